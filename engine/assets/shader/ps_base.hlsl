@@ -6,16 +6,31 @@ struct PS_INPUT
     float3 worldPos : TEXCOORD1;
 };
 
-Texture2D albedoTexture : register(t2);
+Texture2DArray albedoTexture : register(t2);
 SamplerState albedoSampler : register(s2);
 
 cbuffer MaterialBuffer : register(b2)
 {
     float4 albedo;
+    float4 uvScaleBias; // atlas rect: uv = frac(uv) * xy + zw
     int useTexture;
-    int padding[3];
+    int textureSlice;
+    int isAtlas;
+    int padding;
 };
 
+float4 sampleAlbedo(float2 uv)
+{
+    if (isAtlas != 0)
+    {
+        // wrapped into the item's rect by hand, gradients from the unwrapped uv keep the mip steady across the seam
+        float2 scale = uvScaleBias.xy;
+        return albedoTexture.SampleGrad(albedoSampler, float3(frac(uv) * scale + uvScaleBias.zw, textureSlice),
+                                        ddx(uv) * scale, ddy(uv) * scale);
+    }
+    return albedoTexture.Sample(albedoSampler, float3(uv, textureSlice));
+}
+
 struct Light {
     float4 position; // .xyz = position, .w = type
     float4 color;    // .xyz = color, .w = intensity
@@ -33,7 +48,7 @@ cbuffer LightArrayBuffer : register(b3)
 float4 PSMain(PS_INPUT input) : SV_TARGET
 {
     float4 baseColor = (useTexture != 0)
-        ? albedoTexture.Sample(albedoSampler, input.uv)
+        ? sampleAlbedo(input.uv)
         : albedo;
 
     float3 N = normalize(input.normal);
@@ -5,18 +5,33 @@ struct PS_INPUT
     float2 uv     : TEXCOORD;
 };
 
-Texture2D albedoTexture : register(t2);
+Texture2DArray albedoTexture : register(t2);
 SamplerState albedoSampler : register(s2);
 
 cbuffer MaterialBuffer : register(b2)
 {
     float4 albedo;
+    float4 uvScaleBias; // atlas rect: uv = frac(uv) * xy + zw
     int useTexture;
-    int padding[3];
+    int textureSlice;
+    int isAtlas;
+    int padding;
 };
 
+float4 sampleAlbedo(float2 uv)
+{
+    if (isAtlas != 0)
+    {
+        // wrapped into the item's rect by hand, gradients from the unwrapped uv keep the mip steady across the seam
+        float2 scale = uvScaleBias.xy;
+        return albedoTexture.SampleGrad(albedoSampler, float3(frac(uv) * scale + uvScaleBias.zw, textureSlice),
+                                        ddx(uv) * scale, ddy(uv) * scale);
+    }
+    return albedoTexture.Sample(albedoSampler, float3(uv, textureSlice));
+}
+
 float4 PSMain(PS_INPUT input) : SV_TARGET
 {
-    float4 color = (useTexture != 0) ? albedoTexture.Sample(albedoSampler, input.uv) : albedo;
+    float4 color = (useTexture != 0) ? sampleAlbedo(input.uv) : albedo;
     return float4(color.rgb, 1.0f);
 }
\ No newline at end of file
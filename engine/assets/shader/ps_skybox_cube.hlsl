@@ -0,0 +1,15 @@
+struct PS_INPUT
+{
+    float4 pos       : SV_POSITION;
+    float3 direction : DIRECTION;
+};
+
+// Cube map from an equirectangular panorama, see CubemapTexture
+TextureCube skyTexture : register(t2);
+SamplerState skySampler : register(s2);
+
+float4 PSMain(PS_INPUT input) : SV_TARGET
+{
+    float4 color = skyTexture.Sample(skySampler, input.direction);
+    return float4(color.rgb, 1.0f);
+}
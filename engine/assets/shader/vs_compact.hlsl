@@ -0,0 +1,58 @@
+// vs_base for CompactVertex meshes: positions relative to the mesh bounds, octahedral normals, half uvs
+
+struct VS_INPUT
+{
+    float4 pos    : POSITION; // unorm16
+    float2 normal : NORMAL;   // snorm16
+    float2 uv     : TEXCOORD; // half
+};
+
+struct VS_OUTPUT
+{
+    float4 pos    : SV_POSITION;
+    float3 normal : NORMAL;
+    float2 uv     : TEXCOORD;
+    float3 worldPos : TEXCOORD1;
+};
+
+cbuffer ModelBuffer : register(b0)
+{
+    matrix world;
+}
+
+cbuffer CameraBuffer : register(b1)
+{
+    matrix view;
+    matrix projection;
+}
+
+cbuffer MeshBuffer : register(b4)
+{
+    float4 positionOffset;
+    float4 positionScale;
+}
+
+// same as VertexCodec::decodeOctahedral
+float3 decodeOctahedral(float2 e)
+{
+    float3 n = float3(e.xy, 1.f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.xy += (n.xy >= 0.f) ? -t : t;
+    return normalize(n);
+}
+
+VS_OUTPUT VSMain(VS_INPUT input)
+{
+    VS_OUTPUT output = (VS_OUTPUT) 0;
+
+    float3 pos = positionOffset.xyz + input.pos.xyz * positionScale.xyz;
+    float4 worldPos = mul(float4(pos, 1.f), world);
+    float4 viewPos = mul(worldPos, view);
+
+    output.worldPos = worldPos.xyz;
+    output.pos = mul(viewPos, projection);
+    output.normal = normalize(mul(decodeOctahedral(input.normal), (float3x3) world));
+    output.uv = input.uv;
+
+    return output;
+}
@@ -0,0 +1,38 @@
+struct VS_INPUT
+{
+    float3 pos    : POSITION;
+    float3 normal : NORMAL;
+    float2 uv     : TEXCOORD;
+};
+
+struct VS_OUTPUT
+{
+    float4 pos       : SV_POSITION;
+    float3 direction : DIRECTION;
+};
+
+cbuffer ModelBuffer : register(b0)
+{
+    matrix world;
+}
+
+cbuffer CameraBuffer : register(b1)
+{
+    matrix view;
+    matrix projection;
+}
+
+// Sky at infinity: the cube only gives directions, the camera's translation and the cube's size drop out
+VS_OUTPUT VSMain(VS_INPUT input)
+{
+    VS_OUTPUT output = (VS_OUTPUT) 0;
+
+    output.direction = mul(input.pos, (float3x3)world);
+    float3 viewDirection = mul(output.direction, (float3x3)view);
+    float4 clipPos = mul(float4(viewDirection, 1.f), projection);
+
+    // just inside the far plane, so the depth test against the cleared 1.0 still passes
+    output.pos = float4(clipPos.xy, clipPos.w * 0.999999f, clipPos.w);
+
+    return output;
+}
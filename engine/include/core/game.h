@@ -26,6 +26,7 @@ protected:
     virtual void onGraphicsUpdate(float deltaTime);
     virtual void onLogicUpdate(float deltaTime);
     virtual void onInputUpdate(float deltaTime);
+    void presentLoadingFrame(); // cleared back buffer while onCreate waits for assets, keeps the window responsive
 
     void onWindowZoom(float delta);
     void switchCamera(bool is_first_person_camera);
@@ -1,17 +1,22 @@
 #pragma once
 
 #include "utils/forward.h"
+#include "utils/frustum.h"
 
 class CameraBase
 {
 public:
+    static constexpr float DEFAULT_FOV = DirectX::XM_PIDIV4; // 45 degrees in radians
+
     CameraBase(ID3D11Device *device, EntityBase *targetEntity);
     virtual ~CameraBase() = default;
 
     void getPosition(DirectX::XMFLOAT3 &position);
     void getViewMatrix(DirectX::XMMATRIX &view);
     void getProjectionMatrix(DirectX::XMMATRIX &projection);
+    void getFrustum(Frustum &frustum); // world space
     DirectX::XMFLOAT3 getFrontVector();
+    float getFOV() const { return m_fov; }
 
     void setFOV(float fov);
     void setAspectRatio(float aspectRatio);
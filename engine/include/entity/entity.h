@@ -24,12 +24,16 @@ public:
     virtual DirectX::XMFLOAT3 getWorldScale() const;
     virtual DirectX::XMMATRIX getWorldMatrix() const;
     std::vector<std::shared_ptr<RenderComponent>> getRenderComponents() const;
+    bool getWorldBoundingSphere(DirectX::XMFLOAT3 &center, float &radius) const; // over all render components, false without any mesh
+    bool getIsStatic() const { return m_isStatic; }
 
     void setParent(std::shared_ptr<EntityBase> parent);
     void addChild(std::shared_ptr<EntityBase> child);
     void setLocalPosition(const DirectX::XMFLOAT3 &position);
     void setLocalRotation(const DirectX::XMFLOAT3 &eulerAngles);
     virtual void setLocalScale(const DirectX::XMFLOAT3 &scale);
+    // Never moves once the scene is finalized (incl. through its parents), see GameResourceManager::rebuildRootEntities
+    void setIsStatic(bool isStatic) { m_isStatic = isStatic; }
 
     virtual void onLogicUpdate(float deltaTime);
     void onGraphicsUpdate(ID3D11DeviceContext *deviceContext);
@@ -54,6 +58,8 @@ protected:
     DirectX::XMFLOAT3 m_localScale;
 
     DirectX::XMMATRIX m_worldMatrix;
+    DirectX::XMFLOAT4X4 m_uploadedWorldMatrix; // last written to m_modelBuffer
+    bool m_isStatic;
 
     DirectX::XMFLOAT3 m_front;
     DirectX::XMFLOAT3 m_right;
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct AssetCacheStats
+{
+    uint64_t hits = 0;        // the name was loaded already
+    uint64_t contentHits = 0; // a new name whose content was loaded under another one
+    uint64_t misses = 0;      // created
+    uint64_t unloads = 0;     // last handle released
+    uint32_t assetCount = 0;
+    uint32_t nameCount = 0;   // names resolving to a live asset, >= assetCount
+    size_t residentBytes = 0; // as reported by the cache's size function
+};
+
+// Absolute, lexically normal, '/' separated; lower case on Windows, whose file system ignores case
+std::string normalizeAssetPath(const std::filesystem::path &path);
+// Hash of the file's bytes, chained onto `seed`; throws std::runtime_error when the file cannot be read
+uint64_t hashAssetFile(const std::filesystem::path &path, uint64_t seed);
+
+// Live assets of one type, found by name (normalized paths plus load options) and by content key (file hashes
+// plus the same options), both O(1). A load hands out a shared_ptr; the asset is unloaded once the last one is
+// released, whether or not the cache still exists. A name seen before is a hit without touching the disk, a new
+// name is hashed first so the same bytes under another path share the existing asset. Thread safe; `create`
+// runs without the lock, two loads of the same name racing may both create, the later one is dropped.
+template <typename T>
+class AssetCache
+{
+public:
+    using SizeFunction = std::function<size_t(const T &)>;
+
+    explicit AssetCache(SizeFunction getSize = {}) : m_state(std::make_shared<State>())
+    {
+        m_state->getSize = std::move(getSize);
+    }
+
+    AssetCache(const AssetCache &) = delete;
+    AssetCache &operator=(const AssetCache &) = delete;
+
+    // `getContentKey` runs on a name miss, empty when the name alone identifies the content (e.g. materials)
+    std::shared_ptr<T> load(const std::string &name, const std::function<uint64_t()> &getContentKey,
+                            const std::function<std::shared_ptr<T>()> &create)
+    {
+        State &state = *m_state;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (std::shared_ptr<T> asset = find(state, name))
+            {
+                ++state.stats.hits;
+                return asset;
+            }
+        }
+
+        uint64_t contentKey = getContentKey ? getContentKey() : std::hash<std::string>{}(name);
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            auto it = state.byContent.find(contentKey);
+            if (it != state.byContent.end())
+            {
+                if (std::shared_ptr<T> asset = state.entries[it->second].handle.lock())
+                {
+                    addName(state, it->second, name);
+                    ++state.stats.contentHits;
+                    return asset;
+                }
+            }
+        }
+
+        std::shared_ptr<T> created = create();
+        if (created == nullptr)
+        {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        auto it = state.byContent.find(contentKey);
+        if (it != state.byContent.end())
+        {
+            if (std::shared_ptr<T> asset = state.entries[it->second].handle.lock())
+            {
+                addName(state, it->second, name);
+                ++state.stats.contentHits;
+                return asset;
+            }
+        }
+
+        // the handle owns `created` through its deleter, which forgets the entry before the asset goes away
+        uint64_t id = state.nextId++;
+        T *raw = created.get();
+        std::weak_ptr<State> weakState = m_state;
+        std::shared_ptr<T> handle(raw, [owner = std::move(created), weakState, id](T *) mutable
+                                  {
+            if (std::shared_ptr<State> state = weakState.lock())
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                forget(*state, id);
+            }
+            owner.reset(); });
+
+        Entry &entry = state.entries[id];
+        entry.asset = raw;
+        entry.handle = handle;
+        entry.contentKey = contentKey;
+        state.byContent[contentKey] = id;
+        addName(state, id, name);
+        ++state.stats.misses;
+        return handle;
+    }
+
+    // The live asset under `name`, nullptr when it was never loaded or already unloaded; not counted as a hit
+    std::shared_ptr<T> find(const std::string &name) const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return find(*m_state, name);
+    }
+
+    // find(), counted as a hit when found: a load that needs no create step (AssetLoader's asynchronous loads)
+    std::shared_ptr<T> tryLoad(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        std::shared_ptr<T> asset = find(*m_state, name);
+        m_state->stats.hits += asset ? 1 : 0;
+        return asset;
+    }
+
+    AssetCacheStats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        AssetCacheStats stats = m_state->stats;
+        stats.assetCount = static_cast<uint32_t>(m_state->entries.size());
+        stats.nameCount = static_cast<uint32_t>(m_state->byName.size());
+        if (m_state->getSize)
+        {
+            for (const auto &[id, entry] : m_state->entries)
+            {
+                stats.residentBytes += m_state->getSize(*entry.asset);
+            }
+        }
+        return stats;
+    }
+
+private:
+    struct Entry
+    {
+        T *asset = nullptr; // valid while the entry exists, the deleter removes it first
+        std::weak_ptr<T> handle;
+        uint64_t contentKey = 0;
+        std::vector<std::string> names;
+    };
+
+    struct State
+    {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, Entry> entries;
+        std::unordered_map<std::string, uint64_t> byName;
+        std::unordered_map<uint64_t, uint64_t> byContent;
+        uint64_t nextId = 0;
+        SizeFunction getSize;
+        AssetCacheStats stats;
+    };
+
+    static std::shared_ptr<T> find(State &state, const std::string &name)
+    {
+        auto it = state.byName.find(name);
+        return it != state.byName.end() ? state.entries[it->second].handle.lock() : nullptr;
+    }
+
+    static void addName(State &state, uint64_t id, const std::string &name)
+    {
+        auto [it, isNew] = state.byName.emplace(name, id);
+        if (isNew)
+        {
+            state.entries[id].names.push_back(name);
+        }
+        else if (it->second != id)
+        {
+            // the name still points at an asset whose last handle is being released on another thread
+            it->second = id;
+            state.entries[id].names.push_back(name);
+        }
+    }
+
+    static void forget(State &state, uint64_t id)
+    {
+        auto it = state.entries.find(id);
+        if (it == state.entries.end())
+        {
+            return;
+        }
+        for (const std::string &name : it->second.names)
+        {
+            auto nameIt = state.byName.find(name);
+            if (nameIt != state.byName.end() && nameIt->second == id)
+            {
+                state.byName.erase(nameIt);
+            }
+        }
+        auto contentIt = state.byContent.find(it->second.contentKey);
+        if (contentIt != state.byContent.end() && contentIt->second == id)
+        {
+            state.byContent.erase(contentIt);
+        }
+        state.entries.erase(it);
+        ++state.stats.unloads;
+    }
+
+    std::shared_ptr<State> m_state;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "utils/forward.h"
+#include "utils/thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <optional>
+#include <type_traits>
+
+// Ready once the load's create step ran; holds the exception when either step threw
+template <typename T>
+using AssetFuture = std::shared_future<T>;
+
+// Loads in two steps: `prepare` (file I/O, decoding, parsing, cooking) runs on a ThreadPool, `create` (device
+// objects from the prepared data) on the thread calling update() or wait(), in submission order.
+// Independent loads prepare concurrently while that thread keeps presenting frames. Only update() and wait()
+// make a future ready, get() on one before that from the same thread never returns.
+// The device is created free-threaded (no D3D11_CREATE_DEVICE_SINGLETHREADED), so pool workers may create
+// resources too (TextureStreamer does); only the immediate context is the render thread's. `create` stays on the
+// calling thread to keep the order and the caller's maps single threaded, and holds no decoding or file writes.
+class AssetLoader
+{
+public:
+    struct Stats
+    {
+        uint32_t threadCount = 0;
+        uint32_t pending = 0; // create step not run yet
+        uint32_t completed = 0;
+        uint32_t failed = 0;   // either step threw
+        float prepareMs = 0.f; // summed over loads, on the workers
+        float createMs = 0.f;  // summed over loads, on the calling thread
+        float wallMs = 0.f;    // from the first load submitted while idle to the last create step after it
+    };
+
+    // `threadCount` 0 shares ThreadPool::getInstance(), otherwise the loader runs its own pool of that size
+    explicit AssetLoader(ID3D11Device *device, uint32_t threadCount = 0);
+    ~AssetLoader(); // waits for running prepare steps, their create steps never run
+
+    AssetLoader(const AssetLoader &) = delete;
+    AssetLoader &operator=(const AssetLoader &) = delete;
+
+    // `prepare()` returns the CPU side data, `create(device, prepared)` what the future holds
+    template <typename Prepare, typename Create>
+    auto load(Prepare prepare, Create create)
+    {
+        using Prepared = std::invoke_result_t<Prepare &>;
+        using Result = std::invoke_result_t<Create &, ID3D11Device *, Prepared &>;
+
+        auto prepared = std::make_shared<std::optional<Prepared>>();
+        auto promise = std::make_shared<std::promise<Result>>();
+        AssetFuture<Result> future = promise->get_future().share();
+
+        PendingLoad load;
+        load.prepareDone = m_threadPool->submit([this, prepared, prepare = std::move(prepare)]() mutable
+                                                {
+            auto startTime = std::chrono::high_resolution_clock::now();
+            prepared->emplace(prepare());
+            m_prepareMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - startTime).count(); });
+        load.create = [prepared, promise, create = std::move(create)](ID3D11Device *device, std::exception_ptr error) mutable
+        {
+            if (error)
+            {
+                promise->set_exception(error);
+                return false;
+            }
+            try
+            {
+                promise->set_value(create(device, **prepared));
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+                return false;
+            }
+            prepared->reset(); // the CPU side copy is not needed any more
+            return true;
+        };
+        submit(std::move(load));
+        return future;
+    }
+
+    // An already created result as a ready future, for loads served from a cache
+    template <typename T>
+    static AssetFuture<T> makeReady(T value)
+    {
+        std::promise<T> promise;
+        promise.set_value(std::move(value));
+        return promise.get_future().share();
+    }
+
+    // Runs the create steps of the loads prepared so far, returns how many ran
+    uint32_t update();
+    // update() until every load is done, `onWait` between polls (e.g. present a loading frame)
+    void wait(const std::function<void()> &onWait = {});
+    bool isIdle() const { return m_pending.empty(); }
+
+    Stats getStats() const;
+    void logStats() const;
+
+private:
+    struct PendingLoad
+    {
+        std::future<void> prepareDone;
+        std::function<bool(ID3D11Device *, std::exception_ptr)> create; // false when the load failed
+    };
+
+    void submit(PendingLoad load);
+
+    ID3D11Device *m_device;
+    std::unique_ptr<ThreadPool> m_ownThreadPool;
+    ThreadPool *m_threadPool;
+    std::deque<PendingLoad> m_pending;
+
+    std::atomic<int64_t> m_prepareMicroseconds = 0;
+    float m_createMs = 0.f;
+    uint32_t m_completed = 0;
+    uint32_t m_failed = 0;
+    std::chrono::high_resolution_clock::time_point m_batchStart;
+    float m_wallMs = 0.f;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class BlockFormat
+{
+    BC1, // RGB 5:6:5 endpoints, 2-bit indices, 8 bytes per 4x4 block
+    BC3, // BC1 color + interpolated 8-bit alpha, 16 bytes
+    BC7, // mode 6 only: RGBA 7-bit + p-bit endpoints, 4-bit indices, 16 bytes
+};
+
+// CPU block compression of RGBA8 images. Endpoints start on the principal axis of the block's colors and are
+// refined by least squares on the chosen indices. Blocks at the right / bottom edge repeat the last row / column.
+// The decoders are the reference for PSNR, the BC7 one only understands mode 6 (what the encoder writes).
+class BlockCompressor
+{
+public:
+    static size_t getBlockBytes(BlockFormat format) { return format == BlockFormat::BC1 ? 8 : 16; }
+    static size_t getCompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+    static void encodeBlock(BlockFormat format, const uint8_t rgba[64], uint8_t *block);
+    static void decodeBlock(BlockFormat format, const uint8_t *block, uint8_t rgba[64]);
+
+    // Tightly packed RGBA8 in / out, block rows run on the ThreadPool
+    static std::vector<uint8_t> compress(BlockFormat format, const uint8_t *pixels, uint32_t width, uint32_t height);
+    static std::vector<uint8_t> decompress(BlockFormat format, const uint8_t *blocks, uint32_t width, uint32_t height);
+
+    // Over RGB, plus alpha when includeAlpha
+    static double computePsnr(const uint8_t *reference, const uint8_t *pixels, size_t texelCount, bool includeAlpha);
+};
@@ -13,13 +13,32 @@ struct ModelBuffer
     DirectX::XMMATRIX world;
 };
 
+struct alignas(16) MeshBuffer
+{
+    DirectX::XMFLOAT4 positionOffset; // .xyz = bounds min
+    DirectX::XMFLOAT4 positionScale;  // .xyz = bounds extent
+};
+static_assert(sizeof(MeshBuffer) == 32, "MeshBuffer size mismatch!");
+
 struct alignas(16) MaterialBuffer
 {
     DirectX::XMFLOAT4 albedo;
+    DirectX::XMFLOAT4 uvScaleBias; // atlas rect: uv = frac(uv) * xy + zw
     int useTexture;
-    int padding[3];
+    int textureSlice; // Texture2DArray slice
+    int isAtlas;
+    int padding;
+};
+static_assert(sizeof(MaterialBuffer) == 48, "MaterialBuffer size mismatch!");
+
+struct alignas(16) VirtualTextureBuffer
+{
+    DirectX::XMUINT4 levelTiles[16];  // .x = tiles x, .y = tiles y, .z = first page table entry
+    DirectX::XMFLOAT4 levelSizes[16]; // .xy = level size in texels
+    DirectX::XMFLOAT4 physicalScale;  // .xy = 1 / atlas size, .z = tile size, .w = tile border
+    DirectX::XMUINT4 info;            // .x = level count, .y = tile stride, .z = feedback divisor
 };
-static_assert(sizeof(MaterialBuffer) == 32, "MaterialBuffer size mismatch!");
+static_assert(sizeof(VirtualTextureBuffer) == 544, "VirtualTextureBuffer size mismatch!");
 
 struct alignas(16) LightBuffer
 {
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "resources/mip_generator.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Equirectangular (longitude / latitude) panorama to the six faces of a cube map, on the CPU. Each face texel
+// averages bilinear samples spread over its footprint: one where the panorama is coarser than the face, up to
+// MAX_SAMPLES^2 near the poles, where a face texel covers a whole run of panorama texels (area resampling).
+// Filtered in linear light with premultiplied alpha like MipGenerator; face rows run on the ThreadPool, the
+// direction to panorama mapping four samples at a time as DirectXMath vectors.
+class CubemapConverter
+{
+public:
+    static constexpr uint32_t FACE_COUNT = 6;
+    static constexpr uint32_t MAX_SAMPLES = 4; // per axis
+
+    // Power of two face size closest to one texel per pixel at the center of a `viewportHeight` tall view with
+    // vertical field of view `fovY`, no larger than the panorama has texels for
+    static uint32_t getFaceSize(uint32_t viewportHeight, float fovY, uint32_t sourceWidth);
+
+    // `faces[face][level]`, faces in D3D TEXTURECUBE order (+X, -X, +Y, -Y, +Z, -Z), mips box filtered.
+    // +Y is the top row of the panorama, its center column looks down +Z.
+    static std::vector<std::vector<MipLevel>> convert(const uint8_t *pixels, uint32_t width, uint32_t height, size_t rowPitch,
+                                                      bool isSrgb, uint32_t faceSize);
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "resources/texture.h"
+
+// Sky texture: an equirectangular panorama converted by CubemapConverter into a TEXTURECUBE with a full mip chain,
+// block compressed like ImageTexture's cook. Sampled by direction (ps_skybox_cube.hlsl), so the texel density is
+// close to uniform and the sky needs no geometry beyond a cube around the camera. bind() sets the cube view and
+// the sampler at `slot`.
+class CubemapTexture : public TextureBase {
+public:
+    // Encoded faces, `levels[face * mipLevels + mip]`; the source size is 0 when the faces came from the cache
+    struct CookedCubemap
+    {
+        std::string sourcePath;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        uint32_t faceSize = 0;
+        uint32_t mipLevels = 0;
+        uint32_t sourceWidth = 0;
+        uint32_t sourceHeight = 0;
+        std::vector<std::vector<uint8_t>> levels;
+    };
+
+    // Faces sized for a `viewportHeight` tall view with vertical field of view `fovY`, see CubemapConverter::getFaceSize
+    CubemapTexture(ID3D11Device* device, const std::string& sourcePath, uint32_t viewportHeight, float fovY,
+                   TextureCompression compression = TextureCompression::Auto);
+    CubemapTexture(ID3D11Device* device, const CookedCubemap& cooked);
+    ~CubemapTexture() = default;
+
+    // Decode, conversion and encoding, no device involved (AssetLoader runs it on the ThreadPool). The faces are kept
+    // in TextureCache under getOptionsKey(), a later cook with the same options maps them back. Throws std::runtime_error.
+    static CookedCubemap cook(const std::string& sourcePath, uint32_t viewportHeight, float fovY,
+                              TextureCompression compression = TextureCompression::Auto);
+
+    // Hash of the options that change the cooked faces
+    static uint64_t getOptionsKey(uint32_t viewportHeight, float fovY, TextureCompression compression);
+
+    void bind(ID3D11DeviceContext* deviceContext, UINT slot) const override;
+
+    uint32_t getFaceSize() const { return m_faceSize; }
+
+private:
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> m_texture;
+    uint32_t m_faceSize = 0;
+};
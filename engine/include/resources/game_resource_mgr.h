@@ -3,12 +3,42 @@
 #include "entity/entity.h"
 #include "entity/entity_controllable.h"
 #include "entity/light.h"
+#include "resources/asset_cache.h"
+#include "resources/asset_loader.h"
+#include "resources/lazy_asset.h"
+#include "resources/mesh.h"
+#include "resources/shader.h"
+#include "resources/material.h"
+#include "resources/texture.h"
+#include "resources/texture_packer.h"
 
+#include <chrono>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class GameResourceManager
 {
 public:
+    struct FrameStats
+    {
+        uint32_t drawnEntities = 0;
+        uint32_t culledEntities = 0; // outside the camera frustum, skipped before any buffer update
+        uint32_t visibleMeshlets = 0;
+        uint32_t totalMeshlets = 0; // of drawn entities at LOD0
+        uint32_t drawCalls = 0;
+        uint32_t staticBatches = 0; // drawn, each replaces the draws of its members
+    };
+
+    struct AssetStats
+    {
+        AssetCacheStats meshes;
+        AssetCacheStats shaders;
+        AssetCacheStats textures;
+        AssetCacheStats texturePacks;
+        AssetCacheStats materials;
+    };
+
     GameResourceManager(ID3D11Device *device);
     ~GameResourceManager();
 
@@ -20,23 +50,121 @@ public:
     void registerControllableEntity(std::shared_ptr<ControllableEntity> entity);
     void registerLight(std::shared_ptr<Light> light);
 
+    // Assets: a file loaded again with the same options, under any path with the same bytes, is the asset
+    // already loaded (see AssetCache). It stays loaded while something holds the returned pointer, or a
+    // TextureRef of a pack; `name` only labels a mesh the first time its file is loaded.
+    std::shared_ptr<Mesh> loadMesh(const std::string &filepath, const std::string &name, const MeshOptions &options = {});
+    std::shared_ptr<Shader> loadShader(const std::wstring &vertexShaderPath, const std::wstring &pixelShaderPath,
+                                       const D3D11_INPUT_ELEMENT_DESC *inputElementDescs, UINT numInputElementDescs);
+    std::shared_ptr<TextureBase> loadTexture(const std::string &filepath, TextureCompression compression = TextureCompression::Auto,
+                                             TextureLoading loading = TextureLoading::Blocking);
+    std::shared_ptr<TextureBase> loadCubemap(const std::string &filepath, uint32_t viewportHeight, float fovY,
+                                             TextureCompression compression = TextureCompression::Auto);
+    // TextureArray::loadPacked, the whole list is one asset
+    std::vector<TextureRef> loadTexturePack(const std::vector<std::string> &filePaths, const TexturePackOptions &options = {},
+                                            TextureCompression compression = TextureCompression::Auto,
+                                            TextureLoading loading = TextureLoading::Blocking);
+    // Lambertian materials with the same shader and albedo are one object
+    std::shared_ptr<MaterialBase> loadMaterial(std::shared_ptr<Shader> shader, const DirectX::XMFLOAT4 &albedo);
+    std::shared_ptr<MaterialBase> loadMaterial(std::shared_ptr<Shader> shader, std::shared_ptr<TextureBase> albedoTexture);
+    std::shared_ptr<MaterialBase> loadMaterial(std::shared_ptr<Shader> shader, const TextureRef &albedoTexture);
+
+    // The loads above in AssetLoader's two steps: reading, parsing, compiling and cooking run concurrently on the
+    // ThreadPool, the device objects are created on this thread by waitForLoads or the next onGraphicsUpdate.
+    // Cached assets come back ready. `inputElementDescs` must stay valid until the shader is created.
+    AssetFuture<std::shared_ptr<Mesh>> loadMeshAsync(const std::string &filepath, const std::string &name, const MeshOptions &options = {});
+    AssetFuture<std::shared_ptr<Shader>> loadShaderAsync(const std::wstring &vertexShaderPath, const std::wstring &pixelShaderPath,
+                                                         const D3D11_INPUT_ELEMENT_DESC *inputElementDescs, UINT numInputElementDescs);
+    AssetFuture<std::shared_ptr<TextureBase>> loadTextureAsync(const std::string &filepath, TextureCompression compression = TextureCompression::Auto,
+                                                               TextureLoading loading = TextureLoading::Blocking);
+    AssetFuture<std::shared_ptr<TextureBase>> loadCubemapAsync(const std::string &filepath, uint32_t viewportHeight, float fovY,
+                                                               TextureCompression compression = TextureCompression::Auto);
+    AssetFuture<std::vector<TextureRef>> loadTexturePackAsync(const std::vector<std::string> &filePaths, const TexturePackOptions &options = {},
+                                                              TextureCompression compression = TextureCompression::Auto,
+                                                              TextureLoading loading = TextureLoading::Blocking);
+    // Creates what the loads prepared as they finish, `onWait` in between (e.g. present a loading frame)
+    void waitForLoads(const std::function<void()> &onWait = {});
+    const AssetLoader &getAssetLoader() const { return m_assetLoader; }
+
+    // Lazy loads: nothing is read until a component using the asset is first visible, or nearer to the camera than
+    // the lazy load distance, and it draws with `placeholder` until the asynchronous load is in (a low LOD mesh, a
+    // flat colour material). The placeholder mesh's bounds stand in for the visibility test, neither may be null.
+    // The handles must not be requested once this manager is gone.
+    std::shared_ptr<LazyAsset<Mesh>> loadMeshLazy(const std::string &filepath, const std::string &name, std::shared_ptr<Mesh> placeholder,
+                                                  const MeshOptions &options = {});
+    // A Lambertian material textured with `albedoPath`
+    std::shared_ptr<LazyAsset<MaterialBase>> loadMaterialLazy(std::shared_ptr<Shader> shader, const std::string &albedoPath,
+                                                              std::shared_ptr<MaterialBase> placeholder,
+                                                              TextureCompression compression = TextureCompression::Auto,
+                                                              TextureLoading loading = TextureLoading::Blocking);
+    // World units from the camera to an entity's bounding sphere within which its lazy assets load unseen, 0: once visible
+    void setLazyLoadDistance(float distance) { m_lazyLoadDistance = distance; }
+    std::vector<LazyAssetUsage> getLazyAssetUsage() const;
+    // Lazy assets loaded, failed and never requested this session; the last ones need not ship with the scene
+    void logLazyAssetReport() const;
+
+    AssetStats getAssetStats() const;
+    void logAssetStats() const;
+
     void onLogicUpdate(float deltaTime);
-    void onGraphicsUpdate(DXDeviceManager *deviceManager);
+    void onGraphicsUpdate(DXDeviceManager *deviceManager, CameraBase *camera, float viewportHeight);
+    const FrameStats &getFrameStats() const { return m_frameStats; }
 
+    // Scene finalization, also regroups static entities into batches when the static set changed
     void rebuildRootEntities();
     void initLightArrayBuffer(ID3D11Device *device);
 
 private:
+    // a pack is cached whole, the refs handed out share its lifetime
+    struct TexturePack
+    {
+        std::vector<TextureRef> textures;
+    };
+
+    static std::vector<TextureRef> getPackRefs(const std::shared_ptr<TexturePack> &pack);
+
     void topDownLogicUpdateRecursive(std::shared_ptr<EntityBase> entity, float deltaTime);
 
     void bindLightArrayBuffer(ID3D11DeviceContext *context);
+    void cullEntities(CameraBase *camera); // fills m_cullEntities / m_cullVisible
+    void requestLazyAssets(CameraBase *camera); // of culled entities that are visible or within m_lazyLoadDistance
+    std::shared_ptr<LazyAssetUsage> addLazyAsset(const char *type, const std::string &name);
+    void rebuildStaticBatches();
 
     ID3D11Device *m_device;
 
+    AssetCache<Mesh> m_meshes;
+    AssetCache<Shader> m_shaders;
+    AssetCache<TextureBase> m_textures;
+    AssetCache<TexturePack> m_texturePacks;
+    AssetCache<MaterialBase> m_materials;
+    AssetLoader m_assetLoader; // after the caches, its create steps fill them
+
+    std::vector<std::shared_ptr<LazyAssetUsage>> m_lazyAssets; // every one handed out, for the report
+    float m_lazyLoadDistance = 0.f;
+    std::chrono::steady_clock::time_point m_startTime;
+
     std::unordered_map<uint32_t, std::shared_ptr<EntityBase>> m_allEntities;
     std::unordered_map<uint32_t, std::shared_ptr<EntityBase>> m_rootEntities;
     std::unordered_map<uint32_t, std::shared_ptr<ControllableEntity>> m_controllableEntities;
     std::unordered_map<uint32_t, std::shared_ptr<Light>> m_lights;
 
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_lightArrayBuffer;
+
+    // static batching, built on the first frame after the static set changed so world matrices are current
+    std::vector<std::shared_ptr<EntityBase>> m_staticBatches;
+    std::unordered_set<const RenderComponent *> m_batchedComponents; // drawn through a batch
+    std::unordered_set<const EntityBase *> m_batchedEntities;        // every component batched, not culled or drawn
+    uint64_t m_staticSetHash = 0;
+    bool m_isStaticBatchDirty = false;
+
+    // per-frame culling scratch, kept to avoid reallocating
+    std::vector<EntityBase *> m_cullEntities;
+    std::vector<float> m_cullCenterX;
+    std::vector<float> m_cullCenterY;
+    std::vector<float> m_cullCenterZ;
+    std::vector<float> m_cullRadius;
+    std::vector<uint8_t> m_cullVisible;
+    size_t m_cullBatchStart = 0; // static batches follow the scene entities
+    FrameStats m_frameStats;
 };
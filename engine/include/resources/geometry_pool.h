@@ -0,0 +1,86 @@
+#pragma once
+
+#include "utils/forward.h"
+#include "utils/tlsf_allocator.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Shared vertex / index arenas. Meshes with the same vertex stride, index format and position stream get
+// sub-ranges of one set of buffers and draw with DrawIndexed offsets, so consecutive draws skip the IA rebind.
+// Ranges are TlsfAllocator handles in vertex / index units, 16-bit indices stay relative to the base vertex.
+class GeometryPool
+{
+public:
+    static constexpr uint32_t INVALID_HANDLE = UINT32_MAX;
+    static constexpr size_t VERTEX_ARENA_BYTES = 16 * 1024 * 1024;
+    static constexpr size_t INDEX_ARENA_BYTES = 8 * 1024 * 1024;
+
+    struct Allocation
+    {
+        uint32_t arena = INVALID_HANDLE;
+        uint32_t vertexHandle = TlsfAllocator::INVALID_HANDLE;
+        uint32_t indexHandle = TlsfAllocator::INVALID_HANDLE;
+        uint32_t baseVertex = 0;
+        uint32_t firstIndex = 0;
+        uint32_t vertexCount = 0;
+        uint32_t indexCount = 0;
+    };
+
+    static GeometryPool &getInstance();
+
+    // Copies the data into the first arena of the matching layout with room for it, creating one if none has.
+    // `positions` (PositionVertex, one per vertex) may be null. Returns a handle for getAllocation / bind / free.
+    uint32_t allocate(ID3D11Device *device, UINT vertexStride, DXGI_FORMAT indexFormat, const void *vertices, uint32_t vertexCount,
+                      const void *positions, const void *indices, uint32_t indexCount);
+    void free(uint32_t handle);
+
+    // A copy: allocate() may grow the table and compact() moves ranges while other threads read
+    Allocation getAllocation(uint32_t handle) const;
+
+    // Binds the allocation's arena unless it is the one bound last
+    void bind(ID3D11DeviceContext *deviceContext, uint32_t handle, D3D11_PRIMITIVE_TOPOLOGY topology);
+    void bindPositionOnly(ID3D11DeviceContext *deviceContext, uint32_t handle, D3D11_PRIMITIVE_TOPOLOGY topology);
+
+    // Call whenever IA state is set outside the pool (unpooled meshes, other passes, start of a frame)
+    void invalidateBindings();
+
+    // Moves the live ranges of every arena whose free space is more fragmented than `minFragmentation` to the
+    // front of a fresh buffer (GPU copies), base vertex / first index of the allocations follow
+    void compact(ID3D11Device *device, ID3D11DeviceContext *deviceContext, float minFragmentation = 0.25f);
+
+    void logStats() const;
+
+private:
+    struct Arena
+    {
+        Arena(UINT stride, DXGI_FORMAT format, bool positions, uint32_t vertexCapacity, uint32_t indexCapacity)
+            : vertexStride(stride), indexFormat(format), hasPositions(positions), vertexAllocator(vertexCapacity), indexAllocator(indexCapacity) {}
+
+        UINT vertexStride;
+        DXGI_FORMAT indexFormat;
+        bool hasPositions;
+        TlsfAllocator vertexAllocator;
+        TlsfAllocator indexAllocator;
+        Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer;
+        Microsoft::WRL::ComPtr<ID3D11Buffer> positionBuffer; // PositionVertex, same offsets as vertexBuffer
+        Microsoft::WRL::ComPtr<ID3D11Buffer> indexBuffer;
+    };
+
+    GeometryPool() = default;
+
+    uint32_t createArena(ID3D11Device *device, UINT vertexStride, DXGI_FORMAT indexFormat, bool hasPositions, uint32_t minVertices, uint32_t minIndices);
+    static void createBuffer(ID3D11Device *device, UINT bindFlags, size_t byteWidth, ID3D11Buffer **buffer);
+    static void upload(ID3D11DeviceContext *deviceContext, ID3D11Buffer *buffer, size_t byteOffset, const void *data, size_t byteWidth);
+    static void copy(ID3D11DeviceContext *deviceContext, ID3D11Buffer *target, ID3D11Buffer *source, const std::vector<TlsfAllocator::Move> &moves, UINT stride);
+
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<Arena>> m_arenas;
+    std::vector<Allocation> m_allocations;
+    std::vector<uint32_t> m_unusedAllocations;
+
+    // IA state last set by the pool
+    uint32_t m_boundArena = INVALID_HANDLE;
+    bool m_boundPositions = false;
+    D3D11_PRIMITIVE_TOPOLOGY m_boundTopology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "resources/vertex.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary glTF 2.0 (.glb) parser. Only the JSON chunk is parsed, accessors point into the BIN chunk of the
+// caller's buffer (no copies). Output of readVertices is converted from right-hand, ccw to left-hand, cw
+// (z flipped, glTF uvs already have v pointing down). Node transforms are not applied.
+class GlbParser
+{
+public:
+    static constexpr uint32_t MAGIC = 0x46546C67;      // "glTF"
+    static constexpr uint32_t CHUNK_JSON = 0x4E4F534A; // "JSON"
+    static constexpr uint32_t CHUNK_BIN = 0x004E4942;  // "BIN\0"
+
+    enum ComponentType : uint32_t
+    {
+        Byte = 5120,
+        UnsignedByte = 5121,
+        Short = 5122,
+        UnsignedShort = 5123,
+        UnsignedInt = 5125,
+        Float = 5126,
+    };
+
+    // Strided view into the BIN chunk
+    struct Accessor
+    {
+        const uint8_t *data = nullptr; // null when the attribute is missing
+        size_t count = 0;
+        size_t stride = 0; // bytes between elements, tightly packed when the buffer view has none
+        uint32_t componentType = 0;
+        uint32_t componentCount = 0; // 1 SCALAR, 2 VEC2, 3 VEC3, 4 VEC4
+        bool normalized = false;
+    };
+
+    struct Primitive
+    {
+        std::string meshName;
+        int material = -1;
+        Accessor positions;
+        Accessor normals;
+        Accessor texCoords;
+        Accessor indices; // missing: non-indexed, one vertex per corner
+    };
+
+    struct Result
+    {
+        std::vector<Primitive> primitives; // meshes[].primitives[] flattened, triangle lists only
+    };
+
+    // Throws on malformed files and on unsupported required extensions (Draco, meshopt compression)
+    static Result parse(const char *data, size_t size);
+
+    // One pass over the accessors, a block copy when they are interleaved exactly like `Vertex`.
+    // Missing normals / uvs are zero, like the OBJ path.
+    static void readVertices(const Primitive &primitive, std::vector<Vertex> &vertices);
+    static void readIndices(const Primitive &primitive, std::vector<uint32_t> &indices);
+
+    // True when the vertex accessors are floats interleaved with Vertex's stride and offsets
+    static bool matchesVertexLayout(const Primitive &primitive);
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "utils/forward.h"
+#include "resources/asset_loader.h"
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// What a session did with one lazy asset, kept by GameResourceManager for its report
+struct LazyAssetUsage
+{
+    std::string type;
+    std::string name;
+    bool isRequested = false;
+    bool isLoaded = false;
+    bool isFailed = false; // the load threw, the placeholder stays
+    std::chrono::steady_clock::time_point requestTime;
+    float loadMs = 0.f; // from the first request to the asset in use
+};
+
+// The tallies of GameResourceManager::logLazyAssetReport
+struct LazyAssetCounts
+{
+    uint32_t loaded = 0;
+    uint32_t failed = 0;
+    uint32_t loading = 0; // requested, neither loaded nor failed yet
+    uint32_t neverRequested = 0;
+};
+
+inline LazyAssetCounts countLazyAssets(const std::vector<std::shared_ptr<LazyAssetUsage>> &assets)
+{
+    LazyAssetCounts counts;
+    for (const auto &asset : assets)
+    {
+        counts.loaded += asset->isLoaded ? 1 : 0;
+        counts.failed += asset->isFailed ? 1 : 0;
+        counts.loading += asset->isRequested && !asset->isLoaded && !asset->isFailed ? 1 : 0;
+        counts.neverRequested += asset->isRequested ? 0 : 1;
+    }
+    return counts;
+}
+
+// An asset that is only read once something wants it. get() is the placeholder (a flat colour material, a low LOD
+// mesh) until the load started by the first request() has finished, the asset from then on. request() also picks
+// the result up, so it is called every frame the asset is wanted; on the thread running AssetLoader::update().
+template <typename T>
+class LazyAsset
+{
+public:
+    using Load = std::function<AssetFuture<std::shared_ptr<T>>()>;
+
+    LazyAsset(std::shared_ptr<LazyAssetUsage> usage, Load load, std::shared_ptr<T> placeholder)
+        : m_usage(std::move(usage)), m_load(std::move(load)), m_placeholder(std::move(placeholder))
+    {
+    }
+
+    LazyAsset(const LazyAsset &) = delete;
+    LazyAsset &operator=(const LazyAsset &) = delete;
+
+    const std::shared_ptr<T> &get() const { return m_asset ? m_asset : m_placeholder; }
+    bool isLoaded() const { return m_asset != nullptr; }
+    const LazyAssetUsage &getUsage() const { return *m_usage; }
+
+    // Starts the load on the first call, true once get() returns the asset
+    bool request()
+    {
+        if (m_asset || m_usage->isFailed)
+        {
+            return m_asset != nullptr;
+        }
+        if (!m_usage->isRequested)
+        {
+            m_usage->isRequested = true;
+            m_usage->requestTime = std::chrono::steady_clock::now();
+            try
+            {
+                m_future = m_load();
+            }
+            catch (const std::exception &e)
+            {
+                fail(e.what());
+                return false;
+            }
+            m_load = {}; // drops what the load captured
+        }
+        if (m_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return false;
+        }
+
+        try
+        {
+            m_asset = m_future.get();
+        }
+        catch (const std::exception &e)
+        {
+            fail(e.what());
+            return false;
+        }
+        m_future = {};
+        if (m_asset == nullptr)
+        {
+            fail("nothing loaded");
+            return false;
+        }
+        m_usage->isLoaded = true;
+        m_usage->loadMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_usage->requestTime).count();
+        m_placeholder.reset();
+        return true;
+    }
+
+private:
+    void fail(const char *error)
+    {
+        m_usage->isFailed = true;
+        m_future = {};
+        m_load = {};
+        Logger::LogError(std::string("LazyAsset::request: ") + m_usage->type + " " + m_usage->name + " failed, keeping the placeholder: " + error);
+    }
+
+    std::shared_ptr<LazyAssetUsage> m_usage;
+    Load m_load;
+    AssetFuture<std::shared_ptr<T>> m_future;
+    std::shared_ptr<T> m_placeholder;
+    std::shared_ptr<T> m_asset;
+};
@@ -13,6 +13,9 @@ public:
 
     virtual void bind(ID3D11DeviceContext *deviceContext) const = 0;
     virtual void setProperty(const std::string &name, const void *data, size_t size) = 0;
+
+    // Projected size in pixels of a draw with this material, passed on to its textures (TextureBase::requestDetail)
+    virtual void requestDetail(float) const {}
 };
 
 class LambertianMaterial : public MaterialBase
@@ -20,9 +23,13 @@ class LambertianMaterial : public MaterialBase
 public:
     LambertianMaterial(ID3D11Device *device, std::shared_ptr<Shader> shader, const DirectX::XMFLOAT4 &albedo);
     LambertianMaterial(ID3D11Device *device, std::shared_ptr<Shader> shader, const std::string &albedoPath);
+    LambertianMaterial(ID3D11Device *device, std::shared_ptr<Shader> shader, std::shared_ptr<TextureBase> albedoTexture);
+    // A slice of a packed TextureArray, see TextureArray::loadPacked
+    LambertianMaterial(ID3D11Device *device, std::shared_ptr<Shader> shader, const TextureRef &albedoTexture);
 
     void bind(ID3D11DeviceContext *deviceContext) const override;
     void setProperty(const std::string &name, const void *data, size_t size) override;
+    void requestDetail(float screenSize) const override;
 
 private:
     std::shared_ptr<Shader> m_shader;
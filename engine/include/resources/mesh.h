@@ -1,32 +1,155 @@
 #pragma once
 
 #include "utils/forward.h"
+#include "resources/mesh_bounds.h"
+#include "resources/mesh_bvh.h"
+#include "resources/mesh_lod.h"
+#include "resources/meshlet.h"
+#include "resources/mesh_cache.h"
+#include "resources/vertex.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 
+// What stays in system memory once a mesh is on the GPU
+enum class MeshResidency
+{
+    Default,       // Mesh::setDefaultResidency, Keep unless changed
+    Keep,          // every vertex and LOD (re-upload, tools)
+    Discard,       // nothing, see Mesh::rematerialize
+    PositionsOnly, // float3 positions and LOD0 indices (picking, physics)
+};
+
+struct MeshOptions
+{
+    float weldEpsilon = 0.f;                        // > 0: merge vertices closer than this (position, normal and uv), e.g. split seams
+    bool optimizeVertexCache = true;                // reorder triangles for the post-transform cache and vertices for fetch
+    bool optimizeOverdraw = false;                  // additionally sort triangle clusters front-to-back from the outside
+    uint32_t lodCount = 1;                          // levels of detail incl. the full mesh, up to MAX_MESH_LODS
+    float lodReduction = 0.5f;                      // triangle ratio between consecutive levels
+    float lodMaxError = 0.25f;                      // stop adding levels past this error, relative to the bounding sphere radius
+    VertexFormat vertexFormat = VertexFormat::Full; // Compact needs a shader built from vs_compact.hlsl
+    bool positionStream = false;                    // also upload a quantized position-only stream, see bindPositionOnly
+    bool useCache = true;                           // file meshes: load from / write to the binary .dxmesh cache
+    bool useGeometryPool = true;                    // sub-allocate from the shared GeometryPool arenas instead of own buffers
+    MeshResidency residency = MeshResidency::Default; // CPU copies kept after the upload
+    bool buildMeshlets = false;                     // split LOD0 into clusters (reorders its triangles) for per-cluster frustum and backface culling
+    uint32_t maxMeshletVertices = MeshletBuilder::MAX_VERTICES;
+    uint32_t maxMeshletTriangles = MeshletBuilder::MAX_TRIANGLES;
+};
+
 class Mesh
 {
 public:
-    Mesh(ID3D11Device *device, const std::string &filepath, const std::string &name);
-    Mesh(ID3D11Device *device, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, const std::string &name);
+    // .obj or .glb, `primitive` picks one of the glTF file's triangle primitives (see loadGLB)
+    Mesh(ID3D11Device *device, const std::string &filepath, const std::string &name, const MeshOptions &options = {}, uint32_t primitive = 0);
+    Mesh(ID3D11Device *device, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, const std::string &name, const MeshOptions &options = {});
+    // prebuilt levels (e.g. MeshGenerator::createIcosphereLods), LOD0 first, lodCount / lodReduction / lodMaxError are ignored
+    Mesh(ID3D11Device *device, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, const std::vector<MeshLod> &lods, const std::string &name, const MeshOptions &options = {});
     ~Mesh();
 
+    // The file constructor in two steps, for AssetLoader: prepare maps the .dxmesh cache or cooks the source (and
+    // writes the cache) on any thread without a device, upload creates the buffers (straight from the mapping on a
+    // cache hit)
+    static std::shared_ptr<Mesh> prepare(const std::string &filepath, const std::string &name, const MeshOptions &options = {}, uint32_t primitive = 0);
+    void upload(ID3D11Device *device);
+
     const UINT getIndicesCount() const;
+    const MeshBounds &getBounds() const;
+    uint32_t getLodCount() const { return static_cast<uint32_t>(m_lods.size()); }
+    const MeshLod &getLod(uint32_t level) const { return m_lods[level]; }
+    const std::vector<Meshlet> &getMeshlets() const { return m_meshlets; } // LOD0 only, empty unless buildMeshlets
+    VertexFormat getVertexFormat() const { return m_options.vertexFormat; }
+    // Offsets of the mesh inside its GeometryPool arena, DrawIndexed adds them to LOD / meshlet ranges. 0 when unpooled.
+    uint32_t getBaseVertex() const;
+    uint32_t getFirstIndex() const;
+
+    // CPU side geometry as left by the residency policy: empty after Discard, getPositions and LOD0 indices after PositionsOnly
+    const std::vector<Vertex> &getVertices() const { return m_vertices; }
+    const std::vector<DirectX::XMFLOAT3> &getPositions() const { return m_positions; }
+    const std::vector<uint32_t> &getIndices() const { return m_indices; }
+    MeshResidency getResidency() const;
+    bool isCpuResident() const; // full vertices and indices, by count; rematerialize also compares their content hash
+
+    // Restores the full CPU vertices and indices from the .dxmesh cache, or cooks the source again.
+    // Meshes built from memory have nothing to reload from. releaseCpuData applies the policy again.
+    bool rematerialize();
+    void releaseCpuData();
+
+    // Triangle BVH over LOD0 in object space, built on first use and kept with the mesh. Discarded meshes are
+    // rematerialized for the build and released again; null for meshes that cannot be (built from memory, not triangles).
+    // Hit / closest-point triangles count from LOD0's first index.
+    const MeshBvh *getBvh();
+
+    size_t getCpuBytes() const; // incl. the BVH
+    size_t getGpuBytes() const { return m_gpuBytes; }
+
+    static void setDefaultResidency(MeshResidency residency);
+    static MeshResidency getDefaultResidency() { return s_defaultResidency.load(); }
+    static void logMemoryReport(); // CPU / GPU bytes of every live mesh
 
     void setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY primitiveTopology);
+    D3D11_PRIMITIVE_TOPOLOGY getPrimitiveTopology() const { return m_primitiveTopology; }
+
+    // One mesh per primitive of every glTF mesh, each gets its own RenderComponent
+    static std::vector<std::shared_ptr<Mesh>> loadGLB(ID3D11Device *device, const std::string &filepath, const std::string &name, const MeshOptions &options = {});
 
     void loadFromOBJ(const std::string &filepath);
+    void loadFromGLB(const std::string &filepath, uint32_t primitive);
     void bind(ID3D11DeviceContext *deviceContext) const;
+    void bindPositionOnly(ID3D11DeviceContext *deviceContext) const; // PositionVertex::inputLayout
 
 private:
-    void initBuffers(ID3D11Device *device, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices);
+    Mesh(const std::string &filepath, const std::string &name, const MeshOptions &options, uint32_t primitive); // see prepare
+
+    void cook(const std::string &filepath);
+    bool mapCache(const std::string &filepath);
+    void uploadFromCache(ID3D11Device *device);
+    uint64_t getOptionsKey() const;
+    void weldVertices();
+    void optimize();
+    void buildLods();
+    void buildMeshlets();
+    void initBuffers(ID3D11Device *device, const Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount);
+    void createBuffer(ID3D11Device *device, UINT bindFlags, const void *data, size_t byteWidth, ID3D11Buffer **buffer, D3D11_USAGE usage = D3D11_USAGE_DEFAULT);
+
+    static void registerMesh(const Mesh *mesh);
+    static void unregisterMesh(const Mesh *mesh);
+
+    static std::atomic<MeshResidency> s_defaultResidency;
 
     std::string m_name;
+    std::string m_sourcePath; // empty for meshes built from memory
+    uint32_t m_sourcePrimitive = 0;
+    MeshOptions m_options;
 
     std::vector<Vertex> m_vertices;
-    std::vector<uint32_t> m_indices;
+    std::vector<uint32_t> m_indices; // all levels, see m_lods
+    std::vector<MeshLod> m_lods;
+    std::vector<Meshlet> m_meshlets;
+    std::vector<DirectX::XMFLOAT3> m_positions; // PositionsOnly
+    MeshBounds m_bounds;
+    std::unique_ptr<MeshBvh> m_bvh; // lazy, see getBvh
+    std::mutex m_bvhMutex;
+    bool m_isBvhUnavailable = false;
+    UINT m_vertexStride;
+    DXGI_FORMAT m_indexFormat;
     D3D11_PRIMITIVE_TOPOLOGY m_primitiveTopology;
+    size_t m_gpuVertexCount = 0;
+    size_t m_gpuIndexCount = 0;
+    uint64_t m_gpuContentHash = 0; // vertices and indices as uploaded, only for meshes with a source to reload
+    size_t m_gpuBytes = 0;
+    uint32_t m_poolHandle = UINT32_MAX; // GeometryPool::INVALID_HANDLE when the buffers below are used
+
+    // between prepare and upload
+    std::unique_ptr<MeshCache::CachedMesh> m_pendingCache; // null when cooked
+    float m_prepareMs = 0.f;
+    bool m_isUploaded = false;
 
-    Microsoft::WRL::ComPtr<ID3D11Buffer> m_vertexBuffer;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_vertexBuffer; // unpooled only
     Microsoft::WRL::ComPtr<ID3D11Buffer> m_indexBuffer;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_positionBuffer;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_meshBuffer; // b4, position dequantization for compact layouts
 };
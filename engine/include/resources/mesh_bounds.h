@@ -0,0 +1,15 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+struct MeshBounds
+{
+    DirectX::XMFLOAT3 aabbMin;
+    DirectX::XMFLOAT3 aabbMax;
+    DirectX::XMFLOAT3 sphereCenter;
+    float sphereRadius;
+
+    // positions are read with the given byte stride, e.g. sizeof(Vertex)
+    static MeshBounds compute(const DirectX::XMFLOAT3 *positions, size_t count, size_t stride);
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounding volume hierarchy over a mesh's triangles in object space, built with binned SAH.
+// Rays are tested against node boxes with slab tests on DirectXMath vectors; the packet query
+// traverses four rays together, one SIMD lane each. Triangles are two-sided.
+class MeshBvh
+{
+public:
+    static constexpr uint32_t SAH_BINS = 16;
+    static constexpr uint32_t MAX_LEAF_TRIANGLES = 4; // leaves only grow past this when no split is possible
+    static constexpr uint32_t INVALID_TRIANGLE = UINT32_MAX;
+    static constexpr uint32_t PACKET_SIZE = 4;
+
+    struct Ray
+    {
+        DirectX::XMFLOAT3 origin;
+        DirectX::XMFLOAT3 direction; // need not be normalized, t is in units of its length
+        float tMax = FLT_MAX;
+    };
+
+    struct Hit
+    {
+        float t = FLT_MAX;
+        uint32_t triangle = INVALID_TRIANGLE; // index into the source index range / 3
+        float u = 0.f;                        // barycentrics of the second and third corner
+        float v = 0.f;
+    };
+
+    struct ClosestPoint
+    {
+        DirectX::XMFLOAT3 point;
+        float distance = FLT_MAX;
+        uint32_t triangle = INVALID_TRIANGLE;
+    };
+
+    // `positions` are read with `positionStride` bytes between them (e.g. &vertices[0].pos, sizeof(Vertex))
+    MeshBvh(const DirectX::XMFLOAT3 *positions, size_t positionStride, size_t vertexCount, const uint32_t *indices, size_t indexCount);
+
+    bool intersect(const Ray &ray, Hit &hit) const; // closest hit before ray.tMax
+    bool isOccluded(const Ray &ray) const;          // any hit before ray.tMax, for line-of-sight
+    void intersect(const Ray *rays, size_t rayCount, Hit *hits) const; // packets of PACKET_SIZE, best for coherent rays
+
+    // Closest surface point within maxDistance of `point`
+    bool findClosestPoint(const DirectX::XMFLOAT3 &point, float maxDistance, ClosestPoint &result) const;
+
+    size_t getNodeCount() const { return m_nodes.size(); }
+    size_t getTriangleCount() const { return m_triangles.size(); }
+    size_t getMemoryBytes() const;
+    uint32_t getDepth() const { return m_depth; }
+
+private:
+    // 32 bytes, inner nodes have triangleCount 0 and their children at leftOrFirst, leftOrFirst + 1
+    struct Node
+    {
+        DirectX::XMFLOAT3 boundsMin;
+        uint32_t leftOrFirst;
+        DirectX::XMFLOAT3 boundsMax;
+        uint32_t triangleCount;
+    };
+
+    // Moller-Trumbore form, in leaf order
+    struct Triangle
+    {
+        DirectX::XMFLOAT3 v0;
+        DirectX::XMFLOAT3 edge1;
+        DirectX::XMFLOAT3 edge2;
+    };
+
+    void build(const std::vector<DirectX::XMFLOAT3> &boundsMin, const std::vector<DirectX::XMFLOAT3> &boundsMax,
+               const std::vector<DirectX::XMFLOAT3> &centroids, std::vector<uint32_t> &order);
+
+    template <bool ANY_HIT>
+    bool traverse(const Ray &ray, Hit &hit) const;
+    void intersectPacket(const Ray *rays, size_t rayCount, Hit *hits) const;
+
+    std::vector<Node> m_nodes;
+    std::vector<Triangle> m_triangles;
+    std::vector<uint32_t> m_triangleIds; // leaf order -> source triangle
+    uint32_t m_depth = 0;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "resources/vertex.h"
+#include "resources/mesh_bounds.h"
+#include "resources/mesh_lod.h"
+#include "resources/meshlet.h"
+#include "utils/mapped_file.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Versioned binary mesh blob (.dxmesh): Header | Vertex[vertexCount] | uint32_t[indexCount] (every LOD) | Meshlet[meshletCount].
+// The vertex array is stored in the exact `Vertex` layout so a mapped blob can be uploaded as is.
+class MeshCache
+{
+public:
+    static constexpr uint32_t MAGIC = 0x48534D44; // "DMSH"
+    static constexpr uint32_t VERSION = 3;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vertexStride;
+        uint32_t reserved;
+        uint64_t optionsKey; // hash of the load options that change the cooked data
+
+        // source stamp, size + mtime is the fast path, the content hash is the fallback
+        uint64_t sourceSize;
+        int64_t sourceWriteTime;
+        uint64_t sourceHash;
+        float sourceLoadMs; // text path load time, for comparison
+
+        MeshBounds bounds;
+        uint32_t lodCount;
+        MeshLod lods[MAX_MESH_LODS]; // ranges of the index array
+
+        uint64_t vertexCount;
+        uint64_t indexCount;
+        uint64_t meshletCount;
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint64_t meshletOffset;
+    };
+
+    // Blob mapped from disk, pointers stay valid while `file` lives
+    struct CachedMesh
+    {
+        std::unique_ptr<MappedFile> file;
+        const Header *header = nullptr;
+        const Vertex *vertices = nullptr;
+        const uint32_t *indices = nullptr;
+        const Meshlet *meshlets = nullptr;
+    };
+
+    // `primitive` selects one of several meshes cooked from the same source (glTF primitives), `optionsKey` one of
+    // several cooks of the same mesh
+    static std::string getCachePath(const std::string &sourcePath, uint32_t primitive, uint64_t optionsKey);
+
+    // Returns false when the blob is missing, from another version or layout, stale, or has ranges outside its arrays
+    static bool load(const std::string &sourcePath, uint32_t primitive, uint64_t optionsKey, CachedMesh &cached);
+
+    // Failures are logged, not thrown: the cache is only an accelerator
+    static void save(const std::string &sourcePath, uint32_t primitive, uint64_t optionsKey, float sourceLoadMs, const MeshBounds &bounds,
+                     const std::vector<MeshLod> &lods, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices,
+                     const std::vector<Meshlet> &meshlets);
+
+private:
+    struct SourceStamp
+    {
+        uint64_t size = 0;
+        int64_t writeTime = 0;
+    };
+
+    static bool getSourceStamp(const std::string &sourcePath, SourceStamp &stamp);
+    static uint64_t hashSource(const std::string &sourcePath);
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "resources/vertex.h"
+#include "resources/mesh_lod.h"
+#include <vector>
+
+// Procedural unit-centered spheres in the same convention as the OBJ loader output: y up, cw front faces
+// (left-handed) and equirectangular uvs with u = 0.75 - atan2(x, z) / 2pi, v = acos(y) / pi, seam at -x
+class MeshGenerator
+{
+public:
+    // Latitude / longitude sphere. The seam column is duplicated so u runs 0..1, poles get one vertex per segment
+    // so the texture isn't twisted there.
+    static void createUVSphere(uint32_t segments, uint32_t rings, float radius, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices);
+
+    // Icosahedron subdivided `subdivisions` times (20 * 4^n triangles), vertices projected to the sphere
+    static void createIcosphere(uint32_t subdivisions, float radius, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices);
+
+    // Every level from `subdivisions` down to `subdivisions - lodCount + 1` in one shared vertex buffer, finest
+    // first. Levels are concatenated in `indices` and described by `lods` (error: max distance to the sphere),
+    // ready for the Mesh constructor taking prebuilt LODs.
+    static void createIcosphereLods(uint32_t subdivisions, uint32_t lodCount, float radius,
+                                    std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, std::vector<MeshLod> &lods);
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+constexpr uint32_t MAX_MESH_LODS = 8;
+
+// One level of detail, a range of the mesh's shared index buffer
+struct MeshLod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error; // object space distance from the full mesh, 0 for LOD0
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "resources/vertex.h"
+#include "resources/obj_parser.h"
+#include "resources/mesh_lod.h"
+#include <vector>
+
+class MeshOptimizer
+{
+public:
+    struct IndexingStats
+    {
+        size_t vertexCountBefore = 0;
+        size_t vertexCountAfter = 0;
+        size_t bytesBefore = 0; // vertex + index buffer bytes
+        size_t bytesAfter = 0;
+    };
+
+    struct VertexCacheStats
+    {
+        float acmr = 0.f; // average cache miss ratio, vertex shader invocations per triangle (0.5 .. 3)
+        float atvr = 0.f; // average transformed vertex ratio, invocations per unique vertex (1 is optimal)
+    };
+
+    static constexpr uint32_t ANALYZE_CACHE_SIZE = 16; // FIFO, close to what current GPUs behave like
+
+    // Builds an indexed vertex buffer with one vertex per unique (position, texcoord, normal) index triple
+    static IndexingStats indexCorners(const ObjParser::Result &obj, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices);
+
+    // Merges vertices whose position, normal and texcoord all lie within epsilon (e.g. split seams). Collapsed
+    // triangles are dropped, `lods` (ranges of `indices`) are rewritten to the triangles they keep.
+    static IndexingStats weldVertices(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, float epsilon, std::vector<MeshLod> *lods = nullptr);
+
+    // Simulates a FIFO post-transform cache over a triangle list
+    static VertexCacheStats analyzeVertexCache(const uint32_t *indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = ANALYZE_CACHE_SIZE);
+
+    // Reorders triangles for the post-transform vertex cache (Forsyth, linear speed), deterministic
+    static void optimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount);
+
+    // Sorts the cache-ordered triangles in clusters, outward facing and far from the center first, so that
+    // occluders tend to be drawn before what they occlude. Keeps the old order if ACMR grows beyond `threshold`.
+    static void optimizeOverdraw(const std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, float threshold = 1.05f);
+
+    // Renumbers vertices in order of first use by the index buffer, unused vertices are dropped
+    static void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices);
+
+    static size_t getBufferBytes(size_t vertexCount, size_t indexCount);
+};
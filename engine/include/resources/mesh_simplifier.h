@@ -0,0 +1,21 @@
+#pragma once
+
+#include "resources/vertex.h"
+#include <vector>
+
+// Quadric error edge collapse (Garland-Heckbert) on the position-welded topology. Collapses move one
+// position onto a neighbouring one, so the output indexes the input vertices and LODs can share a vertex buffer.
+// UV seam and open boundary positions are locked in place. Runs headless, no device needed.
+class MeshSimplifier
+{
+public:
+    struct Result
+    {
+        size_t triangleCount = 0;
+        float error = 0.f; // object space, largest collapse error: sqrt of the area-weighted mean squared plane distance
+    };
+
+    // Stops at `targetIndexCount` or before the first collapse with an error above `targetError`
+    static Result simplify(const std::vector<Vertex> &vertices, const uint32_t *indices, size_t indexCount,
+                           size_t targetIndexCount, float targetError, std::vector<uint32_t> &result);
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "resources/vertex.h"
+#include <vector>
+
+// Fixed-size cluster of a triangle list, a contiguous range of the mesh's index buffer
+struct Meshlet
+{
+    uint32_t firstIndex;
+    uint32_t triangleCount;
+    uint32_t vertexCount; // unique vertices referenced
+
+    // bounding sphere, object space
+    DirectX::XMFLOAT3 center;
+    float radius;
+
+    // normal cone: every triangle normal lies within asin(coneSinAngle) of coneAxis, coneSinAngle >= 1 never culls
+    DirectX::XMFLOAT3 coneAxis;
+    float coneSinAngle;
+};
+
+class MeshletBuilder
+{
+public:
+    static constexpr uint32_t MAX_VERTICES = 64;
+    static constexpr uint32_t MAX_TRIANGLES = 124;
+
+    // Grows each meshlet from a seed triangle over shared vertices, preferring triangles that add the fewest new
+    // vertices and then the ones closest to the cluster, so clusters come out as compact patches with narrow cones.
+    // The triangles of indices[firstIndex, firstIndex + indexCount) are rewritten in meshlet order, seeds follow the
+    // input order (run it after the vertex cache pass so clusters keep most of the cache locality). Appends to `meshlets`.
+    static void build(const std::vector<Vertex> &vertices, uint32_t *indices, size_t indexCount, uint32_t firstIndex,
+                      uint32_t maxVertices, uint32_t maxTriangles, std::vector<Meshlet> &meshlets);
+
+    // True when every triangle of the meshlet faces away from `cameraPosition` (object space).
+    // Front faces are the side the vertex normals point to, independent of winding.
+    static bool isBackfacing(const Meshlet &meshlet, const DirectX::XMFLOAT3 &cameraPosition);
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class MipFilter
+{
+    Box,     // exact footprint average, softest
+    Kaiser,  // windowed sinc, radius 2, alpha 4: sharp with little ringing
+    Lanczos, // Lanczos3, sharpest, rings on hard edges
+};
+
+// One mip level, 8-bit four channel pixels (channel order as given), tightly packed
+struct MipLevel
+{
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint8_t> pixels;
+};
+
+// CPU mip chain for 8-bit RGBA / BGRA images. Levels are resampled one from another in linear light
+// (sRGB decoded when isSrgb, alpha always linear) with premultiplied alpha, kept in float between levels.
+// Odd sizes round down like D3D, the filter then spans the exact 2+ texel footprint. Edges wrap like the
+// ImageTexture sampler. Rows run on the ThreadPool, pixels as DirectXMath vectors.
+class MipGenerator
+{
+public:
+    static uint32_t getLevelCount(uint32_t width, uint32_t height);
+
+    // Level 0 is a copy of `pixels`
+    static std::vector<MipLevel> generate(const uint8_t *pixels, uint32_t width, uint32_t height, size_t rowPitch, bool isSrgb,
+                                          MipFilter filter = MipFilter::Kaiser);
+
+    // 8-bit rows to and from the premultiplied linear floats the filters run on (alpha in w)
+    static void decodeRow(const uint8_t *row, uint32_t width, bool isSrgb, DirectX::XMFLOAT4 *out);
+    static void encodeRow(const DirectX::XMFLOAT4 *row, uint32_t width, bool isSrgb, uint8_t *out);
+};
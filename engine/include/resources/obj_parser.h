@@ -0,0 +1,23 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+// Wavefront OBJ text parser, split into line-aligned chunks parsed in parallel.
+// Output is converted from right-hand, ccw to left-hand, cw (z and v flipped).
+class ObjParser
+{
+public:
+    struct Result
+    {
+        // index 0 of each attribute array is a zero sentinel (OBJ indices are 1-based, 0 = missing)
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<DirectX::XMFLOAT3> normals;
+        std::vector<DirectX::XMFLOAT2> texCoords;
+
+        // v, t, n per triangle corner, 3 corners per triangle (n-gons are fan triangulated)
+        std::vector<DirectX::XMINT3> corners;
+    };
+
+    static Result parse(const char *begin, const char *end);
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "utils/staging_pool.h"
+#include <string>
+
+// Decoded image as RGBA8, tightly packed (row pitch = width * 4) in pooled staging memory
+struct DecodedImage
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool isSrgb = false; // sRGB chunk, or a gAMA of 1/2.2; WIC tags both as an _SRGB format
+    StagingBuffer pixels;
+};
+
+// Portable PNG decoder: every color type and bit depth, tRNS, Adam7. 16-bit channels keep their high byte.
+// Inflate runs straight on the mapped file when the image data is a single IDAT chunk, the Sub / Up / Average /
+// Paeth unfilters use SSE2 for 3 and 4 byte pixels. No WIC or COM, so any thread can decode. Chunk CRCs are
+// not checked, the zlib Adler-32 already covers the image data.
+class PngDecoder
+{
+public:
+    static bool isPng(const void *data, size_t size);
+
+    // Throws std::runtime_error on malformed or unsupported data
+    static DecodedImage decode(const std::string &filePath);
+    static DecodedImage decode(const uint8_t *data, size_t size, const std::string &name);
+};
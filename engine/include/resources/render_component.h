@@ -3,19 +3,72 @@
 #include "utils/forward.h"
 #include "resources/mesh.h"
 #include "resources/material.h"
+#include "resources/lazy_asset.h"
+#include <vector>
+
+// Per-frame camera inputs for RenderComponent::prepare
+struct RenderView
+{
+    DirectX::XMMATRIX viewProjection;
+    DirectX::XMFLOAT3 cameraPosition;
+    float pixelsPerUnit; // screen pixels covered by one world unit at distance 1, i.e. viewportHeight / (2 tan(fov / 2))
+};
 
 class RenderComponent
 {
 public:
     RenderComponent(std::shared_ptr<Mesh> mesh, std::shared_ptr<MaterialBase> material);
+    // Lazy assets draw with their placeholders until requestAssets() finds them loaded
+    RenderComponent(std::shared_ptr<Mesh> mesh, std::shared_ptr<LazyAsset<MaterialBase>> material);
+    RenderComponent(std::shared_ptr<LazyAsset<Mesh>> mesh, std::shared_ptr<MaterialBase> material);
+    RenderComponent(std::shared_ptr<LazyAsset<Mesh>> mesh, std::shared_ptr<LazyAsset<MaterialBase>> material);
 
+    const std::shared_ptr<Mesh> &getMesh() const { return m_mesh; }
+    const std::shared_ptr<MaterialBase> &getMaterial() const { return m_material; }
     void setIsCullFront(bool isCullFront) { m_isCullFront = isCullFront; }
     bool getIsCullFront() const { return m_isCullFront; }
+    void setLodPixelError(float pixelError) { m_lodPixelError = pixelError; }
+    uint32_t getLodLevel() const { return m_lodLevel; }
+    size_t getMeshletCount() const { return m_meshletCount; }
+    size_t getVisibleMeshletCount() const { return m_visibleMeshletCount; }
+    size_t getDrawCallCount() const { return m_drawRanges.size(); } // issued by the next render
+    bool hasPendingAssets() const { return m_lazyMesh || m_lazyMaterial; } // still on a placeholder
+
+    // Starts the lazy loads on the first call (the component is visible or close), swaps each asset in once it is
+    // loaded. Before prepare, GameResourceManager calls it every frame for those components.
+    void requestAssets();
+
+    // Selects the LOD and, for LOD0 of meshes with meshlets, the visible clusters. Without a view the full LOD0 is drawn.
+    void prepare(const DirectX::XMMATRIX &world, const RenderView *view);
 
     void render(ID3D11DeviceContext *deviceContext);
 
 private:
+    struct DrawRange
+    {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+    };
+
+    // Tells the material how large the object projects, texture streaming loads the largest ones first
+    void requestTextureDetail(const DirectX::XMMATRIX &world, const RenderView &view) const;
+
+    // Picks the coarsest LOD whose error, projected at the near side of the bounding sphere, stays below
+    // m_lodPixelError. A coarser level is only taken once it is a margin below the threshold, so levels don't flicker.
+    void selectLod(const DirectX::XMMATRIX &world, const RenderView &view);
+
+    // Frustum and normal cone tests in object space, adjacent survivors are merged into one draw
+    void cullMeshlets(const DirectX::XMMATRIX &world, const RenderView &view);
+
     bool m_isCullFront;
+    uint32_t m_lodLevel;
+    float m_lodPixelError;
+    float m_lodHysteresis; // fraction of m_lodPixelError
+    std::vector<DrawRange> m_drawRanges;
+    size_t m_meshletCount;
+    size_t m_visibleMeshletCount;
     std::shared_ptr<Mesh> m_mesh;
     std::shared_ptr<MaterialBase> m_material;
+    std::shared_ptr<LazyAsset<Mesh>> m_lazyMesh; // until loaded, m_mesh is its placeholder
+    std::shared_ptr<LazyAsset<MaterialBase>> m_lazyMaterial;
 };
@@ -1,22 +1,38 @@
 #pragma once
 
 #include "utils/forward.h"
+#include "utils/hash.h"
+
+// Compiled VSMain / PSMain, what Shader::compile hands to the constructor
+struct ShaderBytecode
+{
+    Microsoft::WRL::ComPtr<ID3DBlob> vertexShader;
+    Microsoft::WRL::ComPtr<ID3DBlob> pixelShader;
+};
 
 class Shader
 {
 public:
     Shader(ID3D11Device *device, const std::wstring &vertexShaderPath, const std::wstring &pixelShaderPath, const D3D11_INPUT_ELEMENT_DESC *inputElementDescs, UINT numInputElementDescs);
+    Shader(ID3D11Device *device, const ShaderBytecode &bytecode, const D3D11_INPUT_ELEMENT_DESC *inputElementDescs, UINT numInputElementDescs);
     ~Shader() = default;
 
     void bind(ID3D11DeviceContext *deviceContext) const;
 
     ID3D11InputLayout *getInputLayout() const;
+    // Bytecode and input layout: equal for shaders built from the same sources, whichever object holds them
+    uint64_t getContentKey() const { return m_contentKey; }
+
+    // No device involved, runs on any thread (AssetLoader). Throws std::runtime_error.
+    static ShaderBytecode compile(const std::wstring &vertexShaderPath, const std::wstring &pixelShaderPath);
+    static uint64_t hashInputLayout(const D3D11_INPUT_ELEMENT_DESC *inputElementDescs, UINT numInputElementDescs, uint64_t seed = FNV_OFFSET_BASIS);
 
 private:
-    HRESULT compileShaderFromFile(const std::wstring &fileName, LPCSTR entryPoint, LPCSTR shaderModel, ID3DBlob **ppBlobOut);
+    static HRESULT compileShaderFromFile(const std::wstring &fileName, LPCSTR entryPoint, LPCSTR shaderModel, ID3DBlob **ppBlobOut);
 
 private:
     Microsoft::WRL::ComPtr<ID3D11VertexShader> m_vertexShader;
     Microsoft::WRL::ComPtr<ID3D11PixelShader> m_pixelShader;
     Microsoft::WRL::ComPtr<ID3D11InputLayout> m_inputLayout;
+    uint64_t m_contentKey = 0;
 };
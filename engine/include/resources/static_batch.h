@@ -0,0 +1,24 @@
+#pragma once
+
+#include "utils/forward.h"
+#include "resources/vertex.h"
+#include <unordered_set>
+#include <vector>
+
+// Render components of static entities (EntityBase::setIsStatic) that share a material, vertex format and cull mode,
+// pre-transformed to world space and merged into one mesh. A batch is an entity with an identity transform, so it
+// draws with one model buffer and one mesh instead of one per member. Members lose their LODs, the merged mesh gets
+// meshlets for per-cluster culling instead.
+class StaticBatch
+{
+public:
+    // Appends the triangles of `indices` transformed by `world`, copying only the vertices they reference.
+    // Normals go through the inverse transpose, mirroring transforms swap the winding so front faces stay front.
+    static void append(const std::vector<Vertex> &vertices, const uint32_t *indices, size_t indexCount, const DirectX::XMMATRIX &world,
+                       std::vector<Vertex> &batchVertices, std::vector<uint32_t> &batchIndices);
+
+    // Merges every group of at least two components of `entities`. Meshes without CPU geometry are rematerialized for
+    // the merge and released again, components that cannot be are left out. Merged ones are added to `batchedComponents`.
+    static std::vector<std::shared_ptr<EntityBase>> build(ID3D11Device *device, const std::vector<std::shared_ptr<EntityBase>> &entities,
+                                                          std::unordered_set<const RenderComponent *> &batchedComponents);
+};
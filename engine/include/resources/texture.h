@@ -1,15 +1,84 @@
 #pragma once
 
 #include "utils/forward.h"
+#include "resources/png_decoder.h"
+#include "resources/block_compressor.h"
+#include "resources/texture_cache.h"
+#include <vector>
 
+// Every texture is viewed as a Texture2DArray (ArraySize 1 unless packed), so one shader serves all of them;
+// CubemapTexture, sampled by direction, is the exception
 class TextureBase {
 public:
-    virtual ~TextureBase() = default;
+    virtual ~TextureBase();
     
     virtual void bind(ID3D11DeviceContext* deviceContext, UINT slot) const = 0;
 
+    // Mip streaming for TextureResidency: keeps the levels from `mip` (of the full chain) down, on the render
+    // thread. Only called on textures tracked as streamable; throws std::runtime_error when levels cannot come back.
+    virtual void setResidentMip(ID3D11Device*, ID3D11DeviceContext*, uint32_t) {}
+    uint32_t getResidentMip() const { return m_residentMip; }
+    size_t getGpuBytes() const; // resident levels as TextureResidency counts them, 0 when untracked
+
+    // Progressive loading for TextureStreamer: loadStreamed builds the full chain on a pool worker without
+    // touching what draws use, commitStreamed swaps it in on the render thread. Only called on textures that came
+    // up with a mip tail; loadStreamed throws std::runtime_error.
+    virtual void loadStreamed(ID3D11Device*) {}
+    virtual void commitStreamed() {}
+
+    // Projected size in pixels a draw wants the texture at; the largest one of the latest frame is the streaming
+    // priority, 0 when the texture was not drawn
+    void requestDetail(float screenSize) const;
+    float getScreenSize() const { return m_screenSizeFrame == s_frame ? m_screenSize : 0.f; }
+
+    // Frame of the last bind(); TextureResidency moves the frame number on once per frame
+    uint64_t getLastUsedFrame() const { return m_lastUsedFrame; }
+    static uint64_t getFrame() { return s_frame; }
+    static void advanceFrame() { ++s_frame; }
+
+    // Binds are filtered like GeometryPool's: a draw whose texture already sits in its slot skips the PSSet* calls.
+    // Other passes may touch the pixel shader slots, GameResourceManager forgets the bindings once per frame.
+    static void invalidateBindings();
+
 protected:
+    bool isBound(UINT slot) const;
+    void setBound(UINT slot) const;
+    void forgetBindings() const; // the view changed under the same texture
+    void markUsed() const { m_lastUsedFrame = s_frame; }
+    void createSampler(ID3D11Device* device);
+
+    // Registers the byte cost of every level of `texture` with TextureResidency; a streamable texture may drop its
+    // top levels (block compressed ones only down to a level of whole blocks). The rest track a fixed cost.
+    // Tracking again replaces the earlier entry.
+    void trackResidency(ID3D11Texture2D* texture, bool isStreamable);
+    void trackResidency(size_t gpuBytes, size_t cpuBytes);
+
+    // A new texture with the levels of `source` from `firstMip` down, copied on the GPU
+    static Microsoft::WRL::ComPtr<ID3D11Texture2D> copyMipTail(ID3D11Device* device, ID3D11DeviceContext* deviceContext,
+                                                               ID3D11Texture2D* source, UINT firstMip);
+
     Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_srv;
+    Microsoft::WRL::ComPtr<ID3D11SamplerState> m_sampler; // same slot as the texture, none for ConstantTexture
+    uint32_t m_residentMip = 0;
+
+private:
+    static constexpr UINT TRACKED_SLOTS = 8;
+    static const TextureBase* s_boundTextures[TRACKED_SLOTS];
+    static uint64_t s_frame;
+
+    uint32_t m_residencyId = UINT32_MAX;
+    mutable uint64_t m_lastUsedFrame = 0;
+    mutable float m_screenSize = 0.f;
+    mutable uint64_t m_screenSizeFrame = 0;
+};
+
+// A texture as a material samples it: a slice of a (possibly packed) array, atlas items with their uv rect
+struct TextureRef
+{
+    std::shared_ptr<TextureBase> texture;
+    uint32_t slice = 0;
+    DirectX::XMFLOAT4 uvScaleBias = {1.f, 1.f, 0.f, 0.f}; // atlas uv = frac(uv) * xy + zw
+    bool isAtlas = false;
 };
 
 class ConstantTexture : public TextureBase {
@@ -23,15 +92,122 @@ private:
     Microsoft::WRL::ComPtr<ID3D11Texture2D> m_texture;
 };
 
+// How ImageTexture cooks its mip chain, the result is cached as DDS under cache/texture/
+enum class TextureCompression
+{
+    None, // RGBA8
+    Auto, // BC1 when fully opaque, BC7 otherwise
+    BC1,
+    BC3,
+    BC7,
+};
+
+enum class TextureLoading
+{
+    Blocking,    // the whole chain before the constructor returns
+    Progressive, // a small mip tail right away, the rest streamed in later by TextureStreamer
+};
+
 class ImageTexture : public TextureBase {
 public:
-    ImageTexture(ID3D11Device* device, const std::string& filePath);
+    // A progressive texture comes up with its levels from this size down (whole blocks when block compressed)
+    static constexpr uint32_t PROGRESSIVE_TAIL_SIZE = 64;
+
+    // The levels a load uploads, read from the cache or decoded and cooked, so the constructor taking it only
+    // creates the resources
+    struct PreparedTexture
+    {
+        std::string filePath;
+        TextureCompression compression = TextureCompression::Auto;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        uint32_t width = 0; // of the full chain
+        uint32_t height = 0;
+        uint32_t mipLevels = 0;
+        uint32_t residentMip = 0;            // first level uploaded, the tail's for a progressive load
+        std::vector<const uint8_t*> levels;  // from residentMip down, into `cached` or `ownedLevels`
+        std::vector<uint32_t> rowPitches;
+        TextureCache::CachedTexture cached;
+        std::vector<std::vector<uint8_t>> ownedLevels;
+        DecodedImage streamImage; // a progressive tail box filtered on a cache miss, cooked by loadStreamed
+    };
+
+    ImageTexture(ID3D11Device* device, const std::string& filePath, TextureCompression compression = TextureCompression::Auto,
+                 TextureLoading loading = TextureLoading::Blocking);
+    ImageTexture(ID3D11Device* device, PreparedTexture&& prepared);
     ~ImageTexture() = default;
 
+    // Decode, cook and cache reads, no device involved (AssetLoader runs it on the ThreadPool). Throws std::runtime_error.
+    static PreparedTexture prepare(const std::string& filePath, TextureCompression compression = TextureCompression::Auto,
+                                   TextureLoading loading = TextureLoading::Blocking);
+    // Prepares every file concurrently on the ThreadPool, then creates them in order on the calling thread.
+    // Progressive textures are handed to TextureStreamer.
+    static std::vector<std::shared_ptr<ImageTexture>> loadAll(ID3D11Device* device, const std::vector<std::string>& filePaths,
+                                                              TextureCompression compression = TextureCompression::Auto,
+                                                              TextureLoading loading = TextureLoading::Blocking);
+    static std::vector<PreparedTexture> prepareAll(const std::vector<std::string>& filePaths,
+                                                   TextureCompression compression = TextureCompression::Auto,
+                                                   TextureLoading loading = TextureLoading::Blocking);
+    static std::vector<std::shared_ptr<ImageTexture>> createAll(ID3D11Device* device, std::vector<PreparedTexture>&& prepared);
+
+    // RGBA8 pixels of an image file: PNGs decode in engine, the rest through WIC. Throws std::runtime_error.
+    static DecodedImage decode(const std::string& filePath);
+    // The chain an earlier load cooked with `compression`, false when it is missing or stale
+    static bool loadCached(const std::string& filePath, TextureCompression compression, TextureCache::CachedTexture& cached);
+    // Decodes and cooks the chain into the cache unless it is there already. Throws std::runtime_error.
+    static void cookCached(const std::string& filePath, TextureCompression compression);
+    // The block format the cook encodes `image` with, false when it stays RGBA8 (a top level not in whole blocks)
+    static bool selectBlockFormat(const DecodedImage& image, TextureCompression compression, BlockFormat& blockFormat);
+    static DXGI_FORMAT getCookedFormat(bool isBlockCompressed, BlockFormat blockFormat, bool isSrgb);
+
     void bind(ID3D11DeviceContext* deviceContext, UINT slot) const override;
+    // Drops levels with a GPU copy, restores them from the cooked chain (cooking again if the cache is gone)
+    void setResidentMip(ID3D11Device* device, ID3D11DeviceContext* deviceContext, uint32_t mip) override;
+    void loadStreamed(ID3D11Device* device) override;
+    void commitStreamed() override;
+
+    // Whether the full chain is still to be streamed in
+    bool isStreamPending() const { return m_isStreamPending; }
+
+    // What the texture is after streaming, getTexture() may still be the tail
+    ID3D11Texture2D* getTexture() const { return m_texture.Get(); }
+    uint32_t getWidth() const { return m_width; }
+    uint32_t getHeight() const { return m_height; }
+    uint32_t getMipLevels() const { return m_mipLevels; }
+    DXGI_FORMAT getFormat() const { return m_format; }
 
 private:
-    void loadFromFile(ID3D11Device* device, const std::string& filePath);
+    struct CookedTexture
+    {
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<std::vector<uint8_t>> levels;
+    };
+
+    // Mip chain, block compression and the cache entry
+    static CookedTexture cook(const std::string& filePath, const DecodedImage& image, TextureCompression compression);
+    static Microsoft::WRL::ComPtr<ID3D11Texture2D> createTexture(ID3D11Device* device, DXGI_FORMAT format, UINT width, UINT height,
+                                                                 const std::vector<D3D11_SUBRESOURCE_DATA>& levels);
+    static Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> createView(ID3D11Device* device, ID3D11Texture2D* texture);
+
+    // The whole chain, from the cache or cooked into it; the progressive tail, from the cache or box filtered
+    static PreparedTexture prepareChain(const std::string& filePath, TextureCompression compression);
+    static PreparedTexture prepareTail(const std::string& filePath, TextureCompression compression);
+
+    void upload(ID3D11Device* device, PreparedTexture&& prepared);
+    void setTexture(ID3D11Device* device, const Microsoft::WRL::ComPtr<ID3D11Texture2D>& texture);
     
     Microsoft::WRL::ComPtr<ID3D11Texture2D> m_texture;
+    std::string m_filePath;
+    TextureCompression m_compression;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    uint32_t m_mipLevels = 0;
+    DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+
+    // progressive: the tail is up, loadStreamed fills the streamed resources, commitStreamed swaps them in
+    bool m_isStreamPending = false;
+    DecodedImage m_streamImage; // decoded for the tail on a cache miss, cooked by loadStreamed
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> m_streamedTexture;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_streamedSrv;
 };
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "resources/texture.h"
+#include "resources/texture_packer.h"
+#include "resources/mip_generator.h"
+
+// Texture2DArray that several materials share, each sampling its own slice (and uv rect on atlas pages).
+// Draws with the same array in the same slot skip the texture bind entirely.
+class TextureArray : public TextureBase {
+public:
+    // Slices copied on the GPU from textures of one size, format and mip count. With the slices' `sourcePaths`
+    // (ImageTextures cooked with `compression`) the array can drop its top levels and restore them from the cache.
+    // Slices that are progressive tails starting at `residentMip` of their chains make an array at that mip,
+    // loadStreamed builds the full one from the sources.
+    TextureArray(ID3D11Device* device, const std::vector<ID3D11Texture2D*>& slices, const std::vector<std::string>& sourcePaths = {},
+                 TextureCompression compression = TextureCompression::Auto, uint32_t residentMip = 0);
+    // Slices from CPU mip chains, `slices[slice][level]`, RGBA8 in `format`
+    TextureArray(ID3D11Device* device, DXGI_FORMAT format, const std::vector<std::vector<MipLevel>>& slices);
+    ~TextureArray() = default;
+
+    // The CPU side of loadPacked: every texture prepared, the layout, atlas pages composed with their chains
+    struct PreparedPack
+    {
+        TextureCompression compression = TextureCompression::Auto;
+        std::vector<ImageTexture::PreparedTexture> textures;
+        TexturePackLayout layout;
+        std::vector<std::vector<std::vector<MipLevel>>> atlasPages; // per group, `[slice][level]`, empty for arrays
+    };
+
+    // Loads every file like ImageTexture::loadAll, then packs them as TexturePacker lays out: array groups share
+    // one TextureArray, atlas items are decoded again and composed into pages, the rest stays standalone.
+    // Progressive arrays and standalone textures stream through TextureStreamer, atlas pages load whole.
+    // One ref per path, in order.
+    static std::vector<TextureRef> loadPacked(ID3D11Device* device, const std::vector<std::string>& filePaths,
+                                              const TexturePackOptions& options = {},
+                                              TextureCompression compression = TextureCompression::Auto,
+                                              TextureLoading loading = TextureLoading::Blocking);
+    // Decoding, cooking and page composition, no device involved (AssetLoader runs it on the ThreadPool)
+    static PreparedPack preparePacked(const std::vector<std::string>& filePaths, const TexturePackOptions& options = {},
+                                      TextureCompression compression = TextureCompression::Auto,
+                                      TextureLoading loading = TextureLoading::Blocking);
+    // Resource creation and the GPU copies into arrays, on the thread owning the immediate context
+    static std::vector<TextureRef> createPacked(ID3D11Device* device, PreparedPack&& prepared);
+
+    void bind(ID3D11DeviceContext* deviceContext, UINT slot) const override;
+    void setResidentMip(ID3D11Device* device, ID3D11DeviceContext* deviceContext, uint32_t mip) override;
+    void loadStreamed(ID3D11Device* device) override;
+    void commitStreamed() override;
+
+    UINT getSliceCount() const { return m_sliceCount; }
+
+private:
+    // Every slice from its cooked chain, levels from `mip` down
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> createFromCache(ID3D11Device* device, uint32_t mip) const;
+    static Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> createView(ID3D11Device* device, ID3D11Texture2D* texture);
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> m_texture;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> m_streamedTexture;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_streamedSrv;
+    UINT m_sliceCount = 0;
+    std::vector<std::string> m_sourcePaths; // empty for atlas pages, which stay whole
+    TextureCompression m_compression = TextureCompression::Auto;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "utils/forward.h"
+#include "utils/mapped_file.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Cooked textures as plain DDS files (DX10 header, every mip level), readable by any DDS tool. The source stamp
+// lives in the header's reserved words so a stale file is detected without a side file. Cube maps store each
+// face's chain in turn, +X -X +Y -Y +Z -Z, in a file of their own next to the source's 2D one.
+class TextureCache
+{
+public:
+    static constexpr uint32_t TAG = 0x43455844; // "DXEC"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t CUBE_FACE_COUNT = 6;
+
+    // Levels mapped from disk, pointers stay valid while `file` lives
+    struct CachedTexture
+    {
+        std::unique_ptr<MappedFile> file;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipLevels = 0;
+        std::vector<const uint8_t *> levels; // levels[face * mipLevels + mip], one face unless a cube map
+        std::vector<uint32_t> rowPitches;    // bytes per row of texels (block row for BC formats)
+    };
+
+    static std::string getCachePath(const std::string &sourcePath, bool isCube = false);
+
+    // Returns false when the file is missing, from another version or options, or stale
+    static bool load(const std::string &sourcePath, uint64_t optionsKey, CachedTexture &cached, bool isCube = false);
+
+    // Failures are logged, not thrown: the cache is only an accelerator. A cube map's `levels` are
+    // levels[face * mipLevels + mip] of CUBE_FACE_COUNT square faces.
+    static void save(const std::string &sourcePath, uint64_t optionsKey, DXGI_FORMAT format, uint32_t width, uint32_t height,
+                     const std::vector<std::vector<uint8_t>> &levels, bool isCube = false);
+
+    // Bytes per row and per level for the formats the cook writes (RGBA8, BC1, BC3, BC7, UNORM or sRGB)
+    static uint32_t getRowPitch(DXGI_FORMAT format, uint32_t width);
+    static size_t getLevelSize(DXGI_FORMAT format, uint32_t width, uint32_t height);
+    static bool isBlockCompressed(DXGI_FORMAT format);
+};
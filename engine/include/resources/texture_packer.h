@@ -0,0 +1,74 @@
+#pragma once
+
+#include "utils/forward.h"
+#include <cstdint>
+#include <vector>
+
+// One texture to pack, as created on the device
+struct TexturePackItem
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipLevels;
+    DXGI_FORMAT format;
+};
+
+struct TexturePackOptions
+{
+    uint32_t minArraySize = 2;      // textures sharing size, format and mip count group into a Texture2DArray from this many
+    uint32_t maxAtlasItemSize = 256; // ungrouped textures this small on both sides share atlas pages, 0 disables atlases
+    uint32_t atlasPageSize = 1024;   // power of two
+    uint32_t atlasMipLevels = 5;     // mip levels kept free of neighbour bleeding, items sit in 2^(levels - 1) aligned cells
+};
+
+struct TexturePackGroup
+{
+    enum class Kind
+    {
+        Array, // items copied slice by slice, their own mip chains
+        Atlas, // items composed into RGBA8 pages with wrapped gutters, the page chain is box filtered
+    };
+
+    Kind kind;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipLevels;
+    uint32_t sliceCount;
+    uint32_t gutter; // atlas cell size and gutter width in texels, 0 for arrays
+    DXGI_FORMAT format;
+    std::vector<uint32_t> items;
+};
+
+struct TexturePlacement
+{
+    static constexpr uint32_t STANDALONE = UINT32_MAX;
+
+    uint32_t group = STANDALONE;
+    uint32_t slice = 0;
+    uint32_t x = 0; // atlas texel rect of the item, gutters excluded
+    uint32_t y = 0;
+    DirectX::XMFLOAT4 uvScaleBias = {1.f, 1.f, 0.f, 0.f}; // atlas uv = frac(uv) * xy + zw
+};
+
+struct TexturePackLayout
+{
+    std::vector<TexturePackGroup> groups;
+    std::vector<TexturePlacement> placements; // one per item
+};
+
+// CPU side of texture packing, no device needed. Same size / format / mip count textures become array slices;
+// small leftovers go to skyline packed atlas pages. An atlas item with L = atlasMipLevels keeps a gutter of
+// A = 2^(L-1) texels and its padded rect starts and ends on A aligned texels, so every texel of mips 0..L-1
+// under a box filter belongs to exactly one item, and bilinear taps at the item border land in its own gutter.
+class TexturePacker
+{
+public:
+    static TexturePackLayout pack(const std::vector<TexturePackItem> &items, const TexturePackOptions &options = {});
+
+    // RGBA8 page `slice` of an atlas group; `itemPixels` is indexed like the items, tightly packed RGBA8.
+    // Gutters repeat the item wrapped around, like the sampler would; free space is transparent black.
+    static std::vector<uint8_t> composeAtlasPage(const TexturePackLayout &layout, uint32_t group, uint32_t slice,
+                                                 const std::vector<TexturePackItem> &items, const std::vector<const uint8_t *> &itemPixels);
+
+    static bool isSrgbFormat(DXGI_FORMAT format);
+};
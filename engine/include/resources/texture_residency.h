@@ -0,0 +1,38 @@
+#pragma once
+
+#include "utils/forward.h"
+#include "resources/texture_residency_policy.h"
+#include <mutex>
+#include <vector>
+
+class TextureBase;
+
+// Every live texture with its GPU / CPU byte cost, kept under one budget by TextureResidencyPolicy. Textures
+// track themselves on creation; once per frame update() feeds the policy the frame each one was last bound in
+// and applies what it decides through TextureBase::setResidentMip.
+class TextureResidency
+{
+public:
+    static TextureResidency &getInstance();
+
+    void setOptions(const TextureResidencyOptions &options);
+
+    // Thread safe, textures load on the ThreadPool. Returns the id for untrack.
+    uint32_t track(TextureBase *texture, const std::vector<size_t> &levelBytes, uint32_t width, uint32_t height,
+                   uint32_t maxResidentMip, size_t cpuBytes = 0);
+    void untrack(uint32_t id);
+    size_t getResidentBytes(uint32_t id) const; // GPU, after the drops
+
+    // Once per frame before drawing, on the render thread: last frame's binds decide what drops and what comes back
+    void update(ID3D11Device *device, ID3D11DeviceContext *deviceContext);
+
+    TextureResidencyPolicy::Stats getStats() const;
+    void logStats() const;
+
+private:
+    TextureResidency() = default;
+
+    mutable std::mutex m_mutex;
+    TextureResidencyPolicy m_policy;
+    std::vector<TextureBase *> m_textures; // by policy id
+};
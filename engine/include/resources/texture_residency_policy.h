@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TextureResidencyOptions
+{
+    size_t budgetBytes = 256 * 1024 * 1024; // GPU bytes of every tracked texture together
+    uint32_t minResidentSize = 64;          // levels this size and smaller are never dropped
+    uint32_t maxReloadsPerFrame = 2;        // textures restored per update, each one is a reload from disk
+    uint32_t minIdleFrames = 30;            // unused this long before a texture gives levels to another one
+};
+
+// Decides which mips of which textures stay on the GPU, without touching a device. Textures are entries with a
+// byte cost per mip level; when the total exceeds the budget the least recently used ones lose their most
+// detailed level, one at a time, down to minResidentSize. A texture used in the latest frame gets its levels
+// back as long as they fit, taking room only from textures idle for minIdleFrames, so textures that flicker in
+// and out of view do not trade the same bytes back and forth.
+class TextureResidencyPolicy
+{
+public:
+    static constexpr uint32_t INVALID_ID = UINT32_MAX;
+
+    struct Stats
+    {
+        size_t budgetBytes = 0;
+        size_t residentBytes = 0; // GPU, after the drops
+        size_t fullBytes = 0;     // GPU if every texture kept every level
+        size_t cpuBytes = 0;
+        uint32_t textureCount = 0;
+        uint32_t reducedCount = 0; // textures missing at least one level
+        uint64_t evictions = 0;    // textures that lost levels in an update
+        uint64_t reloads = 0;      // textures that got levels back in an update
+        uint64_t evictedBytes = 0;
+        uint64_t reloadedBytes = 0;
+    };
+
+    struct Change
+    {
+        uint32_t id;
+        uint32_t residentMip; // most detailed level to keep
+    };
+
+    explicit TextureResidencyPolicy(const TextureResidencyOptions &options = {});
+
+    // `levelBytes` per mip level, most detailed first. Levels up to `maxResidentMip` may be dropped (further
+    // limited by minResidentSize), 0 keeps the texture whole; it still counts against the budget.
+    uint32_t add(const std::vector<size_t> &levelBytes, uint32_t width, uint32_t height, uint32_t maxResidentMip, size_t cpuBytes = 0);
+    void remove(uint32_t id);
+
+    void touch(uint32_t id, uint64_t frame);
+
+    // `frame` is the latest one touches were recorded for. Returns the textures whose resident mip changed,
+    // the bookkeeping already assumes the changes are applied.
+    std::vector<Change> update(uint64_t frame);
+
+    // The texture could not change: it stays at `residentMip` and is not streamed any more
+    void pin(uint32_t id, uint32_t residentMip);
+
+    uint32_t getResidentMip(uint32_t id) const { return m_entries[id].residentMip; }
+    size_t getResidentBytes(uint32_t id) const { return m_entries[id].tailBytes[m_entries[id].residentMip]; }
+
+    const TextureResidencyOptions &getOptions() const { return m_options; }
+    // The budget applies from the next update, minResidentSize to textures added afterwards
+    void setOptions(const TextureResidencyOptions &options) { m_options = options; }
+    Stats getStats() const;
+
+private:
+    struct Entry
+    {
+        std::vector<size_t> tailBytes; // bytes of level i and every coarser one, one past the last level is 0
+        uint32_t residentMip = 0;
+        uint32_t maxResidentMip = 0;
+        uint64_t lastUsed = 0;
+        size_t cpuBytes = 0;
+        bool isLive = false;
+        bool isPinned = false;
+    };
+
+    size_t getLevelBytes(const Entry &entry, uint32_t mip) const { return entry.tailBytes[mip] - entry.tailBytes[mip + 1]; }
+
+    // Drops the top level of the least recently used texture last used before `usedBefore`, false when none can drop
+    bool dropLeastRecent(uint64_t usedBefore);
+
+    TextureResidencyOptions m_options;
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_unusedIds;
+    size_t m_residentBytes = 0;
+    uint64_t m_evictions = 0;
+    uint64_t m_reloads = 0;
+    uint64_t m_evictedBytes = 0;
+    uint64_t m_reloadedBytes = 0;
+};
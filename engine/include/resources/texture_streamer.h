@@ -0,0 +1,65 @@
+#pragma once
+
+#include "utils/forward.h"
+#include <future>
+#include <mutex>
+#include <vector>
+
+class TextureBase;
+
+struct TextureStreamerOptions
+{
+    uint32_t maxConcurrentLoads = 2; // full chains decoding / uploading on the ThreadPool at once
+};
+
+// Brings progressive textures (TextureLoading::Progressive) from their mip tail to the full chain. Each frame
+// update() swaps in the loads that finished and starts the pending textures drawn largest on screen in the
+// latest frame (TextureBase::getScreenSize), so what the camera looks at sharpens first. Time to the first frame
+// and to full quality are measured from startup and reported separately.
+class TextureStreamer
+{
+public:
+    struct Stats
+    {
+        uint32_t pendingCount = 0;
+        uint32_t loadingCount = 0;
+        uint32_t streamedCount = 0;
+        uint32_t failedCount = 0;    // kept at their tail
+        float firstFrameMs = -1.f;   // startup to the first update(), -1 before it
+        float fullQualityMs = -1.f;  // startup to the update() that committed the last pending texture, -1 before it
+    };
+
+    static TextureStreamer &getInstance();
+
+    void setOptions(const TextureStreamerOptions &options);
+
+    // Thread safe; the streamer only holds the texture while its load runs
+    void request(const std::shared_ptr<TextureBase> &texture);
+
+    // Once per frame before drawing, on the render thread
+    void update(ID3D11Device *device);
+
+    Stats getStats() const;
+    void logStats() const;
+
+private:
+    struct Load
+    {
+        std::shared_ptr<TextureBase> texture;
+        std::future<bool> isLoaded;
+    };
+
+    TextureStreamer() = default;
+
+    void startLoads(ID3D11Device *device);
+
+    mutable std::mutex m_mutex;
+    TextureStreamerOptions m_options;
+    std::vector<std::weak_ptr<TextureBase>> m_pending;
+    std::vector<Load> m_loads;
+    uint32_t m_streamedCount = 0;
+    uint32_t m_failedCount = 0;
+    bool m_hasRequests = false;
+    float m_firstFrameMs = -1.f;
+    float m_fullQualityMs = -1.f;
+};
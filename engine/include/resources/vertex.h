@@ -12,3 +12,30 @@ struct Vertex {
     static const D3D11_INPUT_ELEMENT_DESC inputLayout[3];
     static const uint32_t numElements = ARRAYSIZE(inputLayout);
 };
+
+enum class VertexFormat
+{
+    Full,    // Vertex, 32 bytes
+    Compact, // CompactVertex, 16 bytes, needs vs_compact.hlsl
+};
+
+// 16 bytes: position as unorm16 relative to the mesh bounds (dequantized with MeshBuffer, b4),
+// octahedral normal as snorm16, uv as half floats (keeps tiling uvs outside [0, 1])
+struct CompactVertex {
+    uint16_t pos[4]; // .w unused, R16G16B16 has no vertex format
+    int16_t n[2];
+    uint16_t uv[2];
+
+    static const D3D11_INPUT_ELEMENT_DESC inputLayout[3];
+    static const uint32_t numElements = ARRAYSIZE(inputLayout);
+};
+static_assert(sizeof(CompactVertex) == 16, "CompactVertex size mismatch!");
+
+// 8 bytes: quantized position only, a separate stream for depth-only passes
+struct PositionVertex {
+    uint16_t pos[4];
+
+    static const D3D11_INPUT_ELEMENT_DESC inputLayout[1];
+    static const uint32_t numElements = ARRAYSIZE(inputLayout);
+};
+static_assert(sizeof(PositionVertex) == 8, "PositionVertex size mismatch!");
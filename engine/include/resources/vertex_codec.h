@@ -0,0 +1,45 @@
+#pragma once
+
+#include "resources/vertex.h"
+#include "resources/mesh_bounds.h"
+#include <vector>
+
+// Encode / decode between Vertex and the compact layouts in vertex.h
+class VertexCodec
+{
+public:
+    struct Quantization
+    {
+        DirectX::XMFLOAT3 offset; // bounds min
+        DirectX::XMFLOAT3 scale;  // bounds extent, never zero
+    };
+
+    struct ErrorStats
+    {
+        float maxPositionError = 0.f; // object space units, per axis
+        float maxNormalErrorDegrees = 0.f;
+        float maxTexCoordError = 0.f;
+    };
+
+    static Quantization getQuantization(const MeshBounds &bounds);
+
+    static uint16_t encodeUnorm16(float value);
+    static float decodeUnorm16(uint16_t value);
+
+    // Octahedral map of the unit sphere onto [-1, 1]^2, stored as snorm16
+    static void encodeOctahedral(const DirectX::XMFLOAT3 &normal, int16_t encoded[2]);
+    static DirectX::XMFLOAT3 decodeOctahedral(const int16_t encoded[2]);
+
+    static CompactVertex encodeCompact(const Vertex &vertex, const Quantization &quantization);
+    static Vertex decodeCompact(const CompactVertex &vertex, const Quantization &quantization);
+    static PositionVertex encodePosition(const DirectX::XMFLOAT3 &position, const Quantization &quantization);
+
+    static void encodeCompact(const Vertex *vertices, size_t count, const Quantization &quantization, std::vector<CompactVertex> &encoded);
+    static void encodePositions(const Vertex *vertices, size_t count, const Quantization &quantization, std::vector<PositionVertex> &encoded);
+
+    // Decodes every vertex again and compares against the source
+    static ErrorStats measureError(const Vertex *vertices, const CompactVertex *encoded, size_t count, const Quantization &quantization);
+
+    // Worst case round-trip error of a well-formed input, measureError should stay below this
+    static ErrorStats getErrorBounds(const Quantization &quantization, float maxTexCoord);
+};
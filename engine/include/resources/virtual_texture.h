@@ -0,0 +1,73 @@
+#pragma once
+
+#include "resources/texture.h"
+#include "resources/virtual_texture_cache.h"
+#include <future>
+#include <unordered_set>
+
+struct VirtualTextureOptions
+{
+    size_t cacheBytes = 32 * 1024 * 1024; // physical tile cache, fixed for the texture's life
+    uint32_t maxUploadsPerFrame = 16;
+    uint32_t maxPendingReads = 32;
+    uint32_t feedbackWidth = 320;  // the feedback pass writes one pixel in FEEDBACK_DIVISOR^2, writes past the
+    uint32_t feedbackHeight = 200; // edge of the buffer are dropped (2560x1600 covered by default)
+};
+
+// Sparse texture streamed from a VirtualTextureFile. The sampling shader looks tiles up through the page table
+// (VirtualTextureBuffer) and writes the tile it wanted to a feedback UAV; each frame update() reads back an older
+// feedback buffer without stalling, reads missing tiles on the ThreadPool and uploads finished ones into a
+// fixed physical atlas under LRU. The coarsest level is pinned, so there is always something to sample.
+// bind() sets the atlas (slot), the page table (slot + 1), VirtualTextureBuffer (b4) and the feedback UAV (u1).
+class VirtualTexture : public TextureBase {
+public:
+    static constexpr uint32_t FEEDBACK_DIVISOR = 8;
+
+    VirtualTexture(ID3D11Device* device, const std::string& sourcePath, const VirtualTextureOptions& options = {});
+    ~VirtualTexture() override;
+
+    void bind(ID3D11DeviceContext* deviceContext, UINT slot) const override;
+
+    // Once per frame before drawing, on the render thread; the owner calls it
+    void update(ID3D11DeviceContext* deviceContext);
+
+    uint32_t getResidentTileCount() const { return m_cache.getResidentCount(); }
+    uint32_t getPendingReadCount() const { return static_cast<uint32_t>(m_pendingReads.size()); }
+
+private:
+    struct PendingRead
+    {
+        uint32_t tile;
+        std::future<std::vector<uint8_t>> data;
+    };
+
+    void createResources(ID3D11Device* device);
+    void readFeedback(ID3D11DeviceContext* deviceContext);
+    void requestTiles(const std::vector<VirtualTextureFeedback::Request>& requests);
+    void uploadTiles(ID3D11DeviceContext* deviceContext);
+    void uploadTile(ID3D11DeviceContext* deviceContext, uint32_t slot, const uint8_t* data);
+    std::vector<uint8_t> readTile(uint32_t tile) const;
+
+    std::string m_sourcePath;
+    VirtualTextureOptions m_options;
+    std::unique_ptr<VirtualTextureFile> m_file;
+    TileCache m_cache;
+    PageTable m_pageTable;
+    uint32_t m_slotsPerRow = 0;
+    uint64_t m_frame = 0;
+
+    std::vector<PendingRead> m_pendingReads;
+    std::unordered_set<uint32_t> m_pendingTiles;
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> m_physicalTexture;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_pageTableBuffer;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_pageTableSrv;
+    Microsoft::WRL::ComPtr<ID3D11Buffer> m_constantBuffer;
+
+    // feedback: written by the shader, copied to a staging ring, read FEEDBACK_LATENCY frames later
+    static constexpr uint32_t FEEDBACK_LATENCY = 3;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> m_feedbackTexture;
+    Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView> m_feedbackUav;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> m_feedbackStaging[FEEDBACK_LATENCY];
+    uint64_t m_feedbackCopies = 0;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "resources/virtual_texture_file.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Physical tile slots with least recently used replacement. A slot used in the current frame is never evicted,
+// so a frame that wants more tiles than fit keeps what it has instead of thrashing; pinned slots never leave.
+class TileCache
+{
+public:
+    static constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+    explicit TileCache(uint32_t slotCount);
+
+    uint32_t getSlotCount() const { return static_cast<uint32_t>(m_slots.size()); }
+    uint32_t getResidentCount() const { return static_cast<uint32_t>(m_lookup.size()); }
+
+    // Slot holding `tile` or INVALID_SLOT
+    uint32_t find(uint32_t tile) const;
+    uint32_t getTile(uint32_t slot) const { return m_slots[slot].tile; }
+
+    // Marks the slot used in `frame`
+    void touch(uint32_t slot, uint64_t frame);
+    void pin(uint32_t slot);
+
+    // A free slot for `tile`, else the least recently used one not used in `frame`; INVALID_SLOT when none.
+    // `evictedTile` receives the tile that was dropped, or VirtualTile::INVALID.
+    uint32_t allocate(uint32_t tile, uint64_t frame, uint32_t &evictedTile);
+
+private:
+    struct Slot
+    {
+        uint32_t tile = VirtualTile::INVALID;
+        uint64_t lastUsed = 0;
+        bool isPinned = false;
+        uint32_t prev = INVALID_SLOT; // LRU list, least recent first; pinned slots are not linked
+        uint32_t next = INVALID_SLOT;
+    };
+
+    void unlink(uint32_t slot);
+    void pushBack(uint32_t slot);
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+    std::unordered_map<uint32_t, uint32_t> m_lookup; // tile -> slot
+    uint32_t m_head = INVALID_SLOT;
+    uint32_t m_tail = INVALID_SLOT;
+};
+
+// Virtual tile -> physical slot table as the shader reads it: every tile of every level has an entry, one that is
+// not resident points at its closest resident ancestor, so sampling falls back to a coarser level instead of
+// missing. Entry x = slot x | slot y << 8 | resident level << 16, y = tile x | tile y << 16 at that level.
+class PageTable
+{
+public:
+    struct Entry
+    {
+        uint32_t slot;
+        uint32_t tile;
+    };
+    static constexpr uint32_t NOT_RESIDENT = 0xff0000; // resident level 255: nothing to sample yet
+
+    explicit PageTable(const std::vector<VirtualTextureFile::Level> &levels);
+
+    void map(uint32_t tile, uint32_t slotX, uint32_t slotY);
+    void unmap(uint32_t tile);
+
+    bool isDirty() const { return m_isDirty; }
+
+    // Entries after fallback, in VirtualTextureFile tile order
+    const std::vector<Entry> &resolve();
+
+private:
+    std::vector<VirtualTextureFile::Level> m_levels;
+    std::vector<uint32_t> m_slots; // own slot per tile (x | y << 8), or UINT32_MAX
+    std::vector<Entry> m_entries;
+    bool m_isDirty = true;
+};
+
+// CPU side of the feedback pass: the shader writes the packed tile it wanted per (downscaled) pixel, cleared
+// to VirtualTile::INVALID. analyze() turns one readback into the tiles to make resident.
+class VirtualTextureFeedback
+{
+public:
+    struct Request
+    {
+        uint32_t tile;
+        uint32_t pixelCount; // 0 for ancestors added only to complete a fallback chain
+    };
+
+    // Unique valid tiles plus all their ancestors (a fine tile only helps once the chain above it is there),
+    // coarse levels first, then by pixel count. `rowPitch` is in bytes.
+    static std::vector<Request> analyze(const uint32_t *feedback, uint32_t width, uint32_t height, size_t rowPitch,
+                                        const std::vector<VirtualTextureFile::Level> &levels);
+};
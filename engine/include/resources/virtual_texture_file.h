@@ -0,0 +1,79 @@
+#pragma once
+
+#include "utils/forward.h"
+#include "utils/mapped_file.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// A tile of the virtual mip pyramid. Packed as level << 24 | y << 12 | x it keys every residency structure and
+// is what the feedback pass writes per pixel.
+struct VirtualTile
+{
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    uint32_t level;
+    uint32_t x;
+    uint32_t y;
+
+    uint32_t pack() const { return level << 24 | y << 12 | x; }
+    static VirtualTile unpack(uint32_t key) { return {key >> 24, key & 0xfff, (key >> 12) & 0xfff}; }
+};
+
+// Page file of a virtual texture: each mip level cut into TILE_SIZE tiles, each stored with a TILE_BORDER texel
+// border (wrapped, like the sampler) so bilinear taps never need the neighbour tile. Tiles are BC1 for opaque
+// images and RGBA8 otherwise, all the same size, so a tile is one multiply away. Levels stop at the first one
+// that fits a single tile. Page files live in cache/vtex/ and carry the source stamp like the other caches.
+class VirtualTextureFile
+{
+public:
+    static constexpr uint32_t TAG = 0x54565844; // "DXVT"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t TILE_SIZE = 128;
+    static constexpr uint32_t TILE_BORDER = 4;
+    static constexpr uint32_t TILE_STRIDE = TILE_SIZE + 2 * TILE_BORDER; // stored texels per tile side
+    static constexpr uint32_t MAX_LEVELS = 16;
+
+    struct Level
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t tilesX;
+        uint32_t tilesY;
+        uint32_t firstTile; // index of tile (0, 0) in the file
+    };
+
+    // Maps an existing page file, throws std::runtime_error when it is not a valid one
+    explicit VirtualTextureFile(const std::string &pagePath);
+
+    // Page file of an image, nullptr when missing or stale: the caller decodes the source and write()s it.
+    // Decoding is left out so the tiling builds without the device headers
+    static std::unique_ptr<VirtualTextureFile> openCached(const std::string &sourcePath);
+    static std::string getCachePath(const std::string &sourcePath);
+
+    // Tiles RGBA8 pixels (tightly packed) into `pagePath`; the stamp of `sourcePath` is recorded when given
+    static void write(const std::string &pagePath, const uint8_t *pixels, uint32_t width, uint32_t height, bool isSrgb,
+                      const std::string &sourcePath = {});
+
+    // Tile pyramid of a width x height image
+    static std::vector<Level> getLevels(uint32_t width, uint32_t height);
+
+    uint32_t getWidth() const { return m_width; }
+    uint32_t getHeight() const { return m_height; }
+    DXGI_FORMAT getFormat() const { return m_format; }
+    const std::vector<Level> &getLevels() const { return m_levels; }
+    uint32_t getTileCount() const;
+    size_t getTileBytes() const;
+    uint32_t getTileRowPitch() const; // bytes per texel row (block row for BC1)
+
+    // TILE_STRIDE x TILE_STRIDE texels in the mapping; reading faults the file in, so do it off the render thread
+    const uint8_t *getTileData(const VirtualTile &tile) const;
+
+private:
+    std::unique_ptr<MappedFile> m_file;
+    uint32_t m_width = 0;
+    uint32_t m_height = 0;
+    DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+    std::vector<Level> m_levels;
+    size_t m_dataOffset = 0;
+};
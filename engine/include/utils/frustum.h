@@ -0,0 +1,31 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+// View frustum as six planes, ax + by + cz + d >= 0 inside, normalized
+struct Frustum
+{
+    enum Plane
+    {
+        Left,
+        Right,
+        Bottom,
+        Top,
+        Near,
+        Far,
+        Count
+    };
+
+    DirectX::XMFLOAT4 planes[Plane::Count];
+
+    // Gribb-Hartmann extraction from a row-vector (DirectXMath) matrix with D3D clip depth [0, w].
+    // The planes live in the space the matrix maps from: world * view * projection gives object space planes.
+    static Frustum fromMatrix(const DirectX::XMMATRIX &matrix);
+
+    bool intersectsSphere(const DirectX::XMFLOAT3 &center, float radius) const;
+
+    // Batch test over structure-of-arrays spheres, four per iteration, writes 1 (visible) or 0 per sphere
+    void intersectsSpheres(const float *centerX, const float *centerY, const float *centerZ, const float *radius, size_t count, uint8_t *visible) const;
+};
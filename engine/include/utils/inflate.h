@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// DEFLATE (RFC 1951) decoder for outputs of known size, as in PNG where the filtered image size follows from the
+// header. Huffman codes decode through a 10-bit lookup table with a 64-bit bit buffer refilled 8 bytes at a time,
+// back references copy 8 bytes at a time when they do not overlap.
+class Inflate
+{
+public:
+    // zlib stream (RFC 1950): header, deflate data, Adler-32 of the output (checked).
+    // Returns the number of bytes written, throws std::runtime_error on corrupt data or when `dst` is too small.
+    static size_t decompressZlib(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstCapacity);
+
+    // Raw deflate data
+    static size_t decompress(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstCapacity);
+
+    static uint32_t adler32(const uint8_t *data, size_t size, uint32_t adler = 1);
+};
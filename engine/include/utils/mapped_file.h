@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &filepath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return static_cast<const char *>(m_data); }
+    const char *end() const { return data() + m_size; }
+    size_t size() const { return m_size; }
+    const std::string &getPath() const { return m_filepath; }
+
+private:
+    void close();
+
+    std::string m_filepath;
+    const void *m_data;
+    size_t m_size;
+
+#ifdef _WIN32
+    void *m_fileHandle;
+    void *m_mappingHandle;
+#else
+    int m_fileDescriptor;
+#endif
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+class StagingPool;
+
+// Move-only block of cache line aligned memory, handed back to its pool when destroyed. Contents are uninitialized.
+class StagingBuffer
+{
+public:
+    StagingBuffer() = default;
+    ~StagingBuffer() { reset(); }
+
+    StagingBuffer(StagingBuffer &&other) noexcept;
+    StagingBuffer &operator=(StagingBuffer &&other) noexcept;
+    StagingBuffer(const StagingBuffer &) = delete;
+    StagingBuffer &operator=(const StagingBuffer &) = delete;
+
+    uint8_t *data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_data == nullptr; }
+
+    void reset();
+
+private:
+    friend class StagingPool;
+    StagingBuffer(StagingPool *pool, uint8_t *data, size_t size, size_t capacity)
+        : m_pool(pool), m_data(data), m_size(size), m_capacity(capacity) {}
+
+    StagingPool *m_pool = nullptr;
+    uint8_t *m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_capacity = 0;
+};
+
+// Recycles large scratch allocations (decoded images, inflate output) so loading many textures does not
+// keep going back to the heap. Released blocks are kept up to a byte budget and reused best fit. Thread safe.
+class StagingPool
+{
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    explicit StagingPool(size_t retainedBudget = 256ull << 20);
+    ~StagingPool();
+
+    StagingPool(const StagingPool &) = delete;
+    StagingPool &operator=(const StagingPool &) = delete;
+
+    static StagingPool &getInstance();
+
+    StagingBuffer acquire(size_t size);
+
+    size_t getRetainedBytes() const;
+    void trim(); // frees every retained block
+
+private:
+    friend class StagingBuffer;
+    void release(uint8_t *data, size_t capacity);
+
+    mutable std::mutex m_mutex;
+    std::multimap<size_t, uint8_t *> m_freeBlocks; // capacity -> block
+    size_t m_retainedBytes = 0;
+    size_t m_retainedBudget;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(uint32_t threadCount = 0); // 0 => hardware concurrency - 1
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    static ThreadPool &getInstance();
+
+    uint32_t getThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+    template <typename F>
+    auto submit(F &&task) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using ReturnType = std::invoke_result_t<std::decay_t<F>>;
+        auto packagedTask = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<F>(task));
+        std::future<ReturnType> future = packagedTask->get_future();
+        enqueue([packagedTask]()
+                { (*packagedTask)(); });
+        return future;
+    }
+
+    // Splits [0, count) into ranges of at least grainSize and runs fn(begin, end) on them.
+    // The calling thread takes part, so nested calls from a worker cannot deadlock.
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)> &fn);
+
+private:
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_isStopping;
+};
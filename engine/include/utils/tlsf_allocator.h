@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Two-level segregated fit allocator over an abstract range [0, capacity) of units (bytes, vertices, indices).
+// Allocate and free are O(1) with good-fit placement. It only hands out offsets, the memory lives elsewhere
+// (a GPU buffer), so it has no device dependency.
+class TlsfAllocator
+{
+public:
+    static constexpr uint32_t INVALID_HANDLE = UINT32_MAX;
+
+    struct Stats
+    {
+        uint32_t capacity = 0;
+        uint32_t usedSize = 0;
+        uint32_t freeSize = 0;
+        uint32_t largestFreeBlock = 0;
+        uint32_t allocationCount = 0;
+        uint32_t freeBlockCount = 0;
+        float fragmentation = 0.f; // 1 - largest free block / free size, 0 when the free space is contiguous
+    };
+
+    // One allocation slid towards offset 0 by compact
+    struct Move
+    {
+        uint32_t handle;
+        uint32_t from;
+        uint32_t to;
+        uint32_t size;
+    };
+
+    explicit TlsfAllocator(uint32_t capacity);
+
+    // Returns INVALID_HANDLE when no free block is large enough. Zero sized requests take one unit.
+    uint32_t allocate(uint32_t size);
+    void free(uint32_t handle);
+
+    uint32_t getOffset(uint32_t handle) const { return m_blocks[handle].offset; }
+    uint32_t getSize(uint32_t handle) const { return m_blocks[handle].size; }
+    uint32_t getCapacity() const { return m_capacity; }
+    Stats getStats() const;
+
+    // Packs every allocation towards offset 0 in offset order, handles stay valid. Moves come in offset order
+    // with to <= from, so copying them in order never overwrites data that is yet to move.
+    std::vector<Move> compact();
+
+private:
+    static constexpr uint32_t SL_BITS = 4;
+    static constexpr uint32_t SL_COUNT = 1 << SL_BITS; // second level subdivisions per power of two
+    static constexpr uint32_t FL_COUNT = 32 - SL_BITS + 1;
+
+    struct Block
+    {
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        uint32_t prevPhysical = INVALID_HANDLE;
+        uint32_t nextPhysical = INVALID_HANDLE;
+        uint32_t prevFree = INVALID_HANDLE;
+        uint32_t nextFree = INVALID_HANDLE;
+        bool isFree = false;
+        bool isUsed = false; // slot holds a live block
+    };
+
+    static void mapping(uint32_t size, uint32_t &fl, uint32_t &sl);
+
+    uint32_t createBlock(uint32_t offset, uint32_t size);
+    void releaseBlock(uint32_t index);
+    void insertFree(uint32_t index);
+    void removeFree(uint32_t index);
+    uint32_t findFree(uint32_t size) const;
+    void mergeWithNext(uint32_t index); // index absorbs its next physical block
+
+    uint32_t m_capacity;
+    uint32_t m_firstBlock;
+    uint32_t m_flBitmap;
+    uint32_t m_slBitmaps[FL_COUNT];
+    uint32_t m_freeHeads[FL_COUNT][SL_COUNT];
+    std::vector<Block> m_blocks;
+    std::vector<uint32_t> m_unusedBlocks;
+};
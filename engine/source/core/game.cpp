@@ -59,6 +59,7 @@ void Game::onCreate()
 void Game::onDestroy()
 {
     m_isRunning = false;
+    m_gameResourceManager->logLazyAssetReport();
     m_graphicsEngine->onDestroy();
 }
 
@@ -142,7 +143,14 @@ void Game::onGraphicsUpdate(float deltaTime)
 {
     m_graphicsEngine->beginRender();
     m_activeCamera->onGraphicsUpdate(m_graphicsEngine->getDeviceManager()->getDeviceContext());
-    m_gameResourceManager->onGraphicsUpdate(m_graphicsEngine->getDeviceManager());
+    m_gameResourceManager->onGraphicsUpdate(m_graphicsEngine->getDeviceManager(), m_activeCamera.get(), static_cast<float>(m_window->getHeight()));
+    m_graphicsEngine->endRender();
+}
+
+void Game::presentLoadingFrame()
+{
+    m_window->onProcessEvents();
+    m_graphicsEngine->beginRender();
     m_graphicsEngine->endRender();
 }
 
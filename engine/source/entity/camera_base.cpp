@@ -4,7 +4,7 @@
 #include <algorithm>
 
 CameraBase::CameraBase(ID3D11Device *device, EntityBase *targetEntity)
-    : m_targetEntity(targetEntity), m_fov(DirectX::XM_PIDIV4), // 45 degrees in radians
+    : m_targetEntity(targetEntity), m_fov(DEFAULT_FOV),
       m_aspectRatio(16.0f / 9.0f), m_nearClip(0.1f), m_position(0.0f, 0.0f, 0.0f), m_farClip(10000.0f), m_yaw(0.0f), m_pitch(0.0f)
 {
     updateVectorsFromEulerAngles();
@@ -17,6 +17,7 @@ CameraBase::CameraBase(ID3D11Device *device, EntityBase *targetEntity)
 void CameraBase::getPosition(DirectX::XMFLOAT3 &position) { position = m_position; }
 void CameraBase::getViewMatrix(DirectX::XMMATRIX &view) { view = m_viewMatrix; }
 void CameraBase::getProjectionMatrix(DirectX::XMMATRIX &projection) { projection = m_projectionMatrix; }
+void CameraBase::getFrustum(Frustum &frustum) { frustum = Frustum::fromMatrix(m_viewMatrix * m_projectionMatrix); }
 DirectX::XMFLOAT3 CameraBase::getFrontVector() { return m_front; }
 
 void CameraBase::setFOV(float fov)
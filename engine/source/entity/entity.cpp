@@ -1,5 +1,7 @@
 #include "entity/entity.h"
 #include "resources/buffer_type.h"
+#include <algorithm>
+#include <cstring>
 
 std::atomic<uint32_t> EntityBase::s_nextId = 0;
 
@@ -8,7 +10,8 @@ EntityBase::EntityBase(ID3D11Device *device)
       m_localPosition({0.0f, 0.0f, 0.0f}),
       m_localEulerAngles({0.0f, 0.0f, 0.0f}),
       m_localScale({1.0f, 1.0f, 1.0f}),
-      m_parent(nullptr)
+      m_parent(nullptr),
+      m_isStatic(false)
 {
     updateWorldMatrix();
     updateDirectionVectors();
@@ -70,6 +73,58 @@ DirectX::XMFLOAT3 EntityBase::getWorldScale() const
 DirectX::XMMATRIX EntityBase::getWorldMatrix() const { return m_worldMatrix; }
 std::vector<std::shared_ptr<RenderComponent>> EntityBase::getRenderComponents() const { return m_renderComponents; }
 
+bool EntityBase::getWorldBoundingSphere(DirectX::XMFLOAT3 &center, float &radius) const
+{
+    // the largest axis scale keeps the sphere conservative under non-uniform scaling
+    float scale = std::max({DirectX::XMVectorGetX(DirectX::XMVector3Length(m_worldMatrix.r[0])),
+                            DirectX::XMVectorGetX(DirectX::XMVector3Length(m_worldMatrix.r[1])),
+                            DirectX::XMVectorGetX(DirectX::XMVector3Length(m_worldMatrix.r[2]))});
+
+    bool hasBounds = false;
+    DirectX::XMVECTOR sphereCenter = DirectX::XMVectorZero();
+    float sphereRadius = 0.f;
+    for (const auto &comp : m_renderComponents)
+    {
+        const std::shared_ptr<Mesh> &mesh = comp->getMesh();
+        if (!mesh)
+        {
+            continue;
+        }
+
+        const MeshBounds &bounds = mesh->getBounds();
+        DirectX::XMVECTOR compCenter = DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&bounds.sphereCenter), m_worldMatrix);
+        float compRadius = bounds.sphereRadius * scale;
+        if (!hasBounds)
+        {
+            sphereCenter = compCenter;
+            sphereRadius = compRadius;
+            hasBounds = true;
+            continue;
+        }
+
+        // smallest sphere holding both
+        DirectX::XMVECTOR offset = DirectX::XMVectorSubtract(compCenter, sphereCenter);
+        float distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(offset));
+        if (distance + compRadius <= sphereRadius)
+        {
+            continue;
+        }
+        if (distance + sphereRadius <= compRadius)
+        {
+            sphereCenter = compCenter;
+            sphereRadius = compRadius;
+            continue;
+        }
+        float mergedRadius = 0.5f * (distance + sphereRadius + compRadius);
+        sphereCenter = DirectX::XMVectorAdd(sphereCenter, DirectX::XMVectorScale(offset, (mergedRadius - sphereRadius) / distance));
+        sphereRadius = mergedRadius;
+    }
+
+    DirectX::XMStoreFloat3(&center, sphereCenter);
+    radius = sphereRadius;
+    return hasBounds;
+}
+
 void EntityBase::setParent(std::shared_ptr<EntityBase> parent) { m_parent = parent; }
 void EntityBase::addChild(std::shared_ptr<EntityBase> child) { m_children.push_back(child); }
 void EntityBase::setLocalPosition(const DirectX::XMFLOAT3 &position) { m_localPosition = position; }
@@ -160,6 +215,7 @@ void EntityBase::initModelBuffer(ID3D11Device *device)
 
     ModelBuffer modelBuffer = {};
     modelBuffer.world = XMMatrixTranspose(m_worldMatrix);
+    DirectX::XMStoreFloat4x4(&m_uploadedWorldMatrix, m_worldMatrix);
 
     D3D11_SUBRESOURCE_DATA initData;
     initData.pSysMem = &modelBuffer;
@@ -175,9 +231,15 @@ void EntityBase::initModelBuffer(ID3D11Device *device)
 
 void EntityBase::bindModelBuffer(ID3D11DeviceContext *deviceContext)
 {
-    ModelBuffer modelBuffer;
-    modelBuffer.world = DirectX::XMMatrixTranspose(m_worldMatrix);
-
-    deviceContext->UpdateSubresource(m_modelBuffer.Get(), 0, nullptr, &modelBuffer, 0, 0);
+    // entities that did not move (static ones, bodies at rest) keep last frame's buffer
+    DirectX::XMFLOAT4X4 worldMatrix;
+    DirectX::XMStoreFloat4x4(&worldMatrix, m_worldMatrix);
+    if (std::memcmp(&worldMatrix, &m_uploadedWorldMatrix, sizeof(worldMatrix)) != 0)
+    {
+        ModelBuffer modelBuffer;
+        modelBuffer.world = DirectX::XMMatrixTranspose(m_worldMatrix);
+        deviceContext->UpdateSubresource(m_modelBuffer.Get(), 0, nullptr, &modelBuffer, 0, 0);
+        m_uploadedWorldMatrix = worldMatrix;
+    }
     deviceContext->VSSetConstantBuffers(0, 1, m_modelBuffer.GetAddressOf()); // slot 0
 }
@@ -0,0 +1,23 @@
+#include "resources/asset_cache.h"
+#include "utils/mapped_file.h"
+#include "utils/hash.h"
+#include <algorithm>
+#include <cctype>
+
+std::string normalizeAssetPath(const std::filesystem::path &path)
+{
+    std::error_code ec;
+    std::filesystem::path absolutePath = std::filesystem::absolute(path, ec);
+    std::string normalized = (ec ? path : absolutePath).lexically_normal().generic_string();
+#ifdef _WIN32
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+#endif
+    return normalized;
+}
+
+uint64_t hashAssetFile(const std::filesystem::path &path, uint64_t seed)
+{
+    MappedFile file(path.string());
+    return hashBytes(file.data(), file.size(), seed);
+}
@@ -0,0 +1,108 @@
+#include "resources/asset_loader.h"
+#include <thread>
+
+AssetLoader::AssetLoader(ID3D11Device *device, uint32_t threadCount)
+    : m_device(device)
+{
+    if (threadCount > 0)
+    {
+        m_ownThreadPool = std::make_unique<ThreadPool>(threadCount);
+    }
+    m_threadPool = m_ownThreadPool ? m_ownThreadPool.get() : &ThreadPool::getInstance();
+}
+
+AssetLoader::~AssetLoader()
+{
+    // the prepare steps write into this loader's stats
+    for (PendingLoad &load : m_pending)
+    {
+        load.prepareDone.wait();
+    }
+}
+
+void AssetLoader::submit(PendingLoad load)
+{
+    if (m_pending.empty())
+    {
+        m_batchStart = std::chrono::high_resolution_clock::now();
+    }
+    m_pending.push_back(std::move(load));
+}
+
+uint32_t AssetLoader::update()
+{
+    uint32_t created = 0;
+    auto startTime = std::chrono::high_resolution_clock::now();
+    // in submission order: a prepared load waits for the ones ahead of it
+    while (!m_pending.empty() && m_pending.front().prepareDone.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        // out of the queue first, a create step may submit further loads
+        PendingLoad load = std::move(m_pending.front());
+        m_pending.pop_front();
+
+        std::exception_ptr error;
+        try
+        {
+            load.prepareDone.get();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        bool isCreated = load.create(m_device, error);
+        m_completed += isCreated ? 1 : 0;
+        m_failed += isCreated ? 0 : 1;
+        ++created;
+    }
+
+    if (created > 0)
+    {
+        auto endTime = std::chrono::high_resolution_clock::now();
+        m_createMs += std::chrono::duration<float, std::milli>(endTime - startTime).count();
+        if (m_pending.empty())
+        {
+            m_wallMs = std::chrono::duration<float, std::milli>(endTime - m_batchStart).count();
+        }
+    }
+    return created;
+}
+
+void AssetLoader::wait(const std::function<void()> &onWait)
+{
+    while (true)
+    {
+        update();
+        if (m_pending.empty())
+        {
+            return;
+        }
+        if (onWait)
+        {
+            onWait();
+        }
+        else
+        {
+            m_pending.front().prepareDone.wait_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+AssetLoader::Stats AssetLoader::getStats() const
+{
+    Stats stats;
+    stats.threadCount = m_threadPool->getThreadCount();
+    stats.pending = static_cast<uint32_t>(m_pending.size());
+    stats.completed = m_completed;
+    stats.failed = m_failed;
+    stats.prepareMs = m_prepareMicroseconds.load() / 1000.f;
+    stats.createMs = m_createMs;
+    stats.wallMs = m_wallMs;
+    return stats;
+}
+
+void AssetLoader::logStats() const
+{
+    Stats stats = getStats();
+    Logger::Log(Logger::LogLevel::INFO, "AssetLoader::logStats: {} loaded, {} failed, {} pending on {} threads; {:.2f} ms wall, prepare {:.2f} ms (workers), create {:.2f} ms",
+                stats.completed, stats.failed, stats.pending, stats.threadCount, stats.wallMs, stats.prepareMs, stats.createMs);
+}
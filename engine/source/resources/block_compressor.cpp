@@ -0,0 +1,632 @@
+#include "resources/block_compressor.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    constexpr int REFINE_ITERATIONS = 2;
+    constexpr int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+    constexpr float BC1_WEIGHTS[4] = {0.f, 1.f, 1.f / 3.f, 2.f / 3.f}; // share of endpoint 1 per index
+
+    template <int C>
+    struct Points
+    {
+        float values[16][C];
+
+        bool isSolid() const
+        {
+            for (int i = 1; i < 16; ++i)
+            {
+                if (std::memcmp(values[i], values[0], sizeof(values[0])) != 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    // Mean and principal axis (power iteration on the covariance), axis is zero for a solid block
+    template <int C>
+    void getPrincipalAxis(const Points<C> &points, float mean[C], float axis[C])
+    {
+        for (int c = 0; c < C; ++c)
+        {
+            mean[c] = 0.f;
+            for (int i = 0; i < 16; ++i)
+            {
+                mean[c] += points.values[i][c];
+            }
+            mean[c] /= 16.f;
+        }
+
+        float covariance[C][C] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int a = 0; a < C; ++a)
+            {
+                for (int b = a; b < C; ++b)
+                {
+                    covariance[a][b] += (points.values[i][a] - mean[a]) * (points.values[i][b] - mean[b]);
+                }
+            }
+        }
+        int largest = 0;
+        for (int a = 0; a < C; ++a)
+        {
+            for (int b = 0; b < a; ++b)
+            {
+                covariance[a][b] = covariance[b][a];
+            }
+            largest = covariance[a][a] > covariance[largest][largest] ? a : largest;
+        }
+
+        for (int c = 0; c < C; ++c)
+        {
+            axis[c] = covariance[largest][c];
+        }
+        for (int iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[C] = {}, length = 0.f;
+            for (int a = 0; a < C; ++a)
+            {
+                for (int b = 0; b < C; ++b)
+                {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length += next[a] * next[a];
+            }
+            length = std::sqrt(length);
+            for (int c = 0; c < C; ++c)
+            {
+                axis[c] = length > 1e-12f ? next[c] / length : 0.f;
+            }
+        }
+    }
+
+    // Endpoints at the extreme projections on the axis
+    template <int C>
+    void getAxisEndpoints(const Points<C> &points, float e0[C], float e1[C])
+    {
+        float mean[C], axis[C];
+        getPrincipalAxis(points, mean, axis);
+        float tMin = FLT_MAX, tMax = -FLT_MAX;
+        for (int i = 0; i < 16; ++i)
+        {
+            float t = 0.f;
+            for (int c = 0; c < C; ++c)
+            {
+                t += (points.values[i][c] - mean[c]) * axis[c];
+            }
+            tMin = std::min(tMin, t);
+            tMax = std::max(tMax, t);
+        }
+        for (int c = 0; c < C; ++c)
+        {
+            e0[c] = std::clamp(mean[c] + axis[c] * tMin, 0.f, 255.f);
+            e1[c] = std::clamp(mean[c] + axis[c] * tMax, 0.f, 255.f);
+        }
+    }
+
+    // Least squares endpoints for fixed interpolation weights (share of e1), false when the weights are all equal
+    template <int C>
+    bool solveEndpoints(const Points<C> &points, const float weights[16], float e0[C], float e1[C])
+    {
+        float aa = 0.f, ab = 0.f, bb = 0.f, ax[C] = {}, bx[C] = {};
+        for (int i = 0; i < 16; ++i)
+        {
+            float b = weights[i], a = 1.f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < C; ++c)
+            {
+                ax[c] += a * points.values[i][c];
+                bx[c] += b * points.values[i][c];
+            }
+        }
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+        float inverse = 1.f / determinant;
+        for (int c = 0; c < C; ++c)
+        {
+            e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) * inverse, 0.f, 255.f);
+            e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) * inverse, 0.f, 255.f);
+        }
+        return true;
+    }
+
+    // Nearest palette entry per texel, returns the summed squared error
+    template <int C, int N>
+    float selectIndices(const Points<C> &points, const int palette[N][C], uint8_t indices[16])
+    {
+        float total = 0.f;
+        for (int i = 0; i < 16; ++i)
+        {
+            float best = FLT_MAX;
+            for (int p = 0; p < N; ++p)
+            {
+                float error = 0.f;
+                for (int c = 0; c < C; ++c)
+                {
+                    float d = points.values[i][c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < best)
+                {
+                    best = error;
+                    indices[i] = static_cast<uint8_t>(p);
+                }
+            }
+            total += best;
+        }
+        return total;
+    }
+
+    struct BitWriter
+    {
+        uint8_t *bytes;
+        uint32_t position = 0;
+
+        void write(uint32_t value, uint32_t count)
+        {
+            for (uint32_t i = 0; i < count; ++i, ++position)
+            {
+                bytes[position >> 3] |= static_cast<uint8_t>(((value >> i) & 1u) << (position & 7));
+            }
+        }
+    };
+
+    struct BitReader
+    {
+        const uint8_t *bytes;
+        uint32_t position = 0;
+
+        uint32_t read(uint32_t count)
+        {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < count; ++i, ++position)
+            {
+                value |= ((bytes[position >> 3] >> (position & 7)) & 1u) << i;
+            }
+            return value;
+        }
+    };
+
+    // ---- BC1 color ----
+
+    uint16_t packRgb565(const float color[3])
+    {
+        uint32_t r = static_cast<uint32_t>(color[0] * 31.f / 255.f + 0.5f);
+        uint32_t g = static_cast<uint32_t>(color[1] * 63.f / 255.f + 0.5f);
+        uint32_t b = static_cast<uint32_t>(color[2] * 31.f / 255.f + 0.5f);
+        return static_cast<uint16_t>((std::min(r, 31u) << 11) | (std::min(g, 63u) << 5) | std::min(b, 31u));
+    }
+
+    void unpackRgb565(uint16_t packed, int color[3])
+    {
+        int r = packed >> 11, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    void getColorPalette(uint16_t c0, uint16_t c1, bool isFourColor, int palette[4][3])
+    {
+        unpackRgb565(c0, palette[0]);
+        unpackRgb565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            if (isFourColor)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+    }
+
+    // Always four-color mode: c0 > c1, or c0 == c1 with every index 0 (same color in either mode)
+    void encodeColorBlock(const uint8_t rgba[64], uint8_t block[8])
+    {
+        Points<3> points;
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                points.values[i][c] = rgba[i * 4 + c];
+            }
+        }
+
+        float e0[3], e1[3];
+        getAxisEndpoints(points, e0, e1);
+
+        uint16_t bestC0 = 0, bestC1 = 0;
+        uint8_t bestIndices[16] = {};
+        float bestError = FLT_MAX;
+        for (int iteration = 0; iteration <= REFINE_ITERATIONS; ++iteration)
+        {
+            uint16_t c0 = packRgb565(e1), c1 = packRgb565(e0); // brighter end first, it usually packs higher
+            if (c0 < c1)
+            {
+                std::swap(c0, c1);
+            }
+
+            int palette[4][3];
+            getColorPalette(c0, c1, true, palette);
+            uint8_t indices[16];
+            float error = c0 == c1 ? selectIndices<3, 1>(points, palette, indices) : selectIndices<3, 4>(points, palette, indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                bestC0 = c0;
+                bestC1 = c1;
+                std::memcpy(bestIndices, indices, sizeof(indices));
+            }
+            if (error == 0.f || c0 == c1)
+            {
+                break;
+            }
+
+            // solve in palette order: endpoint 0 is c0
+            float weights[16];
+            for (int i = 0; i < 16; ++i)
+            {
+                weights[i] = BC1_WEIGHTS[indices[i]];
+            }
+            if (!solveEndpoints(points, weights, e1, e0))
+            {
+                break;
+            }
+        }
+
+        std::memset(block, 0, 8);
+        block[0] = static_cast<uint8_t>(bestC0);
+        block[1] = static_cast<uint8_t>(bestC0 >> 8);
+        block[2] = static_cast<uint8_t>(bestC1);
+        block[3] = static_cast<uint8_t>(bestC1 >> 8);
+        for (int i = 0; i < 16; ++i)
+        {
+            block[4 + i / 4] |= static_cast<uint8_t>(bestIndices[i] << ((i % 4) * 2));
+        }
+    }
+
+    void decodeColorBlock(const uint8_t block[8], bool allowThreeColor, uint8_t rgba[64])
+    {
+        uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+        uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+        int palette[4][3];
+        getColorPalette(c0, c1, !allowThreeColor || c0 > c1, palette);
+        for (int i = 0; i < 16; ++i)
+        {
+            int index = (block[4 + i / 4] >> ((i % 4) * 2)) & 3;
+            for (int c = 0; c < 3; ++c)
+            {
+                rgba[i * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+            }
+            rgba[i * 4 + 3] = allowThreeColor && c0 <= c1 && index == 3 ? 0 : 255;
+        }
+    }
+
+    // ---- BC3 alpha ----
+
+    void getAlphaPalette(int a0, int a1, int palette[8])
+    {
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1)
+        {
+            for (int i = 1; i < 7; ++i)
+            {
+                palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+            }
+        }
+        else
+        {
+            for (int i = 1; i < 5; ++i)
+            {
+                palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    void encodeAlphaBlock(const uint8_t rgba[64], uint8_t block[8])
+    {
+        int a0 = 0, a1 = 255;
+        for (int i = 0; i < 16; ++i)
+        {
+            a0 = std::max(a0, static_cast<int>(rgba[i * 4 + 3]));
+            a1 = std::min(a1, static_cast<int>(rgba[i * 4 + 3]));
+        }
+
+        std::memset(block, 0, 8);
+        block[0] = static_cast<uint8_t>(a0);
+        block[1] = static_cast<uint8_t>(a1);
+        if (a0 == a1)
+        {
+            return; // every index 0
+        }
+
+        int palette[8];
+        getAlphaPalette(a0, a1, palette);
+        BitWriter writer{block + 2};
+        for (int i = 0; i < 16; ++i)
+        {
+            int alpha = rgba[i * 4 + 3], best = 0;
+            for (int p = 1; p < 8; ++p)
+            {
+                best = std::abs(palette[p] - alpha) < std::abs(palette[best] - alpha) ? p : best;
+            }
+            writer.write(static_cast<uint32_t>(best), 3);
+        }
+    }
+
+    void decodeAlphaBlock(const uint8_t block[8], uint8_t rgba[64])
+    {
+        int palette[8];
+        getAlphaPalette(block[0], block[1], palette);
+        BitReader reader{block + 2};
+        for (int i = 0; i < 16; ++i)
+        {
+            rgba[i * 4 + 3] = static_cast<uint8_t>(palette[reader.read(3)]);
+        }
+    }
+
+    // ---- BC7 mode 6 ----
+
+    void getMode6Palette(const int v0[4], const int v1[4], int palette[16][4])
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                palette[i][c] = ((64 - BC7_WEIGHTS[i]) * v0[c] + BC7_WEIGHTS[i] * v1[c] + 32) >> 6;
+            }
+        }
+    }
+
+    void encodeMode6Block(const uint8_t rgba[64], uint8_t block[16])
+    {
+        Points<4> points;
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                points.values[i][c] = rgba[i * 4 + c];
+            }
+        }
+
+        float e0[4], e1[4];
+        getAxisEndpoints(points, e0, e1);
+
+        int bestQ0[4] = {}, bestQ1[4] = {}, bestP0 = 0, bestP1 = 0;
+        uint8_t bestIndices[16] = {};
+        float bestError = FLT_MAX;
+        for (int iteration = 0; iteration <= REFINE_ITERATIONS; ++iteration)
+        {
+            uint8_t indices[16];
+            float iterationError = FLT_MAX;
+            for (int pbits = 0; pbits < 4; ++pbits)
+            {
+                // 7-bit endpoints, the p-bit is the shared lsb of all four channels
+                int p0 = pbits & 1, p1 = pbits >> 1;
+                int q0[4], q1[4], v0[4], v1[4];
+                for (int c = 0; c < 4; ++c)
+                {
+                    q0[c] = std::clamp(static_cast<int>(std::lround((e0[c] - p0) * 0.5f)), 0, 127);
+                    q1[c] = std::clamp(static_cast<int>(std::lround((e1[c] - p1) * 0.5f)), 0, 127);
+                    v0[c] = (q0[c] << 1) | p0;
+                    v1[c] = (q1[c] << 1) | p1;
+                }
+
+                int palette[16][4];
+                getMode6Palette(v0, v1, palette);
+                uint8_t candidate[16];
+                float error = selectIndices<4, 16>(points, palette, candidate);
+                if (error < iterationError)
+                {
+                    iterationError = error;
+                    std::memcpy(indices, candidate, sizeof(candidate));
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    std::memcpy(bestQ0, q0, sizeof(q0));
+                    std::memcpy(bestQ1, q1, sizeof(q1));
+                    bestP0 = p0;
+                    bestP1 = p1;
+                    std::memcpy(bestIndices, candidate, sizeof(candidate));
+                }
+            }
+            if (bestError == 0.f)
+            {
+                break;
+            }
+
+            float weights[16];
+            for (int i = 0; i < 16; ++i)
+            {
+                weights[i] = BC7_WEIGHTS[indices[i]] / 64.f;
+            }
+            if (!solveEndpoints(points, weights, e0, e1))
+            {
+                break;
+            }
+        }
+
+        // the first index drops its msb, so it must be below 8
+        if (bestIndices[0] & 8)
+        {
+            std::swap(bestQ0, bestQ1);
+            std::swap(bestP0, bestP1);
+            for (uint8_t &index : bestIndices)
+            {
+                index = static_cast<uint8_t>(15 - index);
+            }
+        }
+
+        std::memset(block, 0, 16);
+        BitWriter writer{block};
+        writer.write(1u << 6, 7); // mode 6
+        for (int c = 0; c < 4; ++c)
+        {
+            writer.write(static_cast<uint32_t>(bestQ0[c]), 7);
+            writer.write(static_cast<uint32_t>(bestQ1[c]), 7);
+        }
+        writer.write(static_cast<uint32_t>(bestP0), 1);
+        writer.write(static_cast<uint32_t>(bestP1), 1);
+        for (int i = 0; i < 16; ++i)
+        {
+            writer.write(bestIndices[i], i == 0 ? 3 : 4);
+        }
+    }
+
+    void decodeMode6Block(const uint8_t block[16], uint8_t rgba[64])
+    {
+        BitReader reader{block};
+        if (reader.read(7) != (1u << 6))
+        {
+            std::memset(rgba, 0, 64); // other modes are never written
+            return;
+        }
+        int q0[4], q1[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            q0[c] = static_cast<int>(reader.read(7));
+            q1[c] = static_cast<int>(reader.read(7));
+        }
+        int p0 = static_cast<int>(reader.read(1)), p1 = static_cast<int>(reader.read(1));
+        int v0[4], v1[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            v0[c] = (q0[c] << 1) | p0;
+            v1[c] = (q1[c] << 1) | p1;
+        }
+        int palette[16][4];
+        getMode6Palette(v0, v1, palette);
+        for (int i = 0; i < 16; ++i)
+        {
+            uint32_t index = reader.read(i == 0 ? 3 : 4);
+            for (int c = 0; c < 4; ++c)
+            {
+                rgba[i * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+            }
+        }
+    }
+}
+
+size_t BlockCompressor::getCompressedSize(BlockFormat format, uint32_t width, uint32_t height)
+{
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * getBlockBytes(format);
+}
+
+void BlockCompressor::encodeBlock(BlockFormat format, const uint8_t rgba[64], uint8_t *block)
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        encodeColorBlock(rgba, block);
+        break;
+    case BlockFormat::BC3:
+        encodeAlphaBlock(rgba, block);
+        encodeColorBlock(rgba, block + 8);
+        break;
+    case BlockFormat::BC7:
+        encodeMode6Block(rgba, block);
+        break;
+    }
+}
+
+void BlockCompressor::decodeBlock(BlockFormat format, const uint8_t *block, uint8_t rgba[64])
+{
+    switch (format)
+    {
+    case BlockFormat::BC1:
+        decodeColorBlock(block, true, rgba);
+        break;
+    case BlockFormat::BC3:
+        decodeColorBlock(block + 8, false, rgba);
+        decodeAlphaBlock(block, rgba);
+        break;
+    case BlockFormat::BC7:
+        decodeMode6Block(block, rgba);
+        break;
+    }
+}
+
+std::vector<uint8_t> BlockCompressor::compress(BlockFormat format, const uint8_t *pixels, uint32_t width, uint32_t height)
+{
+    uint32_t blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+    size_t blockBytes = getBlockBytes(format);
+    std::vector<uint8_t> blocks(getCompressedSize(format, width, height));
+
+    ThreadPool::getInstance().parallelFor(blocksHigh, 1, [&](size_t begin, size_t end)
+                                          {
+        uint8_t rgba[64];
+        for (size_t by = begin; by < end; ++by)
+        {
+            for (uint32_t bx = 0; bx < blocksWide; ++bx)
+            {
+                for (uint32_t i = 0; i < 16; ++i)
+                {
+                    uint32_t x = std::min(bx * 4 + i % 4, width - 1), y = std::min(static_cast<uint32_t>(by) * 4 + i / 4, height - 1);
+                    std::memcpy(rgba + i * 4, pixels + (static_cast<size_t>(y) * width + x) * 4, 4);
+                }
+                encodeBlock(format, rgba, blocks.data() + (by * blocksWide + bx) * blockBytes);
+            }
+        } });
+    return blocks;
+}
+
+std::vector<uint8_t> BlockCompressor::decompress(BlockFormat format, const uint8_t *blocks, uint32_t width, uint32_t height)
+{
+    uint32_t blocksWide = (width + 3) / 4, blocksHigh = (height + 3) / 4;
+    size_t blockBytes = getBlockBytes(format);
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    for (uint32_t by = 0; by < blocksHigh; ++by)
+    {
+        for (uint32_t bx = 0; bx < blocksWide; ++bx)
+        {
+            uint8_t rgba[64];
+            decodeBlock(format, blocks + (static_cast<size_t>(by) * blocksWide + bx) * blockBytes, rgba);
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                uint32_t x = bx * 4 + i % 4, y = by * 4 + i / 4;
+                if (x < width && y < height)
+                {
+                    std::memcpy(pixels.data() + (static_cast<size_t>(y) * width + x) * 4, rgba + i * 4, 4);
+                }
+            }
+        }
+    }
+    return pixels;
+}
+
+double BlockCompressor::computePsnr(const uint8_t *reference, const uint8_t *pixels, size_t texelCount, bool includeAlpha)
+{
+    int channels = includeAlpha ? 4 : 3;
+    double squaredError = 0.0;
+    for (size_t i = 0; i < texelCount; ++i)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            double d = static_cast<double>(reference[i * 4 + c]) - pixels[i * 4 + c];
+            squaredError += d * d;
+        }
+    }
+    double mse = squaredError / (static_cast<double>(texelCount) * channels);
+    return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : std::numeric_limits<double>::infinity();
+}
@@ -0,0 +1,180 @@
+#include "resources/cubemap_converter.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr size_t ROW_GRAIN = 4;
+
+    // Direction through face coordinates (u, v) in [-1, 1], v down, as D3D lays out cube faces
+    XMVECTOR getFaceDirection(uint32_t face, float u, float v)
+    {
+        switch (face)
+        {
+        case 0:
+            return XMVectorSet(1.f, -v, -u, 0.f);
+        case 1:
+            return XMVectorSet(-1.f, -v, u, 0.f);
+        case 2:
+            return XMVectorSet(u, 1.f, v, 0.f);
+        case 3:
+            return XMVectorSet(u, -1.f, -v, 0.f);
+        case 4:
+            return XMVectorSet(u, -v, 1.f, 0.f);
+        default:
+            return XMVectorSet(-u, -v, -1.f, 0.f);
+        }
+    }
+
+    // The panorama, decoded once; bilinear taps wrap in longitude and clamp in latitude
+    struct Panorama
+    {
+        std::vector<XMFLOAT4> texels;
+        uint32_t width;
+        uint32_t height;
+
+        XMVECTOR sample(float x, float y) const
+        {
+            x -= 0.5f;
+            y = std::clamp(y - 0.5f, 0.f, static_cast<float>(height - 1));
+            float x0 = std::floor(x), y0 = std::floor(y);
+            float fx = x - x0, fy = y - y0;
+            uint32_t left = static_cast<uint32_t>((static_cast<int64_t>(x0) % width + width) % width);
+            uint32_t right = left + 1 == width ? 0 : left + 1;
+            uint32_t top = static_cast<uint32_t>(y0);
+            uint32_t bottom = std::min(top + 1, height - 1);
+
+            const XMFLOAT4 *topRow = texels.data() + static_cast<size_t>(top) * width;
+            const XMFLOAT4 *bottomRow = texels.data() + static_cast<size_t>(bottom) * width;
+            XMVECTOR upper = XMVectorLerp(XMLoadFloat4(&topRow[left]), XMLoadFloat4(&topRow[right]), fx);
+            XMVECTOR lower = XMVectorLerp(XMLoadFloat4(&bottomRow[left]), XMLoadFloat4(&bottomRow[right]), fx);
+            return XMVectorLerp(upper, lower, fy);
+        }
+    };
+}
+
+uint32_t CubemapConverter::getFaceSize(uint32_t viewportHeight, float fovY, uint32_t sourceWidth)
+{
+    // a face spans 90 degrees, faceSize / 2 texels per radian at its center; the view has
+    // viewportHeight / (2 tan(fovY / 2)) pixels per radian at its center, the panorama width / 2pi at the equator
+    float screenSize = viewportHeight / std::tan(0.5f * fovY);
+    float sourceSize = sourceWidth / XM_PI;
+    float size = std::max(std::min(screenSize, sourceSize), 4.f);
+    return 1u << static_cast<uint32_t>(std::lround(std::log2(size)));
+}
+
+std::vector<std::vector<MipLevel>> CubemapConverter::convert(const uint8_t *pixels, uint32_t width, uint32_t height, size_t rowPitch,
+                                                             bool isSrgb, uint32_t faceSize)
+{
+    ThreadPool &pool = ThreadPool::getInstance();
+    Panorama panorama = {std::vector<XMFLOAT4>(static_cast<size_t>(width) * height), width, height};
+    pool.parallelFor(height, 16, [&](size_t begin, size_t end)
+                     {
+        for (size_t y = begin; y < end; ++y)
+        {
+            MipGenerator::decodeRow(pixels + y * rowPitch, width, isSrgb, panorama.texels.data() + y * width);
+        } });
+
+    // angle of one panorama texel along a row (at the equator) and down a column
+    float texelLongitude = XM_2PI / width;
+    float texelLatitude = XM_PI / height;
+    XMVECTOR toX = XMVectorReplicate(width / XM_2PI);
+    XMVECTOR toY = XMVectorReplicate(height / XM_PI);
+    XMVECTOR halfWidth = XMVectorReplicate(0.5f * width);
+
+    std::vector<std::vector<MipLevel>> faces(FACE_COUNT);
+    std::vector<MipLevel> topLevels(FACE_COUNT);
+    for (uint32_t face = 0; face < FACE_COUNT; ++face)
+    {
+        topLevels[face] = {faceSize, faceSize, std::vector<uint8_t>(static_cast<size_t>(faceSize) * faceSize * 4)};
+    }
+
+    pool.parallelFor(static_cast<size_t>(FACE_COUNT) * faceSize, ROW_GRAIN, [&](size_t begin, size_t end)
+                     {
+        std::vector<float> dirX, dirY, dirZ;  // every sample of a row, structure of arrays
+        std::vector<uint32_t> sampleStart(faceSize + 1);
+        std::vector<XMFLOAT4> row(faceSize);
+        std::vector<float> sampleX, sampleY;
+        for (size_t index = begin; index < end; ++index)
+        {
+            uint32_t face = static_cast<uint32_t>(index / faceSize);
+            uint32_t y = static_cast<uint32_t>(index % faceSize);
+            float texelSize = 2.f / faceSize;
+            float v = (y + 0.5f) * texelSize - 1.f;
+
+            dirX.clear();
+            dirY.clear();
+            dirZ.clear();
+            for (uint32_t x = 0; x < faceSize; ++x)
+            {
+                sampleStart[x] = static_cast<uint32_t>(dirX.size());
+                float u = (x + 0.5f) * texelSize - 1.f;
+
+                // the texel's angular size against the panorama's texels there; longitude texels narrow with cos(latitude)
+                float lengthSq = 1.f + u * u + v * v;
+                float texelAngle = texelSize / std::sqrt(lengthSq);
+                XMFLOAT3 direction;
+                XMStoreFloat3(&direction, XMVector3Normalize(getFaceDirection(face, u, v)));
+                float cosLatitude = std::sqrt(std::max(1.f - direction.y * direction.y, 0.f));
+                float footprint = std::max(texelAngle / std::max(texelLongitude * cosLatitude, 1e-6f), texelAngle / texelLatitude);
+                uint32_t samples = std::clamp(static_cast<uint32_t>(std::ceil(footprint)), 1u, MAX_SAMPLES);
+
+                for (uint32_t j = 0; j < samples; ++j)
+                {
+                    for (uint32_t i = 0; i < samples; ++i)
+                    {
+                        float su = u + ((i + 0.5f) / samples - 0.5f) * texelSize;
+                        float sv = v + ((j + 0.5f) / samples - 0.5f) * texelSize;
+                        XMFLOAT3 sample;
+                        XMStoreFloat3(&sample, getFaceDirection(face, su, sv));
+                        dirX.push_back(sample.x);
+                        dirY.push_back(sample.y);
+                        dirZ.push_back(sample.z);
+                    }
+                }
+            }
+            sampleStart[faceSize] = static_cast<uint32_t>(dirX.size());
+
+            // four directions at a time to panorama coordinates: longitude from atan2(x, z), latitude from acos(y)
+            size_t count = dirX.size();
+            size_t padded = (count + 3) & ~size_t(3);
+            dirX.resize(padded, 0.f);
+            dirY.resize(padded, 1.f);
+            dirZ.resize(padded, 0.f);
+            sampleX.resize(padded);
+            sampleY.resize(padded);
+            for (size_t i = 0; i < padded; i += 4)
+            {
+                XMVECTOR x = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(&dirX[i]));
+                XMVECTOR y = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(&dirY[i]));
+                XMVECTOR z = XMLoadFloat4(reinterpret_cast<const XMFLOAT4 *>(&dirZ[i]));
+                XMVECTOR inverseLength = XMVectorReciprocalSqrt(XMVectorMultiplyAdd(x, x, XMVectorMultiplyAdd(y, y, XMVectorMultiply(z, z))));
+                XMVECTOR longitude = XMVectorATan2(x, z);
+                XMVECTOR colatitude = XMVectorACos(XMVectorClamp(XMVectorMultiply(y, inverseLength), XMVectorReplicate(-1.f), XMVectorSplatOne()));
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4 *>(&sampleX[i]), XMVectorMultiplyAdd(longitude, toX, halfWidth));
+                XMStoreFloat4(reinterpret_cast<XMFLOAT4 *>(&sampleY[i]), XMVectorMultiply(colatitude, toY));
+            }
+
+            for (uint32_t x = 0; x < faceSize; ++x)
+            {
+                XMVECTOR sum = XMVectorZero();
+                for (uint32_t i = sampleStart[x]; i < sampleStart[x + 1]; ++i)
+                {
+                    sum = XMVectorAdd(sum, panorama.sample(sampleX[i], sampleY[i]));
+                }
+                XMStoreFloat4(&row[x], XMVectorScale(sum, 1.f / (sampleStart[x + 1] - sampleStart[x])));
+            }
+            MipGenerator::encodeRow(row.data(), faceSize, isSrgb, topLevels[face].pixels.data() + static_cast<size_t>(y) * faceSize * 4);
+        } });
+
+    // the panorama's wrap does not apply across face edges, box filtering stays inside each face
+    for (uint32_t face = 0; face < FACE_COUNT; ++face)
+    {
+        faces[face] = MipGenerator::generate(topLevels[face].pixels.data(), faceSize, faceSize, static_cast<size_t>(faceSize) * 4, isSrgb, MipFilter::Box);
+    }
+    return faces;
+}
@@ -0,0 +1,145 @@
+#include "resources/cubemap_texture.h"
+#include "resources/cubemap_converter.h"
+#include "utils/hash.h"
+#include <algorithm>
+#include <chrono>
+
+CubemapTexture::CubemapTexture(ID3D11Device *device, const std::string &sourcePath, uint32_t viewportHeight, float fovY, TextureCompression compression)
+    : CubemapTexture(device, cook(sourcePath, viewportHeight, fovY, compression))
+{
+}
+
+CubemapTexture::CubemapTexture(ID3D11Device *device, const CookedCubemap &cooked)
+    : m_faceSize(cooked.faceSize)
+{
+    std::vector<D3D11_SUBRESOURCE_DATA> initData;
+    initData.reserve(cooked.levels.size());
+    size_t gpuBytes = 0;
+    for (size_t i = 0; i < cooked.levels.size(); ++i)
+    {
+        D3D11_SUBRESOURCE_DATA data = {};
+        data.pSysMem = cooked.levels[i].data();
+        data.SysMemPitch = TextureCache::getRowPitch(cooked.format, std::max(cooked.faceSize >> (i % cooked.mipLevels), 1u));
+        initData.push_back(data);
+        gpuBytes += cooked.levels[i].size();
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = cooked.faceSize;
+    desc.Height = cooked.faceSize;
+    desc.MipLevels = cooked.mipLevels;
+    desc.ArraySize = CubemapConverter::FACE_COUNT;
+    desc.Format = cooked.format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_TEXTURECUBE;
+
+    HRESULT hr = device->CreateTexture2D(&desc, initData.data(), m_texture.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create cube map texture.");
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = cooked.format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+    srvDesc.TextureCube.MostDetailedMip = 0;
+    srvDesc.TextureCube.MipLevels = cooked.mipLevels;
+
+    hr = device->CreateShaderResourceView(m_texture.Get(), &srvDesc, m_srv.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create shader resource view for cube map.");
+    }
+    createSampler(device);
+    trackResidency(m_texture.Get(), false);
+
+    if (cooked.sourceWidth == 0)
+    {
+        Logger::Log(Logger::LogLevel::INFO, "CubemapTexture::CubemapTexture: {}: {:.2f} MB on the GPU", cooked.sourcePath, gpuBytes / (1024.f * 1024.f));
+        return;
+    }
+    size_t panoramaBytes = TextureCache::getLevelSize(cooked.format, cooked.sourceWidth, cooked.sourceHeight) * 4 / 3; // with its chain
+    Logger::Log(Logger::LogLevel::INFO, "CubemapTexture::CubemapTexture: {}: {:.2f} MB on the GPU, the panorama as a 2D texture would take {:.2f} MB",
+                cooked.sourcePath, gpuBytes / (1024.f * 1024.f), panoramaBytes / (1024.f * 1024.f));
+}
+
+uint64_t CubemapTexture::getOptionsKey(uint32_t viewportHeight, float fovY, TextureCompression compression)
+{
+    // the face size follows from these and the source, which the cache stamps on its own
+    return hashValue(compression, hashValue(fovY, hashValue(viewportHeight, hashValue(CubemapConverter::FACE_COUNT))));
+}
+
+CubemapTexture::CookedCubemap CubemapTexture::cook(const std::string &sourcePath, uint32_t viewportHeight, float fovY, TextureCompression compression)
+{
+    // cooked before: copy the faces out of the mapped DDS, no decode, conversion or encoding
+    auto startTime = std::chrono::high_resolution_clock::now();
+    uint64_t optionsKey = getOptionsKey(viewportHeight, fovY, compression);
+    CookedCubemap cooked;
+    cooked.sourcePath = sourcePath;
+    TextureCache::CachedTexture cached;
+    if (TextureCache::load(sourcePath, optionsKey, cached, true) && cached.width == cached.height)
+    {
+        cooked.format = cached.format;
+        cooked.faceSize = cached.width;
+        cooked.mipLevels = cached.mipLevels;
+        cooked.levels.reserve(cached.levels.size());
+        for (size_t i = 0; i < cached.levels.size(); ++i)
+        {
+            uint32_t size = std::max(cooked.faceSize >> (i % cooked.mipLevels), 1u);
+            cooked.levels.emplace_back(cached.levels[i], cached.levels[i] + TextureCache::getLevelSize(cooked.format, size, size));
+        }
+        float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+        Logger::Log(Logger::LogLevel::INFO, "CubemapTexture::cook: {}: {}x{} faces, {} mip levels from {} in {:.2f} ms",
+                    sourcePath, cooked.faceSize, cooked.faceSize, cooked.mipLevels, TextureCache::getCachePath(sourcePath, true), elapsedMs);
+        return cooked;
+    }
+
+    DecodedImage image = ImageTexture::decode(sourcePath);
+    cooked.sourceWidth = image.width;
+    cooked.sourceHeight = image.height;
+    cooked.faceSize = CubemapConverter::getFaceSize(viewportHeight, fovY, image.width);
+
+    startTime = std::chrono::high_resolution_clock::now();
+    std::vector<std::vector<MipLevel>> faces = CubemapConverter::convert(image.pixels.data(), image.width, image.height,
+                                                                         static_cast<size_t>(image.width) * 4, true, cooked.faceSize);
+    float convertMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+    // the panorama decides the encoding, its texels are what the faces resample
+    BlockFormat blockFormat = BlockFormat::BC7;
+    bool isBlockCompressed = ImageTexture::selectBlockFormat(image, compression, blockFormat); // faces are 4 texels or larger
+    cooked.format = ImageTexture::getCookedFormat(isBlockCompressed, blockFormat, image.isSrgb);
+
+    startTime = std::chrono::high_resolution_clock::now();
+    cooked.mipLevels = static_cast<uint32_t>(faces[0].size());
+    cooked.levels.reserve(CubemapConverter::FACE_COUNT * cooked.mipLevels);
+    for (std::vector<MipLevel> &levels : faces)
+    {
+        for (MipLevel &level : levels)
+        {
+            cooked.levels.push_back(isBlockCompressed ? BlockCompressor::compress(blockFormat, level.pixels.data(), level.width, level.height)
+                                                      : std::move(level.pixels));
+        }
+    }
+    float encodeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+    Logger::Log(Logger::LogLevel::INFO, "CubemapTexture::cook: {}: {}x{} panorama to {}x{} faces, {} mip levels, converted in {:.2f} ms ({:.1f} MP/s), encoded in {:.2f} ms",
+                sourcePath, image.width, image.height, cooked.faceSize, cooked.faceSize, cooked.mipLevels, convertMs,
+                CubemapConverter::FACE_COUNT * cooked.faceSize * cooked.faceSize / 1000.f / std::max(convertMs, 1e-3f), encodeMs);
+
+    TextureCache::save(sourcePath, optionsKey, cooked.format, cooked.faceSize, cooked.faceSize, cooked.levels, true);
+    return cooked;
+}
+
+void CubemapTexture::bind(ID3D11DeviceContext *deviceContext, UINT slot) const
+{
+    markUsed();
+    if (isBound(slot))
+    {
+        return;
+    }
+    deviceContext->PSSetShaderResources(slot, 1, m_srv.GetAddressOf());
+    deviceContext->PSSetSamplers(slot, 1, m_sampler.GetAddressOf());
+    setBound(slot);
+}
@@ -1,9 +1,159 @@
 #include "resources/game_resource_mgr.h"
 #include "resources/render_component.h"
+#include "resources/geometry_pool.h"
+#include "resources/static_batch.h"
+#include "resources/texture.h"
+#include "resources/texture_residency.h"
+#include "resources/texture_streamer.h"
+#include "resources/texture_array.h"
+#include "resources/cubemap_texture.h"
 #include "graphics/dx11/dx_device_mgr.h"
 #include "resources/buffer_type.h"
+#include "entity/camera_base.h"
+#include "utils/hash.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
 
-GameResourceManager::GameResourceManager(ID3D11Device *device) : m_device(device) {}
+namespace
+{
+    // every option that changes the mesh, Default residency resolved so changing the default does not share
+    uint64_t hashMeshOptions(const MeshOptions &options)
+    {
+        MeshResidency residency = options.residency == MeshResidency::Default ? Mesh::getDefaultResidency() : options.residency;
+        uint64_t key = hashValue(options.weldEpsilon);
+        key = hashValue(options.optimizeVertexCache, key);
+        key = hashValue(options.optimizeOverdraw, key);
+        key = hashValue(options.lodCount, key);
+        key = hashValue(options.lodReduction, key);
+        key = hashValue(options.lodMaxError, key);
+        key = hashValue(options.vertexFormat, key);
+        key = hashValue(options.positionStream, key);
+        key = hashValue(options.useCache, key);
+        key = hashValue(options.useGeometryPool, key);
+        key = hashValue(residency, key);
+        key = hashValue(options.buildMeshlets, key);
+        key = hashValue(options.maxMeshletVertices, key);
+        return hashValue(options.maxMeshletTriangles, key);
+    }
+
+    struct AssetKey
+    {
+        std::string name;
+        uint64_t optionsKey = 0;
+    };
+
+    AssetKey getMeshKey(const std::string &filepath, const MeshOptions &options)
+    {
+        uint64_t optionsKey = hashMeshOptions(options);
+        return {normalizeAssetPath(filepath) + "|" + std::to_string(optionsKey), optionsKey};
+    }
+
+    AssetKey getShaderKey(const std::wstring &vertexShaderPath, const std::wstring &pixelShaderPath,
+                          const D3D11_INPUT_ELEMENT_DESC *inputElementDescs, UINT numInputElementDescs)
+    {
+        uint64_t layoutKey = Shader::hashInputLayout(inputElementDescs, numInputElementDescs);
+        return {normalizeAssetPath(vertexShaderPath) + "|" + normalizeAssetPath(pixelShaderPath) + "|" + std::to_string(layoutKey), layoutKey};
+    }
+
+    AssetKey getTextureKey(const std::string &filepath, TextureCompression compression, TextureLoading loading)
+    {
+        uint64_t optionsKey = hashValue(loading, hashValue(compression, hashValue(0u))); // 0: ImageTexture
+        return {normalizeAssetPath(filepath) + "|" + std::to_string(optionsKey), optionsKey};
+    }
+
+    AssetKey getCubemapKey(const std::string &filepath, uint32_t viewportHeight, float fovY, TextureCompression compression)
+    {
+        uint64_t optionsKey = hashValue(1u, CubemapTexture::getOptionsKey(viewportHeight, fovY, compression)); // 1: CubemapTexture
+        return {normalizeAssetPath(filepath) + "|" + std::to_string(optionsKey), optionsKey};
+    }
+
+    AssetKey getTexturePackKey(const std::vector<std::string> &filePaths, const TexturePackOptions &options,
+                               TextureCompression compression, TextureLoading loading)
+    {
+        uint64_t optionsKey = hashValue(options.minArraySize);
+        optionsKey = hashValue(options.maxAtlasItemSize, optionsKey);
+        optionsKey = hashValue(options.atlasPageSize, optionsKey);
+        optionsKey = hashValue(options.atlasMipLevels, optionsKey);
+        optionsKey = hashValue(compression, optionsKey);
+        optionsKey = hashValue(loading, optionsKey);
+
+        AssetKey key;
+        for (const std::string &filepath : filePaths)
+        {
+            key.name += normalizeAssetPath(filepath) + "|";
+        }
+        key.name += std::to_string(optionsKey);
+        key.optionsKey = optionsKey;
+        return key;
+    }
+
+    uint64_t hashFiles(const std::vector<std::string> &filePaths, uint64_t seed)
+    {
+        uint64_t key = seed;
+        for (const std::string &filepath : filePaths)
+        {
+            key = hashAssetFile(filepath, key);
+        }
+        return key;
+    }
+
+    std::shared_ptr<TextureBase> createImageTexture(ID3D11Device *device, ImageTexture::PreparedTexture &&prepared)
+    {
+        auto texture = std::make_shared<ImageTexture>(device, std::move(prepared));
+        if (texture->isStreamPending())
+        {
+            TextureStreamer::getInstance().request(texture);
+        }
+        return texture;
+    }
+
+    // What an asynchronous load's prepare step hands to its create step
+    template <typename T>
+    struct PreparedAsset
+    {
+        uint64_t contentKey = 0;
+        T data;
+    };
+
+    // The prepare step of a texture load: decoded, mipped and encoded into the cache (or the progressive tail),
+    // so the create step only uploads
+    PreparedAsset<ImageTexture::PreparedTexture> prepareTexture(const std::string &filepath, TextureCompression compression, TextureLoading loading,
+                                                                uint64_t optionsKey)
+    {
+        return {hashAssetFile(filepath, optionsKey), ImageTexture::prepare(filepath, compression, loading)};
+    }
+
+    size_t getPackBytes(const std::vector<TextureRef> &textures)
+    {
+        std::unordered_set<const TextureBase *> counted;
+        size_t bytes = 0;
+        for (const TextureRef &ref : textures)
+        {
+            if (ref.texture && counted.insert(ref.texture.get()).second)
+            {
+                bytes += ref.texture->getGpuBytes();
+            }
+        }
+        return bytes;
+    }
+
+    void logCacheStats(const char *type, const AssetCacheStats &stats)
+    {
+        Logger::Log(Logger::LogLevel::INFO, "GameResourceManager::logAssetStats: {:<8} {} assets ({} names), {:.1f} KB; {} hits, {} content hits, {} misses, {} unloads",
+                    type, stats.assetCount, stats.nameCount, stats.residentBytes / 1024.0, stats.hits, stats.contentHits, stats.misses, stats.unloads);
+    }
+}
+
+GameResourceManager::GameResourceManager(ID3D11Device *device)
+    : m_device(device),
+      m_meshes([](const Mesh &mesh) { return mesh.getCpuBytes() + mesh.getGpuBytes(); }),
+      m_textures([](const TextureBase &texture) { return texture.getGpuBytes(); }),
+      m_texturePacks([](const TexturePack &pack) { return getPackBytes(pack.textures); }),
+      m_assetLoader(device),
+      m_startTime(std::chrono::steady_clock::now())
+{
+}
 GameResourceManager::~GameResourceManager() {}
 
 void GameResourceManager::registerStaticEntity(std::shared_ptr<EntityBase> entity)
@@ -59,6 +209,287 @@ std::shared_ptr<Light> GameResourceManager::getLight(uint32_t id) const
     return (it != m_lights.end()) ? it->second : nullptr;
 }
 
+std::shared_ptr<Mesh> GameResourceManager::loadMesh(const std::string &filepath, const std::string &name, const MeshOptions &options)
+{
+    AssetKey key = getMeshKey(filepath, options);
+    return m_meshes.load(key.name,
+                         [&]() { return hashAssetFile(filepath, key.optionsKey); },
+                         [&]() { return std::make_shared<Mesh>(m_device, filepath, name, options); });
+}
+
+std::shared_ptr<Shader> GameResourceManager::loadShader(const std::wstring &vertexShaderPath, const std::wstring &pixelShaderPath,
+                                                        const D3D11_INPUT_ELEMENT_DESC *inputElementDescs, UINT numInputElementDescs)
+{
+    AssetKey key = getShaderKey(vertexShaderPath, pixelShaderPath, inputElementDescs, numInputElementDescs);
+    return m_shaders.load(key.name,
+                          [&]() { return hashAssetFile(pixelShaderPath, hashAssetFile(vertexShaderPath, key.optionsKey)); },
+                          [&]() { return std::make_shared<Shader>(m_device, vertexShaderPath, pixelShaderPath, inputElementDescs, numInputElementDescs); });
+}
+
+std::shared_ptr<TextureBase> GameResourceManager::loadTexture(const std::string &filepath, TextureCompression compression, TextureLoading loading)
+{
+    AssetKey key = getTextureKey(filepath, compression, loading);
+    return m_textures.load(key.name,
+                           [&]() { return hashAssetFile(filepath, key.optionsKey); },
+                           [&]() { return createImageTexture(m_device, ImageTexture::prepare(filepath, compression, loading)); });
+}
+
+std::shared_ptr<TextureBase> GameResourceManager::loadCubemap(const std::string &filepath, uint32_t viewportHeight, float fovY, TextureCompression compression)
+{
+    AssetKey key = getCubemapKey(filepath, viewportHeight, fovY, compression);
+    return m_textures.load(key.name,
+                           [&]() { return hashAssetFile(filepath, key.optionsKey); },
+                           [&]() { return std::make_shared<CubemapTexture>(m_device, filepath, viewportHeight, fovY, compression); });
+}
+
+std::vector<TextureRef> GameResourceManager::loadTexturePack(const std::vector<std::string> &filePaths, const TexturePackOptions &options,
+                                                             TextureCompression compression, TextureLoading loading)
+{
+    AssetKey key = getTexturePackKey(filePaths, options, compression, loading);
+    return getPackRefs(m_texturePacks.load(key.name,
+                                           [&]() { return hashFiles(filePaths, key.optionsKey); },
+                                           [&]()
+                                           {
+        auto pack = std::make_shared<TexturePack>();
+        pack->textures = TextureArray::loadPacked(m_device, filePaths, options, compression, loading);
+        return pack; }));
+}
+
+AssetFuture<std::shared_ptr<Mesh>> GameResourceManager::loadMeshAsync(const std::string &filepath, const std::string &name, const MeshOptions &options)
+{
+    AssetKey key = getMeshKey(filepath, options);
+    if (std::shared_ptr<Mesh> mesh = m_meshes.tryLoad(key.name))
+    {
+        return AssetLoader::makeReady(mesh);
+    }
+    return m_assetLoader.load([filepath, name, options, key]()
+                              { return PreparedAsset<std::shared_ptr<Mesh>>{hashAssetFile(filepath, key.optionsKey), Mesh::prepare(filepath, name, options)}; },
+                              [this, key](ID3D11Device *device, PreparedAsset<std::shared_ptr<Mesh>> &prepared)
+                              {
+        return m_meshes.load(key.name, [&]() { return prepared.contentKey; }, [&]()
+                             {
+            prepared.data->upload(device);
+            return prepared.data; }); });
+}
+
+AssetFuture<std::shared_ptr<Shader>> GameResourceManager::loadShaderAsync(const std::wstring &vertexShaderPath, const std::wstring &pixelShaderPath,
+                                                                          const D3D11_INPUT_ELEMENT_DESC *inputElementDescs, UINT numInputElementDescs)
+{
+    AssetKey key = getShaderKey(vertexShaderPath, pixelShaderPath, inputElementDescs, numInputElementDescs);
+    if (std::shared_ptr<Shader> shader = m_shaders.tryLoad(key.name))
+    {
+        return AssetLoader::makeReady(shader);
+    }
+    return m_assetLoader.load([vertexShaderPath, pixelShaderPath, key]()
+                              {
+        uint64_t contentKey = hashAssetFile(pixelShaderPath, hashAssetFile(vertexShaderPath, key.optionsKey));
+        return PreparedAsset<ShaderBytecode>{contentKey, Shader::compile(vertexShaderPath, pixelShaderPath)}; },
+                              [this, key, inputElementDescs, numInputElementDescs](ID3D11Device *device, PreparedAsset<ShaderBytecode> &prepared)
+                              {
+        return m_shaders.load(key.name, [&]() { return prepared.contentKey; }, [&]()
+                              { return std::make_shared<Shader>(device, prepared.data, inputElementDescs, numInputElementDescs); }); });
+}
+
+AssetFuture<std::shared_ptr<TextureBase>> GameResourceManager::loadTextureAsync(const std::string &filepath, TextureCompression compression, TextureLoading loading)
+{
+    AssetKey key = getTextureKey(filepath, compression, loading);
+    if (std::shared_ptr<TextureBase> texture = m_textures.tryLoad(key.name))
+    {
+        return AssetLoader::makeReady(texture);
+    }
+    return m_assetLoader.load([filepath, compression, loading, key]()
+                              { return prepareTexture(filepath, compression, loading, key.optionsKey); },
+                              [this, key](ID3D11Device *device, PreparedAsset<ImageTexture::PreparedTexture> &prepared)
+                              {
+        return m_textures.load(key.name, [&]() { return prepared.contentKey; }, [&]()
+                               { return createImageTexture(device, std::move(prepared.data)); }); });
+}
+
+AssetFuture<std::shared_ptr<TextureBase>> GameResourceManager::loadCubemapAsync(const std::string &filepath, uint32_t viewportHeight, float fovY,
+                                                                                TextureCompression compression)
+{
+    AssetKey key = getCubemapKey(filepath, viewportHeight, fovY, compression);
+    if (std::shared_ptr<TextureBase> texture = m_textures.tryLoad(key.name))
+    {
+        return AssetLoader::makeReady(texture);
+    }
+    return m_assetLoader.load([filepath, viewportHeight, fovY, compression, key]()
+                              {
+        uint64_t contentKey = hashAssetFile(filepath, key.optionsKey);
+        return PreparedAsset<CubemapTexture::CookedCubemap>{contentKey, CubemapTexture::cook(filepath, viewportHeight, fovY, compression)}; },
+                              [this, key](ID3D11Device *device, PreparedAsset<CubemapTexture::CookedCubemap> &prepared)
+                              {
+        return m_textures.load(key.name, [&]() { return prepared.contentKey; }, [&]()
+                               { return std::make_shared<CubemapTexture>(device, prepared.data); }); });
+}
+
+AssetFuture<std::vector<TextureRef>> GameResourceManager::loadTexturePackAsync(const std::vector<std::string> &filePaths, const TexturePackOptions &options,
+                                                                               TextureCompression compression, TextureLoading loading)
+{
+    AssetKey key = getTexturePackKey(filePaths, options, compression, loading);
+    if (std::shared_ptr<TexturePack> pack = m_texturePacks.tryLoad(key.name))
+    {
+        return AssetLoader::makeReady(getPackRefs(pack));
+    }
+    return m_assetLoader.load([filePaths, options, compression, loading, key]()
+                              {
+        uint64_t contentKey = hashFiles(filePaths, key.optionsKey);
+        return PreparedAsset<TextureArray::PreparedPack>{contentKey, TextureArray::preparePacked(filePaths, options, compression, loading)}; },
+                              [this, key](ID3D11Device *device, PreparedAsset<TextureArray::PreparedPack> &prepared)
+                              {
+        return getPackRefs(m_texturePacks.load(key.name, [&]() { return prepared.contentKey; }, [&]()
+                                               {
+            auto pack = std::make_shared<TexturePack>();
+            pack->textures = TextureArray::createPacked(device, std::move(prepared.data));
+            return pack; })); });
+}
+
+void GameResourceManager::waitForLoads(const std::function<void()> &onWait)
+{
+    m_assetLoader.wait(onWait);
+    m_assetLoader.logStats();
+}
+
+std::shared_ptr<LazyAsset<Mesh>> GameResourceManager::loadMeshLazy(const std::string &filepath, const std::string &name, std::shared_ptr<Mesh> placeholder,
+                                                                   const MeshOptions &options)
+{
+    if (placeholder == nullptr)
+    {
+        throw std::runtime_error("GameResourceManager::loadMeshLazy: placeholder is nullptr");
+    }
+    return std::make_shared<LazyAsset<Mesh>>(addLazyAsset("mesh", filepath),
+                                             [this, filepath, name, options]() { return loadMeshAsync(filepath, name, options); },
+                                             placeholder);
+}
+
+std::shared_ptr<LazyAsset<MaterialBase>> GameResourceManager::loadMaterialLazy(std::shared_ptr<Shader> shader, const std::string &albedoPath,
+                                                                               std::shared_ptr<MaterialBase> placeholder,
+                                                                               TextureCompression compression, TextureLoading loading)
+{
+    if (shader == nullptr || placeholder == nullptr)
+    {
+        throw std::runtime_error("GameResourceManager::loadMaterialLazy: shader or placeholder is nullptr");
+    }
+    auto load = [this, shader, albedoPath, compression, loading]() -> AssetFuture<std::shared_ptr<MaterialBase>>
+    {
+        // loadTextureAsync, with the material created in the same step
+        AssetKey key = getTextureKey(albedoPath, compression, loading);
+        if (std::shared_ptr<TextureBase> texture = m_textures.tryLoad(key.name))
+        {
+            return AssetLoader::makeReady(loadMaterial(shader, texture));
+        }
+        return m_assetLoader.load([albedoPath, compression, loading, key]()
+                                  { return prepareTexture(albedoPath, compression, loading, key.optionsKey); },
+                                  [this, key, shader](ID3D11Device *device, PreparedAsset<ImageTexture::PreparedTexture> &prepared)
+                                  {
+            std::shared_ptr<TextureBase> texture = m_textures.load(key.name, [&]() { return prepared.contentKey; }, [&]()
+                                                                   { return createImageTexture(device, std::move(prepared.data)); });
+            return loadMaterial(shader, texture); });
+    };
+    return std::make_shared<LazyAsset<MaterialBase>>(addLazyAsset("material", albedoPath), load, placeholder);
+}
+
+std::shared_ptr<LazyAssetUsage> GameResourceManager::addLazyAsset(const char *type, const std::string &name)
+{
+    auto usage = std::make_shared<LazyAssetUsage>();
+    usage->type = type;
+    usage->name = name;
+    m_lazyAssets.push_back(usage);
+    return usage;
+}
+
+std::vector<LazyAssetUsage> GameResourceManager::getLazyAssetUsage() const
+{
+    std::vector<LazyAssetUsage> usage;
+    usage.reserve(m_lazyAssets.size());
+    for (const auto &asset : m_lazyAssets)
+    {
+        usage.push_back(*asset);
+    }
+    return usage;
+}
+
+void GameResourceManager::logLazyAssetReport() const
+{
+    LazyAssetCounts counts = countLazyAssets(m_lazyAssets);
+    Logger::Log(Logger::LogLevel::INFO, "GameResourceManager::logLazyAssetReport: {} lazy assets, {} loaded, {} failed, {} still loading, {} never requested",
+                m_lazyAssets.size(), counts.loaded, counts.failed, counts.loading, counts.neverRequested);
+    for (const auto &asset : m_lazyAssets)
+    {
+        if (!asset->isRequested)
+        {
+            Logger::Log(Logger::LogLevel::INFO, "GameResourceManager::logLazyAssetReport: never requested: {} {}", asset->type, asset->name);
+            continue;
+        }
+        float requestedAfter = std::chrono::duration<float>(asset->requestTime - m_startTime).count();
+        if (asset->isLoaded)
+        {
+            Logger::Log(Logger::LogLevel::INFO, "GameResourceManager::logLazyAssetReport: {} {}: requested after {:.2f} s, in use {:.2f} ms later",
+                        asset->type, asset->name, requestedAfter, asset->loadMs);
+        }
+        else
+        {
+            Logger::Log(Logger::LogLevel::INFO, "GameResourceManager::logLazyAssetReport: {} {}: requested after {:.2f} s, {}",
+                        asset->type, asset->name, requestedAfter, asset->isFailed ? "failed" : "still loading");
+        }
+    }
+}
+
+std::vector<TextureRef> GameResourceManager::getPackRefs(const std::shared_ptr<TexturePack> &pack)
+{
+    // aliasing pointers: every ref handed out keeps the pack cached
+    std::vector<TextureRef> textures = pack->textures;
+    for (TextureRef &ref : textures)
+    {
+        ref.texture = std::shared_ptr<TextureBase>(pack, ref.texture.get());
+    }
+    return textures;
+}
+
+std::shared_ptr<MaterialBase> GameResourceManager::loadMaterial(std::shared_ptr<Shader> shader, const DirectX::XMFLOAT4 &albedo)
+{
+    uint64_t key = hashValue(albedo, shader->getContentKey());
+    return m_materials.load("lambertian|" + std::to_string(key), {},
+                            [&]() { return std::make_shared<LambertianMaterial>(m_device, shader, albedo); });
+}
+
+std::shared_ptr<MaterialBase> GameResourceManager::loadMaterial(std::shared_ptr<Shader> shader, std::shared_ptr<TextureBase> albedoTexture)
+{
+    return loadMaterial(shader, TextureRef{albedoTexture});
+}
+
+std::shared_ptr<MaterialBase> GameResourceManager::loadMaterial(std::shared_ptr<Shader> shader, const TextureRef &albedoTexture)
+{
+    // the material holds its texture, so the address identifies it while the entry lives
+    uint64_t key = hashValue(albedoTexture.texture.get(), shader->getContentKey());
+    key = hashValue(albedoTexture.slice, key);
+    key = hashValue(albedoTexture.uvScaleBias, key);
+    key = hashValue(albedoTexture.isAtlas, key);
+    return m_materials.load("lambertian_texture|" + std::to_string(key), {},
+                            [&]() { return std::make_shared<LambertianMaterial>(m_device, shader, albedoTexture); });
+}
+
+GameResourceManager::AssetStats GameResourceManager::getAssetStats() const
+{
+    AssetStats stats;
+    stats.meshes = m_meshes.getStats();
+    stats.shaders = m_shaders.getStats();
+    stats.textures = m_textures.getStats();
+    stats.texturePacks = m_texturePacks.getStats();
+    stats.materials = m_materials.getStats();
+    return stats;
+}
+
+void GameResourceManager::logAssetStats() const
+{
+    AssetStats stats = getAssetStats();
+    logCacheStats("meshes", stats.meshes);
+    logCacheStats("shaders", stats.shaders);
+    logCacheStats("textures", stats.textures);
+    logCacheStats("packs", stats.texturePacks);
+    logCacheStats("materials", stats.materials);
+}
+
 void GameResourceManager::onLogicUpdate(float deltaTime)
 {
     for (auto &pair : m_rootEntities)
@@ -67,18 +498,61 @@ void GameResourceManager::onLogicUpdate(float deltaTime)
     }
 }
 
-void GameResourceManager::onGraphicsUpdate(DXDeviceManager *deviceManager)
+void GameResourceManager::onGraphicsUpdate(DXDeviceManager *deviceManager, CameraBase *camera, float viewportHeight)
 {
     auto deviceContext = deviceManager->getDeviceContext();
 
+    if (m_isStaticBatchDirty)
+    {
+        rebuildStaticBatches();
+    }
+    GeometryPool::getInstance().invalidateBindings(); // IA state may have changed since the last frame
+    TextureBase::invalidateBindings(); // and so may the pixel shader slots
+    m_assetLoader.update(); // loads submitted after startup
+    TextureStreamer::getInstance().update(deviceManager->getDevice()); // before residency moves the frame on
+    TextureResidency::getInstance().update(deviceManager->getDevice(), deviceContext);
     bindLightArrayBuffer(deviceContext);
 
-    for (auto &pair : m_allEntities)
+    // LOD selection and cluster culling inputs
+    RenderView view = {};
+    if (camera)
     {
-        std::shared_ptr<EntityBase> entity = pair.second;
+        DirectX::XMMATRIX viewMatrix, projectionMatrix;
+        camera->getViewMatrix(viewMatrix);
+        camera->getProjectionMatrix(projectionMatrix);
+        view.viewProjection = viewMatrix * projectionMatrix;
+        camera->getPosition(view.cameraPosition);
+        view.pixelsPerUnit = 0.5f * viewportHeight / std::tan(0.5f * camera->getFOV());
+    }
+
+    cullEntities(camera);
+    requestLazyAssets(camera); // after update(), a load finished this frame is drawn this frame
+
+    FrameStats stats = {};
+    stats.culledEntities = static_cast<uint32_t>(m_cullEntities.size());
+    for (size_t i = 0; i < m_cullEntities.size(); ++i)
+    {
+        if (!m_cullVisible[i])
+        {
+            continue;
+        }
+
+        EntityBase *entity = m_cullEntities[i];
         entity->onGraphicsUpdate(deviceContext); // bind model buffer
+        ++stats.drawnEntities;
+        stats.staticBatches += i >= m_cullBatchStart ? 1 : 0;
         for (auto &comp : entity->getRenderComponents())
         {
+            if (m_batchedComponents.count(comp.get()))
+            {
+                continue; // part of a static batch
+            }
+
+            comp->prepare(entity->getWorldMatrix(), camera ? &view : nullptr);
+            stats.visibleMeshlets += static_cast<uint32_t>(comp->getVisibleMeshletCount());
+            stats.totalMeshlets += static_cast<uint32_t>(comp->getMeshletCount());
+            stats.drawCalls += static_cast<uint32_t>(comp->getDrawCallCount());
+
             if (comp->getIsCullFront())
             {
                 deviceManager->setRasterStateCullFront();
@@ -91,6 +565,94 @@ void GameResourceManager::onGraphicsUpdate(DXDeviceManager *deviceManager)
             comp->render(deviceContext); // bind render comp (mesh, material, shader, etc.)
         }
     }
+    stats.culledEntities -= stats.drawnEntities;
+
+    if (stats.drawnEntities != m_frameStats.drawnEntities || stats.culledEntities != m_frameStats.culledEntities || stats.staticBatches != m_frameStats.staticBatches)
+    {
+        Logger::Log(Logger::LogLevel::INFO, "GameResourceManager::onGraphicsUpdate: {} entities drawn ({} static batches), {} culled, {} draw calls",
+                    stats.drawnEntities, stats.staticBatches, stats.culledEntities, stats.drawCalls);
+    }
+    m_frameStats = stats;
+}
+
+void GameResourceManager::cullEntities(CameraBase *camera)
+{
+    // structure-of-arrays world spheres so the frustum test runs four entities at a time
+    m_cullEntities.clear();
+    m_cullCenterX.clear();
+    m_cullCenterY.clear();
+    m_cullCenterZ.clear();
+    m_cullRadius.clear();
+    auto addEntity = [this](EntityBase *entity)
+    {
+        DirectX::XMFLOAT3 center;
+        float radius;
+        if (!entity->getWorldBoundingSphere(center, radius))
+        {
+            return; // nothing to draw
+        }
+        m_cullEntities.push_back(entity);
+        m_cullCenterX.push_back(center.x);
+        m_cullCenterY.push_back(center.y);
+        m_cullCenterZ.push_back(center.z);
+        m_cullRadius.push_back(radius);
+    };
+    for (auto &pair : m_allEntities)
+    {
+        if (!m_batchedEntities.count(pair.second.get()))
+        {
+            addEntity(pair.second.get());
+        }
+    }
+    m_cullBatchStart = m_cullEntities.size();
+    for (auto &batch : m_staticBatches)
+    {
+        addEntity(batch.get());
+    }
+
+    m_cullVisible.assign(m_cullEntities.size(), 1);
+    if (camera)
+    {
+        Frustum frustum;
+        camera->getFrustum(frustum);
+        frustum.intersectsSpheres(m_cullCenterX.data(), m_cullCenterY.data(), m_cullCenterZ.data(), m_cullRadius.data(),
+                                  m_cullEntities.size(), m_cullVisible.data());
+    }
+}
+
+void GameResourceManager::requestLazyAssets(CameraBase *camera)
+{
+    if (m_lazyAssets.empty())
+    {
+        return;
+    }
+
+    DirectX::XMFLOAT3 cameraPosition = {};
+    if (camera)
+    {
+        camera->getPosition(cameraPosition);
+    }
+    for (size_t i = 0; i < m_cullBatchStart; ++i)
+    {
+        if (!m_cullVisible[i])
+        {
+            // near enough to be seen soon
+            float dx = m_cullCenterX[i] - cameraPosition.x;
+            float dy = m_cullCenterY[i] - cameraPosition.y;
+            float dz = m_cullCenterZ[i] - cameraPosition.z;
+            if (m_lazyLoadDistance <= 0.f || std::sqrt(dx * dx + dy * dy + dz * dz) - m_cullRadius[i] > m_lazyLoadDistance)
+            {
+                continue;
+            }
+        }
+        for (auto &comp : m_cullEntities[i]->getRenderComponents())
+        {
+            if (comp->hasPendingAssets())
+            {
+                comp->requestAssets();
+            }
+        }
+    }
 }
 
 void GameResourceManager::rebuildRootEntities()
@@ -104,6 +666,65 @@ void GameResourceManager::rebuildRootEntities()
             m_rootEntities[entity->getId()] = entity;
         }
     }
+
+    // batches only need rebuilding when static entities or their components come or go
+    std::vector<uint32_t> staticIds;
+    for (auto &pair : m_allEntities)
+    {
+        if (pair.second->getIsStatic())
+        {
+            staticIds.push_back(pair.first);
+        }
+    }
+    std::sort(staticIds.begin(), staticIds.end());
+    uint64_t staticSetHash = FNV_OFFSET_BASIS;
+    for (uint32_t id : staticIds)
+    {
+        staticSetHash = hashValue(id, staticSetHash);
+        for (auto &comp : m_allEntities[id]->getRenderComponents())
+        {
+            staticSetHash = hashValue(comp.get(), staticSetHash);
+        }
+    }
+    if (staticSetHash != m_staticSetHash)
+    {
+        m_staticSetHash = staticSetHash;
+        m_isStaticBatchDirty = true;
+    }
+}
+
+void GameResourceManager::rebuildStaticBatches()
+{
+    m_isStaticBatchDirty = false;
+    m_staticBatches.clear();
+    m_batchedComponents.clear();
+    m_batchedEntities.clear();
+
+    std::vector<std::shared_ptr<EntityBase>> staticEntities;
+    for (auto &pair : m_allEntities)
+    {
+        if (pair.second->getIsStatic())
+        {
+            staticEntities.push_back(pair.second);
+        }
+    }
+    std::sort(staticEntities.begin(), staticEntities.end(), [](const auto &a, const auto &b)
+              { return a->getId() < b->getId(); });
+    if (staticEntities.empty())
+    {
+        return;
+    }
+
+    m_staticBatches = StaticBatch::build(m_device, staticEntities, m_batchedComponents);
+    for (auto &entity : staticEntities)
+    {
+        auto components = entity->getRenderComponents();
+        if (std::all_of(components.begin(), components.end(), [this](const auto &comp)
+                        { return m_batchedComponents.count(comp.get()) > 0; }))
+        {
+            m_batchedEntities.insert(entity.get());
+        }
+    }
 }
 
 void GameResourceManager::topDownLogicUpdateRecursive(std::shared_ptr<EntityBase> entity, float deltaTime)
@@ -0,0 +1,302 @@
+#include "resources/geometry_pool.h"
+#include "resources/vertex.h"
+#include <algorithm>
+
+GeometryPool &GeometryPool::getInstance()
+{
+    static GeometryPool instance;
+    return instance;
+}
+
+void GeometryPool::createBuffer(ID3D11Device *device, UINT bindFlags, size_t byteWidth, ID3D11Buffer **buffer)
+{
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    bufferDesc.ByteWidth = static_cast<UINT>(byteWidth);
+    bufferDesc.BindFlags = bindFlags;
+
+    HRESULT hr = device->CreateBuffer(&bufferDesc, nullptr, buffer);
+    if (FAILED(hr))
+    {
+        throw std::runtime_error(std::format("GeometryPool::createBuffer: Failed to create a {} byte arena (bind flags {:#x}), HRESULT: {:#X}",
+                                             byteWidth, bindFlags, static_cast<uint32_t>(hr)));
+    }
+}
+
+void GeometryPool::upload(ID3D11DeviceContext *deviceContext, ID3D11Buffer *buffer, size_t byteOffset, const void *data, size_t byteWidth)
+{
+    if (byteWidth == 0)
+    {
+        return;
+    }
+    D3D11_BOX box = {};
+    box.left = static_cast<UINT>(byteOffset);
+    box.right = static_cast<UINT>(byteOffset + byteWidth);
+    box.bottom = 1;
+    box.back = 1;
+    deviceContext->UpdateSubresource(buffer, 0, &box, data, 0, 0);
+}
+
+void GeometryPool::copy(ID3D11DeviceContext *deviceContext, ID3D11Buffer *target, ID3D11Buffer *source, const std::vector<TlsfAllocator::Move> &moves, UINT stride)
+{
+    // ranges that were already packed stay where they are, they form the prefix before the first move
+    uint32_t prefix = moves.empty() ? UINT32_MAX : moves.front().to;
+    std::vector<TlsfAllocator::Move> regions;
+    regions.push_back({0, 0, 0, prefix});
+    for (const TlsfAllocator::Move &move : moves)
+    {
+        TlsfAllocator::Move &last = regions.back();
+        if (last.from + last.size == move.from && last.to + last.size == move.to)
+        {
+            last.size += move.size; // contiguous before and after, one copy
+        }
+        else
+        {
+            regions.push_back(move);
+        }
+    }
+
+    D3D11_BUFFER_DESC desc = {};
+    source->GetDesc(&desc);
+    for (const TlsfAllocator::Move &region : regions)
+    {
+        D3D11_BOX box = {};
+        box.left = region.from * stride;
+        box.right = static_cast<UINT>(std::min<uint64_t>((static_cast<uint64_t>(region.from) + region.size) * stride, desc.ByteWidth));
+        box.bottom = 1;
+        box.back = 1;
+        if (box.right > box.left)
+        {
+            deviceContext->CopySubresourceRegion(target, 0, region.to * stride, 0, 0, source, 0, &box);
+        }
+    }
+}
+
+uint32_t GeometryPool::createArena(ID3D11Device *device, UINT vertexStride, DXGI_FORMAT indexFormat, bool hasPositions, uint32_t minVertices, uint32_t minIndices)
+{
+    UINT indexStride = indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
+    uint32_t vertexCapacity = std::max(static_cast<uint32_t>(VERTEX_ARENA_BYTES / vertexStride), std::max(minVertices, 1u));
+    uint32_t indexCapacity = std::max(static_cast<uint32_t>(INDEX_ARENA_BYTES / indexStride), std::max(minIndices, 1u));
+
+    auto arena = std::make_unique<Arena>(vertexStride, indexFormat, hasPositions, vertexCapacity, indexCapacity);
+    createBuffer(device, D3D11_BIND_VERTEX_BUFFER, static_cast<size_t>(vertexCapacity) * vertexStride, arena->vertexBuffer.GetAddressOf());
+    createBuffer(device, D3D11_BIND_INDEX_BUFFER, static_cast<size_t>(indexCapacity) * indexStride, arena->indexBuffer.GetAddressOf());
+    if (hasPositions)
+    {
+        createBuffer(device, D3D11_BIND_VERTEX_BUFFER, static_cast<size_t>(vertexCapacity) * sizeof(PositionVertex), arena->positionBuffer.GetAddressOf());
+    }
+
+    m_arenas.push_back(std::move(arena));
+    Logger::Log(Logger::LogLevel::INFO, "GeometryPool::createArena: arena {}: {} vertices ({} B stride{}), {} indices ({}-bit)",
+                m_arenas.size() - 1, vertexCapacity, vertexStride, hasPositions ? ", position stream" : "", indexCapacity, indexStride * 8);
+    return static_cast<uint32_t>(m_arenas.size() - 1);
+}
+
+uint32_t GeometryPool::allocate(ID3D11Device *device, UINT vertexStride, DXGI_FORMAT indexFormat, const void *vertices, uint32_t vertexCount,
+                                const void *positions, const void *indices, uint32_t indexCount)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Allocation allocation;
+    allocation.vertexCount = vertexCount;
+    allocation.indexCount = indexCount;
+
+    bool hasPositions = positions != nullptr;
+    auto tryArena = [&](uint32_t arenaIndex)
+    {
+        Arena &arena = *m_arenas[arenaIndex];
+        if (arena.vertexStride != vertexStride || arena.indexFormat != indexFormat || arena.hasPositions != hasPositions)
+        {
+            return false;
+        }
+        uint32_t vertexHandle = arena.vertexAllocator.allocate(vertexCount);
+        if (vertexHandle == TlsfAllocator::INVALID_HANDLE)
+        {
+            return false;
+        }
+        uint32_t indexHandle = arena.indexAllocator.allocate(indexCount);
+        if (indexHandle == TlsfAllocator::INVALID_HANDLE)
+        {
+            arena.vertexAllocator.free(vertexHandle);
+            return false;
+        }
+        allocation.arena = arenaIndex;
+        allocation.vertexHandle = vertexHandle;
+        allocation.indexHandle = indexHandle;
+        return true;
+    };
+
+    bool isAllocated = false;
+    for (uint32_t arenaIndex = 0; arenaIndex < m_arenas.size() && !isAllocated; ++arenaIndex)
+    {
+        isAllocated = tryArena(arenaIndex);
+    }
+    if (!isAllocated && !tryArena(createArena(device, vertexStride, indexFormat, hasPositions, vertexCount, indexCount)))
+    {
+        throw std::runtime_error("GeometryPool::allocate: a fresh arena could not hold the mesh");
+    }
+
+    Arena &arena = *m_arenas[allocation.arena];
+    allocation.baseVertex = arena.vertexAllocator.getOffset(allocation.vertexHandle);
+    allocation.firstIndex = arena.indexAllocator.getOffset(allocation.indexHandle);
+
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext;
+    device->GetImmediateContext(deviceContext.GetAddressOf());
+    UINT indexStride = indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
+    upload(deviceContext.Get(), arena.vertexBuffer.Get(), static_cast<size_t>(allocation.baseVertex) * vertexStride, vertices, static_cast<size_t>(vertexCount) * vertexStride);
+    upload(deviceContext.Get(), arena.indexBuffer.Get(), static_cast<size_t>(allocation.firstIndex) * indexStride, indices, static_cast<size_t>(indexCount) * indexStride);
+    if (hasPositions)
+    {
+        upload(deviceContext.Get(), arena.positionBuffer.Get(), static_cast<size_t>(allocation.baseVertex) * sizeof(PositionVertex), positions, static_cast<size_t>(vertexCount) * sizeof(PositionVertex));
+    }
+
+    uint32_t handle;
+    if (!m_unusedAllocations.empty())
+    {
+        handle = m_unusedAllocations.back();
+        m_unusedAllocations.pop_back();
+        m_allocations[handle] = allocation;
+    }
+    else
+    {
+        handle = static_cast<uint32_t>(m_allocations.size());
+        m_allocations.push_back(allocation);
+    }
+    return handle;
+}
+
+void GeometryPool::free(uint32_t handle)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Allocation &allocation = m_allocations[handle];
+    Arena &arena = *m_arenas[allocation.arena];
+    arena.vertexAllocator.free(allocation.vertexHandle);
+    arena.indexAllocator.free(allocation.indexHandle);
+    allocation = Allocation();
+    m_unusedAllocations.push_back(handle);
+}
+
+GeometryPool::Allocation GeometryPool::getAllocation(uint32_t handle) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocations[handle];
+}
+
+void GeometryPool::bind(ID3D11DeviceContext *deviceContext, uint32_t handle, D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    uint32_t arenaIndex = m_allocations[handle].arena;
+    if (arenaIndex != m_boundArena || m_boundPositions)
+    {
+        const Arena &arena = *m_arenas[arenaIndex];
+        UINT stride = arena.vertexStride;
+        UINT offset = 0;
+        deviceContext->IASetVertexBuffers(0, 1, arena.vertexBuffer.GetAddressOf(), &stride, &offset);
+        deviceContext->IASetIndexBuffer(arena.indexBuffer.Get(), arena.indexFormat, 0);
+        m_boundArena = arenaIndex;
+        m_boundPositions = false;
+    }
+    if (topology != m_boundTopology)
+    {
+        deviceContext->IASetPrimitiveTopology(topology);
+        m_boundTopology = topology;
+    }
+}
+
+void GeometryPool::bindPositionOnly(ID3D11DeviceContext *deviceContext, uint32_t handle, D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+    uint32_t arenaIndex = m_allocations[handle].arena;
+    const Arena &arena = *m_arenas[arenaIndex];
+    if (!arena.positionBuffer)
+    {
+        throw std::runtime_error("GeometryPool::bindPositionOnly: the allocation has no position stream");
+    }
+    if (arenaIndex != m_boundArena || !m_boundPositions)
+    {
+        UINT stride = sizeof(PositionVertex);
+        UINT offset = 0;
+        deviceContext->IASetVertexBuffers(0, 1, arena.positionBuffer.GetAddressOf(), &stride, &offset);
+        deviceContext->IASetIndexBuffer(arena.indexBuffer.Get(), arena.indexFormat, 0);
+        m_boundArena = arenaIndex;
+        m_boundPositions = true;
+    }
+    if (topology != m_boundTopology)
+    {
+        deviceContext->IASetPrimitiveTopology(topology);
+        m_boundTopology = topology;
+    }
+}
+
+void GeometryPool::invalidateBindings()
+{
+    m_boundArena = INVALID_HANDLE;
+    m_boundPositions = false;
+    m_boundTopology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+}
+
+void GeometryPool::compact(ID3D11Device *device, ID3D11DeviceContext *deviceContext, float minFragmentation)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (uint32_t arenaIndex = 0; arenaIndex < m_arenas.size(); ++arenaIndex)
+    {
+        Arena &arena = *m_arenas[arenaIndex];
+        TlsfAllocator::Stats vertexStats = arena.vertexAllocator.getStats();
+        TlsfAllocator::Stats indexStats = arena.indexAllocator.getStats();
+        if (vertexStats.fragmentation < minFragmentation && indexStats.fragmentation < minFragmentation)
+        {
+            continue;
+        }
+
+        // GPU copies cannot overlap inside one buffer, so the live ranges go to fresh buffers
+        UINT indexStride = arena.indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
+        Microsoft::WRL::ComPtr<ID3D11Buffer> vertexBuffer, positionBuffer, indexBuffer;
+        createBuffer(device, D3D11_BIND_VERTEX_BUFFER, static_cast<size_t>(vertexStats.capacity) * arena.vertexStride, vertexBuffer.GetAddressOf());
+        createBuffer(device, D3D11_BIND_INDEX_BUFFER, static_cast<size_t>(indexStats.capacity) * indexStride, indexBuffer.GetAddressOf());
+        if (arena.hasPositions)
+        {
+            createBuffer(device, D3D11_BIND_VERTEX_BUFFER, static_cast<size_t>(vertexStats.capacity) * sizeof(PositionVertex), positionBuffer.GetAddressOf());
+        }
+
+        std::vector<TlsfAllocator::Move> vertexMoves = arena.vertexAllocator.compact();
+        std::vector<TlsfAllocator::Move> indexMoves = arena.indexAllocator.compact();
+        copy(deviceContext, vertexBuffer.Get(), arena.vertexBuffer.Get(), vertexMoves, arena.vertexStride);
+        copy(deviceContext, indexBuffer.Get(), arena.indexBuffer.Get(), indexMoves, indexStride);
+        if (arena.hasPositions)
+        {
+            copy(deviceContext, positionBuffer.Get(), arena.positionBuffer.Get(), vertexMoves, sizeof(PositionVertex));
+        }
+        arena.vertexBuffer = vertexBuffer;
+        arena.indexBuffer = indexBuffer;
+        arena.positionBuffer = positionBuffer;
+
+        for (Allocation &allocation : m_allocations)
+        {
+            if (allocation.arena == arenaIndex)
+            {
+                allocation.baseVertex = arena.vertexAllocator.getOffset(allocation.vertexHandle);
+                allocation.firstIndex = arena.indexAllocator.getOffset(allocation.indexHandle);
+            }
+        }
+
+        Logger::Log(Logger::LogLevel::INFO, "GeometryPool::compact: arena {}: moved {} vertex and {} index ranges, fragmentation {:.2f} / {:.2f} -> 0",
+                    arenaIndex, vertexMoves.size(), indexMoves.size(), vertexStats.fragmentation, indexStats.fragmentation);
+    }
+    invalidateBindings();
+}
+
+void GeometryPool::logStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (size_t arenaIndex = 0; arenaIndex < m_arenas.size(); ++arenaIndex)
+    {
+        const Arena &arena = *m_arenas[arenaIndex];
+        TlsfAllocator::Stats vertexStats = arena.vertexAllocator.getStats();
+        TlsfAllocator::Stats indexStats = arena.indexAllocator.getStats();
+        Logger::Log(Logger::LogLevel::INFO, "GeometryPool::logStats: arena {}: {} meshes, vertices {}/{} ({} B stride), indices {}/{} ({}-bit), fragmentation {:.2f} / {:.2f}",
+                    arenaIndex, vertexStats.allocationCount, vertexStats.usedSize, vertexStats.capacity, arena.vertexStride,
+                    indexStats.usedSize, indexStats.capacity, arena.indexFormat == DXGI_FORMAT_R16_UINT ? 16 : 32,
+                    vertexStats.fragmentation, indexStats.fragmentation);
+    }
+}
@@ -0,0 +1,605 @@
+#include "resources/glb_parser.h"
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint32_t MODE_TRIANGLES = 4;
+    constexpr int MAX_JSON_DEPTH = 64;
+
+    // Just enough JSON for the glTF scene description, objects keep their keys in order
+    struct JsonValue
+    {
+        enum class Type
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object,
+        };
+
+        Type type = Type::Null;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<std::string> keys; // Object
+        std::vector<JsonValue> items;  // Array elements or Object values
+
+        const JsonValue *find(const char *key) const
+        {
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                if (keys[i] == key)
+                {
+                    return &items[i];
+                }
+            }
+            return nullptr;
+        }
+
+        const JsonValue *at(size_t index) const { return type == Type::Array && index < items.size() ? &items[index] : nullptr; }
+
+        int64_t getInt(const char *key, int64_t fallback) const
+        {
+            const JsonValue *value = find(key);
+            return value && value->type == Type::Number ? static_cast<int64_t>(value->number) : fallback;
+        }
+
+        std::string getString(const char *key) const
+        {
+            const JsonValue *value = find(key);
+            return value && value->type == Type::String ? value->string : std::string();
+        }
+    };
+
+    class JsonReader
+    {
+    public:
+        JsonReader(const char *begin, const char *end) : m_p(begin), m_end(end) {}
+
+        JsonValue parseDocument()
+        {
+            JsonValue value = parseValue(0);
+            skipSpaces();
+            if (m_p != m_end)
+            {
+                fail("trailing characters");
+            }
+            return value;
+        }
+
+    private:
+        [[noreturn]] void fail(const char *message) const
+        {
+            throw std::runtime_error(std::string("GlbParser::parse: invalid JSON, ") + message);
+        }
+
+        void skipSpaces()
+        {
+            // the JSON chunk is padded with spaces, NUL is tolerated for broken exporters
+            while (m_p < m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r' || *m_p == '\0'))
+            {
+                ++m_p;
+            }
+        }
+
+        bool consume(char c)
+        {
+            skipSpaces();
+            if (m_p < m_end && *m_p == c)
+            {
+                ++m_p;
+                return true;
+            }
+            return false;
+        }
+
+        void expectLiteral(const char *literal)
+        {
+            size_t length = std::strlen(literal);
+            if (static_cast<size_t>(m_end - m_p) < length || std::memcmp(m_p, literal, length) != 0)
+            {
+                fail("unknown literal");
+            }
+            m_p += length;
+        }
+
+        JsonValue parseValue(int depth)
+        {
+            if (depth > MAX_JSON_DEPTH)
+            {
+                fail("nested too deep");
+            }
+            skipSpaces();
+            if (m_p >= m_end)
+            {
+                fail("unexpected end");
+            }
+
+            JsonValue value;
+            switch (*m_p)
+            {
+            case '{':
+                ++m_p;
+                value.type = JsonValue::Type::Object;
+                if (consume('}'))
+                {
+                    break;
+                }
+                do
+                {
+                    skipSpaces();
+                    if (m_p >= m_end || *m_p != '"')
+                    {
+                        fail("expected a key");
+                    }
+                    value.keys.push_back(parseString());
+                    if (!consume(':'))
+                    {
+                        fail("expected ':'");
+                    }
+                    value.items.push_back(parseValue(depth + 1));
+                } while (consume(','));
+                if (!consume('}'))
+                {
+                    fail("expected '}'");
+                }
+                break;
+            case '[':
+                ++m_p;
+                value.type = JsonValue::Type::Array;
+                if (consume(']'))
+                {
+                    break;
+                }
+                do
+                {
+                    value.items.push_back(parseValue(depth + 1));
+                } while (consume(','));
+                if (!consume(']'))
+                {
+                    fail("expected ']'");
+                }
+                break;
+            case '"':
+                value.type = JsonValue::Type::String;
+                value.string = parseString();
+                break;
+            case 't':
+                expectLiteral("true");
+                value.type = JsonValue::Type::Bool;
+                value.boolean = true;
+                break;
+            case 'f':
+                expectLiteral("false");
+                value.type = JsonValue::Type::Bool;
+                break;
+            case 'n':
+                expectLiteral("null");
+                break;
+            default:
+            {
+                value.type = JsonValue::Type::Number;
+                auto [next, ec] = std::from_chars(m_p, m_end, value.number);
+                if (ec != std::errc())
+                {
+                    fail("bad number");
+                }
+                m_p = next;
+                break;
+            }
+            }
+            return value;
+        }
+
+        uint32_t parseHex4()
+        {
+            if (m_end - m_p < 4)
+            {
+                fail("bad \\u escape");
+            }
+            uint32_t code = 0;
+            auto [next, ec] = std::from_chars(m_p, m_p + 4, code, 16);
+            if (ec != std::errc() || next != m_p + 4)
+            {
+                fail("bad \\u escape");
+            }
+            m_p += 4;
+            return code;
+        }
+
+        static void appendUtf8(std::string &out, uint32_t code)
+        {
+            if (code < 0x80)
+            {
+                out += static_cast<char>(code);
+            }
+            else if (code < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (code >> 6));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else if (code < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (code >> 12));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                out += static_cast<char>(0xF0 | (code >> 18));
+                out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+
+        std::string parseString()
+        {
+            ++m_p; // opening quote
+            std::string out;
+            while (m_p < m_end && *m_p != '"')
+            {
+                char c = *m_p++;
+                if (c != '\\')
+                {
+                    out += c;
+                    continue;
+                }
+                if (m_p >= m_end)
+                {
+                    break;
+                }
+                char escape = *m_p++;
+                switch (escape)
+                {
+                case 'b':
+                    out += '\b';
+                    break;
+                case 'f':
+                    out += '\f';
+                    break;
+                case 'n':
+                    out += '\n';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'u':
+                {
+                    uint32_t code = parseHex4();
+                    if (code >= 0xD800 && code < 0xDC00 && m_end - m_p >= 6 && m_p[0] == '\\' && m_p[1] == 'u')
+                    {
+                        m_p += 2;
+                        uint32_t low = parseHex4();
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default: // " \ /
+                    out += escape;
+                    break;
+                }
+            }
+            if (m_p >= m_end)
+            {
+                fail("unterminated string");
+            }
+            ++m_p; // closing quote
+            return out;
+        }
+
+        const char *m_p;
+        const char *m_end;
+    };
+
+    inline uint32_t readU32(const char *p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    size_t getComponentSize(uint32_t componentType)
+    {
+        switch (componentType)
+        {
+        case GlbParser::Byte:
+        case GlbParser::UnsignedByte:
+            return 1;
+        case GlbParser::Short:
+        case GlbParser::UnsignedShort:
+            return 2;
+        case GlbParser::UnsignedInt:
+        case GlbParser::Float:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    uint32_t getComponentCount(const std::string &type)
+    {
+        if (type == "SCALAR")
+        {
+            return 1;
+        }
+        if (type.size() == 4 && type.compare(0, 3, "VEC") == 0 && type[3] >= '2' && type[3] <= '4')
+        {
+            return static_cast<uint32_t>(type[3] - '0');
+        }
+        return 0; // matrices are never vertex attributes we read
+    }
+
+    GlbParser::Accessor resolveAccessor(const JsonValue &document, int64_t index, const char *bin, size_t binSize)
+    {
+        const JsonValue *accessors = document.find("accessors");
+        const JsonValue *accessor = accessors && index >= 0 ? accessors->at(static_cast<size_t>(index)) : nullptr;
+        if (!accessor)
+        {
+            throw std::runtime_error("GlbParser::parse: accessor " + std::to_string(index) + " does not exist");
+        }
+        if (accessor->find("sparse"))
+        {
+            throw std::runtime_error("GlbParser::parse: sparse accessors are not supported");
+        }
+
+        const JsonValue *bufferViews = document.find("bufferViews");
+        int64_t viewIndex = accessor->getInt("bufferView", -1);
+        const JsonValue *view = bufferViews && viewIndex >= 0 ? bufferViews->at(static_cast<size_t>(viewIndex)) : nullptr;
+        if (!view || view->getInt("buffer", -1) != 0 || !bin)
+        {
+            throw std::runtime_error("GlbParser::parse: accessor " + std::to_string(index) + " is not stored in the BIN chunk");
+        }
+
+        GlbParser::Accessor result;
+        result.componentType = static_cast<uint32_t>(accessor->getInt("componentType", 0));
+        result.componentCount = getComponentCount(accessor->getString("type"));
+        result.count = static_cast<size_t>(std::max<int64_t>(accessor->getInt("count", 0), 0));
+        const JsonValue *normalized = accessor->find("normalized");
+        result.normalized = normalized && normalized->boolean;
+
+        size_t elementSize = getComponentSize(result.componentType) * result.componentCount;
+        int64_t viewOffset = view->getInt("byteOffset", 0);
+        int64_t viewLength = view->getInt("byteLength", 0);
+        int64_t offset = accessor->getInt("byteOffset", 0);
+        result.stride = static_cast<size_t>(view->getInt("byteStride", static_cast<int64_t>(elementSize)));
+        if (elementSize == 0 || result.stride < elementSize || viewOffset < 0 || viewLength < 0 || offset < 0 ||
+            static_cast<uint64_t>(viewOffset + viewLength) > binSize ||
+            (result.count > 0 && static_cast<uint64_t>(offset) + (result.count - 1) * result.stride + elementSize > static_cast<uint64_t>(viewLength)))
+        {
+            throw std::runtime_error("GlbParser::parse: accessor " + std::to_string(index) + " is out of its buffer view");
+        }
+        result.data = reinterpret_cast<const uint8_t *>(bin + viewOffset + offset);
+        return result;
+    }
+
+    inline bool isFloat3(const GlbParser::Accessor &accessor)
+    {
+        return accessor.componentType == GlbParser::Float && accessor.componentCount == 3;
+    }
+
+    inline float readTexCoord(const uint8_t *p, uint32_t componentType)
+    {
+        switch (componentType)
+        {
+        case GlbParser::UnsignedByte:
+            return *p / 255.f;
+        case GlbParser::UnsignedShort:
+        {
+            uint16_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value / 65535.f;
+        }
+        default:
+        {
+            float value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+        }
+    }
+}
+
+GlbParser::Result GlbParser::parse(const char *data, size_t size)
+{
+    if (size < 20 || readU32(data) != MAGIC)
+    {
+        throw std::runtime_error("GlbParser::parse: not a binary glTF file");
+    }
+    if (readU32(data + 4) != 2)
+    {
+        throw std::runtime_error("GlbParser::parse: only glTF 2.0 is supported");
+    }
+    size_t length = std::min<size_t>(readU32(data + 8), size);
+
+    // JSON chunk first, then an optional BIN chunk, both 4-byte aligned
+    size_t jsonLength = readU32(data + 12);
+    if (readU32(data + 16) != CHUNK_JSON || 20 + jsonLength > length)
+    {
+        throw std::runtime_error("GlbParser::parse: missing JSON chunk");
+    }
+    const char *json = data + 20;
+
+    const char *bin = nullptr;
+    size_t binSize = 0;
+    size_t binHeader = 20 + ((jsonLength + 3) & ~size_t(3));
+    if (binHeader + 8 <= length && readU32(data + binHeader + 4) == CHUNK_BIN)
+    {
+        binSize = readU32(data + binHeader);
+        bin = data + binHeader + 8;
+        if (binHeader + 8 + binSize > length)
+        {
+            throw std::runtime_error("GlbParser::parse: BIN chunk is truncated");
+        }
+    }
+
+    JsonValue document = JsonReader(json, json + jsonLength).parseDocument();
+    if (const JsonValue *required = document.find("extensionsRequired"); required && !required->items.empty())
+    {
+        // KHR_draco_mesh_compression, EXT_meshopt_compression, ... would need their decoders
+        throw std::runtime_error("GlbParser::parse: required extension " + required->items[0].string + " is not supported");
+    }
+
+    Result result;
+    const JsonValue *meshes = document.find("meshes");
+    if (!meshes)
+    {
+        return result;
+    }
+    for (const JsonValue &mesh : meshes->items)
+    {
+        const JsonValue *primitives = mesh.find("primitives");
+        if (!primitives)
+        {
+            continue;
+        }
+        for (const JsonValue &primitive : primitives->items)
+        {
+            std::string meshName = mesh.getString("name");
+            if (primitive.getInt("mode", MODE_TRIANGLES) != MODE_TRIANGLES)
+            {
+                Logger::Log(Logger::LogLevel::WARNING, "GlbParser::parse: {}: skipped a primitive that is not a triangle list", meshName);
+                continue;
+            }
+            const JsonValue *attributes = primitive.find("attributes");
+            if (!attributes || !attributes->find("POSITION"))
+            {
+                throw std::runtime_error("GlbParser::parse: " + meshName + ": primitive without POSITION");
+            }
+
+            Primitive out;
+            out.meshName = meshName;
+            out.material = static_cast<int>(primitive.getInt("material", -1));
+            out.positions = resolveAccessor(document, attributes->getInt("POSITION", -1), bin, binSize);
+            if (attributes->find("NORMAL"))
+            {
+                out.normals = resolveAccessor(document, attributes->getInt("NORMAL", -1), bin, binSize);
+            }
+            if (attributes->find("TEXCOORD_0"))
+            {
+                out.texCoords = resolveAccessor(document, attributes->getInt("TEXCOORD_0", -1), bin, binSize);
+            }
+            if (primitive.find("indices"))
+            {
+                out.indices = resolveAccessor(document, primitive.getInt("indices", -1), bin, binSize);
+            }
+
+            size_t vertexCount = out.positions.count;
+            bool texCoordsValid = out.texCoords.componentCount == 2 &&
+                                  (out.texCoords.componentType == Float || (out.texCoords.normalized && (out.texCoords.componentType == UnsignedByte || out.texCoords.componentType == UnsignedShort)));
+            bool indicesValid = out.indices.componentCount == 1 &&
+                                (out.indices.componentType == UnsignedByte || out.indices.componentType == UnsignedShort || out.indices.componentType == UnsignedInt);
+            if (!isFloat3(out.positions) || (out.normals.data && (!isFloat3(out.normals) || out.normals.count != vertexCount)) ||
+                (out.texCoords.data && (!texCoordsValid || out.texCoords.count != vertexCount)) || (out.indices.data && !indicesValid))
+            {
+                throw std::runtime_error("GlbParser::parse: " + meshName + ": unsupported attribute formats (quantized meshes are not supported)");
+            }
+            result.primitives.push_back(std::move(out));
+        }
+    }
+    return result;
+}
+
+bool GlbParser::matchesVertexLayout(const Primitive &primitive)
+{
+    const Accessor &positions = primitive.positions;
+    return positions.stride == sizeof(Vertex) &&
+           primitive.normals.data == positions.data + offsetof(Vertex, n) && primitive.normals.stride == sizeof(Vertex) &&
+           primitive.texCoords.data == positions.data + offsetof(Vertex, uv) && primitive.texCoords.stride == sizeof(Vertex) &&
+           primitive.texCoords.componentType == Float && reinterpret_cast<uintptr_t>(positions.data) % alignof(Vertex) == 0;
+}
+
+void GlbParser::readVertices(const Primitive &primitive, std::vector<Vertex> &vertices)
+{
+    const Accessor &positions = primitive.positions;
+    const Accessor &normals = primitive.normals;
+    const Accessor &texCoords = primitive.texCoords;
+    size_t count = positions.count;
+
+    if (matchesVertexLayout(primitive))
+    {
+        // already our layout: block copy, then flip z in place
+        const Vertex *source = reinterpret_cast<const Vertex *>(positions.data);
+        vertices.assign(source, source + count);
+        for (Vertex &vertex : vertices)
+        {
+            vertex.pos.z = -vertex.pos.z;
+            vertex.n.z = -vertex.n.z;
+        }
+        return;
+    }
+
+    const DirectX::XMVECTOR flipZ = DirectX::XMVectorSet(1.f, 1.f, -1.f, 1.f);
+    vertices.clear();
+    vertices.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        DirectX::XMFLOAT3 pos, normal(0.f, 0.f, 0.f);
+        DirectX::XMFLOAT2 uv(0.f, 0.f);
+
+        std::memcpy(&pos, positions.data + i * positions.stride, sizeof(pos));
+        DirectX::XMStoreFloat3(&pos, DirectX::XMVectorMultiply(DirectX::XMLoadFloat3(&pos), flipZ));
+        if (normals.data)
+        {
+            std::memcpy(&normal, normals.data + i * normals.stride, sizeof(normal));
+            DirectX::XMStoreFloat3(&normal, DirectX::XMVectorMultiply(DirectX::XMLoadFloat3(&normal), flipZ));
+        }
+        if (texCoords.data)
+        {
+            const uint8_t *p = texCoords.data + i * texCoords.stride;
+            size_t componentSize = getComponentSize(texCoords.componentType);
+            uv = DirectX::XMFLOAT2(readTexCoord(p, texCoords.componentType), readTexCoord(p + componentSize, texCoords.componentType));
+        }
+        vertices.push_back({pos, normal, uv});
+    }
+}
+
+void GlbParser::readIndices(const Primitive &primitive, std::vector<uint32_t> &indices)
+{
+    const Accessor &source = primitive.indices;
+    size_t vertexCount = primitive.positions.count;
+    if (!source.data)
+    {
+        indices.resize(vertexCount - vertexCount % 3);
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            indices[i] = static_cast<uint32_t>(i);
+        }
+        return;
+    }
+
+    indices.resize(source.count - source.count % 3);
+    if (source.componentType == UnsignedInt && source.stride == sizeof(uint32_t))
+    {
+        std::memcpy(indices.data(), source.data, indices.size() * sizeof(uint32_t));
+    }
+    else
+    {
+        size_t componentSize = getComponentSize(source.componentType);
+        for (size_t i = 0; i < indices.size(); ++i)
+        {
+            const uint8_t *p = source.data + i * source.stride;
+            uint32_t value = 0;
+            std::memcpy(&value, p, componentSize); // little endian
+            indices[i] = value;
+        }
+    }
+
+    for (uint32_t index : indices)
+    {
+        if (index >= vertexCount)
+        {
+            throw std::runtime_error("GlbParser::readIndices: " + primitive.meshName + ": index out of the vertex range");
+        }
+    }
+}
@@ -5,10 +5,11 @@ LambertianMaterial::LambertianMaterial(ID3D11Device *device, std::shared_ptr<Sha
 {
     MaterialBuffer materialData;
     materialData.albedo = albedo;
+    materialData.uvScaleBias = DirectX::XMFLOAT4(1.f, 1.f, 0.f, 0.f);
     materialData.useTexture = 0;
-    materialData.padding[0] = 0;
-    materialData.padding[1] = 0;
-    materialData.padding[2] = 0;
+    materialData.textureSlice = 0;
+    materialData.isAtlas = 0;
+    materialData.padding = 0;
 
     D3D11_BUFFER_DESC bufferDesc = {};
     bufferDesc.ByteWidth = sizeof(MaterialBuffer);
@@ -29,16 +30,25 @@ LambertianMaterial::LambertianMaterial(ID3D11Device *device, std::shared_ptr<Sha
 }
 
 LambertianMaterial::LambertianMaterial(ID3D11Device *device, std::shared_ptr<Shader> shader, const std::string &albedoPath)
-    : m_shader(shader)
+    : LambertianMaterial(device, shader, std::make_shared<ImageTexture>(device, albedoPath))
 {
-    m_albedoTexture = std::make_shared<ImageTexture>(device, albedoPath);
+}
+
+LambertianMaterial::LambertianMaterial(ID3D11Device *device, std::shared_ptr<Shader> shader, std::shared_ptr<TextureBase> albedoTexture)
+    : LambertianMaterial(device, shader, TextureRef{albedoTexture})
+{
+}
 
+LambertianMaterial::LambertianMaterial(ID3D11Device *device, std::shared_ptr<Shader> shader, const TextureRef &albedoTexture)
+    : m_shader(shader), m_albedoTexture(albedoTexture.texture)
+{
     MaterialBuffer materialData;
     materialData.albedo = DirectX::XMFLOAT4(1.f, 0.0f, 1.0f, 1.0f);
+    materialData.uvScaleBias = albedoTexture.uvScaleBias;
     materialData.useTexture = 1;
-    materialData.padding[0] = 0;
-    materialData.padding[1] = 0;
-    materialData.padding[2] = 0;
+    materialData.textureSlice = static_cast<int>(albedoTexture.slice);
+    materialData.isAtlas = albedoTexture.isAtlas ? 1 : 0;
+    materialData.padding = 0;
 
     D3D11_BUFFER_DESC bufferDesc = {};
     bufferDesc.ByteWidth = sizeof(MaterialBuffer);
@@ -68,13 +78,21 @@ void LambertianMaterial::bind(ID3D11DeviceContext *deviceContext) const
     // bind constant buffer to slot 2 (matches register(b2))
     deviceContext->PSSetConstantBuffers(2, 1, m_constantBuffer.GetAddressOf());
 
-    // bind albedo texture to slot 2 if available (matches register(t2))
+    // bind albedo texture to slot 2 if available (matches register(t2)), skipped when a packed array is already there
     if (m_albedoTexture)
     {
         m_albedoTexture->bind(deviceContext, 2);
     }
 }
 
+void LambertianMaterial::requestDetail(float screenSize) const
+{
+    if (m_albedoTexture)
+    {
+        m_albedoTexture->requestDetail(screenSize);
+    }
+}
+
 void LambertianMaterial::setProperty(const std::string &name, const void *data, size_t size)
 {
     if (name == "albedo" && size == sizeof(DirectX::XMFLOAT4))
@@ -1,151 +1,751 @@
 #include "resources/vertex.h"
 #include "resources/mesh.h"
-#include <fstream>
-#include <sstream>
+#include "resources/obj_parser.h"
+#include "resources/glb_parser.h"
+#include "resources/geometry_pool.h"
+#include "resources/mesh_optimizer.h"
+#include "resources/mesh_cache.h"
+#include "resources/mesh_simplifier.h"
+#include "resources/meshlet.h"
+#include "resources/vertex_codec.h"
+#include "resources/buffer_type.h"
+#include "utils/mapped_file.h"
+#include "utils/hash.h"
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <filesystem>
+#include <mutex>
+#include <unordered_set>
 
-Mesh::Mesh(ID3D11Device *device, const std::string &filepath, const std::string &name)
-    : m_name(name), m_primitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+namespace
 {
-    loadFromOBJ(filepath);
-    initBuffers(device, m_vertices, m_indices);
+    // live meshes for the memory report
+    std::mutex s_registryMutex;
+    std::unordered_set<const Mesh *> s_registry;
+
+    const char *getResidencyName(MeshResidency residency)
+    {
+        switch (residency)
+        {
+        case MeshResidency::Keep:
+            return "keep";
+        case MeshResidency::Discard:
+            return "discard";
+        case MeshResidency::PositionsOnly:
+            return "positions";
+        default:
+            return "default";
+        }
+    }
+
+    bool isGlbPath(const std::string &filepath)
+    {
+        std::string extension = std::filesystem::path(filepath).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        return extension == ".glb";
+    }
+
+    uint64_t hashGeometry(const Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount)
+    {
+        return hashBytes(indices, indexCount * sizeof(uint32_t), hashBytes(vertices, vertexCount * sizeof(Vertex)));
+    }
+}
+
+std::atomic<MeshResidency> Mesh::s_defaultResidency = MeshResidency::Keep;
+
+Mesh::Mesh(ID3D11Device *device, const std::string &filepath, const std::string &name, const MeshOptions &options, uint32_t primitive)
+    : Mesh(filepath, name, options, primitive)
+{
+    upload(device);
+}
+
+Mesh::Mesh(const std::string &filepath, const std::string &name, const MeshOptions &options, uint32_t primitive)
+    : m_name(name), m_sourcePath(filepath), m_sourcePrimitive(primitive), m_options(options), m_bounds(), m_vertexStride(0), m_indexFormat(DXGI_FORMAT_R32_UINT), m_primitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+{
+    if (m_options.useCache && mapCache(filepath))
+    {
+        return;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    cook(filepath);
+    m_prepareMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    if (m_options.useCache)
+    {
+        // written here, off the create step: the upload only reads what is cooked
+        MeshCache::save(m_sourcePath, m_sourcePrimitive, getOptionsKey(), m_prepareMs, m_bounds, m_lods, m_vertices, m_indices, m_meshlets);
+    }
+}
+
+std::shared_ptr<Mesh> Mesh::prepare(const std::string &filepath, const std::string &name, const MeshOptions &options, uint32_t primitive)
+{
+    return std::shared_ptr<Mesh>(new Mesh(filepath, name, options, primitive));
+}
+
+void Mesh::upload(ID3D11Device *device)
+{
+    if (m_isUploaded)
+    {
+        return;
+    }
+
+    if (m_pendingCache)
+    {
+        uploadFromCache(device);
+    }
+    else
+    {
+        initBuffers(device, m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size());
+    }
+    m_isUploaded = true;
+    releaseCpuData();
+    registerMesh(this);
 }
 
-Mesh::Mesh(ID3D11Device *device, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, const std::string &name)
-    : m_name(name), m_vertices(vertices), m_indices(indices), m_primitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+Mesh::Mesh(ID3D11Device *device, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, const std::string &name, const MeshOptions &options)
+    : Mesh(device, vertices, indices, {}, name, options) {}
+
+Mesh::Mesh(ID3D11Device *device, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, const std::vector<MeshLod> &lods, const std::string &name, const MeshOptions &options)
+    : m_name(name), m_options(options), m_vertices(vertices), m_indices(indices), m_lods(lods), m_bounds(), m_vertexStride(0), m_indexFormat(DXGI_FORMAT_R32_UINT), m_primitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
 {
-    initBuffers(device, vertices, indices);
+    // the weld drops collapsed triangles and rewrites the LOD ranges, check them once they are final
+    weldVertices();
+    for (const MeshLod &lod : m_lods)
+    {
+        if (static_cast<size_t>(lod.firstIndex) + lod.indexCount > m_indices.size() || lod.firstIndex % 3 != 0 || lod.indexCount % 3 != 0)
+        {
+            throw std::runtime_error("Mesh::Mesh: LOD range out of the index buffer: " + name);
+        }
+    }
+    optimize();
+    if (!m_vertices.empty())
+    {
+        m_bounds = MeshBounds::compute(&m_vertices[0].pos, m_vertices.size(), sizeof(Vertex));
+    }
+    buildLods();
+    buildMeshlets();
+    initBuffers(device, m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size());
+    m_isUploaded = true;
+    releaseCpuData();
+    registerMesh(this);
 }
 
 Mesh::~Mesh()
 {
+    unregisterMesh(this);
+    if (m_poolHandle != GeometryPool::INVALID_HANDLE)
+    {
+        GeometryPool::getInstance().free(m_poolHandle);
+    }
     m_vertexBuffer.Reset();
     m_indexBuffer.Reset();
+    m_positionBuffer.Reset();
+    m_meshBuffer.Reset();
 }
 
-const UINT Mesh::getIndicesCount() const { return static_cast<UINT>(m_indices.size()); }
+const UINT Mesh::getIndicesCount() const { return m_lods.empty() ? 0 : m_lods[0].indexCount; }
+
+const MeshBounds &Mesh::getBounds() const { return m_bounds; }
 
 void Mesh::setPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY primitiveTopology) { m_primitiveTopology = primitiveTopology; }
 
 void Mesh::loadFromOBJ(const std::string &filepath) // right-hand, ccw => left-hand, cw
 {
-    std::ifstream file(filepath);
-    if (!file.is_open())
+    std::unique_ptr<MappedFile> file;
+    try
+    {
+        file = std::make_unique<MappedFile>(filepath);
+    }
+    catch (const std::exception &)
     {
         throw std::runtime_error("Mesh::loadFromOBJ: Failed to open OBJ file: " + filepath);
     }
 
-    std::vector<DirectX::XMFLOAT3> positions = {{0.f, 0.f, 0.f}};
-    std::vector<DirectX::XMFLOAT3> normals = {{0.f, 0.f, 0.f}};
-    std::vector<DirectX::XMFLOAT2> texCoords = {{0.f, 0.f}};
-    m_vertices.clear();
-    m_indices.clear();
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    ObjParser::Result obj = ObjParser::parse(file->data(), file->end());
+
+    MeshOptimizer::IndexingStats stats = MeshOptimizer::indexCorners(obj, m_vertices, m_indices);
+
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    float sizeMB = static_cast<float>(file->size()) / (1024.f * 1024.f);
+    Logger::Log(Logger::LogLevel::INFO, "Mesh::loadFromOBJ: {} ({:.2f} MB) loaded in {:.2f} ms, {:.1f} MB/s",
+                filepath, sizeMB, elapsedMs, elapsedMs > 0.f ? sizeMB / (elapsedMs / 1000.f) : 0.f);
+    Logger::Log(Logger::LogLevel::INFO, "Mesh::loadFromOBJ: {}: indexed {} -> {} vertices, {:.1f} KB -> {:.1f} KB",
+                m_name, stats.vertexCountBefore, stats.vertexCountAfter, stats.bytesBefore / 1024.f, stats.bytesAfter / 1024.f);
+}
+
+std::vector<std::shared_ptr<Mesh>> Mesh::loadGLB(ID3D11Device *device, const std::string &filepath, const std::string &name, const MeshOptions &options)
+{
+    size_t primitiveCount = 0;
+    try
+    {
+        // only the JSON chunk is read, the primitives are cooked (or loaded from the cache) one by one
+        MappedFile file(filepath);
+        primitiveCount = GlbParser::parse(file.data(), file.size()).primitives.size();
+    }
+    catch (const std::exception &e)
+    {
+        throw std::runtime_error("Mesh::loadGLB: " + filepath + ": " + e.what());
+    }
+
+    std::vector<std::shared_ptr<Mesh>> meshes;
+    for (uint32_t primitive = 0; primitive < primitiveCount; ++primitive)
+    {
+        std::string primitiveName = primitiveCount > 1 ? name + "_" + std::to_string(primitive) : name;
+        meshes.push_back(std::make_shared<Mesh>(device, filepath, primitiveName, options, primitive));
+    }
+    return meshes;
+}
+
+void Mesh::loadFromGLB(const std::string &filepath, uint32_t primitive)
+{
+    std::unique_ptr<MappedFile> file;
+    try
+    {
+        file = std::make_unique<MappedFile>(filepath);
+    }
+    catch (const std::exception &)
+    {
+        throw std::runtime_error("Mesh::loadFromGLB: Failed to open glTF file: " + filepath);
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    GlbParser::Result glb = GlbParser::parse(file->data(), file->size());
+    if (primitive >= glb.primitives.size())
+    {
+        throw std::runtime_error("Mesh::loadFromGLB: " + filepath + " has no primitive " + std::to_string(primitive));
+    }
+    const GlbParser::Primitive &source = glb.primitives[primitive];
+    GlbParser::readVertices(source, m_vertices);
+    GlbParser::readIndices(source, m_indices);
+
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    float sizeMB = static_cast<float>(file->size()) / (1024.f * 1024.f);
+    Logger::Log(Logger::LogLevel::INFO, "Mesh::loadFromGLB: {} ({:.2f} MB) primitive {} loaded in {:.2f} ms, {} vertices, {} triangles ({})",
+                filepath, sizeMB, primitive, elapsedMs, m_vertices.size(), m_indices.size() / 3,
+                GlbParser::matchesVertexLayout(source) ? "block copy" : "converted");
+}
+
+void Mesh::cook(const std::string &filepath)
+{
+    if (isGlbPath(filepath))
+    {
+        loadFromGLB(filepath, m_sourcePrimitive);
+    }
+    else
+    {
+        loadFromOBJ(filepath);
+    }
+    weldVertices();
+    optimize();
+    if (!m_vertices.empty())
+    {
+        m_bounds = MeshBounds::compute(&m_vertices[0].pos, m_vertices.size(), sizeof(Vertex));
+    }
+    buildLods();
+    buildMeshlets();
+}
+
+bool Mesh::mapCache(const std::string &filepath)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    auto cached = std::make_unique<MeshCache::CachedMesh>();
+    if (!MeshCache::load(filepath, m_sourcePrimitive, getOptionsKey(), *cached))
+    {
+        return false;
+    }
+    m_bounds = cached->header->bounds;
+    m_lods.assign(cached->header->lods, cached->header->lods + cached->header->lodCount);
+    m_meshlets.assign(cached->meshlets, cached->meshlets + cached->header->meshletCount);
+    m_pendingCache = std::move(cached);
+    m_prepareMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    return true;
+}
+
+void Mesh::uploadFromCache(ID3D11Device *device)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    // upload straight from the mapping, no parsing
+    const MeshCache::CachedMesh &cached = *m_pendingCache;
+    size_t vertexCount = static_cast<size_t>(cached.header->vertexCount);
+    size_t indexCount = static_cast<size_t>(cached.header->indexCount);
+    initBuffers(device, cached.vertices, vertexCount, cached.indices, indexCount);
+    if (getResidency() != MeshResidency::Discard)
+    {
+        m_vertices.assign(cached.vertices, cached.vertices + vertexCount);
+        m_indices.assign(cached.indices, cached.indices + indexCount);
+    }
+
+    float elapsedMs = m_prepareMs + std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    float textMs = cached.header->sourceLoadMs;
+    Logger::Log(Logger::LogLevel::INFO, "Mesh::uploadFromCache: {} loaded from {} in {:.2f} ms (text path {:.2f} ms, {:.1f}x)",
+                m_name, cached.file->getPath(), elapsedMs, textMs, elapsedMs > 0.f ? textMs / elapsedMs : 0.f);
+    m_pendingCache.reset();
+}
+
+uint64_t Mesh::getOptionsKey() const
+{
+    // only options that change the cooked vertex / index data
+    uint64_t key = hashValue(m_options.weldEpsilon);
+    key = hashValue(m_options.optimizeVertexCache, key);
+    key = hashValue(m_options.optimizeOverdraw, key);
+    key = hashValue(m_options.lodCount, key);
+    key = hashValue(m_options.lodReduction, key);
+    key = hashValue(m_options.lodMaxError, key);
+    key = hashValue(m_options.buildMeshlets, key);
+    key = hashValue(m_options.maxMeshletVertices, key);
+    return hashValue(m_options.maxMeshletTriangles, key);
+}
+
+void Mesh::weldVertices()
+{
+    if (m_options.weldEpsilon <= 0.f)
+    {
+        return;
+    }
+
+    MeshOptimizer::IndexingStats stats = MeshOptimizer::weldVertices(m_vertices, m_indices, m_options.weldEpsilon, &m_lods);
+    Logger::Log(Logger::LogLevel::INFO, "Mesh::weldVertices: {}: welded {} -> {} vertices (epsilon {}), {:.1f} KB -> {:.1f} KB",
+                m_name, stats.vertexCountBefore, stats.vertexCountAfter, m_options.weldEpsilon, stats.bytesBefore / 1024.f, stats.bytesAfter / 1024.f);
+}
 
-    std::string line;
-    while (std::getline(file, line))
+void Mesh::optimize()
+{
+    if (!m_options.optimizeVertexCache || m_primitiveTopology != D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
     {
-        std::istringstream iss(line);
-        std::string type;
-        iss >> type;
+        return;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    size_t baseIndexCount = m_lods.empty() ? m_indices.size() : m_lods[0].indexCount;
+    MeshOptimizer::VertexCacheStats before = MeshOptimizer::analyzeVertexCache(m_indices.data(), baseIndexCount, m_vertices.size());
 
-        if (type == "v")
+    if (m_lods.size() > 1)
+    {
+        // prebuilt levels: each range on its own, the overdraw sort would mix them
+        std::vector<uint32_t> range;
+        for (const MeshLod &lod : m_lods)
         {
-            DirectX::XMFLOAT3 pos;
-            iss >> pos.x >> pos.y >> pos.z;
-            pos.z = -pos.z;
-            positions.push_back(pos);
+            range.assign(m_indices.begin() + lod.firstIndex, m_indices.begin() + lod.firstIndex + lod.indexCount);
+            MeshOptimizer::optimizeVertexCache(range, m_vertices.size());
+            std::copy(range.begin(), range.end(), m_indices.begin() + lod.firstIndex);
         }
-        else if (type == "vt")
+    }
+    else
+    {
+        MeshOptimizer::optimizeVertexCache(m_indices, m_vertices.size());
+        if (m_options.optimizeOverdraw)
         {
-            DirectX::XMFLOAT2 tex;
-            iss >> tex.x >> tex.y;
-            tex.y = 1.f - tex.y;
-            texCoords.push_back(tex);
+            MeshOptimizer::optimizeOverdraw(m_vertices, m_indices);
         }
-        else if (type == "vn")
+    }
+    MeshOptimizer::optimizeVertexFetch(m_vertices, m_indices);
+
+    MeshOptimizer::VertexCacheStats after = MeshOptimizer::analyzeVertexCache(m_indices.data(), baseIndexCount, m_vertices.size());
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "Mesh::optimize: {}: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f} in {:.2f} ms",
+                m_name, before.acmr, after.acmr, before.atvr, after.atvr, elapsedMs);
+}
+
+void Mesh::buildLods()
+{
+    if (!m_lods.empty())
+    {
+        return; // prebuilt
+    }
+
+    // LOD0 is the full mesh, coarser levels are appended to the same index buffer
+    m_lods.push_back({0, static_cast<uint32_t>(m_indices.size()), 0.f});
+
+    uint32_t lodCount = std::min(m_options.lodCount, MAX_MESH_LODS);
+    if (lodCount <= 1 || m_indices.empty() || m_primitiveTopology != D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+    {
+        return;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    std::vector<uint32_t> baseIndices(m_indices);
+    std::vector<uint32_t> lodIndices;
+    float maxError = m_options.lodMaxError * m_bounds.sphereRadius;
+    float targetRatio = 1.f;
+    for (uint32_t level = 1; level < lodCount; ++level)
+    {
+        targetRatio *= m_options.lodReduction;
+        size_t targetIndexCount = static_cast<size_t>(baseIndices.size() * targetRatio) / 3 * 3;
+
+        MeshSimplifier::Result result = MeshSimplifier::simplify(m_vertices, baseIndices.data(), baseIndices.size(), targetIndexCount, maxError, lodIndices);
+        if (lodIndices.empty() || lodIndices.size() > m_lods.back().indexCount * 9 / 10)
         {
-            DirectX::XMFLOAT3 norm;
-            iss >> norm.x >> norm.y >> norm.z;
-            norm.z = -norm.z;
-            normals.push_back(norm);
+            break; // locked or out of error budget, nothing worth another level
         }
-        else if (type == "f")
+        MeshOptimizer::optimizeVertexCache(lodIndices, m_vertices.size());
+
+        float error = std::max(result.error, m_lods.back().error); // selection expects errors to grow with the level
+        m_lods.push_back({static_cast<uint32_t>(m_indices.size()), static_cast<uint32_t>(lodIndices.size()), error});
+        m_indices.insert(m_indices.end(), lodIndices.begin(), lodIndices.end());
+
+        Logger::Log(Logger::LogLevel::INFO, "Mesh::buildLods: {}: LOD{} {} -> {} triangles, error {:.5f} ({:.2f}% of radius)",
+                    m_name, level, baseIndices.size() / 3, result.triangleCount, error, m_bounds.sphereRadius > 0.f ? 100.f * error / m_bounds.sphereRadius : 0.f);
+    }
+
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "Mesh::buildLods: {}: {} levels in {:.2f} ms", m_name, m_lods.size(), elapsedMs);
+}
+
+void Mesh::buildMeshlets()
+{
+    m_meshlets.clear();
+    if (!m_options.buildMeshlets || m_lods.empty() || m_lods[0].indexCount == 0 || m_primitiveTopology != D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+    {
+        return;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    MeshletBuilder::build(m_vertices, m_indices.data(), m_lods[0].indexCount, m_lods[0].firstIndex,
+                          std::max(m_options.maxMeshletVertices, 3u), std::max(m_options.maxMeshletTriangles, 1u), m_meshlets);
+
+    size_t cullable = std::count_if(m_meshlets.begin(), m_meshlets.end(), [](const Meshlet &meshlet)
+                                    { return meshlet.coneSinAngle < 1.f; });
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "Mesh::buildMeshlets: {}: {} meshlets, {:.1f} triangles avg, {} with a backface cone, in {:.2f} ms",
+                m_name, m_meshlets.size(), m_lods[0].indexCount / 3.f / m_meshlets.size(), cullable, elapsedMs);
+}
+
+void Mesh::initBuffers(ID3D11Device *device, const Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount)
+{
+    VertexCodec::Quantization quantization = VertexCodec::getQuantization(m_bounds);
+    size_t vertexBytes = 0;
+
+    // Vertex data
+    std::vector<CompactVertex> compactVertices;
+    const void *vertexData = vertices;
+    if (m_options.vertexFormat == VertexFormat::Compact)
+    {
+        VertexCodec::encodeCompact(vertices, vertexCount, quantization, compactVertices);
+        vertexData = compactVertices.data();
+        m_vertexStride = sizeof(CompactVertex);
+    }
+    else
+    {
+        m_vertexStride = sizeof(Vertex);
+    }
+    vertexBytes += m_vertexStride * vertexCount;
+
+    // Position data (depth-only passes)
+    std::vector<PositionVertex> positions;
+    if (m_options.positionStream)
+    {
+        VertexCodec::encodePositions(vertices, vertexCount, quantization, positions);
+        vertexBytes += sizeof(PositionVertex) * vertexCount;
+    }
+
+    // Mesh Buffer (dequantization)
+    if (m_options.vertexFormat == VertexFormat::Compact || m_options.positionStream)
+    {
+        MeshBuffer meshData = {};
+        meshData.positionOffset = DirectX::XMFLOAT4(quantization.offset.x, quantization.offset.y, quantization.offset.z, 0.f);
+        meshData.positionScale = DirectX::XMFLOAT4(quantization.scale.x, quantization.scale.y, quantization.scale.z, 1.f);
+        createBuffer(device, D3D11_BIND_CONSTANT_BUFFER, &meshData, sizeof(MeshBuffer), m_meshBuffer.GetAddressOf(), D3D11_USAGE_IMMUTABLE);
+    }
+
+    // Index data, 16-bit whenever every vertex is addressable (relative to the base vertex when pooled)
+    std::vector<uint16_t> shortIndices;
+    const void *indexData = indices;
+    size_t indexBytes;
+    if (vertexCount < 65536)
+    {
+        shortIndices.assign(indices, indices + indexCount);
+        indexData = shortIndices.data();
+        indexBytes = sizeof(uint16_t) * indexCount;
+        m_indexFormat = DXGI_FORMAT_R16_UINT;
+    }
+    else
+    {
+        indexBytes = sizeof(uint32_t) * indexCount;
+        m_indexFormat = DXGI_FORMAT_R32_UINT;
+    }
+
+    if (m_options.useGeometryPool)
+    {
+        m_poolHandle = GeometryPool::getInstance().allocate(device, m_vertexStride, m_indexFormat, vertexData, static_cast<uint32_t>(vertexCount),
+                                                            m_options.positionStream ? positions.data() : nullptr, indexData, static_cast<uint32_t>(indexCount));
+    }
+    else
+    {
+        createBuffer(device, D3D11_BIND_VERTEX_BUFFER, vertexData, m_vertexStride * vertexCount, m_vertexBuffer.GetAddressOf());
+        if (m_options.positionStream)
         {
-            std::vector<DirectX::XMINT3> face_vertices;
-            std::string descriptor;
-            while (iss >> descriptor)
-            {
-                size_t firstSlash = descriptor.find('/');
-                size_t secondSlash = descriptor.find('/', firstSlash + 1);
-
-                int vIndex = std::stoi(descriptor.substr(0, firstSlash));
-                int tIndex = std::stoi(descriptor.substr(firstSlash + 1, secondSlash - firstSlash - 1));
-                int nIndex = std::stoi(descriptor.substr(secondSlash + 1));
-
-                face_vertices.push_back({vIndex, tIndex, nIndex}); // v, t, n
-            }
-
-            size_t size_vertices = face_vertices.size();
-            if (size_vertices == 3)
-            {
-                for (int i = 0; i < 3; ++i)
-                {
-                    auto &fv = face_vertices[i];
-                    m_vertices.push_back({positions[fv.x], normals[fv.z], texCoords[fv.y]}); // v, n, t
-                    m_indices.push_back(static_cast<uint32_t>(m_vertices.size() - 1));
-                }
-            }
-            else if (size_vertices == 4)
-            {
-                const int A = 0, B = 1, C = 2, D = 3;
-                int quad_indices[6] = {A, B, C, A, C, D};
-                for (int i = 0; i < 6; ++i)
-                {
-                    auto &fv = face_vertices[quad_indices[i]];
-                    m_vertices.push_back({positions[fv.x], normals[fv.z], texCoords[fv.y]}); // v, n, t
-                    m_indices.push_back(static_cast<uint32_t>(m_vertices.size() - 1));       // TODO: 1-1 mapping, need to optimize
-                }
-            }
+            createBuffer(device, D3D11_BIND_VERTEX_BUFFER, positions.data(), sizeof(PositionVertex) * vertexCount, m_positionBuffer.GetAddressOf());
         }
+        createBuffer(device, D3D11_BIND_INDEX_BUFFER, indexData, indexBytes, m_indexBuffer.GetAddressOf());
+    }
+
+    m_gpuVertexCount = vertexCount;
+    m_gpuIndexCount = indexCount;
+    if (!m_sourcePath.empty())
+    {
+        m_gpuContentHash = hashGeometry(vertices, vertexCount, indices, indexCount); // what rematerialize has to reproduce
     }
-    file.close();
+    m_gpuBytes = vertexBytes + indexBytes + (m_meshBuffer ? sizeof(MeshBuffer) : 0);
+
+    Logger::Log(Logger::LogLevel::INFO, "Mesh::initBuffers: {}: {:.1f} KB vertices ({} B stride), {:.1f} KB indices ({}-bit), fat layout {:.1f} KB{}",
+                m_name, vertexBytes / 1024.f, m_vertexStride, indexBytes / 1024.f, m_indexFormat == DXGI_FORMAT_R16_UINT ? 16 : 32,
+                MeshOptimizer::getBufferBytes(vertexCount, indexCount) / 1024.f, m_options.useGeometryPool ? ", pooled" : "");
 }
 
-void Mesh::initBuffers(ID3D11Device *device, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices)
+void Mesh::createBuffer(ID3D11Device *device, UINT bindFlags, const void *data, size_t byteWidth, ID3D11Buffer **buffer, D3D11_USAGE usage)
 {
     D3D11_BUFFER_DESC bufferDesc = {};
-    D3D11_SUBRESOURCE_DATA initData = {};
-    HRESULT hr;
+    bufferDesc.Usage = usage;
+    bufferDesc.ByteWidth = static_cast<UINT>(byteWidth);
+    bufferDesc.BindFlags = bindFlags;
 
-    // Vertex Buffer
-    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    bufferDesc.ByteWidth = static_cast<UINT>(sizeof(Vertex) * vertices.size());
-    bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-    initData.pSysMem = vertices.data();
+    D3D11_SUBRESOURCE_DATA initData = {};
+    initData.pSysMem = data;
 
-    hr = device->CreateBuffer(&bufferDesc, &initData, m_vertexBuffer.GetAddressOf());
+    HRESULT hr = device->CreateBuffer(&bufferDesc, &initData, buffer);
     if (FAILED(hr))
     {
-        throw std::runtime_error("Mesh::initBuffers: Failed to create vertex buffer.");
+        throw std::runtime_error(std::format("Mesh::createBuffer: Failed to create buffer (bind flags {:#x}), HRESULT: {:#X}", bindFlags, static_cast<uint32_t>(hr)));
     }
+}
 
-    // Index Buffer
-    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-    bufferDesc.ByteWidth = static_cast<UINT>(sizeof(uint32_t) * indices.size());
-    bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-    initData.pSysMem = indices.data();
+uint32_t Mesh::getBaseVertex() const
+{
+    return m_poolHandle != GeometryPool::INVALID_HANDLE ? GeometryPool::getInstance().getAllocation(m_poolHandle).baseVertex : 0;
+}
 
-    hr = device->CreateBuffer(&bufferDesc, &initData, m_indexBuffer.GetAddressOf());
-    if (FAILED(hr))
+uint32_t Mesh::getFirstIndex() const
+{
+    return m_poolHandle != GeometryPool::INVALID_HANDLE ? GeometryPool::getInstance().getAllocation(m_poolHandle).firstIndex : 0;
+}
+
+void Mesh::bind(ID3D11DeviceContext *deviceContext) const
+{
+    if (m_poolHandle != GeometryPool::INVALID_HANDLE)
     {
-        throw std::runtime_error("Mesh::initBuffers: Failed to create index buffer.");
+        GeometryPool::getInstance().bind(deviceContext, m_poolHandle, m_primitiveTopology);
+    }
+    else
+    {
+        UINT stride = m_vertexStride;
+        UINT offset = 0;
+        deviceContext->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
+        deviceContext->IASetIndexBuffer(m_indexBuffer.Get(), m_indexFormat, 0);
+        deviceContext->IASetPrimitiveTopology(m_primitiveTopology);
+        GeometryPool::getInstance().invalidateBindings();
+    }
+    if (m_meshBuffer)
+    {
+        deviceContext->VSSetConstantBuffers(4, 1, m_meshBuffer.GetAddressOf()); // slot 4
     }
 }
 
-void Mesh::bind(ID3D11DeviceContext *deviceContext) const
+void Mesh::bindPositionOnly(ID3D11DeviceContext *deviceContext) const
+{
+    if (!m_options.positionStream)
+    {
+        throw std::runtime_error("Mesh::bindPositionOnly: " + m_name + " was created without a position stream");
+    }
+
+    if (m_poolHandle != GeometryPool::INVALID_HANDLE)
+    {
+        GeometryPool::getInstance().bindPositionOnly(deviceContext, m_poolHandle, m_primitiveTopology);
+    }
+    else
+    {
+        UINT stride = sizeof(PositionVertex);
+        UINT offset = 0;
+        deviceContext->IASetVertexBuffers(0, 1, m_positionBuffer.GetAddressOf(), &stride, &offset);
+        deviceContext->IASetIndexBuffer(m_indexBuffer.Get(), m_indexFormat, 0);
+        deviceContext->IASetPrimitiveTopology(m_primitiveTopology);
+        GeometryPool::getInstance().invalidateBindings();
+    }
+    deviceContext->VSSetConstantBuffers(4, 1, m_meshBuffer.GetAddressOf()); // slot 4
+}
+
+MeshResidency Mesh::getResidency() const
+{
+    return m_options.residency == MeshResidency::Default ? s_defaultResidency.load() : m_options.residency;
+}
+
+bool Mesh::isCpuResident() const
+{
+    return m_vertices.size() == m_gpuVertexCount && m_indices.size() == m_gpuIndexCount;
+}
+
+void Mesh::releaseCpuData()
+{
+    MeshResidency residency = getResidency();
+    if (residency == MeshResidency::Keep)
+    {
+        return;
+    }
+
+    if (residency == MeshResidency::PositionsOnly && !m_lods.empty() && isCpuResident())
+    {
+        // picking / physics only need the full detail surface
+        m_positions.resize(m_vertices.size());
+        std::transform(m_vertices.begin(), m_vertices.end(), m_positions.begin(), [](const Vertex &vertex)
+                       { return vertex.pos; });
+        std::vector<uint32_t> baseIndices(m_indices.begin() + m_lods[0].firstIndex, m_indices.begin() + m_lods[0].firstIndex + m_lods[0].indexCount);
+        m_indices.swap(baseIndices);
+    }
+    else if (residency == MeshResidency::Discard)
+    {
+        std::vector<DirectX::XMFLOAT3>().swap(m_positions);
+        std::vector<uint32_t>().swap(m_indices);
+    }
+    std::vector<Vertex>().swap(m_vertices);
+
+    if (m_sourcePath.empty())
+    {
+        Logger::Log(Logger::LogLevel::INFO, "Mesh::releaseCpuData: {}: built from memory, rematerialize will not be able to restore it", m_name);
+    }
+}
+
+bool Mesh::rematerialize()
+{
+    if (isCpuResident())
+    {
+        return true;
+    }
+    if (m_sourcePath.empty())
+    {
+        Logger::LogWarning("Mesh::rematerialize: " + m_name + ": built from memory, nothing to reload from");
+        return false;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    MeshCache::CachedMesh cached;
+    bool fromCache = m_options.useCache && MeshCache::load(m_sourcePath, m_sourcePrimitive, getOptionsKey(), cached);
+    if (fromCache)
+    {
+        m_vertices.assign(cached.vertices, cached.vertices + cached.header->vertexCount);
+        m_indices.assign(cached.indices, cached.indices + cached.header->indexCount);
+    }
+    else
+    {
+        // cooking is deterministic, so the result matches what was uploaded
+        m_vertices.clear();
+        m_indices.clear();
+        m_lods.clear();
+        try
+        {
+            cook(m_sourcePath);
+        }
+        catch (const std::exception &e)
+        {
+            Logger::Log(Logger::LogLevel::WARNING, "Mesh::rematerialize: {}: {}", m_name, e.what());
+        }
+    }
+
+    if (!isCpuResident() || hashGeometry(m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size()) != m_gpuContentHash)
+    {
+        Logger::Log(Logger::LogLevel::WARNING, "Mesh::rematerialize: {}: {} no longer matches the uploaded buffers", m_name, m_sourcePath);
+        std::vector<Vertex>().swap(m_vertices);
+        std::vector<uint32_t>().swap(m_indices);
+        return false;
+    }
+    std::vector<DirectX::XMFLOAT3>().swap(m_positions);
+
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "Mesh::rematerialize: {}: restored from {} in {:.2f} ms", m_name, fromCache ? "the cache" : "the source", elapsedMs);
+    return true;
+}
+
+const MeshBvh *Mesh::getBvh()
+{
+    std::lock_guard<std::mutex> lock(m_bvhMutex);
+    if (m_bvh || m_isBvhUnavailable)
+    {
+        return m_bvh.get();
+    }
+    if (m_lods.empty() || m_gpuVertexCount == 0 || m_primitiveTopology != D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+    {
+        m_isBvhUnavailable = true;
+        return nullptr;
+    }
+
+    // PositionsOnly already keeps what the BVH needs, anything else must have its vertices back
+    bool isRematerialized = false;
+    if (m_positions.empty() && !isCpuResident())
+    {
+        if (!rematerialize())
+        {
+            Logger::LogWarning("Mesh::getBvh: " + m_name + ": no CPU geometry to build from");
+            m_isBvhUnavailable = true;
+            return nullptr;
+        }
+        isRematerialized = true;
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    if (!m_positions.empty())
+    {
+        m_bvh = std::make_unique<MeshBvh>(m_positions.data(), sizeof(DirectX::XMFLOAT3), m_positions.size(), m_indices.data(), m_lods[0].indexCount);
+    }
+    else
+    {
+        m_bvh = std::make_unique<MeshBvh>(&m_vertices[0].pos, sizeof(Vertex), m_vertices.size(), m_indices.data() + m_lods[0].firstIndex, m_lods[0].indexCount);
+    }
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+    if (isRematerialized)
+    {
+        releaseCpuData();
+    }
+    Logger::Log(Logger::LogLevel::INFO, "Mesh::getBvh: {}: {} nodes, depth {}, {:.1f} KB in {:.2f} ms",
+                m_name, m_bvh->getNodeCount(), m_bvh->getDepth(), m_bvh->getMemoryBytes() / 1024.f, elapsedMs);
+    return m_bvh.get();
+}
+
+size_t Mesh::getCpuBytes() const
+{
+    return m_vertices.capacity() * sizeof(Vertex) + m_positions.capacity() * sizeof(DirectX::XMFLOAT3) +
+           m_indices.capacity() * sizeof(uint32_t) + m_meshlets.capacity() * sizeof(Meshlet) + m_lods.capacity() * sizeof(MeshLod) +
+           (m_bvh ? m_bvh->getMemoryBytes() : 0);
+}
+
+void Mesh::setDefaultResidency(MeshResidency residency)
+{
+    s_defaultResidency = residency == MeshResidency::Default ? MeshResidency::Keep : residency;
+}
+
+void Mesh::logMemoryReport()
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    std::vector<const Mesh *> meshes(s_registry.begin(), s_registry.end());
+    std::sort(meshes.begin(), meshes.end(), [](const Mesh *a, const Mesh *b)
+              { return a->getCpuBytes() > b->getCpuBytes(); });
+
+    size_t totalCpu = 0, totalGpu = 0;
+    for (const Mesh *mesh : meshes)
+    {
+        Logger::Log(Logger::LogLevel::INFO, "Mesh::logMemoryReport: {:<24} {:<9} CPU {:9.1f} KB  GPU {:9.1f} KB",
+                    mesh->m_name, getResidencyName(mesh->getResidency()), mesh->getCpuBytes() / 1024.f, mesh->getGpuBytes() / 1024.f);
+        totalCpu += mesh->getCpuBytes();
+        totalGpu += mesh->getGpuBytes();
+    }
+    Logger::Log(Logger::LogLevel::INFO, "Mesh::logMemoryReport: {} meshes, CPU {:.1f} KB, GPU {:.1f} KB",
+                meshes.size(), totalCpu / 1024.f, totalGpu / 1024.f);
+}
+
+void Mesh::registerMesh(const Mesh *mesh)
+{
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    s_registry.insert(mesh);
+}
+
+void Mesh::unregisterMesh(const Mesh *mesh)
 {
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-    deviceContext->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
-    deviceContext->IASetIndexBuffer(m_indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
-    deviceContext->IASetPrimitiveTopology(m_primitiveTopology);
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    s_registry.erase(mesh);
 }
@@ -0,0 +1,41 @@
+#include "resources/mesh_bounds.h"
+#include <algorithm>
+#include <cmath>
+
+MeshBounds MeshBounds::compute(const DirectX::XMFLOAT3 *positions, size_t count, size_t stride)
+{
+    MeshBounds bounds = {};
+    if (count == 0)
+    {
+        return bounds;
+    }
+
+    const unsigned char *base = reinterpret_cast<const unsigned char *>(positions);
+    auto positionAt = [base, stride](size_t i) -> const DirectX::XMFLOAT3 &
+    {
+        return *reinterpret_cast<const DirectX::XMFLOAT3 *>(base + i * stride);
+    };
+
+    DirectX::XMVECTOR minVec = DirectX::XMLoadFloat3(&positionAt(0));
+    DirectX::XMVECTOR maxVec = minVec;
+    for (size_t i = 1; i < count; ++i)
+    {
+        DirectX::XMVECTOR p = DirectX::XMLoadFloat3(&positionAt(i));
+        minVec = DirectX::XMVectorMin(minVec, p);
+        maxVec = DirectX::XMVectorMax(maxVec, p);
+    }
+    DirectX::XMStoreFloat3(&bounds.aabbMin, minVec);
+    DirectX::XMStoreFloat3(&bounds.aabbMax, maxVec);
+
+    // sphere around the box center, tight enough for culling and LOD metrics
+    DirectX::XMVECTOR center = DirectX::XMVectorScale(DirectX::XMVectorAdd(minVec, maxVec), 0.5f);
+    float radiusSq = 0.f;
+    for (size_t i = 0; i < count; ++i)
+    {
+        DirectX::XMVECTOR d = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&positionAt(i)), center);
+        radiusSq = std::max(radiusSq, DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(d)));
+    }
+    DirectX::XMStoreFloat3(&bounds.sphereCenter, center);
+    bounds.sphereRadius = std::sqrt(radiusSq);
+    return bounds;
+}
@@ -0,0 +1,569 @@
+#include "resources/mesh_bvh.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr float TRAVERSAL_COST = 1.f; // relative to one triangle test
+    constexpr uint32_t STACK_SIZE = 64;
+    constexpr float DETERMINANT_EPSILON = 1e-12f;
+
+    inline float getHalfArea(const XMFLOAT3 &boundsMin, const XMFLOAT3 &boundsMax)
+    {
+        float dx = boundsMax.x - boundsMin.x, dy = boundsMax.y - boundsMin.y, dz = boundsMax.z - boundsMin.z;
+        return dx * dy + dy * dz + dz * dx;
+    }
+
+    inline void growBounds(XMFLOAT3 &boundsMin, XMFLOAT3 &boundsMax, const XMFLOAT3 &pointMin, const XMFLOAT3 &pointMax)
+    {
+        XMStoreFloat3(&boundsMin, XMVectorMin(XMLoadFloat3(&boundsMin), XMLoadFloat3(&pointMin)));
+        XMStoreFloat3(&boundsMax, XMVectorMax(XMLoadFloat3(&boundsMax), XMLoadFloat3(&pointMax)));
+    }
+
+    inline float getComponent(const XMFLOAT3 &v, uint32_t axis)
+    {
+        return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+    }
+
+    inline float horizontalMax(XMVECTOR v) { return std::max({XMVectorGetX(v), XMVectorGetY(v), XMVectorGetZ(v)}); }
+    inline float horizontalMin(XMVECTOR v) { return std::min({XMVectorGetX(v), XMVectorGetY(v), XMVectorGetZ(v)}); }
+
+    inline bool isAnyLaneSet(XMVECTOR mask) { return XMVector4NotEqualInt(mask, XMVectorFalseInt()); }
+
+    // Ericson, Real-Time Collision Detection 5.1.5
+    XMVECTOR getClosestPointOnTriangle(XMVECTOR p, XMVECTOR a, XMVECTOR b, XMVECTOR c)
+    {
+        XMVECTOR ab = XMVectorSubtract(b, a), ac = XMVectorSubtract(c, a), ap = XMVectorSubtract(p, a);
+        float d1 = XMVectorGetX(XMVector3Dot(ab, ap)), d2 = XMVectorGetX(XMVector3Dot(ac, ap));
+        if (d1 <= 0.f && d2 <= 0.f)
+        {
+            return a;
+        }
+        XMVECTOR bp = XMVectorSubtract(p, b);
+        float d3 = XMVectorGetX(XMVector3Dot(ab, bp)), d4 = XMVectorGetX(XMVector3Dot(ac, bp));
+        if (d3 >= 0.f && d4 <= d3)
+        {
+            return b;
+        }
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+        {
+            return XMVectorMultiplyAdd(ab, XMVectorReplicate(d1 / (d1 - d3)), a);
+        }
+        XMVECTOR cp = XMVectorSubtract(p, c);
+        float d5 = XMVectorGetX(XMVector3Dot(ab, cp)), d6 = XMVectorGetX(XMVector3Dot(ac, cp));
+        if (d6 >= 0.f && d5 <= d6)
+        {
+            return c;
+        }
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+        {
+            return XMVectorMultiplyAdd(ac, XMVectorReplicate(d2 / (d2 - d6)), a);
+        }
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+        {
+            return XMVectorMultiplyAdd(XMVectorSubtract(c, b), XMVectorReplicate((d4 - d3) / ((d4 - d3) + (d5 - d6))), b);
+        }
+        float denominator = 1.f / (va + vb + vc);
+        return XMVectorAdd(a, XMVectorAdd(XMVectorScale(ab, vb * denominator), XMVectorScale(ac, vc * denominator)));
+    }
+}
+
+MeshBvh::MeshBvh(const XMFLOAT3 *positions, size_t positionStride, size_t vertexCount, const uint32_t *indices, size_t indexCount)
+{
+    auto getPosition = [&](uint32_t index) -> const XMFLOAT3 &
+    {
+        return *reinterpret_cast<const XMFLOAT3 *>(reinterpret_cast<const uint8_t *>(positions) + index * positionStride);
+    };
+
+    size_t triangleCount = indexCount / 3;
+    std::vector<XMFLOAT3> boundsMin(triangleCount), boundsMax(triangleCount), centroids(triangleCount);
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        uint32_t i0 = indices[i * 3], i1 = indices[i * 3 + 1], i2 = indices[i * 3 + 2];
+        if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount)
+        {
+            throw std::runtime_error("MeshBvh::MeshBvh: index out of the vertex range");
+        }
+        XMVECTOR a = XMLoadFloat3(&getPosition(i0)), b = XMLoadFloat3(&getPosition(i1)), c = XMLoadFloat3(&getPosition(i2));
+        XMVECTOR lower = XMVectorMin(XMVectorMin(a, b), c), upper = XMVectorMax(XMVectorMax(a, b), c);
+        XMStoreFloat3(&boundsMin[i], lower);
+        XMStoreFloat3(&boundsMax[i], upper);
+        XMStoreFloat3(&centroids[i], XMVectorScale(XMVectorAdd(lower, upper), 0.5f));
+    }
+
+    std::vector<uint32_t> order(triangleCount);
+    std::iota(order.begin(), order.end(), 0u);
+    build(boundsMin, boundsMax, centroids, order);
+
+    // triangles in leaf order, so leaves read them contiguously
+    m_triangles.resize(triangleCount);
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        const uint32_t *corners = indices + order[i] * 3;
+        XMVECTOR v0 = XMLoadFloat3(&getPosition(corners[0]));
+        XMStoreFloat3(&m_triangles[i].v0, v0);
+        XMStoreFloat3(&m_triangles[i].edge1, XMVectorSubtract(XMLoadFloat3(&getPosition(corners[1])), v0));
+        XMStoreFloat3(&m_triangles[i].edge2, XMVectorSubtract(XMLoadFloat3(&getPosition(corners[2])), v0));
+    }
+    m_triangleIds = std::move(order);
+}
+
+void MeshBvh::build(const std::vector<XMFLOAT3> &boundsMin, const std::vector<XMFLOAT3> &boundsMax, const std::vector<XMFLOAT3> &centroids, std::vector<uint32_t> &order)
+{
+    uint32_t triangleCount = static_cast<uint32_t>(order.size());
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    struct Bin
+    {
+        XMFLOAT3 boundsMin;
+        XMFLOAT3 boundsMax;
+        uint32_t count;
+    };
+
+    m_nodes.reserve(triangleCount * 2 - 1);
+    m_nodes.push_back({XMFLOAT3(), 0, XMFLOAT3(), triangleCount});
+
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{0u, 1u}}; // node, depth
+    while (!stack.empty())
+    {
+        auto [nodeIndex, depth] = stack.back();
+        stack.pop_back();
+        m_depth = std::max(m_depth, depth);
+
+        uint32_t first = m_nodes[nodeIndex].leftOrFirst;
+        uint32_t count = m_nodes[nodeIndex].triangleCount;
+        XMFLOAT3 nodeMin(FLT_MAX, FLT_MAX, FLT_MAX), nodeMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        XMFLOAT3 centroidMin = nodeMin, centroidMax = nodeMax;
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            growBounds(nodeMin, nodeMax, boundsMin[order[i]], boundsMax[order[i]]);
+            growBounds(centroidMin, centroidMax, centroids[order[i]], centroids[order[i]]);
+        }
+        m_nodes[nodeIndex].boundsMin = nodeMin;
+        m_nodes[nodeIndex].boundsMax = nodeMax;
+        if (count == 1)
+        {
+            continue;
+        }
+
+        // binned SAH over the centroid bounds of every axis
+        float bestCost = FLT_MAX;
+        uint32_t bestAxis = 0, bestSplit = 0;
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            float lower = getComponent(centroidMin, axis), extent = getComponent(centroidMax, axis) - lower;
+            if (extent <= 0.f)
+            {
+                continue;
+            }
+            float scale = SAH_BINS / extent;
+
+            Bin bins[SAH_BINS];
+            for (Bin &bin : bins)
+            {
+                bin = {XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX), XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX), 0};
+            }
+            for (uint32_t i = first; i < first + count; ++i)
+            {
+                uint32_t triangle = order[i];
+                uint32_t binIndex = std::min(static_cast<uint32_t>((getComponent(centroids[triangle], axis) - lower) * scale), SAH_BINS - 1);
+                growBounds(bins[binIndex].boundsMin, bins[binIndex].boundsMax, boundsMin[triangle], boundsMax[triangle]);
+                ++bins[binIndex].count;
+            }
+
+            // sweep from the right, then evaluate every split from the left
+            float rightArea[SAH_BINS - 1];
+            uint32_t rightCount[SAH_BINS - 1];
+            XMFLOAT3 sweepMin(FLT_MAX, FLT_MAX, FLT_MAX), sweepMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            uint32_t sweepCount = 0;
+            for (uint32_t split = SAH_BINS - 1; split > 0; --split)
+            {
+                growBounds(sweepMin, sweepMax, bins[split].boundsMin, bins[split].boundsMax);
+                sweepCount += bins[split].count;
+                rightArea[split - 1] = sweepCount ? getHalfArea(sweepMin, sweepMax) : 0.f;
+                rightCount[split - 1] = sweepCount;
+            }
+            sweepMin = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+            sweepMax = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            sweepCount = 0;
+            for (uint32_t split = 0; split < SAH_BINS - 1; ++split)
+            {
+                growBounds(sweepMin, sweepMax, bins[split].boundsMin, bins[split].boundsMax);
+                sweepCount += bins[split].count;
+                if (sweepCount == 0 || rightCount[split] == 0)
+                {
+                    continue;
+                }
+                float cost = getHalfArea(sweepMin, sweepMax) * sweepCount + rightArea[split] * rightCount[split];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        if (bestCost == FLT_MAX)
+        {
+            continue; // every centroid in one spot, nothing to split
+        }
+        float nodeArea = getHalfArea(nodeMin, nodeMax);
+        float splitCost = TRAVERSAL_COST + (nodeArea > 0.f ? bestCost / nodeArea : static_cast<float>(count));
+        if (count <= MAX_LEAF_TRIANGLES && splitCost >= static_cast<float>(count))
+        {
+            continue;
+        }
+
+        float lower = getComponent(centroidMin, bestAxis);
+        float scale = SAH_BINS / (getComponent(centroidMax, bestAxis) - lower);
+        auto middle = std::partition(order.begin() + first, order.begin() + first + count, [&](uint32_t triangle)
+                                     { return std::min(static_cast<uint32_t>((getComponent(centroids[triangle], bestAxis) - lower) * scale), SAH_BINS - 1) <= bestSplit; });
+        uint32_t leftCount = static_cast<uint32_t>(middle - (order.begin() + first));
+        if (leftCount == 0 || leftCount == count)
+        {
+            continue;
+        }
+
+        uint32_t left = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.push_back({XMFLOAT3(), first, XMFLOAT3(), leftCount});
+        m_nodes.push_back({XMFLOAT3(), first + leftCount, XMFLOAT3(), count - leftCount});
+        m_nodes[nodeIndex].leftOrFirst = left;
+        m_nodes[nodeIndex].triangleCount = 0;
+        stack.push_back({left, depth + 1});
+        stack.push_back({left + 1, depth + 1});
+    }
+    m_nodes.shrink_to_fit();
+}
+
+size_t MeshBvh::getMemoryBytes() const
+{
+    return m_nodes.capacity() * sizeof(Node) + m_triangles.capacity() * sizeof(Triangle) + m_triangleIds.capacity() * sizeof(uint32_t);
+}
+
+template <bool ANY_HIT>
+bool MeshBvh::traverse(const Ray &ray, Hit &hit) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    XMVECTOR origin = XMLoadFloat3(&ray.origin);
+    XMVECTOR direction = XMLoadFloat3(&ray.direction);
+    XMVECTOR inverseDirection = XMVectorReciprocal(direction);
+    float tMax = ray.tMax;
+    bool isHit = false;
+
+    // slab test, entry distance or FLT_MAX on a miss
+    auto intersectBox = [&](const Node &node)
+    {
+        XMVECTOR t1 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&node.boundsMin), origin), inverseDirection);
+        XMVECTOR t2 = XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&node.boundsMax), origin), inverseDirection);
+        float tNear = std::max(horizontalMax(XMVectorMin(t1, t2)), 0.f);
+        float tFar = std::min(horizontalMin(XMVectorMax(t1, t2)), tMax);
+        return tNear <= tFar ? tNear : FLT_MAX;
+    };
+
+    struct Entry
+    {
+        uint32_t node;
+        float tNear;
+    };
+    Entry stack[STACK_SIZE];
+    uint32_t stackSize = 0;
+    float rootNear = intersectBox(m_nodes[0]);
+    if (rootNear != FLT_MAX)
+    {
+        stack[stackSize++] = {0, rootNear};
+    }
+
+    while (stackSize > 0)
+    {
+        Entry entry = stack[--stackSize];
+        if (entry.tNear > tMax)
+        {
+            continue; // a closer hit was found since it was pushed
+        }
+
+        const Node &node = m_nodes[entry.node];
+        if (node.triangleCount > 0)
+        {
+            for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.triangleCount; ++i)
+            {
+                const Triangle &triangle = m_triangles[i];
+                XMVECTOR edge1 = XMLoadFloat3(&triangle.edge1), edge2 = XMLoadFloat3(&triangle.edge2);
+                XMVECTOR p = XMVector3Cross(direction, edge2);
+                float determinant = XMVectorGetX(XMVector3Dot(edge1, p));
+                if (std::fabs(determinant) < DETERMINANT_EPSILON)
+                {
+                    continue;
+                }
+                float inverseDeterminant = 1.f / determinant;
+                XMVECTOR s = XMVectorSubtract(origin, XMLoadFloat3(&triangle.v0));
+                float u = XMVectorGetX(XMVector3Dot(s, p)) * inverseDeterminant;
+                if (u < 0.f || u > 1.f)
+                {
+                    continue;
+                }
+                XMVECTOR q = XMVector3Cross(s, edge1);
+                float v = XMVectorGetX(XMVector3Dot(direction, q)) * inverseDeterminant;
+                if (v < 0.f || u + v > 1.f)
+                {
+                    continue;
+                }
+                float t = XMVectorGetX(XMVector3Dot(edge2, q)) * inverseDeterminant;
+                if (t < 0.f || t >= tMax)
+                {
+                    continue;
+                }
+
+                if (ANY_HIT)
+                {
+                    return true;
+                }
+                tMax = t;
+                hit = {t, m_triangleIds[i], u, v};
+                isHit = true;
+            }
+            continue;
+        }
+
+        // nearer child on top of the stack
+        float leftNear = intersectBox(m_nodes[node.leftOrFirst]);
+        float rightNear = intersectBox(m_nodes[node.leftOrFirst + 1]);
+        Entry near = {node.leftOrFirst, leftNear}, far = {node.leftOrFirst + 1, rightNear};
+        if (rightNear < leftNear)
+        {
+            std::swap(near, far);
+        }
+        if (far.tNear != FLT_MAX && stackSize < STACK_SIZE)
+        {
+            stack[stackSize++] = far;
+        }
+        if (near.tNear != FLT_MAX && stackSize < STACK_SIZE)
+        {
+            stack[stackSize++] = near;
+        }
+    }
+    return isHit;
+}
+
+bool MeshBvh::intersect(const Ray &ray, Hit &hit) const
+{
+    return traverse<false>(ray, hit);
+}
+
+bool MeshBvh::isOccluded(const Ray &ray) const
+{
+    Hit hit;
+    return traverse<true>(ray, hit);
+}
+
+void MeshBvh::intersect(const Ray *rays, size_t rayCount, Hit *hits) const
+{
+    for (size_t first = 0; first < rayCount; first += PACKET_SIZE)
+    {
+        intersectPacket(rays + first, std::min<size_t>(PACKET_SIZE, rayCount - first), hits + first);
+    }
+}
+
+void MeshBvh::intersectPacket(const Ray *rays, size_t rayCount, Hit *hits) const
+{
+    // structure of arrays, one ray per lane, unused lanes get a negative tMax and never hit
+    XMFLOAT4 lanes[10] = {};
+    for (size_t i = 0; i < PACKET_SIZE; ++i)
+    {
+        const Ray &ray = rays[std::min(i, rayCount - 1)];
+        float *values[10] = {&lanes[0].x, &lanes[1].x, &lanes[2].x, &lanes[3].x, &lanes[4].x, &lanes[5].x, &lanes[6].x, &lanes[7].x, &lanes[8].x, &lanes[9].x};
+        float laneValues[10] = {ray.origin.x, ray.origin.y, ray.origin.z, ray.direction.x, ray.direction.y, ray.direction.z,
+                                1.f / ray.direction.x, 1.f / ray.direction.y, 1.f / ray.direction.z, i < rayCount ? ray.tMax : -1.f};
+        for (size_t k = 0; k < 10; ++k)
+        {
+            values[k][i] = laneValues[k];
+        }
+    }
+    XMVECTOR ox = XMLoadFloat4(&lanes[0]), oy = XMLoadFloat4(&lanes[1]), oz = XMLoadFloat4(&lanes[2]);
+    XMVECTOR dx = XMLoadFloat4(&lanes[3]), dy = XMLoadFloat4(&lanes[4]), dz = XMLoadFloat4(&lanes[5]);
+    XMVECTOR ix = XMLoadFloat4(&lanes[6]), iy = XMLoadFloat4(&lanes[7]), iz = XMLoadFloat4(&lanes[8]);
+    XMVECTOR hitT = XMLoadFloat4(&lanes[9]);
+    XMVECTOR hitU = XMVectorZero(), hitV = XMVectorZero();
+    XMVECTOR zero = XMVectorZero(), one = XMVectorSplatOne();
+    uint32_t hitTriangles[PACKET_SIZE] = {INVALID_TRIANGLE, INVALID_TRIANGLE, INVALID_TRIANGLE, INVALID_TRIANGLE};
+
+    uint32_t stack[STACK_SIZE];
+    uint32_t stackSize = m_nodes.empty() ? 0 : 1;
+    stack[0] = 0;
+    while (stackSize > 0)
+    {
+        const Node &node = m_nodes[stack[--stackSize]];
+
+        XMVECTOR t1x = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(node.boundsMin.x), ox), ix);
+        XMVECTOR t2x = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(node.boundsMax.x), ox), ix);
+        XMVECTOR t1y = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(node.boundsMin.y), oy), iy);
+        XMVECTOR t2y = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(node.boundsMax.y), oy), iy);
+        XMVECTOR t1z = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(node.boundsMin.z), oz), iz);
+        XMVECTOR t2z = XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(node.boundsMax.z), oz), iz);
+        XMVECTOR tNear = XMVectorMax(XMVectorMax(XMVectorMin(t1x, t2x), XMVectorMin(t1y, t2y)), XMVectorMax(XMVectorMin(t1z, t2z), zero));
+        XMVECTOR tFar = XMVectorMin(XMVectorMin(XMVectorMax(t1x, t2x), XMVectorMax(t1y, t2y)), XMVectorMin(XMVectorMax(t1z, t2z), hitT));
+        if (!isAnyLaneSet(XMVectorLessOrEqual(tNear, tFar)))
+        {
+            continue;
+        }
+
+        if (node.triangleCount == 0)
+        {
+            if (stackSize + 2 <= STACK_SIZE)
+            {
+                stack[stackSize++] = node.leftOrFirst + 1;
+                stack[stackSize++] = node.leftOrFirst;
+            }
+            continue;
+        }
+
+        for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.triangleCount; ++i)
+        {
+            const Triangle &triangle = m_triangles[i];
+            XMVECTOR e1x = XMVectorReplicate(triangle.edge1.x), e1y = XMVectorReplicate(triangle.edge1.y), e1z = XMVectorReplicate(triangle.edge1.z);
+            XMVECTOR e2x = XMVectorReplicate(triangle.edge2.x), e2y = XMVectorReplicate(triangle.edge2.y), e2z = XMVectorReplicate(triangle.edge2.z);
+
+            // p = d x e2, zero determinants give inf / nan and fail the range tests below
+            XMVECTOR px = XMVectorSubtract(XMVectorMultiply(dy, e2z), XMVectorMultiply(dz, e2y));
+            XMVECTOR py = XMVectorSubtract(XMVectorMultiply(dz, e2x), XMVectorMultiply(dx, e2z));
+            XMVECTOR pz = XMVectorSubtract(XMVectorMultiply(dx, e2y), XMVectorMultiply(dy, e2x));
+            XMVECTOR determinant = XMVectorMultiplyAdd(e1x, px, XMVectorMultiplyAdd(e1y, py, XMVectorMultiply(e1z, pz)));
+            XMVECTOR inverseDeterminant = XMVectorReciprocal(determinant);
+
+            XMVECTOR sx = XMVectorSubtract(ox, XMVectorReplicate(triangle.v0.x));
+            XMVECTOR sy = XMVectorSubtract(oy, XMVectorReplicate(triangle.v0.y));
+            XMVECTOR sz = XMVectorSubtract(oz, XMVectorReplicate(triangle.v0.z));
+            XMVECTOR u = XMVectorMultiply(XMVectorMultiplyAdd(sx, px, XMVectorMultiplyAdd(sy, py, XMVectorMultiply(sz, pz))), inverseDeterminant);
+
+            // q = s x e1
+            XMVECTOR qx = XMVectorSubtract(XMVectorMultiply(sy, e1z), XMVectorMultiply(sz, e1y));
+            XMVECTOR qy = XMVectorSubtract(XMVectorMultiply(sz, e1x), XMVectorMultiply(sx, e1z));
+            XMVECTOR qz = XMVectorSubtract(XMVectorMultiply(sx, e1y), XMVectorMultiply(sy, e1x));
+            XMVECTOR v = XMVectorMultiply(XMVectorMultiplyAdd(dx, qx, XMVectorMultiplyAdd(dy, qy, XMVectorMultiply(dz, qz))), inverseDeterminant);
+            XMVECTOR t = XMVectorMultiply(XMVectorMultiplyAdd(e2x, qx, XMVectorMultiplyAdd(e2y, qy, XMVectorMultiply(e2z, qz))), inverseDeterminant);
+
+            XMVECTOR mask = XMVectorAndInt(XMVectorGreaterOrEqual(u, zero), XMVectorGreaterOrEqual(v, zero));
+            mask = XMVectorAndInt(mask, XMVectorLessOrEqual(XMVectorAdd(u, v), one));
+            mask = XMVectorAndInt(mask, XMVectorAndInt(XMVectorGreaterOrEqual(t, zero), XMVectorLess(t, hitT)));
+            if (!isAnyLaneSet(mask))
+            {
+                continue;
+            }
+
+            hitT = XMVectorSelect(hitT, t, mask);
+            hitU = XMVectorSelect(hitU, u, mask);
+            hitV = XMVectorSelect(hitV, v, mask);
+            XMUINT4 laneMask;
+            XMStoreUInt4(&laneMask, mask);
+            const uint32_t laneBits[PACKET_SIZE] = {laneMask.x, laneMask.y, laneMask.z, laneMask.w};
+            for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane)
+            {
+                if (laneBits[lane])
+                {
+                    hitTriangles[lane] = m_triangleIds[i];
+                }
+            }
+        }
+    }
+
+    XMFLOAT4 t, u, v;
+    XMStoreFloat4(&t, hitT);
+    XMStoreFloat4(&u, hitU);
+    XMStoreFloat4(&v, hitV);
+    const float *laneT = &t.x, *laneU = &u.x, *laneV = &v.x;
+    for (size_t i = 0; i < rayCount; ++i)
+    {
+        hits[i] = hitTriangles[i] != INVALID_TRIANGLE ? Hit{laneT[i], hitTriangles[i], laneU[i], laneV[i]} : Hit();
+    }
+}
+
+bool MeshBvh::findClosestPoint(const XMFLOAT3 &point, float maxDistance, ClosestPoint &result) const
+{
+    if (m_nodes.empty())
+    {
+        return false;
+    }
+
+    XMVECTOR p = XMLoadFloat3(&point);
+    auto getBoxDistanceSq = [&](const Node &node)
+    {
+        XMVECTOR outside = XMVectorMax(XMVectorSubtract(XMLoadFloat3(&node.boundsMin), p), XMVectorSubtract(p, XMLoadFloat3(&node.boundsMax)));
+        outside = XMVectorMax(outside, XMVectorZero());
+        return XMVectorGetX(XMVector3LengthSq(outside));
+    };
+
+    float bestDistanceSq = maxDistance * maxDistance;
+    bool isFound = false;
+    struct Entry
+    {
+        uint32_t node;
+        float distanceSq;
+    };
+    Entry stack[STACK_SIZE];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = {0, getBoxDistanceSq(m_nodes[0])};
+
+    while (stackSize > 0)
+    {
+        Entry entry = stack[--stackSize];
+        if (entry.distanceSq > bestDistanceSq)
+        {
+            continue;
+        }
+
+        const Node &node = m_nodes[entry.node];
+        if (node.triangleCount > 0)
+        {
+            for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.triangleCount; ++i)
+            {
+                const Triangle &triangle = m_triangles[i];
+                XMVECTOR a = XMLoadFloat3(&triangle.v0);
+                XMVECTOR closest = getClosestPointOnTriangle(p, a, XMVectorAdd(a, XMLoadFloat3(&triangle.edge1)), XMVectorAdd(a, XMLoadFloat3(&triangle.edge2)));
+                float distanceSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(closest, p)));
+                if (distanceSq <= bestDistanceSq)
+                {
+                    bestDistanceSq = distanceSq;
+                    XMStoreFloat3(&result.point, closest);
+                    result.triangle = m_triangleIds[i];
+                    isFound = true;
+                }
+            }
+            continue;
+        }
+
+        Entry near = {node.leftOrFirst, getBoxDistanceSq(m_nodes[node.leftOrFirst])};
+        Entry far = {node.leftOrFirst + 1, getBoxDistanceSq(m_nodes[node.leftOrFirst + 1])};
+        if (far.distanceSq < near.distanceSq)
+        {
+            std::swap(near, far);
+        }
+        if (far.distanceSq <= bestDistanceSq && stackSize < STACK_SIZE)
+        {
+            stack[stackSize++] = far;
+        }
+        if (near.distanceSq <= bestDistanceSq && stackSize < STACK_SIZE)
+        {
+            stack[stackSize++] = near;
+        }
+    }
+
+    if (isFound)
+    {
+        result.distance = std::sqrt(bestDistanceSq);
+    }
+    return isFound;
+}
@@ -0,0 +1,225 @@
+#include "resources/mesh_cache.h"
+#include "utils/hash.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    const std::string CACHE_DIRECTORY = "cache/mesh/";
+
+    std::atomic<uint32_t> s_nextTempId = 0;
+
+    inline uint64_t alignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // `count` elements at `offset` lie inside the file, written so the multiplication cannot wrap
+    inline bool fitsFile(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t alignment, uint64_t fileSize)
+    {
+        return offset % alignment == 0 && offset <= fileSize && count <= (fileSize - offset) / elementSize;
+    }
+
+    // LODs and meshlets are ranges of the index array, meshlets also count vertices of the vertex array
+    bool hasValidRanges(const MeshCache::Header &header, const Meshlet *meshlets)
+    {
+        for (uint32_t i = 0; i < header.lodCount; ++i)
+        {
+            if (static_cast<uint64_t>(header.lods[i].firstIndex) + header.lods[i].indexCount > header.indexCount)
+            {
+                return false;
+            }
+        }
+        for (uint64_t i = 0; i < header.meshletCount; ++i)
+        {
+            const Meshlet &meshlet = meshlets[i];
+            if (static_cast<uint64_t>(meshlet.firstIndex) + static_cast<uint64_t>(meshlet.triangleCount) * 3 > header.indexCount ||
+                meshlet.vertexCount > header.vertexCount)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+std::string MeshCache::getCachePath(const std::string &sourcePath, uint32_t primitive, uint64_t optionsKey)
+{
+    // flatten the source path so every asset gets its own blob in one directory
+    std::string name = sourcePath;
+    for (char &c : name)
+    {
+        if (c == '/' || c == '\\' || c == ':')
+        {
+            c = '_';
+        }
+    }
+    if (primitive != 0)
+    {
+        name += "_p" + std::to_string(primitive);
+    }
+    // one blob per options, so meshes cooked differently from the same source don't replace each other
+    char key[17];
+    std::snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(optionsKey));
+    return CACHE_DIRECTORY + name + "_" + key + ".dxmesh";
+}
+
+bool MeshCache::getSourceStamp(const std::string &sourcePath, SourceStamp &stamp)
+{
+    std::error_code ec;
+    stamp.size = static_cast<uint64_t>(std::filesystem::file_size(sourcePath, ec));
+    if (ec)
+    {
+        return false;
+    }
+    stamp.writeTime = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, ec).time_since_epoch().count());
+    return !ec;
+}
+
+uint64_t MeshCache::hashSource(const std::string &sourcePath)
+{
+    MappedFile source(sourcePath);
+    return hashBytes(source.data(), source.size());
+}
+
+bool MeshCache::load(const std::string &sourcePath, uint32_t primitive, uint64_t optionsKey, CachedMesh &cached)
+{
+    std::string cachePath = getCachePath(sourcePath, primitive, optionsKey);
+    std::error_code ec;
+    if (!std::filesystem::exists(cachePath, ec))
+    {
+        return false;
+    }
+
+    std::unique_ptr<MappedFile> file;
+    try
+    {
+        file = std::make_unique<MappedFile>(cachePath);
+    }
+    catch (const std::exception &e)
+    {
+        Logger::Log(Logger::LogLevel::WARNING, "MeshCache::load: {}", e.what());
+        return false;
+    }
+
+    if (file->size() < sizeof(Header))
+    {
+        Logger::Log(Logger::LogLevel::WARNING, "MeshCache::load: {} is truncated, rebuilding", cachePath);
+        return false;
+    }
+
+    const Header *header = reinterpret_cast<const Header *>(file->data());
+    if (header->magic != MAGIC || header->version != VERSION || header->vertexStride != sizeof(Vertex) || header->optionsKey != optionsKey)
+    {
+        Logger::Log(Logger::LogLevel::INFO, "MeshCache::load: {} was cooked with another version or options, rebuilding", cachePath);
+        return false;
+    }
+    uint64_t fileSize = file->size();
+    if (header->lodCount == 0 || header->lodCount > MAX_MESH_LODS ||
+        !fitsFile(header->vertexOffset, header->vertexCount, sizeof(Vertex), alignof(Vertex), fileSize) ||
+        !fitsFile(header->indexOffset, header->indexCount, sizeof(uint32_t), alignof(uint32_t), fileSize) ||
+        !fitsFile(header->meshletOffset, header->meshletCount, sizeof(Meshlet), alignof(Meshlet), fileSize))
+    {
+        Logger::Log(Logger::LogLevel::WARNING, "MeshCache::load: {} is truncated, rebuilding", cachePath);
+        return false;
+    }
+    if (!hasValidRanges(*header, reinterpret_cast<const Meshlet *>(file->data() + header->meshletOffset)))
+    {
+        Logger::Log(Logger::LogLevel::WARNING, "MeshCache::load: {} has LODs or meshlets outside its buffers, rebuilding", cachePath);
+        return false;
+    }
+
+    SourceStamp stamp;
+    if (getSourceStamp(sourcePath, stamp))
+    {
+        if (stamp.size != header->sourceSize)
+        {
+            Logger::Log(Logger::LogLevel::INFO, "MeshCache::load: {} changed size, rebuilding", sourcePath);
+            return false;
+        }
+        // mtime moved (checkout, copy) but the size did not: only the content can tell
+        if (stamp.writeTime != header->sourceWriteTime && hashSource(sourcePath) != header->sourceHash)
+        {
+            Logger::Log(Logger::LogLevel::INFO, "MeshCache::load: {} changed content, rebuilding", sourcePath);
+            return false;
+        }
+    }
+
+    cached.header = header;
+    cached.vertices = reinterpret_cast<const Vertex *>(file->data() + header->vertexOffset);
+    cached.indices = reinterpret_cast<const uint32_t *>(file->data() + header->indexOffset);
+    cached.meshlets = reinterpret_cast<const Meshlet *>(file->data() + header->meshletOffset);
+    cached.file = std::move(file);
+    return true;
+}
+
+void MeshCache::save(const std::string &sourcePath, uint32_t primitive, uint64_t optionsKey, float sourceLoadMs, const MeshBounds &bounds,
+                     const std::vector<MeshLod> &lods, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices,
+                     const std::vector<Meshlet> &meshlets)
+{
+    std::string cachePath = getCachePath(sourcePath, primitive, optionsKey);
+    // unique per writer, two threads cooking the same mesh must not write into each other's file
+    std::string tempPath = cachePath + "." + std::to_string(s_nextTempId++) + ".tmp";
+
+    try
+    {
+        SourceStamp stamp;
+        if (!getSourceStamp(sourcePath, stamp))
+        {
+            return;
+        }
+
+        Header header = {};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.vertexStride = sizeof(Vertex);
+        header.optionsKey = optionsKey;
+        header.sourceSize = stamp.size;
+        header.sourceWriteTime = stamp.writeTime;
+        header.sourceHash = hashSource(sourcePath);
+        header.sourceLoadMs = sourceLoadMs;
+        header.bounds = bounds;
+        header.lodCount = static_cast<uint32_t>(std::min<size_t>(lods.size(), MAX_MESH_LODS));
+        std::copy(lods.begin(), lods.begin() + header.lodCount, header.lods);
+        header.vertexCount = vertices.size();
+        header.indexCount = indices.size();
+        header.meshletCount = meshlets.size();
+        header.vertexOffset = alignUp(sizeof(Header), 16);
+        header.indexOffset = alignUp(header.vertexOffset + vertices.size() * sizeof(Vertex), 16);
+        header.meshletOffset = alignUp(header.indexOffset + indices.size() * sizeof(uint32_t), 16);
+
+        std::filesystem::create_directories(CACHE_DIRECTORY);
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out)
+            {
+                throw std::runtime_error("MeshCache::save: Failed to open " + tempPath);
+            }
+
+            const char padding[16] = {};
+            out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+            out.write(padding, static_cast<std::streamsize>(header.vertexOffset - sizeof(Header)));
+            out.write(reinterpret_cast<const char *>(vertices.data()), static_cast<std::streamsize>(vertices.size() * sizeof(Vertex)));
+            out.write(padding, static_cast<std::streamsize>(header.indexOffset - header.vertexOffset - vertices.size() * sizeof(Vertex)));
+            out.write(reinterpret_cast<const char *>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(uint32_t)));
+            out.write(padding, static_cast<std::streamsize>(header.meshletOffset - header.indexOffset - indices.size() * sizeof(uint32_t)));
+            out.write(reinterpret_cast<const char *>(meshlets.data()), static_cast<std::streamsize>(meshlets.size() * sizeof(Meshlet)));
+            if (!out)
+            {
+                throw std::runtime_error("MeshCache::save: Failed to write " + tempPath);
+            }
+        }
+
+        // replace atomically so a crash never leaves a half-written blob behind
+        std::filesystem::rename(tempPath, cachePath);
+    }
+    catch (const std::exception &e)
+    {
+        Logger::Log(Logger::LogLevel::WARNING, "MeshCache::save: {}: {}", cachePath, e.what());
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+    }
+}
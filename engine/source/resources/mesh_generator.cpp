@@ -0,0 +1,280 @@
+#include "resources/mesh_generator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    constexpr float POLE_EPSILON = 1e-6f;
+
+    DirectX::XMFLOAT3 directionFromUV(float u, float v)
+    {
+        float theta = v * DirectX::XM_PI;
+        float phi = (0.75f - u) * DirectX::XM_2PI;
+        return {std::sin(theta) * std::sin(phi), std::cos(theta), std::sin(theta) * std::cos(phi)};
+    }
+
+    float longitudeU(const DirectX::XMFLOAT3 &direction) // [0, 1)
+    {
+        float u = 0.75f - std::atan2(direction.x, direction.z) / DirectX::XM_2PI;
+        return u - std::floor(u);
+    }
+
+    float latitudeV(const DirectX::XMFLOAT3 &direction)
+    {
+        return std::acos(std::clamp(direction.y, -1.f, 1.f)) / DirectX::XM_PI;
+    }
+
+    bool isPole(const DirectX::XMFLOAT3 &direction)
+    {
+        return std::fabs(direction.x) < POLE_EPSILON && std::fabs(direction.z) < POLE_EPSILON;
+    }
+
+    // front faces are clockwise seen from the outside, i.e. (b - a) x (c - a) points to the center
+    void addTriangle(const DirectX::XMFLOAT3 *positions, std::vector<uint32_t> &indices, uint32_t a, uint32_t b, uint32_t c)
+    {
+        DirectX::XMVECTOR pa = DirectX::XMLoadFloat3(&positions[a]);
+        DirectX::XMVECTOR pb = DirectX::XMLoadFloat3(&positions[b]);
+        DirectX::XMVECTOR pc = DirectX::XMLoadFloat3(&positions[c]);
+        DirectX::XMVECTOR normal = DirectX::XMVector3Cross(DirectX::XMVectorSubtract(pb, pa), DirectX::XMVectorSubtract(pc, pa));
+        DirectX::XMVECTOR centroid = DirectX::XMVectorAdd(DirectX::XMVectorAdd(pa, pb), pc);
+        if (DirectX::XMVectorGetX(DirectX::XMVector3Dot(normal, centroid)) > 0.f)
+        {
+            std::swap(b, c);
+        }
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    }
+
+    struct Icosphere
+    {
+        std::vector<DirectX::XMFLOAT3> positions;          // unit, shared by every level
+        std::vector<std::vector<uint32_t>> levelTriangles; // position indices per subdivision level
+    };
+
+    Icosphere buildIcosphere(uint32_t subdivisions)
+    {
+        Icosphere sphere;
+        std::vector<DirectX::XMFLOAT3> &positions = sphere.positions;
+
+        // poles on y, two rings of five at +-atan(1 / 2) latitude, the lower one rotated by 36 deg
+        float ringY = 1.f / std::sqrt(5.f);
+        float ringRadius = 2.f / std::sqrt(5.f);
+        positions.push_back({0.f, 1.f, 0.f});
+        for (int ring = 0; ring < 2; ++ring)
+        {
+            for (int k = 0; k < 5; ++k)
+            {
+                float phi = DirectX::XMConvertToRadians(72.f * k + 36.f * ring);
+                positions.push_back({ringRadius * std::sin(phi), ring == 0 ? ringY : -ringY, ringRadius * std::cos(phi)});
+            }
+        }
+        positions.push_back({0.f, -1.f, 0.f});
+
+        std::vector<uint32_t> triangles;
+        for (uint32_t k = 0; k < 5; ++k)
+        {
+            uint32_t upper = 1 + k, upperNext = 1 + (k + 1) % 5;
+            uint32_t lower = 6 + k, lowerNext = 6 + (k + 1) % 5;
+            addTriangle(positions.data(), triangles, 0, upper, upperNext);
+            addTriangle(positions.data(), triangles, upper, lower, upperNext);
+            addTriangle(positions.data(), triangles, upperNext, lower, lowerNext);
+            addTriangle(positions.data(), triangles, 11, lower, lowerNext);
+        }
+        sphere.levelTriangles.push_back(triangles);
+
+        // split every triangle in four, edge midpoints are shared through the cache
+        std::unordered_map<uint64_t, uint32_t> midpoints;
+        auto midpoint = [&](uint32_t a, uint32_t b)
+        {
+            uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+            auto it = midpoints.find(key);
+            if (it != midpoints.end())
+            {
+                return it->second;
+            }
+            DirectX::XMVECTOR mid = DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&positions[a]), DirectX::XMLoadFloat3(&positions[b]));
+            DirectX::XMFLOAT3 position;
+            DirectX::XMStoreFloat3(&position, DirectX::XMVector3Normalize(mid));
+            positions.push_back(position);
+            uint32_t index = static_cast<uint32_t>(positions.size() - 1);
+            midpoints.emplace(key, index);
+            return index;
+        };
+
+        for (uint32_t level = 1; level <= subdivisions; ++level)
+        {
+            const std::vector<uint32_t> &coarse = sphere.levelTriangles.back();
+            std::vector<uint32_t> fine;
+            fine.reserve(coarse.size() * 4);
+            for (size_t t = 0; t < coarse.size(); t += 3)
+            {
+                uint32_t a = coarse[t], b = coarse[t + 1], c = coarse[t + 2];
+                uint32_t ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+                uint32_t split[12] = {a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca}; // same winding as the parent
+                fine.insert(fine.end(), split, split + 12);
+            }
+            sphere.levelTriangles.push_back(std::move(fine));
+        }
+        return sphere;
+    }
+
+    // Unwraps a level onto the equirectangular map. A triangle spanning the seam gets the vertices of its low side
+    // shifted by +1 in u (needs wrap addressing), pole vertices take the u of their triangle, both by duplication.
+    float appendLevel(const std::vector<DirectX::XMFLOAT3> &positions, const std::vector<uint32_t> &triangles, float radius,
+                      std::unordered_map<uint64_t, uint32_t> &vertexIds, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
+    {
+        auto emit = [&](uint32_t position, float u)
+        {
+            uint32_t uBits;
+            std::memcpy(&uBits, &u, sizeof(uBits));
+            uint64_t key = (static_cast<uint64_t>(position) << 32) | uBits;
+            auto it = vertexIds.find(key);
+            if (it != vertexIds.end())
+            {
+                return it->second;
+            }
+            const DirectX::XMFLOAT3 &direction = positions[position];
+            vertices.emplace_back(DirectX::XMFLOAT3(direction.x * radius, direction.y * radius, direction.z * radius), direction,
+                                  DirectX::XMFLOAT2(u, latitudeV(direction)));
+            uint32_t index = static_cast<uint32_t>(vertices.size() - 1);
+            vertexIds.emplace(key, index);
+            return index;
+        };
+
+        float minPlaneDistance = 1.f;
+        for (size_t t = 0; t < triangles.size(); t += 3)
+        {
+            const uint32_t *tri = &triangles[t];
+            float u[3];
+            bool pole[3];
+            float minU = 1.f, maxU = 0.f;
+            for (int k = 0; k < 3; ++k)
+            {
+                pole[k] = isPole(positions[tri[k]]);
+                u[k] = longitudeU(positions[tri[k]]);
+                if (!pole[k])
+                {
+                    minU = std::min(minU, u[k]);
+                    maxU = std::max(maxU, u[k]);
+                }
+            }
+
+            float poleU = 0.f;
+            int ringCount = 0;
+            for (int k = 0; k < 3; ++k)
+            {
+                if (pole[k])
+                {
+                    continue;
+                }
+                if (maxU - minU > 0.5f && u[k] < 0.5f)
+                {
+                    u[k] += 1.f;
+                }
+                poleU += u[k];
+                ++ringCount;
+            }
+            for (int k = 0; k < 3; ++k)
+            {
+                if (pole[k])
+                {
+                    u[k] = ringCount > 0 ? poleU / ringCount : 0.5f;
+                }
+                indices.push_back(emit(tri[k], u[k]));
+            }
+
+            // the flat triangle's plane is where the level deviates the most from the sphere
+            DirectX::XMVECTOR pa = DirectX::XMLoadFloat3(&positions[tri[0]]);
+            DirectX::XMVECTOR normal = DirectX::XMVector3Normalize(DirectX::XMVector3Cross(
+                DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&positions[tri[1]]), pa),
+                DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&positions[tri[2]]), pa)));
+            minPlaneDistance = std::min(minPlaneDistance, std::fabs(DirectX::XMVectorGetX(DirectX::XMVector3Dot(normal, pa))));
+        }
+        return radius * (1.f - minPlaneDistance);
+    }
+}
+
+void MeshGenerator::createUVSphere(uint32_t segments, uint32_t rings, float radius, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+    segments = std::max(segments, 3u);
+    rings = std::max(rings, 2u);
+    vertices.clear();
+    indices.clear();
+    vertices.reserve(2 * segments + (rings - 1) * (segments + 1));
+    indices.reserve(6 * segments * (rings - 1));
+
+    auto addVertex = [&](float u, float v)
+    {
+        DirectX::XMFLOAT3 direction = directionFromUV(u, v);
+        vertices.emplace_back(DirectX::XMFLOAT3(direction.x * radius, direction.y * radius, direction.z * radius), direction, DirectX::XMFLOAT2(u, v));
+    };
+
+    // north pole, ring 1 .. rings - 1 with the seam column duplicated, south pole
+    for (uint32_t j = 0; j < segments; ++j)
+    {
+        addVertex((j + 0.5f) / segments, 0.f);
+    }
+    for (uint32_t i = 1; i < rings; ++i)
+    {
+        for (uint32_t j = 0; j <= segments; ++j)
+        {
+            addVertex(static_cast<float>(j) / segments, static_cast<float>(i) / rings);
+        }
+    }
+    uint32_t southPole = static_cast<uint32_t>(vertices.size());
+    for (uint32_t j = 0; j < segments; ++j)
+    {
+        addVertex((j + 0.5f) / segments, 1.f);
+    }
+
+    std::vector<DirectX::XMFLOAT3> positions(vertices.size());
+    std::transform(vertices.begin(), vertices.end(), positions.begin(), [](const Vertex &vertex)
+                   { return vertex.pos; });
+    auto ringVertex = [segments](uint32_t ring, uint32_t column)
+    { return segments + (ring - 1) * (segments + 1) + column; };
+
+    for (uint32_t j = 0; j < segments; ++j)
+    {
+        addTriangle(positions.data(), indices, j, ringVertex(1, j), ringVertex(1, j + 1));
+    }
+    for (uint32_t i = 1; i + 1 < rings; ++i)
+    {
+        for (uint32_t j = 0; j < segments; ++j)
+        {
+            addTriangle(positions.data(), indices, ringVertex(i, j), ringVertex(i + 1, j), ringVertex(i, j + 1));
+            addTriangle(positions.data(), indices, ringVertex(i, j + 1), ringVertex(i + 1, j), ringVertex(i + 1, j + 1));
+        }
+    }
+    for (uint32_t j = 0; j < segments; ++j)
+    {
+        addTriangle(positions.data(), indices, southPole + j, ringVertex(rings - 1, j), ringVertex(rings - 1, j + 1));
+    }
+}
+
+void MeshGenerator::createIcosphere(uint32_t subdivisions, float radius, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+    std::vector<MeshLod> lods;
+    createIcosphereLods(subdivisions, 1, radius, vertices, indices, lods);
+}
+
+void MeshGenerator::createIcosphereLods(uint32_t subdivisions, uint32_t lodCount, float radius,
+                                        std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, std::vector<MeshLod> &lods)
+{
+    lodCount = std::clamp(lodCount, 1u, std::min(subdivisions + 1, MAX_MESH_LODS));
+    Icosphere sphere = buildIcosphere(subdivisions);
+
+    vertices.clear();
+    indices.clear();
+    lods.clear();
+    std::unordered_map<uint64_t, uint32_t> vertexIds;
+    for (uint32_t lod = 0; lod < lodCount; ++lod)
+    {
+        const std::vector<uint32_t> &triangles = sphere.levelTriangles[subdivisions - lod];
+        uint32_t firstIndex = static_cast<uint32_t>(indices.size());
+        float error = appendLevel(sphere.positions, triangles, radius, vertexIds, vertices, indices);
+        lods.push_back({firstIndex, static_cast<uint32_t>(triangles.size()), lod == 0 ? 0.f : error}); // coarse levels lie within error of LOD0 too
+    }
+}
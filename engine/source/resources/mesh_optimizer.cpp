@@ -0,0 +1,553 @@
+#include "resources/mesh_optimizer.h"
+#include "resources/mesh_bounds.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFFu;
+
+    size_t nextPowerOfTwo(size_t value)
+    {
+        size_t result = 16;
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    inline uint32_t hashInt3(int32_t x, int32_t y, int32_t z)
+    {
+        uint32_t h = static_cast<uint32_t>(x) * 0x8DA6B343u;
+        h ^= static_cast<uint32_t>(y) * 0xD8163841u;
+        h ^= static_cast<uint32_t>(z) * 0xCB1AB31Fu;
+        h ^= h >> 16;
+        h *= 0x7FEB352Du;
+        h ^= h >> 15;
+        return h;
+    }
+
+    inline bool equalInt3(const DirectX::XMINT3 &a, const DirectX::XMINT3 &b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+    inline bool nearlyEqual(const Vertex &a, const Vertex &b, float epsilon)
+    {
+        return std::fabs(a.pos.x - b.pos.x) <= epsilon && std::fabs(a.pos.y - b.pos.y) <= epsilon && std::fabs(a.pos.z - b.pos.z) <= epsilon &&
+               std::fabs(a.n.x - b.n.x) <= epsilon && std::fabs(a.n.y - b.n.y) <= epsilon && std::fabs(a.n.z - b.n.z) <= epsilon &&
+               std::fabs(a.uv.x - b.uv.x) <= epsilon && std::fabs(a.uv.y - b.uv.y) <= epsilon;
+    }
+
+    inline int32_t toCell(float value, float invCellSize)
+    {
+        double cell = std::floor(static_cast<double>(value) * invCellSize);
+        cell = std::fmax(-2147483647.0, std::fmin(2147483647.0, cell));
+        return static_cast<int32_t>(cell);
+    }
+}
+
+size_t MeshOptimizer::getBufferBytes(size_t vertexCount, size_t indexCount)
+{
+    return vertexCount * sizeof(Vertex) + indexCount * sizeof(uint32_t);
+}
+
+MeshOptimizer::IndexingStats MeshOptimizer::indexCorners(const ObjParser::Result &obj, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+    const std::vector<DirectX::XMINT3> &corners = obj.corners;
+    size_t cornerCount = corners.size();
+
+    // open addressing, linear probing, slots hold the unique vertex index
+    size_t tableSize = nextPowerOfTwo(cornerCount * 2);
+    size_t mask = tableSize - 1;
+    std::vector<uint32_t> table(tableSize, EMPTY_SLOT);
+    std::vector<uint32_t> uniqueCorners; // first corner of each unique vertex
+    uniqueCorners.reserve(cornerCount / 2);
+
+    indices.resize(cornerCount);
+    for (size_t i = 0; i < cornerCount; ++i)
+    {
+        const DirectX::XMINT3 &key = corners[i];
+        size_t slot = hashInt3(key.x, key.y, key.z) & mask;
+        while (table[slot] != EMPTY_SLOT && !equalInt3(corners[uniqueCorners[table[slot]]], key))
+        {
+            slot = (slot + 1) & mask;
+        }
+        if (table[slot] == EMPTY_SLOT)
+        {
+            table[slot] = static_cast<uint32_t>(uniqueCorners.size());
+            uniqueCorners.push_back(static_cast<uint32_t>(i));
+        }
+        indices[i] = table[slot];
+    }
+
+    vertices.clear();
+    vertices.reserve(uniqueCorners.size());
+    for (uint32_t cornerIndex : uniqueCorners)
+    {
+        const DirectX::XMINT3 &corner = corners[cornerIndex];
+        vertices.push_back({obj.positions[corner.x], obj.normals[corner.z], obj.texCoords[corner.y]}); // v, n, t
+    }
+
+    IndexingStats stats;
+    stats.vertexCountBefore = cornerCount;
+    stats.vertexCountAfter = vertices.size();
+    stats.bytesBefore = getBufferBytes(cornerCount, cornerCount);
+    stats.bytesAfter = getBufferBytes(vertices.size(), indices.size());
+    return stats;
+}
+
+MeshOptimizer::IndexingStats MeshOptimizer::weldVertices(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, float epsilon, std::vector<MeshLod> *lods)
+{
+    IndexingStats stats;
+    stats.vertexCountBefore = vertices.size();
+    stats.bytesBefore = getBufferBytes(vertices.size(), indices.size());
+
+    if (epsilon <= 0.f || vertices.empty())
+    {
+        stats.vertexCountAfter = stats.vertexCountBefore;
+        stats.bytesAfter = stats.bytesBefore;
+        return stats;
+    }
+
+    // spatial hash with cell size = epsilon, so any match lies in one of the 27 neighbouring cells
+    struct Cell
+    {
+        int32_t x, y, z;
+        uint32_t head; // first kept vertex in this cell, chained through `next`
+    };
+
+    float invCellSize = 1.f / epsilon;
+    size_t tableSize = nextPowerOfTwo(vertices.size() * 2);
+    size_t mask = tableSize - 1;
+    std::vector<Cell> cells(tableSize, {0, 0, 0, EMPTY_SLOT});
+    std::vector<uint32_t> next(vertices.size(), EMPTY_SLOT);
+    std::vector<uint32_t> remap(vertices.size(), EMPTY_SLOT);
+    std::vector<Vertex> welded;
+    welded.reserve(vertices.size());
+    std::vector<uint32_t> keptSource; // welded index -> source vertex
+    keptSource.reserve(vertices.size());
+
+    auto findCell = [&cells, mask](int32_t x, int32_t y, int32_t z) -> size_t
+    {
+        size_t slot = hashInt3(x, y, z) & mask;
+        while (cells[slot].head != EMPTY_SLOT && (cells[slot].x != x || cells[slot].y != y || cells[slot].z != z))
+        {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    };
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        const Vertex &vertex = vertices[i];
+        int32_t cx = toCell(vertex.pos.x, invCellSize);
+        int32_t cy = toCell(vertex.pos.y, invCellSize);
+        int32_t cz = toCell(vertex.pos.z, invCellSize);
+
+        uint32_t match = EMPTY_SLOT;
+        for (int32_t dz = -1; dz <= 1 && match == EMPTY_SLOT; ++dz)
+        {
+            for (int32_t dy = -1; dy <= 1 && match == EMPTY_SLOT; ++dy)
+            {
+                for (int32_t dx = -1; dx <= 1 && match == EMPTY_SLOT; ++dx)
+                {
+                    const Cell &cell = cells[findCell(cx + dx, cy + dy, cz + dz)];
+                    for (uint32_t k = cell.head; k != EMPTY_SLOT; k = next[k])
+                    {
+                        if (nearlyEqual(vertices[keptSource[k]], vertex, epsilon))
+                        {
+                            match = k;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (match == EMPTY_SLOT)
+        {
+            match = static_cast<uint32_t>(welded.size());
+            welded.push_back(vertex);
+            keptSource.push_back(static_cast<uint32_t>(i));
+
+            Cell &cell = cells[findCell(cx, cy, cz)];
+            if (cell.head == EMPTY_SLOT)
+            {
+                cell.x = cx;
+                cell.y = cy;
+                cell.z = cz;
+            }
+            next[match] = cell.head;
+            cell.head = match;
+        }
+        remap[i] = match;
+    }
+
+    // remap indices and drop triangles that collapsed, keptBefore[t] = indices kept ahead of triangle t
+    std::vector<uint32_t> weldedIndices;
+    weldedIndices.reserve(indices.size());
+    std::vector<uint32_t> keptBefore;
+    keptBefore.reserve(lods ? indices.size() / 3 + 1 : 0);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        if (lods)
+        {
+            keptBefore.push_back(static_cast<uint32_t>(weldedIndices.size()));
+        }
+        uint32_t a = remap[indices[i]];
+        uint32_t b = remap[indices[i + 1]];
+        uint32_t c = remap[indices[i + 2]];
+        if (a != b && b != c && a != c)
+        {
+            weldedIndices.push_back(a);
+            weldedIndices.push_back(b);
+            weldedIndices.push_back(c);
+        }
+    }
+
+    if (lods)
+    {
+        // each range shrinks to the triangles it keeps, ranges that don't fit the buffer are left for the caller to reject
+        keptBefore.push_back(static_cast<uint32_t>(weldedIndices.size()));
+        for (MeshLod &lod : *lods)
+        {
+            size_t lodEnd = static_cast<size_t>(lod.firstIndex) + lod.indexCount;
+            if (lod.firstIndex % 3 != 0 || lod.indexCount % 3 != 0 || lodEnd > indices.size() / 3 * 3)
+            {
+                continue;
+            }
+            uint32_t firstIndex = keptBefore[lod.firstIndex / 3];
+            lod.indexCount = keptBefore[lodEnd / 3] - firstIndex;
+            lod.firstIndex = firstIndex;
+        }
+    }
+
+    vertices.swap(welded);
+    indices.swap(weldedIndices);
+
+    stats.vertexCountAfter = vertices.size();
+    stats.bytesAfter = getBufferBytes(vertices.size(), indices.size());
+    return stats;
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::analyzeVertexCache(const uint32_t *indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    if (indexCount < 3 || vertexCount == 0)
+    {
+        return stats;
+    }
+
+    // FIFO: a vertex is resident while fewer than `cacheSize` misses happened since it was loaded
+    std::vector<size_t> loadedAt(vertexCount, 0);
+    std::vector<uint8_t> seen(vertexCount, 0);
+    size_t misses = 0;
+    size_t uniqueVertices = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t index = indices[i];
+        if (!seen[index])
+        {
+            seen[index] = 1;
+            ++uniqueVertices;
+        }
+        else if (misses - loadedAt[index] < cacheSize)
+        {
+            continue;
+        }
+        loadedAt[index] = misses++;
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(uniqueVertices);
+    return stats;
+}
+
+namespace
+{
+    // Forsyth, "Linear-Speed Vertex Cache Optimisation"
+    constexpr int32_t FORSYTH_CACHE_SIZE = 32;
+    constexpr uint32_t FORSYTH_MAX_VALENCE = 32;
+    constexpr float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+    constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.f;
+    constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+    struct ForsythTables
+    {
+        float cacheScore[FORSYTH_CACHE_SIZE + 3];
+        float valenceScore[FORSYTH_MAX_VALENCE + 1];
+
+        ForsythTables()
+        {
+            for (int32_t i = 0; i < FORSYTH_CACHE_SIZE + 3; ++i)
+            {
+                if (i < 3)
+                {
+                    cacheScore[i] = FORSYTH_LAST_TRIANGLE_SCORE; // the last triangle's vertices, fixed so it is not re-used immediately
+                }
+                else if (i < FORSYTH_CACHE_SIZE)
+                {
+                    float scaler = 1.f / static_cast<float>(FORSYTH_CACHE_SIZE - 3);
+                    cacheScore[i] = std::pow(1.f - static_cast<float>(i - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+                }
+                else
+                {
+                    cacheScore[i] = 0.f; // overflow slots, about to be evicted
+                }
+            }
+            valenceScore[0] = 0.f;
+            for (uint32_t i = 1; i <= FORSYTH_MAX_VALENCE; ++i)
+            {
+                valenceScore[i] = FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -FORSYTH_VALENCE_BOOST_POWER);
+            }
+        }
+
+        float vertexScore(int32_t cachePosition, uint32_t remaining) const
+        {
+            if (remaining == 0)
+            {
+                return -1.f; // no triangle needs it anymore
+            }
+            float score = cachePosition >= 0 ? cacheScore[cachePosition] : 0.f;
+            return score + valenceScore[std::min(remaining, FORSYTH_MAX_VALENCE)];
+        }
+    };
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount)
+{
+    static const ForsythTables tables;
+
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+    {
+        return;
+    }
+
+    // vertex -> adjacent triangles, CSR layout; the live part of each list shrinks as triangles are emitted
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+    {
+        ++remaining[indices[i]];
+    }
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+            }
+        }
+    }
+
+    std::vector<int32_t> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+    {
+        vertexScores[v] = tables.vertexScore(-1, remaining[v]);
+    }
+    std::vector<uint8_t> emitted(triangleCount, 0);
+
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+    uint32_t cache[FORSYTH_CACHE_SIZE + 3];
+    uint32_t newCache[FORSYTH_CACHE_SIZE + 3];
+    int32_t cacheCount = 0;
+    size_t scanCursor = 0;
+
+    uint32_t best = EMPTY_SLOT;
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        if (best == EMPTY_SLOT)
+        {
+            // nothing in the cache touches a live triangle, restart from the first one left
+            while (emitted[scanCursor])
+            {
+                ++scanCursor;
+            }
+            best = static_cast<uint32_t>(scanCursor);
+        }
+
+        const uint32_t *triangle = &indices[best * 3];
+        emitted[best] = 1;
+        output.insert(output.end(), triangle, triangle + 3);
+
+        // drop the triangle from its vertices' adjacency
+        for (size_t k = 0; k < 3; ++k)
+        {
+            uint32_t v = triangle[k];
+            uint32_t *list = &adjacency[adjacencyOffsets[v]];
+            uint32_t count = remaining[v];
+            for (uint32_t j = 0; j < count; ++j)
+            {
+                if (list[j] == best)
+                {
+                    list[j] = list[count - 1];
+                    break;
+                }
+            }
+            --remaining[v];
+        }
+
+        // LRU: the triangle's vertices move to the front, the overflow falls out
+        int32_t newCount = 0;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            newCache[newCount++] = triangle[k];
+        }
+        for (int32_t i = 0; i < cacheCount; ++i)
+        {
+            uint32_t v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+            {
+                newCache[newCount++] = v;
+            }
+        }
+        for (int32_t i = FORSYTH_CACHE_SIZE; i < newCount; ++i)
+        {
+            cachePosition[newCache[i]] = -1;
+            vertexScores[newCache[i]] = tables.vertexScore(-1, remaining[newCache[i]]);
+        }
+        cacheCount = std::min(newCount, FORSYTH_CACHE_SIZE);
+        std::copy(newCache, newCache + cacheCount, cache);
+
+        for (int32_t i = 0; i < cacheCount; ++i)
+        {
+            cachePosition[cache[i]] = i;
+            vertexScores[cache[i]] = tables.vertexScore(i, remaining[cache[i]]);
+        }
+
+        // rescore the live triangles around the cache and pick the best, lowest index wins ties
+        best = EMPTY_SLOT;
+        float bestScore = -1.f;
+        for (int32_t i = 0; i < cacheCount; ++i)
+        {
+            uint32_t v = cache[i];
+            const uint32_t *list = &adjacency[adjacencyOffsets[v]];
+            for (uint32_t j = 0; j < remaining[v]; ++j)
+            {
+                uint32_t t = list[j];
+                float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                if (score > bestScore || (score == bestScore && t < best))
+                {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+    }
+
+    indices.swap(output);
+}
+
+void MeshOptimizer::optimizeOverdraw(const std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, float threshold)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2)
+    {
+        return;
+    }
+
+    // cluster boundaries where the cache order restarts (a triangle with three misses)
+    std::vector<size_t> clusterStarts;
+    {
+        std::vector<size_t> loadedAt(vertices.size(), 0);
+        std::vector<uint8_t> seen(vertices.size(), 0);
+        size_t misses = 0;
+        for (size_t t = 0; t < triangleCount; ++t)
+        {
+            size_t triangleMisses = 0;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                uint32_t index = indices[t * 3 + k];
+                if (!seen[index] || misses - loadedAt[index] >= ANALYZE_CACHE_SIZE)
+                {
+                    seen[index] = 1;
+                    loadedAt[index] = misses++;
+                    ++triangleMisses;
+                }
+            }
+            if (t == 0 || triangleMisses == 3)
+            {
+                clusterStarts.push_back(t);
+            }
+        }
+    }
+    if (clusterStarts.size() < 2)
+    {
+        return;
+    }
+
+    MeshBounds bounds = MeshBounds::compute(&vertices[0].pos, vertices.size(), sizeof(Vertex));
+    DirectX::XMVECTOR meshCenter = DirectX::XMLoadFloat3(&bounds.sphereCenter);
+
+    struct Cluster
+    {
+        size_t firstTriangle;
+        size_t triangleCount;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters(clusterStarts.size());
+    for (size_t c = 0; c < clusterStarts.size(); ++c)
+    {
+        size_t first = clusterStarts[c];
+        size_t last = (c + 1 < clusterStarts.size()) ? clusterStarts[c + 1] : triangleCount;
+
+        DirectX::XMVECTOR centroid = DirectX::XMVectorZero();
+        DirectX::XMVECTOR normal = DirectX::XMVectorZero();
+        for (size_t i = first * 3; i < last * 3; ++i)
+        {
+            const Vertex &vertex = vertices[indices[i]];
+            centroid = DirectX::XMVectorAdd(centroid, DirectX::XMLoadFloat3(&vertex.pos));
+            normal = DirectX::XMVectorAdd(normal, DirectX::XMLoadFloat3(&vertex.n));
+        }
+        centroid = DirectX::XMVectorScale(centroid, 1.f / static_cast<float>((last - first) * 3));
+        normal = DirectX::XMVector3Normalize(normal);
+
+        clusters[c] = {first, last - first, DirectX::XMVectorGetX(DirectX::XMVector3Dot(DirectX::XMVectorSubtract(centroid, meshCenter), normal))};
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster &a, const Cluster &b)
+                     { return a.sortKey > b.sortKey; });
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(indices.size());
+    for (const Cluster &cluster : clusters)
+    {
+        sorted.insert(sorted.end(), indices.begin() + cluster.firstTriangle * 3, indices.begin() + (cluster.firstTriangle + cluster.triangleCount) * 3);
+    }
+
+    float acmrBefore = analyzeVertexCache(indices.data(), indices.size(), vertices.size()).acmr;
+    float acmrAfter = analyzeVertexCache(sorted.data(), sorted.size(), vertices.size()).acmr;
+    if (acmrAfter <= acmrBefore * threshold)
+    {
+        indices.swap(sorted);
+    }
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), EMPTY_SLOT);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+    for (uint32_t &index : indices)
+    {
+        if (remap[index] == EMPTY_SLOT)
+        {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(reordered);
+}
@@ -0,0 +1,360 @@
+#include "resources/mesh_simplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+
+namespace
+{
+    constexpr uint32_t INVALID_ID = 0xFFFFFFFFu;
+    constexpr float SEAM_UV_EPSILON = 1e-6f;
+
+    // symmetric 4x4 plane quadric, accumulated in double
+    struct Quadric
+    {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+        double weight = 0;
+
+        static Quadric fromPlane(double a, double b, double c, double d, double weight)
+        {
+            Quadric q;
+            q.a2 = a * a * weight, q.ab = a * b * weight, q.ac = a * c * weight, q.ad = a * d * weight;
+            q.b2 = b * b * weight, q.bc = b * c * weight, q.bd = b * d * weight;
+            q.c2 = c * c * weight, q.cd = c * d * weight;
+            q.d2 = d * d * weight;
+            q.weight = weight;
+            return q;
+        }
+
+        void add(const Quadric &q)
+        {
+            a2 += q.a2, ab += q.ab, ac += q.ac, ad += q.ad;
+            b2 += q.b2, bc += q.bc, bd += q.bd;
+            c2 += q.c2, cd += q.cd;
+            d2 += q.d2;
+            weight += q.weight;
+        }
+
+        // mean squared distance to the accumulated planes
+        double evaluate(const DirectX::XMFLOAT3 &p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double sum = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x +
+                         b2 * y * y + 2 * bc * y * z + 2 * bd * y +
+                         c2 * z * z + 2 * cd * z +
+                         d2;
+            return weight > 0 ? std::fabs(sum) / weight : 0;
+        }
+    };
+
+    struct Collapse
+    {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+        uint32_t fromVersion;
+        uint32_t toVersion;
+
+        bool operator>(const Collapse &other) const
+        {
+            // deterministic order for equal costs
+            if (cost != other.cost)
+                return cost > other.cost;
+            if (from != other.from)
+                return from > other.from;
+            return to > other.to;
+        }
+    };
+
+    inline bool equalPosition(const DirectX::XMFLOAT3 &a, const DirectX::XMFLOAT3 &b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+    inline DirectX::XMVECTOR triangleNormal(const DirectX::XMFLOAT3 &a, const DirectX::XMFLOAT3 &b, const DirectX::XMFLOAT3 &c)
+    {
+        DirectX::XMVECTOR va = DirectX::XMLoadFloat3(&a);
+        return DirectX::XMVector3Cross(DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&b), va), DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&c), va));
+    }
+}
+
+MeshSimplifier::Result MeshSimplifier::simplify(const std::vector<Vertex> &vertices, const uint32_t *indices, size_t indexCount,
+                                                size_t targetIndexCount, float targetError, std::vector<uint32_t> &result)
+{
+    size_t vertexCount = vertices.size();
+
+    // weld by exact position, sorted so ids are deterministic
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&vertices](uint32_t a, uint32_t b)
+              {
+        const DirectX::XMFLOAT3 &pa = vertices[a].pos;
+        const DirectX::XMFLOAT3 &pb = vertices[b].pos;
+        if (pa.x != pb.x) return pa.x < pb.x;
+        if (pa.y != pb.y) return pa.y < pb.y;
+        if (pa.z != pb.z) return pa.z < pb.z;
+        return a < b; });
+
+    std::vector<uint32_t> vertexPosition(vertexCount);
+    std::vector<uint32_t> positionFirstVertex; // positions -> their vertices, contiguous in `order`
+    std::vector<DirectX::XMFLOAT3> positions;
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        uint32_t v = order[i];
+        if (positions.empty() || !equalPosition(positions.back(), vertices[v].pos))
+        {
+            positions.push_back(vertices[v].pos);
+            positionFirstVertex.push_back(static_cast<uint32_t>(i));
+        }
+        vertexPosition[v] = static_cast<uint32_t>(positions.size() - 1);
+    }
+    size_t positionCount = positions.size();
+    positionFirstVertex.push_back(static_cast<uint32_t>(vertexCount));
+
+    // a position whose vertices disagree on uv sits on a seam, moving it would tear the texture
+    std::vector<uint8_t> locked(positionCount, 0);
+    for (size_t p = 0; p < positionCount; ++p)
+    {
+        const DirectX::XMFLOAT2 &uv = vertices[order[positionFirstVertex[p]]].uv;
+        for (uint32_t i = positionFirstVertex[p] + 1; i < positionFirstVertex[p + 1]; ++i)
+        {
+            const DirectX::XMFLOAT2 &other = vertices[order[i]].uv;
+            if (std::fabs(other.x - uv.x) > SEAM_UV_EPSILON || std::fabs(other.y - uv.y) > SEAM_UV_EPSILON)
+            {
+                locked[p] = 1;
+                break;
+            }
+        }
+    }
+
+    // triangles on positions, the source vertex of each corner is kept for the output
+    size_t triangleCount = indexCount / 3;
+    std::vector<uint32_t> triangles(triangleCount * 3);
+    std::vector<uint8_t> triangleAlive(triangleCount, 1);
+    size_t liveTriangles = 0;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        uint32_t a = vertexPosition[indices[t * 3]];
+        uint32_t b = vertexPosition[indices[t * 3 + 1]];
+        uint32_t c = vertexPosition[indices[t * 3 + 2]];
+        triangles[t * 3] = a;
+        triangles[t * 3 + 1] = b;
+        triangles[t * 3 + 2] = c;
+        if (a == b || b == c || a == c)
+        {
+            triangleAlive[t] = 0;
+            continue;
+        }
+        ++liveTriangles;
+    }
+
+    // edges, sorted (min, max) pairs; open and non-manifold edges lock their ends
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    edges.reserve(liveTriangles * 3);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        if (!triangleAlive[t])
+            continue;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            uint32_t a = triangles[t * 3 + k];
+            uint32_t b = triangles[t * 3 + (k + 1) % 3];
+            edges.push_back({std::min(a, b), std::max(a, b)});
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size();)
+    {
+        size_t j = i;
+        while (j < edges.size() && edges[j] == edges[i])
+            ++j;
+        if (j - i != 2)
+        {
+            locked[edges[i].first] = 1;
+            locked[edges[i].second] = 1;
+        }
+        i = j;
+    }
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    // area weighted plane quadrics
+    std::vector<Quadric> quadrics(positionCount);
+    std::vector<std::vector<uint32_t>> positionTriangles(positionCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        if (!triangleAlive[t])
+            continue;
+        const uint32_t *tri = &triangles[t * 3];
+        DirectX::XMVECTOR normal = triangleNormal(positions[tri[0]], positions[tri[1]], positions[tri[2]]);
+        float doubleArea = DirectX::XMVectorGetX(DirectX::XMVector3Length(normal));
+        if (doubleArea > 0.f)
+        {
+            normal = DirectX::XMVectorScale(normal, 1.f / doubleArea);
+        }
+        DirectX::XMFLOAT3 n;
+        DirectX::XMStoreFloat3(&n, normal);
+        double d = -(static_cast<double>(n.x) * positions[tri[0]].x + static_cast<double>(n.y) * positions[tri[0]].y + static_cast<double>(n.z) * positions[tri[0]].z);
+        Quadric q = Quadric::fromPlane(n.x, n.y, n.z, d, std::max(0.5 * doubleArea, 1e-12));
+        for (size_t k = 0; k < 3; ++k)
+        {
+            quadrics[tri[k]].add(q);
+            positionTriangles[tri[k]].push_back(static_cast<uint32_t>(t));
+        }
+    }
+
+    std::vector<uint32_t> version(positionCount, 0);
+    std::vector<uint8_t> alive(positionCount, 1);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+
+    auto pushEdge = [&](uint32_t a, uint32_t b)
+    {
+        // positions only move onto existing positions, so the target is one of the two ends
+        Quadric q = quadrics[a];
+        q.add(quadrics[b]);
+        double costToB = locked[a] ? INFINITY : q.evaluate(positions[b]);
+        double costToA = locked[b] ? INFINITY : q.evaluate(positions[a]);
+        if (std::isinf(costToA) && std::isinf(costToB))
+            return;
+        if (costToB <= costToA)
+            queue.push({costToB, a, b, version[a], version[b]});
+        else
+            queue.push({costToA, b, a, version[b], version[a]});
+    };
+    for (const auto &edge : edges)
+    {
+        pushEdge(edge.first, edge.second);
+    }
+
+    double maxCost = 0;
+    double targetCost = static_cast<double>(targetError) * targetError;
+    size_t targetTriangles = targetIndexCount / 3;
+    std::vector<uint32_t> neighbours;
+
+    while (liveTriangles > targetTriangles && !queue.empty())
+    {
+        Collapse collapse = queue.top();
+        queue.pop();
+        uint32_t u = collapse.from;
+        uint32_t v = collapse.to;
+        if (!alive[u] || !alive[v] || version[u] != collapse.fromVersion || version[v] != collapse.toVersion)
+            continue; // stale
+        if (collapse.cost > targetCost)
+            break;
+
+        // reject collapses that flip a surviving triangle
+        bool flips = false;
+        for (uint32_t t : positionTriangles[u])
+        {
+            if (!triangleAlive[t])
+                continue;
+            const uint32_t *tri = &triangles[t * 3];
+            if (tri[0] == v || tri[1] == v || tri[2] == v)
+                continue;
+            DirectX::XMFLOAT3 moved[3] = {positions[tri[0]], positions[tri[1]], positions[tri[2]]};
+            for (size_t k = 0; k < 3; ++k)
+            {
+                if (tri[k] == u)
+                    moved[k] = positions[v];
+            }
+            DirectX::XMVECTOR before = triangleNormal(positions[tri[0]], positions[tri[1]], positions[tri[2]]);
+            DirectX::XMVECTOR after = triangleNormal(moved[0], moved[1], moved[2]);
+            if (DirectX::XMVectorGetX(DirectX::XMVector3Dot(before, after)) <= 0.f)
+            {
+                flips = true;
+                break;
+            }
+        }
+        if (flips)
+            continue;
+
+        // collapse u onto v
+        for (uint32_t t : positionTriangles[u])
+        {
+            if (!triangleAlive[t])
+                continue;
+            uint32_t *tri = &triangles[t * 3];
+            if (tri[0] == v || tri[1] == v || tri[2] == v)
+            {
+                triangleAlive[t] = 0;
+                --liveTriangles;
+                continue;
+            }
+            for (size_t k = 0; k < 3; ++k)
+            {
+                if (tri[k] == u)
+                    tri[k] = v;
+            }
+            positionTriangles[v].push_back(t);
+        }
+        positionTriangles[u].clear();
+        alive[u] = 0;
+        quadrics[v].add(quadrics[u]);
+        ++version[v];
+        maxCost = std::max(maxCost, collapse.cost);
+
+        // drop dead triangles from v and re-cost the edges around it
+        std::vector<uint32_t> &around = positionTriangles[v];
+        around.erase(std::remove_if(around.begin(), around.end(), [&triangleAlive](uint32_t t)
+                                    { return !triangleAlive[t]; }),
+                     around.end());
+        neighbours.clear();
+        for (uint32_t t : around)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                if (triangles[t * 3 + k] != v)
+                    neighbours.push_back(triangles[t * 3 + k]);
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (uint32_t n : neighbours)
+        {
+            pushEdge(v, n); // entries from before the collapse are stale through version[v]
+        }
+    }
+
+    // back to vertices: a corner that moved takes the vertex at its new position with the closest uv, then normal
+    auto pickVertex = [&](uint32_t sourceVertex, uint32_t position) -> uint32_t
+    {
+        if (vertexPosition[sourceVertex] == position)
+            return sourceVertex;
+        const Vertex &source = vertices[sourceVertex];
+        uint32_t best = INVALID_ID;
+        float bestUV = INFINITY, bestDot = -INFINITY;
+        for (uint32_t i = positionFirstVertex[position]; i < positionFirstVertex[position + 1]; ++i)
+        {
+            const Vertex &candidate = vertices[order[i]];
+            float du = candidate.uv.x - source.uv.x, dv = candidate.uv.y - source.uv.y;
+            float uvDistance = du * du + dv * dv;
+            float normalDot = candidate.n.x * source.n.x + candidate.n.y * source.n.y + candidate.n.z * source.n.z;
+            if (uvDistance < bestUV || (uvDistance == bestUV && normalDot > bestDot))
+            {
+                best = order[i];
+                bestUV = uvDistance;
+                bestDot = normalDot;
+            }
+        }
+        return best;
+    };
+
+    result.clear();
+    result.reserve(liveTriangles * 3);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        if (!triangleAlive[t])
+            continue;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            result.push_back(pickVertex(indices[t * 3 + k], triangles[t * 3 + k]));
+        }
+    }
+
+    Result stats;
+    stats.triangleCount = liveTriangles;
+    stats.error = static_cast<float>(std::sqrt(maxCost));
+    return stats;
+}
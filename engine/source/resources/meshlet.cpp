@@ -0,0 +1,259 @@
+#include "resources/meshlet.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    constexpr uint32_t INVALID_ID = 0xFFFFFFFFu;
+
+    void computeBounds(const std::vector<Vertex> &vertices, const uint32_t *indices, Meshlet &meshlet)
+    {
+        const uint32_t *begin = indices + meshlet.firstIndex;
+        const uint32_t *end = begin + meshlet.triangleCount * 3;
+
+        // sphere around the box center
+        DirectX::XMVECTOR minVec = DirectX::XMLoadFloat3(&vertices[*begin].pos);
+        DirectX::XMVECTOR maxVec = minVec;
+        for (const uint32_t *index = begin; index != end; ++index)
+        {
+            DirectX::XMVECTOR p = DirectX::XMLoadFloat3(&vertices[*index].pos);
+            minVec = DirectX::XMVectorMin(minVec, p);
+            maxVec = DirectX::XMVectorMax(maxVec, p);
+        }
+        DirectX::XMVECTOR center = DirectX::XMVectorScale(DirectX::XMVectorAdd(minVec, maxVec), 0.5f);
+        float radiusSq = 0.f;
+        for (const uint32_t *index = begin; index != end; ++index)
+        {
+            DirectX::XMVECTOR d = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&vertices[*index].pos), center);
+            radiusSq = std::max(radiusSq, DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(d)));
+        }
+        DirectX::XMStoreFloat3(&meshlet.center, center);
+        meshlet.radius = std::sqrt(radiusSq);
+
+        // triangle normals, oriented to agree with the vertex normals
+        std::vector<DirectX::XMVECTOR> normals;
+        normals.reserve(meshlet.triangleCount);
+        DirectX::XMVECTOR axis = DirectX::XMVectorZero();
+        for (const uint32_t *tri = begin; tri != end; tri += 3)
+        {
+            const Vertex &a = vertices[tri[0]];
+            const Vertex &b = vertices[tri[1]];
+            const Vertex &c = vertices[tri[2]];
+            DirectX::XMVECTOR pa = DirectX::XMLoadFloat3(&a.pos);
+            DirectX::XMVECTOR normal = DirectX::XMVector3Cross(DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&b.pos), pa),
+                                                               DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&c.pos), pa));
+            if (DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(normal)) <= 0.f)
+            {
+                continue; // degenerate, never visible
+            }
+            DirectX::XMVECTOR vertexNormal = DirectX::XMVectorAdd(DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&a.n), DirectX::XMLoadFloat3(&b.n)), DirectX::XMLoadFloat3(&c.n));
+            if (DirectX::XMVectorGetX(DirectX::XMVector3Dot(normal, vertexNormal)) < 0.f)
+            {
+                normal = DirectX::XMVectorNegate(normal);
+            }
+            normal = DirectX::XMVector3Normalize(normal);
+            normals.push_back(normal);
+            axis = DirectX::XMVectorAdd(axis, normal);
+        }
+
+        meshlet.coneAxis = {0.f, 0.f, 0.f};
+        meshlet.coneSinAngle = 1.f;
+        if (normals.empty() || DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(axis)) <= 0.f)
+        {
+            return;
+        }
+        axis = DirectX::XMVector3Normalize(axis);
+        float minDot = 1.f;
+        for (const DirectX::XMVECTOR &normal : normals)
+        {
+            minDot = std::min(minDot, DirectX::XMVectorGetX(DirectX::XMVector3Dot(axis, normal)));
+        }
+        DirectX::XMStoreFloat3(&meshlet.coneAxis, axis);
+        if (minDot > 0.f) // cone narrower than a hemisphere
+        {
+            meshlet.coneSinAngle = std::sqrt(1.f - minDot * minDot);
+        }
+    }
+}
+
+void MeshletBuilder::build(const std::vector<Vertex> &vertices, uint32_t *indices, size_t indexCount, uint32_t firstIndex,
+                           uint32_t maxVertices, uint32_t maxTriangles, std::vector<Meshlet> &meshlets)
+{
+    uint32_t *rangeIndices = indices + firstIndex;
+    size_t triangleCount = indexCount / 3;
+    size_t vertexCount = vertices.size();
+    size_t firstMeshlet = meshlets.size();
+
+    // triangles are adjacent through shared positions, split normals / uvs must not cut clusters apart
+    std::vector<uint32_t> order(vertexCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&vertices](uint32_t a, uint32_t b)
+              {
+        const DirectX::XMFLOAT3 &pa = vertices[a].pos;
+        const DirectX::XMFLOAT3 &pb = vertices[b].pos;
+        if (pa.x != pb.x) return pa.x < pb.x;
+        if (pa.y != pb.y) return pa.y < pb.y;
+        if (pa.z != pb.z) return pa.z < pb.z;
+        return a < b; });
+
+    std::vector<uint32_t> positionIds(vertexCount);
+    uint32_t positionCount = 0;
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const DirectX::XMFLOAT3 &pos = vertices[order[i]].pos;
+        if (i > 0)
+        {
+            const DirectX::XMFLOAT3 &prev = vertices[order[i - 1]].pos;
+            positionCount += (pos.x != prev.x || pos.y != prev.y || pos.z != prev.z);
+        }
+        positionIds[order[i]] = positionCount;
+    }
+    positionCount += vertexCount > 0;
+
+    // position -> triangles, compressed rows
+    std::vector<uint32_t> adjacencyOffsets(positionCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i)
+    {
+        ++adjacencyOffsets[positionIds[rangeIndices[i]] + 1];
+    }
+    for (uint32_t p = 0; p < positionCount; ++p)
+    {
+        adjacencyOffsets[p + 1] += adjacencyOffsets[p];
+    }
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    std::vector<DirectX::XMFLOAT3> centroids(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        const uint32_t *tri = rangeIndices + t * 3;
+        DirectX::XMVECTOR sum = DirectX::XMVectorZero();
+        for (int k = 0; k < 3; ++k)
+        {
+            adjacency[fillOffsets[positionIds[tri[k]]]++] = static_cast<uint32_t>(t);
+            sum = DirectX::XMVectorAdd(sum, DirectX::XMLoadFloat3(&vertices[tri[k]].pos));
+        }
+        DirectX::XMStoreFloat3(&centroids[t], DirectX::XMVectorScale(sum, 1.f / 3.f));
+    }
+
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> stamp(vertexCount, INVALID_ID);           // meshlet each vertex was last added to
+    std::vector<uint32_t> positionStamp(positionCount, INVALID_ID); // same for positions, the growth frontier
+    std::vector<uint32_t> meshletPositions;
+    std::vector<uint32_t> meshletTriangles;
+    std::vector<uint32_t> ordered;
+    ordered.reserve(triangleCount * 3);
+
+    uint32_t meshletId = 0;
+    for (size_t seed = 0; seed < triangleCount; ++seed)
+    {
+        if (emitted[seed])
+        {
+            continue;
+        }
+
+        Meshlet meshlet = {};
+        meshlet.firstIndex = firstIndex + static_cast<uint32_t>(ordered.size());
+        uint32_t meshletVertexCount = 0;
+        meshletPositions.clear();
+        meshletTriangles.clear();
+        DirectX::XMVECTOR centroidSum = DirectX::XMVectorZero();
+        uint32_t candidate = static_cast<uint32_t>(seed);
+        while (candidate != INVALID_ID)
+        {
+            emitted[candidate] = 1;
+            const uint32_t *tri = rangeIndices + candidate * 3;
+            for (int k = 0; k < 3; ++k)
+            {
+                if (stamp[tri[k]] != meshletId)
+                {
+                    stamp[tri[k]] = meshletId;
+                    ++meshletVertexCount;
+                }
+                if (positionStamp[positionIds[tri[k]]] != meshletId)
+                {
+                    positionStamp[positionIds[tri[k]]] = meshletId;
+                    meshletPositions.push_back(positionIds[tri[k]]);
+                }
+            }
+            meshletTriangles.push_back(candidate);
+            centroidSum = DirectX::XMVectorAdd(centroidSum, DirectX::XMLoadFloat3(&centroids[candidate]));
+            if (++meshlet.triangleCount >= maxTriangles)
+            {
+                break;
+            }
+
+            // fewest new vertices first, then closest to the cluster
+            DirectX::XMVECTOR center = DirectX::XMVectorScale(centroidSum, 1.f / meshlet.triangleCount);
+            uint32_t bestExtra = 4;
+            float bestDistance = 0.f;
+            candidate = INVALID_ID;
+            for (uint32_t p : meshletPositions)
+            {
+                for (uint32_t a = adjacencyOffsets[p]; a < adjacencyOffsets[p + 1]; ++a)
+                {
+                    uint32_t t = adjacency[a];
+                    if (emitted[t])
+                    {
+                        continue;
+                    }
+                    const uint32_t *other = rangeIndices + t * 3;
+                    uint32_t extra = (stamp[other[0]] != meshletId) + (stamp[other[1]] != meshletId && other[1] != other[0]) +
+                                     (stamp[other[2]] != meshletId && other[2] != other[0] && other[2] != other[1]);
+                    if (meshletVertexCount + extra > maxVertices || extra > bestExtra)
+                    {
+                        continue;
+                    }
+                    float distance = DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&centroids[t]), center)));
+                    if (extra < bestExtra || distance < bestDistance)
+                    {
+                        bestExtra = extra;
+                        bestDistance = distance;
+                        candidate = t;
+                    }
+                }
+            }
+        }
+
+        // keep the input (vertex cache) order inside the meshlet
+        std::sort(meshletTriangles.begin(), meshletTriangles.end());
+        for (uint32_t t : meshletTriangles)
+        {
+            ordered.insert(ordered.end(), rangeIndices + t * 3, rangeIndices + t * 3 + 3);
+        }
+        meshlet.vertexCount = meshletVertexCount;
+        meshlets.push_back(meshlet);
+        ++meshletId;
+    }
+    std::copy(ordered.begin(), ordered.end(), rangeIndices);
+
+    for (size_t i = firstMeshlet; i < meshlets.size(); ++i)
+    {
+        computeBounds(vertices, indices, meshlets[i]);
+    }
+}
+
+bool MeshletBuilder::isBackfacing(const Meshlet &meshlet, const DirectX::XMFLOAT3 &cameraPosition)
+{
+    if (meshlet.coneSinAngle >= 1.f)
+    {
+        return false;
+    }
+
+    // every view ray into the sphere must stay within 90 deg - cone angle of the axis:
+    // angle(toCenter, axis) + asin(radius / distance) <= 90 deg - asin(coneSinAngle)
+    DirectX::XMVECTOR toCenter = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&meshlet.center), DirectX::XMLoadFloat3(&cameraPosition));
+    float distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(toCenter));
+    if (distance <= meshlet.radius)
+    {
+        return false;
+    }
+
+    float cosPhi = DirectX::XMVectorGetX(DirectX::XMVector3Dot(toCenter, DirectX::XMLoadFloat3(&meshlet.coneAxis))) / distance;
+    float sinPhi = std::sqrt(std::max(0.f, 1.f - cosPhi * cosPhi));
+    float sinDelta = meshlet.radius / distance;
+    float cosDelta = std::sqrt(1.f - sinDelta * sinDelta);
+
+    // cos(phi + delta) >= sin(cone angle) = cos(90 deg - cone angle), phi + delta is in [0, 180 deg]
+    return cosPhi * cosDelta - sinPhi * sinDelta >= meshlet.coneSinAngle;
+}
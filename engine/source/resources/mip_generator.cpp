@@ -0,0 +1,293 @@
+#include "resources/mip_generator.h"
+#include "utils/thread_pool.h"
+#include <DirectXMath.h>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr size_t ROW_GRAIN = 16;
+    constexpr uint32_t ENCODE_TABLE_SIZE = 16384; // linear -> sRGB8, fine enough near black
+    constexpr float KAISER_ALPHA = 4.f;
+
+    struct SrgbTables
+    {
+        float decode[256];
+        uint8_t encode[ENCODE_TABLE_SIZE];
+
+        SrgbTables()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                float c = i / 255.f;
+                decode[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (uint32_t i = 0; i < ENCODE_TABLE_SIZE; ++i)
+            {
+                float l = i / static_cast<float>(ENCODE_TABLE_SIZE - 1);
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.f / 2.4f) - 0.055f;
+                encode[i] = static_cast<uint8_t>(std::clamp(c * 255.f + 0.5f, 0.f, 255.f));
+            }
+        }
+    };
+
+    const SrgbTables &getSrgbTables()
+    {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    float sinc(float x)
+    {
+        if (std::fabs(x) < 1e-6f)
+        {
+            return 1.f;
+        }
+        x *= XM_PI;
+        return std::sin(x) / x;
+    }
+
+    float besselI0(float x)
+    {
+        // power series, converges quickly for the alphas used here
+        float sum = 1.f, term = 1.f, halfX = 0.5f * x;
+        for (int k = 1; k < 32 && term > sum * 1e-8f; ++k)
+        {
+            term *= (halfX / k) * (halfX / k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    float getSupport(MipFilter filter)
+    {
+        switch (filter)
+        {
+        case MipFilter::Kaiser:
+            return 2.f;
+        case MipFilter::Lanczos:
+            return 3.f;
+        default:
+            return 0.5f;
+        }
+    }
+
+    float evaluate(MipFilter filter, float t)
+    {
+        float support = getSupport(filter);
+        if (std::fabs(t) >= support)
+        {
+            return 0.f;
+        }
+        if (filter == MipFilter::Lanczos)
+        {
+            return sinc(t) * sinc(t / support);
+        }
+        float ratio = t / support;
+        return sinc(t) * besselI0(KAISER_ALPHA * std::sqrt(1.f - ratio * ratio)) / besselI0(KAISER_ALPHA);
+    }
+
+    // Source texels and weights of every destination texel along one axis, normalized
+    struct Taps
+    {
+        std::vector<uint32_t> start; // dstSize + 1
+        std::vector<uint32_t> index;
+        std::vector<float> weight;
+    };
+
+    Taps computeTaps(uint32_t srcSize, uint32_t dstSize, MipFilter filter)
+    {
+        Taps taps;
+        taps.start.reserve(dstSize + 1);
+        float ratio = static_cast<float>(srcSize) / dstSize;
+        for (uint32_t x = 0; x < dstSize; ++x)
+        {
+            taps.start.push_back(static_cast<uint32_t>(taps.index.size()));
+            size_t first = taps.weight.size();
+            if (srcSize == dstSize)
+            {
+                taps.index.push_back(x); // axis already at 1 texel
+                taps.weight.push_back(1.f);
+                continue;
+            }
+
+            float lower = x * ratio, upper = (x + 1) * ratio;
+            if (filter == MipFilter::Box)
+            {
+                // area of [lower, upper) over each source texel
+                for (uint32_t i = static_cast<uint32_t>(lower); i < std::min(static_cast<uint32_t>(std::ceil(upper)), srcSize); ++i)
+                {
+                    float coverage = std::min(upper, i + 1.f) - std::max(lower, static_cast<float>(i));
+                    if (coverage > 0.f)
+                    {
+                        taps.index.push_back(i);
+                        taps.weight.push_back(coverage);
+                    }
+                }
+            }
+            else
+            {
+                float center = 0.5f * (lower + upper), radius = getSupport(filter) * ratio;
+                int64_t begin = static_cast<int64_t>(std::floor(center - radius)), end = static_cast<int64_t>(std::ceil(center + radius));
+                for (int64_t i = begin; i < end; ++i)
+                {
+                    float weight = evaluate(filter, (i + 0.5f - center) / ratio);
+                    if (weight != 0.f)
+                    {
+                        taps.index.push_back(static_cast<uint32_t>(((i % srcSize) + srcSize) % srcSize)); // wrap
+                        taps.weight.push_back(weight);
+                    }
+                }
+            }
+
+            float sum = 0.f;
+            for (size_t i = first; i < taps.weight.size(); ++i)
+            {
+                sum += taps.weight[i];
+            }
+            for (size_t i = first; i < taps.weight.size(); ++i)
+            {
+                taps.weight[i] /= sum;
+            }
+        }
+        taps.start.push_back(static_cast<uint32_t>(taps.index.size()));
+        return taps;
+    }
+}
+
+uint32_t MipGenerator::getLevelCount(uint32_t width, uint32_t height)
+{
+    return static_cast<uint32_t>(std::bit_width(std::max({width, height, 1u})));
+}
+
+std::vector<MipLevel> MipGenerator::generate(const uint8_t *pixels, uint32_t width, uint32_t height, size_t rowPitch, bool isSrgb, MipFilter filter)
+{
+    std::vector<MipLevel> levels(getLevelCount(width, height));
+    levels[0] = {width, height, std::vector<uint8_t>(static_cast<size_t>(width) * height * 4)};
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        std::memcpy(levels[0].pixels.data() + static_cast<size_t>(y) * width * 4, pixels + y * rowPitch, static_cast<size_t>(width) * 4);
+    }
+
+    ThreadPool &pool = ThreadPool::getInstance();
+    std::vector<XMFLOAT4> source; // previous level, premultiplied linear; empty while it is level 0
+    for (size_t level = 1; level < levels.size(); ++level)
+    {
+        uint32_t srcWidth = levels[level - 1].width, srcHeight = levels[level - 1].height;
+        uint32_t dstWidth = std::max(srcWidth / 2, 1u), dstHeight = std::max(srcHeight / 2, 1u);
+        Taps horizontal = computeTaps(srcWidth, dstWidth, filter);
+        Taps vertical = computeTaps(srcHeight, dstHeight, filter);
+        std::vector<XMFLOAT4> destination(static_cast<size_t>(dstWidth) * dstHeight);
+
+        // a band of destination rows filters the source rows it needs horizontally once, then vertically row by row
+        pool.parallelFor(dstHeight, ROW_GRAIN, [&](size_t begin, size_t end)
+                         {
+            std::vector<uint32_t> rows;
+            for (uint32_t i = vertical.start[begin]; i < vertical.start[end]; ++i)
+            {
+                rows.push_back(vertical.index[i]);
+            }
+            std::sort(rows.begin(), rows.end());
+            rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+            std::vector<XMFLOAT4> band(rows.size() * dstWidth);
+            std::vector<XMFLOAT4> decoded(source.empty() ? srcWidth : 0);
+            for (size_t slot = 0; slot < rows.size(); ++slot)
+            {
+                const XMFLOAT4 *row;
+                if (source.empty())
+                {
+                    decodeRow(levels[0].pixels.data() + static_cast<size_t>(rows[slot]) * srcWidth * 4, srcWidth, isSrgb, decoded.data());
+                    row = decoded.data();
+                }
+                else
+                {
+                    row = source.data() + static_cast<size_t>(rows[slot]) * srcWidth;
+                }
+
+                XMFLOAT4 *out = band.data() + slot * dstWidth;
+                for (uint32_t x = 0; x < dstWidth; ++x)
+                {
+                    XMVECTOR sum = XMVectorZero();
+                    for (uint32_t i = horizontal.start[x]; i < horizontal.start[x + 1]; ++i)
+                    {
+                        sum = XMVectorMultiplyAdd(XMLoadFloat4(&row[horizontal.index[i]]), XMVectorReplicate(horizontal.weight[i]), sum);
+                    }
+                    XMStoreFloat4(&out[x], sum);
+                }
+            }
+
+            for (size_t y = begin; y < end; ++y)
+            {
+                XMFLOAT4 *out = destination.data() + y * dstWidth;
+                std::fill(out, out + dstWidth, XMFLOAT4(0.f, 0.f, 0.f, 0.f));
+                for (uint32_t i = vertical.start[y]; i < vertical.start[y + 1]; ++i)
+                {
+                    size_t slot = std::lower_bound(rows.begin(), rows.end(), vertical.index[i]) - rows.begin();
+                    const XMFLOAT4 *in = band.data() + slot * dstWidth;
+                    XMVECTOR weight = XMVectorReplicate(vertical.weight[i]);
+                    for (uint32_t x = 0; x < dstWidth; ++x)
+                    {
+                        XMStoreFloat4(&out[x], XMVectorMultiplyAdd(XMLoadFloat4(&in[x]), weight, XMLoadFloat4(&out[x])));
+                    }
+                }
+            } });
+
+        levels[level] = {dstWidth, dstHeight, std::vector<uint8_t>(static_cast<size_t>(dstWidth) * dstHeight * 4)};
+        pool.parallelFor(dstHeight, ROW_GRAIN, [&](size_t begin, size_t end)
+                         {
+            for (size_t y = begin; y < end; ++y)
+            {
+                encodeRow(destination.data() + y * dstWidth, dstWidth, isSrgb, levels[level].pixels.data() + y * dstWidth * 4);
+            } });
+        source.swap(destination);
+    }
+    return levels;
+}
+
+void MipGenerator::decodeRow(const uint8_t *row, uint32_t width, bool isSrgb, XMFLOAT4 *out)
+{
+    const SrgbTables &tables = getSrgbTables();
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        const uint8_t *texel = row + x * 4;
+        float alpha = texel[3] / 255.f;
+        XMVECTOR color = isSrgb ? XMVectorSet(tables.decode[texel[0]], tables.decode[texel[1]], tables.decode[texel[2]], 1.f)
+                                : XMVectorSet(texel[0] / 255.f, texel[1] / 255.f, texel[2] / 255.f, 1.f);
+        XMStoreFloat4(&out[x], XMVectorScale(color, alpha)); // w = alpha
+    }
+}
+
+void MipGenerator::encodeRow(const XMFLOAT4 *row, uint32_t width, bool isSrgb, uint8_t *out)
+{
+    const SrgbTables &tables = getSrgbTables();
+    XMVECTOR zero = XMVectorZero(), one = XMVectorSplatOne();
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        XMVECTOR texel = XMLoadFloat4(&row[x]);
+        float alpha = std::clamp(XMVectorGetW(texel), 0.f, 1.f);
+        XMVECTOR color = alpha > 0.f ? XMVectorScale(texel, 1.f / alpha) : texel; // unpremultiply
+        color = XMVectorMin(XMVectorMax(color, zero), one);                         // negative lobes overshoot
+
+        XMFLOAT4 c;
+        XMStoreFloat4(&c, color);
+        uint8_t *texelOut = out + x * 4;
+        if (isSrgb)
+        {
+            texelOut[0] = tables.encode[static_cast<uint32_t>(c.x * (ENCODE_TABLE_SIZE - 1) + 0.5f)];
+            texelOut[1] = tables.encode[static_cast<uint32_t>(c.y * (ENCODE_TABLE_SIZE - 1) + 0.5f)];
+            texelOut[2] = tables.encode[static_cast<uint32_t>(c.z * (ENCODE_TABLE_SIZE - 1) + 0.5f)];
+        }
+        else
+        {
+            texelOut[0] = static_cast<uint8_t>(c.x * 255.f + 0.5f);
+            texelOut[1] = static_cast<uint8_t>(c.y * 255.f + 0.5f);
+            texelOut[2] = static_cast<uint8_t>(c.z * 255.f + 0.5f);
+        }
+        texelOut[3] = static_cast<uint8_t>(alpha * 255.f + 0.5f);
+    }
+}
@@ -0,0 +1,269 @@
+#include "resources/obj_parser.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    constexpr size_t CHUNK_GRAIN_BYTES = 256 * 1024;
+
+    // Negative (relative) OBJ indices are resolved against the chunk-local attribute count and
+    // stored with this bias, the chunk's global offset is only known after every chunk is parsed.
+    constexpr int32_t RELATIVE_INDEX_BIAS = -(1 << 30);
+    constexpr int32_t RELATIVE_INDEX_THRESHOLD = -(1 << 29);
+
+    struct Chunk
+    {
+        const char *begin;
+        const char *end;
+
+        std::vector<DirectX::XMFLOAT3> positions;
+        std::vector<DirectX::XMFLOAT3> normals;
+        std::vector<DirectX::XMFLOAT2> texCoords;
+        std::vector<DirectX::XMINT3> corners;
+    };
+
+    inline bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    inline const char *skipSpaces(const char *p, const char *end)
+    {
+        while (p < end && isSpace(*p))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    inline const char *skipLine(const char *p, const char *end)
+    {
+        const char *newline = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+        return newline ? newline + 1 : end;
+    }
+
+    inline bool parseFloat(const char *&p, const char *end, float &value)
+    {
+        p = skipSpaces(p, end);
+        if (p < end && *p == '+')
+        {
+            ++p;
+        }
+        auto [next, ec] = std::from_chars(p, end, value);
+        if (ec != std::errc())
+        {
+            return false;
+        }
+        p = next;
+        return true;
+    }
+
+    inline bool parseInt(const char *&p, const char *end, int32_t &value)
+    {
+        auto [next, ec] = std::from_chars(p, end, value);
+        if (ec != std::errc())
+        {
+            return false;
+        }
+        p = next;
+        return true;
+    }
+
+    inline int32_t encodeIndex(int32_t raw, size_t localCount, const char *attributeName)
+    {
+        if (raw >= 0)
+        {
+            return raw; // absolute, 0 = missing
+        }
+        // local 1-based index, below 1 when it reaches into earlier chunks; it has to fit between the bias and the threshold
+        int64_t local = static_cast<int64_t>(localCount) + raw + 1;
+        if (local < int64_t(INT32_MIN) - RELATIVE_INDEX_BIAS || local > int64_t(RELATIVE_INDEX_THRESHOLD) - RELATIVE_INDEX_BIAS)
+        {
+            throw std::runtime_error(std::string("ObjParser::parse: ") + attributeName + " index out of range: " + std::to_string(raw));
+        }
+        return RELATIVE_INDEX_BIAS + static_cast<int32_t>(local);
+    }
+
+    inline int32_t resolveIndex(int32_t encoded, size_t globalOffset, size_t attributeCount, const char *attributeName)
+    {
+        int64_t index = encoded;
+        int64_t firstValid = 0; // 0 = missing
+        if (encoded <= RELATIVE_INDEX_THRESHOLD)
+        {
+            index = int64_t(encoded) - RELATIVE_INDEX_BIAS + static_cast<int64_t>(globalOffset);
+            firstValid = 1; // a relative index never means missing
+        }
+        if (index < firstValid || static_cast<uint64_t>(index) >= attributeCount)
+        {
+            throw std::runtime_error(std::string("ObjParser::parse: ") + attributeName + " index out of range: " + std::to_string(index));
+        }
+        return static_cast<int32_t>(index);
+    }
+
+    void parseChunk(Chunk &chunk)
+    {
+        std::vector<DirectX::XMINT3> faceCorners; // reused across faces
+        const char *p = chunk.begin;
+        const char *end = chunk.end;
+
+        while (p < end)
+        {
+            p = skipSpaces(p, end);
+            if (p >= end)
+            {
+                break;
+            }
+
+            if (p[0] == 'v' && p + 1 < end && isSpace(p[1]))
+            {
+                p += 1;
+                DirectX::XMFLOAT3 pos = {0.f, 0.f, 0.f};
+                parseFloat(p, end, pos.x) && parseFloat(p, end, pos.y) && parseFloat(p, end, pos.z);
+                pos.z = -pos.z;
+                chunk.positions.push_back(pos);
+            }
+            else if (p[0] == 'v' && p + 2 < end && p[1] == 't' && isSpace(p[2]))
+            {
+                p += 2;
+                DirectX::XMFLOAT2 tex = {0.f, 0.f};
+                parseFloat(p, end, tex.x) && parseFloat(p, end, tex.y);
+                tex.y = 1.f - tex.y;
+                chunk.texCoords.push_back(tex);
+            }
+            else if (p[0] == 'v' && p + 2 < end && p[1] == 'n' && isSpace(p[2]))
+            {
+                p += 2;
+                DirectX::XMFLOAT3 norm = {0.f, 0.f, 0.f};
+                parseFloat(p, end, norm.x) && parseFloat(p, end, norm.y) && parseFloat(p, end, norm.z);
+                norm.z = -norm.z;
+                chunk.normals.push_back(norm);
+            }
+            else if (p[0] == 'f' && p + 1 < end && isSpace(p[1]))
+            {
+                p += 1;
+                faceCorners.clear();
+                while (true)
+                {
+                    p = skipSpaces(p, end);
+                    if (p >= end || *p == '\n' || *p == '#')
+                    {
+                        break;
+                    }
+
+                    // v, v/t, v//n, v/t/n
+                    int32_t v = 0, t = 0, n = 0;
+                    if (!parseInt(p, end, v))
+                    {
+                        throw std::runtime_error("ObjParser::parse: Malformed face descriptor");
+                    }
+                    if (p < end && *p == '/')
+                    {
+                        ++p;
+                        if (p < end && *p != '/')
+                        {
+                            parseInt(p, end, t);
+                        }
+                        if (p < end && *p == '/')
+                        {
+                            ++p;
+                            parseInt(p, end, n);
+                        }
+                    }
+
+                    faceCorners.push_back({encodeIndex(v, chunk.positions.size(), "position"),
+                                           encodeIndex(t, chunk.texCoords.size(), "texcoord"),
+                                           encodeIndex(n, chunk.normals.size(), "normal")});
+                }
+
+                for (size_t i = 1; i + 1 < faceCorners.size(); ++i) // fan: (A, B, C), (A, C, D), ...
+                {
+                    chunk.corners.push_back(faceCorners[0]);
+                    chunk.corners.push_back(faceCorners[i]);
+                    chunk.corners.push_back(faceCorners[i + 1]);
+                }
+            }
+
+            p = skipLine(p, end);
+        }
+    }
+}
+
+ObjParser::Result ObjParser::parse(const char *begin, const char *end)
+{
+    ThreadPool &pool = ThreadPool::getInstance();
+    size_t totalBytes = static_cast<size_t>(end - begin);
+
+    // split into line-aligned chunks
+    size_t maxChunks = static_cast<size_t>(pool.getThreadCount()) + 1;
+    size_t chunkCount = std::max<size_t>(1, std::min(maxChunks, totalBytes / CHUNK_GRAIN_BYTES));
+    size_t chunkBytes = totalBytes / chunkCount;
+
+    std::vector<Chunk> chunks(chunkCount);
+    const char *chunkBegin = begin;
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        const char *chunkEnd = (i + 1 == chunkCount) ? end : std::min(end, chunkBegin + chunkBytes);
+        if (chunkEnd < end)
+        {
+            chunkEnd = skipLine(chunkEnd, end);
+        }
+        chunks[i].begin = chunkBegin;
+        chunks[i].end = chunkEnd;
+        chunkBegin = chunkEnd;
+    }
+
+    pool.parallelFor(chunkCount, 1, [&chunks](size_t first, size_t last)
+                     {
+        for (size_t i = first; i < last; ++i)
+        {
+            parseChunk(chunks[i]);
+        } });
+
+    // merge, attribute arrays keep the zero sentinel at index 0
+    std::vector<size_t> positionOffsets(chunkCount), normalOffsets(chunkCount), texCoordOffsets(chunkCount), cornerOffsets(chunkCount);
+    size_t positionCount = 1, normalCount = 1, texCoordCount = 1, cornerCount = 0;
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        positionOffsets[i] = positionCount;
+        normalOffsets[i] = normalCount;
+        texCoordOffsets[i] = texCoordCount;
+        cornerOffsets[i] = cornerCount;
+        positionCount += chunks[i].positions.size();
+        normalCount += chunks[i].normals.size();
+        texCoordCount += chunks[i].texCoords.size();
+        cornerCount += chunks[i].corners.size();
+    }
+
+    Result result;
+    result.positions.resize(positionCount);
+    result.normals.resize(normalCount);
+    result.texCoords.resize(texCoordCount);
+    result.corners.resize(cornerCount);
+    result.positions[0] = {0.f, 0.f, 0.f};
+    result.normals[0] = {0.f, 0.f, 0.f};
+    result.texCoords[0] = {0.f, 0.f};
+
+    pool.parallelFor(chunkCount, 1, [&](size_t first, size_t last)
+                     {
+        for (size_t i = first; i < last; ++i)
+        {
+            const Chunk &chunk = chunks[i];
+            std::copy(chunk.positions.begin(), chunk.positions.end(), result.positions.begin() + positionOffsets[i]);
+            std::copy(chunk.normals.begin(), chunk.normals.end(), result.normals.begin() + normalOffsets[i]);
+            std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), result.texCoords.begin() + texCoordOffsets[i]);
+
+            // relative indices are local 1-based, so the global offset is one less than the array offset
+            DirectX::XMINT3 *corners = result.corners.data() + cornerOffsets[i];
+            for (size_t c = 0; c < chunk.corners.size(); ++c)
+            {
+                const DirectX::XMINT3 &corner = chunk.corners[c];
+                corners[c].x = resolveIndex(corner.x, positionOffsets[i] - 1, positionCount, "position");
+                corners[c].y = resolveIndex(corner.y, texCoordOffsets[i] - 1, texCoordCount, "texcoord");
+                corners[c].z = resolveIndex(corner.z, normalOffsets[i] - 1, normalCount, "normal");
+            }
+        } });
+
+    return result;
+}
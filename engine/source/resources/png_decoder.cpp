@@ -0,0 +1,582 @@
+#include "resources/png_decoder.h"
+#include "utils/inflate.h"
+#include "utils/mapped_file.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PNG_DECODER_SSE2 1
+#endif
+
+namespace
+{
+    constexpr uint8_t SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    constexpr uint32_t GAMMA_22 = 45455; // gAMA stores 1/gamma * 100000
+
+    enum ColorType : uint8_t
+    {
+        GRAY = 0,
+        RGB = 2,
+        PALETTE = 3,
+        GRAY_ALPHA = 4,
+        RGBA = 6,
+    };
+
+    // pass origin and step, pass 0 stands for the whole non-interlaced image
+    struct Pass
+    {
+        uint32_t x0, y0, dx, dy;
+    };
+    constexpr Pass FULL_IMAGE = {0, 0, 1, 1};
+    constexpr Pass ADAM7[7] = {{0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4}, {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2}};
+
+    uint32_t readBigEndian(const uint8_t *p)
+    {
+        return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8 | p[3];
+    }
+
+    struct Format
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint8_t bitDepth = 0;
+        uint8_t colorType = 0;
+        uint8_t channels = 0;
+        bool isInterlaced = false;
+
+        size_t getRowBytes(uint32_t width) const { return (static_cast<size_t>(width) * channels * bitDepth + 7) / 8; }
+        uint32_t getFilterStride() const { return std::max(1u, static_cast<uint32_t>(channels * bitDepth / 8)); }
+    };
+
+    struct Transparency
+    {
+        uint8_t palette[256][4]; // RGBA per palette entry
+        uint16_t key[3];         // color key of gray / RGB images, in sample units
+        bool hasKey = false;
+    };
+
+    // ---- unfiltering ----
+
+    uint8_t paeth(int a, int b, int c)
+    {
+        int pa = std::abs(b - c), pb = std::abs(a - c), pc = std::abs(a + b - 2 * c);
+        return static_cast<uint8_t>(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+    }
+
+    void unfilterScalar(uint8_t filter, uint8_t *row, const uint8_t *prior, size_t rowBytes, uint32_t stride)
+    {
+        switch (filter)
+        {
+        case 1:
+            for (size_t i = stride; i < rowBytes; ++i)
+            {
+                row[i] = static_cast<uint8_t>(row[i] + row[i - stride]);
+            }
+            break;
+        case 2:
+            for (size_t i = 0; i < rowBytes; ++i)
+            {
+                row[i] = static_cast<uint8_t>(row[i] + prior[i]);
+            }
+            break;
+        case 3:
+            for (size_t i = 0; i < stride; ++i)
+            {
+                row[i] = static_cast<uint8_t>(row[i] + (prior[i] >> 1));
+            }
+            for (size_t i = stride; i < rowBytes; ++i)
+            {
+                row[i] = static_cast<uint8_t>(row[i] + ((row[i - stride] + prior[i]) >> 1));
+            }
+            break;
+        case 4:
+            for (size_t i = 0; i < stride; ++i)
+            {
+                row[i] = static_cast<uint8_t>(row[i] + prior[i]);
+            }
+            for (size_t i = stride; i < rowBytes; ++i)
+            {
+                row[i] = static_cast<uint8_t>(row[i] + paeth(row[i - stride], prior[i], prior[i - stride]));
+            }
+            break;
+        }
+    }
+
+#ifdef PNG_DECODER_SSE2
+    // one pixel of 3 or 4 bytes in the low lanes
+    template <uint32_t STRIDE>
+    __m128i loadPixel(const uint8_t *p)
+    {
+        uint32_t value = 0;
+        std::memcpy(&value, p, STRIDE);
+        return _mm_cvtsi32_si128(static_cast<int>(value));
+    }
+
+    template <uint32_t STRIDE>
+    void storePixel(uint8_t *p, __m128i pixel)
+    {
+        uint32_t value = static_cast<uint32_t>(_mm_cvtsi128_si32(pixel));
+        std::memcpy(p, &value, STRIDE);
+    }
+
+    __m128i select(__m128i mask, __m128i a, __m128i b)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    __m128i abs16(__m128i x)
+    {
+        return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+    }
+
+    void unfilterUp(uint8_t *row, const uint8_t *prior, size_t rowBytes)
+    {
+        size_t i = 0;
+        for (; i + 16 <= rowBytes; i += 16)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(prior + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(row + i), _mm_add_epi8(x, b));
+        }
+        for (; i < rowBytes; ++i)
+        {
+            row[i] = static_cast<uint8_t>(row[i] + prior[i]);
+        }
+    }
+
+    // 4 pixels per vector: a log-step prefix sum, then the running last pixel is added in
+    void unfilterSub4(uint8_t *row, size_t rowBytes)
+    {
+        __m128i last = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 16 <= rowBytes; i += 16)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+            x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+            x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+            x = _mm_add_epi8(x, last);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(row + i), x);
+            last = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+        for (; i < rowBytes; ++i)
+        {
+            row[i] = static_cast<uint8_t>(row[i] + (i >= 4 ? row[i - 4] : 0));
+        }
+    }
+
+    template <uint32_t STRIDE>
+    void unfilterSub(uint8_t *row, size_t rowBytes)
+    {
+        __m128i a = _mm_setzero_si128();
+        for (size_t i = 0; i < rowBytes; i += STRIDE)
+        {
+            a = _mm_add_epi8(a, loadPixel<STRIDE>(row + i));
+            storePixel<STRIDE>(row + i, a);
+        }
+    }
+
+    template <uint32_t STRIDE>
+    void unfilterAverage(uint8_t *row, const uint8_t *prior, size_t rowBytes)
+    {
+        // pavg rounds up, the low bit of a ^ b takes it back to floor((a + b) / 2)
+        const __m128i one = _mm_set1_epi8(1);
+        __m128i a = _mm_setzero_si128();
+        for (size_t i = 0; i < rowBytes; i += STRIDE)
+        {
+            __m128i b = loadPixel<STRIDE>(prior + i);
+            __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+            a = _mm_add_epi8(loadPixel<STRIDE>(row + i), average);
+            storePixel<STRIDE>(row + i, a);
+        }
+    }
+
+    template <uint32_t STRIDE>
+    void unfilterPaeth(uint8_t *row, const uint8_t *prior, size_t rowBytes)
+    {
+        // 16-bit lanes; p - a = b - c, p - b = a - c, p - c = (b - c) + (a - c)
+        const __m128i zero = _mm_setzero_si128();
+        __m128i a = zero, c = zero;
+        for (size_t i = 0; i < rowBytes; i += STRIDE)
+        {
+            __m128i b = _mm_unpacklo_epi8(loadPixel<STRIDE>(prior + i), zero);
+            __m128i toA = _mm_sub_epi16(b, c), toB = _mm_sub_epi16(a, c);
+            __m128i pc = abs16(_mm_add_epi16(toA, toB)), pa = abs16(toA), pb = abs16(toB);
+            __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+            __m128i predictor = select(_mm_cmpeq_epi16(smallest, pa), a, select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+            __m128i x = _mm_add_epi8(loadPixel<STRIDE>(row + i), _mm_packus_epi16(predictor, predictor));
+            storePixel<STRIDE>(row + i, x);
+            a = _mm_unpacklo_epi8(x, zero);
+            c = b;
+        }
+    }
+#endif
+
+    void unfilterRow(uint8_t filter, uint8_t *row, const uint8_t *prior, size_t rowBytes, uint32_t stride)
+    {
+#ifdef PNG_DECODER_SSE2
+        if (filter == 2)
+        {
+            unfilterUp(row, prior, rowBytes);
+            return;
+        }
+        if (stride == 4)
+        {
+            switch (filter)
+            {
+            case 1:
+                unfilterSub4(row, rowBytes);
+                return;
+            case 3:
+                unfilterAverage<4>(row, prior, rowBytes);
+                return;
+            case 4:
+                unfilterPaeth<4>(row, prior, rowBytes);
+                return;
+            }
+        }
+        else if (stride == 3)
+        {
+            switch (filter)
+            {
+            case 1:
+                unfilterSub<3>(row, rowBytes);
+                return;
+            case 3:
+                unfilterAverage<3>(row, prior, rowBytes);
+                return;
+            case 4:
+                unfilterPaeth<3>(row, prior, rowBytes);
+                return;
+            }
+        }
+#endif
+        unfilterScalar(filter, row, prior, rowBytes, stride);
+    }
+
+    // ---- conversion to RGBA8 ----
+
+    // Sample `x` of a row packed at `bitDepth` (1, 2, 4, 8 or 16 bits, big endian)
+    uint32_t getSample(const uint8_t *row, size_t x, uint32_t bitDepth)
+    {
+        switch (bitDepth)
+        {
+        case 16:
+            return static_cast<uint32_t>(row[x * 2]) << 8 | row[x * 2 + 1];
+        case 8:
+            return row[x];
+        default:
+        {
+            size_t bit = x * bitDepth;
+            return (row[bit >> 3] >> (8 - bitDepth - (bit & 7))) & ((1u << bitDepth) - 1);
+        }
+        }
+    }
+
+    uint8_t toByte(uint32_t sample, uint32_t bitDepth)
+    {
+        switch (bitDepth)
+        {
+        case 16:
+            return static_cast<uint8_t>(sample >> 8);
+        case 8:
+            return static_cast<uint8_t>(sample);
+        default:
+            return static_cast<uint8_t>(sample * 255 / ((1u << bitDepth) - 1));
+        }
+    }
+
+    void expandRow(const Format &format, const Transparency &transparency, const uint8_t *row, uint32_t width, uint8_t *out)
+    {
+        uint32_t depth = format.bitDepth;
+        switch (format.colorType)
+        {
+        case RGBA:
+            if (depth == 8)
+            {
+                std::memcpy(out, row, static_cast<size_t>(width) * 4);
+                return;
+            }
+            for (size_t i = 0; i < static_cast<size_t>(width) * 4; ++i)
+            {
+                out[i] = row[i * 2];
+            }
+            return;
+        case RGB:
+            for (uint32_t x = 0; x < width; ++x, out += 4)
+            {
+                uint32_t r = getSample(row, x * 3, depth), g = getSample(row, x * 3 + 1, depth), b = getSample(row, x * 3 + 2, depth);
+                out[0] = toByte(r, depth);
+                out[1] = toByte(g, depth);
+                out[2] = toByte(b, depth);
+                out[3] = transparency.hasKey && r == transparency.key[0] && g == transparency.key[1] && b == transparency.key[2] ? 0 : 255;
+            }
+            return;
+        case GRAY:
+            for (uint32_t x = 0; x < width; ++x, out += 4)
+            {
+                uint32_t sample = getSample(row, x, depth);
+                out[0] = out[1] = out[2] = toByte(sample, depth);
+                out[3] = transparency.hasKey && sample == transparency.key[0] ? 0 : 255;
+            }
+            return;
+        case GRAY_ALPHA:
+            for (uint32_t x = 0; x < width; ++x, out += 4)
+            {
+                out[0] = out[1] = out[2] = toByte(getSample(row, x * 2, depth), depth);
+                out[3] = toByte(getSample(row, x * 2 + 1, depth), depth);
+            }
+            return;
+        case PALETTE:
+            if (depth == 8)
+            {
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    std::memcpy(out + x * 4, transparency.palette[row[x]], 4);
+                }
+                return;
+            }
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                std::memcpy(out + x * 4, transparency.palette[getSample(row, x, depth)], 4);
+            }
+            return;
+        }
+    }
+}
+
+bool PngDecoder::isPng(const void *data, size_t size)
+{
+    return size >= sizeof(SIGNATURE) && std::memcmp(data, SIGNATURE, sizeof(SIGNATURE)) == 0;
+}
+
+DecodedImage PngDecoder::decode(const std::string &filePath)
+{
+    MappedFile file(filePath);
+    return decode(reinterpret_cast<const uint8_t *>(file.data()), file.size(), filePath);
+}
+
+DecodedImage PngDecoder::decode(const uint8_t *data, size_t size, const std::string &name)
+{
+    auto fail = [&name](const std::string &message)
+    {
+        throw std::runtime_error("PngDecoder::decode: " + name + ": " + message);
+    };
+    if (!isPng(data, size))
+    {
+        fail("not a PNG file");
+    }
+
+    Format format;
+    Transparency transparency;
+    for (auto &entry : transparency.palette)
+    {
+        entry[0] = entry[1] = entry[2] = 0; // out of range indices decode as opaque black
+        entry[3] = 255;
+    }
+    bool hasHeader = false, hasPalette = false, hasSrgb = false, hasGamma22 = false;
+    std::vector<std::pair<const uint8_t *, size_t>> idat;
+    size_t compressedSize = 0;
+
+    for (size_t position = sizeof(SIGNATURE); position + 12 <= size;)
+    {
+        uint32_t length = readBigEndian(data + position);
+        const uint8_t *type = data + position + 4;
+        const uint8_t *body = data + position + 8;
+        if (length > size - position - 12)
+        {
+            fail("truncated chunk");
+        }
+        position += 12 + static_cast<size_t>(length);
+
+        if (std::memcmp(type, "IHDR", 4) == 0)
+        {
+            if (length < 13)
+            {
+                fail("short IHDR");
+            }
+            format.width = readBigEndian(body);
+            format.height = readBigEndian(body + 4);
+            format.bitDepth = body[8];
+            format.colorType = body[9];
+            format.isInterlaced = body[12] == 1;
+            if (body[10] != 0 || body[11] != 0 || body[12] > 1)
+            {
+                fail("unknown compression, filter or interlace method");
+            }
+
+            static const uint8_t CHANNELS[7] = {1, 0, 3, 1, 2, 0, 4};
+            format.channels = format.colorType < 7 ? CHANNELS[format.colorType] : 0;
+            uint8_t depth = format.bitDepth;
+            bool isValidDepth = format.colorType == GRAY      ? depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16
+                                : format.colorType == PALETTE ? depth == 1 || depth == 2 || depth == 4 || depth == 8
+                                                              : depth == 8 || depth == 16;
+            if (format.channels == 0 || !isValidDepth)
+            {
+                fail("invalid color type / bit depth combination");
+            }
+            if (format.width == 0 || format.height == 0 || format.width > (1u << 24) || format.height > (1u << 24))
+            {
+                fail("invalid dimensions");
+            }
+            hasHeader = true;
+        }
+        else if (std::memcmp(type, "PLTE", 4) == 0)
+        {
+            for (uint32_t i = 0; i < std::min(length / 3, 256u); ++i)
+            {
+                std::memcpy(transparency.palette[i], body + i * 3, 3);
+            }
+            hasPalette = true;
+        }
+        else if (std::memcmp(type, "tRNS", 4) == 0)
+        {
+            if (format.colorType == PALETTE)
+            {
+                for (uint32_t i = 0; i < std::min(length, 256u); ++i)
+                {
+                    transparency.palette[i][3] = body[i];
+                }
+            }
+            else if ((format.colorType == GRAY && length >= 2) || (format.colorType == RGB && length >= 6))
+            {
+                for (uint32_t i = 0; i < (format.colorType == RGB ? 3u : 1u); ++i)
+                {
+                    transparency.key[i] = static_cast<uint16_t>(body[i * 2] << 8 | body[i * 2 + 1]);
+                }
+                transparency.hasKey = true;
+            }
+        }
+        else if (std::memcmp(type, "sRGB", 4) == 0)
+        {
+            hasSrgb = true;
+        }
+        else if (std::memcmp(type, "gAMA", 4) == 0 && length >= 4)
+        {
+            hasGamma22 = readBigEndian(body) == GAMMA_22;
+        }
+        else if (std::memcmp(type, "IDAT", 4) == 0)
+        {
+            idat.emplace_back(body, length);
+            compressedSize += length;
+        }
+        else if (std::memcmp(type, "IEND", 4) == 0)
+        {
+            break;
+        }
+        // anything else is skipped, even chunks flagged critical: galaxy.png carries a nonstandard "ICC_"
+        // that WIC ignores as well
+    }
+    if (!hasHeader || idat.empty())
+    {
+        fail("missing IHDR or IDAT");
+    }
+    if (format.colorType == PALETTE && !hasPalette)
+    {
+        fail("palette image without PLTE");
+    }
+
+    StagingPool &pool = StagingPool::getInstance();
+
+    // image data split over several IDAT chunks is gathered, a single chunk inflates in place
+    StagingBuffer gathered;
+    const uint8_t *compressed = idat.front().first;
+    if (idat.size() > 1)
+    {
+        gathered = pool.acquire(compressedSize);
+        size_t offset = 0;
+        for (const auto &[chunk, length] : idat)
+        {
+            std::memcpy(gathered.data() + offset, chunk, length);
+            offset += length;
+        }
+        compressed = gathered.data();
+    }
+
+    const Pass *passes = format.isInterlaced ? ADAM7 : &FULL_IMAGE;
+    uint32_t passCount = format.isInterlaced ? 7 : 1;
+    size_t filteredSize = 0, maxRowBytes = 0;
+    for (uint32_t p = 0; p < passCount; ++p)
+    {
+        const Pass &pass = passes[p];
+        uint32_t passWidth = format.width > pass.x0 ? (format.width - pass.x0 + pass.dx - 1) / pass.dx : 0;
+        uint32_t passHeight = format.height > pass.y0 ? (format.height - pass.y0 + pass.dy - 1) / pass.dy : 0;
+        if (passWidth != 0 && passHeight != 0)
+        {
+            filteredSize += passHeight * (1 + format.getRowBytes(passWidth));
+            maxRowBytes = std::max(maxRowBytes, format.getRowBytes(passWidth));
+        }
+    }
+
+    StagingBuffer filtered = pool.acquire(filteredSize);
+    size_t written = 0;
+    try
+    {
+        written = Inflate::decompressZlib(compressed, compressedSize, filtered.data(), filteredSize);
+    }
+    catch (const std::exception &e)
+    {
+        fail(e.what());
+    }
+    if (written != filteredSize)
+    {
+        fail("image data is " + std::to_string(written) + " bytes, expected " + std::to_string(filteredSize));
+    }
+    gathered.reset();
+
+    DecodedImage image;
+    image.width = format.width;
+    image.height = format.height;
+    image.isSrgb = hasSrgb || hasGamma22;
+    image.pixels = pool.acquire(static_cast<size_t>(format.width) * format.height * 4);
+
+    uint32_t stride = format.getFilterStride();
+    std::vector<uint8_t> zeroRow(maxRowBytes, 0);
+    std::vector<uint8_t> passRow(format.isInterlaced ? static_cast<size_t>(format.width) * 4 : 0);
+    uint8_t *cursor = filtered.data();
+    for (uint32_t p = 0; p < passCount; ++p)
+    {
+        const Pass &pass = passes[p];
+        uint32_t passWidth = format.width > pass.x0 ? (format.width - pass.x0 + pass.dx - 1) / pass.dx : 0;
+        uint32_t passHeight = format.height > pass.y0 ? (format.height - pass.y0 + pass.dy - 1) / pass.dy : 0;
+        if (passWidth == 0 || passHeight == 0)
+        {
+            continue;
+        }
+
+        size_t rowBytes = format.getRowBytes(passWidth);
+        const uint8_t *prior = zeroRow.data();
+        for (uint32_t y = 0; y < passHeight; ++y)
+        {
+            uint8_t filter = cursor[0];
+            uint8_t *row = cursor + 1;
+            if (filter > 4)
+            {
+                fail("invalid filter type " + std::to_string(filter));
+            }
+            unfilterRow(filter, row, prior, rowBytes, stride);
+
+            uint32_t imageY = pass.y0 + y * pass.dy;
+            uint8_t *out = image.pixels.data() + static_cast<size_t>(imageY) * format.width * 4;
+            if (!format.isInterlaced)
+            {
+                expandRow(format, transparency, row, passWidth, out);
+            }
+            else
+            {
+                expandRow(format, transparency, row, passWidth, passRow.data());
+                for (uint32_t x = 0; x < passWidth; ++x)
+                {
+                    std::memcpy(out + (pass.x0 + static_cast<size_t>(x) * pass.dx) * 4, passRow.data() + x * 4, 4);
+                }
+            }
+
+            prior = row;
+            cursor += 1 + rowBytes;
+        }
+    }
+    return image;
+}
@@ -1,7 +1,157 @@
 #include "resources/render_component.h"
+#include "utils/frustum.h"
+#include <algorithm>
 
 RenderComponent::RenderComponent(std::shared_ptr<Mesh> mesh, std::shared_ptr<MaterialBase> material)
-    : m_isCullFront(true), m_mesh(mesh), m_material(material) {}
+    : m_isCullFront(true), m_lodLevel(0), m_lodPixelError(1.f), m_lodHysteresis(0.25f), m_meshletCount(0), m_visibleMeshletCount(0), m_mesh(mesh), m_material(material) {}
+
+RenderComponent::RenderComponent(std::shared_ptr<Mesh> mesh, std::shared_ptr<LazyAsset<MaterialBase>> material)
+    : RenderComponent(mesh, material ? material->get() : nullptr)
+{
+    m_lazyMaterial = material;
+}
+
+RenderComponent::RenderComponent(std::shared_ptr<LazyAsset<Mesh>> mesh, std::shared_ptr<MaterialBase> material)
+    : RenderComponent(mesh ? mesh->get() : nullptr, material)
+{
+    m_lazyMesh = mesh;
+}
+
+RenderComponent::RenderComponent(std::shared_ptr<LazyAsset<Mesh>> mesh, std::shared_ptr<LazyAsset<MaterialBase>> material)
+    : RenderComponent(mesh ? mesh->get() : nullptr, material ? material->get() : nullptr)
+{
+    m_lazyMesh = mesh;
+    m_lazyMaterial = material;
+}
+
+void RenderComponent::requestAssets()
+{
+    // the handles go once the asset is in, a failed load keeps the placeholder and its handle
+    if (m_lazyMesh && m_lazyMesh->request())
+    {
+        m_mesh = m_lazyMesh->get();
+        m_lazyMesh.reset();
+        m_lodLevel = 0;
+    }
+    if (m_lazyMaterial && m_lazyMaterial->request())
+    {
+        m_material = m_lazyMaterial->get();
+        m_lazyMaterial.reset();
+    }
+}
+
+void RenderComponent::prepare(const DirectX::XMMATRIX &world, const RenderView *view)
+{
+    m_drawRanges.clear();
+    m_meshletCount = 0;
+    m_visibleMeshletCount = 0;
+    if (!m_mesh || m_mesh->getLodCount() == 0)
+    {
+        return;
+    }
+
+    if (!view)
+    {
+        m_lodLevel = 0;
+    }
+    else
+    {
+        requestTextureDetail(world, *view);
+        selectLod(world, *view);
+        if (m_lodLevel == 0 && !m_mesh->getMeshlets().empty())
+        {
+            cullMeshlets(world, *view);
+            return;
+        }
+    }
+
+    const MeshLod &lod = m_mesh->getLod(m_lodLevel);
+    m_drawRanges.push_back({lod.firstIndex, lod.indexCount});
+}
+
+void RenderComponent::requestTextureDetail(const DirectX::XMMATRIX &world, const RenderView &view) const
+{
+    if (!m_material)
+    {
+        return;
+    }
+
+    const MeshBounds &bounds = m_mesh->getBounds();
+    DirectX::XMVECTOR center = DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&bounds.sphereCenter), world);
+    float scale = std::max({DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[0])),
+                            DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[1])),
+                            DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[2]))});
+    float radius = bounds.sphereRadius * scale;
+    float distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(center, DirectX::XMLoadFloat3(&view.cameraPosition))));
+    distance = std::max(distance - radius, 1e-3f);
+
+    // projected diameter of the bounding sphere
+    m_material->requestDetail(2.f * radius * view.pixelsPerUnit / distance);
+}
+
+void RenderComponent::selectLod(const DirectX::XMMATRIX &world, const RenderView &view)
+{
+    if (!m_mesh || m_mesh->getLodCount() <= 1)
+    {
+        m_lodLevel = 0;
+        return;
+    }
+
+    const MeshBounds &bounds = m_mesh->getBounds();
+    DirectX::XMVECTOR center = DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&bounds.sphereCenter), world);
+    float scale = std::max({DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[0])),
+                            DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[1])),
+                            DirectX::XMVectorGetX(DirectX::XMVector3Length(world.r[2]))});
+    float distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(center, DirectX::XMLoadFloat3(&view.cameraPosition))));
+    distance = std::max(distance - bounds.sphereRadius * scale, 1e-3f);
+
+    // pixels per object space unit at the sphere's nearest point
+    float pixelsPerObjectUnit = scale * view.pixelsPerUnit / distance;
+    uint32_t lastLevel = m_mesh->getLodCount() - 1;
+    m_lodLevel = std::min(m_lodLevel, lastLevel);
+
+    while (m_lodLevel > 0 && m_mesh->getLod(m_lodLevel).error * pixelsPerObjectUnit > m_lodPixelError)
+    {
+        --m_lodLevel;
+    }
+    while (m_lodLevel < lastLevel && m_mesh->getLod(m_lodLevel + 1).error * pixelsPerObjectUnit < m_lodPixelError * (1.f - m_lodHysteresis))
+    {
+        ++m_lodLevel;
+    }
+}
+
+void RenderComponent::cullMeshlets(const DirectX::XMMATRIX &world, const RenderView &view)
+{
+    const std::vector<Meshlet> &meshlets = m_mesh->getMeshlets();
+    m_meshletCount = meshlets.size();
+
+    // bring the camera into object space instead of every cluster into world space
+    Frustum frustum = Frustum::fromMatrix(world * view.viewProjection);
+    DirectX::XMMATRIX invWorld = DirectX::XMMatrixInverse(nullptr, world);
+    DirectX::XMFLOAT3 cameraPosition;
+    DirectX::XMStoreFloat3(&cameraPosition, DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&view.cameraPosition), invWorld));
+
+    // the normal cone assumes outward faces are the drawn ones, see m_isCullFront
+    bool coneCulling = m_isCullFront;
+    for (const Meshlet &meshlet : meshlets)
+    {
+        if (!frustum.intersectsSphere(meshlet.center, meshlet.radius) || (coneCulling && MeshletBuilder::isBackfacing(meshlet, cameraPosition)))
+        {
+            continue;
+        }
+
+        ++m_visibleMeshletCount;
+        uint32_t indexCount = meshlet.triangleCount * 3;
+        if (!m_drawRanges.empty() && m_drawRanges.back().firstIndex + m_drawRanges.back().indexCount == meshlet.firstIndex)
+        {
+            m_drawRanges.back().indexCount += indexCount;
+        }
+        else
+        {
+            m_drawRanges.push_back({meshlet.firstIndex, indexCount});
+        }
+    }
+}
 
 void RenderComponent::render(ID3D11DeviceContext *deviceContext)
 {
@@ -13,5 +163,11 @@ void RenderComponent::render(ID3D11DeviceContext *deviceContext)
     {
         m_material->bind(deviceContext);
     }
-    deviceContext->DrawIndexed(m_mesh->getIndicesCount(), 0, 0); // TODO: index offset if needed
+    // ranges are relative to the mesh, pooled meshes sit at an offset inside a shared arena
+    UINT firstIndex = m_mesh ? m_mesh->getFirstIndex() : 0;
+    INT baseVertex = m_mesh ? static_cast<INT>(m_mesh->getBaseVertex()) : 0;
+    for (const DrawRange &range : m_drawRanges)
+    {
+        deviceContext->DrawIndexed(range.indexCount, firstIndex + range.firstIndex, baseVertex);
+    }
 }
@@ -1,6 +1,7 @@
 #include "resources/shader.h"
 #include <d3dcompiler.h>
 #include <assert.h>
+#include <cstring>
 #include <stdexcept>
 
 Shader::Shader(ID3D11Device *device,
@@ -8,17 +9,16 @@ Shader::Shader(ID3D11Device *device,
                const std::wstring &pixelShaderPath,
                const D3D11_INPUT_ELEMENT_DESC *inputElementDescs,
                UINT numInputElementDescs)
+    : Shader(device, compile(vertexShaderPath, pixelShaderPath), inputElementDescs, numInputElementDescs)
 {
-    // vertex shader
+}
 
-    Microsoft::WRL::ComPtr<ID3DBlob> vsBlob;
-    HRESULT hr = compileShaderFromFile(vertexShaderPath, "VSMain", "vs_5_0", vsBlob.GetAddressOf());
-    if (FAILED(hr))
-    {
-        throw std::runtime_error("Shader:Shader: Failed to compile vertex shader");
-    }
+Shader::Shader(ID3D11Device *device, const ShaderBytecode &bytecode, const D3D11_INPUT_ELEMENT_DESC *inputElementDescs, UINT numInputElementDescs)
+{
+    // vertex shader
 
-    hr = device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, m_vertexShader.GetAddressOf());
+    ID3DBlob *vsBlob = bytecode.vertexShader.Get();
+    HRESULT hr = device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, m_vertexShader.GetAddressOf());
     if (FAILED(hr))
     {
         throw std::runtime_error("Shader:Shader: Failed to create vertex shader");
@@ -35,18 +35,50 @@ Shader::Shader(ID3D11Device *device,
 
     // pixel shader
 
-    Microsoft::WRL::ComPtr<ID3DBlob> psBlob;
-    hr = compileShaderFromFile(pixelShaderPath, "PSMain", "ps_5_0", psBlob.GetAddressOf());
+    ID3DBlob *psBlob = bytecode.pixelShader.Get();
+    hr = device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, m_pixelShader.GetAddressOf());
     if (FAILED(hr))
     {
-        throw std::runtime_error("Shader:Shader: Failed to compile pixel shader");
+        throw std::runtime_error("Shader:Shader: Failed to create pixel shader");
     }
 
-    hr = device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, m_pixelShader.GetAddressOf());
+    m_contentKey = hashBytes(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize());
+    m_contentKey = hashBytes(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), m_contentKey);
+    m_contentKey = hashInputLayout(inputElementDescs, numInputElementDescs, m_contentKey);
+}
+
+ShaderBytecode Shader::compile(const std::wstring &vertexShaderPath, const std::wstring &pixelShaderPath)
+{
+    ShaderBytecode bytecode;
+    HRESULT hr = compileShaderFromFile(vertexShaderPath, "VSMain", "vs_5_0", bytecode.vertexShader.GetAddressOf());
     if (FAILED(hr))
     {
-        throw std::runtime_error("Shader:Shader: Failed to create pixel shader");
+        throw std::runtime_error("Shader::compile: Failed to compile vertex shader");
+    }
+
+    hr = compileShaderFromFile(pixelShaderPath, "PSMain", "ps_5_0", bytecode.pixelShader.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Shader::compile: Failed to compile pixel shader");
+    }
+    return bytecode;
+}
+
+uint64_t Shader::hashInputLayout(const D3D11_INPUT_ELEMENT_DESC *inputElementDescs, UINT numInputElementDescs, uint64_t seed)
+{
+    uint64_t key = hashValue(numInputElementDescs, seed);
+    for (UINT i = 0; i < numInputElementDescs; ++i)
+    {
+        const D3D11_INPUT_ELEMENT_DESC &desc = inputElementDescs[i];
+        key = hashBytes(desc.SemanticName, std::strlen(desc.SemanticName), key);
+        key = hashValue(desc.SemanticIndex, key);
+        key = hashValue(desc.Format, key);
+        key = hashValue(desc.InputSlot, key);
+        key = hashValue(desc.AlignedByteOffset, key);
+        key = hashValue(desc.InputSlotClass, key);
+        key = hashValue(desc.InstanceDataStepRate, key);
     }
+    return key;
 }
 
 void Shader::bind(ID3D11DeviceContext *deviceContext) const
@@ -0,0 +1,126 @@
+#include "resources/static_batch.h"
+#include "resources/render_component.h"
+#include "entity/entity.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <tuple>
+
+void StaticBatch::append(const std::vector<Vertex> &vertices, const uint32_t *indices, size_t indexCount, const DirectX::XMMATRIX &world,
+                         std::vector<Vertex> &batchVertices, std::vector<uint32_t> &batchIndices)
+{
+    DirectX::XMMATRIX normalMatrix = DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, world));
+    bool isMirrored = DirectX::XMVectorGetX(DirectX::XMMatrixDeterminant(world)) < 0.f;
+
+    std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+    batchIndices.reserve(batchIndices.size() + indexCount);
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        uint32_t corners[3] = {indices[i], indices[i + 1], indices[i + 2]};
+        if (isMirrored)
+        {
+            std::swap(corners[1], corners[2]);
+        }
+
+        for (uint32_t corner : corners)
+        {
+            if (remap[corner] == UINT32_MAX)
+            {
+                const Vertex &vertex = vertices[corner];
+                Vertex transformed = vertex;
+                DirectX::XMStoreFloat3(&transformed.pos, DirectX::XMVector3TransformCoord(DirectX::XMLoadFloat3(&vertex.pos), world));
+                DirectX::XMStoreFloat3(&transformed.n, DirectX::XMVector3Normalize(DirectX::XMVector3TransformNormal(DirectX::XMLoadFloat3(&vertex.n), normalMatrix)));
+                remap[corner] = static_cast<uint32_t>(batchVertices.size());
+                batchVertices.push_back(transformed);
+            }
+            batchIndices.push_back(remap[corner]);
+        }
+    }
+}
+
+std::vector<std::shared_ptr<EntityBase>> StaticBatch::build(ID3D11Device *device, const std::vector<std::shared_ptr<EntityBase>> &entities,
+                                                            std::unordered_set<const RenderComponent *> &batchedComponents)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    // material, vertex format (decides the shader), cull front
+    using GroupKey = std::tuple<const MaterialBase *, VertexFormat, bool>;
+    struct Member
+    {
+        const EntityBase *entity;
+        std::shared_ptr<RenderComponent> component;
+    };
+    std::map<GroupKey, std::vector<Member>> groups;
+    for (const auto &entity : entities)
+    {
+        for (const auto &comp : entity->getRenderComponents())
+        {
+            // placeholders are swapped for the lazy assets later, a batch would keep drawing them
+            const std::shared_ptr<Mesh> &mesh = comp->getMesh();
+            if (!mesh || !comp->getMaterial() || comp->hasPendingAssets() || mesh->getLodCount() == 0 || mesh->getPrimitiveTopology() != D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+            {
+                continue;
+            }
+            groups[{comp->getMaterial().get(), mesh->getVertexFormat(), comp->getIsCullFront()}].push_back({entity.get(), comp});
+        }
+    }
+
+    std::vector<std::shared_ptr<EntityBase>> batches;
+    size_t memberCount = 0;
+    for (auto &[key, members] : groups)
+    {
+        if (members.size() < 2)
+        {
+            continue; // nothing to save
+        }
+
+        std::vector<Vertex> batchVertices;
+        std::vector<uint32_t> batchIndices;
+        std::vector<const RenderComponent *> merged;
+        for (const Member &member : members)
+        {
+            Mesh &mesh = *member.component->getMesh();
+            bool isRematerialized = !mesh.isCpuResident();
+            if (isRematerialized && !mesh.rematerialize())
+            {
+                continue; // drawn on its own
+            }
+
+            const MeshLod &lod = mesh.getLod(0);
+            append(mesh.getVertices(), mesh.getIndices().data() + lod.firstIndex, lod.indexCount, member.entity->getWorldMatrix(), batchVertices, batchIndices);
+            merged.push_back(member.component.get());
+            if (isRematerialized)
+            {
+                mesh.releaseCpuData();
+            }
+        }
+        if (merged.size() < 2)
+        {
+            continue;
+        }
+
+        MeshOptions options;
+        options.vertexFormat = std::get<1>(key);
+        options.residency = MeshResidency::Discard;
+        options.buildMeshlets = true;
+        std::string name = "static_batch_" + std::to_string(batches.size());
+        auto mesh = std::make_shared<Mesh>(device, batchVertices, batchIndices, name, options);
+
+        auto comp = std::make_shared<RenderComponent>(mesh, members.front().component->getMaterial());
+        comp->setIsCullFront(std::get<2>(key));
+        auto batch = std::make_shared<EntityBase>(device);
+        batch->addRenderComponent(comp);
+        batch->setIsStatic(true);
+        batches.push_back(batch);
+
+        batchedComponents.insert(merged.begin(), merged.end());
+        memberCount += merged.size();
+        Logger::Log(Logger::LogLevel::INFO, "StaticBatch::build: {}: {} components, {} vertices, {} triangles",
+                    name, merged.size(), batchVertices.size(), batchIndices.size() / 3);
+    }
+
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "StaticBatch::build: {} static entities, {} components merged into {} batches ({} -> {} draws) in {:.2f} ms",
+                entities.size(), memberCount, batches.size(), memberCount, batches.size(), elapsedMs);
+    return batches;
+}
@@ -1,5 +1,183 @@
 #include "resources/texture.h"
+#include "resources/mip_generator.h"
+#include "resources/block_compressor.h"
+#include "resources/texture_cache.h"
+#include "resources/png_decoder.h"
+#include "resources/texture_residency.h"
+#include "resources/texture_streamer.h"
+#include "utils/hash.h"
+#include "utils/mapped_file.h"
+#include "utils/thread_pool.h"
 #include "external/DirectXTex/DirectXTex.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <objbase.h>
+#endif
+
+namespace
+{
+    constexpr MipFilter MIP_FILTER = MipFilter::Kaiser;
+
+    uint64_t getOptionsKey(TextureCompression compression)
+    {
+        return hashValue(MIP_FILTER, hashValue(compression));
+    }
+
+    // First level of the progressive tail: PROGRESSIVE_TAIL_SIZE or smaller, in whole blocks when block compressed
+    uint32_t getTailMip(DXGI_FORMAT format, uint32_t width, uint32_t height, uint32_t mipLevels)
+    {
+        uint32_t mip = 0;
+        while (mip + 1 < mipLevels && std::max(width >> mip, height >> mip) > ImageTexture::PROGRESSIVE_TAIL_SIZE)
+        {
+            uint32_t nextWidth = std::max(width >> (mip + 1), 1u);
+            uint32_t nextHeight = std::max(height >> (mip + 1), 1u);
+            if (TextureCache::isBlockCompressed(format) && (nextWidth % 4 != 0 || nextHeight % 4 != 0))
+            {
+                break;
+            }
+            ++mip;
+        }
+        return mip;
+    }
+}
+
+const TextureBase *TextureBase::s_boundTextures[TextureBase::TRACKED_SLOTS] = {};
+uint64_t TextureBase::s_frame = 1; // 0 is never bound
+
+TextureBase::~TextureBase()
+{
+    if (m_residencyId != UINT32_MAX)
+    {
+        TextureResidency::getInstance().untrack(m_residencyId);
+    }
+    forgetBindings(); // a later texture could reuse the address
+}
+
+size_t TextureBase::getGpuBytes() const
+{
+    return m_residencyId != UINT32_MAX ? TextureResidency::getInstance().getResidentBytes(m_residencyId) : 0;
+}
+
+void TextureBase::invalidateBindings()
+{
+    std::fill(std::begin(s_boundTextures), std::end(s_boundTextures), nullptr);
+}
+
+bool TextureBase::isBound(UINT slot) const
+{
+    return slot < TRACKED_SLOTS && s_boundTextures[slot] == this;
+}
+
+void TextureBase::setBound(UINT slot) const
+{
+    if (slot < TRACKED_SLOTS)
+    {
+        s_boundTextures[slot] = this;
+    }
+}
+
+void TextureBase::forgetBindings() const
+{
+    for (const TextureBase *&bound : s_boundTextures)
+    {
+        if (bound == this)
+        {
+            bound = nullptr;
+        }
+    }
+}
+
+void TextureBase::requestDetail(float screenSize) const
+{
+    if (m_screenSizeFrame != s_frame)
+    {
+        m_screenSizeFrame = s_frame;
+        m_screenSize = 0.f;
+    }
+    m_screenSize = std::max(m_screenSize, screenSize);
+}
+
+void TextureBase::trackResidency(ID3D11Texture2D *texture, bool isStreamable)
+{
+    D3D11_TEXTURE2D_DESC desc = {};
+    texture->GetDesc(&desc);
+    std::vector<size_t> levelBytes(desc.MipLevels);
+    uint32_t maxResidentMip = 0;
+    for (UINT mip = 0; mip < desc.MipLevels; ++mip)
+    {
+        uint32_t width = std::max(desc.Width >> mip, 1u);
+        uint32_t height = std::max(desc.Height >> mip, 1u);
+        levelBytes[mip] = TextureCache::getLevelSize(desc.Format, width, height) * desc.ArraySize;
+
+        // D3D wants the top level of a block compressed texture in whole blocks
+        bool isWholeBlocks = !TextureCache::isBlockCompressed(desc.Format) || (width % 4 == 0 && height % 4 == 0);
+        maxResidentMip = isStreamable && isWholeBlocks ? mip : maxResidentMip;
+    }
+    if (m_residencyId != UINT32_MAX)
+    {
+        TextureResidency::getInstance().untrack(m_residencyId); // the chain changed under a tracked texture
+    }
+    m_residencyId = TextureResidency::getInstance().track(this, levelBytes, desc.Width, desc.Height, maxResidentMip);
+}
+
+void TextureBase::trackResidency(size_t gpuBytes, size_t cpuBytes)
+{
+    m_residencyId = TextureResidency::getInstance().track(this, {gpuBytes}, 1, 1, 0, cpuBytes);
+}
+
+Microsoft::WRL::ComPtr<ID3D11Texture2D> TextureBase::copyMipTail(ID3D11Device *device, ID3D11DeviceContext *deviceContext,
+                                                                 ID3D11Texture2D *source, UINT firstMip)
+{
+    D3D11_TEXTURE2D_DESC desc = {};
+    source->GetDesc(&desc);
+    UINT sourceMips = desc.MipLevels;
+    desc.Width = std::max(desc.Width >> firstMip, 1u);
+    desc.Height = std::max(desc.Height >> firstMip, 1u);
+    desc.MipLevels = sourceMips - firstMip;
+    desc.Usage = D3D11_USAGE_DEFAULT; // copy destination
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = 0;
+    desc.MiscFlags = 0;
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> target;
+    HRESULT hr = device->CreateTexture2D(&desc, nullptr, target.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create reduced texture.");
+    }
+    for (UINT slice = 0; slice < desc.ArraySize; ++slice)
+    {
+        for (UINT level = 0; level < desc.MipLevels; ++level)
+        {
+            deviceContext->CopySubresourceRegion(target.Get(), D3D11CalcSubresource(level, slice, desc.MipLevels), 0, 0, 0,
+                                                 source, D3D11CalcSubresource(level + firstMip, slice, sourceMips), nullptr);
+        }
+    }
+    return target;
+}
+
+void TextureBase::createSampler(ID3D11Device *device)
+{
+    // wrap, the default sampler clamps: tiling uvs and the icosphere seam (u past 1) need it
+    D3D11_SAMPLER_DESC desc = {};
+    desc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+    desc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
+    desc.AddressV = D3D11_TEXTURE_ADDRESS_WRAP;
+    desc.AddressW = D3D11_TEXTURE_ADDRESS_WRAP;
+    desc.ComparisonFunc = D3D11_COMPARISON_NEVER;
+    desc.MinLOD = 0.f;
+    desc.MaxLOD = D3D11_FLOAT32_MAX;
+
+    HRESULT hr = device->CreateSamplerState(&desc, m_sampler.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create texture sampler state.");
+    }
+}
 
 ConstantTexture::ConstantTexture(ID3D11Device *device, const DirectX::XMFLOAT4 &color)
 {
@@ -31,73 +209,513 @@ ConstantTexture::ConstantTexture(ID3D11Device *device, const DirectX::XMFLOAT4 &
 
     D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
     srvDesc.Format = desc.Format;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = 1;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    srvDesc.Texture2DArray.MipLevels = 1;
+    srvDesc.Texture2DArray.ArraySize = 1;
 
     hr = device->CreateShaderResourceView(m_texture.Get(), &srvDesc, m_srv.GetAddressOf());
     if (FAILED(hr))
     {
         throw std::runtime_error("Failed to create shader resource view for constant texture.");
     }
+    trackResidency(m_texture.Get(), false);
 }
 
 void ConstantTexture::bind(ID3D11DeviceContext *deviceContext, UINT slot) const
 {
+    markUsed();
+    if (isBound(slot))
+    {
+        return;
+    }
     deviceContext->PSSetShaderResources(slot, 1, m_srv.GetAddressOf());
+    setBound(slot);
+}
+
+ImageTexture::ImageTexture(ID3D11Device *device, const std::string &filePath, TextureCompression compression, TextureLoading loading)
+    : ImageTexture(device, prepare(filePath, compression, loading))
+{
+}
+
+ImageTexture::ImageTexture(ID3D11Device *device, PreparedTexture &&prepared)
+    : m_filePath(prepared.filePath), m_compression(prepared.compression)
+{
+    upload(device, std::move(prepared));
+    createSampler(device);
+    if (!m_isStreamPending)
+    {
+        trackResidency(m_texture.Get(), true);
+    }
+}
+
+ImageTexture::PreparedTexture ImageTexture::prepare(const std::string &filePath, TextureCompression compression, TextureLoading loading)
+{
+    return loading == TextureLoading::Progressive ? prepareTail(filePath, compression) : prepareChain(filePath, compression);
 }
 
-ImageTexture::ImageTexture(ID3D11Device *device, const std::string &filePath)
+std::vector<std::shared_ptr<ImageTexture>> ImageTexture::loadAll(ID3D11Device *device, const std::vector<std::string> &filePaths,
+                                                                 TextureCompression compression, TextureLoading loading)
 {
-    loadFromFile(device, filePath);
+    return createAll(device, prepareAll(filePaths, compression, loading));
+}
+
+std::vector<ImageTexture::PreparedTexture> ImageTexture::prepareAll(const std::vector<std::string> &filePaths, TextureCompression compression,
+                                                                    TextureLoading loading)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    std::vector<PreparedTexture> prepared(filePaths.size());
+    ThreadPool::getInstance().parallelFor(filePaths.size(), 1, [&](size_t begin, size_t end)
+                                          {
+        for (size_t i = begin; i < end; ++i)
+        {
+            prepared[i] = prepare(filePaths[i], compression, loading);
+        } });
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "ImageTexture::prepareAll: {} textures in {:.2f} ms", filePaths.size(), elapsedMs);
+    return prepared;
+}
+
+std::vector<std::shared_ptr<ImageTexture>> ImageTexture::createAll(ID3D11Device *device, std::vector<PreparedTexture> &&prepared)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    std::vector<std::shared_ptr<ImageTexture>> textures;
+    textures.reserve(prepared.size());
+    size_t streamedCount = 0;
+    for (PreparedTexture &texture : prepared)
+    {
+        textures.push_back(std::make_shared<ImageTexture>(device, std::move(texture)));
+        if (textures.back()->isStreamPending())
+        {
+            TextureStreamer::getInstance().request(textures.back());
+            ++streamedCount;
+        }
+    }
+    prepared.clear();
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "ImageTexture::createAll: {} textures in {:.2f} ms, {} streaming the rest", textures.size(), elapsedMs, streamedCount);
+    return textures;
 }
 
 void ImageTexture::bind(ID3D11DeviceContext *deviceContext, UINT slot) const
 {
+    markUsed();
+    if (isBound(slot))
+    {
+        return;
+    }
     deviceContext->PSSetShaderResources(slot, 1, m_srv.GetAddressOf());
+    deviceContext->PSSetSamplers(slot, 1, m_sampler.GetAddressOf());
+    setBound(slot);
 }
 
-void ImageTexture::loadFromFile(ID3D11Device *device, const std::string &filePath)
+void ImageTexture::setResidentMip(ID3D11Device *device, ID3D11DeviceContext *deviceContext, uint32_t mip)
 {
-    DirectX::ScratchImage scratchImage;
-    HRESULT hr = DirectX::LoadFromWICFile(
-        std::wstring(filePath.begin(), filePath.end()).c_str(),
-        DirectX::WIC_FLAGS_NONE,
-        nullptr,
-        scratchImage);
-    if (FAILED(hr))
+    if (mip == m_residentMip)
     {
-        throw std::runtime_error("Failed to load texture from file: " + filePath);
+        return;
     }
 
-    Microsoft::WRL::ComPtr<ID3D11Resource> textureResource;
-    hr = DirectX::CreateTexture(
-        device,
-        scratchImage.GetImages(),
-        scratchImage.GetImageCount(),
-        scratchImage.GetMetadata(),
-        textureResource.GetAddressOf());
-    if (FAILED(hr))
+    if (mip > m_residentMip)
     {
-        throw std::runtime_error("Failed to create texture from image data.");
+        // what stays is on the GPU already
+        setTexture(device, copyMipTail(device, deviceContext, m_texture.Get(), mip - m_residentMip));
+    }
+    else
+    {
+        TextureCache::CachedTexture cached;
+        if (loadCached(m_filePath, m_compression, cached))
+        {
+            std::vector<D3D11_SUBRESOURCE_DATA> initData(cached.levels.size() - mip);
+            for (size_t i = 0; i < initData.size(); ++i)
+            {
+                initData[i].pSysMem = cached.levels[mip + i];
+                initData[i].SysMemPitch = cached.rowPitches[mip + i];
+            }
+            setTexture(device, createTexture(device, cached.format, std::max(cached.width >> mip, 1u), std::max(cached.height >> mip, 1u), initData));
+        }
+        else
+        {
+            // the cache is gone, cooking again rewrites it
+            upload(device, prepareChain(m_filePath, m_compression));
+            if (mip > 0)
+            {
+                setTexture(device, copyMipTail(device, deviceContext, m_texture.Get(), mip));
+            }
+        }
     }
-    hr = textureResource.As(&m_texture);
+    m_residentMip = mip;
+    forgetBindings();
+}
+
+void ImageTexture::loadStreamed(ID3D11Device *device)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+    TextureCache::CachedTexture cached;
+    if (!m_streamImage.pixels.empty())
+    {
+        // the tail came from a quick downsample, the real chain is cooked now
+        CookedTexture cooked = cook(m_filePath, m_streamImage, m_compression);
+        m_streamImage = {};
+        std::vector<D3D11_SUBRESOURCE_DATA> initData(cooked.levels.size());
+        for (size_t i = 0; i < cooked.levels.size(); ++i)
+        {
+            initData[i].pSysMem = cooked.levels[i].data();
+            initData[i].SysMemPitch = TextureCache::getRowPitch(cooked.format, std::max(cooked.width >> i, 1u));
+        }
+        texture = createTexture(device, cooked.format, cooked.width, cooked.height, initData);
+    }
+    else if (loadCached(m_filePath, m_compression, cached))
+    {
+        std::vector<D3D11_SUBRESOURCE_DATA> initData(cached.levels.size());
+        for (size_t i = 0; i < cached.levels.size(); ++i)
+        {
+            initData[i].pSysMem = cached.levels[i];
+            initData[i].SysMemPitch = cached.rowPitches[i];
+        }
+        texture = createTexture(device, cached.format, cached.width, cached.height, initData);
+    }
+    else
+    {
+        throw std::runtime_error("ImageTexture::loadStreamed: " + m_filePath + " left the texture cache");
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    texture->GetDesc(&desc);
+    if (desc.Width != m_width || desc.Height != m_height || desc.MipLevels != m_mipLevels || desc.Format != m_format)
+    {
+        throw std::runtime_error("ImageTexture::loadStreamed: " + m_filePath + " changed since its tail was loaded");
+    }
+    m_streamedSrv = createView(device, texture.Get());
+    m_streamedTexture = texture;
+
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "ImageTexture::loadStreamed: {}: {}x{}, {} mip levels in {:.2f} ms", m_filePath, m_width, m_height, m_mipLevels, elapsedMs);
+}
+
+void ImageTexture::commitStreamed()
+{
+    m_texture = std::move(m_streamedTexture);
+    m_srv = std::move(m_streamedSrv);
+    m_residentMip = 0;
+    m_isStreamPending = false;
+    forgetBindings();
+    trackResidency(m_texture.Get(), true);
+}
+
+DecodedImage ImageTexture::decode(const std::string &filePath)
+{
+    // PNGs decode in engine, the rest (the JPEG planet maps) goes through WIC
+    auto startTime = std::chrono::high_resolution_clock::now();
+    MappedFile file(filePath);
+    DecodedImage image;
+    bool isPng = PngDecoder::isPng(file.data(), file.size());
+    if (isPng)
+    {
+        image = PngDecoder::decode(reinterpret_cast<const uint8_t *>(file.data()), file.size(), filePath);
+    }
+    else
+    {
+#ifdef _WIN32
+        // WIC goes through COM and prepare steps run this on pool workers, the thread simply stays in the MTA
+        thread_local HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+        (void)comResult;
+#endif
+        DirectX::ScratchImage scratchImage;
+        HRESULT hr = DirectX::LoadFromWICMemory(file.data(), file.size(), DirectX::WIC_FLAGS_NONE, nullptr, scratchImage);
+        if (FAILED(hr))
+        {
+            throw std::runtime_error("Failed to load texture from file: " + filePath);
+        }
+
+        // everything downstream works on RGBA8 (the BC encoder reads channels in that order), convert anything else first;
+        // an sRGB tagged file keeps sampling as sRGB
+        DXGI_FORMAT sourceFormat = scratchImage.GetMetadata().format;
+        image.isSrgb = sourceFormat == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || sourceFormat == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+        DXGI_FORMAT rgbaFormat = image.isSrgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+        if (sourceFormat != rgbaFormat)
+        {
+            DirectX::ScratchImage converted;
+            hr = DirectX::Convert(*scratchImage.GetImage(0, 0, 0), rgbaFormat, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted);
+            if (FAILED(hr))
+            {
+                throw std::runtime_error("Failed to convert texture to RGBA8: " + filePath);
+            }
+            scratchImage = std::move(converted);
+        }
+
+        // repacked tightly so every caller sees the PNG layout, one copy next to a JPEG decode
+        const DirectX::Image *source = scratchImage.GetImage(0, 0, 0);
+        image.width = static_cast<uint32_t>(source->width);
+        image.height = static_cast<uint32_t>(source->height);
+        size_t rowBytes = static_cast<size_t>(image.width) * 4;
+        image.pixels = StagingPool::getInstance().acquire(rowBytes * image.height);
+        for (uint32_t y = 0; y < image.height; ++y)
+        {
+            std::memcpy(image.pixels.data() + y * rowBytes, source->pixels + y * source->rowPitch, rowBytes);
+        }
+    }
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "ImageTexture::decode: {}: decoded {}x{} ({}) in {:.2f} ms ({:.1f} MP/s)",
+                filePath, image.width, image.height, isPng ? "PNG" : "WIC", elapsedMs, image.width * image.height / 1000.f / std::max(elapsedMs, 1e-3f));
+    return image;
+}
+
+bool ImageTexture::loadCached(const std::string &filePath, TextureCompression compression, TextureCache::CachedTexture &cached)
+{
+    return TextureCache::load(filePath, getOptionsKey(compression), cached);
+}
+
+void ImageTexture::cookCached(const std::string &filePath, TextureCompression compression)
+{
+    TextureCache::CachedTexture cached;
+    if (!loadCached(filePath, compression, cached))
+    {
+        cook(filePath, decode(filePath), compression);
+    }
+}
+
+ImageTexture::PreparedTexture ImageTexture::prepareChain(const std::string &filePath, TextureCompression compression)
+{
+    // cooked before: the mapped DDS levels go straight to the device
+    auto startTime = std::chrono::high_resolution_clock::now();
+    PreparedTexture prepared;
+    prepared.filePath = filePath;
+    prepared.compression = compression;
+    if (loadCached(filePath, compression, prepared.cached))
+    {
+        prepared.format = prepared.cached.format;
+        prepared.width = prepared.cached.width;
+        prepared.height = prepared.cached.height;
+        prepared.levels = prepared.cached.levels;
+        prepared.rowPitches = prepared.cached.rowPitches;
+        float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+        Logger::Log(Logger::LogLevel::INFO, "ImageTexture::prepareChain: {}: {}x{}, {} mip levels from {} in {:.2f} ms",
+                    filePath, prepared.width, prepared.height, prepared.levels.size(), TextureCache::getCachePath(filePath), elapsedMs);
+    }
+    else
+    {
+        CookedTexture cooked = cook(filePath, decode(filePath), compression);
+        prepared.format = cooked.format;
+        prepared.width = cooked.width;
+        prepared.height = cooked.height;
+        prepared.ownedLevels = std::move(cooked.levels);
+        for (size_t i = 0; i < prepared.ownedLevels.size(); ++i)
+        {
+            prepared.levels.push_back(prepared.ownedLevels[i].data());
+            prepared.rowPitches.push_back(TextureCache::getRowPitch(prepared.format, std::max(prepared.width >> i, 1u)));
+        }
+    }
+    prepared.mipLevels = static_cast<uint32_t>(prepared.levels.size());
+    return prepared;
+}
+
+ImageTexture::PreparedTexture ImageTexture::prepareTail(const std::string &filePath, TextureCompression compression)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    PreparedTexture prepared;
+    prepared.filePath = filePath;
+    prepared.compression = compression;
+    if (loadCached(filePath, compression, prepared.cached))
+    {
+        // cooked before: the tail is the coarse end of the cached chain
+        prepared.format = prepared.cached.format;
+        prepared.width = prepared.cached.width;
+        prepared.height = prepared.cached.height;
+        prepared.mipLevels = static_cast<uint32_t>(prepared.cached.levels.size());
+        prepared.residentMip = getTailMip(prepared.format, prepared.width, prepared.height, prepared.mipLevels);
+        prepared.levels.assign(prepared.cached.levels.begin() + prepared.residentMip, prepared.cached.levels.end());
+        prepared.rowPitches.assign(prepared.cached.rowPitches.begin() + prepared.residentMip, prepared.cached.rowPitches.end());
+    }
+    else
+    {
+        // a box filtered chain encoded like the cooked one will be, so the full chain swaps in without a format
+        // change; the decode is kept for loadStreamed to cook
+        prepared.streamImage = decode(filePath);
+        const DecodedImage &image = prepared.streamImage;
+        BlockFormat blockFormat = BlockFormat::BC7;
+        bool isBlockCompressed = selectBlockFormat(image, compression, blockFormat);
+        prepared.width = image.width;
+        prepared.height = image.height;
+        prepared.mipLevels = MipGenerator::getLevelCount(image.width, image.height);
+        prepared.format = getCookedFormat(isBlockCompressed, blockFormat, image.isSrgb);
+        prepared.residentMip = getTailMip(prepared.format, prepared.width, prepared.height, prepared.mipLevels);
+
+        std::vector<MipLevel> levels = MipGenerator::generate(image.pixels.data(), image.width, image.height,
+                                                              static_cast<size_t>(image.width) * 4, true, MipFilter::Box);
+        for (uint32_t mip = prepared.residentMip; mip < prepared.mipLevels; ++mip)
+        {
+            const MipLevel &level = levels[mip];
+            prepared.ownedLevels.push_back(isBlockCompressed ? BlockCompressor::compress(blockFormat, level.pixels.data(), level.width, level.height)
+                                                             : level.pixels);
+            prepared.levels.push_back(prepared.ownedLevels.back().data());
+            prepared.rowPitches.push_back(TextureCache::getRowPitch(prepared.format, level.width));
+        }
+    }
+
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "ImageTexture::prepareTail: {}: {}x{} tail from mip {} ({}) in {:.2f} ms",
+                filePath, std::max(prepared.width >> prepared.residentMip, 1u), std::max(prepared.height >> prepared.residentMip, 1u),
+                prepared.residentMip, prepared.cached.levels.empty() ? "downsampled" : "cached", elapsedMs);
+    return prepared;
+}
+
+void ImageTexture::upload(ID3D11Device *device, PreparedTexture &&prepared)
+{
+    std::vector<D3D11_SUBRESOURCE_DATA> initData(prepared.levels.size());
+    for (size_t i = 0; i < initData.size(); ++i)
+    {
+        initData[i].pSysMem = prepared.levels[i];
+        initData[i].SysMemPitch = prepared.rowPitches[i];
+    }
+    uint32_t mip = prepared.residentMip;
+    setTexture(device, createTexture(device, prepared.format, std::max(prepared.width >> mip, 1u), std::max(prepared.height >> mip, 1u), initData));
+    m_width = prepared.width;
+    m_height = prepared.height;
+    m_mipLevels = prepared.mipLevels;
+    m_format = prepared.format;
+    m_residentMip = mip;
+    m_streamImage = std::move(prepared.streamImage);
+    // a tail that is the whole chain still streams when it was only box filtered
+    m_isStreamPending = mip > 0 || !m_streamImage.pixels.empty();
+}
+
+bool ImageTexture::selectBlockFormat(const DecodedImage &image, TextureCompression compression, BlockFormat &blockFormat)
+{
+    // D3D wants block compressed top levels in whole blocks
+    if (compression == TextureCompression::None || image.width % 4 != 0 || image.height % 4 != 0)
+    {
+        return false;
+    }
+
+    blockFormat = BlockFormat::BC7;
+    if (compression == TextureCompression::Auto)
+    {
+        const uint8_t *pixels = image.pixels.data();
+        size_t size = static_cast<size_t>(image.width) * image.height * 4;
+        bool isOpaque = true;
+        for (size_t i = 3; i < size && isOpaque; i += 4)
+        {
+            isOpaque = pixels[i] == 255;
+        }
+        blockFormat = isOpaque ? BlockFormat::BC1 : BlockFormat::BC7;
+    }
+    else if (compression == TextureCompression::BC1 || compression == TextureCompression::BC3)
+    {
+        blockFormat = compression == TextureCompression::BC1 ? BlockFormat::BC1 : BlockFormat::BC3;
+    }
+    return true;
+}
+
+DXGI_FORMAT ImageTexture::getCookedFormat(bool isBlockCompressed, BlockFormat blockFormat, bool isSrgb)
+{
+    if (!isBlockCompressed)
+    {
+        return isSrgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+    static const DXGI_FORMAT FORMATS[][2] = {{DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC1_UNORM_SRGB},
+                                             {DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC3_UNORM_SRGB},
+                                             {DXGI_FORMAT_BC7_UNORM, DXGI_FORMAT_BC7_UNORM_SRGB}};
+    return FORMATS[static_cast<int>(blockFormat)][isSrgb ? 1 : 0];
+}
+
+ImageTexture::CookedTexture ImageTexture::cook(const std::string &filePath, const DecodedImage &image, TextureCompression compression)
+{
+    CookedTexture cooked;
+    cooked.width = image.width;
+    cooked.height = image.height;
+    size_t rowPitch = static_cast<size_t>(image.width) * 4;
+
+    // albedo images are sRGB encoded whatever the format says, so the chain is filtered in linear light
+    auto startTime = std::chrono::high_resolution_clock::now();
+    std::vector<MipLevel> levels = MipGenerator::generate(image.pixels.data(), image.width, image.height, rowPitch, true, MIP_FILTER);
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "ImageTexture::cook: {}: {}x{}, {} mip levels in {:.2f} ms ({:.1f} MP/s)",
+                filePath, image.width, image.height, levels.size(), elapsedMs, image.width * image.height / 1000.f / std::max(elapsedMs, 1e-3f));
+
+    BlockFormat blockFormat = BlockFormat::BC7;
+    bool isBlockCompressed = selectBlockFormat(image, compression, blockFormat);
+    if (compression != TextureCompression::None && !isBlockCompressed)
+    {
+        Logger::Log(Logger::LogLevel::WARNING, "ImageTexture::cook: {}: {}x{} is not a multiple of 4, kept as RGBA8", filePath, image.width, image.height);
+    }
+    cooked.format = getCookedFormat(isBlockCompressed, blockFormat, image.isSrgb);
+
+    cooked.levels.resize(levels.size());
+    if (!isBlockCompressed)
+    {
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            cooked.levels[i] = std::move(levels[i].pixels);
+        }
+    }
+    else
+    {
+        startTime = std::chrono::high_resolution_clock::now();
+        size_t texelCount = 0;
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            cooked.levels[i] = BlockCompressor::compress(blockFormat, levels[i].pixels.data(), levels[i].width, levels[i].height);
+            texelCount += static_cast<size_t>(levels[i].width) * levels[i].height;
+        }
+        elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+        std::vector<uint8_t> decoded = BlockCompressor::decompress(blockFormat, cooked.levels[0].data(), image.width, image.height);
+        double psnr = BlockCompressor::computePsnr(levels[0].pixels.data(), decoded.data(), static_cast<size_t>(image.width) * image.height, blockFormat != BlockFormat::BC1);
+        static const char *FORMAT_NAMES[] = {"BC1", "BC3", "BC7"};
+        Logger::Log(Logger::LogLevel::INFO, "ImageTexture::cook: {}: {} encode in {:.2f} ms ({:.1f} MP/s), PSNR {:.2f} dB",
+                    filePath, FORMAT_NAMES[static_cast<int>(blockFormat)], elapsedMs, texelCount / 1000.f / std::max(elapsedMs, 1e-3f), psnr);
+    }
+
+    TextureCache::save(filePath, getOptionsKey(compression), cooked.format, cooked.width, cooked.height, cooked.levels);
+    return cooked;
+}
+
+Microsoft::WRL::ComPtr<ID3D11Texture2D> ImageTexture::createTexture(ID3D11Device *device, DXGI_FORMAT format, UINT width, UINT height,
+                                                                    const std::vector<D3D11_SUBRESOURCE_DATA> &levels)
+{
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = width;
+    desc.Height = height;
+    desc.MipLevels = static_cast<UINT>(levels.size());
+    desc.ArraySize = 1;
+    desc.Format = format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+    HRESULT hr = device->CreateTexture2D(&desc, levels.data(), texture.GetAddressOf());
     if (FAILED(hr))
     {
-        throw std::runtime_error("Failed to convert ID3D11Resource to ID3D11Texture2D.");
+        throw std::runtime_error("Failed to create texture from image data.");
     }
+    return texture;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ImageTexture::createView(ID3D11Device *device, ID3D11Texture2D *texture)
+{
+    D3D11_TEXTURE2D_DESC desc = {};
+    texture->GetDesc(&desc);
 
     D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-    srvDesc.Format = scratchImage.GetMetadata().format;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-    srvDesc.Texture2D.MipLevels = 1;
-    srvDesc.Texture2D.MostDetailedMip = 0;
-
-    hr = device->CreateShaderResourceView(
-        m_texture.Get(),
-        &srvDesc,
-        &m_srv);
+    srvDesc.Format = desc.Format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    srvDesc.Texture2DArray.MipLevels = desc.MipLevels;
+    srvDesc.Texture2DArray.MostDetailedMip = 0;
+    srvDesc.Texture2DArray.ArraySize = 1;
+
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+    HRESULT hr = device->CreateShaderResourceView(texture, &srvDesc, srv.GetAddressOf());
     if (FAILED(hr))
     {
         throw std::runtime_error("Failed to create shader resource view.");
     }
+    return srv;
+}
+
+void ImageTexture::setTexture(ID3D11Device *device, const Microsoft::WRL::ComPtr<ID3D11Texture2D> &texture)
+{
+    m_srv = createView(device, texture.Get());
+    m_texture = texture;
 }
@@ -0,0 +1,360 @@
+#include "resources/texture_array.h"
+#include "resources/texture_streamer.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+
+TextureArray::TextureArray(ID3D11Device *device, const std::vector<ID3D11Texture2D *> &slices, const std::vector<std::string> &sourcePaths,
+                           TextureCompression compression, uint32_t residentMip)
+    : m_sourcePaths(sourcePaths), m_compression(compression)
+{
+    if (slices.empty())
+    {
+        throw std::runtime_error("TextureArray::TextureArray: no slices");
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    slices[0]->GetDesc(&desc);
+    desc.ArraySize = static_cast<UINT>(slices.size());
+    desc.Usage = D3D11_USAGE_DEFAULT; // copy destination
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = 0;
+    desc.MiscFlags = 0;
+
+    HRESULT hr = device->CreateTexture2D(&desc, nullptr, m_texture.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create texture array.");
+    }
+
+    // GPU side copies, the slices never come back to the CPU; the immediate context belongs to the calling thread
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext;
+    device->GetImmediateContext(deviceContext.GetAddressOf());
+    for (UINT slice = 0; slice < desc.ArraySize; ++slice)
+    {
+        D3D11_TEXTURE2D_DESC sliceDesc = {};
+        slices[slice]->GetDesc(&sliceDesc);
+        if (sliceDesc.Width != desc.Width || sliceDesc.Height != desc.Height || sliceDesc.MipLevels != desc.MipLevels || sliceDesc.Format != desc.Format)
+        {
+            throw std::runtime_error("TextureArray::TextureArray: slices differ in size, format or mip count");
+        }
+        for (UINT level = 0; level < desc.MipLevels; ++level)
+        {
+            deviceContext->CopySubresourceRegion(m_texture.Get(), D3D11CalcSubresource(level, slice, desc.MipLevels), 0, 0, 0,
+                                                 slices[slice], D3D11CalcSubresource(level, 0, desc.MipLevels), nullptr);
+        }
+    }
+
+    m_srv = createView(device, m_texture.Get());
+    m_sliceCount = desc.ArraySize;
+    createSampler(device);
+    m_residentMip = residentMip;
+    if (residentMip == 0)
+    {
+        trackResidency(m_texture.Get(), m_sourcePaths.size() == slices.size());
+    }
+}
+
+TextureArray::TextureArray(ID3D11Device *device, DXGI_FORMAT format, const std::vector<std::vector<MipLevel>> &slices)
+{
+    if (slices.empty() || slices[0].empty())
+    {
+        throw std::runtime_error("TextureArray::TextureArray: no slices");
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = slices[0][0].width;
+    desc.Height = slices[0][0].height;
+    desc.MipLevels = static_cast<UINT>(slices[0].size());
+    desc.ArraySize = static_cast<UINT>(slices.size());
+    desc.Format = format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    // subresources go slice by slice, each with its whole chain
+    std::vector<D3D11_SUBRESOURCE_DATA> initData;
+    initData.reserve(static_cast<size_t>(desc.ArraySize) * desc.MipLevels);
+    for (const std::vector<MipLevel> &levels : slices)
+    {
+        if (levels.size() != desc.MipLevels || levels[0].width != desc.Width || levels[0].height != desc.Height)
+        {
+            throw std::runtime_error("TextureArray::TextureArray: slices differ in size or mip count");
+        }
+        for (const MipLevel &level : levels)
+        {
+            D3D11_SUBRESOURCE_DATA data = {};
+            data.pSysMem = level.pixels.data();
+            data.SysMemPitch = level.width * 4;
+            initData.push_back(data);
+        }
+    }
+
+    HRESULT hr = device->CreateTexture2D(&desc, initData.data(), m_texture.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create texture array.");
+    }
+
+    m_srv = createView(device, m_texture.Get());
+    m_sliceCount = desc.ArraySize;
+    createSampler(device);
+    trackResidency(m_texture.Get(), false);
+}
+
+std::vector<TextureRef> TextureArray::loadPacked(ID3D11Device *device, const std::vector<std::string> &filePaths,
+                                                 const TexturePackOptions &options, TextureCompression compression, TextureLoading loading)
+{
+    return createPacked(device, preparePacked(filePaths, options, compression, loading));
+}
+
+TextureArray::PreparedPack TextureArray::preparePacked(const std::vector<std::string> &filePaths, const TexturePackOptions &options,
+                                                       TextureCompression compression, TextureLoading loading)
+{
+    PreparedPack prepared;
+    prepared.compression = compression;
+    prepared.textures = ImageTexture::prepareAll(filePaths, compression, loading);
+
+    // laid out by the full chains, progressive textures may still be tails
+    auto startTime = std::chrono::high_resolution_clock::now();
+    std::vector<TexturePackItem> items(prepared.textures.size());
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        const ImageTexture::PreparedTexture &texture = prepared.textures[i];
+        items[i] = {texture.width, texture.height, texture.mipLevels, texture.format};
+    }
+    prepared.layout = TexturePacker::pack(items, options);
+    const TexturePackLayout &layout = prepared.layout;
+
+    prepared.atlasPages.resize(layout.groups.size());
+    size_t pageCount = 0;
+    for (uint32_t groupIndex = 0; groupIndex < layout.groups.size(); ++groupIndex)
+    {
+        const TexturePackGroup &group = layout.groups[groupIndex];
+        if (group.kind != TexturePackGroup::Kind::Atlas)
+        {
+            continue;
+        }
+
+        // the cooked (block compressed) textures cannot be composed, the sources decode again
+        std::vector<DecodedImage> images(items.size());
+        ThreadPool::getInstance().parallelFor(group.items.size(), 1, [&](size_t begin, size_t end)
+                                              {
+            for (size_t i = begin; i < end; ++i)
+            {
+                images[group.items[i]] = ImageTexture::decode(filePaths[group.items[i]]);
+            } });
+        std::vector<const uint8_t *> itemPixels(items.size(), nullptr);
+        for (uint32_t index : group.items)
+        {
+            itemPixels[index] = images[index].pixels.data();
+        }
+
+        // box filtered: the chain stays inside each item's aligned cells, see TexturePacker
+        std::vector<std::vector<MipLevel>> &pages = prepared.atlasPages[groupIndex];
+        pages.resize(group.sliceCount);
+        for (uint32_t slice = 0; slice < group.sliceCount; ++slice)
+        {
+            std::vector<uint8_t> page = TexturePacker::composeAtlasPage(layout, groupIndex, slice, items, itemPixels);
+            pages[slice] = MipGenerator::generate(page.data(), group.width, group.height, static_cast<size_t>(group.width) * 4, true, MipFilter::Box);
+            pages[slice].resize(group.mipLevels);
+        }
+        pageCount += group.sliceCount;
+    }
+
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "TextureArray::preparePacked: {} textures laid out, {} atlas pages composed in {:.2f} ms",
+                items.size(), pageCount, elapsedMs);
+    return prepared;
+}
+
+std::vector<TextureRef> TextureArray::createPacked(ID3D11Device *device, PreparedPack &&prepared)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    const TexturePackLayout &layout = prepared.layout;
+    std::vector<std::string> filePaths;
+    for (const ImageTexture::PreparedTexture &texture : prepared.textures)
+    {
+        filePaths.push_back(texture.filePath);
+    }
+    std::vector<std::shared_ptr<ImageTexture>> textures = ImageTexture::createAll(device, std::move(prepared.textures));
+
+    std::vector<TextureRef> refs(textures.size());
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        refs[i].texture = textures[i];
+    }
+
+    size_t arrayCount = 0, pageCount = 0;
+    for (uint32_t groupIndex = 0; groupIndex < layout.groups.size(); ++groupIndex)
+    {
+        const TexturePackGroup &group = layout.groups[groupIndex];
+        std::shared_ptr<TextureArray> array;
+        if (group.kind == TexturePackGroup::Kind::Array)
+        {
+            // the slices of a group share a full chain, so progressive ones share their tail mip too
+            std::vector<ID3D11Texture2D *> slices;
+            std::vector<std::string> slicePaths;
+            bool isStreamPending = false;
+            for (uint32_t index : group.items)
+            {
+                slices.push_back(textures[index]->getTexture());
+                slicePaths.push_back(filePaths[index]);
+                isStreamPending |= textures[index]->isStreamPending();
+            }
+            uint32_t residentMip = textures[group.items[0]]->getResidentMip();
+            array = std::make_shared<TextureArray>(device, slices, slicePaths, prepared.compression, residentMip);
+            if (isStreamPending)
+            {
+                TextureStreamer::getInstance().request(array);
+            }
+            ++arrayCount;
+        }
+        else
+        {
+            array = std::make_shared<TextureArray>(device, group.format, prepared.atlasPages[groupIndex]);
+            pageCount += group.sliceCount;
+        }
+
+        for (uint32_t index : group.items)
+        {
+            const TexturePlacement &placement = layout.placements[index];
+            refs[index] = {array, placement.slice, placement.uvScaleBias, group.kind == TexturePackGroup::Kind::Atlas};
+        }
+    }
+
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    size_t standaloneCount = std::count_if(layout.placements.begin(), layout.placements.end(), [](const TexturePlacement &placement)
+                                           { return placement.group == TexturePlacement::STANDALONE; });
+    Logger::Log(Logger::LogLevel::INFO, "TextureArray::createPacked: {} textures into {} arrays, {} atlas pages, {} standalone in {:.2f} ms",
+                textures.size(), arrayCount, pageCount, standaloneCount, elapsedMs);
+    return refs;
+}
+
+void TextureArray::bind(ID3D11DeviceContext *deviceContext, UINT slot) const
+{
+    markUsed();
+    if (isBound(slot))
+    {
+        return;
+    }
+    deviceContext->PSSetShaderResources(slot, 1, m_srv.GetAddressOf());
+    deviceContext->PSSetSamplers(slot, 1, m_sampler.GetAddressOf());
+    setBound(slot);
+}
+
+void TextureArray::setResidentMip(ID3D11Device *device, ID3D11DeviceContext *deviceContext, uint32_t mip)
+{
+    if (mip == m_residentMip)
+    {
+        return;
+    }
+
+    if (mip > m_residentMip)
+    {
+        m_texture = copyMipTail(device, deviceContext, m_texture.Get(), mip - m_residentMip);
+    }
+    else
+    {
+        m_texture = createFromCache(device, mip);
+    }
+
+    m_srv = createView(device, m_texture.Get());
+    m_residentMip = mip;
+    forgetBindings();
+}
+
+void TextureArray::loadStreamed(ID3D11Device *device)
+{
+    // slices whose tail was only downsampled are cooked first
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (const std::string &sourcePath : m_sourcePaths)
+    {
+        ImageTexture::cookCached(sourcePath, m_compression);
+    }
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> texture = createFromCache(device, 0);
+    m_streamedSrv = createView(device, texture.Get());
+    m_streamedTexture = texture;
+
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "TextureArray::loadStreamed: {} slices in {:.2f} ms", m_sourcePaths.size(), elapsedMs);
+}
+
+void TextureArray::commitStreamed()
+{
+    m_texture = std::move(m_streamedTexture);
+    m_srv = std::move(m_streamedSrv);
+    m_residentMip = 0;
+    forgetBindings();
+    trackResidency(m_texture.Get(), true);
+}
+
+Microsoft::WRL::ComPtr<ID3D11Texture2D> TextureArray::createFromCache(ID3D11Device *device, uint32_t mip) const
+{
+    std::vector<TextureCache::CachedTexture> cached(m_sourcePaths.size());
+    for (size_t slice = 0; slice < cached.size(); ++slice)
+    {
+        if (!ImageTexture::loadCached(m_sourcePaths[slice], m_compression, cached[slice]))
+        {
+            throw std::runtime_error("TextureArray::createFromCache: " + m_sourcePaths[slice] + " is not in the texture cache");
+        }
+        if (cached[slice].format != cached[0].format || cached[slice].width != cached[0].width ||
+            cached[slice].height != cached[0].height || cached[slice].levels.size() != cached[0].levels.size())
+        {
+            throw std::runtime_error("TextureArray::createFromCache: " + m_sourcePaths[slice] + " changed since the array was built");
+        }
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = std::max(cached[0].width >> mip, 1u);
+    desc.Height = std::max(cached[0].height >> mip, 1u);
+    desc.MipLevels = static_cast<UINT>(cached[0].levels.size() - mip);
+    desc.ArraySize = static_cast<UINT>(cached.size());
+    desc.Format = cached[0].format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+    std::vector<D3D11_SUBRESOURCE_DATA> initData;
+    initData.reserve(static_cast<size_t>(desc.ArraySize) * desc.MipLevels);
+    for (const TextureCache::CachedTexture &slice : cached)
+    {
+        for (size_t level = mip; level < slice.levels.size(); ++level)
+        {
+            D3D11_SUBRESOURCE_DATA data = {};
+            data.pSysMem = slice.levels[level];
+            data.SysMemPitch = slice.rowPitches[level];
+            initData.push_back(data);
+        }
+    }
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+    HRESULT hr = device->CreateTexture2D(&desc, initData.data(), texture.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create texture array.");
+    }
+    return texture;
+}
+
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> TextureArray::createView(ID3D11Device *device, ID3D11Texture2D *texture)
+{
+    D3D11_TEXTURE2D_DESC desc = {};
+    texture->GetDesc(&desc);
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = desc.Format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    srvDesc.Texture2DArray.MostDetailedMip = 0;
+    srvDesc.Texture2DArray.MipLevels = desc.MipLevels;
+    srvDesc.Texture2DArray.FirstArraySlice = 0;
+    srvDesc.Texture2DArray.ArraySize = desc.ArraySize;
+
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+    HRESULT hr = device->CreateShaderResourceView(texture, &srvDesc, srv.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create shader resource view for texture array.");
+    }
+    return srv;
+}
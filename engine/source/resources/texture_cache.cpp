@@ -0,0 +1,290 @@
+#include "resources/texture_cache.h"
+#include "utils/hash.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    const std::string CACHE_DIRECTORY = "cache/texture/";
+
+    constexpr uint32_t DDS_MAGIC = 0x20534444;  // "DDS "
+    constexpr uint32_t DDS_FOURCC_DX10 = 0x30315844; // "DX10"
+    constexpr uint32_t DDSD_CAPS = 0x1, DDSD_HEIGHT = 0x2, DDSD_WIDTH = 0x4, DDSD_PITCH = 0x8;
+    constexpr uint32_t DDSD_PIXELFORMAT = 0x1000, DDSD_MIPMAPCOUNT = 0x20000, DDSD_LINEARSIZE = 0x80000;
+    constexpr uint32_t DDPF_FOURCC = 0x4;
+    constexpr uint32_t DDSCAPS_COMPLEX = 0x8, DDSCAPS_TEXTURE = 0x1000, DDSCAPS_MIPMAP = 0x400000;
+    constexpr uint32_t DDSCAPS2_CUBEMAP_ALLFACES = 0xFE00; // CUBEMAP and the six face bits
+    constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+    constexpr uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+    struct DdsPixelFormat
+    {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t fourCC;
+        uint32_t rgbBitCount;
+        uint32_t bitMasks[4];
+    };
+
+    struct DdsHeader
+    {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t height;
+        uint32_t width;
+        uint32_t pitchOrLinearSize;
+        uint32_t depth;
+        uint32_t mipMapCount;
+        uint32_t reserved1[11]; // source stamp
+        DdsPixelFormat pixelFormat;
+        uint32_t caps[4];
+        uint32_t reserved2;
+    };
+
+    struct DdsHeaderDx10
+    {
+        uint32_t dxgiFormat;
+        uint32_t resourceDimension;
+        uint32_t miscFlag;
+        uint32_t arraySize;
+        uint32_t miscFlags2;
+    };
+
+    struct File
+    {
+        uint32_t magic;
+        DdsHeader header;
+        DdsHeaderDx10 dx10;
+    };
+    static_assert(sizeof(DdsHeader) == 124 && sizeof(File) == 148, "DDS header layout");
+
+    // size + mtime is the fast path, the content hash is the fallback
+    struct SourceStamp
+    {
+        uint32_t tag;
+        uint32_t version;
+        uint64_t optionsKey;
+        uint64_t size;
+        int64_t writeTime;
+        uint64_t hash;
+    };
+    static_assert(sizeof(SourceStamp) <= sizeof(DdsHeader::reserved1), "stamp must fit the reserved words");
+
+    bool getSourceStamp(const std::string &sourcePath, SourceStamp &stamp)
+    {
+        std::error_code ec;
+        stamp.size = static_cast<uint64_t>(std::filesystem::file_size(sourcePath, ec));
+        if (ec)
+        {
+            return false;
+        }
+        stamp.writeTime = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, ec).time_since_epoch().count());
+        return !ec;
+    }
+
+    uint64_t hashSource(const std::string &sourcePath)
+    {
+        MappedFile source(sourcePath);
+        return hashBytes(source.data(), source.size());
+    }
+
+    bool isBc1(DXGI_FORMAT format)
+    {
+        return format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC1_UNORM_SRGB;
+    }
+}
+
+bool TextureCache::isBlockCompressed(DXGI_FORMAT format)
+{
+    return format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC1_UNORM_SRGB || format == DXGI_FORMAT_BC3_UNORM ||
+           format == DXGI_FORMAT_BC3_UNORM_SRGB || format == DXGI_FORMAT_BC7_UNORM || format == DXGI_FORMAT_BC7_UNORM_SRGB;
+}
+
+uint32_t TextureCache::getRowPitch(DXGI_FORMAT format, uint32_t width)
+{
+    if (!isBlockCompressed(format))
+    {
+        return width * 4;
+    }
+    return std::max((width + 3) / 4, 1u) * (isBc1(format) ? 8 : 16);
+}
+
+size_t TextureCache::getLevelSize(DXGI_FORMAT format, uint32_t width, uint32_t height)
+{
+    size_t rows = isBlockCompressed(format) ? std::max((height + 3) / 4, 1u) : height;
+    return rows * getRowPitch(format, width);
+}
+
+std::string TextureCache::getCachePath(const std::string &sourcePath, bool isCube)
+{
+    std::string name = sourcePath;
+    for (char &c : name)
+    {
+        if (c == '/' || c == '\\' || c == ':')
+        {
+            c = '_';
+        }
+    }
+    return CACHE_DIRECTORY + name + (isCube ? ".cube.dds" : ".dds");
+}
+
+bool TextureCache::load(const std::string &sourcePath, uint64_t optionsKey, CachedTexture &cached, bool isCube)
+{
+    std::string cachePath = getCachePath(sourcePath, isCube);
+    std::error_code ec;
+    if (!std::filesystem::exists(cachePath, ec))
+    {
+        return false;
+    }
+
+    std::unique_ptr<MappedFile> file;
+    try
+    {
+        file = std::make_unique<MappedFile>(cachePath);
+    }
+    catch (const std::exception &e)
+    {
+        Logger::Log(Logger::LogLevel::WARNING, "TextureCache::load: {}", e.what());
+        return false;
+    }
+
+    if (file->size() < sizeof(File))
+    {
+        Logger::Log(Logger::LogLevel::WARNING, "TextureCache::load: {} is truncated, rebuilding", cachePath);
+        return false;
+    }
+
+    File dds;
+    std::memcpy(&dds, file->data(), sizeof(File));
+    SourceStamp cachedStamp;
+    std::memcpy(&cachedStamp, dds.header.reserved1, sizeof(SourceStamp));
+    DXGI_FORMAT format = static_cast<DXGI_FORMAT>(dds.dx10.dxgiFormat);
+    if (dds.magic != DDS_MAGIC || dds.header.pixelFormat.fourCC != DDS_FOURCC_DX10 || cachedStamp.tag != TAG ||
+        cachedStamp.version != VERSION || cachedStamp.optionsKey != optionsKey ||
+        (format != DXGI_FORMAT_R8G8B8A8_UNORM && format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB && !isBlockCompressed(format)) || dds.header.mipMapCount == 0 ||
+        dds.dx10.arraySize != 1 || ((dds.dx10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE) != 0) != isCube)
+    {
+        Logger::Log(Logger::LogLevel::INFO, "TextureCache::load: {} was cooked with another version or options, rebuilding", cachePath);
+        return false;
+    }
+
+    SourceStamp stamp;
+    if (getSourceStamp(sourcePath, stamp))
+    {
+        if (stamp.size != cachedStamp.size)
+        {
+            Logger::Log(Logger::LogLevel::INFO, "TextureCache::load: {} changed size, rebuilding", sourcePath);
+            return false;
+        }
+        if (stamp.writeTime != cachedStamp.writeTime && hashSource(sourcePath) != cachedStamp.hash)
+        {
+            Logger::Log(Logger::LogLevel::INFO, "TextureCache::load: {} changed content, rebuilding", sourcePath);
+            return false;
+        }
+    }
+
+    // levels follow the headers back to back, largest first, one chain per face
+    cached.levels.clear();
+    cached.rowPitches.clear();
+    size_t offset = sizeof(File);
+    uint32_t faceCount = isCube ? CUBE_FACE_COUNT : 1;
+    for (uint32_t face = 0; face < faceCount; ++face)
+    {
+        uint32_t width = dds.header.width, height = dds.header.height;
+        for (uint32_t level = 0; level < dds.header.mipMapCount; ++level)
+        {
+            size_t levelSize = getLevelSize(format, width, height);
+            if (offset + levelSize > file->size())
+            {
+                Logger::Log(Logger::LogLevel::WARNING, "TextureCache::load: {} is truncated, rebuilding", cachePath);
+                return false;
+            }
+            cached.levels.push_back(reinterpret_cast<const uint8_t *>(file->data() + offset));
+            cached.rowPitches.push_back(getRowPitch(format, width));
+            offset += levelSize;
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+    }
+
+    cached.format = format;
+    cached.width = dds.header.width;
+    cached.height = dds.header.height;
+    cached.mipLevels = dds.header.mipMapCount;
+    cached.file = std::move(file);
+    return true;
+}
+
+void TextureCache::save(const std::string &sourcePath, uint64_t optionsKey, DXGI_FORMAT format, uint32_t width, uint32_t height,
+                        const std::vector<std::vector<uint8_t>> &levels, bool isCube)
+{
+    std::string cachePath = getCachePath(sourcePath, isCube);
+    std::string tempPath = cachePath + ".tmp";
+
+    try
+    {
+        SourceStamp stamp = {};
+        if (!getSourceStamp(sourcePath, stamp))
+        {
+            return;
+        }
+        stamp.tag = TAG;
+        stamp.version = VERSION;
+        stamp.optionsKey = optionsKey;
+        stamp.hash = hashSource(sourcePath);
+
+        File dds = {};
+        dds.magic = DDS_MAGIC;
+        dds.header.size = sizeof(DdsHeader);
+        dds.header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT |
+                           (isBlockCompressed(format) ? DDSD_LINEARSIZE : DDSD_PITCH);
+        dds.header.height = height;
+        dds.header.width = width;
+        dds.header.pitchOrLinearSize = static_cast<uint32_t>(isBlockCompressed(format) ? getLevelSize(format, width, height) : getRowPitch(format, width));
+        uint32_t mipLevels = static_cast<uint32_t>(levels.size() / (isCube ? CUBE_FACE_COUNT : 1));
+        if (mipLevels == 0 || levels.size() != mipLevels * (isCube ? CUBE_FACE_COUNT : 1))
+        {
+            throw std::runtime_error("TextureCache::save: " + std::to_string(levels.size()) + " levels are not whole mip chains");
+        }
+        dds.header.mipMapCount = mipLevels;
+        std::memcpy(dds.header.reserved1, &stamp, sizeof(SourceStamp));
+        dds.header.pixelFormat.size = sizeof(DdsPixelFormat);
+        dds.header.pixelFormat.flags = DDPF_FOURCC;
+        dds.header.pixelFormat.fourCC = DDS_FOURCC_DX10;
+        dds.header.caps[0] = DDSCAPS_TEXTURE | (mipLevels > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0) | (isCube ? DDSCAPS_COMPLEX : 0);
+        dds.header.caps[1] = isCube ? DDSCAPS2_CUBEMAP_ALLFACES : 0;
+        dds.dx10.dxgiFormat = static_cast<uint32_t>(format);
+        dds.dx10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+        dds.dx10.miscFlag = isCube ? DDS_RESOURCE_MISC_TEXTURECUBE : 0;
+        dds.dx10.arraySize = 1; // cubes, not faces
+
+        std::filesystem::create_directories(CACHE_DIRECTORY);
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out)
+            {
+                throw std::runtime_error("TextureCache::save: Failed to open " + tempPath);
+            }
+            out.write(reinterpret_cast<const char *>(&dds), sizeof(File));
+            for (const std::vector<uint8_t> &level : levels)
+            {
+                out.write(reinterpret_cast<const char *>(level.data()), static_cast<std::streamsize>(level.size()));
+            }
+            if (!out)
+            {
+                throw std::runtime_error("TextureCache::save: Failed to write " + tempPath);
+            }
+        }
+
+        // replace atomically so a crash never leaves a half-written file behind
+        std::filesystem::rename(tempPath, cachePath);
+    }
+    catch (const std::exception &e)
+    {
+        Logger::Log(Logger::LogLevel::WARNING, "TextureCache::save: {}: {}", cachePath, e.what());
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+    }
+}
@@ -0,0 +1,275 @@
+#include "resources/texture_packer.h"
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <tuple>
+
+namespace
+{
+    uint32_t alignUp(uint32_t value, uint32_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Bottom-left skyline over one page, in cells
+    class Skyline
+    {
+    public:
+        explicit Skyline(uint32_t size)
+            : m_size(size), m_segments{{0, 0, size}}
+        {
+        }
+
+        bool insert(uint32_t width, uint32_t height, uint32_t &outX, uint32_t &outY)
+        {
+            uint32_t bestY = UINT32_MAX, bestX = UINT32_MAX;
+            for (size_t i = 0; i < m_segments.size(); ++i)
+            {
+                uint32_t x = m_segments[i].x;
+                if (x + width > m_size)
+                {
+                    break;
+                }
+                uint32_t y = 0;
+                for (size_t j = i; j < m_segments.size() && m_segments[j].x < x + width; ++j)
+                {
+                    y = std::max(y, m_segments[j].y);
+                }
+                if (y + height <= m_size && (y < bestY || (y == bestY && x < bestX)))
+                {
+                    bestY = y;
+                    bestX = x;
+                }
+            }
+            if (bestY == UINT32_MAX)
+            {
+                return false;
+            }
+
+            // the new top replaces whatever it covers, a partly covered segment keeps its right part
+            std::vector<Segment> segments;
+            segments.reserve(m_segments.size() + 2);
+            for (const Segment &segment : m_segments)
+            {
+                uint32_t end = segment.x + segment.width;
+                if (end <= bestX || segment.x >= bestX + width)
+                {
+                    segments.push_back(segment);
+                    continue;
+                }
+                if (segment.x < bestX)
+                {
+                    segments.push_back({segment.x, segment.y, bestX - segment.x});
+                }
+                if (end > bestX + width)
+                {
+                    segments.push_back({bestX + width, segment.y, end - bestX - width});
+                }
+            }
+            auto it = std::lower_bound(segments.begin(), segments.end(), bestX, [](const Segment &segment, uint32_t x)
+                                       { return segment.x < x; });
+            segments.insert(it, {bestX, bestY + height, width});
+
+            m_segments.clear();
+            for (const Segment &segment : segments)
+            {
+                if (!m_segments.empty() && m_segments.back().y == segment.y)
+                {
+                    m_segments.back().width += segment.width;
+                }
+                else
+                {
+                    m_segments.push_back(segment);
+                }
+            }
+
+            outX = bestX;
+            outY = bestY;
+            return true;
+        }
+
+    private:
+        struct Segment
+        {
+            uint32_t x;
+            uint32_t y;
+            uint32_t width;
+        };
+
+        uint32_t m_size;
+        std::vector<Segment> m_segments;
+    };
+}
+
+bool TexturePacker::isSrgbFormat(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:
+        return true;
+    default:
+        return false;
+    }
+}
+
+TexturePackLayout TexturePacker::pack(const std::vector<TexturePackItem> &items, const TexturePackOptions &options)
+{
+    TexturePackLayout layout;
+    layout.placements.resize(items.size());
+
+    // width, height, mip levels, format; groups keep the order of their first item
+    using ArrayKey = std::tuple<uint32_t, uint32_t, uint32_t, DXGI_FORMAT>;
+    std::map<ArrayKey, size_t> keyIndices;
+    std::vector<std::vector<uint32_t>> candidates;
+    for (uint32_t i = 0; i < items.size(); ++i)
+    {
+        const TexturePackItem &item = items[i];
+        auto [it, isNew] = keyIndices.try_emplace({item.width, item.height, item.mipLevels, item.format}, candidates.size());
+        if (isNew)
+        {
+            candidates.emplace_back();
+        }
+        candidates[it->second].push_back(i);
+    }
+
+    std::vector<uint32_t> leftovers;
+    for (const std::vector<uint32_t> &members : candidates)
+    {
+        if (members.size() < std::max(options.minArraySize, 2u))
+        {
+            leftovers.insert(leftovers.end(), members.begin(), members.end());
+            continue;
+        }
+
+        const TexturePackItem &first = items[members[0]];
+        uint32_t groupIndex = static_cast<uint32_t>(layout.groups.size());
+        layout.groups.push_back({TexturePackGroup::Kind::Array, first.width, first.height, first.mipLevels,
+                                 static_cast<uint32_t>(members.size()), 0, first.format, members});
+        for (uint32_t slice = 0; slice < members.size(); ++slice)
+        {
+            layout.placements[members[slice]].group = groupIndex;
+            layout.placements[members[slice]].slice = slice;
+        }
+    }
+
+    if (options.maxAtlasItemSize == 0 || options.atlasPageSize == 0)
+    {
+        return layout;
+    }
+
+    // mips past the page's own chain do not exist, and a cell must leave room for an item
+    uint32_t pageSize = options.atlasPageSize;
+    uint32_t pageLevels = 1;
+    while ((pageSize >> pageLevels) > 0)
+    {
+        ++pageLevels;
+    }
+    uint32_t mipLevels = std::clamp(options.atlasMipLevels, 1u, pageLevels - 1);
+    uint32_t gutter = 1u << (mipLevels - 1);
+    uint32_t pageCells = pageSize / gutter;
+
+    // linear and sRGB items sample through different views, so they get their own pages
+    std::vector<uint32_t> atlasItems[2];
+    std::sort(leftovers.begin(), leftovers.end());
+    for (uint32_t index : leftovers)
+    {
+        const TexturePackItem &item = items[index];
+        if (item.width <= options.maxAtlasItemSize && item.height <= options.maxAtlasItemSize &&
+            alignUp(item.width + 2 * gutter, gutter) <= pageSize && alignUp(item.height + 2 * gutter, gutter) <= pageSize)
+        {
+            atlasItems[isSrgbFormat(item.format) ? 1 : 0].push_back(index);
+        }
+    }
+
+    for (int srgb = 0; srgb < 2; ++srgb)
+    {
+        std::vector<uint32_t> &members = atlasItems[srgb];
+        if (members.size() < 2)
+        {
+            continue; // a page of one item only costs its mip tail
+        }
+
+        // tallest first keeps the skyline flat
+        std::stable_sort(members.begin(), members.end(), [&](uint32_t a, uint32_t b)
+                         { return std::make_pair(items[a].height, items[a].width) > std::make_pair(items[b].height, items[b].width); });
+
+        uint32_t groupIndex = static_cast<uint32_t>(layout.groups.size());
+        TexturePackGroup group = {TexturePackGroup::Kind::Atlas, pageSize, pageSize, mipLevels, 0, gutter,
+                                  srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM, {}};
+        std::vector<Skyline> pages;
+        for (uint32_t index : members)
+        {
+            const TexturePackItem &item = items[index];
+            uint32_t cellsX = alignUp(item.width + 2 * gutter, gutter) / gutter;
+            uint32_t cellsY = alignUp(item.height + 2 * gutter, gutter) / gutter;
+
+            uint32_t cellX = 0, cellY = 0, slice = 0;
+            while (slice < pages.size() && !pages[slice].insert(cellsX, cellsY, cellX, cellY))
+            {
+                ++slice;
+            }
+            if (slice == pages.size())
+            {
+                pages.emplace_back(pageCells);
+                pages.back().insert(cellsX, cellsY, cellX, cellY);
+            }
+
+            TexturePlacement &placement = layout.placements[index];
+            placement.group = groupIndex;
+            placement.slice = slice;
+            placement.x = cellX * gutter + gutter;
+            placement.y = cellY * gutter + gutter;
+            float scale = 1.f / pageSize;
+            placement.uvScaleBias = {item.width * scale, item.height * scale, placement.x * scale, placement.y * scale};
+            group.items.push_back(index);
+        }
+        group.sliceCount = static_cast<uint32_t>(pages.size());
+        layout.groups.push_back(std::move(group));
+    }
+    return layout;
+}
+
+std::vector<uint8_t> TexturePacker::composeAtlasPage(const TexturePackLayout &layout, uint32_t group, uint32_t slice,
+                                                     const std::vector<TexturePackItem> &items, const std::vector<const uint8_t *> &itemPixels)
+{
+    const TexturePackGroup &atlas = layout.groups[group];
+    std::vector<uint8_t> page(static_cast<size_t>(atlas.width) * atlas.height * 4, 0);
+    for (uint32_t index : atlas.items)
+    {
+        const TexturePlacement &placement = layout.placements[index];
+        if (placement.slice != slice)
+        {
+            continue;
+        }
+
+        const TexturePackItem &item = items[index];
+        const uint8_t *pixels = itemPixels[index];
+        uint32_t paddedWidth = alignUp(item.width + 2 * atlas.gutter, atlas.gutter);
+        uint32_t paddedHeight = alignUp(item.height + 2 * atlas.gutter, atlas.gutter);
+        uint32_t left = placement.x - atlas.gutter;
+        uint32_t top = placement.y - atlas.gutter;
+
+        // the padded row starts `gutter` texels before the item: wrap into the source row from there
+        uint32_t startX = (item.width - atlas.gutter % item.width) % item.width;
+        for (uint32_t row = 0; row < paddedHeight; ++row)
+        {
+            uint32_t sourceY = (row + item.height - atlas.gutter % item.height) % item.height;
+            const uint8_t *sourceRow = pixels + static_cast<size_t>(sourceY) * item.width * 4;
+            uint8_t *dst = page.data() + (static_cast<size_t>(top + row) * atlas.width + left) * 4;
+            for (uint32_t done = 0, sourceX = startX; done < paddedWidth;)
+            {
+                uint32_t run = std::min(paddedWidth - done, item.width - sourceX);
+                std::memcpy(dst + static_cast<size_t>(done) * 4, sourceRow + static_cast<size_t>(sourceX) * 4, static_cast<size_t>(run) * 4);
+                done += run;
+                sourceX = 0;
+            }
+        }
+    }
+    return page;
+}
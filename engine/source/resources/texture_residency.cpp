@@ -0,0 +1,98 @@
+#include "resources/texture_residency.h"
+#include "resources/texture.h"
+
+TextureResidency &TextureResidency::getInstance()
+{
+    static TextureResidency instance;
+    return instance;
+}
+
+void TextureResidency::setOptions(const TextureResidencyOptions &options)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_policy.setOptions(options);
+}
+
+uint32_t TextureResidency::track(TextureBase *texture, const std::vector<size_t> &levelBytes, uint32_t width, uint32_t height,
+                                 uint32_t maxResidentMip, size_t cpuBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint32_t id = m_policy.add(levelBytes, width, height, maxResidentMip, cpuBytes);
+    if (id >= m_textures.size())
+    {
+        m_textures.resize(id + 1, nullptr);
+    }
+    m_textures[id] = texture;
+    return id;
+}
+
+void TextureResidency::untrack(uint32_t id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_policy.remove(id);
+    m_textures[id] = nullptr;
+}
+
+size_t TextureResidency::getResidentBytes(uint32_t id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_policy.getResidentBytes(id);
+}
+
+void TextureResidency::update(ID3D11Device *device, ID3D11DeviceContext *deviceContext)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // binds of the frame that just ended, the next one stamps a new number
+    uint64_t frame = TextureBase::getFrame();
+    for (uint32_t id = 0; id < m_textures.size(); ++id)
+    {
+        if (m_textures[id])
+        {
+            m_policy.touch(id, m_textures[id]->getLastUsedFrame());
+        }
+    }
+    std::vector<TextureResidencyPolicy::Change> changes = m_policy.update(frame);
+    TextureBase::advanceFrame();
+    if (changes.empty())
+    {
+        return;
+    }
+
+    uint32_t reducedCount = 0, restoredCount = 0;
+    for (const TextureResidencyPolicy::Change &change : changes)
+    {
+        TextureBase *texture = m_textures[change.id];
+        uint32_t previousMip = texture->getResidentMip();
+        try
+        {
+            texture->setResidentMip(device, deviceContext, change.residentMip);
+            (change.residentMip > previousMip ? reducedCount : restoredCount) += 1;
+        }
+        catch (const std::exception &e)
+        {
+            Logger::Log(Logger::LogLevel::WARNING, "TextureResidency::update: {}, kept at mip {}", e.what(), previousMip);
+            m_policy.pin(change.id, previousMip);
+        }
+    }
+
+    TextureResidencyPolicy::Stats stats = m_policy.getStats();
+    Logger::Log(Logger::LogLevel::INFO, "TextureResidency::update: {} textures reduced, {} restored, {:.1f} / {:.1f} MB resident",
+                reducedCount, restoredCount, stats.residentBytes / (1024.f * 1024.f), stats.budgetBytes / (1024.f * 1024.f));
+}
+
+TextureResidencyPolicy::Stats TextureResidency::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_policy.getStats();
+}
+
+void TextureResidency::logStats() const
+{
+    TextureResidencyPolicy::Stats stats = getStats();
+    Logger::Log(Logger::LogLevel::INFO, "TextureResidency::logStats: {} textures ({} reduced), GPU {:.1f} MB of {:.1f} MB full, budget {:.1f} MB, CPU {:.1f} KB",
+                stats.textureCount, stats.reducedCount, stats.residentBytes / (1024.f * 1024.f), stats.fullBytes / (1024.f * 1024.f),
+                stats.budgetBytes / (1024.f * 1024.f), stats.cpuBytes / 1024.f);
+    Logger::Log(Logger::LogLevel::INFO, "TextureResidency::logStats: {} evictions ({:.1f} MB), {} reloads ({:.1f} MB)",
+                stats.evictions, stats.evictedBytes / (1024.f * 1024.f), stats.reloads, stats.reloadedBytes / (1024.f * 1024.f));
+}
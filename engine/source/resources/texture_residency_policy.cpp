@@ -0,0 +1,204 @@
+#include "resources/texture_residency_policy.h"
+#include <algorithm>
+
+TextureResidencyPolicy::TextureResidencyPolicy(const TextureResidencyOptions &options)
+    : m_options(options)
+{
+}
+
+uint32_t TextureResidencyPolicy::add(const std::vector<size_t> &levelBytes, uint32_t width, uint32_t height, uint32_t maxResidentMip, size_t cpuBytes)
+{
+    Entry entry;
+    entry.tailBytes.assign(levelBytes.size() + 1, 0);
+    for (size_t mip = levelBytes.size(); mip-- > 0;)
+    {
+        entry.tailBytes[mip] = entry.tailBytes[mip + 1] + levelBytes[mip];
+    }
+
+    // the levels that stay no matter what: minResidentSize and smaller, and at least the last one
+    uint32_t lastMip = levelBytes.empty() ? 0 : static_cast<uint32_t>(levelBytes.size() - 1);
+    uint32_t mip = 0;
+    while (mip < lastMip && std::max(width >> mip, height >> mip) > m_options.minResidentSize)
+    {
+        ++mip;
+    }
+    entry.maxResidentMip = std::min({maxResidentMip, mip, lastMip});
+    entry.cpuBytes = cpuBytes;
+    entry.isLive = true;
+    m_residentBytes += entry.tailBytes[0];
+
+    uint32_t id;
+    if (!m_unusedIds.empty())
+    {
+        id = m_unusedIds.back();
+        m_unusedIds.pop_back();
+        m_entries[id] = std::move(entry);
+    }
+    else
+    {
+        id = static_cast<uint32_t>(m_entries.size());
+        m_entries.push_back(std::move(entry));
+    }
+    return id;
+}
+
+void TextureResidencyPolicy::remove(uint32_t id)
+{
+    Entry &entry = m_entries[id];
+    m_residentBytes -= entry.tailBytes[entry.residentMip];
+    entry = {};
+    m_unusedIds.push_back(id);
+}
+
+void TextureResidencyPolicy::touch(uint32_t id, uint64_t frame)
+{
+    Entry &entry = m_entries[id];
+    entry.lastUsed = std::max(entry.lastUsed, frame);
+}
+
+std::vector<TextureResidencyPolicy::Change> TextureResidencyPolicy::update(uint64_t frame)
+{
+    std::vector<uint32_t> startMips(m_entries.size());
+    for (size_t id = 0; id < m_entries.size(); ++id)
+    {
+        startMips[id] = m_entries[id].residentMip;
+    }
+
+    // the budget is hard: textures in use lose levels too once nothing older is left to drop
+    while (m_residentBytes > m_options.budgetBytes && dropLeastRecent(UINT64_MAX))
+    {
+    }
+
+    // textures used in the latest frame get levels back, the most reduced first
+    std::vector<uint32_t> candidates;
+    for (uint32_t id = 0; id < m_entries.size(); ++id)
+    {
+        const Entry &entry = m_entries[id];
+        if (entry.isLive && !entry.isPinned && entry.residentMip > 0 && entry.lastUsed == frame)
+        {
+            candidates.push_back(id);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+              {
+        if (m_entries[a].residentMip != m_entries[b].residentMip)
+        {
+            return m_entries[a].residentMip > m_entries[b].residentMip;
+        }
+        return a < b; });
+
+    uint32_t reloadCount = 0;
+    for (uint32_t id : candidates)
+    {
+        if (reloadCount >= m_options.maxReloadsPerFrame)
+        {
+            break;
+        }
+        Entry &entry = m_entries[id];
+        uint64_t idleBefore = entry.lastUsed > m_options.minIdleFrames ? entry.lastUsed - m_options.minIdleFrames : 0;
+        while (entry.residentMip > 0)
+        {
+            size_t cost = getLevelBytes(entry, entry.residentMip - 1);
+            while (m_residentBytes + cost > m_options.budgetBytes && dropLeastRecent(idleBefore))
+            {
+            }
+            if (m_residentBytes + cost > m_options.budgetBytes)
+            {
+                break;
+            }
+            m_residentBytes += cost;
+            --entry.residentMip;
+        }
+        reloadCount += entry.residentMip < startMips[id] ? 1 : 0;
+    }
+
+    std::vector<Change> changes;
+    for (uint32_t id = 0; id < m_entries.size(); ++id)
+    {
+        const Entry &entry = m_entries[id];
+        uint32_t startMip = startMips[id];
+        if (!entry.isLive || entry.residentMip == startMip)
+        {
+            continue;
+        }
+        changes.push_back({id, entry.residentMip});
+        if (entry.residentMip > startMip)
+        {
+            ++m_evictions;
+            m_evictedBytes += entry.tailBytes[startMip] - entry.tailBytes[entry.residentMip];
+        }
+        else
+        {
+            ++m_reloads;
+            m_reloadedBytes += entry.tailBytes[entry.residentMip] - entry.tailBytes[startMip];
+        }
+    }
+    return changes;
+}
+
+void TextureResidencyPolicy::pin(uint32_t id, uint32_t residentMip)
+{
+    Entry &entry = m_entries[id];
+    m_residentBytes -= entry.tailBytes[entry.residentMip];
+    entry.residentMip = residentMip;
+    entry.maxResidentMip = residentMip;
+    entry.isPinned = true;
+    m_residentBytes += entry.tailBytes[entry.residentMip];
+}
+
+TextureResidencyPolicy::Stats TextureResidencyPolicy::getStats() const
+{
+    Stats stats;
+    stats.budgetBytes = m_options.budgetBytes;
+    stats.residentBytes = m_residentBytes;
+    for (const Entry &entry : m_entries)
+    {
+        if (!entry.isLive)
+        {
+            continue;
+        }
+        stats.fullBytes += entry.tailBytes[0];
+        stats.cpuBytes += entry.cpuBytes;
+        ++stats.textureCount;
+        stats.reducedCount += entry.residentMip > 0 ? 1 : 0;
+    }
+    stats.evictions = m_evictions;
+    stats.reloads = m_reloads;
+    stats.evictedBytes = m_evictedBytes;
+    stats.reloadedBytes = m_reloadedBytes;
+    return stats;
+}
+
+bool TextureResidencyPolicy::dropLeastRecent(uint64_t usedBefore)
+{
+    // oldest first, then the one freeing the most
+    uint32_t victim = INVALID_ID;
+    for (uint32_t id = 0; id < m_entries.size(); ++id)
+    {
+        const Entry &entry = m_entries[id];
+        if (!entry.isLive || entry.residentMip >= entry.maxResidentMip || entry.lastUsed >= usedBefore)
+        {
+            continue;
+        }
+        if (victim == INVALID_ID)
+        {
+            victim = id;
+            continue;
+        }
+        const Entry &best = m_entries[victim];
+        if (entry.lastUsed < best.lastUsed ||
+            (entry.lastUsed == best.lastUsed && getLevelBytes(entry, entry.residentMip) > getLevelBytes(best, best.residentMip)))
+        {
+            victim = id;
+        }
+    }
+    if (victim == INVALID_ID)
+    {
+        return false;
+    }
+
+    Entry &entry = m_entries[victim];
+    m_residentBytes -= getLevelBytes(entry, entry.residentMip);
+    ++entry.residentMip;
+    return true;
+}
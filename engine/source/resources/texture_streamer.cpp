@@ -0,0 +1,140 @@
+#include "resources/texture_streamer.h"
+#include "resources/texture.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+    // static init runs before main, close enough to process start for the startup metrics
+    const auto STARTUP_TIME = std::chrono::steady_clock::now();
+
+    float getMsSinceStartup()
+    {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - STARTUP_TIME).count();
+    }
+}
+
+TextureStreamer &TextureStreamer::getInstance()
+{
+    static TextureStreamer instance;
+    return instance;
+}
+
+void TextureStreamer::setOptions(const TextureStreamerOptions &options)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_options = options;
+}
+
+void TextureStreamer::request(const std::shared_ptr<TextureBase> &texture)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.push_back(texture);
+    m_hasRequests = true;
+}
+
+void TextureStreamer::update(ID3D11Device *device)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_firstFrameMs < 0.f)
+    {
+        m_firstFrameMs = getMsSinceStartup();
+        Logger::Log(Logger::LogLevel::INFO, "TextureStreamer::update: first frame after {:.2f} ms, {} textures still streaming",
+                    m_firstFrameMs, m_pending.size());
+        return; // nothing is drawn yet, loads start once a frame has reported screen sizes
+    }
+
+    // finished loads swap in between frames, the draws never see a half built texture
+    for (size_t i = 0; i < m_loads.size();)
+    {
+        Load &load = m_loads[i];
+        if (load.isLoaded.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++i;
+            continue;
+        }
+        if (load.isLoaded.get())
+        {
+            load.texture->commitStreamed();
+            ++m_streamedCount;
+        }
+        else
+        {
+            ++m_failedCount;
+        }
+        m_loads.erase(m_loads.begin() + i);
+    }
+
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(), [](const std::weak_ptr<TextureBase> &texture)
+                                   { return texture.expired(); }),
+                    m_pending.end());
+    startLoads(device);
+
+    if (m_hasRequests && m_fullQualityMs < 0.f && m_pending.empty() && m_loads.empty())
+    {
+        m_fullQualityMs = getMsSinceStartup();
+        Logger::Log(Logger::LogLevel::INFO, "TextureStreamer::update: full quality after {:.2f} ms ({} textures streamed, {} failed)",
+                    m_fullQualityMs, m_streamedCount, m_failedCount);
+    }
+}
+
+void TextureStreamer::startLoads(ID3D11Device *device)
+{
+    // largest on screen first; textures not drawn yet keep their request order
+    while (m_loads.size() < m_options.maxConcurrentLoads && !m_pending.empty())
+    {
+        size_t best = 0;
+        float bestSize = -1.f;
+        for (size_t i = 0; i < m_pending.size(); ++i)
+        {
+            std::shared_ptr<TextureBase> texture = m_pending[i].lock();
+            float screenSize = texture ? texture->getScreenSize() : -1.f;
+            if (screenSize > bestSize)
+            {
+                best = i;
+                bestSize = screenSize;
+            }
+        }
+
+        std::shared_ptr<TextureBase> texture = m_pending[best].lock();
+        m_pending.erase(m_pending.begin() + best);
+        if (!texture)
+        {
+            continue;
+        }
+        std::future<bool> isLoaded = ThreadPool::getInstance().submit([texture, device]()
+                                                                      {
+            try
+            {
+                texture->loadStreamed(device);
+                return true;
+            }
+            catch (const std::exception &e)
+            {
+                Logger::Log(Logger::LogLevel::WARNING, "TextureStreamer::startLoads: {}, kept at its mip tail", e.what());
+                return false;
+            } });
+        m_loads.push_back({std::move(texture), std::move(isLoaded)});
+    }
+}
+
+TextureStreamer::Stats TextureStreamer::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats;
+    stats.pendingCount = static_cast<uint32_t>(m_pending.size());
+    stats.loadingCount = static_cast<uint32_t>(m_loads.size());
+    stats.streamedCount = m_streamedCount;
+    stats.failedCount = m_failedCount;
+    stats.firstFrameMs = m_firstFrameMs;
+    stats.fullQualityMs = m_fullQualityMs;
+    return stats;
+}
+
+void TextureStreamer::logStats() const
+{
+    Stats stats = getStats();
+    Logger::Log(Logger::LogLevel::INFO, "TextureStreamer::logStats: {} streamed, {} failed, {} loading, {} pending; first frame {:.2f} ms, full quality {:.2f} ms",
+                stats.streamedCount, stats.failedCount, stats.loadingCount, stats.pendingCount, stats.firstFrameMs, stats.fullQualityMs);
+}
@@ -0,0 +1,177 @@
+#include "resources/vertex_codec.h"
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr float MIN_EXTENT = 1e-6f;
+    constexpr float SNORM16_MAX = 32767.f;
+    constexpr float UNORM16_MAX = 65535.f;
+
+    inline int16_t encodeSnorm16(float value)
+    {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.f, 1.f) * SNORM16_MAX));
+    }
+
+    inline float decodeSnorm16(int16_t value)
+    {
+        return std::max(static_cast<float>(value) / SNORM16_MAX, -1.f); // D3D maps -32768 and -32767 to -1
+    }
+
+    inline float signNotZero(float value) { return value >= 0.f ? 1.f : -1.f; }
+}
+
+VertexCodec::Quantization VertexCodec::getQuantization(const MeshBounds &bounds)
+{
+    Quantization quantization;
+    quantization.offset = bounds.aabbMin;
+    quantization.scale.x = std::max(bounds.aabbMax.x - bounds.aabbMin.x, MIN_EXTENT);
+    quantization.scale.y = std::max(bounds.aabbMax.y - bounds.aabbMin.y, MIN_EXTENT);
+    quantization.scale.z = std::max(bounds.aabbMax.z - bounds.aabbMin.z, MIN_EXTENT);
+    return quantization;
+}
+
+uint16_t VertexCodec::encodeUnorm16(float value)
+{
+    return static_cast<uint16_t>(std::lround(std::clamp(value, 0.f, 1.f) * UNORM16_MAX));
+}
+
+float VertexCodec::decodeUnorm16(uint16_t value)
+{
+    return static_cast<float>(value) / UNORM16_MAX;
+}
+
+void VertexCodec::encodeOctahedral(const DirectX::XMFLOAT3 &normal, int16_t encoded[2])
+{
+    float l1 = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    if (l1 <= 0.f)
+    {
+        encoded[0] = 0;
+        encoded[1] = 0; // decodes to +z
+        return;
+    }
+
+    float x = normal.x / l1;
+    float y = normal.y / l1;
+    if (normal.z < 0.f) // fold the lower hemisphere over the diagonals
+    {
+        float foldedX = (1.f - std::fabs(y)) * signNotZero(x);
+        float foldedY = (1.f - std::fabs(x)) * signNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+    encoded[0] = encodeSnorm16(x);
+    encoded[1] = encodeSnorm16(y);
+}
+
+DirectX::XMFLOAT3 VertexCodec::decodeOctahedral(const int16_t encoded[2])
+{
+    // same as decodeOctahedral in vs_compact.hlsl
+    float x = decodeSnorm16(encoded[0]);
+    float y = decodeSnorm16(encoded[1]);
+    float z = 1.f - std::fabs(x) - std::fabs(y);
+    float t = std::max(-z, 0.f);
+    x += x >= 0.f ? -t : t;
+    y += y >= 0.f ? -t : t;
+
+    DirectX::XMFLOAT3 normal;
+    DirectX::XMStoreFloat3(&normal, DirectX::XMVector3Normalize(DirectX::XMVectorSet(x, y, z, 0.f)));
+    return normal;
+}
+
+CompactVertex VertexCodec::encodeCompact(const Vertex &vertex, const Quantization &quantization)
+{
+    CompactVertex encoded;
+    PositionVertex position = encodePosition(vertex.pos, quantization);
+    std::copy(position.pos, position.pos + 4, encoded.pos);
+    encodeOctahedral(vertex.n, encoded.n);
+    encoded.uv[0] = DirectX::PackedVector::XMConvertFloatToHalf(vertex.uv.x);
+    encoded.uv[1] = DirectX::PackedVector::XMConvertFloatToHalf(vertex.uv.y);
+    return encoded;
+}
+
+Vertex VertexCodec::decodeCompact(const CompactVertex &vertex, const Quantization &quantization)
+{
+    DirectX::XMFLOAT3 position = {
+        quantization.offset.x + decodeUnorm16(vertex.pos[0]) * quantization.scale.x,
+        quantization.offset.y + decodeUnorm16(vertex.pos[1]) * quantization.scale.y,
+        quantization.offset.z + decodeUnorm16(vertex.pos[2]) * quantization.scale.z};
+    DirectX::XMFLOAT2 texCoord = {
+        DirectX::PackedVector::XMConvertHalfToFloat(vertex.uv[0]),
+        DirectX::PackedVector::XMConvertHalfToFloat(vertex.uv[1])};
+    return Vertex(position, decodeOctahedral(vertex.n), texCoord);
+}
+
+PositionVertex VertexCodec::encodePosition(const DirectX::XMFLOAT3 &position, const Quantization &quantization)
+{
+    PositionVertex encoded;
+    encoded.pos[0] = encodeUnorm16((position.x - quantization.offset.x) / quantization.scale.x);
+    encoded.pos[1] = encodeUnorm16((position.y - quantization.offset.y) / quantization.scale.y);
+    encoded.pos[2] = encodeUnorm16((position.z - quantization.offset.z) / quantization.scale.z);
+    encoded.pos[3] = static_cast<uint16_t>(UNORM16_MAX); // w = 1
+    return encoded;
+}
+
+void VertexCodec::encodeCompact(const Vertex *vertices, size_t count, const Quantization &quantization, std::vector<CompactVertex> &encoded)
+{
+    encoded.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        encoded[i] = encodeCompact(vertices[i], quantization);
+    }
+}
+
+void VertexCodec::encodePositions(const Vertex *vertices, size_t count, const Quantization &quantization, std::vector<PositionVertex> &encoded)
+{
+    encoded.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        encoded[i] = encodePosition(vertices[i].pos, quantization);
+    }
+}
+
+VertexCodec::ErrorStats VertexCodec::measureError(const Vertex *vertices, const CompactVertex *encoded, size_t count, const Quantization &quantization)
+{
+    ErrorStats stats;
+    float maxNormalAngle = 0.f;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Vertex &source = vertices[i];
+        Vertex decoded = decodeCompact(encoded[i], quantization);
+
+        stats.maxPositionError = std::max({stats.maxPositionError,
+                                           std::fabs(decoded.pos.x - source.pos.x),
+                                           std::fabs(decoded.pos.y - source.pos.y),
+                                           std::fabs(decoded.pos.z - source.pos.z)});
+        stats.maxTexCoordError = std::max({stats.maxTexCoordError,
+                                           std::fabs(decoded.uv.x - source.uv.x),
+                                           std::fabs(decoded.uv.y - source.uv.y)});
+
+        DirectX::XMVECTOR sourceNormal = DirectX::XMLoadFloat3(&source.n);
+        if (DirectX::XMVectorGetX(DirectX::XMVector3LengthSq(sourceNormal)) > 0.f)
+        {
+            // atan2 of |cross| and dot, acos loses the small angles we are after
+            DirectX::XMVECTOR a = DirectX::XMVector3Normalize(sourceNormal);
+            DirectX::XMVECTOR b = DirectX::XMLoadFloat3(&decoded.n);
+            float sinAngle = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVector3Cross(a, b)));
+            float cosAngle = DirectX::XMVectorGetX(DirectX::XMVector3Dot(a, b));
+            maxNormalAngle = std::max(maxNormalAngle, std::atan2(sinAngle, cosAngle));
+        }
+    }
+    stats.maxNormalErrorDegrees = DirectX::XMConvertToDegrees(maxNormalAngle);
+    return stats;
+}
+
+VertexCodec::ErrorStats VertexCodec::getErrorBounds(const Quantization &quantization, float maxTexCoord)
+{
+    ErrorStats bounds;
+    // half a quantization step, plus float rounding of the decode
+    float maxScale = std::max({quantization.scale.x, quantization.scale.y, quantization.scale.z});
+    bounds.maxPositionError = maxScale * (0.5f / UNORM16_MAX) * 1.01f;
+    // half a snorm16 step along the diagonal, the octahedral map stretches it by at most ~2x on the sphere
+    bounds.maxNormalErrorDegrees = DirectX::XMConvertToDegrees(1.41421356f * 2.f / SNORM16_MAX);
+    // half precision keeps 11 significant bits, rounding error is half an ulp
+    bounds.maxTexCoordError = std::max(maxTexCoord, 1.f / 1024.f) / 2048.f;
+    return bounds;
+}
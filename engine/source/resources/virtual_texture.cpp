@@ -0,0 +1,325 @@
+#include "resources/virtual_texture.h"
+#include "resources/buffer_type.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+    constexpr uint32_t MAX_SLOTS_PER_ROW = std::min<uint32_t>(255, D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION / VirtualTextureFile::TILE_STRIDE);
+
+    uint32_t getSlotCount(const VirtualTextureFile &file, const VirtualTextureOptions &options)
+    {
+        size_t budgetSlots = options.cacheBytes / file.getTileBytes();
+        size_t slotCount = std::min<size_t>({budgetSlots, static_cast<size_t>(MAX_SLOTS_PER_ROW) * MAX_SLOTS_PER_ROW, file.getTileCount()});
+        return static_cast<uint32_t>(std::max<size_t>(slotCount, file.getLevels().size())); // at least one chain
+    }
+
+    std::unique_ptr<VirtualTextureFile> openOrBuild(const std::string &sourcePath)
+    {
+        if (auto file = VirtualTextureFile::openCached(sourcePath))
+        {
+            return file;
+        }
+        std::string pagePath = VirtualTextureFile::getCachePath(sourcePath);
+        DecodedImage image = ImageTexture::decode(sourcePath);
+        VirtualTextureFile::write(pagePath, image.pixels.data(), image.width, image.height, image.isSrgb, sourcePath);
+        return std::make_unique<VirtualTextureFile>(pagePath);
+    }
+}
+
+VirtualTexture::VirtualTexture(ID3D11Device *device, const std::string &sourcePath, const VirtualTextureOptions &options)
+    : m_sourcePath(sourcePath), m_options(options), m_file(openOrBuild(sourcePath)), m_cache(getSlotCount(*m_file, options)),
+      m_pageTable(m_file->getLevels())
+{
+    m_slotsPerRow = std::min(MAX_SLOTS_PER_ROW, static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(m_cache.getSlotCount())))));
+    createResources(device);
+    createSampler(device);
+
+    // the single tile of the coarsest level stays resident: every page table entry falls back to it
+    Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext;
+    device->GetImmediateContext(deviceContext.GetAddressOf());
+    const VirtualTextureFile::Level &coarsest = m_file->getLevels().back();
+    uint32_t root = VirtualTile{static_cast<uint32_t>(m_file->getLevels().size() - 1), 0, 0}.pack();
+    uint32_t evicted;
+    uint32_t slot = m_cache.allocate(root, 0, evicted);
+    m_cache.pin(slot);
+    uploadTile(deviceContext.Get(), slot, m_file->getTileData(VirtualTile::unpack(root)));
+    m_pageTable.map(root, slot % m_slotsPerRow, slot / m_slotsPerRow);
+    const std::vector<PageTable::Entry> &entries = m_pageTable.resolve();
+    deviceContext->UpdateSubresource(m_pageTableBuffer.Get(), 0, nullptr, entries.data(), 0, 0);
+    const UINT clearValue[4] = {VirtualTile::INVALID, VirtualTile::INVALID, VirtualTile::INVALID, VirtualTile::INVALID};
+    deviceContext->ClearUnorderedAccessViewUint(m_feedbackUav.Get(), clearValue);
+
+    // fixed cost: the cache never grows, feedback is one buffer plus the readback ring, reads in flight are capped
+    size_t tileBytes = m_file->getTileBytes();
+    size_t rows = (m_cache.getSlotCount() + m_slotsPerRow - 1) / m_slotsPerRow;
+    size_t feedbackBytes = static_cast<size_t>(m_options.feedbackWidth) * m_options.feedbackHeight * 4;
+    size_t tableBytes = static_cast<size_t>(m_file->getTileCount()) * sizeof(PageTable::Entry);
+    trackResidency(rows * m_slotsPerRow * tileBytes + tableBytes + feedbackBytes * (1 + FEEDBACK_LATENCY),
+                   tableBytes + m_file->getTileCount() * sizeof(uint32_t) + m_options.maxPendingReads * tileBytes);
+
+    Logger::Log(Logger::LogLevel::INFO, "VirtualTexture::VirtualTexture: {}: {}x{}, {} levels down to {}x{}, {} tiles, {} cache slots ({:.1f} MB)",
+                sourcePath, m_file->getWidth(), m_file->getHeight(), m_file->getLevels().size(), coarsest.width, coarsest.height,
+                m_file->getTileCount(), m_cache.getSlotCount(), m_cache.getSlotCount() * m_file->getTileBytes() / (1024.f * 1024.f));
+}
+
+VirtualTexture::~VirtualTexture()
+{
+    // reads still running point into the mapping
+    for (PendingRead &read : m_pendingReads)
+    {
+        read.data.wait();
+    }
+}
+
+void VirtualTexture::bind(ID3D11DeviceContext *deviceContext, UINT slot) const
+{
+    markUsed();
+    if (isBound(slot))
+    {
+        return;
+    }
+    ID3D11ShaderResourceView *views[] = {m_srv.Get(), m_pageTableSrv.Get()};
+    deviceContext->PSSetShaderResources(slot, 2, views);
+    deviceContext->PSSetSamplers(slot, 1, m_sampler.GetAddressOf());
+    deviceContext->PSSetConstantBuffers(4, 1, m_constantBuffer.GetAddressOf()); // matches register(b4)
+
+    // next to the back buffer (u0 would alias SV_Target0), until beginRender sets the targets again
+    ID3D11UnorderedAccessView *uav = m_feedbackUav.Get();
+    deviceContext->OMSetRenderTargetsAndUnorderedAccessViews(D3D11_KEEP_RENDER_TARGETS_AND_DEPTH_STENCIL, nullptr, nullptr, 1, 1, &uav, nullptr);
+    setBound(slot);
+    setBound(slot + 1);
+}
+
+void VirtualTexture::update(ID3D11DeviceContext *deviceContext)
+{
+    ++m_frame;
+    readFeedback(deviceContext);
+    uploadTiles(deviceContext);
+    if (m_pageTable.isDirty())
+    {
+        const std::vector<PageTable::Entry> &entries = m_pageTable.resolve();
+        deviceContext->UpdateSubresource(m_pageTableBuffer.Get(), 0, nullptr, entries.data(), 0, 0);
+    }
+}
+
+void VirtualTexture::readFeedback(ID3D11DeviceContext *deviceContext)
+{
+    // last frame's requests go to the staging ring, the buffer starts over for this frame
+    deviceContext->CopyResource(m_feedbackStaging[m_feedbackCopies % FEEDBACK_LATENCY].Get(), m_feedbackTexture.Get());
+    ++m_feedbackCopies;
+    const UINT clearValue[4] = {VirtualTile::INVALID, VirtualTile::INVALID, VirtualTile::INVALID, VirtualTile::INVALID};
+    deviceContext->ClearUnorderedAccessViewUint(m_feedbackUav.Get(), clearValue);
+    if (m_feedbackCopies < FEEDBACK_LATENCY)
+    {
+        return;
+    }
+
+    // the oldest copy had FEEDBACK_LATENCY - 1 frames to land; when the GPU is further behind the round is skipped
+    // rather than stalling the frame
+    ID3D11Texture2D *staging = m_feedbackStaging[m_feedbackCopies % FEEDBACK_LATENCY].Get();
+    D3D11_MAPPED_SUBRESOURCE mapped = {};
+    HRESULT hr = deviceContext->Map(staging, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+    if (FAILED(hr))
+    {
+        return;
+    }
+    std::vector<VirtualTextureFeedback::Request> requests = VirtualTextureFeedback::analyze(
+        static_cast<const uint32_t *>(mapped.pData), m_options.feedbackWidth, m_options.feedbackHeight, mapped.RowPitch, m_file->getLevels());
+    deviceContext->Unmap(staging, 0);
+    requestTiles(requests);
+}
+
+void VirtualTexture::requestTiles(const std::vector<VirtualTextureFeedback::Request> &requests)
+{
+    // resident tiles are marked used even when the read queue is full, so they outlive tiles nobody looks at
+    for (const VirtualTextureFeedback::Request &request : requests)
+    {
+        uint32_t slot = m_cache.find(request.tile);
+        if (slot != TileCache::INVALID_SLOT)
+        {
+            m_cache.touch(slot, m_frame);
+            continue;
+        }
+        if (m_pendingReads.size() >= m_options.maxPendingReads || !m_pendingTiles.insert(request.tile).second)
+        {
+            continue;
+        }
+        uint32_t tile = request.tile;
+        m_pendingReads.push_back({tile, ThreadPool::getInstance().submit([this, tile]()
+                                                                        { return readTile(tile); })});
+    }
+}
+
+void VirtualTexture::uploadTiles(ID3D11DeviceContext *deviceContext)
+{
+    uint32_t uploadCount = 0;
+    for (size_t i = 0; i < m_pendingReads.size() && uploadCount < m_options.maxUploadsPerFrame;)
+    {
+        PendingRead &read = m_pendingReads[i];
+        if (read.data.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            ++i;
+            continue;
+        }
+        uint32_t tile = read.tile;
+        std::vector<uint8_t> data = read.data.get();
+        m_pendingReads.erase(m_pendingReads.begin() + i);
+        m_pendingTiles.erase(tile);
+
+        // every slot in use this frame: dropped, later feedback asks again
+        uint32_t evicted;
+        uint32_t slot = m_cache.allocate(tile, m_frame, evicted);
+        if (slot == TileCache::INVALID_SLOT)
+        {
+            continue;
+        }
+        if (evicted != VirtualTile::INVALID)
+        {
+            m_pageTable.unmap(evicted);
+        }
+        uploadTile(deviceContext, slot, data.data());
+        m_pageTable.map(tile, slot % m_slotsPerRow, slot / m_slotsPerRow);
+        ++uploadCount;
+    }
+}
+
+void VirtualTexture::uploadTile(ID3D11DeviceContext *deviceContext, uint32_t slot, const uint8_t *data)
+{
+    D3D11_BOX box = {};
+    box.left = slot % m_slotsPerRow * VirtualTextureFile::TILE_STRIDE;
+    box.top = slot / m_slotsPerRow * VirtualTextureFile::TILE_STRIDE;
+    box.right = box.left + VirtualTextureFile::TILE_STRIDE;
+    box.bottom = box.top + VirtualTextureFile::TILE_STRIDE;
+    box.front = 0;
+    box.back = 1;
+    deviceContext->UpdateSubresource(m_physicalTexture.Get(), 0, &box, data, m_file->getTileRowPitch(), 0);
+}
+
+std::vector<uint8_t> VirtualTexture::readTile(uint32_t tile) const
+{
+    // copying out of the mapping is the actual disk read: page faults land on the worker, not the render thread
+    const uint8_t *source = m_file->getTileData(VirtualTile::unpack(tile));
+    return std::vector<uint8_t>(source, source + m_file->getTileBytes());
+}
+
+void VirtualTexture::createResources(ID3D11Device *device)
+{
+    uint32_t rows = (m_cache.getSlotCount() + m_slotsPerRow - 1) / m_slotsPerRow;
+
+    // physical atlas, filled a tile at a time
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = m_slotsPerRow * VirtualTextureFile::TILE_STRIDE;
+    desc.Height = rows * VirtualTextureFile::TILE_STRIDE;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = m_file->getFormat();
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    HRESULT hr = device->CreateTexture2D(&desc, nullptr, m_physicalTexture.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create virtual texture tile cache.");
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = desc.Format;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    srvDesc.Texture2DArray.MipLevels = 1;
+    srvDesc.Texture2DArray.ArraySize = 1;
+    hr = device->CreateShaderResourceView(m_physicalTexture.Get(), &srvDesc, m_srv.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create shader resource view for virtual texture tile cache.");
+    }
+
+    // page table, rewritten whole when residency changes (8 bytes a tile)
+    uint32_t tileCount = m_file->getTileCount();
+    D3D11_BUFFER_DESC bufferDesc = {};
+    bufferDesc.ByteWidth = tileCount * sizeof(PageTable::Entry);
+    bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    bufferDesc.StructureByteStride = sizeof(PageTable::Entry);
+    hr = device->CreateBuffer(&bufferDesc, nullptr, m_pageTableBuffer.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create virtual texture page table.");
+    }
+
+    srvDesc = {};
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    srvDesc.Buffer.FirstElement = 0;
+    srvDesc.Buffer.NumElements = tileCount;
+    hr = device->CreateShaderResourceView(m_pageTableBuffer.Get(), &srvDesc, m_pageTableSrv.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create shader resource view for virtual texture page table.");
+    }
+
+    // layout constants
+    VirtualTextureBuffer constants = {};
+    const std::vector<VirtualTextureFile::Level> &levels = m_file->getLevels();
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        constants.levelTiles[i] = DirectX::XMUINT4(levels[i].tilesX, levels[i].tilesY, levels[i].firstTile, 0);
+        constants.levelSizes[i] = DirectX::XMFLOAT4(static_cast<float>(levels[i].width), static_cast<float>(levels[i].height), 0.f, 0.f);
+    }
+    constants.physicalScale = DirectX::XMFLOAT4(1.f / desc.Width, 1.f / desc.Height, static_cast<float>(VirtualTextureFile::TILE_SIZE),
+                                                static_cast<float>(VirtualTextureFile::TILE_BORDER));
+    constants.info = DirectX::XMUINT4(static_cast<uint32_t>(levels.size()), VirtualTextureFile::TILE_STRIDE, FEEDBACK_DIVISOR, 0);
+
+    bufferDesc = {};
+    bufferDesc.ByteWidth = sizeof(VirtualTextureBuffer);
+    bufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    D3D11_SUBRESOURCE_DATA initData = {};
+    initData.pSysMem = &constants;
+    hr = device->CreateBuffer(&bufferDesc, &initData, m_constantBuffer.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create virtual texture constant buffer.");
+    }
+
+    // feedback target and its readback ring
+    desc = {};
+    desc.Width = m_options.feedbackWidth;
+    desc.Height = m_options.feedbackHeight;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_R32_UINT;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_UNORDERED_ACCESS;
+    hr = device->CreateTexture2D(&desc, nullptr, m_feedbackTexture.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create virtual texture feedback buffer.");
+    }
+
+    D3D11_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+    uavDesc.Format = desc.Format;
+    uavDesc.ViewDimension = D3D11_UAV_DIMENSION_TEXTURE2D;
+    uavDesc.Texture2D.MipSlice = 0;
+    hr = device->CreateUnorderedAccessView(m_feedbackTexture.Get(), &uavDesc, m_feedbackUav.GetAddressOf());
+    if (FAILED(hr))
+    {
+        throw std::runtime_error("Failed to create virtual texture feedback view.");
+    }
+
+    desc.Usage = D3D11_USAGE_STAGING;
+    desc.BindFlags = 0;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+    for (auto &staging : m_feedbackStaging)
+    {
+        hr = device->CreateTexture2D(&desc, nullptr, staging.GetAddressOf());
+        if (FAILED(hr))
+        {
+            throw std::runtime_error("Failed to create virtual texture feedback readback.");
+        }
+    }
+}
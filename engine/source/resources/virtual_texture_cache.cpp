@@ -0,0 +1,231 @@
+#include "resources/virtual_texture_cache.h"
+#include <algorithm>
+
+namespace
+{
+    // The tile one level up covering (most of) this one; odd level sizes round down, the tile border absorbs the texel
+    uint32_t getParent(uint32_t tile, const std::vector<VirtualTextureFile::Level> &levels)
+    {
+        VirtualTile child = VirtualTile::unpack(tile);
+        const VirtualTextureFile::Level &parent = levels[child.level + 1];
+        return VirtualTile{child.level + 1, std::min(child.x / 2, parent.tilesX - 1), std::min(child.y / 2, parent.tilesY - 1)}.pack();
+    }
+
+    bool isValidTile(uint32_t tile, const std::vector<VirtualTextureFile::Level> &levels)
+    {
+        VirtualTile unpacked = VirtualTile::unpack(tile);
+        return unpacked.level < levels.size() && unpacked.x < levels[unpacked.level].tilesX && unpacked.y < levels[unpacked.level].tilesY;
+    }
+}
+
+TileCache::TileCache(uint32_t slotCount)
+    : m_slots(slotCount)
+{
+    m_freeSlots.reserve(slotCount);
+    for (uint32_t slot = slotCount; slot-- > 0;)
+    {
+        m_freeSlots.push_back(slot); // handed out from slot 0 up
+    }
+}
+
+uint32_t TileCache::find(uint32_t tile) const
+{
+    auto it = m_lookup.find(tile);
+    return it != m_lookup.end() ? it->second : INVALID_SLOT;
+}
+
+void TileCache::touch(uint32_t slot, uint64_t frame)
+{
+    Slot &entry = m_slots[slot];
+    entry.lastUsed = frame;
+    if (!entry.isPinned)
+    {
+        unlink(slot);
+        pushBack(slot);
+    }
+}
+
+void TileCache::pin(uint32_t slot)
+{
+    if (!m_slots[slot].isPinned)
+    {
+        unlink(slot);
+        m_slots[slot].isPinned = true;
+    }
+}
+
+uint32_t TileCache::allocate(uint32_t tile, uint64_t frame, uint32_t &evictedTile)
+{
+    evictedTile = VirtualTile::INVALID;
+    uint32_t slot;
+    if (!m_freeSlots.empty())
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        // everything after the head was used at least as recently
+        if (m_head == INVALID_SLOT || m_slots[m_head].lastUsed >= frame)
+        {
+            return INVALID_SLOT;
+        }
+        slot = m_head;
+        unlink(slot);
+        evictedTile = m_slots[slot].tile;
+        m_lookup.erase(evictedTile);
+    }
+
+    m_slots[slot].tile = tile;
+    m_slots[slot].lastUsed = frame;
+    m_lookup[tile] = slot;
+    pushBack(slot);
+    return slot;
+}
+
+void TileCache::unlink(uint32_t slot)
+{
+    Slot &entry = m_slots[slot];
+    bool isLinked = entry.prev != INVALID_SLOT || m_head == slot;
+    if (!isLinked)
+    {
+        return;
+    }
+    (entry.prev != INVALID_SLOT ? m_slots[entry.prev].next : m_head) = entry.next;
+    (entry.next != INVALID_SLOT ? m_slots[entry.next].prev : m_tail) = entry.prev;
+    entry.prev = INVALID_SLOT;
+    entry.next = INVALID_SLOT;
+}
+
+void TileCache::pushBack(uint32_t slot)
+{
+    Slot &entry = m_slots[slot];
+    entry.prev = m_tail;
+    entry.next = INVALID_SLOT;
+    (m_tail != INVALID_SLOT ? m_slots[m_tail].next : m_head) = slot;
+    m_tail = slot;
+}
+
+PageTable::PageTable(const std::vector<VirtualTextureFile::Level> &levels)
+    : m_levels(levels)
+{
+    uint32_t tileCount = levels.back().firstTile + levels.back().tilesX * levels.back().tilesY;
+    m_slots.assign(tileCount, UINT32_MAX);
+    m_entries.assign(tileCount, {NOT_RESIDENT, 0});
+}
+
+void PageTable::map(uint32_t tile, uint32_t slotX, uint32_t slotY)
+{
+    VirtualTile unpacked = VirtualTile::unpack(tile);
+    const VirtualTextureFile::Level &level = m_levels[unpacked.level];
+    m_slots[level.firstTile + unpacked.y * level.tilesX + unpacked.x] = slotX | slotY << 8;
+    m_isDirty = true;
+}
+
+void PageTable::unmap(uint32_t tile)
+{
+    VirtualTile unpacked = VirtualTile::unpack(tile);
+    const VirtualTextureFile::Level &level = m_levels[unpacked.level];
+    m_slots[level.firstTile + unpacked.y * level.tilesX + unpacked.x] = UINT32_MAX;
+    m_isDirty = true;
+}
+
+const std::vector<PageTable::Entry> &PageTable::resolve()
+{
+    if (!m_isDirty)
+    {
+        return m_entries;
+    }
+
+    // coarse to fine, so the parent entry is final when a child falls back to it
+    for (uint32_t levelIndex = static_cast<uint32_t>(m_levels.size()); levelIndex-- > 0;)
+    {
+        const VirtualTextureFile::Level &level = m_levels[levelIndex];
+        for (uint32_t y = 0; y < level.tilesY; ++y)
+        {
+            for (uint32_t x = 0; x < level.tilesX; ++x)
+            {
+                uint32_t index = level.firstTile + y * level.tilesX + x;
+                if (m_slots[index] != UINT32_MAX)
+                {
+                    m_entries[index] = {m_slots[index] | levelIndex << 16, x | y << 16};
+                }
+                else if (levelIndex + 1 < m_levels.size())
+                {
+                    VirtualTile parent = VirtualTile::unpack(getParent(VirtualTile{levelIndex, x, y}.pack(), m_levels));
+                    const VirtualTextureFile::Level &parentLevel = m_levels[parent.level];
+                    m_entries[index] = m_entries[parentLevel.firstTile + parent.y * parentLevel.tilesX + parent.x];
+                }
+                else
+                {
+                    m_entries[index] = {NOT_RESIDENT, 0};
+                }
+            }
+        }
+    }
+    m_isDirty = false;
+    return m_entries;
+}
+
+std::vector<VirtualTextureFeedback::Request> VirtualTextureFeedback::analyze(const uint32_t *feedback, uint32_t width, uint32_t height, size_t rowPitch,
+                                                                           const std::vector<VirtualTextureFile::Level> &levels)
+{
+    // neighbouring pixels mostly want the same tile, skip runs before touching the map
+    std::unordered_map<uint32_t, uint32_t> counts;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const uint32_t *row = reinterpret_cast<const uint32_t *>(reinterpret_cast<const uint8_t *>(feedback) + y * rowPitch);
+        for (uint32_t x = 0; x < width;)
+        {
+            uint32_t tile = row[x];
+            uint32_t run = 1;
+            while (x + run < width && row[x + run] == tile)
+            {
+                ++run;
+            }
+            x += run;
+            if (tile != VirtualTile::INVALID && isValidTile(tile, levels))
+            {
+                counts[tile] += run;
+            }
+        }
+    }
+
+    std::vector<uint32_t> seeds;
+    seeds.reserve(counts.size());
+    for (const auto &[tile, count] : counts)
+    {
+        seeds.push_back(tile);
+    }
+    for (uint32_t tile : seeds)
+    {
+        while (VirtualTile::unpack(tile).level + 1 < levels.size())
+        {
+            tile = getParent(tile, levels);
+            if (!counts.try_emplace(tile, 0).second)
+            {
+                break; // the rest of the chain is in already
+            }
+        }
+    }
+
+    std::vector<Request> requests;
+    requests.reserve(counts.size());
+    for (const auto &[tile, count] : counts)
+    {
+        requests.push_back({tile, count});
+    }
+    std::sort(requests.begin(), requests.end(), [](const Request &a, const Request &b)
+              {
+        uint32_t levelA = a.tile >> 24, levelB = b.tile >> 24;
+        if (levelA != levelB)
+        {
+            return levelA > levelB;
+        }
+        if (a.pixelCount != b.pixelCount)
+        {
+            return a.pixelCount > b.pixelCount;
+        }
+        return a.tile < b.tile; });
+    return requests;
+}
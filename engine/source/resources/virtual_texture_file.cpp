@@ -0,0 +1,286 @@
+#include "resources/virtual_texture_file.h"
+#include "resources/mip_generator.h"
+#include "resources/block_compressor.h"
+#include "utils/hash.h"
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    const std::string CACHE_DIRECTORY = "cache/vtex/";
+
+    struct Header
+    {
+        uint32_t tag;
+        uint32_t version;
+        uint64_t sourceSize; // size + mtime is the fast path, the content hash is the fallback
+        int64_t writeTime;
+        uint64_t sourceHash;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levelCount;
+        uint32_t tileSize;
+        uint32_t tileBorder;
+        uint32_t format;
+        uint64_t dataOffset;
+    };
+
+    constexpr size_t DATA_ALIGNMENT = 64;
+
+    bool getSourceStamp(const std::string &sourcePath, uint64_t &size, int64_t &writeTime)
+    {
+        std::error_code ec;
+        size = static_cast<uint64_t>(std::filesystem::file_size(sourcePath, ec));
+        if (ec)
+        {
+            return false;
+        }
+        writeTime = static_cast<int64_t>(std::filesystem::last_write_time(sourcePath, ec).time_since_epoch().count());
+        return !ec;
+    }
+
+    uint64_t hashSource(const std::string &sourcePath)
+    {
+        MappedFile source(sourcePath);
+        return hashBytes(source.data(), source.size());
+    }
+
+    bool isValidFormat(DXGI_FORMAT format)
+    {
+        return format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC1_UNORM_SRGB || format == DXGI_FORMAT_R8G8B8A8_UNORM ||
+               format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    }
+
+    bool isBc1(DXGI_FORMAT format)
+    {
+        return format == DXGI_FORMAT_BC1_UNORM || format == DXGI_FORMAT_BC1_UNORM_SRGB;
+    }
+
+    size_t tileBytesOf(DXGI_FORMAT format)
+    {
+        constexpr size_t texels = VirtualTextureFile::TILE_STRIDE * VirtualTextureFile::TILE_STRIDE;
+        return isBc1(format) ? texels / 2 : texels * 4;
+    }
+
+    // Tile texels around the tile origin, wrapped into the level like the sampler wraps
+    void extractTile(const MipLevel &level, uint32_t tileX, uint32_t tileY, uint8_t *tile)
+    {
+        constexpr uint32_t STRIDE = VirtualTextureFile::TILE_STRIDE;
+        int64_t originX = static_cast<int64_t>(tileX) * VirtualTextureFile::TILE_SIZE - VirtualTextureFile::TILE_BORDER;
+        int64_t originY = static_cast<int64_t>(tileY) * VirtualTextureFile::TILE_SIZE - VirtualTextureFile::TILE_BORDER;
+        for (uint32_t row = 0; row < STRIDE; ++row)
+        {
+            int64_t y = ((originY + row) % level.height + level.height) % level.height;
+            const uint8_t *source = level.pixels.data() + static_cast<size_t>(y) * level.width * 4;
+            for (uint32_t column = 0; column < STRIDE; ++column)
+            {
+                int64_t x = ((originX + column) % level.width + level.width) % level.width;
+                std::memcpy(tile + (static_cast<size_t>(row) * STRIDE + column) * 4, source + x * 4, 4);
+            }
+        }
+    }
+}
+
+VirtualTextureFile::VirtualTextureFile(const std::string &pagePath)
+    : m_file(std::make_unique<MappedFile>(pagePath))
+{
+    Header header;
+    if (m_file->size() < sizeof(Header))
+    {
+        throw std::runtime_error("VirtualTextureFile: " + pagePath + " is truncated");
+    }
+    std::memcpy(&header, m_file->data(), sizeof(Header));
+    DXGI_FORMAT format = static_cast<DXGI_FORMAT>(header.format);
+    if (header.tag != TAG || header.version != VERSION || header.tileSize != TILE_SIZE || header.tileBorder != TILE_BORDER ||
+        !isValidFormat(format) || header.width == 0 || header.height == 0)
+    {
+        throw std::runtime_error("VirtualTextureFile: " + pagePath + " is not a page file of this version");
+    }
+
+    m_width = header.width;
+    m_height = header.height;
+    m_format = format;
+    m_levels = getLevels(m_width, m_height);
+    m_dataOffset = static_cast<size_t>(header.dataOffset);
+    if (header.levelCount != m_levels.size() || m_dataOffset + getTileCount() * getTileBytes() > m_file->size())
+    {
+        throw std::runtime_error("VirtualTextureFile: " + pagePath + " is truncated");
+    }
+}
+
+std::string VirtualTextureFile::getCachePath(const std::string &sourcePath)
+{
+    std::string name = sourcePath;
+    for (char &c : name)
+    {
+        if (c == '/' || c == '\\' || c == ':')
+        {
+            c = '_';
+        }
+    }
+    return CACHE_DIRECTORY + name + ".vtx";
+}
+
+std::unique_ptr<VirtualTextureFile> VirtualTextureFile::openCached(const std::string &sourcePath)
+{
+    std::string pagePath = getCachePath(sourcePath);
+    std::error_code ec;
+    if (std::filesystem::exists(pagePath, ec))
+    {
+        try
+        {
+            auto file = std::make_unique<VirtualTextureFile>(pagePath);
+            Header header;
+            std::memcpy(&header, file->m_file->data(), sizeof(Header));
+            uint64_t size;
+            int64_t writeTime;
+            if (!getSourceStamp(sourcePath, size, writeTime) ||
+                (size == header.sourceSize && (writeTime == header.writeTime || hashSource(sourcePath) == header.sourceHash)))
+            {
+                return file;
+            }
+            Logger::Log(Logger::LogLevel::INFO, "VirtualTextureFile::openCached: {} changed, retiling", sourcePath);
+        }
+        catch (const std::exception &e)
+        {
+            Logger::Log(Logger::LogLevel::INFO, "VirtualTextureFile::openCached: {}, retiling", e.what());
+        }
+    }
+
+    return nullptr;
+}
+
+void VirtualTextureFile::write(const std::string &pagePath, const uint8_t *pixels, uint32_t width, uint32_t height, bool isSrgb,
+                               const std::string &sourcePath)
+{
+    auto startTime = std::chrono::high_resolution_clock::now();
+    std::vector<Level> levels = getLevels(width, height);
+
+    // the whole chain in linear light like ImageTexture, only the levels that still need more than one tile are kept
+    std::vector<MipLevel> mips = MipGenerator::generate(pixels, width, height, static_cast<size_t>(width) * 4, true, MipFilter::Kaiser);
+    mips.resize(levels.size());
+
+    bool isOpaque = true;
+    for (size_t i = 3; i < static_cast<size_t>(width) * height * 4 && isOpaque; i += 4)
+    {
+        isOpaque = pixels[i] == 255;
+    }
+    DXGI_FORMAT format = isOpaque ? (isSrgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM)
+                                  : (isSrgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM);
+
+    Header header = {};
+    header.tag = TAG;
+    header.version = VERSION;
+    if (!sourcePath.empty() && getSourceStamp(sourcePath, header.sourceSize, header.writeTime))
+    {
+        header.sourceHash = hashSource(sourcePath);
+    }
+    header.width = width;
+    header.height = height;
+    header.levelCount = static_cast<uint32_t>(levels.size());
+    header.tileSize = TILE_SIZE;
+    header.tileBorder = TILE_BORDER;
+    header.format = static_cast<uint32_t>(format);
+    header.dataOffset = (sizeof(Header) + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+
+    std::filesystem::path parent = std::filesystem::path(pagePath).parent_path();
+    if (!parent.empty())
+    {
+        std::filesystem::create_directories(parent);
+    }
+    std::string tempPath = pagePath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            throw std::runtime_error("VirtualTextureFile::write: Failed to open " + tempPath);
+        }
+        std::vector<char> headerBytes(static_cast<size_t>(header.dataOffset), 0);
+        std::memcpy(headerBytes.data(), &header, sizeof(Header));
+        out.write(headerBytes.data(), static_cast<std::streamsize>(headerBytes.size()));
+
+        // a row of tiles at a time keeps the memory bounded on huge sources
+        size_t tileBytes = tileBytesOf(format);
+        std::vector<uint8_t> row;
+        for (size_t levelIndex = 0; levelIndex < levels.size(); ++levelIndex)
+        {
+            const Level &level = levels[levelIndex];
+            row.resize(level.tilesX * tileBytes);
+            for (uint32_t tileY = 0; tileY < level.tilesY; ++tileY)
+            {
+                ThreadPool::getInstance().parallelFor(level.tilesX, 1, [&](size_t begin, size_t end)
+                                                      {
+                    std::vector<uint8_t> tile(static_cast<size_t>(TILE_STRIDE) * TILE_STRIDE * 4);
+                    for (size_t tileX = begin; tileX < end; ++tileX)
+                    {
+                        extractTile(mips[levelIndex], static_cast<uint32_t>(tileX), tileY, tile.data());
+                        if (isOpaque)
+                        {
+                            std::vector<uint8_t> blocks = BlockCompressor::compress(BlockFormat::BC1, tile.data(), TILE_STRIDE, TILE_STRIDE);
+                            std::memcpy(row.data() + tileX * tileBytes, blocks.data(), tileBytes);
+                        }
+                        else
+                        {
+                            std::memcpy(row.data() + tileX * tileBytes, tile.data(), tileBytes);
+                        }
+                    } });
+                out.write(reinterpret_cast<const char *>(row.data()), static_cast<std::streamsize>(row.size()));
+            }
+        }
+        if (!out)
+        {
+            throw std::runtime_error("VirtualTextureFile::write: Failed to write " + tempPath);
+        }
+    }
+    std::filesystem::rename(tempPath, pagePath);
+
+    uint32_t tileCount = levels.back().firstTile + levels.back().tilesX * levels.back().tilesY;
+    float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Logger::Log(Logger::LogLevel::INFO, "VirtualTextureFile::write: {}: {}x{}, {} levels, {} tiles ({}) in {:.2f} ms",
+                pagePath, width, height, levels.size(), tileCount, isOpaque ? "BC1" : "RGBA8", elapsedMs);
+}
+
+std::vector<VirtualTextureFile::Level> VirtualTextureFile::getLevels(uint32_t width, uint32_t height)
+{
+    std::vector<Level> levels;
+    uint32_t firstTile = 0;
+    while (levels.size() < MAX_LEVELS)
+    {
+        Level level = {width, height, (width + TILE_SIZE - 1) / TILE_SIZE, (height + TILE_SIZE - 1) / TILE_SIZE, firstTile};
+        levels.push_back(level);
+        firstTile += level.tilesX * level.tilesY;
+        if (level.tilesX == 1 && level.tilesY == 1)
+        {
+            break;
+        }
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+    return levels;
+}
+
+uint32_t VirtualTextureFile::getTileCount() const
+{
+    return m_levels.back().firstTile + m_levels.back().tilesX * m_levels.back().tilesY;
+}
+
+size_t VirtualTextureFile::getTileBytes() const
+{
+    return tileBytesOf(m_format);
+}
+
+uint32_t VirtualTextureFile::getTileRowPitch() const
+{
+    return isBc1(m_format) ? TILE_STRIDE / 4 * 8 : TILE_STRIDE * 4;
+}
+
+const uint8_t *VirtualTextureFile::getTileData(const VirtualTile &tile) const
+{
+    const Level &level = m_levels[tile.level];
+    size_t index = level.firstTile + static_cast<size_t>(tile.y) * level.tilesX + tile.x;
+    return reinterpret_cast<const uint8_t *>(m_file->data()) + m_dataOffset + index * getTileBytes();
+}
@@ -0,0 +1,79 @@
+#include "utils/frustum.h"
+
+Frustum Frustum::fromMatrix(const DirectX::XMMATRIX &matrix)
+{
+    // clip = p * M, so each clip component is a column of M
+    DirectX::XMMATRIX columns = DirectX::XMMatrixTranspose(matrix);
+    DirectX::XMVECTOR x = columns.r[0];
+    DirectX::XMVECTOR y = columns.r[1];
+    DirectX::XMVECTOR z = columns.r[2];
+    DirectX::XMVECTOR w = columns.r[3];
+
+    DirectX::XMVECTOR planes[Plane::Count] = {
+        DirectX::XMVectorAdd(w, x),      // -w <= x
+        DirectX::XMVectorSubtract(w, x), // x <= w
+        DirectX::XMVectorAdd(w, y),      // -w <= y
+        DirectX::XMVectorSubtract(w, y), // y <= w
+        z,                               // 0 <= z
+        DirectX::XMVectorSubtract(w, z), // z <= w
+    };
+
+    Frustum frustum;
+    for (int i = 0; i < Plane::Count; ++i)
+    {
+        DirectX::XMStoreFloat4(&frustum.planes[i], DirectX::XMPlaneNormalize(planes[i]));
+    }
+    return frustum;
+}
+
+bool Frustum::intersectsSphere(const DirectX::XMFLOAT3 &center, float radius) const
+{
+    for (int i = 0; i < Plane::Count; ++i)
+    {
+        const DirectX::XMFLOAT4 &plane = planes[i];
+        if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Frustum::intersectsSpheres(const float *centerX, const float *centerY, const float *centerZ, const float *radius, size_t count, uint8_t *visible) const
+{
+    DirectX::XMVECTOR planeX[Plane::Count], planeY[Plane::Count], planeZ[Plane::Count], planeW[Plane::Count];
+    for (int i = 0; i < Plane::Count; ++i)
+    {
+        planeX[i] = DirectX::XMVectorReplicate(planes[i].x);
+        planeY[i] = DirectX::XMVectorReplicate(planes[i].y);
+        planeZ[i] = DirectX::XMVectorReplicate(planes[i].z);
+        planeW[i] = DirectX::XMVectorReplicate(planes[i].w);
+    }
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        DirectX::XMVECTOR x = DirectX::XMLoadFloat4(reinterpret_cast<const DirectX::XMFLOAT4 *>(centerX + i));
+        DirectX::XMVECTOR y = DirectX::XMLoadFloat4(reinterpret_cast<const DirectX::XMFLOAT4 *>(centerY + i));
+        DirectX::XMVECTOR z = DirectX::XMLoadFloat4(reinterpret_cast<const DirectX::XMFLOAT4 *>(centerZ + i));
+        DirectX::XMVECTOR negRadius = DirectX::XMVectorNegate(DirectX::XMLoadFloat4(reinterpret_cast<const DirectX::XMFLOAT4 *>(radius + i)));
+
+        DirectX::XMVECTOR outside = DirectX::XMVectorFalseInt();
+        for (int p = 0; p < Plane::Count; ++p)
+        {
+            DirectX::XMVECTOR distance = DirectX::XMVectorMultiplyAdd(x, planeX[p], DirectX::XMVectorMultiplyAdd(y, planeY[p], DirectX::XMVectorMultiplyAdd(z, planeZ[p], planeW[p])));
+            outside = DirectX::XMVectorOrInt(outside, DirectX::XMVectorLess(distance, negRadius));
+        }
+
+        DirectX::XMUINT4 mask;
+        DirectX::XMStoreUInt4(&mask, outside);
+        visible[i] = mask.x == 0;
+        visible[i + 1] = mask.y == 0;
+        visible[i + 2] = mask.z == 0;
+        visible[i + 3] = mask.w == 0;
+    }
+    for (; i < count; ++i)
+    {
+        visible[i] = intersectsSphere({centerX[i], centerY[i], centerZ[i]}, radius[i]);
+    }
+}
@@ -0,0 +1,476 @@
+#include "utils/inflate.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    constexpr uint32_t FAST_BITS = 10;
+    constexpr uint32_t MAX_BITS = 15;
+    constexpr uint32_t ADLER_BASE = 65521;
+    constexpr size_t ADLER_BLOCK = 5552; // largest n for which the sums cannot overflow 32 bits
+
+    constexpr uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    constexpr uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    constexpr uint16_t DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                            6145, 8193, 12289, 16385, 24577};
+    constexpr uint8_t DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+    constexpr uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    [[noreturn]] void fail(const char *message)
+    {
+        throw std::runtime_error(std::string("Inflate: ") + message);
+    }
+
+    // LSB-first bit buffer. Past the end of the input it shifts in zeros and counts them, a stream that
+    // consumed any of them was truncated.
+    class BitReader
+    {
+    public:
+        BitReader(const uint8_t *data, size_t size) : m_data(data), m_size(size) {}
+
+        // at least 56 bits buffered afterwards
+        void refill()
+        {
+            if (m_position + 8 <= m_size)
+            {
+                // bits above m_count already hold the start of the byte at m_position, OR-ing it again is harmless
+                uint64_t word;
+                std::memcpy(&word, m_data + m_position, sizeof(word)); // little endian
+                m_bits |= word << m_count;
+                m_position += (63 - m_count) >> 3;
+                m_count |= 56;
+                return;
+            }
+            while (m_count <= 56)
+            {
+                if (m_position < m_size)
+                {
+                    m_bits |= static_cast<uint64_t>(m_data[m_position++]) << m_count;
+                }
+                else
+                {
+                    ++m_overrun;
+                }
+                m_count += 8;
+            }
+        }
+
+        uint64_t getBits() const { return m_bits; }
+        uint32_t peek(uint32_t count) const { return static_cast<uint32_t>(m_bits & ((1ull << count) - 1)); }
+
+        void consume(uint32_t count)
+        {
+            m_bits >>= count;
+            m_count -= count;
+        }
+
+        uint32_t read(uint32_t count)
+        {
+            if (m_count < count)
+            {
+                refill();
+            }
+            uint32_t value = peek(count);
+            consume(count);
+            return value;
+        }
+
+        void alignToByte() { consume(m_count & 7); }
+
+        // byte offset of the next unread byte, only valid when aligned
+        size_t getBytePosition() const { return m_position + m_overrun - (m_count >> 3); }
+
+        void seek(size_t position)
+        {
+            m_position = position;
+            m_bits = 0;
+            m_count = 0;
+            m_overrun = 0;
+        }
+
+        bool isOverrun() const { return m_overrun * 8 > m_count; }
+
+        const uint8_t *getData() const { return m_data; }
+        size_t getSize() const { return m_size; }
+
+    private:
+        const uint8_t *m_data;
+        size_t m_size;
+        size_t m_position = 0;
+        size_t m_overrun = 0;
+        uint64_t m_bits = 0;
+        uint32_t m_count = 0;
+    };
+
+    // Canonical Huffman code: codes up to FAST_BITS resolve with one lookup, longer ones walk the
+    // per-length counts (rare, literal codes that long only show up in skewed blocks)
+    struct Huffman
+    {
+        uint16_t fast[1 << FAST_BITS]; // symbol << 4 | length, 0 when the code is longer than FAST_BITS
+        uint16_t counts[MAX_BITS + 1];
+        uint16_t symbols[288];
+
+        void build(const uint8_t *lengths, uint32_t count)
+        {
+            std::fill(std::begin(counts), std::end(counts), 0);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                ++counts[lengths[i]];
+            }
+            counts[0] = 0;
+
+            int left = 1;
+            for (uint32_t length = 1; length <= MAX_BITS; ++length)
+            {
+                left = (left << 1) - counts[length];
+                if (left < 0)
+                {
+                    fail("over-subscribed Huffman code");
+                }
+            }
+
+            uint16_t offsets[MAX_BITS + 1] = {};
+            uint32_t nextCode[MAX_BITS + 1] = {};
+            for (uint32_t length = 1; length < MAX_BITS; ++length)
+            {
+                offsets[length + 1] = offsets[length] + counts[length];
+            }
+            for (uint32_t length = 1, code = 0; length <= MAX_BITS; ++length)
+            {
+                code = (code + counts[length - 1]) << 1;
+                nextCode[length] = code;
+            }
+
+            std::fill(std::begin(fast), std::end(fast), 0);
+            for (uint32_t symbol = 0; symbol < count; ++symbol)
+            {
+                uint32_t length = lengths[symbol];
+                if (length == 0)
+                {
+                    continue;
+                }
+                symbols[offsets[length]++] = static_cast<uint16_t>(symbol);
+                uint32_t code = nextCode[length]++;
+                if (length <= FAST_BITS)
+                {
+                    // the stream sends codes MSB first, the bit buffer is LSB first
+                    uint32_t reversed = 0;
+                    for (uint32_t i = 0; i < length; ++i)
+                    {
+                        reversed |= ((code >> i) & 1) << (length - 1 - i);
+                    }
+                    for (uint32_t i = reversed; i < (1u << FAST_BITS); i += 1u << length)
+                    {
+                        fast[i] = static_cast<uint16_t>(symbol << 4 | length);
+                    }
+                }
+            }
+        }
+
+        // needs MAX_BITS buffered
+        uint32_t decode(BitReader &reader) const
+        {
+            uint32_t entry = fast[reader.peek(FAST_BITS)];
+            if (entry != 0)
+            {
+                reader.consume(entry & 15);
+                return entry >> 4;
+            }
+
+            uint64_t bits = reader.getBits();
+            int code = 0, first = 0, index = 0;
+            for (uint32_t length = 1; length <= MAX_BITS; ++length)
+            {
+                code |= static_cast<int>(bits & 1);
+                bits >>= 1;
+                int count = counts[length];
+                if (code - count < first)
+                {
+                    reader.consume(length);
+                    return symbols[index + (code - first)];
+                }
+                index += count;
+                first = (first + count) << 1;
+                code <<= 1;
+            }
+            fail("invalid Huffman code");
+        }
+    };
+
+    struct FixedTables
+    {
+        Huffman literal;
+        Huffman distance;
+
+        FixedTables()
+        {
+            uint8_t lengths[288];
+            std::fill(lengths, lengths + 144, 8);
+            std::fill(lengths + 144, lengths + 256, 9);
+            std::fill(lengths + 256, lengths + 280, 7);
+            std::fill(lengths + 280, lengths + 288, 8);
+            literal.build(lengths, 288);
+            std::fill(lengths, lengths + 30, 5);
+            distance.build(lengths, 30);
+        }
+    };
+
+    void readDynamicTables(BitReader &reader, Huffman &literal, Huffman &distance)
+    {
+        uint32_t literalCount = reader.read(5) + 257;
+        uint32_t distanceCount = reader.read(5) + 1;
+        uint32_t codeLengthCount = reader.read(4) + 4;
+        if (literalCount > 286 || distanceCount > 30)
+        {
+            fail("too many codes");
+        }
+
+        uint8_t codeLengthLengths[19] = {};
+        for (uint32_t i = 0; i < codeLengthCount; ++i)
+        {
+            codeLengthLengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(reader.read(3));
+        }
+        Huffman codeLengths;
+        codeLengths.build(codeLengthLengths, 19);
+
+        uint8_t lengths[286 + 30];
+        uint32_t total = literalCount + distanceCount;
+        for (uint32_t i = 0; i < total;)
+        {
+            reader.refill();
+            uint32_t symbol = codeLengths.decode(reader);
+            if (symbol < 16)
+            {
+                lengths[i++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+
+            uint8_t value = 0;
+            uint32_t repeat;
+            if (symbol == 16)
+            {
+                if (i == 0)
+                {
+                    fail("repeat with no previous length");
+                }
+                value = lengths[i - 1];
+                repeat = 3 + reader.read(2);
+            }
+            else
+            {
+                repeat = symbol == 17 ? 3 + reader.read(3) : 11 + reader.read(7);
+            }
+            if (i + repeat > total)
+            {
+                fail("code lengths overflow");
+            }
+            std::fill(lengths + i, lengths + i + repeat, value);
+            i += repeat;
+        }
+        if (lengths[256] == 0)
+        {
+            fail("no end of block code");
+        }
+
+        literal.build(lengths, literalCount);
+        distance.build(lengths + literalCount, distanceCount);
+    }
+
+    size_t inflateCodes(BitReader &reader, const Huffman &literal, const Huffman &distance, uint8_t *dst, size_t out, size_t capacity)
+    {
+        for (;;)
+        {
+            // 56 bits cover the longest length + distance pair (15 + 5 + 15 + 13)
+            reader.refill();
+            uint32_t symbol = literal.decode(reader);
+            if (symbol < 256)
+            {
+                if (out >= capacity)
+                {
+                    fail("output overflow");
+                }
+                dst[out++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+            if (symbol == 256)
+            {
+                return out;
+            }
+
+            symbol -= 257;
+            if (symbol >= 29)
+            {
+                fail("invalid length code");
+            }
+            size_t length = LENGTH_BASE[symbol] + reader.peek(LENGTH_EXTRA[symbol]);
+            reader.consume(LENGTH_EXTRA[symbol]);
+
+            uint32_t distanceSymbol = distance.decode(reader);
+            if (distanceSymbol >= 30)
+            {
+                fail("invalid distance code");
+            }
+            size_t offset = DISTANCE_BASE[distanceSymbol] + reader.peek(DISTANCE_EXTRA[distanceSymbol]);
+            reader.consume(DISTANCE_EXTRA[distanceSymbol]);
+
+            if (offset > out)
+            {
+                fail("distance too far back");
+            }
+            if (length > capacity - out)
+            {
+                fail("output overflow");
+            }
+
+            uint8_t *target = dst + out;
+            const uint8_t *source = target - offset;
+            if (offset >= 8 && capacity - out >= length + 8)
+            {
+                // each 8 byte read ends at or before the write position, so overlapping runs still copy right
+                for (size_t i = 0; i < length; i += 8)
+                {
+                    std::memcpy(target + i, source + i, 8);
+                }
+            }
+            else if (offset == 1)
+            {
+                std::memset(target, *source, length);
+            }
+            else
+            {
+                for (size_t i = 0; i < length; ++i)
+                {
+                    target[i] = source[i];
+                }
+            }
+            out += length;
+        }
+    }
+
+    size_t inflateBlocks(BitReader &reader, uint8_t *dst, size_t capacity)
+    {
+        static const FixedTables fixed;
+
+        size_t out = 0;
+        bool isFinal;
+        do
+        {
+            isFinal = reader.read(1) != 0;
+            uint32_t type = reader.read(2);
+            if (type == 0)
+            {
+                reader.alignToByte();
+                uint32_t length = reader.read(16);
+                uint32_t complement = reader.read(16);
+                if (length != (~complement & 0xFFFF))
+                {
+                    fail("stored block length mismatch");
+                }
+                size_t position = reader.getBytePosition();
+                if (position + length > reader.getSize())
+                {
+                    fail("truncated stored block");
+                }
+                if (length > capacity - out)
+                {
+                    fail("output overflow");
+                }
+                std::memcpy(dst + out, reader.getData() + position, length);
+                out += length;
+                reader.seek(position + length);
+            }
+            else if (type == 1)
+            {
+                out = inflateCodes(reader, fixed.literal, fixed.distance, dst, out, capacity);
+            }
+            else if (type == 2)
+            {
+                Huffman literal, distance;
+                readDynamicTables(reader, literal, distance);
+                out = inflateCodes(reader, literal, distance, dst, out, capacity);
+            }
+            else
+            {
+                fail("invalid block type");
+            }
+
+            if (reader.isOverrun())
+            {
+                fail("truncated stream");
+            }
+        } while (!isFinal);
+        return out;
+    }
+}
+
+size_t Inflate::decompress(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstCapacity)
+{
+    BitReader reader(src, srcSize);
+    return inflateBlocks(reader, dst, dstCapacity);
+}
+
+size_t Inflate::decompressZlib(const uint8_t *src, size_t srcSize, uint8_t *dst, size_t dstCapacity)
+{
+    if (srcSize < 6)
+    {
+        fail("truncated zlib stream");
+    }
+    uint32_t cmf = src[0], flags = src[1];
+    if ((cmf & 15) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flags) % 31 != 0)
+    {
+        fail("invalid zlib header");
+    }
+    if (flags & 0x20)
+    {
+        fail("preset dictionaries are not supported");
+    }
+
+    BitReader reader(src + 2, srcSize - 2);
+    size_t written = inflateBlocks(reader, dst, dstCapacity);
+
+    reader.alignToByte();
+    size_t position = reader.getBytePosition();
+    if (position + 4 > srcSize - 2)
+    {
+        fail("missing Adler-32");
+    }
+    const uint8_t *trailer = src + 2 + position;
+    uint32_t expected = static_cast<uint32_t>(trailer[0]) << 24 | static_cast<uint32_t>(trailer[1]) << 16 |
+                        static_cast<uint32_t>(trailer[2]) << 8 | trailer[3];
+    if (adler32(dst, written) != expected)
+    {
+        fail("Adler-32 mismatch");
+    }
+    return written;
+}
+
+uint32_t Inflate::adler32(const uint8_t *data, size_t size, uint32_t adler)
+{
+    uint32_t a = adler & 0xFFFF, b = adler >> 16;
+    while (size > 0)
+    {
+        size_t blockSize = std::min(size, ADLER_BLOCK);
+        size -= blockSize;
+        for (; blockSize >= 8; blockSize -= 8, data += 8)
+        {
+            a += data[0], b += a;
+            a += data[1], b += a;
+            a += data[2], b += a;
+            a += data[3], b += a;
+            a += data[4], b += a;
+            a += data[5], b += a;
+            a += data[6], b += a;
+            a += data[7], b += a;
+        }
+        for (; blockSize > 0; --blockSize)
+        {
+            a += *data++;
+            b += a;
+        }
+        a %= ADLER_BASE;
+        b %= ADLER_BASE;
+    }
+    return b << 16 | a;
+}
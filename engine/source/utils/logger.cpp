@@ -14,7 +14,11 @@ namespace Logger
         auto now = std::chrono::system_clock::now();
         auto time_t_now = std::chrono::system_clock::to_time_t(now);
         std::tm local_time{};
+#ifdef _WIN32
         localtime_s(&local_time, &time_t_now);
+#else
+        localtime_r(&time_t_now, &local_time);
+#endif
 
         std::ostringstream ss;
         ss << std::put_time(&local_time, "%Y-%m-%d %H:%M:%S");
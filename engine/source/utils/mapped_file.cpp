@@ -0,0 +1,124 @@
+#include "utils/mapped_file.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &filepath)
+    : m_filepath(filepath), m_data(nullptr), m_size(0), m_fileHandle(INVALID_HANDLE_VALUE), m_mappingHandle(nullptr)
+{
+    m_fileHandle = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_fileHandle == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("MappedFile::MappedFile: Failed to open file: " + filepath);
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(m_fileHandle, &fileSize))
+    {
+        close();
+        throw std::runtime_error("MappedFile::MappedFile: Failed to query file size: " + filepath);
+    }
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    if (m_size == 0)
+    {
+        return; // empty files cannot be mapped
+    }
+
+    m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mappingHandle == nullptr)
+    {
+        close();
+        throw std::runtime_error("MappedFile::MappedFile: Failed to create file mapping: " + filepath);
+    }
+
+    m_data = MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (m_data == nullptr)
+    {
+        close();
+        throw std::runtime_error("MappedFile::MappedFile: Failed to map view of file: " + filepath);
+    }
+}
+
+void MappedFile::close()
+{
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+        m_data = nullptr;
+    }
+    if (m_mappingHandle)
+    {
+        CloseHandle(m_mappingHandle);
+        m_mappingHandle = nullptr;
+    }
+    if (m_fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_fileHandle);
+        m_fileHandle = INVALID_HANDLE_VALUE;
+    }
+    m_size = 0;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &filepath)
+    : m_filepath(filepath), m_data(nullptr), m_size(0), m_fileDescriptor(-1)
+{
+    m_fileDescriptor = ::open(filepath.c_str(), O_RDONLY);
+    if (m_fileDescriptor < 0)
+    {
+        throw std::runtime_error("MappedFile::MappedFile: Failed to open file: " + filepath);
+    }
+
+    struct stat fileStat = {};
+    if (::fstat(m_fileDescriptor, &fileStat) != 0)
+    {
+        close();
+        throw std::runtime_error("MappedFile::MappedFile: Failed to query file size: " + filepath);
+    }
+    m_size = static_cast<size_t>(fileStat.st_size);
+    if (m_size == 0)
+    {
+        return; // empty files cannot be mapped
+    }
+
+    void *mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close();
+        throw std::runtime_error("MappedFile::MappedFile: Failed to map file: " + filepath);
+    }
+    ::madvise(mapping, m_size, MADV_SEQUENTIAL);
+    m_data = mapping;
+}
+
+void MappedFile::close()
+{
+    if (m_data)
+    {
+        ::munmap(const_cast<void *>(m_data), m_size);
+        m_data = nullptr;
+    }
+    if (m_fileDescriptor >= 0)
+    {
+        ::close(m_fileDescriptor);
+        m_fileDescriptor = -1;
+    }
+    m_size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
@@ -0,0 +1,115 @@
+#include "utils/staging_pool.h"
+#include <algorithm>
+#include <new>
+#include <utility>
+
+namespace
+{
+    constexpr size_t GRANULARITY = 64 * 1024; // capacities are rounded up so similar sizes share blocks
+
+    uint8_t *allocateAligned(size_t capacity)
+    {
+        return static_cast<uint8_t *>(::operator new(capacity, std::align_val_t{StagingPool::ALIGNMENT}));
+    }
+
+    void freeAligned(uint8_t *data)
+    {
+        ::operator delete(data, std::align_val_t{StagingPool::ALIGNMENT});
+    }
+}
+
+StagingBuffer::StagingBuffer(StagingBuffer &&other) noexcept
+    : m_pool(std::exchange(other.m_pool, nullptr)), m_data(std::exchange(other.m_data, nullptr)),
+      m_size(std::exchange(other.m_size, 0)), m_capacity(std::exchange(other.m_capacity, 0))
+{
+}
+
+StagingBuffer &StagingBuffer::operator=(StagingBuffer &&other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        m_pool = std::exchange(other.m_pool, nullptr);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_capacity = std::exchange(other.m_capacity, 0);
+    }
+    return *this;
+}
+
+void StagingBuffer::reset()
+{
+    if (m_data)
+    {
+        m_pool->release(m_data, m_capacity);
+    }
+    m_pool = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_capacity = 0;
+}
+
+StagingPool::StagingPool(size_t retainedBudget)
+    : m_retainedBudget(retainedBudget)
+{
+}
+
+StagingPool::~StagingPool()
+{
+    trim();
+}
+
+StagingPool &StagingPool::getInstance()
+{
+    static StagingPool instance;
+    return instance;
+}
+
+StagingBuffer StagingPool::acquire(size_t size)
+{
+    size_t capacity = (std::max<size_t>(size, 1) + GRANULARITY - 1) / GRANULARITY * GRANULARITY;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // smallest block that fits, but never more than twice the request
+        auto it = m_freeBlocks.lower_bound(capacity);
+        if (it != m_freeBlocks.end() && it->first <= capacity * 2)
+        {
+            StagingBuffer buffer(this, it->second, size, it->first);
+            m_retainedBytes -= it->first;
+            m_freeBlocks.erase(it);
+            return buffer;
+        }
+    }
+    return StagingBuffer(this, allocateAligned(capacity), size, capacity);
+}
+
+void StagingPool::release(uint8_t *data, size_t capacity)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_retainedBytes + capacity <= m_retainedBudget)
+        {
+            m_freeBlocks.emplace(capacity, data);
+            m_retainedBytes += capacity;
+            return;
+        }
+    }
+    freeAligned(data);
+}
+
+size_t StagingPool::getRetainedBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_retainedBytes;
+}
+
+void StagingPool::trim()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &[capacity, data] : m_freeBlocks)
+    {
+        freeAligned(data);
+    }
+    m_freeBlocks.clear();
+    m_retainedBytes = 0;
+}
@@ -0,0 +1,149 @@
+#include "utils/thread_pool.h"
+#include <algorithm>
+#include <exception>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+    : m_isStopping(false)
+{
+    if (threadCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1; // leave one core for the calling thread
+    }
+
+    m_workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        m_workers.emplace_back([this]()
+                               { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_condition.notify_all();
+
+    for (auto &worker : m_workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+}
+
+ThreadPool &ThreadPool::getInstance()
+{
+    static ThreadPool instance;
+    return instance;
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)> &fn)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    grainSize = std::max<size_t>(grainSize, 1);
+    size_t maxChunks = static_cast<size_t>(getThreadCount()) + 1;
+    size_t chunkCount = std::min(maxChunks, (count + grainSize - 1) / grainSize);
+    if (chunkCount <= 1)
+    {
+        fn(0, count);
+        return;
+    }
+
+    struct SharedState
+    {
+        std::atomic<size_t> nextChunk{0};
+        std::atomic<size_t> finishedChunks{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr exception;
+    };
+    auto state = std::make_shared<SharedState>();
+    size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    // every participant pulls chunks until none are left, so helpers that start late simply return
+    auto runChunks = [state, &fn, count, chunkSize, chunkCount]()
+    {
+        size_t chunk;
+        while ((chunk = state->nextChunk.fetch_add(1)) < chunkCount)
+        {
+            size_t begin = chunk * chunkSize;
+            size_t end = std::min(count, begin + chunkSize);
+            try
+            {
+                if (begin < end)
+                {
+                    fn(begin, end);
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!state->exception)
+                {
+                    state->exception = std::current_exception();
+                }
+            }
+
+            if (state->finishedChunks.fetch_add(1) + 1 == chunkCount)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    for (size_t i = 1; i < chunkCount; ++i)
+    {
+        enqueue(runChunks);
+    }
+    runChunks();
+
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&state, chunkCount]()
+                             { return state->finishedChunks.load() == chunkCount; });
+    }
+
+    if (state->exception)
+    {
+        std::rethrow_exception(state->exception);
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push(std::move(task));
+    }
+    m_condition.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]()
+                             { return m_isStopping || !m_tasks.empty(); });
+            if (m_isStopping && m_tasks.empty())
+            {
+                return;
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+        task();
+    }
+}
@@ -0,0 +1,305 @@
+#include "utils/tlsf_allocator.h"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <string>
+
+TlsfAllocator::TlsfAllocator(uint32_t capacity)
+    : m_capacity(capacity), m_firstBlock(INVALID_HANDLE), m_flBitmap(0), m_slBitmaps(), m_freeHeads()
+{
+    if (capacity == 0)
+    {
+        throw std::runtime_error("TlsfAllocator::TlsfAllocator: capacity must not be zero");
+    }
+    std::fill(&m_freeHeads[0][0], &m_freeHeads[0][0] + FL_COUNT * SL_COUNT, INVALID_HANDLE);
+
+    m_firstBlock = createBlock(0, capacity);
+    insertFree(m_firstBlock);
+}
+
+void TlsfAllocator::mapping(uint32_t size, uint32_t &fl, uint32_t &sl)
+{
+    if (size < SL_COUNT)
+    {
+        // linear below the first power of two that can be subdivided
+        fl = 0;
+        sl = size;
+        return;
+    }
+    uint32_t msb = static_cast<uint32_t>(std::bit_width(size)) - 1;
+    fl = msb - SL_BITS + 1;
+    sl = (size >> (msb - SL_BITS)) - SL_COUNT;
+}
+
+uint32_t TlsfAllocator::createBlock(uint32_t offset, uint32_t size)
+{
+    uint32_t index;
+    if (!m_unusedBlocks.empty())
+    {
+        index = m_unusedBlocks.back();
+        m_unusedBlocks.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_blocks.size());
+        m_blocks.emplace_back();
+    }
+
+    Block &block = m_blocks[index];
+    block = Block();
+    block.offset = offset;
+    block.size = size;
+    block.isUsed = true;
+    return index;
+}
+
+void TlsfAllocator::releaseBlock(uint32_t index)
+{
+    m_blocks[index].isUsed = false;
+    m_unusedBlocks.push_back(index);
+}
+
+void TlsfAllocator::insertFree(uint32_t index)
+{
+    Block &block = m_blocks[index];
+    uint32_t fl, sl;
+    mapping(block.size, fl, sl);
+
+    block.isFree = true;
+    block.prevFree = INVALID_HANDLE;
+    block.nextFree = m_freeHeads[fl][sl];
+    if (block.nextFree != INVALID_HANDLE)
+    {
+        m_blocks[block.nextFree].prevFree = index;
+    }
+    m_freeHeads[fl][sl] = index;
+    m_flBitmap |= 1u << fl;
+    m_slBitmaps[fl] |= 1u << sl;
+}
+
+void TlsfAllocator::removeFree(uint32_t index)
+{
+    Block &block = m_blocks[index];
+    uint32_t fl, sl;
+    mapping(block.size, fl, sl);
+
+    if (block.prevFree != INVALID_HANDLE)
+    {
+        m_blocks[block.prevFree].nextFree = block.nextFree;
+    }
+    else
+    {
+        m_freeHeads[fl][sl] = block.nextFree;
+    }
+    if (block.nextFree != INVALID_HANDLE)
+    {
+        m_blocks[block.nextFree].prevFree = block.prevFree;
+    }
+
+    if (m_freeHeads[fl][sl] == INVALID_HANDLE)
+    {
+        m_slBitmaps[fl] &= ~(1u << sl);
+        if (m_slBitmaps[fl] == 0)
+        {
+            m_flBitmap &= ~(1u << fl);
+        }
+    }
+    block.isFree = false;
+    block.prevFree = INVALID_HANDLE;
+    block.nextFree = INVALID_HANDLE;
+}
+
+uint32_t TlsfAllocator::findFree(uint32_t size) const
+{
+    // round up to the next list, so any block found there fits without walking the list
+    uint64_t rounded = size;
+    if (size >= SL_COUNT)
+    {
+        uint32_t msb = static_cast<uint32_t>(std::bit_width(size)) - 1;
+        rounded += (1ull << (msb - SL_BITS)) - 1;
+    }
+
+    if (rounded <= UINT32_MAX)
+    {
+        uint32_t fl, sl;
+        mapping(static_cast<uint32_t>(rounded), fl, sl);
+        uint32_t slMap = m_slBitmaps[fl] & (~0u << sl);
+        if (slMap == 0)
+        {
+            uint32_t flMap = fl + 1 < 32 ? m_flBitmap & (~0u << (fl + 1)) : 0;
+            if (flMap != 0)
+            {
+                fl = static_cast<uint32_t>(std::countr_zero(flMap));
+                slMap = m_slBitmaps[fl];
+            }
+        }
+        if (slMap != 0)
+        {
+            return m_freeHeads[fl][std::countr_zero(slMap)];
+        }
+    }
+
+    // nearly full: a block of the request's own list may still fit exactly
+    uint32_t fl, sl;
+    mapping(size, fl, sl);
+    for (uint32_t index = m_freeHeads[fl][sl]; index != INVALID_HANDLE; index = m_blocks[index].nextFree)
+    {
+        if (m_blocks[index].size >= size)
+        {
+            return index;
+        }
+    }
+    return INVALID_HANDLE;
+}
+
+uint32_t TlsfAllocator::allocate(uint32_t size)
+{
+    size = std::max(size, 1u);
+    uint32_t index = findFree(size);
+    if (index == INVALID_HANDLE)
+    {
+        return INVALID_HANDLE;
+    }
+    removeFree(index);
+
+    if (m_blocks[index].size > size)
+    {
+        // the remainder stays free behind the allocation
+        uint32_t remainder = createBlock(m_blocks[index].offset + size, m_blocks[index].size - size);
+        Block &block = m_blocks[index];
+        m_blocks[remainder].prevPhysical = index;
+        m_blocks[remainder].nextPhysical = block.nextPhysical;
+        if (block.nextPhysical != INVALID_HANDLE)
+        {
+            m_blocks[block.nextPhysical].prevPhysical = remainder;
+        }
+        block.nextPhysical = remainder;
+        block.size = size;
+        insertFree(remainder);
+    }
+    return index;
+}
+
+void TlsfAllocator::mergeWithNext(uint32_t index)
+{
+    uint32_t next = m_blocks[index].nextPhysical;
+    Block &block = m_blocks[index];
+    block.size += m_blocks[next].size;
+    block.nextPhysical = m_blocks[next].nextPhysical;
+    if (block.nextPhysical != INVALID_HANDLE)
+    {
+        m_blocks[block.nextPhysical].prevPhysical = index;
+    }
+    releaseBlock(next);
+}
+
+void TlsfAllocator::free(uint32_t handle)
+{
+    if (handle >= m_blocks.size() || !m_blocks[handle].isUsed || m_blocks[handle].isFree)
+    {
+        throw std::runtime_error("TlsfAllocator::free: invalid handle " + std::to_string(handle));
+    }
+
+    // coalesce with free neighbours, the lower block always survives
+    uint32_t next = m_blocks[handle].nextPhysical;
+    if (next != INVALID_HANDLE && m_blocks[next].isFree)
+    {
+        removeFree(next);
+        mergeWithNext(handle);
+    }
+    uint32_t prev = m_blocks[handle].prevPhysical;
+    if (prev != INVALID_HANDLE && m_blocks[prev].isFree)
+    {
+        removeFree(prev);
+        mergeWithNext(prev);
+        handle = prev;
+    }
+    insertFree(handle);
+}
+
+TlsfAllocator::Stats TlsfAllocator::getStats() const
+{
+    Stats stats;
+    stats.capacity = m_capacity;
+    for (uint32_t index = m_firstBlock; index != INVALID_HANDLE; index = m_blocks[index].nextPhysical)
+    {
+        const Block &block = m_blocks[index];
+        if (block.isFree)
+        {
+            stats.freeSize += block.size;
+            stats.largestFreeBlock = std::max(stats.largestFreeBlock, block.size);
+            ++stats.freeBlockCount;
+        }
+        else
+        {
+            stats.usedSize += block.size;
+            ++stats.allocationCount;
+        }
+    }
+    stats.fragmentation = stats.freeSize > 0 ? 1.f - static_cast<float>(stats.largestFreeBlock) / stats.freeSize : 0.f;
+    return stats;
+}
+
+std::vector<TlsfAllocator::Move> TlsfAllocator::compact()
+{
+    std::vector<uint32_t> allocations;
+    for (uint32_t index = m_firstBlock; index != INVALID_HANDLE;)
+    {
+        uint32_t next = m_blocks[index].nextPhysical;
+        if (m_blocks[index].isFree)
+        {
+            releaseBlock(index);
+        }
+        else
+        {
+            allocations.push_back(index);
+        }
+        index = next;
+    }
+
+    m_flBitmap = 0;
+    std::fill(m_slBitmaps, m_slBitmaps + FL_COUNT, 0u);
+    std::fill(&m_freeHeads[0][0], &m_freeHeads[0][0] + FL_COUNT * SL_COUNT, INVALID_HANDLE);
+
+    std::vector<Move> moves;
+    uint32_t offset = 0;
+    uint32_t prev = INVALID_HANDLE;
+    m_firstBlock = INVALID_HANDLE;
+    for (uint32_t index : allocations)
+    {
+        Block &block = m_blocks[index];
+        if (block.offset != offset)
+        {
+            moves.push_back({index, block.offset, offset, block.size});
+            block.offset = offset;
+        }
+        block.prevPhysical = prev;
+        block.nextPhysical = INVALID_HANDLE;
+        if (prev != INVALID_HANDLE)
+        {
+            m_blocks[prev].nextPhysical = index;
+        }
+        else
+        {
+            m_firstBlock = index;
+        }
+        prev = index;
+        offset += block.size;
+    }
+
+    if (offset < m_capacity)
+    {
+        uint32_t tail = createBlock(offset, m_capacity - offset);
+        m_blocks[tail].prevPhysical = prev;
+        if (prev != INVALID_HANDLE)
+        {
+            m_blocks[prev].nextPhysical = tail;
+        }
+        else
+        {
+            m_firstBlock = tail;
+        }
+        insertFree(tail);
+    }
+    return moves;
+}
@@ -14,4 +14,7 @@ protected:
     // void onGraphicsUpdate(float deltaTime) override;
     void onLogicUpdate(float deltaTime) override;
     void onInputUpdate(float deltaTime) override;
+
+private:
+    std::shared_ptr<EntityBase> m_skybox;
 };
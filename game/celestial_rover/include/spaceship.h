@@ -56,6 +56,7 @@ private:
     void completeTransition();
 
     void initLandingSettings();
+    float getLandingSurfaceDistance(const std::shared_ptr<CelestialBody> &target, float theta, float phi) const; // raycast against the target's mesh
     // void updateLandingSettingsFromCartesian();
 
     StateContext m_currentState;
@@ -1,7 +1,11 @@
 #include "game_3dbasic.h"
 #include "resources/vertex.h"
+#include "resources/mesh_generator.h"
+#include "resources/geometry_pool.h"
+#include "resources/texture_residency.h"
 #include "celestial_body.h"
 #include "spaceship.h"
+#include <cmath>
 
 Game3DBasic::Game3DBasic(uint32_t width, uint32_t height, const std::string &title)
     : Game(width, height, title) {}
@@ -9,6 +13,7 @@ Game3DBasic::Game3DBasic(uint32_t width, uint32_t height, const std::string &tit
 void Game3DBasic::onCreate()
 {
     auto device = m_graphicsEngine->getDeviceManager()->getDevice();
+    Mesh::setDefaultResidency(MeshResidency::Discard); // only the landing raycasts read geometry back on the CPU
 
     // test entity
     // std::vector<Vertex> vertices = {
@@ -19,26 +24,59 @@ void Game3DBasic::onCreate()
     // std::vector<uint32_t> indices = {0, 1, 2};
     // auto meshTriangle = std::make_shared<Mesh>(device, vertices, indices, "lambertian_red"); // mesh: triangle
 
-    // init material
+    // init assets: files are read, compiled, decoded and parsed concurrently on the ThreadPool, the device objects
+    // are created here as each one finishes while the window presents loading frames
 
     // (shader)
-    auto shaderBase = std::make_shared<Shader>(device, L"engine/assets/shader/vs_base.hlsl", L"engine/assets/shader/ps_base.hlsl", Vertex::inputLayout, Vertex::numElements);
-    auto shaderSkybox = std::make_shared<Shader>(device, L"engine/assets/shader/vs_skybox.hlsl", L"engine/assets/shader/ps_skybox.hlsl", Vertex::inputLayout, Vertex::numElements);
+    auto shaderBaseLoad = m_gameResourceManager->loadShaderAsync(L"engine/assets/shader/vs_base.hlsl", L"engine/assets/shader/ps_base.hlsl", Vertex::inputLayout, Vertex::numElements);
+    auto shaderCompactLoad = m_gameResourceManager->loadShaderAsync(L"engine/assets/shader/vs_compact.hlsl", L"engine/assets/shader/ps_base.hlsl", CompactVertex::inputLayout, CompactVertex::numElements);
+    auto shaderSkyboxLoad = m_gameResourceManager->loadShaderAsync(L"engine/assets/shader/vs_skybox_cube.hlsl", L"engine/assets/shader/ps_skybox_cube.hlsl", Vertex::inputLayout, Vertex::numElements);
+
+    // (texture) the planet maps share size and format, so one array serves both; the moon's loads lazily below.
+    // Progressive: the first frame draws with 64px mip tails, full chains stream in largest on screen first
+    auto texturesLoad = m_gameResourceManager->loadTexturePackAsync({"engine/assets/texture/checker.png",
+                                                                     "engine/assets/texture/checker-map_tho.png",
+                                                                     "game/celestial_rover/assets/texture/sun.png",
+                                                                     "game/celestial_rover/assets/texture/earth.png"},
+                                                                    {}, TextureCompression::Auto, TextureLoading::Progressive);
+    // the galaxy panorama becomes a cube map sized for the window
+    auto galaxyLoad = m_gameResourceManager->loadCubemapAsync("game/celestial_rover/assets/texture/galaxy.png", m_window->getHeight(), CameraBase::DEFAULT_FOV);
+
+    // (mesh)
+    auto meshSpaceShipLoad = m_gameResourceManager->loadMeshAsync("game/celestial_rover/assets/mesh/spaceship.obj", "spaceship");
+    auto meshCubeLoad = m_gameResourceManager->loadMeshAsync("game/celestial_rover/assets/mesh/cube.obj", "cube");
+
+    // the sphere is generated, built on this thread while the files load
+    MeshOptions sphereOptions;
+    sphereOptions.vertexFormat = VertexFormat::Compact;
+    sphereOptions.buildMeshlets = true;
+    sphereOptions.residency = MeshResidency::PositionsOnly; // built from memory, Spaceship landing needs its BVH
+    std::vector<Vertex> sphereVertices;
+    std::vector<uint32_t> sphereIndices;
+    std::vector<MeshLod> sphereLods;
+    MeshGenerator::createIcosphereLods(5, 4, 1.f, sphereVertices, sphereIndices, sphereLods); // 20480 .. 320 triangles
+    auto meshSphere = std::make_shared<Mesh>(device, sphereVertices, sphereIndices, sphereLods, "sphere", sphereOptions);
+
+    m_gameResourceManager->waitForLoads([this]()
+                                        { presentLoadingFrame(); });
+    auto shaderBase = shaderBaseLoad.get();
+    auto shaderCompact = shaderCompactLoad.get();
+    auto shaderSkybox = shaderSkyboxLoad.get();
+    auto textures = texturesLoad.get();
+    auto galaxy = galaxyLoad.get();
+    auto meshSpaceShip = meshSpaceShipLoad.get();
+    auto meshCube = meshCubeLoad.get();
 
     // (material)
-    std::shared_ptr<MaterialBase> matLambertianGrey = std::make_shared<LambertianMaterial>(device, shaderBase, DirectX::XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f));
-    std::shared_ptr<MaterialBase> matLambertianChecker1 = std::make_shared<LambertianMaterial>(device, shaderBase, "engine/assets/texture/checker.png");
-    std::shared_ptr<MaterialBase> matLambertianChecker2 = std::make_shared<LambertianMaterial>(device, shaderBase, "engine/assets/texture/checker-map_tho.png");
-    std::shared_ptr<MaterialBase> matLambertianSun = std::make_shared<LambertianMaterial>(device, shaderBase, "game/celestial_rover/assets/texture/sun.png");
-    std::shared_ptr<MaterialBase> matLambertianEarth = std::make_shared<LambertianMaterial>(device, shaderBase, "game/celestial_rover/assets/texture/earth.png");
-    std::shared_ptr<MaterialBase> matLambertianMoon = std::make_shared<LambertianMaterial>(device, shaderBase, "game/celestial_rover/assets/texture/moon.png");
-    std::shared_ptr<MaterialBase> matSkybox = std::make_shared<LambertianMaterial>(device, shaderSkybox, "game/celestial_rover/assets/texture/galaxy.png");
-
-    // init mesh
-
-    auto meshSpaceShip = std::make_shared<Mesh>(device, "game/celestial_rover/assets/mesh/spaceship.obj", "spaceship");
-    auto meshSphere = std::make_shared<Mesh>(device, "game/celestial_rover/assets/mesh/sphere.obj", "sphere");
-    auto meshCube = std::make_shared<Mesh>(device, "game/celestial_rover/assets/mesh/cube.obj", "cube");
+    std::shared_ptr<MaterialBase> matLambertianGrey = m_gameResourceManager->loadMaterial(shaderBase, DirectX::XMFLOAT4(0.5f, 0.5f, 0.5f, 1.0f));
+    std::shared_ptr<MaterialBase> matLambertianChecker1 = m_gameResourceManager->loadMaterial(shaderBase, textures[0]);
+    std::shared_ptr<MaterialBase> matLambertianChecker2 = m_gameResourceManager->loadMaterial(shaderBase, textures[1]);
+    std::shared_ptr<MaterialBase> matLambertianSun = m_gameResourceManager->loadMaterial(shaderCompact, textures[2]);
+    std::shared_ptr<MaterialBase> matLambertianEarth = m_gameResourceManager->loadMaterial(shaderCompact, textures[3]);
+    // the moon is grey until it first comes into view or within the lazy load distance, then loads in the background
+    auto matLambertianMoon = m_gameResourceManager->loadMaterialLazy(shaderCompact, "game/celestial_rover/assets/texture/moon.png",
+                                                                     m_gameResourceManager->loadMaterial(shaderCompact, DirectX::XMFLOAT4(0.6f, 0.6f, 0.6f, 1.0f)));
+    std::shared_ptr<MaterialBase> matSkybox = m_gameResourceManager->loadMaterial(shaderSkybox, galaxy);
 
     // init render component
 
@@ -48,6 +86,8 @@ void Game3DBasic::onCreate()
     auto compSpaceShip = std::make_shared<RenderComponent>(meshSpaceShip, matLambertianGrey);
     auto compSkybox = std::make_shared<RenderComponent>(meshCube, matSkybox);
 
+    m_gameResourceManager->setLazyLoadDistance(100.f);
+
     // init entities
 
     // (orbit)
@@ -86,12 +126,26 @@ void Game3DBasic::onCreate()
     shipEarthOrbit->setTransferSpeed(0.5f);
     shipEarthOrbit->setState(Spaceship::State::Orbiting, entityEarth, orbitShipEarth);
 
-    // (skybox)
+    // (skybox) drawn at infinity by vs_skybox_cube, the unit cube follows the camera only to stay inside the frustum
     compSkybox->setIsCullFront(false);
     auto entitySkybox = std::make_shared<EntityBase>(device);
     entitySkybox->addRenderComponent(compSkybox);
     entitySkybox->setLocalPosition(DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f));
-    entitySkybox->setLocalScale(DirectX::XMFLOAT3(5000.0f, 5000.0f, 5000.0f));
+    m_skybox = entitySkybox;
+
+    // (beacons) fixed scenery around the sun; static, so each checker material's cubes draw as one StaticBatch
+    std::vector<std::shared_ptr<EntityBase>> entityBeacons;
+    for (int i = 0; i < 8; ++i)
+    {
+        float angle = DirectX::XM_2PI * i / 8.f;
+        auto compBeacon = std::make_shared<RenderComponent>(meshCube, i % 2 == 0 ? matLambertianChecker1 : matLambertianChecker2);
+        auto entityBeacon = std::make_shared<EntityBase>(device);
+        entityBeacon->addRenderComponent(compBeacon);
+        entityBeacon->setLocalPosition(DirectX::XMFLOAT3(500.f + 90.f * std::cos(angle), 500.f, 500.f + 90.f * std::sin(angle)));
+        entityBeacon->setLocalScale(DirectX::XMFLOAT3(3.f, 3.f, 3.f));
+        entityBeacon->setIsStatic(true);
+        entityBeacons.push_back(entityBeacon);
+    }
 
     // init light
 
@@ -104,6 +158,10 @@ void Game3DBasic::onCreate()
     m_gameResourceManager->registerStaticEntity(entityMoon);
     m_gameResourceManager->registerControllableEntity(shipEarthOrbit);
     m_gameResourceManager->registerStaticEntity(entitySkybox);
+    for (auto &entityBeacon : entityBeacons)
+    {
+        m_gameResourceManager->registerStaticEntity(entityBeacon);
+    }
     m_gameResourceManager->registerLight(light);
 
     m_controlledEntity = m_gameResourceManager->getControllableEntity(shipEarthOrbit->getId());
@@ -121,7 +179,10 @@ void Game3DBasic::onCreate()
 
     m_gameResourceManager->rebuildRootEntities();
     m_gameResourceManager->initLightArrayBuffer(device);
-
+    Mesh::logMemoryReport();
+    GeometryPool::getInstance().logStats();
+    TextureResidency::getInstance().logStats();
+    m_gameResourceManager->logAssetStats();
 }
 
 void Game3DBasic::onLogicUpdate(float deltaTime)
@@ -140,6 +201,11 @@ void Game3DBasic::onLogicUpdate(float deltaTime)
     {
         light->setPosition(entitySun->getWorldPosition());
     }
+
+    // keep the skybox around the camera
+    DirectX::XMFLOAT3 cameraPosition;
+    m_activeCamera->getPosition(cameraPosition);
+    m_skybox->setLocalPosition(cameraPosition);
 }
 
 void Game3DBasic::onInputUpdate(float deltaTime)
@@ -265,5 +265,39 @@ void Spaceship::initLandingSettings()
 
     m_nextState.landingPhi = phi;
     m_nextState.landingTheta = theta;
-    m_nextState.landingRadius = m_nextState.target->getRadius() + m_localScale.y; // suppose the original model ranging [-1, 1] in y direction
+    m_nextState.landingRadius = getLandingSurfaceDistance(m_nextState.target, theta, phi) + m_localScale.y; // suppose the original model ranging [-1, 1] in y direction
+}
+
+float Spaceship::getLandingSurfaceDistance(const std::shared_ptr<CelestialBody> &target, float theta, float phi) const
+{
+    auto components = target->getRenderComponents();
+    const MeshBvh *bvh = components.empty() ? nullptr : components[0]->getMesh()->getBvh();
+    if (!bvh)
+    {
+        return target->getRadius(); // perfect sphere
+    }
+
+    // landing direction as calculatePositionForState places it, cast from outside the mesh towards its center
+    DirectX::XMFLOAT3 offset = sphericalToCartesian(1.f, theta, phi);
+    DirectX::XMVECTOR worldDirection = DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&offset), target->getWorldRotationMatrix());
+    DirectX::XMMATRIX worldMatrix = target->getWorldMatrix();
+    DirectX::XMMATRIX objectMatrix = DirectX::XMMatrixInverse(nullptr, worldMatrix);
+    DirectX::XMVECTOR direction = DirectX::XMVector3Normalize(DirectX::XMVector3TransformNormal(worldDirection, objectMatrix));
+
+    const MeshBounds &bounds = components[0]->getMesh()->getBounds();
+    float reach = 2.f * (DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMLoadFloat3(&bounds.sphereCenter))) + bounds.sphereRadius);
+    MeshBvh::Ray ray;
+    DirectX::XMStoreFloat3(&ray.origin, DirectX::XMVectorScale(direction, reach));
+    DirectX::XMStoreFloat3(&ray.direction, DirectX::XMVectorNegate(direction));
+    ray.tMax = reach;
+
+    MeshBvh::Hit hit;
+    if (!bvh->intersect(ray, hit))
+    {
+        return target->getRadius();
+    }
+    DirectX::XMVECTOR surface = DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&ray.origin), DirectX::XMVectorScale(DirectX::XMLoadFloat3(&ray.direction), hit.t));
+    surface = DirectX::XMVector3TransformCoord(surface, worldMatrix);
+    DirectX::XMFLOAT3 targetPos = target->getWorldPosition();
+    return DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(surface, DirectX::XMLoadFloat3(&targetPos))));
 }
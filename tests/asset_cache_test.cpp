@@ -0,0 +1,153 @@
+#include "test_common.h"
+#include "resources/asset_cache.h"
+#include "utils/hash.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// Path normalization, file content hashes and the cache's name and content lookups; files go to a scratch
+// working directory
+namespace
+{
+    void writeFile(const std::string &path, const std::string &bytes)
+    {
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << bytes;
+    }
+
+    void enterScratchDirectory()
+    {
+        std::filesystem::path scratch = std::filesystem::temp_directory_path() / "asset_cache_test";
+        std::filesystem::current_path(std::filesystem::temp_directory_path());
+        std::filesystem::remove_all(scratch);
+        std::filesystem::create_directories(scratch);
+        std::filesystem::current_path(scratch);
+    }
+
+    void normalizesPaths()
+    {
+        enterScratchDirectory();
+        std::string expected = (std::filesystem::current_path() / "assets" / "mesh.obj").generic_string();
+        CHECK(normalizeAssetPath("assets/mesh.obj") == expected);
+        CHECK(normalizeAssetPath("./assets/../assets/./mesh.obj") == expected);
+        CHECK(normalizeAssetPath(std::filesystem::current_path() / "assets" / "mesh.obj") == expected);
+        CHECK(normalizeAssetPath("assets/mesh.obj") != normalizeAssetPath("assets/other.obj"));
+    }
+
+    void hashesFileContents()
+    {
+        enterScratchDirectory();
+        writeFile("a/texture.png", "the same bytes");
+        writeFile("b/copy.png", "the same bytes");
+        writeFile("c/texture.png", "other bytes");
+
+        std::string bytes = "the same bytes";
+        CHECK(hashAssetFile("a/texture.png", FNV_OFFSET_BASIS) == hashBytes(bytes.data(), bytes.size()));
+        CHECK(hashAssetFile("a/texture.png", 1) == hashAssetFile("b/copy.png", 1));
+        CHECK(hashAssetFile("a/texture.png", 1) != hashAssetFile("c/texture.png", 1));
+        // the seed carries load options: the same file under other options is other content
+        CHECK(hashAssetFile("a/texture.png", 1) != hashAssetFile("a/texture.png", 2));
+        CHECK_THROWS(hashAssetFile("missing.png", 1));
+    }
+
+    void findsAssetsByNameAndContent()
+    {
+        AssetCache<std::string> cache([](const std::string &asset) { return asset.size(); });
+        int keyCalls = 0, createCalls = 0;
+        auto load = [&](const std::string &name, uint64_t contentKey)
+        {
+            return cache.load(name, [&]()
+                              { ++keyCalls; return contentKey; },
+                              [&]()
+                              { ++createCalls; return std::make_shared<std::string>(name); });
+        };
+
+        std::shared_ptr<std::string> a = load("a", 1);
+        CHECK(a != nullptr && *a == "a");
+        // a known name neither hashes nor creates
+        CHECK(load("a", 1) == a);
+        CHECK(keyCalls == 1 && createCalls == 1);
+        // a new name with known content shares the asset
+        std::shared_ptr<std::string> b = load("b", 1);
+        CHECK(b == a);
+        CHECK(keyCalls == 2 && createCalls == 1);
+        std::shared_ptr<std::string> c = load("c", 2);
+        CHECK(c != a && createCalls == 2);
+        CHECK(cache.find("b") == a);
+        CHECK(cache.find("d") == nullptr);
+
+        AssetCacheStats stats = cache.getStats();
+        CHECK(stats.hits == 1 && stats.contentHits == 1 && stats.misses == 2);
+        CHECK(stats.assetCount == 2 && stats.nameCount == 3);
+        CHECK_EQ(stats.residentBytes, size_t(2));
+
+        // without a content key the name is the key: equal names only
+        std::shared_ptr<std::string> named = cache.load("lambertian|1", {}, []() { return std::make_shared<std::string>("material"); });
+        CHECK(cache.load("lambertian|1", {}, []() { return std::make_shared<std::string>("other"); }) == named);
+        CHECK(cache.load("lambertian|2", {}, []() { return std::make_shared<std::string>("other"); }) != named);
+    }
+
+    void unloadsWithTheLastHandle()
+    {
+        AssetCache<int> cache;
+        std::shared_ptr<int> a = cache.load("a", []() { return uint64_t(7); }, []() { return std::make_shared<int>(1); });
+        std::shared_ptr<int> b = cache.load("b", []() { return uint64_t(7); }, []() { return std::make_shared<int>(2); });
+        CHECK(a == b);
+        a.reset();
+        CHECK(cache.find("a") == b);
+        b.reset();
+        CHECK(cache.find("a") == nullptr && cache.find("b") == nullptr);
+        AssetCacheStats stats = cache.getStats();
+        CHECK(stats.unloads == 1 && stats.assetCount == 0 && stats.nameCount == 0);
+
+        // loaded again under the same content, created anew
+        std::shared_ptr<int> again = cache.load("b", []() { return uint64_t(7); }, []() { return std::make_shared<int>(3); });
+        CHECK(again != nullptr && *again == 3);
+        CHECK(cache.tryLoad("b") == again);
+        CHECK_EQ(cache.getStats().hits, uint64_t(1));
+
+        // a failed create caches nothing
+        CHECK(cache.load("c", {}, []() { return std::shared_ptr<int>(); }) == nullptr);
+        CHECK(cache.find("c") == nullptr);
+
+        // handles outlive the cache
+        std::shared_ptr<int> survivor;
+        {
+            AssetCache<int> scoped;
+            survivor = scoped.load("s", {}, []() { return std::make_shared<int>(4); });
+        }
+        CHECK(*survivor == 4);
+        survivor.reset();
+    }
+
+    void sharesFilesUnderOtherPaths()
+    {
+        // the manager's pattern: normalized path plus options as the name, the file hash seeded with the options as content
+        enterScratchDirectory();
+        writeFile("textures/rock.png", "rock");
+        writeFile("copies/rock.png", "rock");
+        AssetCache<int> cache;
+        int createCalls = 0;
+        auto load = [&](const std::string &path, uint64_t optionsKey)
+        {
+            return cache.load(normalizeAssetPath(path) + "|" + std::to_string(optionsKey), [&]() { return hashAssetFile(path, optionsKey); },
+                              [&]() { ++createCalls; return std::make_shared<int>(createCalls); });
+        };
+        std::shared_ptr<int> rock = load("textures/rock.png", 1);
+        CHECK(load("textures/../textures/rock.png", 1) == rock);
+        CHECK(load("copies/rock.png", 1) == rock);
+        CHECK(load("textures/rock.png", 2) != rock);
+        CHECK_EQ(createCalls, 2);
+        CHECK(cache.getStats().hits == 1 && cache.getStats().contentHits == 1);
+    }
+}
+
+int main()
+{
+    return Test::run({{"normalizesPaths", normalizesPaths},
+                      {"hashesFileContents", hashesFileContents},
+                      {"findsAssetsByNameAndContent", findsAssetsByNameAndContent},
+                      {"unloadsWithTheLastHandle", unloadsWithTheLastHandle},
+                      {"sharesFilesUnderOtherPaths", sharesFilesUnderOtherPaths}});
+}
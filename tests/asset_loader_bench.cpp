@@ -0,0 +1,72 @@
+#include "test_common.h"
+#include "resources/asset_loader.h"
+#include "resources/block_compressor.h"
+#include "resources/mesh_optimizer.h"
+#include "resources/mip_generator.h"
+#include "resources/obj_parser.h"
+#include "resources/png_decoder.h"
+#include "utils/mapped_file.h"
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// The startup set's CPU work as AssetLoader prepare steps: OBJ parse and indexing, PNG decode, mips and BC1 for
+// the textures. Create steps do nothing, there is no device. Wall time per loader thread count; the steps' own
+// parallelFor still runs on the shared ThreadPool, as it does in the engine.
+int main()
+{
+    Test::benchmarkHeader("asset_loader");
+    const char *meshes[] = {"game/celestial_rover/assets/mesh/cube.obj", "game/celestial_rover/assets/mesh/sphere.obj",
+                            "game/celestial_rover/assets/mesh/spaceship.obj"};
+    const char *textures[] = {"engine/assets/texture/checker.png", "engine/assets/texture/checker-map_tho.png",
+                              "game/celestial_rover/assets/texture/galaxy.png"};
+
+    auto loadAll = [&](AssetLoader &loader)
+    {
+        for (const char *mesh : meshes)
+        {
+            loader.load([mesh]()
+                        {
+                MappedFile file(Test::sourcePath(mesh));
+                std::vector<Vertex> vertices;
+                std::vector<uint32_t> indices;
+                MeshOptimizer::indexCorners(ObjParser::parse(file.data(), file.end()), vertices, indices);
+                MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+                return indices.size(); },
+                        [](ID3D11Device *, size_t &indexCount) { return indexCount; });
+        }
+        for (const char *texture : textures)
+        {
+            loader.load([texture]()
+                        {
+                DecodedImage image = PngDecoder::decode(Test::sourcePath(texture));
+                size_t bytes = 0;
+                for (const MipLevel &level : MipGenerator::generate(image.pixels.data(), image.width, image.height, image.width * 4, image.isSrgb))
+                {
+                    bytes += BlockCompressor::compress(BlockFormat::BC1, level.pixels.data(), level.width, level.height).size();
+                }
+                return bytes; },
+                        [](ID3D11Device *, size_t &bytes) { return bytes; });
+        }
+        loader.wait();
+    };
+
+    const int repeats = 3;
+    uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    float singleMs = 0.f;
+    for (uint32_t threadCount = 1; threadCount <= maxThreads; ++threadCount)
+    {
+        AssetLoader loader(nullptr, threadCount);
+        float bestWallMs = 1e30f;
+        for (int repeat = 0; repeat < repeats; ++repeat)
+        {
+            loadAll(loader);
+            bestWallMs = std::min(bestWallMs, loader.getStats().wallMs);
+        }
+        singleMs = threadCount == 1 ? bestWallMs : singleMs;
+        AssetLoader::Stats stats = loader.getStats();
+        std::printf("  %2u threads: %8.2f ms wall (%.2fx over 1 thread), %8.2f ms of prepare steps, %u loads\n", threadCount, bestWallMs,
+                    singleMs / bestWallMs, stats.prepareMs / repeats, stats.completed / repeats);
+    }
+    return 0;
+}
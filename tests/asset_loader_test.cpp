@@ -0,0 +1,144 @@
+#include "test_common.h"
+#include "resources/asset_loader.h"
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Create order, failures and draining, without a device: create steps get the loader's null device
+namespace
+{
+    bool isReady(const AssetFuture<int> &future)
+    {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    void createsInSubmissionOrder()
+    {
+        AssetLoader loader(nullptr, 4);
+        std::vector<int> created;
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+
+        // the first load is still preparing, the ones behind it are ready and wait for it
+        std::vector<AssetFuture<int>> futures;
+        futures.push_back(loader.load([opened]() { opened.wait(); return 0; },
+                                      [&](ID3D11Device *, int &value) { created.push_back(value); return value; }));
+        for (int i = 1; i < 8; ++i)
+        {
+            futures.push_back(loader.load([i]() { return i; }, [&](ID3D11Device *, int &value) { created.push_back(value); return value; }));
+        }
+        for (int poll = 0; poll < 20; ++poll)
+        {
+            CHECK_EQ(loader.update(), 0u);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(created.empty() && !isReady(futures.back()));
+        CHECK_EQ(loader.getStats().pending, 8u);
+
+        gate.set_value();
+        loader.wait();
+        CHECK(created == std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7}));
+        for (int i = 0; i < 8; ++i)
+        {
+            CHECK(futures[i].get() == i);
+        }
+
+        // prepare steps finishing in reverse still create in order
+        created.clear();
+        for (int i = 0; i < 6; ++i)
+        {
+            loader.load([i]() { std::this_thread::sleep_for(std::chrono::milliseconds(2 * (6 - i))); return i; },
+                        [&](ID3D11Device *, int &value) { created.push_back(value); return value; });
+        }
+        loader.wait();
+        CHECK(created == std::vector<int>({0, 1, 2, 3, 4, 5}));
+    }
+
+    void failuresReachTheFuture()
+    {
+        AssetLoader loader(nullptr, 2);
+        int createCalls = 0;
+        AssetFuture<int> prepareThrew = loader.load([]() -> int { throw std::runtime_error("prepare"); },
+                                                    [&](ID3D11Device *, int &value) { ++createCalls; return value; });
+        AssetFuture<int> createThrew = loader.load([]() { return 1; },
+                                                   [&](ID3D11Device *, int &) -> int { ++createCalls; throw std::runtime_error("create"); });
+        AssetFuture<int> loaded = loader.load([]() { return 2; }, [&](ID3D11Device *, int &value) { ++createCalls; return value; });
+        loader.wait();
+
+        // a failed prepare never reaches its create step, a failure does not hold up the loads behind it
+        CHECK_EQ(createCalls, 2);
+        std::string prepareMessage, createMessage;
+        try
+        {
+            prepareThrew.get();
+        }
+        catch (const std::runtime_error &e)
+        {
+            prepareMessage = e.what();
+        }
+        try
+        {
+            createThrew.get();
+        }
+        catch (const std::runtime_error &e)
+        {
+            createMessage = e.what();
+        }
+        CHECK(prepareMessage == "prepare" && createMessage == "create");
+        CHECK_EQ(loaded.get(), 2);
+
+        AssetLoader::Stats stats = loader.getStats();
+        CHECK(stats.failed == 2 && stats.completed == 1 && stats.pending == 0);
+    }
+
+    void waitDrainsEverything()
+    {
+        AssetLoader loader(nullptr, 3);
+        std::promise<void> gate;
+        std::shared_future<void> opened = gate.get_future().share();
+        std::vector<AssetFuture<int>> futures;
+        std::vector<AssetFuture<int>> followUps;
+
+        // the prepare steps only finish once wait() polled, and every create step submits one more load
+        for (int i = 0; i < 16; ++i)
+        {
+            futures.push_back(loader.load([opened, i]() { opened.wait(); return i; },
+                                          [&](ID3D11Device *, int &value)
+                                          {
+                followUps.push_back(loader.load([value]() { return value + 100; }, [](ID3D11Device *, int &next) { return next; }));
+                return value; }));
+        }
+        int waits = 0;
+        loader.wait([&]()
+                    {
+            if (waits++ == 0)
+            {
+                gate.set_value();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+
+        CHECK(waits > 0);
+        CHECK(loader.isIdle());
+        CHECK_EQ(followUps.size(), size_t(16));
+        bool allReady = true;
+        for (size_t i = 0; i < futures.size(); ++i)
+        {
+            allReady = allReady && isReady(futures[i]) && isReady(followUps[i]) && followUps[i].get() == static_cast<int>(i) + 100;
+        }
+        CHECK(allReady);
+        AssetLoader::Stats stats = loader.getStats();
+        CHECK(stats.completed == 32 && stats.pending == 0 && stats.threadCount == 3);
+        CHECK(stats.wallMs > 0.f);
+
+        // cache hits are ready without the loader
+        CHECK(isReady(AssetLoader::makeReady(5)) && AssetLoader::makeReady(5).get() == 5);
+    }
+}
+
+int main()
+{
+    return Test::run({{"createsInSubmissionOrder", createsInSubmissionOrder},
+                      {"failuresReachTheFuture", failuresReachTheFuture},
+                      {"waitDrainsEverything", waitDrainsEverything}});
+}
@@ -0,0 +1,36 @@
+#include "test_common.h"
+#include "resources/block_compressor.h"
+#include "resources/png_decoder.h"
+#include "utils/mapped_file.h"
+#include <cstdio>
+
+// Encode megapixels/s and PSNR per texture and format on the PNG assets (level 0 only)
+int main()
+{
+    Test::benchmarkHeader("block_compressor");
+    for (const char *asset : {"engine/assets/texture/checker.png", "engine/assets/texture/checker-map_tho.png",
+                              "game/celestial_rover/assets/texture/galaxy.png"})
+    {
+        MappedFile file(Test::sourcePath(asset));
+        DecodedImage image = PngDecoder::decode(reinterpret_cast<const uint8_t *>(file.data()), file.size(), asset);
+        size_t texelCount = static_cast<size_t>(image.width) * image.height;
+        std::printf("%s: %ux%u, %.1f MB as RGBA8\n", asset, image.width, image.height, texelCount * 4 / 1e6);
+
+        const struct
+        {
+            const char *name;
+            BlockFormat format;
+            bool includeAlpha;
+        } formats[] = {{"BC1", BlockFormat::BC1, false}, {"BC3", BlockFormat::BC3, true}, {"BC7", BlockFormat::BC7, true}};
+        for (const auto &entry : formats)
+        {
+            std::vector<uint8_t> blocks;
+            double ms = Test::bestMs(2, [&]()
+                                     { blocks = BlockCompressor::compress(entry.format, image.pixels.data(), image.width, image.height); });
+            std::vector<uint8_t> decoded = BlockCompressor::decompress(entry.format, blocks.data(), image.width, image.height);
+            std::printf("  %s %9.2f ms %7.1f MP/s  PSNR %.2f dB  %.1f MB\n", entry.name, ms, texelCount / 1e6 / (ms / 1000.0),
+                        BlockCompressor::computePsnr(image.pixels.data(), decoded.data(), texelCount, entry.includeAlpha), blocks.size() / 1e6);
+        }
+    }
+    return 0;
+}
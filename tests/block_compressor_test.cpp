@@ -0,0 +1,171 @@
+#include "test_common.h"
+#include "resources/block_compressor.h"
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    const BlockFormat FORMATS[] = {BlockFormat::BC1, BlockFormat::BC3, BlockFormat::BC7};
+
+    void fillBlock(uint8_t rgba[64], uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            rgba[i * 4] = r;
+            rgba[i * 4 + 1] = g;
+            rgba[i * 4 + 2] = b;
+            rgba[i * 4 + 3] = a;
+        }
+    }
+
+    int maxError(const uint8_t *a, const uint8_t *b, size_t texelCount, bool includeAlpha)
+    {
+        int error = 0;
+        for (size_t i = 0; i < texelCount; ++i)
+        {
+            for (int c = 0; c < (includeAlpha ? 4 : 3); ++c)
+            {
+                error = std::max(error, std::abs(a[i * 4 + c] - b[i * 4 + c]));
+            }
+        }
+        return error;
+    }
+
+    // Smooth color ramps with an alpha ramp and a hard diagonal edge, the content the assets have
+    std::vector<uint8_t> makeImage(uint32_t width, uint32_t height)
+    {
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                uint8_t *texel = pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+                bool isEdge = x > y;
+                texel[0] = static_cast<uint8_t>(255 * x / std::max(width - 1, 1u));
+                texel[1] = static_cast<uint8_t>(255 * y / std::max(height - 1, 1u));
+                texel[2] = isEdge ? 200 : 40;
+                texel[3] = static_cast<uint8_t>(255 - 255 * (x + y) / std::max(width + height - 2, 1u));
+            }
+        }
+        return pixels;
+    }
+
+    void sizesBlocks()
+    {
+        CHECK_EQ(BlockCompressor::getCompressedSize(BlockFormat::BC1, 4, 4), size_t(8));
+        CHECK_EQ(BlockCompressor::getCompressedSize(BlockFormat::BC1, 5, 5), size_t(32));
+        CHECK_EQ(BlockCompressor::getCompressedSize(BlockFormat::BC3, 1, 1), size_t(16));
+        CHECK_EQ(BlockCompressor::getCompressedSize(BlockFormat::BC7, 1024, 512), size_t(256 * 128 * 16));
+    }
+
+    void keepsSolidBlocks()
+    {
+        uint8_t rgba[64], decoded[64], block[16];
+        // exact in 5:6:5; BC7 mode 6 shares one p-bit across an endpoint's channels, so 0 and 255 together are off by one
+        fillBlock(rgba, 255, 0, 255, 255);
+        for (BlockFormat format : FORMATS)
+        {
+            BlockCompressor::encodeBlock(format, rgba, block);
+            BlockCompressor::decodeBlock(format, block, decoded);
+            CHECK_EQ(maxError(rgba, decoded, 16, true), format == BlockFormat::BC7 ? 1 : 0);
+        }
+
+        fillBlock(rgba, 90, 140, 17, 77);
+        for (BlockFormat format : {BlockFormat::BC3, BlockFormat::BC7})
+        {
+            BlockCompressor::encodeBlock(format, rgba, block);
+            BlockCompressor::decodeBlock(format, block, decoded);
+            CHECK(maxError(rgba, decoded, 16, true) <= (format == BlockFormat::BC7 ? 1 : 4));
+        }
+        BlockCompressor::encodeBlock(BlockFormat::BC3, rgba, block);
+        BlockCompressor::decodeBlock(BlockFormat::BC3, block, decoded);
+        CHECK_EQ(static_cast<int>(decoded[3]), 77); // 8-bit alpha endpoints
+    }
+
+    void hitsTwoColorBlocksExactly()
+    {
+        uint8_t rgba[64], decoded[64], block[16];
+        fillBlock(rgba, 0, 0, 0, 255);
+        for (int i = 0; i < 16; i += 3)
+        {
+            rgba[i * 4] = rgba[i * 4 + 1] = rgba[i * 4 + 2] = 255;
+        }
+        for (BlockFormat format : FORMATS)
+        {
+            BlockCompressor::encodeBlock(format, rgba, block);
+            BlockCompressor::decodeBlock(format, block, decoded);
+            CHECK_EQ(maxError(rgba, decoded, 16, true), format == BlockFormat::BC7 ? 1 : 0);
+        }
+    }
+
+    void interpolatesAlpha()
+    {
+        uint8_t rgba[64], decoded[64], block[16];
+        fillBlock(rgba, 128, 128, 128, 0);
+        for (int i = 0; i < 16; ++i)
+        {
+            rgba[i * 4 + 3] = static_cast<uint8_t>(i * 17);
+        }
+        BlockCompressor::encodeBlock(BlockFormat::BC3, rgba, block);
+        BlockCompressor::decodeBlock(BlockFormat::BC3, block, decoded);
+        for (int i = 0; i < 16; ++i)
+        {
+            CHECK(std::abs(decoded[i * 4 + 3] - rgba[i * 4 + 3]) <= 255 / 14);
+        }
+    }
+
+    void compressesImagesWithinPsnr()
+    {
+        // odd sizes: the edge blocks repeat the last row / column, decompress crops them away
+        const uint32_t width = 67, height = 45;
+        std::vector<uint8_t> pixels = makeImage(width, height);
+        const struct
+        {
+            BlockFormat format;
+            double minPsnr;
+            bool includeAlpha;
+        } expectations[] = {{BlockFormat::BC1, 33.0, false}, {BlockFormat::BC3, 33.0, true}, {BlockFormat::BC7, 40.0, true}};
+        for (const auto &expected : expectations)
+        {
+            std::vector<uint8_t> blocks = BlockCompressor::compress(expected.format, pixels.data(), width, height);
+            CHECK_EQ(blocks.size(), BlockCompressor::getCompressedSize(expected.format, width, height));
+            std::vector<uint8_t> decoded = BlockCompressor::decompress(expected.format, blocks.data(), width, height);
+            CHECK_EQ(decoded.size(), pixels.size());
+            double psnr = BlockCompressor::computePsnr(pixels.data(), decoded.data(), size_t(width) * height, expected.includeAlpha);
+            CHECK(psnr >= expected.minPsnr);
+
+            // each block encodes independently of the thread that ran it
+            uint8_t rgba[64], block[16];
+            for (uint32_t y = 0; y < 4; ++y)
+            {
+                for (uint32_t x = 0; x < 4; ++x)
+                {
+                    std::copy_n(pixels.data() + ((8 + y) * width + 12 + x) * 4, 4, rgba + (y * 4 + x) * 4);
+                }
+            }
+            BlockCompressor::encodeBlock(expected.format, rgba, block);
+            size_t blockBytes = BlockCompressor::getBlockBytes(expected.format);
+            CHECK(std::equal(block, block + blockBytes, blocks.data() + (2 * ((width + 3) / 4) + 3) * blockBytes));
+        }
+    }
+
+    void measuresPsnr()
+    {
+        uint8_t a[8] = {10, 20, 30, 40, 50, 60, 70, 80};
+        CHECK(std::isinf(BlockCompressor::computePsnr(a, a, 2, true)));
+        uint8_t b[8] = {11, 20, 30, 40, 50, 60, 70, 99};
+        // alpha only counts when asked: one unit of error over 6 channels
+        CHECK_NEAR(BlockCompressor::computePsnr(a, b, 2, false), 10.0 * std::log10(255.0 * 255.0 * 6.0), 1e-9);
+    }
+}
+
+int main()
+{
+    return Test::run({{"sizesBlocks", sizesBlocks},
+                      {"keepsSolidBlocks", keepsSolidBlocks},
+                      {"hitsTwoColorBlocksExactly", hitsTwoColorBlocksExactly},
+                      {"interpolatesAlpha", interpolatesAlpha},
+                      {"compressesImagesWithinPsnr", compressesImagesWithinPsnr},
+                      {"measuresPsnr", measuresPsnr}});
+}
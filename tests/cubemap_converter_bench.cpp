@@ -0,0 +1,39 @@
+#include "test_common.h"
+#include "resources/cubemap_converter.h"
+#include "resources/png_decoder.h"
+#include "utils/thread_pool.h"
+#include <cstdio>
+
+// Conversion time and output memory per face size, on the galaxy panorama. Throughput counts the six top level
+// faces written; memory is every level of every face as convert() returns it (RGBA8), next to the panorama's own
+int main()
+{
+    Test::benchmarkHeader("cubemap_converter");
+    const char *asset = "game/celestial_rover/assets/texture/galaxy.png";
+    DecodedImage image = PngDecoder::decode(Test::sourcePath(asset));
+    double panoramaMb = image.width * static_cast<double>(image.height) * 4 / 1e6;
+    std::printf("%s: %ux%u %s, %.2f MB RGBA8, on %u threads\n", asset, image.width, image.height, image.isSrgb ? "sRGB" : "linear",
+                panoramaMb, ThreadPool::getInstance().getThreadCount());
+    std::printf("  face size for 1080p at 60 degrees: %u\n", CubemapConverter::getFaceSize(1080, DirectX::XM_PI / 3.f, image.width));
+
+    for (uint32_t faceSize : {128u, 256u, 512u, 1024u})
+    {
+        size_t outputBytes = 0;
+        double ms = Test::bestMs(3, [&]()
+                                 {
+            std::vector<std::vector<MipLevel>> faces = CubemapConverter::convert(image.pixels.data(), image.width, image.height,
+                                                                                 image.width * 4, image.isSrgb, faceSize);
+            outputBytes = 0;
+            for (const std::vector<MipLevel> &levels : faces)
+            {
+                for (const MipLevel &level : levels)
+                {
+                    outputBytes += level.pixels.size();
+                }
+            } });
+        double megapixels = CubemapConverter::FACE_COUNT * static_cast<double>(faceSize) * faceSize / 1e6;
+        std::printf("  %4u: %8.2f ms %8.1f MP/s %8.2f MB out (%.2fx the panorama)\n", faceSize, ms, megapixels / (ms / 1000.0),
+                    outputBytes / 1e6, outputBytes / 1e6 / panoramaMb);
+    }
+    return 0;
+}
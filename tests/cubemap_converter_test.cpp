@@ -0,0 +1,169 @@
+#include "test_common.h"
+#include "resources/cubemap_converter.h"
+#include <cstdlib>
+#include <vector>
+
+// Face orientation, longitude / latitude order and the mip chains, on small synthetic panoramas
+namespace
+{
+    enum Face : uint32_t
+    {
+        POSITIVE_X,
+        NEGATIVE_X,
+        POSITIVE_Y,
+        NEGATIVE_Y,
+        POSITIVE_Z,
+        NEGATIVE_Z,
+    };
+
+    const uint8_t *texel(const MipLevel &level, uint32_t x, uint32_t y)
+    {
+        return level.pixels.data() + (static_cast<size_t>(y) * level.width + x) * 4;
+    }
+
+    bool isColor(const uint8_t *texel, uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255)
+    {
+        return std::abs(texel[0] - r) <= 1 && std::abs(texel[1] - g) <= 1 && std::abs(texel[2] - b) <= 1 && std::abs(texel[3] - a) <= 1;
+    }
+
+    void picksFaceSizesForTheView()
+    {
+        // 1080 pixels over 90 degrees: about one face texel per pixel at 1024
+        CHECK_EQ(CubemapConverter::getFaceSize(1080, DirectX::XM_PIDIV2, 8192), 1024u);
+        CHECK_EQ(CubemapConverter::getFaceSize(1080, DirectX::XM_PI / 3.f, 8192), 2048u);
+        // the panorama has no more detail to give than width / pi texels per face
+        CHECK_EQ(CubemapConverter::getFaceSize(1080, DirectX::XM_PIDIV2, 1024), 256u);
+        CHECK_EQ(CubemapConverter::getFaceSize(10, DirectX::XM_PIDIV2, 8192), 8u);
+        CHECK_EQ(CubemapConverter::getFaceSize(1, DirectX::XM_PIDIV2, 8), 4u);
+    }
+
+    void mapsEachAxisToItsPanoramaRegion()
+    {
+        // the four quarters of the equator band in their axis' color, the polar caps in their own
+        const uint32_t width = 256, height = 128;
+        const uint8_t colors[6][3] = {{255, 0, 0}, {0, 255, 255}, {0, 255, 0}, {255, 0, 255}, {0, 0, 255}, {255, 255, 0}};
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                // the center column looks down +Z, a quarter turn right of it is +X
+                uint32_t face = y < height / 8 ? POSITIVE_Y : y >= height - height / 8 ? NEGATIVE_Y
+                                : x < width / 8 || x >= width - width / 8            ? NEGATIVE_Z
+                                : x < 3 * width / 8                                  ? NEGATIVE_X
+                                : x < 5 * width / 8                                  ? POSITIVE_Z
+                                                                                     : POSITIVE_X;
+                uint8_t *out = pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+                out[0] = colors[face][0];
+                out[1] = colors[face][1];
+                out[2] = colors[face][2];
+                out[3] = 255;
+            }
+        }
+
+        const uint32_t faceSize = 32;
+        std::vector<std::vector<MipLevel>> faces = CubemapConverter::convert(pixels.data(), width, height, width * 4, false, faceSize);
+        CHECK_EQ(faces.size(), size_t(CubemapConverter::FACE_COUNT));
+        for (uint32_t face = 0; face < faces.size(); ++face)
+        {
+            const MipLevel &top = faces[face][0];
+            for (uint32_t y = faceSize / 2 - 2; y < faceSize / 2 + 2; ++y)
+            {
+                for (uint32_t x = faceSize / 2 - 2; x < faceSize / 2 + 2; ++x)
+                {
+                    CHECK(isColor(texel(top, x, y), colors[face][0], colors[face][1], colors[face][2]));
+                }
+            }
+        }
+    }
+
+    void keepsLongitudeAndLatitudeOrder()
+    {
+        // red grows with longitude, green from the top row down
+        const uint32_t width = 256, height = 128;
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                uint8_t *out = pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+                out[0] = static_cast<uint8_t>(x * 255 / (width - 1));
+                out[1] = static_cast<uint8_t>(y * 255 / (height - 1));
+                out[2] = 0;
+                out[3] = 255;
+            }
+        }
+
+        const uint32_t faceSize = 32;
+        std::vector<std::vector<MipLevel>> faces = CubemapConverter::convert(pixels.data(), width, height, width * 4, false, faceSize);
+        const uint32_t middle = faceSize / 2;
+        for (uint32_t face : {POSITIVE_X, NEGATIVE_X, POSITIVE_Z, NEGATIVE_Z})
+        {
+            // looking out from the center, right is east and down is south on every side face; -Z straddles the
+            // panorama's wrap, so its row only climbs on each side of it
+            const MipLevel &top = faces[face][0];
+            uint32_t firstX = face == NEGATIVE_Z ? middle + 1 : 0;
+            for (uint32_t x = firstX + 1; x < faceSize; ++x)
+            {
+                CHECK(texel(top, x, middle)[0] >= texel(top, x - 1, middle)[0]);
+            }
+            CHECK(texel(top, faceSize - 1, middle)[0] > texel(top, firstX, middle)[0]);
+            for (uint32_t y = 1; y < faceSize; ++y)
+            {
+                CHECK(texel(top, middle, y)[1] >= texel(top, middle, y - 1)[1]);
+            }
+            CHECK(texel(top, middle, faceSize - 1)[1] > texel(top, middle, 0)[1]);
+        }
+
+        // the caps: +Y's bottom row and -Y's top row meet +Z, 45 degrees from the poles
+        const MipLevel &up = faces[POSITIVE_Y][0];
+        CHECK(std::abs(texel(up, middle, faceSize - 1)[0] - 128) <= 8);
+        CHECK(texel(up, middle, faceSize - 1)[1] < 72);
+        const MipLevel &down = faces[NEGATIVE_Y][0];
+        CHECK(std::abs(texel(down, middle, 0)[0] - 128) <= 8);
+        CHECK(texel(down, middle, 0)[1] > 184);
+    }
+
+    void buildsBoxFilteredChainsPerFace()
+    {
+        // a solid color survives the resampling and every level; translucent texels stay premultiplied correctly
+        const uint32_t width = 64, height = 32, faceSize = 16;
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+        for (size_t i = 0; i < pixels.size(); i += 4)
+        {
+            pixels[i] = 180;
+            pixels[i + 1] = 90;
+            pixels[i + 2] = 30;
+            pixels[i + 3] = 128;
+        }
+        std::vector<std::vector<MipLevel>> faces = CubemapConverter::convert(pixels.data(), width, height, width * 4, true, faceSize);
+        size_t outputBytes = 0;
+        for (const std::vector<MipLevel> &levels : faces)
+        {
+            CHECK_EQ(levels.size(), size_t(5));
+            for (uint32_t mip = 0; mip < levels.size(); ++mip)
+            {
+                const MipLevel &level = levels[mip];
+                CHECK(level.width == faceSize >> mip && level.height == faceSize >> mip);
+                CHECK_EQ(level.pixels.size(), size_t(level.width) * level.height * 4);
+                bool isSolid = true;
+                for (size_t i = 0; i < level.pixels.size(); i += 4)
+                {
+                    isSolid = isSolid && isColor(level.pixels.data() + i, 180, 90, 30, 128);
+                }
+                CHECK(isSolid);
+                outputBytes += level.pixels.size();
+            }
+        }
+        // RGBA8, 16 + 8 + 4 + 2 + 1 texels square per face
+        CHECK_EQ(outputBytes, size_t(6) * 4 * (256 + 64 + 16 + 4 + 1));
+    }
+}
+
+int main()
+{
+    return Test::run({{"picksFaceSizesForTheView", picksFaceSizesForTheView},
+                      {"mapsEachAxisToItsPanoramaRegion", mapsEachAxisToItsPanoramaRegion},
+                      {"keepsLongitudeAndLatitudeOrder", keepsLongitudeAndLatitudeOrder},
+                      {"buildsBoxFilteredChainsPerFace", buildsBoxFilteredChainsPerFace}});
+}
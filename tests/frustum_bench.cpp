@@ -0,0 +1,46 @@
+#include "test_common.h"
+#include "utils/frustum.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Frustum::intersectsSpheres over 100k structure-of-arrays bounds against one intersectsSphere call per sphere
+int main()
+{
+    Test::benchmarkHeader("frustum_bench");
+    const size_t count = 100000;
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> coordinate(-120.f, 120.f), radius(0.f, 8.f);
+    std::vector<float> x(count), y(count), z(count), r(count);
+    std::vector<DirectX::XMFLOAT3> centers(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        x[i] = coordinate(random);
+        y[i] = coordinate(random);
+        z[i] = coordinate(random);
+        r[i] = radius(random);
+        centers[i] = {x[i], y[i], z[i]};
+    }
+
+    DirectX::XMMATRIX view = DirectX::XMMatrixTranslation(0.f, 0.f, 10.f);
+    DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(60.f), 16.f / 9.f, 0.1f, 100.f);
+    Frustum frustum = Frustum::fromMatrix(view * projection);
+
+    std::vector<uint8_t> visible(count);
+    double scalarMs = Test::bestMs(20, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            visible[i] = frustum.intersectsSphere(centers[i], r[i]);
+        }
+    });
+    size_t visibleCount = 0;
+    for (uint8_t v : visible)
+    {
+        visibleCount += v;
+    }
+    double batchMs = Test::bestMs(20, [&] { frustum.intersectsSpheres(x.data(), y.data(), z.data(), r.data(), count, visible.data()); });
+
+    std::printf("%zu spheres, %zu visible | intersectsSphere %6.3f ms %7.1f M/s | intersectsSpheres %6.3f ms %7.1f M/s | x%.1f\n", count, visibleCount,
+                scalarMs, count / (scalarMs * 1000.0), batchMs, count / (batchMs * 1000.0), scalarMs / batchMs);
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "test_common.h"
+#include "utils/frustum.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    Frustum makeFrustum()
+    {
+        // camera at (0, 0, -10) looking down +z
+        DirectX::XMMATRIX view = DirectX::XMMatrixTranslation(0.f, 0.f, 10.f);
+        DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(60.f), 16.f / 9.f, 0.1f, 100.f);
+        return Frustum::fromMatrix(view * projection);
+    }
+
+    // Distance to the plane the sphere is closest to crossing, spheres right at a plane may go either way
+    float closestMargin(const Frustum &frustum, const DirectX::XMFLOAT3 &center, float radius)
+    {
+        float margin = 1e30f;
+        for (const DirectX::XMFLOAT4 &plane : frustum.planes)
+        {
+            margin = std::min(margin, std::fabs(plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w + radius));
+        }
+        return margin;
+    }
+
+    void extractsNormalizedPlanes()
+    {
+        Frustum frustum = makeFrustum();
+        for (const DirectX::XMFLOAT4 &plane : frustum.planes)
+        {
+            CHECK_NEAR(std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z), 1.0, 1e-5);
+        }
+        // near and far distances from the camera
+        CHECK_NEAR(frustum.planes[Frustum::Near].w / frustum.planes[Frustum::Near].z, 10.0 - 0.1, 1e-3);
+        CHECK_NEAR(-frustum.planes[Frustum::Far].w / frustum.planes[Frustum::Far].z, 100.0 - 10.0, 1e-2);
+    }
+
+    void classifiesSpheres()
+    {
+        Frustum frustum = makeFrustum();
+        CHECK(frustum.intersectsSphere({0.f, 0.f, 0.f}, 1.f));
+        CHECK(!frustum.intersectsSphere({0.f, 0.f, -20.f}, 1.f));  // behind the camera
+        CHECK(!frustum.intersectsSphere({0.f, 0.f, 200.f}, 1.f));  // past the far plane
+        CHECK(!frustum.intersectsSphere({100.f, 0.f, 0.f}, 1.f));  // off to the right
+        CHECK(frustum.intersectsSphere({100.f, 0.f, 0.f}, 100.f)); // big enough to reach in
+        CHECK(frustum.intersectsSphere({0.f, 0.f, -10.f}, 0.5f));  // around the camera
+    }
+
+    void batchMatchesScalar()
+    {
+        // an odd count exercises the scalar tail after the groups of four
+        const size_t count = 100003;
+        std::mt19937 random(11);
+        std::uniform_real_distribution<float> coordinate(-120.f, 120.f), radius(0.f, 8.f);
+        std::vector<float> x(count), y(count), z(count), r(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            x[i] = coordinate(random);
+            y[i] = coordinate(random);
+            z[i] = coordinate(random);
+            r[i] = radius(random);
+        }
+
+        Frustum frustum = makeFrustum();
+        std::vector<uint8_t> visible(count, 2);
+        frustum.intersectsSpheres(x.data(), y.data(), z.data(), r.data(), count, visible.data());
+
+        size_t mismatches = 0, visibleCount = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            bool expected = frustum.intersectsSphere({x[i], y[i], z[i]}, r[i]);
+            visibleCount += expected;
+            if (visible[i] != uint8_t(expected) && closestMargin(frustum, {x[i], y[i], z[i]}, r[i]) > 1e-4f)
+            {
+                ++mismatches;
+            }
+        }
+        CHECK_EQ(mismatches, size_t(0));
+        CHECK(visibleCount > 0 && visibleCount < count);
+
+        // fewer than four spheres only take the tail
+        std::vector<uint8_t> few(3, 2);
+        frustum.intersectsSpheres(x.data(), y.data(), z.data(), r.data(), 3, few.data());
+        for (size_t i = 0; i < 3; ++i)
+        {
+            CHECK_EQ(few[i], uint8_t(frustum.intersectsSphere({x[i], y[i], z[i]}, r[i])));
+        }
+    }
+}
+
+int main()
+{
+    return Test::run({{"extractsNormalizedPlanes", extractsNormalizedPlanes},
+                      {"classifiesSpheres", classifiesSpheres},
+                      {"batchMatchesScalar", batchMatchesScalar}});
+}
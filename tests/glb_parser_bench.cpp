@@ -0,0 +1,72 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "glb_writer.h"
+#include "resources/glb_parser.h"
+#include "resources/obj_parser.h"
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The same mesh through the OBJ path (parse + index) and the GLB path (parse + read), both from memory. Peak is
+// the heap the path holds at once beyond the file: ObjParser's attribute arrays plus the indexed output for OBJ,
+// the output alone for GLB.
+namespace
+{
+    std::string writeObj(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices)
+    {
+        std::ostringstream obj;
+        for (const Vertex &v : vertices)
+        {
+            obj << "v " << v.pos.x << " " << v.pos.y << " " << -v.pos.z << "\nvt " << v.uv.x << " " << 1.f - v.uv.y << "\nvn " << v.n.x << " " << v.n.y << " " << -v.n.z << "\n";
+        }
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            obj << "f";
+            for (size_t k = 0; k < 3; ++k)
+            {
+                uint32_t i = indices[t + k] + 1;
+                obj << " " << i << "/" << i << "/" << i;
+            }
+            obj << "\n";
+        }
+        return obj.str();
+    }
+
+    void measure(const char *name, const std::vector<Vertex> &sourceVertices, const std::vector<uint32_t> &sourceIndices)
+    {
+        std::string obj = writeObj(sourceVertices, sourceIndices);
+        std::string glb = GlbWriter::write(sourceVertices, sourceIndices);
+        size_t outputBytes = MeshOptimizer::getBufferBytes(sourceVertices.size(), sourceIndices.size());
+
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        size_t objPeak = 0;
+        double objMs = Test::bestMs(5, [&] {
+            ObjParser::Result result = ObjParser::parse(obj.data(), obj.data() + obj.size());
+            MeshOptimizer::indexCorners(result, vertices, indices);
+            objPeak = result.positions.capacity() * sizeof(DirectX::XMFLOAT3) + result.normals.capacity() * sizeof(DirectX::XMFLOAT3) +
+                      result.texCoords.capacity() * sizeof(DirectX::XMFLOAT2) + result.corners.capacity() * sizeof(DirectX::XMINT3) + outputBytes;
+        });
+        double glbMs = Test::bestMs(5, [&] {
+            GlbParser::Result result = GlbParser::parse(glb.data(), glb.size());
+            GlbParser::readVertices(result.primitives[0], vertices);
+            GlbParser::readIndices(result.primitives[0], indices);
+        });
+
+        std::printf("%-14s | OBJ %8.1f KB %8.2f ms peak %8.1f KB | GLB %8.1f KB %8.2f ms peak %8.1f KB | x%.1f\n", name, obj.size() / 1024.0, objMs,
+                    objPeak / 1024.0, glb.size() / 1024.0, glbMs, outputBytes / 1024.0, objMs / glbMs);
+    }
+}
+
+int main()
+{
+    Test::benchmarkHeader("glb_parser_bench");
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    TestMeshes::loadObj(Test::sourcePath("game/celestial_rover/assets/mesh/spaceship.obj"), vertices, indices);
+    measure("spaceship", vertices, indices);
+    TestMeshes::makeGrid(400, vertices, indices);
+    measure("grid 400^2", vertices, indices);
+    return 0;
+}
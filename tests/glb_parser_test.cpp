@@ -0,0 +1,138 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "glb_writer.h"
+#include "resources/glb_parser.h"
+#include <string>
+#include <vector>
+
+namespace
+{
+    bool sameVertices(const std::vector<Vertex> &a, const std::vector<Vertex> &b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (TestMeshes::vertexKey(a[i]) != TestMeshes::vertexKey(b[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void readBack(const std::string &glb, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices, bool *blockCopy = nullptr)
+    {
+        GlbParser::Result result = GlbParser::parse(glb.data(), glb.size());
+        CHECK_EQ(result.primitives.size(), size_t(1));
+        const GlbParser::Primitive &primitive = result.primitives.at(0);
+        GlbParser::readVertices(primitive, vertices);
+        GlbParser::readIndices(primitive, indices);
+        if (blockCopy)
+        {
+            *blockCopy = GlbParser::matchesVertexLayout(primitive);
+        }
+    }
+
+    void readsInterleavedWithBlockCopy()
+    {
+        std::vector<Vertex> vertices, readVertices;
+        std::vector<uint32_t> indices, readIndices;
+        TestMeshes::loadObj(Test::sourcePath("game/celestial_rover/assets/mesh/spaceship.obj"), vertices, indices);
+        std::string glb = GlbWriter::write(vertices, indices);
+
+        // accessors point into the caller's buffer
+        GlbParser::Result result = GlbParser::parse(glb.data(), glb.size());
+        const uint8_t *begin = reinterpret_cast<const uint8_t *>(glb.data());
+        CHECK(result.primitives.size() == 1 && result.primitives[0].positions.data > begin && result.primitives[0].positions.data < begin + glb.size());
+
+        bool blockCopy = false;
+        readBack(glb, readVertices, readIndices, &blockCopy);
+        CHECK(blockCopy);
+        CHECK(sameVertices(readVertices, vertices));
+        CHECK(readIndices == indices);
+    }
+
+    void readsSeparateAccessorsAndIndexTypes()
+    {
+        std::vector<Vertex> vertices, readVertices;
+        std::vector<uint32_t> indices, readIndices;
+        TestMeshes::loadObj(Test::sourcePath("game/celestial_rover/assets/mesh/sphere.obj"), vertices, indices);
+
+        GlbWriter::Options options;
+        options.interleaved = false;
+        options.indexType = GlbParser::UnsignedShort;
+        bool blockCopy = true;
+        readBack(GlbWriter::write(vertices, indices, options), readVertices, readIndices, &blockCopy);
+        CHECK(!blockCopy);
+        CHECK(sameVertices(readVertices, vertices));
+        CHECK(readIndices == indices);
+
+        TestMeshes::loadObj(Test::sourcePath("game/celestial_rover/assets/mesh/cube.obj"), vertices, indices);
+        options.indexType = GlbParser::UnsignedByte;
+        readBack(GlbWriter::write(vertices, indices, options), readVertices, readIndices);
+        CHECK(sameVertices(readVertices, vertices));
+        CHECK(readIndices == indices);
+    }
+
+    void fillsMissingAttributes()
+    {
+        std::vector<Vertex> vertices, readVertices;
+        std::vector<uint32_t> indices, readIndices;
+        TestMeshes::makeGrid(2, vertices, indices);
+
+        // no normals or uvs: zero like the OBJ path; no indices: one vertex per corner
+        GlbWriter::Options options;
+        options.interleaved = false;
+        options.normals = false;
+        options.texCoords = false;
+        options.indexType = 0;
+        readBack(GlbWriter::write(vertices, indices, options), readVertices, readIndices);
+        CHECK_EQ(readVertices.size(), vertices.size());
+        CHECK(readVertices[4].pos.x == vertices[4].pos.x && readVertices[4].pos.z == vertices[4].pos.z);
+        CHECK(readVertices[4].n.y == 0.f && readVertices[4].uv.x == 0.f);
+        CHECK_EQ(readIndices.size(), vertices.size() / 3 * 3);
+        CHECK(readIndices.size() > 2 && readIndices[2] == 2);
+    }
+
+    void rejectsUnsupportedFiles()
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::makeGrid(2, vertices, indices);
+        std::string glb = GlbWriter::write(vertices, indices);
+
+        std::string badMagic = glb;
+        badMagic[0] = 'x';
+        CHECK_THROWS(GlbParser::parse(badMagic.data(), badMagic.size()));
+        CHECK_THROWS(GlbParser::parse(glb.data(), glb.size() - 16)); // BIN chunk cut short
+
+        GlbWriter::Options options;
+        options.extensionsRequired = "KHR_draco_mesh_compression";
+        std::string draco = GlbWriter::write(vertices, indices, options);
+        CHECK_THROWS(GlbParser::parse(draco.data(), draco.size()));
+
+        // lines are skipped, not rejected
+        options = {};
+        options.mode = 1;
+        std::string lines = GlbWriter::write(vertices, indices, options);
+        CHECK_EQ(GlbParser::parse(lines.data(), lines.size()).primitives.size(), size_t(0));
+
+        std::vector<uint32_t> outOfRange = indices;
+        outOfRange[1] = static_cast<uint32_t>(vertices.size());
+        std::string bad = GlbWriter::write(vertices, outOfRange);
+        GlbParser::Result result = GlbParser::parse(bad.data(), bad.size());
+        std::vector<uint32_t> readIndices;
+        CHECK_THROWS(GlbParser::readIndices(result.primitives.at(0), readIndices));
+    }
+}
+
+int main()
+{
+    return Test::run({{"readsInterleavedWithBlockCopy", readsInterleavedWithBlockCopy},
+                      {"readsSeparateAccessorsAndIndexTypes", readsSeparateAccessorsAndIndexTypes},
+                      {"fillsMissingAttributes", fillsMissingAttributes},
+                      {"rejectsUnsupportedFiles", rejectsUnsupportedFiles}});
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "resources/glb_parser.h"
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Writes engine vertices as a .glb in memory for the parser tests: z flipped back to glTF's right-hand space,
+// uvs as they are. Interleaved writes one buffer view in Vertex's layout (the block copy path), otherwise each
+// attribute gets its own tightly packed view.
+namespace GlbWriter
+{
+    struct Options
+    {
+        bool interleaved = true;
+        bool normals = true;
+        bool texCoords = true;
+        uint32_t indexType = GlbParser::UnsignedInt; // 0 writes a non-indexed primitive
+        uint32_t mode = 4;                           // TRIANGLES
+        std::string extensionsRequired;              // e.g. KHR_draco_mesh_compression
+    };
+
+    inline void appendBytes(std::string &bin, const void *data, size_t size)
+    {
+        bin.append(static_cast<const char *>(data), size);
+        bin.append((4 - bin.size() % 4) % 4, '\0');
+    }
+
+    inline std::string write(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, const Options &options = {})
+    {
+        std::vector<Vertex> gltfVertices = vertices;
+        for (Vertex &v : gltfVertices)
+        {
+            v.pos.z = -v.pos.z;
+            v.n.z = -v.n.z;
+        }
+
+        std::string bin, views, accessors;
+        int viewCount = 0;
+        auto addView = [&](const void *data, size_t size, size_t stride) {
+            size_t offset = bin.size();
+            appendBytes(bin, data, size);
+            views += std::string(views.empty() ? "" : ",") + "{\"buffer\":0,\"byteOffset\":" + std::to_string(offset) + ",\"byteLength\":" + std::to_string(size) +
+                     (stride ? ",\"byteStride\":" + std::to_string(stride) : "") + "}";
+            return viewCount++;
+        };
+        int accessorCount = 0;
+        auto addAccessor = [&](int view, size_t offset, uint32_t componentType, size_t count, const char *type) {
+            accessors += std::string(accessors.empty() ? "" : ",") + "{\"bufferView\":" + std::to_string(view) + ",\"byteOffset\":" + std::to_string(offset) +
+                         ",\"componentType\":" + std::to_string(componentType) + ",\"count\":" + std::to_string(count) + ",\"type\":\"" + type + "\"}";
+            return accessorCount++;
+        };
+
+        std::string attributes;
+        if (options.interleaved)
+        {
+            int view = addView(gltfVertices.data(), gltfVertices.size() * sizeof(Vertex), sizeof(Vertex));
+            attributes = "\"POSITION\":" + std::to_string(addAccessor(view, 0, GlbParser::Float, vertices.size(), "VEC3"));
+            if (options.normals)
+            {
+                attributes += ",\"NORMAL\":" + std::to_string(addAccessor(view, offsetof(Vertex, n), GlbParser::Float, vertices.size(), "VEC3"));
+            }
+            if (options.texCoords)
+            {
+                attributes += ",\"TEXCOORD_0\":" + std::to_string(addAccessor(view, offsetof(Vertex, uv), GlbParser::Float, vertices.size(), "VEC2"));
+            }
+        }
+        else
+        {
+            std::vector<DirectX::XMFLOAT3> positions, normals;
+            std::vector<DirectX::XMFLOAT2> texCoords;
+            for (const Vertex &v : gltfVertices)
+            {
+                positions.push_back(v.pos);
+                normals.push_back(v.n);
+                texCoords.push_back(v.uv);
+            }
+            attributes = "\"POSITION\":" + std::to_string(addAccessor(addView(positions.data(), positions.size() * 12, 0), 0, GlbParser::Float, vertices.size(), "VEC3"));
+            if (options.normals)
+            {
+                attributes += ",\"NORMAL\":" + std::to_string(addAccessor(addView(normals.data(), normals.size() * 12, 0), 0, GlbParser::Float, vertices.size(), "VEC3"));
+            }
+            if (options.texCoords)
+            {
+                attributes += ",\"TEXCOORD_0\":" + std::to_string(addAccessor(addView(texCoords.data(), texCoords.size() * 8, 0), 0, GlbParser::Float, vertices.size(), "VEC2"));
+            }
+        }
+
+        std::string primitive = "{\"attributes\":{" + attributes + "},\"mode\":" + std::to_string(options.mode);
+        if (options.indexType != 0)
+        {
+            std::string packed;
+            size_t size = options.indexType == GlbParser::UnsignedByte ? 1 : options.indexType == GlbParser::UnsignedShort ? 2 : 4;
+            for (uint32_t index : indices)
+            {
+                packed.append(reinterpret_cast<const char *>(&index), size); // little endian
+            }
+            primitive += ",\"indices\":" + std::to_string(addAccessor(addView(packed.data(), packed.size(), 0), 0, options.indexType, indices.size(), "SCALAR"));
+        }
+        primitive += "}";
+
+        std::string json = "{\"asset\":{\"version\":\"2.0\"},";
+        if (!options.extensionsRequired.empty())
+        {
+            json += "\"extensionsUsed\":[\"" + options.extensionsRequired + "\"],\"extensionsRequired\":[\"" + options.extensionsRequired + "\"],";
+        }
+        json += "\"buffers\":[{\"byteLength\":" + std::to_string(bin.size()) + "}],\"bufferViews\":[" + views + "],\"accessors\":[" + accessors +
+                "],\"meshes\":[{\"name\":\"mesh\",\"primitives\":[" + primitive + "]}]}";
+        json.append((4 - json.size() % 4) % 4, ' ');
+
+        auto appendU32 = [](std::string &out, uint32_t value) { out.append(reinterpret_cast<const char *>(&value), 4); };
+        std::string glb;
+        appendU32(glb, GlbParser::MAGIC);
+        appendU32(glb, 2);
+        appendU32(glb, static_cast<uint32_t>(12 + 8 + json.size() + 8 + bin.size()));
+        appendU32(glb, static_cast<uint32_t>(json.size()));
+        appendU32(glb, GlbParser::CHUNK_JSON);
+        glb += json;
+        appendU32(glb, static_cast<uint32_t>(bin.size()));
+        appendU32(glb, GlbParser::CHUNK_BIN);
+        glb += bin;
+        return glb;
+    }
+}
@@ -0,0 +1,122 @@
+#include "test_common.h"
+#include "resources/lazy_asset.h"
+#include <stdexcept>
+#include <thread>
+
+// request() against promise backed futures: the test decides when a load finishes and how
+namespace
+{
+    struct Loads
+    {
+        int calls = 0;
+        std::promise<std::shared_ptr<int>> promise;
+
+        LazyAsset<int>::Load load()
+        {
+            return [this]()
+            {
+                ++calls;
+                return promise.get_future().share();
+            };
+        }
+    };
+
+    std::shared_ptr<LazyAssetUsage> makeUsage(const char *name)
+    {
+        auto usage = std::make_shared<LazyAssetUsage>();
+        usage->type = "int";
+        usage->name = name;
+        return usage;
+    }
+
+    void servesThePlaceholderUntilReady()
+    {
+        Loads loads;
+        auto placeholder = std::make_shared<int>(0);
+        LazyAsset<int> asset(makeUsage("a"), loads.load(), placeholder);
+        CHECK(asset.get() == placeholder && !asset.isLoaded());
+        CHECK_EQ(loads.calls, 0); // nothing before the first request
+
+        CHECK(!asset.request());
+        CHECK(!asset.request());
+        CHECK(asset.get() == placeholder);
+        CHECK(asset.getUsage().isRequested && !asset.getUsage().isLoaded);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        auto loaded = std::make_shared<int>(7);
+        loads.promise.set_value(loaded);
+        CHECK(asset.request());
+        CHECK(asset.get() == loaded && asset.isLoaded());
+        CHECK(asset.request());
+        CHECK_EQ(loads.calls, 1);
+
+        const LazyAssetUsage &usage = asset.getUsage();
+        CHECK(usage.isLoaded && !usage.isFailed);
+        CHECK(usage.loadMs >= 5.f);
+        CHECK(placeholder.use_count() == 1); // released once the asset is in use
+    }
+
+    void failuresKeepThePlaceholder()
+    {
+        auto placeholder = std::make_shared<int>(0);
+
+        // the load threw on the worker
+        Loads threw;
+        LazyAsset<int> a(makeUsage("a"), threw.load(), placeholder);
+        CHECK(!a.request());
+        threw.promise.set_exception(std::make_exception_ptr(std::runtime_error("missing file")));
+        CHECK(!a.request());
+        CHECK(a.getUsage().isFailed && !a.getUsage().isLoaded);
+        CHECK(a.get() == placeholder);
+        CHECK(!a.request());
+        CHECK_EQ(threw.calls, 1);
+
+        // the load itself threw before handing out a future
+        int calls = 0;
+        LazyAsset<int> b(makeUsage("b"), [&]() -> AssetFuture<std::shared_ptr<int>>
+                         { ++calls; throw std::runtime_error("no loader"); }, placeholder);
+        CHECK(!b.request() && !b.request());
+        CHECK(b.getUsage().isFailed && b.get() == placeholder);
+        CHECK_EQ(calls, 1);
+
+        // nothing loaded is a failure too
+        LazyAsset<int> c(makeUsage("c"), []() { return AssetLoader::makeReady(std::shared_ptr<int>()); }, placeholder);
+        CHECK(!c.request());
+        CHECK(c.getUsage().isFailed && c.get() == placeholder && !c.isLoaded());
+    }
+
+    void countsWhatTheReportPrints()
+    {
+        auto placeholder = std::make_shared<int>(0);
+        std::vector<std::shared_ptr<LazyAssetUsage>> usage = {makeUsage("loaded"), makeUsage("failed"), makeUsage("loading"),
+                                                              makeUsage("untouched"), makeUsage("untouched too")};
+        LazyAsset<int> loaded(usage[0], []() { return AssetLoader::makeReady(std::make_shared<int>(1)); }, placeholder);
+        LazyAsset<int> failed(usage[1], []() { return AssetLoader::makeReady(std::shared_ptr<int>()); }, placeholder);
+        Loads pending;
+        LazyAsset<int> loading(usage[2], pending.load(), placeholder);
+        LazyAsset<int> untouched(usage[3], []() { return AssetLoader::makeReady(std::make_shared<int>(3)); }, placeholder);
+        LazyAsset<int> untouchedToo(usage[4], []() { return AssetLoader::makeReady(std::make_shared<int>(4)); }, placeholder);
+        loaded.request();
+        failed.request();
+        loading.request();
+
+        LazyAssetCounts counts = countLazyAssets(usage);
+        CHECK_EQ(counts.loaded, 1u);
+        CHECK_EQ(counts.failed, 1u);
+        CHECK_EQ(counts.loading, 1u);
+        CHECK_EQ(counts.neverRequested, 2u);
+
+        pending.promise.set_value(std::make_shared<int>(2));
+        loading.request();
+        untouched.request();
+        counts = countLazyAssets(usage);
+        CHECK(counts.loaded == 3 && counts.loading == 0 && counts.neverRequested == 1);
+    }
+}
+
+int main()
+{
+    return Test::run({{"servesThePlaceholderUntilReady", servesThePlaceholderUntilReady},
+                      {"failuresKeepThePlaceholder", failuresKeepThePlaceholder},
+                      {"countsWhatTheReportPrints", countsWhatTheReportPrints}});
+}
@@ -0,0 +1,125 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "resources/mesh_bounds.h"
+#include "resources/mesh_bvh.h"
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Rays/s through MeshBvh: incoherent single rays, occlusion rays and coherent camera rays in packets of four,
+// against a brute force loop over every triangle
+namespace
+{
+    bool bruteIntersect(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, const MeshBvh::Ray &ray, float &bestT)
+    {
+        DirectX::XMVECTOR origin = DirectX::XMLoadFloat3(&ray.origin), direction = DirectX::XMLoadFloat3(&ray.direction);
+        bestT = ray.tMax;
+        bool hit = false;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            DirectX::XMVECTOR a = DirectX::XMLoadFloat3(&vertices[indices[i]].pos);
+            DirectX::XMVECTOR e1 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&vertices[indices[i + 1]].pos), a);
+            DirectX::XMVECTOR e2 = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&vertices[indices[i + 2]].pos), a);
+            DirectX::XMVECTOR p = DirectX::XMVector3Cross(direction, e2);
+            float det = DirectX::XMVectorGetX(DirectX::XMVector3Dot(e1, p));
+            if (std::fabs(det) < 1e-12f)
+            {
+                continue;
+            }
+            DirectX::XMVECTOR s = DirectX::XMVectorSubtract(origin, a), q = DirectX::XMVector3Cross(s, e1);
+            float u = DirectX::XMVectorGetX(DirectX::XMVector3Dot(s, p)) / det, v = DirectX::XMVectorGetX(DirectX::XMVector3Dot(direction, q)) / det;
+            float t = DirectX::XMVectorGetX(DirectX::XMVector3Dot(e2, q)) / det;
+            if (u >= 0.f && v >= 0.f && u + v <= 1.f && t > 0.f && t < bestT)
+            {
+                bestT = t;
+                hit = true;
+            }
+        }
+        return hit;
+    }
+
+    void measure(const char *asset)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::loadObj(Test::sourcePath(asset), vertices, indices);
+        MeshBounds bounds = MeshBounds::compute(&vertices[0].pos, vertices.size(), sizeof(Vertex));
+        float radius = bounds.sphereRadius;
+
+        std::unique_ptr<MeshBvh> bvh;
+        double buildMs = Test::bestMs(5, [&] { bvh = std::make_unique<MeshBvh>(&vertices[0].pos, sizeof(Vertex), vertices.size(), indices.data(), indices.size()); });
+
+        // incoherent: shell to random points near the middle
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> unit(-1.f, 1.f);
+        std::vector<MeshBvh::Ray> rays(100000);
+        for (MeshBvh::Ray &ray : rays)
+        {
+            ray.origin = {bounds.sphereCenter.x + unit(random) * radius * 2.f, bounds.sphereCenter.y + unit(random) * radius * 2.f, bounds.sphereCenter.z - radius * 2.f};
+            ray.direction = {bounds.sphereCenter.x + unit(random) * radius * 0.5f - ray.origin.x, bounds.sphereCenter.y + unit(random) * radius * 0.5f - ray.origin.y,
+                             bounds.sphereCenter.z + unit(random) * radius * 0.5f - ray.origin.z};
+        }
+        size_t hits = 0;
+        double singleMs = Test::bestMs(3, [&] {
+            hits = 0;
+            MeshBvh::Hit hit;
+            for (const MeshBvh::Ray &ray : rays)
+            {
+                hits += bvh->intersect(ray, hit);
+            }
+        });
+        double occlusionMs = Test::bestMs(3, [&] {
+            for (const MeshBvh::Ray &ray : rays)
+            {
+                bvh->isOccluded(ray);
+            }
+        });
+
+        // coherent: a 316x316 pinhole camera in front of the mesh, row by row
+        std::vector<MeshBvh::Ray> camera;
+        const int side = 316;
+        for (int y = 0; y < side; ++y)
+        {
+            for (int x = 0; x < side; ++x)
+            {
+                MeshBvh::Ray ray;
+                ray.origin = {bounds.sphereCenter.x, bounds.sphereCenter.y, bounds.sphereCenter.z - radius * 3.f};
+                ray.direction = {(x / float(side) - 0.5f) * 0.8f, (y / float(side) - 0.5f) * 0.8f, 1.f};
+                camera.push_back(ray);
+            }
+        }
+        std::vector<MeshBvh::Hit> cameraHits(camera.size());
+        double packetMs = Test::bestMs(3, [&] { bvh->intersect(camera.data(), camera.size(), cameraHits.data()); });
+        double cameraSingleMs = Test::bestMs(3, [&] {
+            for (size_t i = 0; i < camera.size(); ++i)
+            {
+                bvh->intersect(camera[i], cameraHits[i]);
+            }
+        });
+
+        const size_t bruteCount = 2000;
+        double bruteMs = Test::bestMs(1, [&] {
+            float t;
+            for (size_t i = 0; i < bruteCount; ++i)
+            {
+                bruteIntersect(vertices, indices, rays[i], t);
+            }
+        });
+
+        auto rate = [](size_t count, double ms) { return count / (ms * 1000.0); };
+        std::printf("%-14s %6zu tris, %5zu nodes, depth %2u, %6.1f KB, build %6.2f ms | Mrays/s: single %6.2f (%4.1f%% hit), occlusion %6.2f, "
+                    "camera single %6.2f packet %6.2f, brute force %7.4f\n",
+                    asset + std::string(asset).rfind('/') + 1, indices.size() / 3, bvh->getNodeCount(), bvh->getDepth(), bvh->getMemoryBytes() / 1024.0, buildMs,
+                    rate(rays.size(), singleMs), 100.0 * hits / rays.size(), rate(rays.size(), occlusionMs), rate(camera.size(), cameraSingleMs),
+                    rate(camera.size(), packetMs), rate(bruteCount, bruteMs));
+    }
+}
+
+int main()
+{
+    Test::benchmarkHeader("mesh_bvh_bench");
+    measure("game/celestial_rover/assets/mesh/sphere.obj");
+    measure("game/celestial_rover/assets/mesh/spaceship.obj");
+    return 0;
+}
@@ -0,0 +1,229 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "resources/mesh_bounds.h"
+#include "resources/mesh_bvh.h"
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+    struct Vec3
+    {
+        double x, y, z;
+    };
+    Vec3 toVec3(const DirectX::XMFLOAT3 &v) { return {v.x, v.y, v.z}; }
+    Vec3 operator-(const Vec3 &a, const Vec3 &b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+    Vec3 operator+(const Vec3 &a, const Vec3 &b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+    Vec3 operator*(const Vec3 &a, double s) { return {a.x * s, a.y * s, a.z * s}; }
+    double dot(const Vec3 &a, const Vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Vec3 cross(const Vec3 &a, const Vec3 &b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+
+    // Two-sided Moller-Trumbore in double, `margin` is how far inside the triangle the hit lies in barycentrics
+    bool intersectTriangle(const Vec3 &origin, const Vec3 &direction, const Vec3 &a, const Vec3 &b, const Vec3 &c, double &t, double &margin)
+    {
+        Vec3 e1 = b - a, e2 = c - a, p = cross(direction, e2);
+        double det = dot(e1, p);
+        if (std::fabs(det) < 1e-14)
+        {
+            return false;
+        }
+        Vec3 s = origin - a;
+        double u = dot(s, p) / det;
+        Vec3 q = cross(s, e1);
+        double v = dot(direction, q) / det;
+        t = dot(e2, q) / det;
+        margin = std::min({u, v, 1.0 - u - v});
+        return margin >= 0.0 && t > 0.0;
+    }
+
+    struct BruteHit
+    {
+        double t = 1e300;
+        double margin = 0.0;
+        uint32_t triangle = MeshBvh::INVALID_TRIANGLE;
+    };
+
+    BruteHit bruteIntersect(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, const MeshBvh::Ray &ray)
+    {
+        BruteHit best;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            double t, margin;
+            if (intersectTriangle(toVec3(ray.origin), toVec3(ray.direction), toVec3(vertices[indices[i]].pos), toVec3(vertices[indices[i + 1]].pos),
+                                  toVec3(vertices[indices[i + 2]].pos), t, margin) &&
+                t < ray.tMax && t < best.t)
+            {
+                best = {t, margin, static_cast<uint32_t>(i / 3)};
+            }
+        }
+        return best;
+    }
+
+    // Closest point on a triangle (Ericson, Real-Time Collision Detection 5.1.5)
+    Vec3 closestOnTriangle(const Vec3 &p, const Vec3 &a, const Vec3 &b, const Vec3 &c)
+    {
+        Vec3 ab = b - a, ac = c - a, ap = p - a;
+        double d1 = dot(ab, ap), d2 = dot(ac, ap);
+        if (d1 <= 0 && d2 <= 0) return a;
+        Vec3 bp = p - b;
+        double d3 = dot(ab, bp), d4 = dot(ac, bp);
+        if (d3 >= 0 && d4 <= d3) return b;
+        double vc = d1 * d4 - d3 * d2;
+        if (vc <= 0 && d1 >= 0 && d3 <= 0) return a + ab * (d1 / (d1 - d3));
+        Vec3 cp = p - c;
+        double d5 = dot(ab, cp), d6 = dot(ac, cp);
+        if (d6 >= 0 && d5 <= d6) return c;
+        double vb = d5 * d2 - d1 * d6;
+        if (vb <= 0 && d2 >= 0 && d6 <= 0) return a + ac * (d2 / (d2 - d6));
+        double va = d3 * d6 - d5 * d4;
+        if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+        double denom = 1.0 / (va + vb + vc);
+        return a + ab * (vb * denom) + ac * (vc * denom);
+    }
+
+    double bruteClosestDistance(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, const DirectX::XMFLOAT3 &point)
+    {
+        double best = 1e300;
+        Vec3 p = toVec3(point);
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            Vec3 q = closestOnTriangle(p, toVec3(vertices[indices[i]].pos), toVec3(vertices[indices[i + 1]].pos), toVec3(vertices[indices[i + 2]].pos));
+            Vec3 d = p - q;
+            best = std::min(best, std::sqrt(dot(d, d)));
+        }
+        return best;
+    }
+
+    std::unique_ptr<MeshBvh> buildBvh(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices)
+    {
+        return std::make_unique<MeshBvh>(&vertices[0].pos, sizeof(Vertex), vertices.size(), indices.data(), indices.size());
+    }
+
+    // Rays from a shell around the mesh towards random points near its middle, some of them short
+    std::vector<MeshBvh::Ray> makeRays(size_t count, const MeshBounds &bounds, uint32_t seed)
+    {
+        const DirectX::XMFLOAT3 &c = bounds.sphereCenter;
+        float radius = bounds.sphereRadius;
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> unit(-1.f, 1.f);
+        std::vector<MeshBvh::Ray> rays(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            DirectX::XMFLOAT3 origin = {c.x + unit(random) * radius * 2.f, c.y + unit(random) * radius * 2.f, c.z + unit(random) * radius * 2.f};
+            DirectX::XMFLOAT3 target = {c.x + unit(random) * radius * 0.5f, c.y + unit(random) * radius * 0.5f, c.z + unit(random) * radius * 0.5f};
+            rays[i].origin = origin;
+            rays[i].direction = {target.x - origin.x, target.y - origin.y, target.z - origin.z};
+            rays[i].tMax = i % 4 == 3 ? 0.6f : FLT_MAX; // ends 60% of the way to the target
+        }
+        return rays;
+    }
+
+    void checkMesh(const char *asset)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::loadObj(Test::sourcePath(asset), vertices, indices);
+        std::unique_ptr<MeshBvh> bvh = buildBvh(vertices, indices);
+        CHECK_EQ(bvh->getTriangleCount(), indices.size() / 3);
+        CHECK(bvh->getNodeCount() < indices.size() / 3 * 2);
+
+        MeshBounds bounds = MeshBounds::compute(&vertices[0].pos, vertices.size(), sizeof(Vertex));
+        std::vector<MeshBvh::Ray> rays = makeRays(2000, bounds, 21);
+        std::vector<MeshBvh::Hit> packetHits(rays.size());
+        bvh->intersect(rays.data(), rays.size(), packetHits.data());
+
+        size_t hits = 0, mismatches = 0, packetMismatches = 0, occlusionMismatches = 0;
+        for (size_t i = 0; i < rays.size(); ++i)
+        {
+            const MeshBvh::Ray &ray = rays[i];
+            MeshBvh::Hit hit;
+            bool isHit = bvh->intersect(ray, hit);
+            BruteHit expected = bruteIntersect(vertices, indices, ray);
+            bool expectedHit = expected.triangle != MeshBvh::INVALID_TRIANGLE;
+            hits += expectedHit;
+
+            // hits grazing an edge or the end of the ray may go either way in float
+            bool ambiguous = expectedHit && (expected.margin < 1e-4 || std::fabs(expected.t - ray.tMax) < 1e-4);
+            if (!ambiguous && (isHit != expectedHit || (isHit && std::fabs(hit.t - expected.t) > 1e-4 * std::max(1.0, expected.t))))
+            {
+                ++mismatches;
+            }
+            if (packetHits[i].triangle != hit.triangle || std::fabs(packetHits[i].t - hit.t) > 1e-5f * std::max(1.f, hit.t))
+            {
+                packetMismatches += !ambiguous;
+            }
+            if (bvh->isOccluded(ray) != isHit)
+            {
+                occlusionMismatches += !ambiguous;
+            }
+        }
+        CHECK(hits > rays.size() / 4);
+        CHECK_EQ(mismatches, size_t(0));
+        CHECK_EQ(packetMismatches, size_t(0));
+        CHECK_EQ(occlusionMismatches, size_t(0));
+
+        // closest points, inside and outside the search radius
+        std::mt19937 random(8);
+        std::uniform_real_distribution<float> unit(-1.5f, 1.5f);
+        size_t closestMismatches = 0;
+        for (int i = 0; i < 300; ++i)
+        {
+            DirectX::XMFLOAT3 point = {bounds.sphereCenter.x + unit(random) * bounds.sphereRadius, bounds.sphereCenter.y + unit(random) * bounds.sphereRadius,
+                                       bounds.sphereCenter.z + unit(random) * bounds.sphereRadius};
+            double expected = bruteClosestDistance(vertices, indices, point);
+            float maxDistance = bounds.sphereRadius * 0.3f;
+            MeshBvh::ClosestPoint closest;
+            bool found = bvh->findClosestPoint(point, maxDistance, closest);
+            if (std::fabs(expected - maxDistance) < 1e-4)
+            {
+                continue;
+            }
+            if (found != (expected <= maxDistance) || (found && std::fabs(closest.distance - expected) > 1e-4 * std::max(1.0, expected)))
+            {
+                ++closestMismatches;
+            }
+        }
+        CHECK_EQ(closestMismatches, size_t(0));
+    }
+
+    void matchesBruteForceOnSphere() { checkMesh("game/celestial_rover/assets/mesh/sphere.obj"); }
+    void matchesBruteForceOnSpaceship() { checkMesh("game/celestial_rover/assets/mesh/spaceship.obj"); }
+
+    void reportsHitDetails()
+    {
+        // a unit quad in z = 0, hit square on from -z
+        std::vector<Vertex> vertices = {Vertex({0.f, 0.f, 0.f}, {0.f, 0.f, -1.f}, {0.f, 0.f}), Vertex({1.f, 0.f, 0.f}, {0.f, 0.f, -1.f}, {1.f, 0.f}),
+                                        Vertex({0.f, 1.f, 0.f}, {0.f, 0.f, -1.f}, {0.f, 1.f}), Vertex({1.f, 1.f, 0.f}, {0.f, 0.f, -1.f}, {1.f, 1.f})};
+        std::vector<uint32_t> indices = {0, 2, 1, 1, 2, 3};
+        std::unique_ptr<MeshBvh> bvh = buildBvh(vertices, indices);
+
+        MeshBvh::Hit hit;
+        CHECK(bvh->intersect({{0.25f, 0.5f, -2.f}, {0.f, 0.f, 2.f}}, hit));
+        CHECK_NEAR(hit.t, 1.f, 1e-6); // in units of the direction's length
+        CHECK_EQ(hit.triangle, 0u);
+        CHECK_NEAR(hit.u, 0.5f, 1e-6); // towards corner 2 (0, 1)
+        CHECK_NEAR(hit.v, 0.25f, 1e-6);
+
+        // two-sided, and the ray ends before the quad
+        CHECK(bvh->intersect({{0.75f, 0.75f, 2.f}, {0.f, 0.f, -1.f}}, hit) && hit.triangle == 1);
+        MeshBvh::Ray shortRay = {{0.5f, 0.5f, -2.f}, {0.f, 0.f, 1.f}, 1.5f};
+        CHECK(!bvh->intersect(shortRay, hit));
+        CHECK(!bvh->isOccluded(shortRay));
+
+        MeshBvh::ClosestPoint closest;
+        CHECK(bvh->findClosestPoint({2.f, 0.5f, 1.f}, 10.f, closest));
+        CHECK_NEAR(closest.point.x, 1.f, 1e-6);
+        CHECK_NEAR(closest.point.z, 0.f, 1e-6);
+        CHECK_NEAR(closest.distance, std::sqrt(2.f), 1e-5);
+        CHECK(!bvh->findClosestPoint({2.f, 0.5f, 1.f}, 1.f, closest));
+    }
+}
+
+int main()
+{
+    return Test::run({{"reportsHitDetails", reportsHitDetails},
+                      {"matchesBruteForceOnSphere", matchesBruteForceOnSphere},
+                      {"matchesBruteForceOnSpaceship", matchesBruteForceOnSpaceship}});
+}
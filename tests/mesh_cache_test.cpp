@@ -0,0 +1,206 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "resources/mesh_cache.h"
+#include "resources/meshlet.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// Blob round trips, the options and source stamp checks and the rejection of damaged blobs; the cache directory is
+// relative, so every case runs in a scratch working directory
+namespace
+{
+    const uint64_t OPTIONS_KEY = 0x1234;
+
+    struct CookedMesh
+    {
+        MeshBounds bounds;
+        std::vector<MeshLod> lods;
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<Meshlet> meshlets;
+    };
+
+    void writeFile(const std::string &path, const std::string &bytes)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << bytes;
+    }
+
+    void enterScratchDirectory()
+    {
+        std::filesystem::path scratch = std::filesystem::temp_directory_path() / "mesh_cache_test";
+        std::filesystem::current_path(std::filesystem::temp_directory_path());
+        std::filesystem::remove_all(scratch);
+        std::filesystem::create_directories(scratch);
+        std::filesystem::current_path(scratch);
+        writeFile("grid.obj", "the source text");
+    }
+
+    CookedMesh cookGrid()
+    {
+        CookedMesh mesh;
+        TestMeshes::makeGrid(8, mesh.vertices, mesh.indices);
+        mesh.bounds = MeshBounds::compute(&mesh.vertices[0].pos, mesh.vertices.size(), sizeof(Vertex));
+        uint32_t half = static_cast<uint32_t>(mesh.indices.size() / 6 * 3);
+        mesh.lods = {{0, static_cast<uint32_t>(mesh.indices.size()), 0.f}, {0, half, 0.25f}};
+        // runs of consecutive triangles stand in for meshlets, the cache only stores them
+        for (uint32_t first = 0; first < mesh.indices.size(); first += 32 * 3)
+        {
+            Meshlet meshlet = {};
+            meshlet.firstIndex = first;
+            meshlet.triangleCount = std::min<uint32_t>(32, static_cast<uint32_t>(mesh.indices.size() - first) / 3);
+            meshlet.vertexCount = meshlet.triangleCount + 2;
+            meshlet.center = mesh.vertices[mesh.indices[first]].pos;
+            meshlet.radius = 1.f;
+            meshlet.coneSinAngle = 1.f;
+            mesh.meshlets.push_back(meshlet);
+        }
+        return mesh;
+    }
+
+    void save(const CookedMesh &mesh, uint64_t optionsKey = OPTIONS_KEY)
+    {
+        MeshCache::save("grid.obj", 0, optionsKey, 1.5f, mesh.bounds, mesh.lods, mesh.vertices, mesh.indices, mesh.meshlets);
+    }
+
+    bool load(uint64_t optionsKey = OPTIONS_KEY)
+    {
+        MeshCache::CachedMesh cached;
+        return MeshCache::load("grid.obj", 0, optionsKey, cached);
+    }
+
+    // Patches the header of the saved blob in place
+    void patchHeader(void (*patch)(MeshCache::Header &))
+    {
+        std::string path = MeshCache::getCachePath("grid.obj", 0, OPTIONS_KEY);
+        MeshCache::Header header;
+        {
+            std::ifstream in(path, std::ios::binary);
+            in.read(reinterpret_cast<char *>(&header), sizeof(header));
+        }
+        patch(header);
+        std::fstream out(path, std::ios::binary | std::ios::in | std::ios::out);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    }
+
+    void roundTripsTheCookedData()
+    {
+        enterScratchDirectory();
+        CookedMesh mesh = cookGrid();
+        save(mesh);
+
+        MeshCache::CachedMesh cached;
+        CHECK(MeshCache::load("grid.obj", 0, OPTIONS_KEY, cached));
+        const MeshCache::Header &header = *cached.header;
+        CHECK_EQ(header.vertexCount, uint64_t(mesh.vertices.size()));
+        CHECK_EQ(header.indexCount, uint64_t(mesh.indices.size()));
+        CHECK_EQ(header.meshletCount, uint64_t(mesh.meshlets.size()));
+        CHECK(std::memcmp(cached.vertices, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex)) == 0);
+        CHECK(std::memcmp(cached.indices, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t)) == 0);
+        CHECK(std::memcmp(cached.meshlets, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet)) == 0);
+        CHECK(std::memcmp(&header.bounds, &mesh.bounds, sizeof(MeshBounds)) == 0);
+        CHECK_EQ(header.lodCount, uint32_t(2));
+        CHECK(header.lods[1].indexCount == mesh.lods[1].indexCount && header.lods[1].error == 0.25f);
+        CHECK(header.sourceLoadMs == 1.5f);
+
+        // no temp file is left behind
+        size_t fileCount = 0;
+        for (const auto &entry : std::filesystem::directory_iterator("cache/mesh"))
+        {
+            fileCount += entry.is_regular_file();
+        }
+        CHECK_EQ(fileCount, size_t(1));
+    }
+
+    void keepsOneBlobPerOptions()
+    {
+        enterScratchDirectory();
+        CookedMesh mesh = cookGrid();
+        save(mesh);
+        CHECK(!load(OPTIONS_KEY + 1));
+        CHECK(MeshCache::getCachePath("grid.obj", 0, OPTIONS_KEY) != MeshCache::getCachePath("grid.obj", 0, OPTIONS_KEY + 1));
+        CHECK(MeshCache::getCachePath("grid.obj", 0, OPTIONS_KEY) != MeshCache::getCachePath("grid.obj", 1, OPTIONS_KEY));
+
+        // a second cook of the same source does not replace the first
+        CookedMesh other = mesh;
+        other.lods.resize(1);
+        save(other, OPTIONS_KEY + 1);
+        MeshCache::CachedMesh first, second;
+        CHECK(MeshCache::load("grid.obj", 0, OPTIONS_KEY, first) && first.header->lodCount == 2);
+        CHECK(MeshCache::load("grid.obj", 0, OPTIONS_KEY + 1, second) && second.header->lodCount == 1);
+    }
+
+    void checksTheSourceStamp()
+    {
+        enterScratchDirectory();
+        save(cookGrid());
+        CHECK(load());
+
+        // touched, same content: the hash vouches for it
+        std::filesystem::last_write_time("grid.obj", std::filesystem::last_write_time("grid.obj") + std::chrono::hours(1));
+        CHECK(load());
+
+        // touched, same size, other content
+        writeFile("grid.obj", "the other text!");
+        std::filesystem::last_write_time("grid.obj", std::filesystem::last_write_time("grid.obj") + std::chrono::hours(2));
+        CHECK(!load());
+
+        // other size
+        save(cookGrid());
+        CHECK(load());
+        writeFile("grid.obj", "the other text, longer");
+        CHECK(!load());
+    }
+
+    void rejectsDamagedBlobs()
+    {
+        enterScratchDirectory();
+        save(cookGrid());
+        std::string path = MeshCache::getCachePath("grid.obj", 0, OPTIONS_KEY);
+        std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+        CHECK(!load());
+        std::filesystem::resize_file(path, sizeof(MeshCache::Header) - 1);
+        CHECK(!load());
+
+        // a count whose byte size wraps past the offset
+        save(cookGrid());
+        patchHeader([](MeshCache::Header &header) { header.vertexCount = ~uint64_t(0) / sizeof(Vertex) + 2; });
+        CHECK(!load());
+        save(cookGrid());
+        patchHeader([](MeshCache::Header &header) { header.indexOffset = ~uint64_t(0) - 3; });
+        CHECK(!load());
+
+        // a LOD past the index array
+        save(cookGrid());
+        patchHeader([](MeshCache::Header &header) { header.lods[1].firstIndex = static_cast<uint32_t>(header.indexCount); });
+        CHECK(!load());
+        save(cookGrid());
+        patchHeader([](MeshCache::Header &header) { header.lods[0].indexCount = 0xFFFFFFFFu; });
+        CHECK(!load());
+
+        // a meshlet past the index array
+        CookedMesh mesh = cookGrid();
+        mesh.meshlets.back().triangleCount += 1;
+        save(mesh);
+        CHECK(!load());
+        mesh = cookGrid();
+        mesh.meshlets.front().vertexCount = static_cast<uint32_t>(mesh.vertices.size() + 1);
+        save(mesh);
+        CHECK(!load());
+
+        save(cookGrid());
+        CHECK(load());
+    }
+}
+
+int main()
+{
+    return Test::run({{"roundTripsTheCookedData", roundTripsTheCookedData},
+                      {"keepsOneBlobPerOptions", keepsOneBlobPerOptions},
+                      {"checksTheSourceStamp", checksTheSourceStamp},
+                      {"rejectsDamagedBlobs", rejectsDamagedBlobs}});
+}
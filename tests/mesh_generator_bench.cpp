@@ -0,0 +1,40 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "resources/mesh_generator.h"
+#include <cstdio>
+#include <vector>
+
+// Generated spheres against parsing and indexing sphere.obj: time to a CPU vertex/index buffer and its size
+namespace
+{
+    void report(const char *name, double ms, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices)
+    {
+        std::printf("%-26s %8.3f ms | %6zu vertices %6zu triangles | %7.1f KB\n", name, ms, vertices.size(), indices.size() / 3,
+                    MeshOptimizer::getBufferBytes(vertices.size(), indices.size()) / 1024.0);
+    }
+}
+
+int main()
+{
+    Test::benchmarkHeader("mesh_generator_bench");
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+
+    std::string obj = Test::sourcePath("game/celestial_rover/assets/mesh/sphere.obj");
+    double ms = Test::bestMs(20, [&] { TestMeshes::loadObj(obj, vertices, indices); });
+    report("sphere.obj parse + index", ms, vertices, indices);
+
+    ms = Test::bestMs(20, [&] { MeshGenerator::createUVSphere(32, 16, 1.f, vertices, indices); });
+    report("UV sphere 32x16", ms, vertices, indices);
+
+    ms = Test::bestMs(20, [&] { MeshGenerator::createUVSphere(128, 64, 1.f, vertices, indices); });
+    report("UV sphere 128x64", ms, vertices, indices);
+
+    ms = Test::bestMs(20, [&] { MeshGenerator::createIcosphere(5, 1.f, vertices, indices); });
+    report("icosphere 5", ms, vertices, indices);
+
+    ms = Test::bestMs(5, [&] { MeshGenerator::createIcosphereLods(5, 4, 1.f, vertices, indices, lods); });
+    report("icosphere 5, 4 LODs", ms, vertices, indices);
+    return 0;
+}
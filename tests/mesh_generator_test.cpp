@@ -0,0 +1,163 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "resources/mesh_generator.h"
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    constexpr float PI = 3.14159265f;
+
+    // +1 when the triangle's cross(b - a, c - a) points away from the center, -1 when toward it
+    int windingSign(const std::vector<Vertex> &vertices, const uint32_t *triangle)
+    {
+        DirectX::XMVECTOR a = DirectX::XMLoadFloat3(&vertices[triangle[0]].pos);
+        DirectX::XMVECTOR b = DirectX::XMLoadFloat3(&vertices[triangle[1]].pos);
+        DirectX::XMVECTOR c = DirectX::XMLoadFloat3(&vertices[triangle[2]].pos);
+        DirectX::XMVECTOR n = DirectX::XMVector3Cross(DirectX::XMVectorSubtract(b, a), DirectX::XMVectorSubtract(c, a));
+        DirectX::XMVECTOR centroid = DirectX::XMVectorAdd(DirectX::XMVectorAdd(a, b), c);
+        return DirectX::XMVectorGetX(DirectX::XMVector3Dot(n, centroid)) > 0.f ? 1 : -1;
+    }
+
+    // The winding every triangle of sphere.obj has after the loader's handedness flip
+    int objWinding()
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::loadObj(Test::sourcePath("game/celestial_rover/assets/mesh/sphere.obj"), vertices, indices);
+        return windingSign(vertices, indices.data());
+    }
+
+    void checkSphere(const std::vector<Vertex> &vertices, const uint32_t *indices, size_t indexCount, float radius, int expectedWinding)
+    {
+        bool onSphere = true, normalsOutward = true, uvsInRange = true, uvsFollowConvention = true, windingMatches = true;
+        for (const Vertex &v : vertices)
+        {
+            float length = std::sqrt(v.pos.x * v.pos.x + v.pos.y * v.pos.y + v.pos.z * v.pos.z);
+            onSphere = onSphere && std::fabs(length - radius) < 1e-4f * radius;
+            normalsOutward = normalsOutward && std::fabs(v.n.x * radius - v.pos.x) < 1e-4f * radius && std::fabs(v.n.y * radius - v.pos.y) < 1e-4f * radius &&
+                             std::fabs(v.n.z * radius - v.pos.z) < 1e-4f * radius;
+            // seam triangles may carry u + 1 on their low side, the texture wraps
+            uvsInRange = uvsInRange && v.uv.x >= -1e-6f && v.uv.x <= 1.25f && v.uv.y >= -1e-6f && v.uv.y <= 1.f + 1e-6f;
+
+            // away from the poles u is fixed by the convention up to the seam, where it is 0 or 1
+            if (std::fabs(v.n.y) < 0.999f)
+            {
+                float u = 0.75f - std::atan2(v.n.x, v.n.z) / (2.f * PI);
+                float du = std::fabs(v.uv.x - u);
+                du = std::min({du, std::fabs(du - 1.f), std::fabs(du - 2.f)});
+                uvsFollowConvention = uvsFollowConvention && du < 1e-4f && std::fabs(v.uv.y - std::acos(v.n.y) / PI) < 1e-4f;
+            }
+        }
+        for (size_t t = 0; t < indexCount; t += 3)
+        {
+            windingMatches = windingMatches && windingSign(vertices, indices + t) == expectedWinding;
+        }
+        CHECK(onSphere);
+        CHECK(normalsOutward);
+        CHECK(uvsInRange);
+        CHECK(uvsFollowConvention);
+        CHECK(windingMatches);
+    }
+
+    void createsUVSphere()
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        MeshGenerator::createUVSphere(32, 16, 2.f, vertices, indices);
+        CHECK_EQ(indices.size(), size_t(32 * (16 - 2) * 6 + 2 * 32 * 3)); // quads between the rings, one triangle per segment at the poles
+        checkSphere(vertices, indices.data(), indices.size(), 2.f, objWinding());
+    }
+
+    void createsIcosphere()
+    {
+        int winding = objWinding();
+        for (uint32_t subdivisions = 0; subdivisions <= 4; ++subdivisions)
+        {
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+            MeshGenerator::createIcosphere(subdivisions, 1.f, vertices, indices);
+            CHECK_EQ(indices.size(), size_t(20 * 3) << (2 * subdivisions));
+            checkSphere(vertices, indices.data(), indices.size(), 1.f, winding);
+        }
+    }
+
+    void createsIcosphereLods()
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<MeshLod> lods;
+        MeshGenerator::createIcosphereLods(5, 4, 1.f, vertices, indices, lods);
+        CHECK_EQ(lods.size(), size_t(4));
+        if (lods.size() != 4)
+        {
+            return;
+        }
+
+        uint32_t next = 0;
+        for (size_t level = 0; level < lods.size(); ++level)
+        {
+            const MeshLod &lod = lods[level];
+            CHECK_EQ(lod.firstIndex, next);
+            CHECK_EQ(lod.indexCount, uint32_t(20 * 3) << (2 * (5 - level)));
+            next = lod.firstIndex + lod.indexCount;
+            checkSphere(vertices, indices.data() + lod.firstIndex, lod.indexCount, 1.f, objWinding());
+
+            // coarse levels: the error covers the flat triangles' distance from the sphere, and grows with the level
+            float maxDistance = 0.f;
+            for (uint32_t t = lod.firstIndex; t < next; t += 3)
+            {
+                DirectX::XMVECTOR centroid = DirectX::XMVectorScale(DirectX::XMVectorAdd(DirectX::XMVectorAdd(DirectX::XMLoadFloat3(&vertices[indices[t]].pos),
+                                                                                                              DirectX::XMLoadFloat3(&vertices[indices[t + 1]].pos)),
+                                                                                        DirectX::XMLoadFloat3(&vertices[indices[t + 2]].pos)),
+                                                                    1.f / 3.f);
+                maxDistance = std::max(maxDistance, 1.f - DirectX::XMVectorGetX(DirectX::XMVector3Length(centroid)));
+            }
+            CHECK(level == 0 ? lod.error == 0.f : lod.error >= maxDistance * 0.999f);
+            CHECK(level == 0 || lod.error > lods[level - 1].error);
+        }
+        CHECK_EQ(next, indices.size());
+    }
+
+    void weldKeepsLodRangesInStep()
+    {
+        // a weld that collapses the finest level's small triangles, the coarse levels keep theirs
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<MeshLod> lods;
+        MeshGenerator::createIcosphereLods(4, 3, 1.f, vertices, indices, lods);
+        for (Vertex &v : vertices)
+        {
+            v.n = {0.f, 1.f, 0.f}; // only positions decide
+            v.uv = {0.f, 0.f};
+        }
+        std::vector<MeshLod> before = lods;
+
+        MeshOptimizer::weldVertices(vertices, indices, 0.06f, &lods);
+        uint32_t next = 0;
+        for (size_t level = 0; level < lods.size(); ++level)
+        {
+            CHECK_EQ(lods[level].firstIndex, next);
+            CHECK(lods[level].indexCount <= before[level].indexCount);
+            next = lods[level].firstIndex + lods[level].indexCount;
+        }
+        CHECK_EQ(next, indices.size());
+        CHECK(lods[0].indexCount < before[0].indexCount);
+        CHECK_EQ(lods[2].indexCount, before[2].indexCount);
+
+        bool nonDegenerate = true;
+        for (size_t t = 0; t < indices.size(); t += 3)
+        {
+            nonDegenerate = nonDegenerate && indices[t] != indices[t + 1] && indices[t + 1] != indices[t + 2] && indices[t] != indices[t + 2];
+        }
+        CHECK(nonDegenerate);
+    }
+}
+
+int main()
+{
+    return Test::run({{"createsUVSphere", createsUVSphere},
+                      {"createsIcosphere", createsIcosphere},
+                      {"createsIcosphereLods", createsIcosphereLods},
+                      {"weldKeepsLodRangesInStep", weldKeepsLodRangesInStep}});
+}
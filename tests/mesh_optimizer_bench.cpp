@@ -0,0 +1,44 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "resources/mesh_optimizer.h"
+#include <cstdio>
+#include <vector>
+
+// ACMR/ATVR before and after the vertex cache and overdraw passes, and the time the cache pass takes
+namespace
+{
+    void measure(const char *name, const std::vector<Vertex> &sourceVertices, const std::vector<uint32_t> &sourceIndices)
+    {
+        std::vector<uint32_t> indices;
+        auto before = MeshOptimizer::analyzeVertexCache(sourceIndices.data(), sourceIndices.size(), sourceVertices.size());
+        double cacheMs = Test::bestMs(5, [&] {
+            indices = sourceIndices;
+            MeshOptimizer::optimizeVertexCache(indices, sourceVertices.size());
+        });
+        auto afterCache = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), sourceVertices.size());
+        std::vector<Vertex> vertices = sourceVertices;
+        MeshOptimizer::optimizeOverdraw(vertices, indices);
+        auto afterOverdraw = MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+        std::printf("%-14s %8zu tris | ACMR %.3f -> %.3f (overdraw %.3f) | ATVR %.3f -> %.3f | %8.2f ms, %6.1f Mtri/s\n", name,
+                    sourceIndices.size() / 3, before.acmr, afterCache.acmr, afterOverdraw.acmr, before.atvr, afterCache.atvr, cacheMs,
+                    sourceIndices.size() / 3 / (cacheMs * 1000.0));
+    }
+}
+
+int main()
+{
+    Test::benchmarkHeader("mesh_optimizer_bench");
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (const char *asset : {"game/celestial_rover/assets/mesh/sphere.obj", "game/celestial_rover/assets/mesh/spaceship.obj"})
+    {
+        TestMeshes::loadObj(Test::sourcePath(asset), vertices, indices);
+        measure(asset + std::string(asset).rfind('/') + 1, vertices, indices);
+    }
+    TestMeshes::makeGrid(512, vertices, indices);
+    measure("grid 512^2", vertices, indices);
+    TestMeshes::shuffleTriangles(indices);
+    measure("shuffled grid", vertices, indices);
+    return 0;
+}
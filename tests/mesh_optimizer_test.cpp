@@ -0,0 +1,238 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "resources/mesh_optimizer.h"
+#include "utils/mapped_file.h"
+#include <string>
+#include <vector>
+
+namespace
+{
+    float acmr(const std::vector<uint32_t> &indices, size_t vertexCount)
+    {
+        return MeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), vertexCount).acmr;
+    }
+
+    void indexesUniqueCorners()
+    {
+        // corners shared by faces become one vertex: a cube's 36 corners are 24 (v, t, n) triples
+        struct Expected
+        {
+            const char *asset;
+            size_t corners, vertices;
+        };
+        for (Expected expected : {Expected{"game/celestial_rover/assets/mesh/cube.obj", 36, 24},
+                                  Expected{"game/celestial_rover/assets/mesh/sphere.obj", 2880, 1984}})
+        {
+            MappedFile file(Test::sourcePath(expected.asset));
+            ObjParser::Result obj = ObjParser::parse(file.data(), file.end());
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+            MeshOptimizer::IndexingStats stats = MeshOptimizer::indexCorners(obj, vertices, indices);
+            CHECK_EQ(stats.vertexCountBefore, expected.corners);
+            CHECK_EQ(stats.vertexCountAfter, expected.vertices);
+            CHECK_EQ(vertices.size(), expected.vertices);
+            CHECK_EQ(indices.size(), expected.corners);
+            // one vertex per corner and 32 bit indices before, one per unique corner after
+            CHECK_EQ(stats.bytesBefore, expected.corners * (sizeof(Vertex) + sizeof(uint32_t)));
+            CHECK_EQ(stats.bytesAfter, expected.vertices * sizeof(Vertex) + expected.corners * sizeof(uint32_t));
+
+            // every corner still resolves to its own attributes
+            bool sameAttributes = true;
+            for (size_t i = 0; i < obj.corners.size(); ++i)
+            {
+                const Vertex &vertex = vertices[indices[i]];
+                const DirectX::XMINT3 &corner = obj.corners[i];
+                sameAttributes = sameAttributes && TestMeshes::vertexKey(vertex) ==
+                                                       TestMeshes::vertexKey(Vertex(obj.positions[corner.x], obj.normals[corner.z], obj.texCoords[corner.y]));
+            }
+            CHECK(sameAttributes);
+        }
+    }
+
+    void missingAttributesResolveToZero()
+    {
+        // index 0 is the parser's zero sentinel: no uv and no normal (z flips to left handed)
+        std::string source = "v 1 2 3\nv 4 5 6\nv 7 8 9\nvn 0 0 1\nf 1 2 3\nf 1//1 2//1 3//1\n";
+        ObjParser::Result obj = ObjParser::parse(source.data(), source.data() + source.size());
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        MeshOptimizer::indexCorners(obj, vertices, indices);
+        CHECK_EQ(vertices.size(), size_t(6));
+        const Vertex &bare = vertices[indices[0]];
+        CHECK(bare.pos.x == 1.f && bare.pos.y == 2.f && bare.pos.z == -3.f);
+        CHECK(bare.n.x == 0.f && bare.n.y == 0.f && bare.n.z == 0.f);
+        CHECK(bare.uv.x == 0.f && bare.uv.y == 0.f);
+        const Vertex &lit = vertices[indices[3]];
+        CHECK(lit.n.z == -1.f && lit.uv.x == 0.f && lit.uv.y == 0.f);
+    }
+
+    void weldsWithinEpsilon()
+    {
+        // epsilon and twice it are exact in binary, so the boundary is tested and not the rounding
+        const float epsilon = 0.25f;
+        auto weld = [](float offset, float epsilon)
+        {
+            std::vector<Vertex> vertices = {Vertex({0.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f}),
+                                            Vertex({offset, 0.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f}),
+                                            Vertex({0.f, 4.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f}),
+                                            Vertex({4.f, 4.f, 0.f}, {0.f, 1.f, 0.f}, {0.f, 0.f})};
+            std::vector<uint32_t> indices = {0, 2, 3, 1, 3, 2};
+            MeshOptimizer::weldVertices(vertices, indices, epsilon);
+            return vertices.size();
+        };
+        CHECK_EQ(weld(epsilon, epsilon), size_t(3));
+        CHECK_EQ(weld(2.f * epsilon, epsilon), size_t(4));
+
+        // epsilon 0 leaves the buffers as they are
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::makeGrid(8, vertices, indices);
+        vertices.push_back(vertices[0]);
+        indices[0] = static_cast<uint32_t>(vertices.size() - 1);
+        std::vector<Vertex> before = vertices;
+        std::vector<uint32_t> indicesBefore = indices;
+        MeshOptimizer::IndexingStats stats = MeshOptimizer::weldVertices(vertices, indices, 0.f);
+        CHECK_EQ(vertices.size(), before.size());
+        CHECK(indices == indicesBefore);
+        CHECK(stats.vertexCountBefore == stats.vertexCountAfter && stats.bytesBefore == stats.bytesAfter);
+
+        // the duplicate goes with any epsilon, and takes its bytes with it
+        stats = MeshOptimizer::weldVertices(vertices, indices, 1e-6f);
+        CHECK_EQ(vertices.size(), before.size() - 1);
+        CHECK_EQ(stats.bytesBefore - stats.bytesAfter, sizeof(Vertex));
+        CHECK(TestMeshes::triangleSet(vertices, indices) == TestMeshes::triangleSet(before, indicesBefore));
+    }
+
+    void dropsCollapsedTrianglesAndRewritesLods()
+    {
+        // two LODs of three and two triangles; vertices 1 and 4 weld, which collapses the second triangle of each
+        std::vector<Vertex> vertices;
+        for (float x : {0.f, 1.f, 2.f, 3.f, 1.001f, 5.f})
+        {
+            vertices.push_back(Vertex({x, x * x, 0.f}, {0.f, 0.f, 1.f}, {0.f, 0.f}));
+        }
+        vertices[4].pos.y = 1.f;
+        std::vector<uint32_t> indices = {0, 1, 2, 1, 4, 3, 2, 3, 5,
+                                         4, 1, 5, 0, 2, 5};
+        std::vector<MeshLod> lods = {{0, 9, 0.f}, {9, 6, 0.5f}};
+        MeshOptimizer::IndexingStats stats = MeshOptimizer::weldVertices(vertices, indices, 0.01f, &lods);
+
+        CHECK_EQ(stats.vertexCountAfter, size_t(5));
+        CHECK_EQ(indices.size(), size_t(9));
+        CHECK(lods[0].firstIndex == 0 && lods[0].indexCount == 6);
+        CHECK(lods[1].firstIndex == 6 && lods[1].indexCount == 3);
+        CHECK(lods[1].error == 0.5f);
+        CHECK_EQ(stats.bytesAfter, MeshOptimizer::getBufferBytes(5, 9));
+
+        // the kept triangles are the ones that were not degenerate, in their order
+        std::vector<uint32_t> expected = {0, 1, 2, 2, 3, 4, 0, 2, 4};
+        CHECK(indices == expected);
+    }
+
+    void analyzesFifoCache()
+    {
+        // one triangle misses three times, a strip of two shares an edge
+        std::vector<uint32_t> triangle = {0, 1, 2};
+        MeshOptimizer::VertexCacheStats stats = MeshOptimizer::analyzeVertexCache(triangle.data(), triangle.size(), 3);
+        CHECK_NEAR(stats.acmr, 3.f, 1e-6);
+        CHECK_NEAR(stats.atvr, 1.f, 1e-6);
+
+        std::vector<uint32_t> strip = {0, 1, 2, 2, 1, 3};
+        CHECK_NEAR(acmr(strip, 4), 2.f, 1e-6);
+
+        // a cache of 3 forgets vertex 0 by the time the third triangle wants it again
+        std::vector<uint32_t> evicted = {0, 1, 2, 3, 4, 5, 0, 1, 2};
+        stats = MeshOptimizer::analyzeVertexCache(evicted.data(), evicted.size(), 6, 3);
+        CHECK_NEAR(stats.acmr, 3.f, 1e-6);
+        CHECK_NEAR(stats.atvr, 1.5f, 1e-6);
+    }
+
+    void vertexCacheOrderKeepsTrianglesAndLowersAcmr()
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::makeGrid(64, vertices, indices);
+        TestMeshes::shuffleTriangles(indices);
+        auto triangles = TestMeshes::triangleSet(vertices, indices);
+        float before = acmr(indices, vertices.size());
+
+        MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+        CHECK(TestMeshes::triangleSet(vertices, indices) == triangles);
+        float after = acmr(indices, vertices.size());
+        CHECK(before > 2.5f);
+        CHECK(after < 0.8f); // a regular grid reaches ~0.6-0.7 with a 16 entry FIFO
+
+        // deterministic: the same input gives the same order
+        std::vector<uint32_t> shuffled = indices;
+        TestMeshes::shuffleTriangles(shuffled, 7);
+        std::vector<uint32_t> first = shuffled, second = shuffled;
+        MeshOptimizer::optimizeVertexCache(first, vertices.size());
+        MeshOptimizer::optimizeVertexCache(second, vertices.size());
+        CHECK(first == second);
+    }
+
+    void overdrawOrderStaysWithinThreshold()
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::loadObj(Test::sourcePath("game/celestial_rover/assets/mesh/spaceship.obj"), vertices, indices);
+        MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+        auto triangles = TestMeshes::triangleSet(vertices, indices);
+        float cacheOrdered = acmr(indices, vertices.size());
+
+        MeshOptimizer::optimizeOverdraw(vertices, indices, 1.05f);
+        CHECK(TestMeshes::triangleSet(vertices, indices) == triangles);
+        CHECK(acmr(indices, vertices.size()) <= cacheOrdered * 1.05f + 1e-4f);
+    }
+
+    void vertexFetchOrderIsFirstUse()
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::loadObj(Test::sourcePath("game/celestial_rover/assets/mesh/sphere.obj"), vertices, indices);
+        MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+        vertices.push_back(Vertex({9.f, 9.f, 9.f}, {0.f, 1.f, 0.f}, {0.f, 0.f})); // unused
+        auto triangles = TestMeshes::triangleSet(vertices, indices);
+        size_t usedCount = vertices.size() - 1;
+
+        MeshOptimizer::optimizeVertexFetch(vertices, indices);
+        CHECK_EQ(vertices.size(), usedCount);
+        CHECK(TestMeshes::triangleSet(vertices, indices) == triangles);
+
+        // every index is at most one past the largest seen so far
+        uint32_t next = 0;
+        bool firstUseOrder = true;
+        for (uint32_t index : indices)
+        {
+            firstUseOrder = firstUseOrder && index <= next;
+            next = std::max(next, index + 1);
+        }
+        CHECK(firstUseOrder);
+    }
+
+    void optimizesAssetsBelowTheirSourceAcmr()
+    {
+        for (const char *asset : {"game/celestial_rover/assets/mesh/sphere.obj", "game/celestial_rover/assets/mesh/spaceship.obj"})
+        {
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+            TestMeshes::loadObj(Test::sourcePath(asset), vertices, indices);
+            float before = acmr(indices, vertices.size());
+            MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+            CHECK(acmr(indices, vertices.size()) <= before);
+        }
+    }
+}
+
+int main()
+{
+    return Test::run({{"indexesUniqueCorners", indexesUniqueCorners},
+                      {"missingAttributesResolveToZero", missingAttributesResolveToZero},
+                      {"weldsWithinEpsilon", weldsWithinEpsilon},
+                      {"dropsCollapsedTrianglesAndRewritesLods", dropsCollapsedTrianglesAndRewritesLods},
+                      {"analyzesFifoCache", analyzesFifoCache},
+                      {"vertexCacheOrderKeepsTrianglesAndLowersAcmr", vertexCacheOrderKeepsTrianglesAndLowersAcmr},
+                      {"overdrawOrderStaysWithinThreshold", overdrawOrderStaysWithinThreshold},
+                      {"vertexFetchOrderIsFirstUse", vertexFetchOrderIsFirstUse},
+                      {"optimizesAssetsBelowTheirSourceAcmr", optimizesAssetsBelowTheirSourceAcmr}});
+}
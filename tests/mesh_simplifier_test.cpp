@@ -0,0 +1,115 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "resources/mesh_simplifier.h"
+#include <cmath>
+#include <set>
+#include <vector>
+
+namespace
+{
+    DirectX::XMFLOAT3 triangleNormal(const std::vector<Vertex> &vertices, const uint32_t *triangle)
+    {
+        const DirectX::XMFLOAT3 &a = vertices[triangle[0]].pos, &b = vertices[triangle[1]].pos, &c = vertices[triangle[2]].pos;
+        DirectX::XMFLOAT3 ab = {b.x - a.x, b.y - a.y, b.z - a.z}, ac = {c.x - a.x, c.y - a.y, c.z - a.z};
+        return {ab.y * ac.z - ab.z * ac.y, ab.z * ac.x - ab.x * ac.z, ab.x * ac.y - ab.y * ac.x}; // length = 2 * area
+    }
+
+    void checkWellFormed(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &result, const MeshSimplifier::Result &stats)
+    {
+        CHECK_EQ(result.size(), stats.triangleCount * 3);
+        bool valid = true;
+        for (size_t t = 0; t + 2 < result.size(); t += 3)
+        {
+            valid = valid && result[t] < vertices.size() && result[t + 1] < vertices.size() && result[t + 2] < vertices.size();
+            valid = valid && result[t] != result[t + 1] && result[t + 1] != result[t + 2] && result[t] != result[t + 2];
+        }
+        CHECK(valid);
+        CHECK(std::isfinite(stats.error) && stats.error >= 0.f);
+    }
+
+    void flatGridCollapsesInteriorWithoutError()
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::makeGrid(16, vertices, indices);
+        for (Vertex &v : vertices)
+        {
+            v.pos.y = 0.f;
+        }
+
+        std::vector<uint32_t> result;
+        MeshSimplifier::Result stats = MeshSimplifier::simplify(vertices, indices.data(), indices.size(), 0, 1e-6f, result);
+        checkWellFormed(vertices, result, stats);
+        CHECK(stats.triangleCount < indices.size() / 3 / 4);
+        CHECK(stats.error <= 1e-6f);
+
+        // no triangle flips and the plane stays covered: every normal points up and the areas add up to the grid
+        double area = 0.0;
+        bool facingUp = true;
+        for (size_t t = 0; t < result.size(); t += 3)
+        {
+            DirectX::XMFLOAT3 n = triangleNormal(vertices, &result[t]);
+            facingUp = facingUp && n.y > 0.f;
+            area += 0.5 * n.y;
+        }
+        CHECK(facingUp);
+        CHECK_NEAR(area, 16.0 * 16.0, 1e-3);
+
+        // the open boundary is locked, each border vertex is still referenced
+        std::set<uint32_t> used(result.begin(), result.end());
+        bool boundaryKept = true;
+        for (uint32_t i = 0; i < vertices.size(); ++i)
+        {
+            const DirectX::XMFLOAT3 &p = vertices[i].pos;
+            if (p.x == 0.f || p.x == 16.f || p.z == 0.f || p.z == 16.f)
+            {
+                boundaryKept = boundaryKept && used.count(i) == 1;
+            }
+        }
+        CHECK(boundaryKept);
+    }
+
+    void stopsAtTargetIndexCount()
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::loadObj(Test::sourcePath("game/celestial_rover/assets/mesh/sphere.obj"), vertices, indices);
+
+        std::vector<uint32_t> half, quarter;
+        MeshSimplifier::Result halfStats = MeshSimplifier::simplify(vertices, indices.data(), indices.size(), indices.size() / 2, 1e30f, half);
+        MeshSimplifier::Result quarterStats = MeshSimplifier::simplify(vertices, indices.data(), indices.size(), indices.size() / 4, 1e30f, quarter);
+        checkWellFormed(vertices, half, halfStats);
+        checkWellFormed(vertices, quarter, quarterStats);
+        CHECK(half.size() <= indices.size() / 2);
+        CHECK(quarter.size() <= indices.size() / 4);
+        CHECK(half.size() > indices.size() / 4); // stops near the target, not far below it
+        CHECK(quarterStats.error >= halfStats.error);
+        CHECK(halfStats.error > 0.f);
+    }
+
+    void stopsAtTargetError()
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::loadObj(Test::sourcePath("game/celestial_rover/assets/mesh/sphere.obj"), vertices, indices);
+
+        // every collapse on a curved surface costs something, none fits under a tiny bound
+        std::vector<uint32_t> result;
+        MeshSimplifier::Result stats = MeshSimplifier::simplify(vertices, indices.data(), indices.size(), 0, 1e-7f, result);
+        CHECK_EQ(stats.triangleCount, indices.size() / 3);
+        CHECK(stats.error <= 1e-7f);
+
+        float bound = 0.02f;
+        stats = MeshSimplifier::simplify(vertices, indices.data(), indices.size(), 0, bound, result);
+        checkWellFormed(vertices, result, stats);
+        CHECK(stats.triangleCount < indices.size() / 3);
+        CHECK(stats.error <= bound);
+    }
+}
+
+int main()
+{
+    return Test::run({{"flatGridCollapsesInteriorWithoutError", flatGridCollapsesInteriorWithoutError},
+                      {"stopsAtTargetIndexCount", stopsAtTargetIndexCount},
+                      {"stopsAtTargetError", stopsAtTargetError}});
+}
@@ -0,0 +1,73 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "resources/meshlet.h"
+#include "utils/frustum.h"
+#include <cstdio>
+#include <vector>
+
+// Meshlet build time after the vertex cache pass, and frustum + normal cone cull rate over the result
+namespace
+{
+    void measure(const char *name, const std::vector<Vertex> &vertices, std::vector<uint32_t> indices, const DirectX::XMMATRIX &viewProjection,
+                 const DirectX::XMFLOAT3 &cameraPosition)
+    {
+        MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+        std::vector<Meshlet> meshlets;
+        std::vector<uint32_t> scratch;
+        double buildMs = Test::bestMs(3, [&] {
+            scratch = indices;
+            meshlets.clear();
+            MeshletBuilder::build(vertices, scratch.data(), scratch.size(), 0, MeshletBuilder::MAX_VERTICES, MeshletBuilder::MAX_TRIANGLES, meshlets);
+        });
+
+        Frustum frustum = Frustum::fromMatrix(viewProjection);
+        size_t frustumCulled = 0, coneCulled = 0;
+        const int passes = 200;
+        double cullMs = Test::bestMs(3, [&] {
+            frustumCulled = coneCulled = 0;
+            for (int pass = 0; pass < passes; ++pass)
+            {
+                for (const Meshlet &meshlet : meshlets)
+                {
+                    if (!frustum.intersectsSphere(meshlet.center, meshlet.radius))
+                    {
+                        ++frustumCulled;
+                    }
+                    else if (MeshletBuilder::isBackfacing(meshlet, cameraPosition))
+                    {
+                        ++coneCulled;
+                    }
+                }
+            }
+        });
+
+        size_t tested = meshlets.size() * passes;
+        std::printf("%-12s %8zu tris %6zu meshlets | build %8.2f ms %6.2f Mtri/s | cull %7.1f Mmeshlets/s, %4.1f%% frustum %4.1f%% cone\n", name,
+                    indices.size() / 3, meshlets.size(), buildMs, indices.size() / 3 / (buildMs * 1000.0), tested / (cullMs * 1000.0),
+                    100.0 * frustumCulled / tested, 100.0 * coneCulled / tested);
+    }
+}
+
+int main()
+{
+    Test::benchmarkHeader("meshlet_bench");
+    DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(60.f), 16.f / 9.f, 0.1f, 1000.f);
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+
+    // meshes around the origin, seen from 4 units away on -z
+    DirectX::XMFLOAT3 camera = {0.f, 0.f, -4.f};
+    DirectX::XMMATRIX view = DirectX::XMMatrixTranslation(-camera.x, -camera.y, -camera.z);
+    for (const char *asset : {"game/celestial_rover/assets/mesh/sphere.obj", "game/celestial_rover/assets/mesh/spaceship.obj"})
+    {
+        TestMeshes::loadObj(Test::sourcePath(asset), vertices, indices);
+        measure(asset + std::string(asset).rfind('/') + 1, vertices, indices, view * projection, camera);
+    }
+
+    // terrain seen from above one corner, most of it outside the frustum
+    TestMeshes::makeGrid(512, vertices, indices);
+    camera = {32.f, 20.f, -10.f};
+    view = DirectX::XMMatrixTranslation(-camera.x, -camera.y, -camera.z);
+    measure("grid 512^2", vertices, indices, view * projection, camera);
+    return 0;
+}
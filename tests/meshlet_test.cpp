@@ -0,0 +1,136 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "resources/meshlet.h"
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace
+{
+    DirectX::XMVECTOR position(const std::vector<Vertex> &vertices, uint32_t index) { return DirectX::XMLoadFloat3(&vertices[index].pos); }
+
+    // Face normal turned to the side the vertex normals point to, like MeshletBuilder does
+    DirectX::XMVECTOR frontNormal(const std::vector<Vertex> &vertices, const uint32_t *triangle)
+    {
+        DirectX::XMVECTOR a = position(vertices, triangle[0]);
+        DirectX::XMVECTOR n = DirectX::XMVector3Cross(DirectX::XMVectorSubtract(position(vertices, triangle[1]), a),
+                                                      DirectX::XMVectorSubtract(position(vertices, triangle[2]), a));
+        DirectX::XMVECTOR vertexNormals = DirectX::XMVectorZero();
+        for (int k = 0; k < 3; ++k)
+        {
+            vertexNormals = DirectX::XMVectorAdd(vertexNormals, DirectX::XMLoadFloat3(&vertices[triangle[k]].n));
+        }
+        return DirectX::XMVectorGetX(DirectX::XMVector3Dot(n, vertexNormals)) < 0.f ? DirectX::XMVectorNegate(n) : n;
+    }
+
+    void checkMeshlets(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, uint32_t firstIndex, size_t indexCount,
+                       const std::vector<Meshlet> &meshlets, uint32_t maxVertices, uint32_t maxTriangles)
+    {
+        // contiguous ranges covering [firstIndex, firstIndex + indexCount)
+        uint32_t next = firstIndex;
+        bool contiguous = true, withinLimits = true, vertexCountsMatch = true, spheresContain = true;
+        for (const Meshlet &meshlet : meshlets)
+        {
+            contiguous = contiguous && meshlet.firstIndex == next && meshlet.triangleCount > 0;
+            next = meshlet.firstIndex + meshlet.triangleCount * 3;
+            withinLimits = withinLimits && meshlet.triangleCount <= maxTriangles && meshlet.vertexCount <= maxVertices;
+
+            std::set<uint32_t> unique(indices.begin() + meshlet.firstIndex, indices.begin() + next);
+            vertexCountsMatch = vertexCountsMatch && unique.size() == meshlet.vertexCount;
+            for (uint32_t index : unique)
+            {
+                float distance = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMVectorSubtract(position(vertices, index), DirectX::XMLoadFloat3(&meshlet.center))));
+                spheresContain = spheresContain && distance <= meshlet.radius * 1.0001f + 1e-6f;
+            }
+        }
+        CHECK(contiguous);
+        CHECK_EQ(next, firstIndex + indexCount);
+        CHECK(withinLimits);
+        CHECK(vertexCountsMatch);
+        CHECK(spheresContain);
+    }
+
+    void coversEveryTriangleWithinLimits()
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::loadObj(Test::sourcePath("game/celestial_rover/assets/mesh/spaceship.obj"), vertices, indices);
+        auto triangles = TestMeshes::triangleSet(vertices, indices);
+
+        std::vector<Meshlet> meshlets;
+        MeshletBuilder::build(vertices, indices.data(), indices.size(), 0, MeshletBuilder::MAX_VERTICES, MeshletBuilder::MAX_TRIANGLES, meshlets);
+        CHECK(TestMeshes::triangleSet(vertices, indices) == triangles);
+        checkMeshlets(vertices, indices, 0, indices.size(), meshlets, MeshletBuilder::MAX_VERTICES, MeshletBuilder::MAX_TRIANGLES);
+
+        // small limits on a grid, most meshlets are full
+        TestMeshes::makeGrid(32, vertices, indices);
+        meshlets.clear(); // build appends
+        MeshletBuilder::build(vertices, indices.data(), indices.size(), 0, 16, 12, meshlets);
+        checkMeshlets(vertices, indices, 0, indices.size(), meshlets, 16, 12);
+        CHECK(meshlets.size() <= indices.size() / 3 / 12 * 2);
+    }
+
+    void rewritesOnlyItsRange()
+    {
+        // the second half of a shared index buffer, like an LOD range
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::makeGrid(16, vertices, indices);
+        uint32_t firstIndex = static_cast<uint32_t>(indices.size() / 2);
+        std::vector<uint32_t> prefix(indices.begin(), indices.begin() + firstIndex);
+
+        std::vector<Meshlet> meshlets;
+        MeshletBuilder::build(vertices, indices.data(), indices.size() - firstIndex, firstIndex, 64, 32, meshlets);
+        CHECK(std::equal(prefix.begin(), prefix.end(), indices.begin()));
+        checkMeshlets(vertices, indices, firstIndex, indices.size() - firstIndex, meshlets, 64, 32);
+    }
+
+    void backfacingIsConservative()
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::loadObj(Test::sourcePath("game/celestial_rover/assets/mesh/sphere.obj"), vertices, indices);
+        std::vector<Meshlet> meshlets;
+        MeshletBuilder::build(vertices, indices.data(), indices.size(), 0, MeshletBuilder::MAX_VERTICES, 32, meshlets);
+
+        // whenever a meshlet is culled, each of its triangles faces away from the camera
+        std::mt19937 random(3);
+        std::uniform_real_distribution<float> coordinate(-6.f, 6.f);
+        size_t culled = 0, wronglyCulled = 0;
+        for (int camera = 0; camera < 200; ++camera)
+        {
+            DirectX::XMFLOAT3 cameraPosition = {coordinate(random), coordinate(random), coordinate(random)};
+            for (const Meshlet &meshlet : meshlets)
+            {
+                if (!MeshletBuilder::isBackfacing(meshlet, cameraPosition))
+                {
+                    continue;
+                }
+                ++culled;
+                for (uint32_t t = 0; t < meshlet.triangleCount; ++t)
+                {
+                    const uint32_t *triangle = &indices[meshlet.firstIndex + t * 3];
+                    DirectX::XMVECTOR toCamera = DirectX::XMVectorSubtract(DirectX::XMLoadFloat3(&cameraPosition), position(vertices, triangle[0]));
+                    if (DirectX::XMVectorGetX(DirectX::XMVector3Dot(frontNormal(vertices, triangle), toCamera)) > 0.f)
+                    {
+                        ++wronglyCulled;
+                    }
+                }
+            }
+        }
+        CHECK(culled > 0);
+        CHECK_EQ(wronglyCulled, size_t(0));
+
+        // a camera inside the bounding sphere never culls
+        Meshlet meshlet = meshlets[0];
+        CHECK(!MeshletBuilder::isBackfacing(meshlet, meshlet.center));
+    }
+}
+
+int main()
+{
+    return Test::run({{"coversEveryTriangleWithinLimits", coversEveryTriangleWithinLimits},
+                      {"rewritesOnlyItsRange", rewritesOnlyItsRange},
+                      {"backfacingIsConservative", backfacingIsConservative}});
+}
@@ -0,0 +1,41 @@
+#include "test_common.h"
+#include "resources/mip_generator.h"
+#include "resources/png_decoder.h"
+#include "utils/mapped_file.h"
+#include <cstdio>
+
+// Megapixels/s of full chain generation on the texture assets, per filter. Counted as level 0 pixels in, which
+// is what a load has to push through
+int main()
+{
+    Test::benchmarkHeader("mip_generator");
+    for (const char *asset : {"engine/assets/texture/checker.png", "engine/assets/texture/checker-map_tho.png",
+                              "game/celestial_rover/assets/texture/earth.png", "game/celestial_rover/assets/texture/galaxy.png",
+                              "game/celestial_rover/assets/texture/moon.png", "game/celestial_rover/assets/texture/sun.png"})
+    {
+        MappedFile file(Test::sourcePath(asset));
+        if (!PngDecoder::isPng(file.data(), file.size()))
+        {
+            std::printf("%s: not a PNG (the engine hands it to WIC), skipped\n", asset);
+            continue;
+        }
+        DecodedImage image = PngDecoder::decode(reinterpret_cast<const uint8_t *>(file.data()), file.size(), asset);
+        double megapixels = image.width * static_cast<double>(image.height) / 1e6;
+        std::printf("%s: %ux%u %s\n", asset, image.width, image.height, image.isSrgb ? "sRGB" : "linear");
+
+        const struct
+        {
+            const char *name;
+            MipFilter filter;
+        } filters[] = {{"box", MipFilter::Box}, {"kaiser", MipFilter::Kaiser}, {"lanczos", MipFilter::Lanczos}};
+        for (const auto &entry : filters)
+        {
+            size_t levelCount = 0;
+            double ms = Test::bestMs(3, [&]()
+                                     { levelCount = MipGenerator::generate(image.pixels.data(), image.width, image.height, image.width * 4,
+                                                                           image.isSrgb, entry.filter).size(); });
+            std::printf("  %-8s %2zu levels %8.2f ms %8.1f MP/s\n", entry.name, levelCount, ms, megapixels / (ms / 1000.0));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,180 @@
+#include "test_common.h"
+#include "resources/mip_generator.h"
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    std::vector<uint8_t> makeSolid(uint32_t width, uint32_t height, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+    {
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+        for (size_t i = 0; i < pixels.size(); i += 4)
+        {
+            pixels[i] = r;
+            pixels[i + 1] = g;
+            pixels[i + 2] = b;
+            pixels[i + 3] = a;
+        }
+        return pixels;
+    }
+
+    void countsLevelsLikeD3D()
+    {
+        CHECK_EQ(MipGenerator::getLevelCount(1, 1), 1u);
+        CHECK_EQ(MipGenerator::getLevelCount(4096, 2048), 13u);
+        CHECK_EQ(MipGenerator::getLevelCount(5, 3), 3u);
+
+        std::vector<uint8_t> pixels = makeSolid(5, 3, 0, 0, 0, 255);
+        std::vector<MipLevel> levels = MipGenerator::generate(pixels.data(), 5, 3, 5 * 4, false);
+        CHECK_EQ(levels.size(), size_t(3));
+        CHECK(levels[1].width == 2 && levels[1].height == 1);
+        CHECK(levels[2].width == 1 && levels[2].height == 1);
+        for (const MipLevel &level : levels)
+        {
+            CHECK_EQ(level.pixels.size(), size_t(level.width) * level.height * 4);
+        }
+    }
+
+    void copiesLevelZeroHonoringThePitch()
+    {
+        // 3 texels per row, rows padded to 16 bytes
+        std::vector<uint8_t> padded(16 * 2, 0xee);
+        for (uint32_t y = 0; y < 2; ++y)
+        {
+            for (uint32_t i = 0; i < 12; ++i)
+            {
+                padded[y * 16 + i] = static_cast<uint8_t>(y * 12 + i);
+            }
+        }
+        std::vector<MipLevel> levels = MipGenerator::generate(padded.data(), 3, 2, 16, false, MipFilter::Box);
+        for (uint32_t i = 0; i < 24; ++i)
+        {
+            CHECK_EQ(levels[0].pixels[i], static_cast<uint8_t>(i));
+        }
+    }
+
+    void keepsSolidColorsForEveryFilter()
+    {
+        for (MipFilter filter : {MipFilter::Box, MipFilter::Kaiser, MipFilter::Lanczos})
+        {
+            for (bool isSrgb : {false, true})
+            {
+                std::vector<uint8_t> pixels = makeSolid(37, 20, 200, 100, 50, 255);
+                for (const MipLevel &level : MipGenerator::generate(pixels.data(), 37, 20, 37 * 4, isSrgb, filter))
+                {
+                    for (size_t i = 0; i < level.pixels.size(); i += 4)
+                    {
+                        CHECK(std::abs(level.pixels[i] - 200) <= 1 && std::abs(level.pixels[i + 1] - 100) <= 1);
+                        CHECK(std::abs(level.pixels[i + 2] - 50) <= 1 && level.pixels[i + 3] == 255);
+                    }
+                }
+            }
+        }
+    }
+
+    void averagesInLinearLight()
+    {
+        // black and white checker: 50% linear, which sRGB encodes as 188, not 128
+        std::vector<uint8_t> pixels = makeSolid(4, 4, 0, 0, 0, 255);
+        for (uint32_t y = 0; y < 4; ++y)
+        {
+            for (uint32_t x = (y & 1); x < 4; x += 2)
+            {
+                std::fill_n(pixels.begin() + (y * 4 + x) * 4, 3, uint8_t(255));
+            }
+        }
+        std::vector<MipLevel> srgb = MipGenerator::generate(pixels.data(), 4, 4, 16, true, MipFilter::Box);
+        std::vector<MipLevel> linear = MipGenerator::generate(pixels.data(), 4, 4, 16, false, MipFilter::Box);
+        for (size_t i = 0; i < srgb[1].pixels.size(); i += 4)
+        {
+            CHECK(std::abs(srgb[1].pixels[i] - 188) <= 1);
+            CHECK(std::abs(linear[1].pixels[i] - 128) <= 1);
+        }
+    }
+
+    void weightsColorsByAlpha()
+    {
+        // opaque red next to transparent green: no green bleeds in, alpha halves
+        uint8_t pixels[8] = {255, 0, 0, 255, 0, 255, 0, 0};
+        std::vector<MipLevel> levels = MipGenerator::generate(pixels, 2, 1, 8, true, MipFilter::Box);
+        const std::vector<uint8_t> &texel = levels[1].pixels;
+        CHECK(texel[0] == 255 && texel[1] == 0 && texel[2] == 0);
+        CHECK(std::abs(texel[3] - 128) <= 1);
+    }
+
+    void spansOddFootprints()
+    {
+        // 3 -> 1 covers all three texels equally
+        uint8_t pixels[12] = {0, 0, 0, 255, 90, 90, 90, 255, 255, 255, 255, 255};
+        std::vector<MipLevel> levels = MipGenerator::generate(pixels, 3, 1, 12, false, MipFilter::Box);
+        CHECK_EQ(levels.size(), size_t(2));
+        CHECK(std::abs(levels[1].pixels[0] - 115) <= 1);
+    }
+
+    void preservesTheMeanOfLargeImages()
+    {
+        // enough rows that the bands spread over the pool; normalized, wrapped filters keep the average
+        uint32_t width = 301, height = 517;
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+        uint32_t state = 12345;
+        for (uint8_t &channel : pixels)
+        {
+            state = state * 1664525u + 1013904223u;
+            channel = static_cast<uint8_t>(state >> 24);
+        }
+        for (size_t i = 3; i < pixels.size(); i += 4)
+        {
+            pixels[i] = 255;
+        }
+
+        auto mean = [](const MipLevel &level)
+        {
+            double sum = 0.0;
+            for (size_t i = 0; i < level.pixels.size(); i += 4)
+            {
+                sum += level.pixels[i];
+            }
+            return sum / (level.pixels.size() / 4);
+        };
+        for (MipFilter filter : {MipFilter::Box, MipFilter::Kaiser, MipFilter::Lanczos})
+        {
+            std::vector<MipLevel> levels = MipGenerator::generate(pixels.data(), width, height, width * 4, false, filter);
+            CHECK_EQ(levels.size(), size_t(10));
+            CHECK_NEAR(mean(levels[1]), mean(levels[0]), 1.0);
+            CHECK_NEAR(mean(levels.back()), mean(levels[0]), 2.0);
+        }
+    }
+
+    void roundTripsEveryByte()
+    {
+        uint8_t row[256 * 4];
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            row[i * 4] = row[i * 4 + 1] = row[i * 4 + 2] = static_cast<uint8_t>(i);
+            row[i * 4 + 3] = 255;
+        }
+        for (bool isSrgb : {false, true})
+        {
+            DirectX::XMFLOAT4 decoded[256];
+            uint8_t encoded[256 * 4];
+            MipGenerator::decodeRow(row, 256, isSrgb, decoded);
+            MipGenerator::encodeRow(decoded, 256, isSrgb, encoded);
+            for (uint32_t i = 0; i < 256 * 4; ++i)
+            {
+                CHECK_EQ(encoded[i], row[i]);
+            }
+        }
+    }
+}
+
+int main()
+{
+    return Test::run({{"countsLevelsLikeD3D", countsLevelsLikeD3D},
+                      {"copiesLevelZeroHonoringThePitch", copiesLevelZeroHonoringThePitch},
+                      {"keepsSolidColorsForEveryFilter", keepsSolidColorsForEveryFilter},
+                      {"averagesInLinearLight", averagesInLinearLight},
+                      {"weightsColorsByAlpha", weightsColorsByAlpha},
+                      {"spansOddFootprints", spansOddFootprints},
+                      {"preservesTheMeanOfLargeImages", preservesTheMeanOfLargeImages},
+                      {"roundTripsEveryByte", roundTripsEveryByte}});
+}
@@ -0,0 +1,57 @@
+#include "test_common.h"
+#include "obj_reference.h"
+#include "resources/obj_parser.h"
+#include "utils/mapped_file.h"
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+// Parse throughput of ObjParser against the getline/istringstream loop it replaced, on the spaceship and on a
+// synthetic multi-chunk file
+namespace
+{
+    std::string makeLargeObj(int size)
+    {
+        std::ostringstream obj;
+        for (int y = 0; y <= size; ++y)
+        {
+            for (int x = 0; x <= size; ++x)
+            {
+                obj << "v " << x * 0.125f << " " << y * 0.25f << " " << (x ^ y) * 0.0625f << "\n";
+                obj << "vt " << x / float(size) << " " << y / float(size) << "\n";
+                obj << "vn 0 " << x / float(size) << " 1\n";
+            }
+        }
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                int a = y * (size + 1) + x + 1, b = a + 1, c = a + size + 2, d = a + size + 1;
+                obj << "f " << a << "/" << a << "/" << a << " " << b << "/" << b << "/" << b << " " << c << "/" << c << "/" << c << " " << d << "/" << d << "/" << d << "\n";
+            }
+        }
+        return obj.str();
+    }
+
+    void measure(const char *name, const std::string &text)
+    {
+        double megabytes = text.size() / (1024.0 * 1024.0);
+        size_t corners = 0;
+        double parserMs = Test::bestMs(5, [&] { corners = ObjParser::parse(text.data(), text.data() + text.size()).corners.size(); });
+        double referenceMs = Test::bestMs(3, [&] {
+            std::istringstream stream(text);
+            parseObjReference(stream);
+        });
+        std::printf("%-12s %7.2f MB %9zu corners | ObjParser %8.2f ms %8.1f MB/s | reference %8.2f ms %8.1f MB/s | x%.1f\n", name, megabytes, corners,
+                    parserMs, megabytes * 1000.0 / parserMs, referenceMs, megabytes * 1000.0 / referenceMs, referenceMs / parserMs);
+    }
+}
+
+int main()
+{
+    Test::benchmarkHeader("obj_parser_bench");
+    MappedFile spaceship(Test::sourcePath("game/celestial_rover/assets/mesh/spaceship.obj"));
+    measure("spaceship", std::string(spaceship.data(), spaceship.size()));
+    measure("grid 600^2", makeLargeObj(600));
+    return 0;
+}
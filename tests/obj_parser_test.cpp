@@ -0,0 +1,166 @@
+#include "test_common.h"
+#include "obj_reference.h"
+#include "resources/obj_parser.h"
+#include "utils/mapped_file.h"
+#include <sstream>
+#include <string>
+
+namespace
+{
+    ObjParser::Result parseText(const std::string &text)
+    {
+        return ObjParser::parse(text.data(), text.data() + text.size());
+    }
+
+    ObjParser::Result parseFile(const std::string &filepath)
+    {
+        MappedFile file(filepath);
+        const char *begin = file.data();
+        return ObjParser::parse(begin, begin + file.size());
+    }
+
+    bool equal(const DirectX::XMFLOAT3 &a, const DirectX::XMFLOAT3 &b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+    bool equal(const DirectX::XMFLOAT2 &a, const DirectX::XMFLOAT2 &b) { return a.x == b.x && a.y == b.y; }
+    bool equal(const DirectX::XMINT3 &a, const DirectX::XMINT3 &b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+
+    template <typename T>
+    bool equal(const std::vector<T> &a, const std::vector<T> &b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (!equal(a[i], b[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void checkSameResult(const ObjParser::Result &result, const ObjParser::Result &expected)
+    {
+        CHECK(equal(result.positions, expected.positions));
+        CHECK(equal(result.normals, expected.normals));
+        CHECK(equal(result.texCoords, expected.texCoords));
+        CHECK(equal(result.corners, expected.corners));
+    }
+
+    // A size x size grid of quads, v/t/n everywhere; absolute indices, or relative ones where `relative` is set
+    std::string makeGridObj(int size, bool relative)
+    {
+        std::ostringstream obj;
+        obj << "# grid\no grid\n";
+        for (int y = 0; y <= size; ++y)
+        {
+            for (int x = 0; x <= size; ++x)
+            {
+                obj << "v " << x * 0.125f << " " << y * 0.25f << " " << (x ^ y) * 0.0625f << "\n";
+                obj << "vt " << x / float(size) << " " << y / float(size) << "\n";
+            }
+        }
+        obj << "vn 0 0 1\nvn 0 1 0\n";
+
+        int vertexCount = (size + 1) * (size + 1);
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                int corners[4] = {y * (size + 1) + x + 1, y * (size + 1) + x + 2, (y + 1) * (size + 1) + x + 2, (y + 1) * (size + 1) + x + 1};
+                int normal = 1 + ((x + y) & 1);
+                obj << "f";
+                for (int corner : corners)
+                {
+                    if (relative)
+                    {
+                        // every vertex and the normals precede the faces
+                        obj << " " << corner - vertexCount - 1 << "/" << corner - vertexCount - 1 << "/" << normal - 3;
+                    }
+                    else
+                    {
+                        obj << " " << corner << "/" << corner << "/" << normal;
+                    }
+                }
+                obj << "\n";
+            }
+        }
+        return obj.str();
+    }
+
+    void matchesReferenceOnAssets()
+    {
+        for (const char *asset : {"game/celestial_rover/assets/mesh/cube.obj", "game/celestial_rover/assets/mesh/sphere.obj",
+                                  "game/celestial_rover/assets/mesh/spaceship.obj", "engine/assets/mesh/spaceship.obj"})
+        {
+            std::string filepath = Test::sourcePath(asset);
+            ObjParser::Result result = parseFile(filepath);
+            CHECK(result.corners.size() > 0);
+            checkSameResult(result, parseObjReferenceFile(filepath));
+        }
+    }
+
+    void matchesReferenceAcrossChunks()
+    {
+        // several 256 KB chunks, their boundaries fall inside vertex and face blocks
+        std::string obj = makeGridObj(160, false);
+        CHECK(obj.size() > 1024 * 1024);
+        std::istringstream stream(obj);
+        ObjParser::Result result = parseText(obj);
+        CHECK_EQ(result.corners.size(), size_t(160 * 160 * 6));
+        checkSameResult(result, parseObjReference(stream));
+    }
+
+    void resolvesRelativeIndices()
+    {
+        ObjParser::Result result = parseText("v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvn 0 0 1\nf -3/-1/-1 -2/-1/-1 -1/-1/-1\n");
+        CHECK_EQ(result.corners.size(), size_t(3));
+        CHECK(equal(result.corners[0], DirectX::XMINT3{1, 1, 1}));
+        CHECK(equal(result.corners[2], DirectX::XMINT3{3, 1, 1}));
+
+        // relative to the end of the previous chunks, which a face chunk only learns after the merge
+        std::string absolute = makeGridObj(160, false);
+        std::string relative = makeGridObj(160, true);
+        CHECK(equal(parseText(relative).corners, parseText(absolute).corners));
+    }
+
+    void triangulatesPolygonsAndMissingAttributes()
+    {
+        ObjParser::Result result = parseText("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv -1 1 0\nvn 0 0 1\n"
+                                             "f 1 2 3 4 5\r\n"
+                                             "f 1//1 2//1 3//1 # trailing comment\n");
+        CHECK_EQ(result.corners.size(), size_t(4 * 3));
+        // fan around the first corner, 0 for the missing texture coordinate and normal
+        CHECK(equal(result.corners[3], DirectX::XMINT3{1, 0, 0}));
+        CHECK(equal(result.corners[4], DirectX::XMINT3{3, 0, 0}));
+        CHECK(equal(result.corners[8], DirectX::XMINT3{5, 0, 0}));
+        CHECK(equal(result.corners[10], DirectX::XMINT3{2, 0, 1}));
+
+        // handedness flip: z negated, v mirrored
+        result = parseText("v 1 2 3\nvt 0.25 0.25\nvn 0 0 1\nf 1/1/1 1/1/1 1/1/1\n");
+        CHECK(equal(result.positions[1], DirectX::XMFLOAT3{1.f, 2.f, -3.f}));
+        CHECK(equal(result.texCoords[1], DirectX::XMFLOAT2{0.25f, 0.75f}));
+        CHECK(equal(result.normals[1], DirectX::XMFLOAT3{0.f, 0.f, -1.f}));
+    }
+
+    void rejectsInvalidIndices()
+    {
+        CHECK_THROWS(parseText("v 0 0 0\nv 1 0 0\nf 1 2 3\n"));
+        CHECK_THROWS(parseText("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1/2 2/2 3/2\n"));
+        // relative indices before the first vertex, including ones far past what the relative encoding holds
+        CHECK_THROWS(parseText("v 0 0 0\nv 1 0 0\nv 0 1 0\nf -4 -2 -1\n"));
+        CHECK_THROWS(parseText("v 0 0 0\nv 1 0 0\nv 0 1 0\nf -2000000000 -2 -1\n"));
+        CHECK_THROWS(parseText("v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nf -1/-2147483648 -2/-1 -3/-1\n"));
+        CHECK_THROWS(parseText("v 0 0 0\nf x y z\n"));
+    }
+}
+
+int main()
+{
+    return Test::run({{"matchesReferenceOnAssets", matchesReferenceOnAssets},
+                      {"matchesReferenceAcrossChunks", matchesReferenceAcrossChunks},
+                      {"resolvesRelativeIndices", resolvesRelativeIndices},
+                      {"triangulatesPolygonsAndMissingAttributes", triangulatesPolygonsAndMissingAttributes},
+                      {"rejectsInvalidIndices", rejectsInvalidIndices}});
+}
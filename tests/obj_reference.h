@@ -0,0 +1,81 @@
+#pragma once
+
+#include "resources/obj_parser.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// The getline/istringstream OBJ loop ObjParser replaced (Mesh::loadFromOBJ before it), producing ObjParser's
+// Result. It only knows v/t/n descriptors with positive indices. The original dropped faces past quads, here every
+// polygon is fanned (A, B, C), (A, C, D), ... the way ObjParser does it.
+inline ObjParser::Result parseObjReference(std::istream &stream)
+{
+    ObjParser::Result result;
+    result.positions = {{0.f, 0.f, 0.f}};
+    result.normals = {{0.f, 0.f, 0.f}};
+    result.texCoords = {{0.f, 0.f}};
+
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        std::istringstream iss(line);
+        std::string type;
+        iss >> type;
+
+        if (type == "v")
+        {
+            DirectX::XMFLOAT3 pos;
+            iss >> pos.x >> pos.y >> pos.z;
+            pos.z = -pos.z;
+            result.positions.push_back(pos);
+        }
+        else if (type == "vt")
+        {
+            DirectX::XMFLOAT2 tex;
+            iss >> tex.x >> tex.y;
+            tex.y = 1.f - tex.y;
+            result.texCoords.push_back(tex);
+        }
+        else if (type == "vn")
+        {
+            DirectX::XMFLOAT3 norm;
+            iss >> norm.x >> norm.y >> norm.z;
+            norm.z = -norm.z;
+            result.normals.push_back(norm);
+        }
+        else if (type == "f")
+        {
+            std::vector<DirectX::XMINT3> faceVertices;
+            std::string descriptor;
+            while (iss >> descriptor)
+            {
+                size_t firstSlash = descriptor.find('/');
+                size_t secondSlash = descriptor.find('/', firstSlash + 1);
+
+                int vIndex = std::stoi(descriptor.substr(0, firstSlash));
+                int tIndex = std::stoi(descriptor.substr(firstSlash + 1, secondSlash - firstSlash - 1));
+                int nIndex = std::stoi(descriptor.substr(secondSlash + 1));
+                faceVertices.push_back({vIndex, tIndex, nIndex});
+            }
+
+            for (size_t i = 1; i + 1 < faceVertices.size(); ++i)
+            {
+                result.corners.push_back(faceVertices[0]);
+                result.corners.push_back(faceVertices[i]);
+                result.corners.push_back(faceVertices[i + 1]);
+            }
+        }
+    }
+    return result;
+}
+
+inline ObjParser::Result parseObjReferenceFile(const std::string &filepath)
+{
+    std::ifstream file(filepath);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("parseObjReferenceFile: Failed to open OBJ file: " + filepath);
+    }
+    return parseObjReference(file);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+// Non-Windows test builds only: the Win32 types the engine's CPU code names, no API
+#include <cstddef>
+#include <cstdint>
+
+typedef long HRESULT;
+typedef int BOOL;
+typedef int INT;
+typedef unsigned int UINT;
+typedef unsigned long ULONG;
+typedef unsigned char BYTE;
+typedef float FLOAT;
+typedef const char *LPCSTR;
+
+#define S_OK ((HRESULT)0L)
+#define E_FAIL ((HRESULT)0x80004005L)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
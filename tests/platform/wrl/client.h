@@ -0,0 +1,29 @@
+#pragma once
+
+// Non-Windows test builds only: ComPtr as a plain holder, the opaque interfaces have nothing to reference count
+#include <cstddef>
+#include <utility>
+
+namespace Microsoft
+{
+    namespace WRL
+    {
+        template <typename T>
+        class ComPtr
+        {
+        public:
+            ComPtr() = default;
+            ComPtr(std::nullptr_t) {}
+
+            T *Get() const { return m_ptr; }
+            T *const *GetAddressOf() const { return &m_ptr; }
+            T **GetAddressOf() { return &m_ptr; }
+            T *operator->() const { return m_ptr; }
+            explicit operator bool() const { return m_ptr != nullptr; }
+            void Reset() { m_ptr = nullptr; }
+
+        private:
+            T *m_ptr = nullptr;
+        };
+    }
+}
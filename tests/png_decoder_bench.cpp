@@ -0,0 +1,49 @@
+#include "test_common.h"
+#include "resources/png_decoder.h"
+#include "utils/mapped_file.h"
+#include "utils/thread_pool.h"
+#include <cstdio>
+#include <future>
+#include <vector>
+
+// Decode megapixels/s per PNG asset from a mapped file, then all of them at once on the ThreadPool the way
+// the texture loads run
+int main()
+{
+    Test::benchmarkHeader("png_decoder");
+    const char *assets[] = {"engine/assets/texture/checker.png", "engine/assets/texture/checker-map_tho.png",
+                            "game/celestial_rover/assets/texture/galaxy.png"};
+    double totalMegapixels = 0.0;
+    for (const char *asset : assets)
+    {
+        MappedFile file(Test::sourcePath(asset));
+        const uint8_t *data = reinterpret_cast<const uint8_t *>(file.data());
+        uint32_t width = 0, height = 0;
+        double ms = Test::bestMs(5, [&]()
+                                 {
+            DecodedImage image = PngDecoder::decode(data, file.size(), asset);
+            width = image.width;
+            height = image.height; });
+        double megapixels = width * static_cast<double>(height) / 1e6;
+        totalMegapixels += megapixels;
+        std::printf("%s: %ux%u %8.2f ms %8.1f MP/s %8.1f MB/s compressed\n", asset, width, height, ms, megapixels / (ms / 1000.0),
+                    file.size() / 1e6 / (ms / 1000.0));
+    }
+
+    ThreadPool &pool = ThreadPool::getInstance();
+    double ms = Test::bestMs(5, [&]()
+                             {
+        std::vector<std::future<DecodedImage>> decodes;
+        for (const char *asset : assets)
+        {
+            decodes.push_back(pool.submit([asset]()
+                                          { return PngDecoder::decode(Test::sourcePath(asset)); }));
+        }
+        for (auto &decode : decodes)
+        {
+            decode.get();
+        } });
+    std::printf("all %zu concurrently on %u threads: %8.2f ms %8.1f MP/s\n", std::size(assets), pool.getThreadCount(), ms,
+                totalMegapixels / (ms / 1000.0));
+    return 0;
+}
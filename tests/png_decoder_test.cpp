@@ -0,0 +1,240 @@
+#include "test_common.h"
+#include "png_writer.h"
+#include "resources/png_decoder.h"
+#include "utils/hash.h"
+#include "utils/inflate.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // FNV-1a of the RGBA8 pixels of an independent decoder (Pillow, converted to RGBA)
+    const struct
+    {
+        const char *asset;
+        uint32_t width;
+        uint32_t height;
+        uint64_t pixelHash;
+    } ASSETS[] = {{"engine/assets/texture/checker.png", 1024, 1024, 0xac98ee728a6d935eull},
+                  {"engine/assets/texture/checker-map_tho.png", 4096, 4096, 0x77b700938149ba18ull},
+                  {"game/celestial_rover/assets/texture/galaxy.png", 1308, 736, 0x6cb0b4bbe68af84bull}};
+
+    PngWriter::Image makeImage(uint32_t width, uint32_t height, uint8_t colorType, uint8_t bitDepth, uint32_t seed)
+    {
+        PngWriter::Image image;
+        image.width = width;
+        image.height = height;
+        image.colorType = colorType;
+        image.bitDepth = bitDepth;
+        image.samples.resize(static_cast<size_t>(width) * height * PngWriter::getChannels(colorType));
+        uint32_t state = seed;
+        for (uint16_t &sample : image.samples)
+        {
+            state = state * 1664525u + 1013904223u;
+            sample = static_cast<uint16_t>((state >> 8) & ((1u << bitDepth) - 1));
+        }
+        return image;
+    }
+
+    uint8_t toByte(uint16_t sample, uint8_t bitDepth)
+    {
+        return static_cast<uint8_t>(bitDepth == 16 ? sample >> 8 : sample * 255 / ((1u << bitDepth) - 1));
+    }
+
+    // What the decoder should produce, straight from the samples
+    std::vector<uint8_t> expectRgba(const PngWriter::Image &image)
+    {
+        uint32_t channels = PngWriter::getChannels(image.colorType);
+        std::vector<uint8_t> rgba;
+        for (size_t pixel = 0; pixel < static_cast<size_t>(image.width) * image.height; ++pixel)
+        {
+            const uint16_t *s = image.samples.data() + pixel * channels;
+            switch (image.colorType)
+            {
+            case 0:
+            {
+                bool isKey = image.tRNS.size() >= 2 && s[0] == (image.tRNS[0] << 8 | image.tRNS[1]);
+                rgba.insert(rgba.end(), {toByte(s[0], image.bitDepth), toByte(s[0], image.bitDepth), toByte(s[0], image.bitDepth),
+                                         static_cast<uint8_t>(isKey ? 0 : 255)});
+                break;
+            }
+            case 2:
+            {
+                bool isKey = image.tRNS.size() >= 6 && s[0] == (image.tRNS[0] << 8 | image.tRNS[1]) &&
+                             s[1] == (image.tRNS[2] << 8 | image.tRNS[3]) && s[2] == (image.tRNS[4] << 8 | image.tRNS[5]);
+                rgba.insert(rgba.end(), {toByte(s[0], image.bitDepth), toByte(s[1], image.bitDepth), toByte(s[2], image.bitDepth),
+                                         static_cast<uint8_t>(isKey ? 0 : 255)});
+                break;
+            }
+            case 3:
+                rgba.insert(rgba.end(), {image.palette[s[0] * 3], image.palette[s[0] * 3 + 1], image.palette[s[0] * 3 + 2],
+                                         static_cast<uint8_t>(s[0] < image.tRNS.size() ? image.tRNS[s[0]] : 255)});
+                break;
+            case 4:
+                rgba.insert(rgba.end(), {toByte(s[0], image.bitDepth), toByte(s[0], image.bitDepth), toByte(s[0], image.bitDepth),
+                                         toByte(s[1], image.bitDepth)});
+                break;
+            case 6:
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    rgba.push_back(toByte(s[c], image.bitDepth));
+                }
+                break;
+            }
+        }
+        return rgba;
+    }
+
+    bool decodesAsExpected(const PngWriter::Image &image)
+    {
+        std::vector<uint8_t> png = PngWriter::write(image);
+        DecodedImage decoded = PngDecoder::decode(png.data(), png.size(), "test.png");
+        std::vector<uint8_t> expected = expectRgba(image);
+        return decoded.width == image.width && decoded.height == image.height && decoded.pixels.size() >= expected.size() &&
+               std::memcmp(decoded.pixels.data(), expected.data(), expected.size()) == 0;
+    }
+
+    void matchesReferenceHashesOnAssets()
+    {
+        for (const auto &asset : ASSETS)
+        {
+            DecodedImage image = PngDecoder::decode(Test::sourcePath(asset.asset));
+            CHECK(image.width == asset.width && image.height == asset.height);
+            CHECK(hashBytes(image.pixels.data(), static_cast<size_t>(image.width) * image.height * 4) == asset.pixelHash);
+        }
+    }
+
+    void unfiltersEveryFilterAndStride()
+    {
+        // odd widths leave a tail after the 16-byte vector loops; one byte per pixel is the scalar path
+        for (uint32_t width : {1u, 5u, 33u, 130u})
+        {
+            CHECK(decodesAsExpected(makeImage(width, 17, 6, 8, width)));
+            CHECK(decodesAsExpected(makeImage(width, 17, 2, 8, width + 1)));
+            CHECK(decodesAsExpected(makeImage(width, 17, 4, 8, width + 2)));
+            CHECK(decodesAsExpected(makeImage(width, 17, 0, 8, width + 3)));
+            CHECK(decodesAsExpected(makeImage(width, 17, 6, 16, width + 4)));
+        }
+    }
+
+    void deinterlacesAdam7()
+    {
+        // sizes smaller than the 8x8 pattern leave some passes empty
+        for (uint32_t size : {1u, 3u, 8u, 29u})
+        {
+            PngWriter::Image image = makeImage(size, size + 2, 6, 8, size);
+            image.isInterlaced = true;
+            CHECK(decodesAsExpected(image));
+            image = makeImage(size + 1, size, 0, 2, size);
+            image.isInterlaced = true;
+            CHECK(decodesAsExpected(image));
+        }
+    }
+
+    void expandsLowBitDepthsAndTransparency()
+    {
+        for (uint8_t depth : {1, 2, 4})
+        {
+            CHECK(decodesAsExpected(makeImage(13, 5, 0, depth, depth)));
+        }
+        CHECK(decodesAsExpected(makeImage(13, 5, 0, 16, 7)));
+
+        // palette with a shorter tRNS: entries past it stay opaque
+        for (uint8_t depth : {1, 2, 4, 8})
+        {
+            PngWriter::Image image = makeImage(21, 6, 3, depth, depth);
+            for (uint32_t i = 0; i < (1u << depth); ++i)
+            {
+                image.palette.insert(image.palette.end(), {static_cast<uint8_t>(i * 3), static_cast<uint8_t>(255 - i), static_cast<uint8_t>(i * 7)});
+            }
+            image.tRNS = {0, 128};
+            CHECK(decodesAsExpected(image));
+        }
+
+        // color keys, in sample units
+        PngWriter::Image gray = makeImage(16, 4, 0, 4, 3);
+        gray.samples[5] = 9;
+        gray.tRNS = {0, 9};
+        CHECK(decodesAsExpected(gray));
+        PngWriter::Image rgb = makeImage(16, 4, 2, 16, 3);
+        rgb.samples[0] = 0x1234;
+        rgb.samples[1] = 0x5678;
+        rgb.samples[2] = 0x9abc;
+        rgb.tRNS = {0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc};
+        CHECK(decodesAsExpected(rgb));
+    }
+
+    void gathersSplitImageDataAndSkipsUnknownChunks()
+    {
+        PngWriter::Image image = makeImage(300, 120, 6, 8, 11); // stored blocks past 64 KB
+        image.idatChunks = 5;
+        image.extraChunk = {1, 2, 3};
+        CHECK(decodesAsExpected(image));
+    }
+
+    void rejectsMalformedFiles()
+    {
+        std::vector<uint8_t> png = PngWriter::write(makeImage(8, 8, 6, 8, 1));
+        CHECK(PngDecoder::isPng(png.data(), png.size()));
+        CHECK(!PngDecoder::isPng(png.data(), 4));
+        CHECK_THROWS(PngDecoder::decode(png.data(), png.size() - 30, "truncated.png"));
+
+        // the Adler-32 right before the IDAT CRC and IEND
+        std::vector<uint8_t> corrupt = png;
+        corrupt[corrupt.size() - 12 - 4 - 1] ^= 1;
+        CHECK_THROWS(PngDecoder::decode(corrupt.data(), corrupt.size(), "adler.png"));
+
+        PngWriter::Image palette = makeImage(8, 8, 3, 8, 1); // no PLTE
+        std::vector<uint8_t> noPalette = PngWriter::write(palette);
+        CHECK_THROWS(PngDecoder::decode(noPalette.data(), noPalette.size(), "palette.png"));
+
+        PngWriter::Image badDepth = makeImage(8, 8, 6, 4, 1);
+        std::vector<uint8_t> invalid = PngWriter::write(badDepth);
+        CHECK_THROWS(PngDecoder::decode(invalid.data(), invalid.size(), "depth.png"));
+    }
+
+    void inflatesFixedHuffmanStreams()
+    {
+        // zlib.compress(b"hello, hello, hello, hello inflate", 9): one fixed Huffman block with overlapping copies
+        const uint8_t compressed[] = {0x78, 0xda, 0xcb, 0x48, 0xcd, 0xc9, 0xc9, 0xd7, 0x51, 0xc8, 0xc0, 0xa4, 0x14,
+                                      0x32, 0xf3, 0xd2, 0x72, 0x12, 0x4b, 0x52, 0x01, 0xd2, 0x4f, 0x0c, 0x38};
+        const std::string expected = "hello, hello, hello, hello inflate";
+        std::vector<uint8_t> out(expected.size());
+        CHECK_EQ(Inflate::decompressZlib(compressed, sizeof(compressed), out.data(), out.size()), expected.size());
+        CHECK(std::memcmp(out.data(), expected.data(), expected.size()) == 0);
+
+        std::vector<uint8_t> small(expected.size() - 1);
+        CHECK_THROWS(Inflate::decompressZlib(compressed, sizeof(compressed), small.data(), small.size()));
+        CHECK_THROWS(Inflate::decompressZlib(compressed, sizeof(compressed) - 6, out.data(), out.size()));
+    }
+
+    void checksAdler32()
+    {
+        const char *text = "Wikipedia";
+        CHECK(Inflate::adler32(reinterpret_cast<const uint8_t *>(text), std::strlen(text)) == 0x11e60398u);
+        // split runs continue from the previous value
+        uint32_t adler = Inflate::adler32(reinterpret_cast<const uint8_t *>(text), 4);
+        CHECK(Inflate::adler32(reinterpret_cast<const uint8_t *>(text) + 4, 5, adler) == 0x11e60398u);
+        std::vector<uint8_t> large(1 << 20, 0xff);
+        uint32_t a = 1, b = 0;
+        for (uint8_t byte : large)
+        {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        CHECK(Inflate::adler32(large.data(), large.size()) == (b << 16 | a));
+    }
+}
+
+int main()
+{
+    return Test::run({{"matchesReferenceHashesOnAssets", matchesReferenceHashesOnAssets},
+                      {"unfiltersEveryFilterAndStride", unfiltersEveryFilterAndStride},
+                      {"deinterlacesAdam7", deinterlacesAdam7},
+                      {"expandsLowBitDepthsAndTransparency", expandsLowBitDepthsAndTransparency},
+                      {"gathersSplitImageDataAndSkipsUnknownChunks", gathersSplitImageDataAndSkipsUnknownChunks},
+                      {"rejectsMalformedFiles", rejectsMalformedFiles},
+                      {"inflatesFixedHuffmanStreams", inflatesFixedHuffmanStreams},
+                      {"checksAdler32", checksAdler32}});
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Writes PNGs in memory for the decoder tests, with no compressor of its own: the zlib stream holds stored blocks,
+// so the bytes the decoder unfilters are exactly the ones written here. Row filters cycle None, Sub, Up, Average,
+// Paeth so every filter meets every stride.
+namespace PngWriter
+{
+    struct Image
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint8_t colorType = 6; // PNG color type: 0 gray, 2 RGB, 3 palette, 4 gray + alpha, 6 RGBA
+        uint8_t bitDepth = 8;
+        bool isInterlaced = false;
+        std::vector<uint16_t> samples;   // width * height * channels, in sample units
+        std::vector<uint8_t> palette;    // RGB triples
+        std::vector<uint8_t> tRNS;       // chunk body as written
+        std::vector<uint8_t> extraChunk; // written as "ICC_" before the image data when not empty
+        uint32_t idatChunks = 1;
+    };
+
+    inline uint32_t getChannels(uint8_t colorType)
+    {
+        static const uint8_t CHANNELS[7] = {1, 0, 3, 1, 2, 0, 4};
+        return CHANNELS[colorType];
+    }
+
+    inline void appendBigEndian(std::vector<uint8_t> &out, uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+        {
+            out.push_back(static_cast<uint8_t>(value >> shift));
+        }
+    }
+
+    inline uint32_t crc32(const uint8_t *data, size_t size)
+    {
+        uint32_t crc = 0xffffffffu;
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+            }
+        }
+        return ~crc;
+    }
+
+    inline void appendChunk(std::vector<uint8_t> &png, const char *type, const uint8_t *body, size_t size)
+    {
+        appendBigEndian(png, static_cast<uint32_t>(size));
+        size_t typeOffset = png.size();
+        png.insert(png.end(), type, type + 4);
+        png.insert(png.end(), body, body + size);
+        appendBigEndian(png, crc32(png.data() + typeOffset, size + 4));
+    }
+
+    inline uint8_t paeth(int a, int b, int c)
+    {
+        int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        return static_cast<uint8_t>(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+    }
+
+    // Packs the samples of one pass (x0 + i * dx, y0 + j * dy), filters each row, appends filter byte + row
+    inline void appendPass(const Image &image, uint32_t x0, uint32_t y0, uint32_t dx, uint32_t dy, std::vector<uint8_t> &out)
+    {
+        uint32_t channels = getChannels(image.colorType);
+        uint32_t passWidth = image.width > x0 ? (image.width - x0 + dx - 1) / dx : 0;
+        uint32_t passHeight = image.height > y0 ? (image.height - y0 + dy - 1) / dy : 0;
+        if (passWidth == 0 || passHeight == 0)
+        {
+            return;
+        }
+        size_t rowBytes = (static_cast<size_t>(passWidth) * channels * image.bitDepth + 7) / 8;
+        size_t stride = std::max<size_t>(1, channels * image.bitDepth / 8);
+        std::vector<uint8_t> prior(rowBytes, 0), row(rowBytes);
+        for (uint32_t j = 0; j < passHeight; ++j)
+        {
+            std::fill(row.begin(), row.end(), uint8_t(0));
+            for (uint32_t i = 0; i < passWidth; ++i)
+            {
+                size_t pixel = static_cast<size_t>(y0 + j * dy) * image.width + x0 + i * dx;
+                for (uint32_t c = 0; c < channels; ++c)
+                {
+                    uint16_t sample = image.samples[pixel * channels + c];
+                    size_t index = static_cast<size_t>(i) * channels + c;
+                    if (image.bitDepth == 16)
+                    {
+                        row[index * 2] = static_cast<uint8_t>(sample >> 8);
+                        row[index * 2 + 1] = static_cast<uint8_t>(sample);
+                    }
+                    else
+                    {
+                        size_t bit = index * image.bitDepth;
+                        row[bit / 8] |= static_cast<uint8_t>(sample << (8 - image.bitDepth - bit % 8));
+                    }
+                }
+            }
+
+            uint8_t filter = static_cast<uint8_t>(j % 5);
+            out.push_back(filter);
+            for (size_t k = 0; k < rowBytes; ++k)
+            {
+                int a = k >= stride ? row[k - stride] : 0, b = prior[k], c = k >= stride ? prior[k - stride] : 0;
+                int predictor = filter == 1 ? a : filter == 2 ? b : filter == 3 ? (a + b) / 2 : filter == 4 ? paeth(a, b, c) : 0;
+                out.push_back(static_cast<uint8_t>(row[k] - predictor));
+            }
+            prior = row;
+        }
+    }
+
+    inline std::vector<uint8_t> write(const Image &image)
+    {
+        std::vector<uint8_t> filtered;
+        if (image.isInterlaced)
+        {
+            const uint32_t ADAM7[7][4] = {{0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4}, {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2}};
+            for (const auto &pass : ADAM7)
+            {
+                appendPass(image, pass[0], pass[1], pass[2], pass[3], filtered);
+            }
+        }
+        else
+        {
+            appendPass(image, 0, 0, 1, 1, filtered);
+        }
+
+        // zlib: header, stored blocks of up to 65535 bytes, Adler-32
+        std::vector<uint8_t> zlib = {0x78, 0x01};
+        size_t offset = 0;
+        do
+        {
+            size_t length = std::min<size_t>(65535, filtered.size() - offset);
+            zlib.push_back(offset + length == filtered.size() ? 1 : 0);
+            zlib.push_back(static_cast<uint8_t>(length));
+            zlib.push_back(static_cast<uint8_t>(length >> 8));
+            zlib.push_back(static_cast<uint8_t>(~length));
+            zlib.push_back(static_cast<uint8_t>(~length >> 8));
+            zlib.insert(zlib.end(), filtered.begin() + offset, filtered.begin() + offset + length);
+            offset += length;
+        } while (offset < filtered.size());
+        uint32_t a = 1, b = 0;
+        for (uint8_t byte : filtered)
+        {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+        appendBigEndian(zlib, b << 16 | a);
+
+        std::vector<uint8_t> png = {137, 80, 78, 71, 13, 10, 26, 10};
+        std::vector<uint8_t> header;
+        appendBigEndian(header, image.width);
+        appendBigEndian(header, image.height);
+        header.insert(header.end(), {image.bitDepth, image.colorType, 0, 0, static_cast<uint8_t>(image.isInterlaced ? 1 : 0)});
+        appendChunk(png, "IHDR", header.data(), header.size());
+        if (!image.extraChunk.empty())
+        {
+            appendChunk(png, "ICC_", image.extraChunk.data(), image.extraChunk.size());
+        }
+        if (!image.palette.empty())
+        {
+            appendChunk(png, "PLTE", image.palette.data(), image.palette.size());
+        }
+        if (!image.tRNS.empty())
+        {
+            appendChunk(png, "tRNS", image.tRNS.data(), image.tRNS.size());
+        }
+        size_t chunkSize = (zlib.size() + image.idatChunks - 1) / image.idatChunks;
+        for (size_t begin = 0; begin < zlib.size(); begin += chunkSize)
+        {
+            appendChunk(png, "IDAT", zlib.data() + begin, std::min(chunkSize, zlib.size() - begin));
+        }
+        appendChunk(png, "IEND", nullptr, 0);
+        return png;
+    }
+}
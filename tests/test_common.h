@@ -0,0 +1,100 @@
+#pragma once
+
+#include "utils/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+// Assertions for the CPU tests: a failed CHECK reports file and line and the case carries on, a case that throws
+// fails and the next one runs. main() returns Test::run({...}).
+namespace Test
+{
+    inline int &failureCount()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    inline void fail(const char *file, int line, const std::string &message)
+    {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, message.c_str());
+        ++failureCount();
+    }
+
+    // Absolute path of a file in the source tree
+    inline std::string sourcePath(const std::string &relativePath)
+    {
+        return std::string(TEST_SOURCE_DIR) + "/" + relativePath;
+    }
+
+    using Case = std::pair<const char *, void (*)()>;
+
+    inline int run(std::initializer_list<Case> cases)
+    {
+        Logger::LoggerInstance::GetInstance().SetVerbosity(Logger::LogLevel::WARNING);
+        for (const Case &testCase : cases)
+        {
+            int failuresBefore = failureCount();
+            try
+            {
+                testCase.second();
+            }
+            catch (const std::exception &e)
+            {
+                fail(__FILE__, __LINE__, std::string(testCase.first) + " threw: " + e.what());
+            }
+            std::printf("[%s] %s\n", failureCount() == failuresBefore ? "pass" : "FAIL", testCase.first);
+        }
+        return failureCount() == 0 ? 0 : 1;
+    }
+
+    // Best wall time of `repeats` calls in ms, the benchmarks report throughput from it
+    template <typename Function>
+    double bestMs(int repeats, Function &&function)
+    {
+        double best = 1e30;
+        for (int i = 0; i < repeats; ++i)
+        {
+            auto startTime = std::chrono::high_resolution_clock::now();
+            function();
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count());
+        }
+        return best;
+    }
+
+    inline void benchmarkHeader(const char *name)
+    {
+        Logger::LoggerInstance::GetInstance().SetVerbosity(Logger::LogLevel::WARNING);
+#ifndef NDEBUG
+        std::printf("%s: built without NDEBUG, configure with CMAKE_BUILD_TYPE=Release for meaningful numbers\n", name);
+#else
+        std::printf("%s\n", name);
+#endif
+    }
+}
+
+#define CHECK(condition) ((condition) ? (void)0 : ::Test::fail(__FILE__, __LINE__, #condition))
+#define CHECK_EQ(a, b) (((a) == (b)) ? (void)0 : ::Test::fail(__FILE__, __LINE__, std::string(#a " == " #b ": ") + std::to_string(a) + " vs " + std::to_string(b)))
+#define CHECK_NEAR(a, b, tolerance) ((std::fabs(static_cast<double>(a) - static_cast<double>(b)) <= (tolerance)) ? (void)0 : ::Test::fail(__FILE__, __LINE__, std::string(#a " ~ " #b ": ") + std::to_string(a) + " vs " + std::to_string(b)))
+#define CHECK_THROWS(expression)                                             \
+    do                                                                       \
+    {                                                                        \
+        bool thrown = false;                                                 \
+        try                                                                  \
+        {                                                                    \
+            expression;                                                      \
+        }                                                                    \
+        catch (const std::exception &)                                       \
+        {                                                                    \
+            thrown = true;                                                   \
+        }                                                                    \
+        if (!thrown)                                                         \
+        {                                                                    \
+            ::Test::fail(__FILE__, __LINE__, "expected a throw: " #expression); \
+        }                                                                    \
+    } while (false)
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "resources/mesh_optimizer.h"
+#include "resources/obj_parser.h"
+#include "resources/vertex.h"
+#include "utils/mapped_file.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Meshes for the geometry tests and benchmarks: the OBJ assets indexed the way Mesh does it, and generated grids
+namespace TestMeshes
+{
+    inline void loadObj(const std::string &filepath, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
+    {
+        MappedFile file(filepath);
+        MeshOptimizer::indexCorners(ObjParser::parse(file.data(), file.end()), vertices, indices);
+    }
+
+    // size x size quads in the xz plane, height from a few sines, rows in order (a poor cache order)
+    inline void makeGrid(int size, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices)
+    {
+        vertices.clear();
+        indices.clear();
+        for (int z = 0; z <= size; ++z)
+        {
+            for (int x = 0; x <= size; ++x)
+            {
+                float height = 0.1f * std::sin(x * 0.3f) * std::cos(z * 0.2f);
+                vertices.emplace_back(DirectX::XMFLOAT3{float(x), height, float(z)}, DirectX::XMFLOAT3{0.f, 1.f, 0.f},
+                                      DirectX::XMFLOAT2{x / float(size), z / float(size)});
+            }
+        }
+        for (int z = 0; z < size; ++z)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                uint32_t a = z * (size + 1) + x, b = a + 1, c = a + size + 1, d = c + 1;
+                indices.insert(indices.end(), {a, c, b, b, c, d});
+            }
+        }
+    }
+
+    // Random triangle order, the worst case for the post-transform cache
+    inline void shuffleTriangles(std::vector<uint32_t> &indices, uint32_t seed = 1)
+    {
+        std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+        for (size_t t = 0; t < triangles.size(); ++t)
+        {
+            triangles[t] = {indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2]};
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+        for (size_t t = 0; t < triangles.size(); ++t)
+        {
+            std::copy(triangles[t].begin(), triangles[t].end(), indices.begin() + t * 3);
+        }
+    }
+
+    using VertexKey = std::array<float, 8>;
+    using TriangleKey = std::array<VertexKey, 3>;
+
+    inline VertexKey vertexKey(const Vertex &v) { return {v.pos.x, v.pos.y, v.pos.z, v.n.x, v.n.y, v.n.z, v.uv.x, v.uv.y}; }
+
+    // The triangles by vertex content, each rotated to start at its smallest vertex (keeps the winding), sorted;
+    // equal for two buffers that draw the same triangles in any order and vertex numbering
+    inline std::vector<TriangleKey> triangleSet(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices)
+    {
+        std::vector<TriangleKey> triangles(indices.size() / 3);
+        for (size_t t = 0; t < triangles.size(); ++t)
+        {
+            TriangleKey key = {vertexKey(vertices[indices[t * 3]]), vertexKey(vertices[indices[t * 3 + 1]]), vertexKey(vertices[indices[t * 3 + 2]])};
+            std::rotate(key.begin(), std::min_element(key.begin(), key.end()), key.end());
+            triangles[t] = key;
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+}
@@ -0,0 +1,178 @@
+#include "test_common.h"
+#include "resources/texture_cache.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// The cache lives under the working directory: every case runs in a scratch one
+namespace
+{
+    const std::string SOURCE = "assets/source.png";
+
+    void writeFile(const std::string &path, const std::vector<uint8_t> &bytes)
+    {
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    void enterScratchDirectory()
+    {
+        std::filesystem::path scratch = std::filesystem::temp_directory_path() / "texture_cache_test";
+        std::filesystem::current_path(std::filesystem::temp_directory_path());
+        std::filesystem::remove_all(scratch);
+        std::filesystem::create_directories(scratch);
+        std::filesystem::current_path(scratch);
+        writeFile(SOURCE, std::vector<uint8_t>(1000, 7));
+    }
+
+    // Level contents are their level index and byte offset, so any misplaced byte shows
+    std::vector<std::vector<uint8_t>> makeLevels(DXGI_FORMAT format, uint32_t width, uint32_t height)
+    {
+        std::vector<std::vector<uint8_t>> levels;
+        for (uint32_t level = 0;; ++level)
+        {
+            std::vector<uint8_t> bytes(TextureCache::getLevelSize(format, width, height));
+            for (size_t i = 0; i < bytes.size(); ++i)
+            {
+                bytes[i] = static_cast<uint8_t>(level * 31 + i);
+            }
+            levels.push_back(std::move(bytes));
+            if (width == 1 && height == 1)
+            {
+                return levels;
+            }
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+    }
+
+    void sizesLevels()
+    {
+        CHECK_EQ(TextureCache::getRowPitch(DXGI_FORMAT_R8G8B8A8_UNORM, 7), 28u);
+        CHECK_EQ(TextureCache::getRowPitch(DXGI_FORMAT_BC1_UNORM_SRGB, 7), 16u);
+        CHECK_EQ(TextureCache::getRowPitch(DXGI_FORMAT_BC7_UNORM, 1), 16u);
+        CHECK_EQ(TextureCache::getLevelSize(DXGI_FORMAT_BC3_UNORM, 9, 5), size_t(3 * 2 * 16));
+        CHECK_EQ(TextureCache::getLevelSize(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 9, 5), size_t(9 * 5 * 4));
+        CHECK(TextureCache::isBlockCompressed(DXGI_FORMAT_BC7_UNORM_SRGB));
+        CHECK(!TextureCache::isBlockCompressed(DXGI_FORMAT_R8G8B8A8_UNORM));
+        CHECK(TextureCache::getCachePath("a/b\\c:d.png").find("a_b_c_d.png.dds") != std::string::npos);
+    }
+
+    void roundTripsEveryLevel()
+    {
+        enterScratchDirectory();
+        for (DXGI_FORMAT format : {DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC7_UNORM_SRGB})
+        {
+            std::vector<std::vector<uint8_t>> levels = makeLevels(format, 37, 10);
+            TextureCache::save(SOURCE, 42, format, 37, 10, levels);
+
+            TextureCache::CachedTexture cached;
+            CHECK(TextureCache::load(SOURCE, 42, cached));
+            CHECK(cached.format == format && cached.width == 37 && cached.height == 10);
+            CHECK_EQ(cached.levels.size(), levels.size());
+            uint32_t width = 37;
+            for (size_t level = 0; level < std::min(cached.levels.size(), levels.size()); ++level)
+            {
+                CHECK(std::memcmp(cached.levels[level], levels[level].data(), levels[level].size()) == 0);
+                CHECK_EQ(cached.rowPitches[level], TextureCache::getRowPitch(format, width));
+                width = std::max(width / 2, 1u);
+            }
+        }
+    }
+
+    void keepsCubeMapsApart()
+    {
+        // six face chains in one file of their own: the source's 2D cook and its cube map don't replace each other
+        enterScratchDirectory();
+        std::vector<std::vector<uint8_t>> levels;
+        for (uint32_t face = 0; face < TextureCache::CUBE_FACE_COUNT; ++face)
+        {
+            for (std::vector<uint8_t> &level : makeLevels(DXGI_FORMAT_BC1_UNORM_SRGB, 16, 16))
+            {
+                for (uint8_t &byte : level)
+                {
+                    byte = static_cast<uint8_t>(byte + face * 7);
+                }
+                levels.push_back(std::move(level));
+            }
+        }
+        TextureCache::save(SOURCE, 42, DXGI_FORMAT_BC1_UNORM_SRGB, 16, 16, levels, true);
+        TextureCache::save(SOURCE, 42, DXGI_FORMAT_R8G8B8A8_UNORM, 8, 8, makeLevels(DXGI_FORMAT_R8G8B8A8_UNORM, 8, 8));
+        CHECK(TextureCache::getCachePath(SOURCE, true) != TextureCache::getCachePath(SOURCE));
+
+        TextureCache::CachedTexture cube;
+        CHECK(TextureCache::load(SOURCE, 42, cube, true));
+        CHECK(cube.format == DXGI_FORMAT_BC1_UNORM_SRGB && cube.width == 16 && cube.height == 16);
+        CHECK_EQ(cube.mipLevels, 5u);
+        CHECK_EQ(cube.levels.size(), levels.size());
+        bool sameLevels = cube.levels.size() == levels.size();
+        for (size_t i = 0; sameLevels && i < levels.size(); ++i)
+        {
+            sameLevels = std::memcmp(cube.levels[i], levels[i].data(), levels[i].size()) == 0 &&
+                         cube.rowPitches[i] == TextureCache::getRowPitch(DXGI_FORMAT_BC1_UNORM_SRGB, std::max(16u >> (i % 5), 1u));
+        }
+        CHECK(sameLevels);
+
+        TextureCache::CachedTexture flat;
+        CHECK(TextureCache::load(SOURCE, 42, flat));
+        CHECK(flat.width == 8 && flat.mipLevels == 4 && flat.levels.size() == 4);
+
+        // a cube map file is not read as a 2D texture and the other way around
+        std::filesystem::copy_file(TextureCache::getCachePath(SOURCE, true), TextureCache::getCachePath(SOURCE),
+                                   std::filesystem::copy_options::overwrite_existing);
+        CHECK(!TextureCache::load(SOURCE, 42, flat));
+        std::filesystem::remove(TextureCache::getCachePath(SOURCE, true));
+        CHECK(!TextureCache::load(SOURCE, 42, cube, true));
+
+        // levels that are not whole chains are not written
+        levels.pop_back();
+        TextureCache::save(SOURCE, 42, DXGI_FORMAT_BC1_UNORM_SRGB, 16, 16, levels, true);
+        CHECK(!std::filesystem::exists(TextureCache::getCachePath(SOURCE, true)));
+    }
+
+    void rejectsOtherOptionsAndStaleSources()
+    {
+        enterScratchDirectory();
+        TextureCache::save(SOURCE, 42, DXGI_FORMAT_BC1_UNORM, 8, 8, makeLevels(DXGI_FORMAT_BC1_UNORM, 8, 8));
+        TextureCache::CachedTexture cached;
+        CHECK(!TextureCache::load(SOURCE, 43, cached));
+        CHECK(!TextureCache::load("assets/missing.png", 42, cached));
+
+        // touched with the same bytes: the content hash still matches
+        auto touched = std::filesystem::last_write_time(SOURCE) + std::chrono::seconds(10);
+        std::filesystem::last_write_time(SOURCE, touched);
+        CHECK(TextureCache::load(SOURCE, 42, cached));
+
+        // same size, other bytes
+        writeFile(SOURCE, std::vector<uint8_t>(1000, 8));
+        std::filesystem::last_write_time(SOURCE, touched + std::chrono::seconds(10));
+        CHECK(!TextureCache::load(SOURCE, 42, cached));
+
+        writeFile(SOURCE, std::vector<uint8_t>(1001, 7));
+        CHECK(!TextureCache::load(SOURCE, 42, cached));
+    }
+
+    void rejectsTruncatedFiles()
+    {
+        enterScratchDirectory();
+        TextureCache::save(SOURCE, 42, DXGI_FORMAT_R8G8B8A8_UNORM, 16, 16, makeLevels(DXGI_FORMAT_R8G8B8A8_UNORM, 16, 16));
+        std::string cachePath = TextureCache::getCachePath(SOURCE);
+        std::filesystem::resize_file(cachePath, std::filesystem::file_size(cachePath) - 1);
+        TextureCache::CachedTexture cached;
+        CHECK(!TextureCache::load(SOURCE, 42, cached));
+        std::filesystem::resize_file(cachePath, 100);
+        CHECK(!TextureCache::load(SOURCE, 42, cached));
+    }
+}
+
+int main()
+{
+    return Test::run({{"sizesLevels", sizesLevels},
+                      {"roundTripsEveryLevel", roundTripsEveryLevel},
+                      {"keepsCubeMapsApart", keepsCubeMapsApart},
+                      {"rejectsOtherOptionsAndStaleSources", rejectsOtherOptionsAndStaleSources},
+                      {"rejectsTruncatedFiles", rejectsTruncatedFiles}});
+}
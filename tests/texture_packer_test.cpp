@@ -0,0 +1,206 @@
+#include "test_common.h"
+#include "resources/texture_packer.h"
+#include <vector>
+
+namespace
+{
+    uint32_t alignUp(uint32_t value, uint32_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // A mix of small items the way the assets come in: odd sizes, both color spaces
+    std::vector<TexturePackItem> makeSmallItems(uint32_t count, uint32_t seed)
+    {
+        std::vector<TexturePackItem> items;
+        uint32_t state = seed;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            state = state * 1664525u + 1013904223u;
+            uint32_t width = 1 + (state >> 8) % 200;
+            uint32_t height = 1 + (state >> 20) % 120;
+            items.push_back({width, height, 1, i % 3 == 0 ? DXGI_FORMAT_R8G8B8A8_UNORM : DXGI_FORMAT_R8G8B8A8_UNORM_SRGB});
+        }
+        return items;
+    }
+
+    uint8_t itemTexel(uint32_t item, uint32_t x, uint32_t y, uint32_t channel)
+    {
+        return static_cast<uint8_t>(1 + (item * 37 + x * 11 + y * 5 + channel) % 254); // never 0, the free space value
+    }
+
+    void groupsMatchingTexturesIntoArrays()
+    {
+        std::vector<TexturePackItem> items = {{512, 512, 10, DXGI_FORMAT_BC7_UNORM_SRGB},
+                                              {1024, 1024, 11, DXGI_FORMAT_BC7_UNORM_SRGB},
+                                              {512, 512, 10, DXGI_FORMAT_BC7_UNORM_SRGB},
+                                              {512, 512, 9, DXGI_FORMAT_BC7_UNORM_SRGB}, // other mip count
+                                              {512, 512, 10, DXGI_FORMAT_BC7_UNORM_SRGB}};
+        TexturePackLayout layout = TexturePacker::pack(items);
+        CHECK_EQ(layout.groups.size(), size_t(1));
+        const TexturePackGroup &group = layout.groups[0];
+        CHECK(group.kind == TexturePackGroup::Kind::Array);
+        CHECK(group.width == 512 && group.height == 512 && group.mipLevels == 10 && group.sliceCount == 3);
+        CHECK((group.items == std::vector<uint32_t>{0, 2, 4}));
+        CHECK(layout.placements[0].slice == 0 && layout.placements[2].slice == 1 && layout.placements[4].slice == 2);
+        CHECK(layout.placements[1].group == TexturePlacement::STANDALONE);
+        CHECK(layout.placements[3].group == TexturePlacement::STANDALONE);
+
+        TexturePackOptions options;
+        options.minArraySize = 4;
+        CHECK(TexturePacker::pack(items, options).groups.empty());
+    }
+
+    void packsAtlasCellsWithoutOverlap()
+    {
+        TexturePackOptions options;
+        options.atlasPageSize = 512; // small pages so the items spill onto several
+        std::vector<TexturePackItem> items = makeSmallItems(60, 7);
+        TexturePackLayout layout = TexturePacker::pack(items, options);
+
+        uint32_t atlasCount = 0;
+        for (uint32_t g = 0; g < layout.groups.size(); ++g)
+        {
+            const TexturePackGroup &group = layout.groups[g];
+            CHECK(group.kind == TexturePackGroup::Kind::Atlas);
+            CHECK_EQ(group.gutter, 1u << (options.atlasMipLevels - 1));
+            CHECK(group.sliceCount > 1);
+            atlasCount += static_cast<uint32_t>(group.items.size());
+
+            std::vector<std::vector<uint32_t>> owner(group.sliceCount, std::vector<uint32_t>(size_t(group.width) * group.height, UINT32_MAX));
+            for (uint32_t index : group.items)
+            {
+                const TexturePackItem &item = items[index];
+                const TexturePlacement &placement = layout.placements[index];
+                CHECK(placement.group == g && placement.slice < group.sliceCount);
+                CHECK_EQ(TexturePacker::isSrgbFormat(item.format), TexturePacker::isSrgbFormat(group.format));
+
+                // the padded rect starts and ends on gutter aligned texels: mips below atlasMipLevels never mix items
+                uint32_t left = placement.x - group.gutter, top = placement.y - group.gutter;
+                uint32_t right = left + alignUp(item.width + 2 * group.gutter, group.gutter);
+                uint32_t bottom = top + alignUp(item.height + 2 * group.gutter, group.gutter);
+                CHECK(left % group.gutter == 0 && top % group.gutter == 0);
+                CHECK(right <= group.width && bottom <= group.height);
+                for (uint32_t y = top; y < std::min(bottom, group.height); ++y)
+                {
+                    for (uint32_t x = left; x < std::min(right, group.width); ++x)
+                    {
+                        uint32_t &cell = owner[placement.slice][size_t(y) * group.width + x];
+                        CHECK(cell == UINT32_MAX);
+                        cell = index;
+                    }
+                }
+
+                // uv 0..1 over the item maps onto its rect
+                const DirectX::XMFLOAT4 &uv = placement.uvScaleBias;
+                CHECK_NEAR(uv.z * group.width, placement.x, 1e-3);
+                CHECK_NEAR(uv.w * group.height, placement.y, 1e-3);
+                CHECK_NEAR((uv.x + uv.z) * group.width, placement.x + item.width, 1e-3);
+                CHECK_NEAR((uv.y + uv.w) * group.height, placement.y + item.height, 1e-3);
+            }
+        }
+        CHECK_EQ(atlasCount, 60u);
+    }
+
+    void leavesLargeAndLoneItemsStandalone()
+    {
+        std::vector<TexturePackItem> items = {{300, 16, 1, DXGI_FORMAT_R8G8B8A8_UNORM},
+                                              {64, 64, 1, DXGI_FORMAT_R8G8B8A8_UNORM},
+                                              {32, 32, 1, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB}};
+        // one linear and one sRGB candidate: neither makes a page worth it
+        TexturePackLayout layout = TexturePacker::pack(items);
+        CHECK(layout.groups.empty());
+        for (const TexturePlacement &placement : layout.placements)
+        {
+            CHECK(placement.group == TexturePlacement::STANDALONE);
+        }
+
+        TexturePackOptions options;
+        options.maxAtlasItemSize = 0;
+        CHECK(TexturePacker::pack(makeSmallItems(10, 3), options).groups.empty());
+    }
+
+    void composesWrappedGutters()
+    {
+        std::vector<TexturePackItem> items = {{5, 3, 1, DXGI_FORMAT_R8G8B8A8_UNORM},
+                                              {20, 40, 1, DXGI_FORMAT_R8G8B8A8_UNORM},
+                                              {1, 1, 1, DXGI_FORMAT_R8G8B8A8_UNORM}};
+        std::vector<std::vector<uint8_t>> pixels(items.size());
+        std::vector<const uint8_t *> itemPixels;
+        for (uint32_t i = 0; i < items.size(); ++i)
+        {
+            for (uint32_t y = 0; y < items[i].height; ++y)
+            {
+                for (uint32_t x = 0; x < items[i].width; ++x)
+                {
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        pixels[i].push_back(itemTexel(i, x, y, c));
+                    }
+                }
+            }
+            itemPixels.push_back(pixels[i].data());
+        }
+
+        TexturePackOptions options;
+        options.atlasPageSize = 128;
+        options.atlasMipLevels = 3;
+        TexturePackLayout layout = TexturePacker::pack(items, options);
+        CHECK_EQ(layout.groups.size(), size_t(1));
+        const TexturePackGroup &group = layout.groups[0];
+        CHECK_EQ(group.sliceCount, 1u);
+        std::vector<uint8_t> page = TexturePacker::composeAtlasPage(layout, 0, 0, items, itemPixels);
+        CHECK_EQ(page.size(), size_t(128) * 128 * 4);
+
+        std::vector<bool> isCovered(size_t(128) * 128, false);
+        for (uint32_t i = 0; i < items.size(); ++i)
+        {
+            const TexturePlacement &placement = layout.placements[i];
+            int gutter = static_cast<int>(group.gutter);
+            int width = static_cast<int>(items[i].width), height = static_cast<int>(items[i].height);
+            // the item and its gutter, which repeats the item wrapped around
+            for (int y = -gutter; y < height + gutter; ++y)
+            {
+                for (int x = -gutter; x < width + gutter; ++x)
+                {
+                    uint32_t sourceX = static_cast<uint32_t>((x % width + width) % width);
+                    uint32_t sourceY = static_cast<uint32_t>((y % height + height) % height);
+                    size_t texel = size_t(placement.y + y) * 128 + placement.x + x;
+                    isCovered[texel] = true;
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        CHECK_EQ(page[texel * 4 + c], itemTexel(i, sourceX, sourceY, c));
+                    }
+                }
+            }
+        }
+
+        // texels outside every padded rect stay transparent black
+        size_t freeTexels = 0;
+        for (size_t texel = 0; texel < isCovered.size(); ++texel)
+        {
+            if (!isCovered[texel] && page[texel * 4] == 0 && page[texel * 4 + 3] == 0)
+            {
+                ++freeTexels;
+            }
+        }
+        CHECK(freeTexels > 0);
+    }
+
+    void tellsSrgbFormats()
+    {
+        CHECK(TexturePacker::isSrgbFormat(DXGI_FORMAT_BC1_UNORM_SRGB));
+        CHECK(TexturePacker::isSrgbFormat(DXGI_FORMAT_B8G8R8A8_UNORM_SRGB));
+        CHECK(!TexturePacker::isSrgbFormat(DXGI_FORMAT_BC7_UNORM));
+        CHECK(!TexturePacker::isSrgbFormat(DXGI_FORMAT_R8G8B8A8_UNORM));
+    }
+}
+
+int main()
+{
+    return Test::run({{"groupsMatchingTexturesIntoArrays", groupsMatchingTexturesIntoArrays},
+                      {"packsAtlasCellsWithoutOverlap", packsAtlasCellsWithoutOverlap},
+                      {"leavesLargeAndLoneItemsStandalone", leavesLargeAndLoneItemsStandalone},
+                      {"composesWrappedGutters", composesWrappedGutters},
+                      {"tellsSrgbFormats", tellsSrgbFormats}});
+}
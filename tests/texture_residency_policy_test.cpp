@@ -0,0 +1,182 @@
+#include "test_common.h"
+#include "resources/texture_residency_policy.h"
+#include <vector>
+
+namespace
+{
+    // RGBA8 chain of a size x size texture, most detailed first
+    std::vector<size_t> chain(uint32_t size)
+    {
+        std::vector<size_t> levels;
+        for (; size > 0; size /= 2)
+        {
+            levels.push_back(static_cast<size_t>(size) * size * 4);
+        }
+        return levels;
+    }
+
+    size_t tailBytes(uint32_t size, uint32_t mip)
+    {
+        std::vector<size_t> levels = chain(size);
+        size_t bytes = 0;
+        for (size_t i = mip; i < levels.size(); ++i)
+        {
+            bytes += levels[i];
+        }
+        return bytes;
+    }
+
+    TextureResidencyOptions withBudget(size_t budgetBytes)
+    {
+        TextureResidencyOptions options;
+        options.budgetBytes = budgetBytes;
+        return options;
+    }
+
+    void dropsLeastRecentlyUsedLevels()
+    {
+        TextureResidencyPolicy policy(withBudget(12000000));
+        uint32_t a = policy.add(chain(1024), 1024, 1024, 10);
+        uint32_t b = policy.add(chain(1024), 1024, 1024, 10);
+        uint32_t c = policy.add(chain(1024), 1024, 1024, 10);
+        policy.touch(a, 1);
+        policy.touch(b, 2);
+        policy.touch(c, 3);
+
+        // 3 x 5.6 MB: the oldest gives up its two top levels
+        std::vector<TextureResidencyPolicy::Change> changes = policy.update(3);
+        CHECK_EQ(changes.size(), size_t(1));
+        CHECK(changes.size() == 1 && changes[0].id == a && changes[0].residentMip == 2);
+        CHECK_EQ(policy.getResidentMip(b), 0u);
+        CHECK_EQ(policy.getResidentBytes(a), tailBytes(1024, 2));
+
+        TextureResidencyPolicy::Stats stats = policy.getStats();
+        CHECK(stats.residentBytes <= stats.budgetBytes);
+        CHECK_EQ(stats.residentBytes, policy.getResidentBytes(a) + policy.getResidentBytes(b) + policy.getResidentBytes(c));
+        CHECK_EQ(stats.fullBytes, 3 * tailBytes(1024, 0));
+        CHECK(stats.textureCount == 3 && stats.reducedCount == 1 && stats.evictions == 1);
+        CHECK_EQ(stats.evictedBytes, uint64_t(tailBytes(1024, 0) - tailBytes(1024, 2)));
+
+        // drawn again, but the others are not idle long enough to make room
+        policy.touch(a, 4);
+        CHECK(policy.update(4).empty());
+    }
+
+    void keepsSmallLevelsAndWholeTextures()
+    {
+        // a budget nothing fits in: levels of 64 and smaller stay, maxResidentMip 0 keeps a texture whole
+        TextureResidencyPolicy policy(withBudget(1));
+        uint32_t streamed = policy.add(chain(1024), 1024, 1024, 10, 4096);
+        uint32_t whole = policy.add(chain(256), 256, 256, 0);
+        uint32_t limited = policy.add(chain(1024), 1024, 1024, 1);
+        policy.update(1);
+        CHECK_EQ(policy.getResidentMip(streamed), 4u); // 64 x 64
+        CHECK_EQ(policy.getResidentMip(whole), 0u);
+        CHECK_EQ(policy.getResidentMip(limited), 1u);
+        CHECK(policy.getStats().residentBytes > policy.getStats().budgetBytes);
+        CHECK_EQ(policy.getStats().cpuBytes, size_t(4096));
+
+        // minResidentSize counts the longer side
+        TextureResidencyPolicy wide(withBudget(1));
+        uint32_t strip = wide.add(chain(1024), 1024, 16, 10);
+        wide.update(1);
+        CHECK_EQ(wide.getResidentMip(strip), 4u);
+    }
+
+    void reloadsTexturesInUse()
+    {
+        TextureResidencyPolicy policy(withBudget(1));
+        uint32_t a = policy.add(chain(512), 512, 512, 10);
+        policy.update(1);
+        CHECK_EQ(policy.getResidentMip(a), 3u);
+
+        policy.setOptions(withBudget(64 << 20));
+        policy.update(2); // not drawn: stays reduced
+        CHECK_EQ(policy.getResidentMip(a), 3u);
+
+        policy.touch(a, 3);
+        std::vector<TextureResidencyPolicy::Change> changes = policy.update(3);
+        CHECK(changes.size() == 1 && changes[0].id == a && changes[0].residentMip == 0);
+        TextureResidencyPolicy::Stats stats = policy.getStats();
+        CHECK(stats.reloads == 1 && stats.reducedCount == 0);
+        CHECK_EQ(stats.reloadedBytes, uint64_t(tailBytes(512, 0) - tailBytes(512, 3)));
+    }
+
+    void takesRoomOnlyFromIdleTextures()
+    {
+        // room for one 256 chain plus a reduced one
+        TextureResidencyPolicy policy(withBudget(400000));
+        uint32_t a = policy.add(chain(256), 256, 256, 10);
+        uint32_t b = policy.add(chain(256), 256, 256, 10);
+        policy.touch(a, 1);
+        policy.update(1);
+        CHECK(policy.getResidentMip(a) == 0 && policy.getResidentMip(b) == 2);
+
+        // b comes into view while a was used a frame ago: no trading the same bytes back and forth
+        policy.touch(b, 2);
+        CHECK(policy.update(2).empty());
+        CHECK_EQ(policy.getResidentMip(b), 2u);
+
+        // a idle for minIdleFrames: it gives its levels to b
+        policy.touch(b, 40);
+        std::vector<TextureResidencyPolicy::Change> changes = policy.update(40);
+        CHECK_EQ(changes.size(), size_t(2));
+        CHECK(policy.getResidentMip(a) == 2 && policy.getResidentMip(b) == 0);
+        CHECK(policy.getStats().residentBytes <= 400000);
+    }
+
+    void limitsReloadsPerFrame()
+    {
+        TextureResidencyPolicy policy(withBudget(1));
+        uint32_t ids[3];
+        for (uint32_t &id : ids)
+        {
+            id = policy.add(chain(256), 256, 256, 10);
+        }
+        policy.update(1);
+
+        policy.setOptions(withBudget(64 << 20));
+        for (uint32_t id : ids)
+        {
+            policy.touch(id, 2);
+        }
+        CHECK_EQ(policy.update(2).size(), size_t(2));
+        CHECK(policy.getResidentMip(ids[0]) == 0 && policy.getResidentMip(ids[1]) == 0 && policy.getResidentMip(ids[2]) == 2);
+
+        policy.touch(ids[2], 3);
+        CHECK_EQ(policy.update(3).size(), size_t(1));
+        CHECK_EQ(policy.getResidentMip(ids[2]), 0u);
+    }
+
+    void removesAndPinsTextures()
+    {
+        TextureResidencyPolicy policy(withBudget(64 << 20));
+        uint32_t a = policy.add(chain(512), 512, 512, 10);
+        uint32_t b = policy.add(chain(512), 512, 512, 10);
+        policy.remove(a);
+        CHECK_EQ(policy.getStats().residentBytes, tailBytes(512, 0));
+        CHECK_EQ(policy.getStats().textureCount, 1u);
+        CHECK_EQ(policy.add(chain(128), 128, 128, 10), a); // the id is reused
+
+        // a pinned texture stays where it is, whatever the budget
+        policy.pin(b, 1);
+        CHECK_EQ(policy.getResidentBytes(b), tailBytes(512, 1));
+        policy.setOptions(withBudget(1));
+        policy.update(5);
+        CHECK_EQ(policy.getResidentMip(b), 1u);
+        policy.setOptions(withBudget(64 << 20));
+        policy.touch(b, 6);
+        policy.update(6);
+        CHECK_EQ(policy.getResidentMip(b), 1u);
+    }
+}
+
+int main()
+{
+    return Test::run({{"dropsLeastRecentlyUsedLevels", dropsLeastRecentlyUsedLevels},
+                      {"keepsSmallLevelsAndWholeTextures", keepsSmallLevelsAndWholeTextures},
+                      {"reloadsTexturesInUse", reloadsTexturesInUse},
+                      {"takesRoomOnlyFromIdleTextures", takesRoomOnlyFromIdleTextures},
+                      {"limitsReloadsPerFrame", limitsReloadsPerFrame},
+                      {"removesAndPinsTextures", removesAndPinsTextures}});
+}
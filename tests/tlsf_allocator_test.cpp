@@ -0,0 +1,180 @@
+#include "test_common.h"
+#include "utils/tlsf_allocator.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Live allocations must lie inside the range without overlapping, and the stats must add up
+    bool isConsistent(const TlsfAllocator &allocator, const std::map<uint32_t, uint32_t> &live)
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> ranges; // offset, size
+        uint32_t used = 0;
+        for (const auto &[handle, size] : live)
+        {
+            if (allocator.getSize(handle) != size)
+            {
+                return false;
+            }
+            ranges.emplace_back(allocator.getOffset(handle), size);
+            used += size;
+        }
+        std::sort(ranges.begin(), ranges.end());
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            uint32_t end = ranges[i].first + ranges[i].second;
+            if (end > allocator.getCapacity() || (i + 1 < ranges.size() && end > ranges[i + 1].first))
+            {
+                return false;
+            }
+        }
+        TlsfAllocator::Stats stats = allocator.getStats();
+        return stats.usedSize == used && stats.freeSize == stats.capacity - used && stats.allocationCount == live.size() && stats.largestFreeBlock <= stats.freeSize;
+    }
+
+    void allocatesAndCoalesces()
+    {
+        TlsfAllocator allocator(1000);
+        uint32_t a = allocator.allocate(100), b = allocator.allocate(200), c = allocator.allocate(300);
+        CHECK(a != TlsfAllocator::INVALID_HANDLE && b != TlsfAllocator::INVALID_HANDLE && c != TlsfAllocator::INVALID_HANDLE);
+        CHECK(isConsistent(allocator, {{a, 100}, {b, 200}, {c, 300}}));
+
+        // freeing neighbours merges them into one block
+        allocator.free(b);
+        allocator.free(a);
+        TlsfAllocator::Stats stats = allocator.getStats();
+        CHECK_EQ(stats.freeBlockCount, 2u); // [a b] and the tail after c
+        CHECK_EQ(stats.largestFreeBlock, 400u);
+        allocator.free(c);
+        stats = allocator.getStats();
+        CHECK_EQ(stats.freeBlockCount, 1u);
+        CHECK_EQ(stats.largestFreeBlock, 1000u);
+        CHECK_NEAR(stats.fragmentation, 0.f, 1e-6);
+
+        // zero takes one unit, nothing fits past the capacity
+        uint32_t zero = allocator.allocate(0);
+        CHECK_EQ(allocator.getSize(zero), 1u);
+        CHECK_EQ(allocator.allocate(1000), TlsfAllocator::INVALID_HANDLE);
+        allocator.free(zero);
+        uint32_t all = allocator.allocate(1000);
+        CHECK(all != TlsfAllocator::INVALID_HANDLE && allocator.getOffset(all) == 0);
+        CHECK_EQ(allocator.allocate(1), TlsfAllocator::INVALID_HANDLE);
+    }
+
+    void staysConsistentUnderRandomTraffic()
+    {
+        TlsfAllocator allocator(1 << 20);
+        std::map<uint32_t, uint32_t> live;
+        std::mt19937 random(9);
+        std::uniform_int_distribution<uint32_t> size(1, 20000);
+        bool consistent = true, fitsWhenRoomy = true;
+        for (int op = 0; op < 20000; ++op)
+        {
+            if (live.empty() || random() % 3 != 0)
+            {
+                uint32_t request = size(random);
+                uint32_t largest = allocator.getStats().largestFreeBlock;
+                uint32_t handle = allocator.allocate(request);
+                if (handle != TlsfAllocator::INVALID_HANDLE)
+                {
+                    live[handle] = request;
+                }
+                else
+                {
+                    // good fit may skip a block within one size class of the request, never a much larger one
+                    fitsWhenRoomy = fitsWhenRoomy && largest < request * 2;
+                }
+            }
+            else
+            {
+                auto it = live.begin();
+                std::advance(it, random() % live.size());
+                allocator.free(it->first);
+                live.erase(it);
+            }
+            if (op % 500 == 0)
+            {
+                consistent = consistent && isConsistent(allocator, live);
+            }
+        }
+        CHECK(consistent && isConsistent(allocator, live));
+        CHECK(fitsWhenRoomy);
+
+        for (const auto &entry : live)
+        {
+            allocator.free(entry.first);
+        }
+        TlsfAllocator::Stats stats = allocator.getStats();
+        CHECK_EQ(stats.freeBlockCount, 1u);
+        CHECK_EQ(stats.freeSize, 1u << 20);
+    }
+
+    void compactsWithoutOverwriting()
+    {
+        // every unit holds its owner's handle, copying the moves in order must keep it
+        const uint32_t capacity = 4096;
+        TlsfAllocator allocator(capacity);
+        std::map<uint32_t, uint32_t> live;
+        std::mt19937 random(4);
+        for (int i = 0; i < 200; ++i)
+        {
+            uint32_t handle = allocator.allocate(1 + random() % 40);
+            if (handle != TlsfAllocator::INVALID_HANDLE)
+            {
+                live[handle] = allocator.getSize(handle);
+            }
+        }
+        for (auto it = live.begin(); it != live.end();)
+        {
+            if (random() % 2 == 0)
+            {
+                allocator.free(it->first);
+                it = live.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        std::vector<uint32_t> memory(capacity, UINT32_MAX);
+        for (const auto &[handle, size] : live)
+        {
+            std::fill_n(memory.begin() + allocator.getOffset(handle), size, handle);
+        }
+        CHECK(allocator.getStats().fragmentation > 0.f);
+
+        std::vector<TlsfAllocator::Move> moves = allocator.compact();
+        bool ordered = true;
+        uint32_t lastFrom = 0;
+        for (const TlsfAllocator::Move &move : moves)
+        {
+            ordered = ordered && move.to <= move.from && move.from >= lastFrom;
+            lastFrom = move.from;
+            std::copy(memory.begin() + move.from, memory.begin() + move.from + move.size, memory.begin() + move.to);
+        }
+        CHECK(ordered);
+        CHECK(isConsistent(allocator, live));
+
+        bool dataKept = true;
+        uint32_t used = 0;
+        for (const auto &[handle, size] : live)
+        {
+            dataKept = dataKept && std::all_of(memory.begin() + allocator.getOffset(handle), memory.begin() + allocator.getOffset(handle) + size,
+                                               [handle = handle](uint32_t owner) { return owner == handle; });
+            used += size;
+        }
+        CHECK(dataKept);
+        TlsfAllocator::Stats stats = allocator.getStats();
+        CHECK_EQ(stats.freeBlockCount, 1u);
+        CHECK_EQ(stats.largestFreeBlock, capacity - used);
+    }
+}
+
+int main()
+{
+    return Test::run({{"allocatesAndCoalesces", allocatesAndCoalesces},
+                      {"staysConsistentUnderRandomTraffic", staysConsistentUnderRandomTraffic},
+                      {"compactsWithoutOverwriting", compactsWithoutOverwriting}});
+}
@@ -0,0 +1,122 @@
+#include "test_common.h"
+#include "test_meshes.h"
+#include "resources/vertex_codec.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    VertexCodec::Quantization quantize(const std::vector<Vertex> &vertices)
+    {
+        return VertexCodec::getQuantization(MeshBounds::compute(&vertices[0].pos, vertices.size(), sizeof(Vertex)));
+    }
+
+    float maxAbsTexCoord(const std::vector<Vertex> &vertices)
+    {
+        float maxTexCoord = 0.f;
+        for (const Vertex &v : vertices)
+        {
+            maxTexCoord = std::max({maxTexCoord, std::fabs(v.uv.x), std::fabs(v.uv.y)});
+        }
+        return maxTexCoord;
+    }
+
+    void checkWithinBounds(const std::vector<Vertex> &vertices)
+    {
+        VertexCodec::Quantization quantization = quantize(vertices);
+        std::vector<CompactVertex> encoded;
+        VertexCodec::encodeCompact(vertices.data(), vertices.size(), quantization, encoded);
+        CHECK_EQ(encoded.size(), vertices.size());
+
+        VertexCodec::ErrorStats error = VertexCodec::measureError(vertices.data(), encoded.data(), vertices.size(), quantization);
+        VertexCodec::ErrorStats bounds = VertexCodec::getErrorBounds(quantization, maxAbsTexCoord(vertices));
+        CHECK(error.maxPositionError <= bounds.maxPositionError);
+        CHECK(error.maxNormalErrorDegrees <= bounds.maxNormalErrorDegrees);
+        CHECK(error.maxTexCoordError <= bounds.maxTexCoordError);
+    }
+
+    void encodesUnorm16Endpoints()
+    {
+        CHECK_EQ(VertexCodec::encodeUnorm16(0.f), 0);
+        CHECK_EQ(VertexCodec::encodeUnorm16(1.f), 65535);
+        CHECK_EQ(VertexCodec::encodeUnorm16(-0.5f), 0);
+        CHECK_EQ(VertexCodec::encodeUnorm16(1.5f), 65535);
+        CHECK_NEAR(VertexCodec::decodeUnorm16(VertexCodec::encodeUnorm16(0.25f)), 0.25f, 0.5 / 65535.0);
+    }
+
+    void encodesOctahedralAxes()
+    {
+        for (DirectX::XMFLOAT3 axis : {DirectX::XMFLOAT3{1.f, 0.f, 0.f}, DirectX::XMFLOAT3{-1.f, 0.f, 0.f}, DirectX::XMFLOAT3{0.f, 1.f, 0.f},
+                                       DirectX::XMFLOAT3{0.f, -1.f, 0.f}, DirectX::XMFLOAT3{0.f, 0.f, 1.f}, DirectX::XMFLOAT3{0.f, 0.f, -1.f}})
+        {
+            int16_t encoded[2];
+            VertexCodec::encodeOctahedral(axis, encoded);
+            DirectX::XMFLOAT3 decoded = VertexCodec::decodeOctahedral(encoded);
+            CHECK_NEAR(decoded.x, axis.x, 1e-4);
+            CHECK_NEAR(decoded.y, axis.y, 1e-4);
+            CHECK_NEAR(decoded.z, axis.z, 1e-4);
+        }
+    }
+
+    void roundTripsRandomVerticesWithinBounds()
+    {
+        // a 60 unit box, normals over the whole sphere, tiling uvs up to 4
+        std::mt19937 random(5);
+        std::uniform_real_distribution<float> position(-30.f, 30.f), direction(-1.f, 1.f), texCoord(-4.f, 4.f);
+        std::vector<Vertex> vertices;
+        while (vertices.size() < 200000)
+        {
+            DirectX::XMFLOAT3 n = {direction(random), direction(random), direction(random)};
+            float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+            if (length < 1e-3f || length > 1.f)
+            {
+                continue;
+            }
+            vertices.emplace_back(DirectX::XMFLOAT3{position(random), position(random), position(random)},
+                                  DirectX::XMFLOAT3{n.x / length, n.y / length, n.z / length}, DirectX::XMFLOAT2{texCoord(random), texCoord(random)});
+        }
+        checkWithinBounds(vertices);
+    }
+
+    void roundTripsAssetsWithinBounds()
+    {
+        for (const char *asset : {"game/celestial_rover/assets/mesh/cube.obj", "game/celestial_rover/assets/mesh/sphere.obj",
+                                  "game/celestial_rover/assets/mesh/spaceship.obj"})
+        {
+            std::vector<Vertex> vertices;
+            std::vector<uint32_t> indices;
+            TestMeshes::loadObj(Test::sourcePath(asset), vertices, indices);
+            checkWithinBounds(vertices);
+        }
+    }
+
+    void flatAxisKeepsNonZeroScale()
+    {
+        // a plane has no extent in y, the quantization must not divide by it
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        TestMeshes::makeGrid(8, vertices, indices);
+        for (Vertex &v : vertices)
+        {
+            v.pos.y = 2.f;
+        }
+        VertexCodec::Quantization quantization = quantize(vertices);
+        CHECK(quantization.scale.y > 0.f);
+        checkWithinBounds(vertices);
+
+        // the position-only stream stores the same quantized position
+        PositionVertex position = VertexCodec::encodePosition(vertices[10].pos, quantization);
+        CompactVertex compact = VertexCodec::encodeCompact(vertices[10], quantization);
+        CHECK(position.pos[0] == compact.pos[0] && position.pos[1] == compact.pos[1] && position.pos[2] == compact.pos[2]);
+    }
+}
+
+int main()
+{
+    return Test::run({{"encodesUnorm16Endpoints", encodesUnorm16Endpoints},
+                      {"encodesOctahedralAxes", encodesOctahedralAxes},
+                      {"roundTripsRandomVerticesWithinBounds", roundTripsRandomVerticesWithinBounds},
+                      {"roundTripsAssetsWithinBounds", roundTripsAssetsWithinBounds},
+                      {"flatAxisKeepsNonZeroScale", flatAxisKeepsNonZeroScale}});
+}
@@ -0,0 +1,240 @@
+#include "test_common.h"
+#include "resources/block_compressor.h"
+#include "resources/virtual_texture_cache.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// Tiling, page table, tile cache and feedback analysis with synthetic images and feedback buffers. Page files
+// go to a scratch working directory.
+namespace
+{
+    constexpr uint32_t TILE_SIZE = VirtualTextureFile::TILE_SIZE;
+    constexpr uint32_t BORDER = VirtualTextureFile::TILE_BORDER;
+    constexpr uint32_t STRIDE = VirtualTextureFile::TILE_STRIDE;
+
+    void enterScratchDirectory()
+    {
+        std::filesystem::path scratch = std::filesystem::temp_directory_path() / "virtual_texture_test";
+        std::filesystem::current_path(std::filesystem::temp_directory_path());
+        std::filesystem::remove_all(scratch);
+        std::filesystem::create_directories(scratch);
+        std::filesystem::current_path(scratch);
+    }
+
+    std::vector<uint8_t> makeImage(uint32_t width, uint32_t height, bool isOpaque)
+    {
+        std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                uint8_t *texel = pixels.data() + (static_cast<size_t>(y) * width + x) * 4;
+                texel[0] = static_cast<uint8_t>(x);
+                texel[1] = static_cast<uint8_t>(y);
+                texel[2] = static_cast<uint8_t>(x * 7 + y * 3);
+                texel[3] = isOpaque ? 255 : static_cast<uint8_t>(128 + (x + y) % 100);
+            }
+        }
+        return pixels;
+    }
+
+    uint32_t pack(uint32_t level, uint32_t x, uint32_t y)
+    {
+        return VirtualTile{level, x, y}.pack();
+    }
+
+    void cutsTheTilePyramid()
+    {
+        std::vector<VirtualTextureFile::Level> levels = VirtualTextureFile::getLevels(1000, 300);
+        CHECK_EQ(levels.size(), size_t(4));
+        const uint32_t expected[4][5] = {{1000, 300, 8, 3, 0}, {500, 150, 4, 2, 24}, {250, 75, 2, 1, 32}, {125, 37, 1, 1, 34}};
+        for (size_t i = 0; i < std::min<size_t>(levels.size(), 4); ++i)
+        {
+            const VirtualTextureFile::Level &level = levels[i];
+            CHECK(level.width == expected[i][0] && level.height == expected[i][1]);
+            CHECK(level.tilesX == expected[i][2] && level.tilesY == expected[i][3] && level.firstTile == expected[i][4]);
+        }
+        CHECK_EQ(VirtualTextureFile::getLevels(TILE_SIZE, 1).size(), size_t(1));
+
+        VirtualTile tile = VirtualTile::unpack(pack(7, 4095, 123));
+        CHECK(tile.level == 7 && tile.x == 4095 && tile.y == 123);
+    }
+
+    void writesWrappedTileBorders()
+    {
+        enterScratchDirectory();
+        const uint32_t width = 300, height = 200;
+        std::vector<uint8_t> pixels = makeImage(width, height, false);
+        VirtualTextureFile::write("page.vtx", pixels.data(), width, height, false);
+        VirtualTextureFile file("page.vtx");
+        CHECK(file.getFormat() == DXGI_FORMAT_R8G8B8A8_UNORM);
+        CHECK(file.getWidth() == width && file.getHeight() == height);
+        CHECK_EQ(file.getTileCount(), 3u * 2 + 2 * 1 + 1);
+        CHECK_EQ(file.getTileBytes(), size_t(STRIDE) * STRIDE * 4);
+        CHECK_EQ(file.getTileRowPitch(), STRIDE * 4);
+
+        // level 0 is the source itself: every stored texel, border included, is the source texel wrapped
+        for (uint32_t tileY = 0; tileY < 2; ++tileY)
+        {
+            for (uint32_t tileX = 0; tileX < 3; ++tileX)
+            {
+                const uint8_t *tile = file.getTileData({0, tileX, tileY});
+                bool isSame = true;
+                for (uint32_t row = 0; row < STRIDE; ++row)
+                {
+                    uint32_t y = (tileY * TILE_SIZE + row + height - BORDER) % height;
+                    for (uint32_t column = 0; column < STRIDE; ++column)
+                    {
+                        uint32_t x = (tileX * TILE_SIZE + column + width - BORDER) % width;
+                        isSame = isSame && std::memcmp(tile + (row * STRIDE + column) * 4, pixels.data() + (size_t(y) * width + x) * 4, 4) == 0;
+                    }
+                }
+                CHECK(isSame);
+            }
+        }
+
+        // opaque images store BC1 tiles
+        std::vector<uint8_t> opaque = makeImage(width, height, true);
+        VirtualTextureFile::write("opaque.vtx", opaque.data(), width, height, true);
+        VirtualTextureFile bc1("opaque.vtx");
+        CHECK(bc1.getFormat() == DXGI_FORMAT_BC1_UNORM_SRGB);
+        CHECK_EQ(bc1.getTileBytes(), BlockCompressor::getCompressedSize(BlockFormat::BC1, STRIDE, STRIDE));
+        std::vector<uint8_t> decoded = BlockCompressor::decompress(BlockFormat::BC1, bc1.getTileData({0, 1, 1}), STRIDE, STRIDE);
+        const uint8_t *inside = decoded.data() + (size_t(BORDER) * STRIDE + BORDER) * 4;
+        const uint8_t *source = opaque.data() + (size_t(TILE_SIZE) * width + TILE_SIZE) * 4;
+        CHECK(std::abs(inside[0] - source[0]) <= 8 && std::abs(inside[1] - source[1]) <= 8);
+
+        std::filesystem::resize_file("page.vtx", std::filesystem::file_size("page.vtx") - 1);
+        CHECK_THROWS(VirtualTextureFile("page.vtx"));
+    }
+
+    void reusesPageFilesUntilTheSourceChanges()
+    {
+        enterScratchDirectory();
+        const std::string source = "source.bin";
+        {
+            std::ofstream out(source, std::ios::binary);
+            out << "source image bytes";
+        }
+        CHECK(VirtualTextureFile::openCached(source) == nullptr);
+
+        std::vector<uint8_t> pixels = makeImage(200, 130, true);
+        VirtualTextureFile::write(VirtualTextureFile::getCachePath(source), pixels.data(), 200, 130, true, source);
+        CHECK(VirtualTextureFile::openCached(source) != nullptr);
+
+        {
+            std::ofstream out(source, std::ios::binary | std::ios::trunc);
+            out << "SOURCE IMAGE BYTES";
+        }
+        std::filesystem::last_write_time(source, std::filesystem::last_write_time(source) + std::chrono::seconds(10));
+        CHECK(VirtualTextureFile::openCached(source) == nullptr);
+    }
+
+    void evictsLeastRecentlyUsedTiles()
+    {
+        TileCache cache(3);
+        uint32_t evicted;
+        uint32_t a = cache.allocate(pack(0, 0, 0), 1, evicted);
+        uint32_t b = cache.allocate(pack(0, 1, 0), 1, evicted);
+        uint32_t c = cache.allocate(pack(0, 2, 0), 2, evicted);
+        CHECK(a == 0 && b == 1 && c == 2 && evicted == VirtualTile::INVALID);
+        CHECK_EQ(cache.getResidentCount(), 3u);
+        CHECK_EQ(cache.find(pack(0, 1, 0)), b);
+
+        cache.touch(a, 3);
+        uint32_t d = cache.allocate(pack(0, 3, 0), 4, evicted);
+        CHECK(d == b && evicted == pack(0, 1, 0));
+        CHECK(cache.find(pack(0, 1, 0)) == TileCache::INVALID_SLOT);
+        CHECK(cache.getTile(d) == pack(0, 3, 0));
+
+        // everything was used this frame: keep it rather than thrash
+        cache.touch(a, 5);
+        cache.touch(c, 5);
+        cache.touch(d, 5);
+        CHECK(cache.allocate(pack(1, 0, 0), 5, evicted) == TileCache::INVALID_SLOT);
+
+        // pinned slots never leave, however old
+        cache.pin(a);
+        CHECK(cache.allocate(pack(1, 0, 0), 6, evicted) == c);
+        CHECK(cache.allocate(pack(1, 1, 0), 7, evicted) == d);
+        CHECK(cache.allocate(pack(1, 2, 0), 8, evicted) == c);
+        CHECK(cache.find(pack(0, 0, 0)) == a);
+    }
+
+    void fallsBackToResidentAncestors()
+    {
+        std::vector<VirtualTextureFile::Level> levels = VirtualTextureFile::getLevels(4 * TILE_SIZE, 4 * TILE_SIZE); // 4x4, 2x2, 1x1
+        PageTable table(levels);
+        for (const PageTable::Entry &entry : table.resolve())
+        {
+            CHECK(entry.slot == PageTable::NOT_RESIDENT);
+        }
+
+        table.map(pack(2, 0, 0), 0, 0);
+        table.map(pack(1, 1, 1), 3, 2);
+        CHECK(table.isDirty());
+        const std::vector<PageTable::Entry> &entries = table.resolve();
+        CHECK(!table.isDirty());
+        CHECK(entries[20].slot == (0u | 2u << 16) && entries[20].tile == 0);
+        CHECK(entries[16 + 3].slot == (3u | 2u << 8 | 1u << 16) && entries[16 + 3].tile == (1u | 1u << 16));
+        for (uint32_t y = 0; y < 4; ++y)
+        {
+            for (uint32_t x = 0; x < 4; ++x)
+            {
+                // the lower right quarter finds level 1's tile, the rest the root
+                bool isUnderMapped = x >= 2 && y >= 2;
+                CHECK(entries[y * 4 + x].slot == (isUnderMapped ? entries[16 + 3].slot : entries[20].slot));
+            }
+        }
+
+        table.map(pack(0, 0, 0), 5, 0);
+        table.unmap(pack(1, 1, 1));
+        table.resolve();
+        CHECK(entries[0].slot == 5u && entries[0].tile == 0);
+        CHECK(entries[15].slot == entries[20].slot);
+    }
+
+    void analyzesFeedback()
+    {
+        std::vector<VirtualTextureFile::Level> levels = VirtualTextureFile::getLevels(4 * TILE_SIZE, 2 * TILE_SIZE); // 4x2, 2x1, 1x1
+        const uint32_t width = 10, height = 3;
+        const size_t rowPitch = 64; // padded like a mapped readback
+        std::vector<uint8_t> buffer(rowPitch * height, 0xff);
+        auto row = [&](uint32_t y)
+        { return reinterpret_cast<uint32_t *>(buffer.data() + y * rowPitch); };
+
+        // a run of (0,3,1), a few (0,0,0), an out of range tile and a cleared pixel
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            row(0)[x] = pack(0, 3, 1);
+            row(1)[x] = x < 3 ? pack(0, 0, 0) : x < 5 ? pack(0, 9, 0) : VirtualTile::INVALID;
+            row(2)[x] = x == 0 ? pack(5, 0, 0) : pack(0, 3, 1);
+        }
+        std::vector<VirtualTextureFeedback::Request> requests = VirtualTextureFeedback::analyze(reinterpret_cast<const uint32_t *>(buffer.data()),
+                                                                                            width, height, rowPitch, levels);
+        CHECK_EQ(requests.size(), size_t(5));
+        if (requests.size() != 5)
+        {
+            return;
+        }
+        // coarse first, then by pixel count; ancestors that only complete a chain count no pixels
+        CHECK(requests[0].tile == pack(2, 0, 0) && requests[0].pixelCount == 0);
+        CHECK(requests[1].tile == pack(1, 0, 0) && requests[1].pixelCount == 0);
+        CHECK(requests[2].tile == pack(1, 1, 0) && requests[2].pixelCount == 0);
+        CHECK(requests[3].tile == pack(0, 3, 1) && requests[3].pixelCount == 19);
+        CHECK(requests[4].tile == pack(0, 0, 0) && requests[4].pixelCount == 3);
+    }
+}
+
+int main()
+{
+    return Test::run({{"cutsTheTilePyramid", cutsTheTilePyramid},
+                      {"writesWrappedTileBorders", writesWrappedTileBorders},
+                      {"reusesPageFilesUntilTheSourceChanges", reusesPageFilesUntilTheSourceChanges},
+                      {"evictsLeastRecentlyUsedTiles", evictsLeastRecentlyUsedTiles},
+                      {"fallsBackToResidentAncestors", fallsBackToResidentAncestors},
+                      {"analyzesFeedback", analyzesFeedback}});
+}